@@ -38,14 +38,102 @@
 // You should receive a copy of the GNU General Public License along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#ifdef _WIN32
 #include "windows.h"
 #include "stdafx.h"
+#else
+#include "PortableConsole.h"
+#endif
 #include "LogData.h"
+#include "BlockReader.h"
+#include "WriteBehind.h"
+#include "BatchSummary.h"
+#include "CombinedUsage.h"
+#include "LogFollower.h"
+#include "MetricsExporter.h"
+#include "QueryService.h"
+#include "PipelineStats.h"
+#include "Cancellation.h"
+#include "ProgressReporter.h"
+#include "GroupMapping.h"
+#include "PeriodComparison.h"
+#include "TraceRecorder.h"
+#include "ThreadPool.h"
+#include "OutputCache.h"
+#include "ResourceLimits.h"
+#include "Utilities.h"
 #include "Exceptions.h"
+#include "CLCRBuildVersion.h"
+#ifdef _WIN32
 #include "resource.h"
+#endif
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
 
 #define PARM_OVERWRITE L"-o"
 #define PARM_CONFLICT  L"-c"
+#define PARM_LONG_USAGE L"-l"
+#define PARM_BUCKETS    L"-b"
+#define PARM_PARTITION  L"--partition"
+#define PARM_MERGE      L"-m"
+#define PARM_MERGE_MEMORY L"--merge-memory"
+#define PARM_INCREMENTAL L"-i"
+#define PARM_FOLLOW     L"-f"
+#define PARM_SERVE      L"-s"
+#define PARM_METRICS    L"--metrics"
+#define PARM_SNAPSHOT   L"--snapshot"
+#define PARM_EVENT_CACHE L"-e"
+#define PARM_ARROW       L"-a"
+#define PARM_SQLITE      L"--sqlite"
+#define PARM_JSONL       L"--jsonl"
+#define PARM_QUERY       L"-q"
+#define PARM_PEAK_MEMORY L"-p"
+#define PARM_STATS       L"--stats"
+#define PARM_STATS_JSON  L"--stats-json"
+#define PARM_MEMORY_STATS L"--memory-stats"
+#define PARM_REPORTS     L"-r"
+#define PARM_REPORT      L"--report"
+#define PARM_COMPRESS    L"-z"
+#define PARM_READ_AHEAD  L"--read-ahead"
+#define PARM_WRITE_BEHIND L"--write-behind"
+#define PARM_THREADS     L"--threads"
+#define PARM_CPUS        L"--cpus"
+#define PARM_LOW_PRIORITY L"--low-priority"
+#define PARM_MAX_MEMORY  L"--max-memory"
+#define PARM_INVALID_LINES L"--invalid-lines"
+#define PARM_FROM        L"--from"
+#define PARM_TO          L"--to"
+#define PARM_PRODUCTS    L"--products"
+#define PARM_USERS       L"--users"
+#define PARM_HOSTS       L"--hosts"
+#define PARM_EXCLUDE_PRODUCTS L"--exclude-products"
+#define PARM_EXCLUDE_USERS    L"--exclude-users"
+#define PARM_EXCLUDE_HOSTS    L"--exclude-hosts"
+#define PARM_COALESCE_DENIALS L"--coalesce-denials"
+#define PARM_DENIAL_USAGE     L"--denial-usage"
+#define PARM_REORDER_WINDOW   L"--reorder-window"
+#define PARM_OFF_HOURS        L"--off-hours"
+#define PARM_LONG_SESSION     L"--long-session"
+#define PARM_APPROXIMATE L"--approximate"
+#define PARM_SAVE_PARTIAL   L"--save-partial"
+#define PARM_MERGE_PARTIALS L"--merge-partials"
+#define PARM_CATALOG     L"--catalog"
+#define PARM_CLUSTER     L"--cluster"
+#define PARM_LAUNCHER    L"--launcher"
+#define PARM_SHARD       L"--shard"
+#define PARM_OUTPUT_CACHE L"--output-cache"
+#define PARM_VALIDATE    L"--validate"
+#define PARM_COMPARE     L"--compare"
+#define PARM_PROGRESS    L"--progress"
+#define PARM_MAX_SECONDS L"--max-seconds"
+#define PARM_TRACE       L"--trace"
+#define PARM_USER_GROUPS L"--user-groups"
+#define PARM_HOST_GROUPS L"--host-groups"
 
 #define INVALID_ARGUMENTS       -100
 #define CONFLICTING_FILES       -200
@@ -57,6 +145,7 @@
 #define UNKNOWN_ERROR           -800
 #define UNABLE_TO_FIND_FILE     -900
 #define UNABLE_TO_FIND_DIR      -1000
+#define CANCELLED               -1100
 
 #define MAX_STR_LEN 1024
 
@@ -99,6 +188,222 @@ void printUsage()
 	LoadStringFromResource(IDS_CONFLICT_DESCR, resourceString);
 	wprintf_s(resourceString);
 	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_LONG_USAGE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_LONG_USAGE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_BUCKETS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_BUCKETS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_PARTITION, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_PARTITION_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_BATCH, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_BATCH_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_MERGE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_MERGE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_CLUSTER, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CLUSTER_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_OUTPUT_CACHE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_OUTPUT_CACHE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_INCREMENTAL, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_INCREMENTAL_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_FOLLOW, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_FOLLOW_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_METRICS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_METRICS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_SNAPSHOT, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_SNAPSHOT_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_SERVE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_SERVE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_EVENT_CACHE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_EVENT_CACHE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_ARROW, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_ARROW_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_SQLITE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_SQLITE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_JSONL, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_JSONL_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_QUERY, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_QUERY_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_PEAK_MEMORY, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_PEAK_MEMORY_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_STATS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_STATS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_MEMORY_STATS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_MEMORY_STATS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_PROGRESS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_PROGRESS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_MAX_SECONDS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_MAX_SECONDS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_TRACE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_TRACE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_GROUPS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_GROUPS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_REPORTS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_REPORTS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_REPORT, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_REPORT_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_COMPRESS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_COMPRESS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_READ_AHEAD, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_READ_AHEAD_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_WRITE_BEHIND, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_WRITE_BEHIND_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_THREADS, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_THREADS_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_INVALID_LINES, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_INVALID_LINES_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_DATE_RANGE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_DATE_RANGE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_EVENT_FILTER, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_EVENT_FILTER_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_DENIAL_USAGE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_DENIAL_USAGE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_VALIDATE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_VALIDATE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_CMDLINE_COMPARE, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
+	LoadStringFromResource(IDS_COMPARE_DESCR, resourceString);
+	wprintf_s(resourceString);
+	wprintf_s(L"\n\n");
 	LoadStringFromResource(IDS_RETURN_CODES, resourceString);
 	wprintf_s(resourceString);
 	wprintf_s(L"\n\n");
@@ -125,99 +430,1963 @@ std::string ConvertToString(const wchar_t *s)
 	}
 }
 
-int _tmain(int argc, _TCHAR* argv[])
+//
+// Converts a --from or --to argument, "MM/DD/YYYY" or "MM/DD/YYYY HH:MM", to
+// seconds since the epoch.  A date alone is the start of its day, or with
+// bEndOfDay the start of the next one, so that --to includes the day.
+// Returns false if the argument has neither form.
+//
+bool parseRangeTime(const wchar_t *s, bool bEndOfDay, long long& timestamp)
+{
+	std::string text = ConvertToString(s);
+	size_t space = text.find(' ');
+	DateTime dateTime = { 0, 0, 0, 0, 0, 0 };
+	if (!parseLogDate(std::string_view(text).substr(0, space), dateTime) || dateTime.year == 0)
+	{
+		return false;
+	}
+	if (space != std::string::npos)
+	{
+		if (!parseLogTime(std::string_view(text).substr(space + 1), dateTime) || dateTime.hours > 23 || dateTime.minutes > 59)
+		{
+			return false;
+		}
+		bEndOfDay = false;
+	}
+	timestamp = dateTimeToEpoch(dateTime) + (bEndOfDay ? 86400 : 0);
+	return true;
+}
+
+//
+// Sets a field of the event filter to the comma separated names of a
+// --products, --users or --hosts argument, or of its --exclude- form.
+// Returns false for an empty name or a field that already has a list.
+//
+bool parseNameFilter(const wchar_t *s, bool bExclude, NameFilter& filter)
+{
+	if (!filter.names.empty())
+	{
+		return false;
+	}
+
+	std::string list = ConvertToString(s);
+	size_t start = 0;
+	while (start <= list.size())
+	{
+		size_t end = list.find(',', start);
+		if (end == std::string::npos)
+		{
+			end = list.size();
+		}
+		if (end == start)
+		{
+			return false;
+		}
+		filter.names.push_back(list.substr(start, end - start));
+		start = end + 1;
+	}
+	filter.exclude = bExclude;
+	return true;
+}
+
+//
+// Converts the -b argument to seconds.  Returns 0 if it is not valid.
+//
+long long parseBucketWidth(const wchar_t *s)
+{
+	if (0 == _wcsicmp(s, L"minute"))
+	{
+		return 60;
+	}
+	if (0 == _wcsicmp(s, L"hour"))
+	{
+		return 3600;
+	}
+	if (0 == _wcsicmp(s, L"day"))
+	{
+		return 86400;
+	}
+
+	wchar_t *end = NULL;
+	long long bucketMinutes = wcstoll(s, &end, 10);
+	if (end == s || *end != L'\0' || bucketMinutes <= 0)
+	{
+		return 0;
+	}
+	return bucketMinutes * 60;
+}
+
+//
+// Converts the comma separated -r argument to a reportSelection.  Returns
+// 0 if it names an unknown report.  The usage is also called concurrency,
+// the license activity sessions.
+//
+unsigned int parseReportSelection(const wchar_t *s)
+{
+	const wchar_t *names[] = { L"summary", L"events", L"usage", L"concurrency", L"activity", L"sessions",
+							   L"hosts", L"users", L"denied", L"durations", L"heatmap", L"saturation",
+							   L"denied-hourly", L"peaks", L"top", L"versions", L"reserved", L"forgotten", L"demand",
+							   L"all" };
+	const unsigned int reports[] = { SummaryReport, ProcessedLogReport, ConcurrentUsageReport, ConcurrentUsageReport,
+									 LicenseActivityReport, LicenseActivityReport, TotalDurationHostsReport,
+									 TotalDurationUsersReport, DeniedRequestsReport, SessionDurationsReport,
+									 UsageHeatmapReport, LicenseSaturationReport, HourlyDenialsReport,
+									 SustainedPeaksReport, TopUsageReport, VersionUsageReport,
+									 ReservedUsageReport, ForgottenSessionsReport, DemandProfileReport,
+									 AllReports };
+	unsigned int selection = 0;
+
+	std::wstring list(s);
+	size_t start = 0;
+	while (start <= list.size())
+	{
+		size_t end = list.find(L',', start);
+		if (end == std::wstring::npos)
+		{
+			end = list.size();
+		}
+		std::wstring name = list.substr(start, end - start);
+		unsigned int report = 0;
+		for (size_t known = 0; known < sizeof(reports) / sizeof(reports[0]); ++known)
+		{
+			if (0 == _wcsicmp(name.c_str(), names[known]))
+			{
+				report = reports[known];
+			}
+		}
+		if (report == 0)
+		{
+			return 0;
+		}
+		selection |= report;
+		start = end + 1;
+	}
+	return selection;
+}
+
+//
+// Applies the output options of the command line to a log's reports. Only
+// the written reports of those analyzed get their files.
+//
+void configureOutputs(LogData& logData,
+					  unsigned int writtenReports,
+					  bool bLongUsage,
+					  bool bDenialUsage,
+					  long long bucketSeconds,
+					  outputPartition partition,
+					  bool bArrowExport,
+					  bool bSqliteExport,
+					  bool bJsonExport,
+					  const std::string& reportDestination,
+					  compressionFormat reportCompression)
+{
+	logData.setWrittenReports(writtenReports);
+	// The compression derives the output paths anew, so it comes first
+	if (reportCompression != Uncompressed)
+	{
+		logData.setReportCompression(reportCompression);
+	}
+	if (bLongUsage)
+	{
+		logData.setConcurrentUsageFormat(LongUsage);
+	}
+	if (bDenialUsage)
+	{
+		logData.setDenialUsage(true);
+	}
+	if (bucketSeconds > 0)
+	{
+		logData.setUsageBucketWidth(bucketSeconds);
+	}
+	if (partition != NoPartition)
+	{
+		logData.setOutputPartition(partition);
+	}
+	if (bArrowExport)
+	{
+		logData.setArrowExport(true);
+	}
+	if (bSqliteExport)
+	{
+		logData.setSqliteExport(true);
+	}
+	if (bJsonExport)
+	{
+		logData.setJsonExport(true);
+	}
+	if (!reportDestination.empty())
+	{
+		logData.setReportDestination(reportDestination);
+	}
+}
+
+//
+// Analyzes one log file and publishes its results, handling the output file
+// conflicts and mapping any exception to a return code.  In a batch run the
+// successful analyses are also merged into the batch summary, and the events
+// the combined usage needs are spilled to serverRun->path if the caller
+// merges servers.  When
+// following, the log is then followed until the program is stopped, and
+// every snapshotSeconds (if not 0) the results are brought up to the lines
+// followed so far by an incremental run of their own; with a service port, it is kept in memory to answer queries until shut down.
+// With a query, the log is only analyzed and the answer to the query is
+// printed instead of writing the results. Only the selected reports are
+// analyzed, and only the written ones of them written, to the report
+// destination instead of the output folder if one is given, and compressed
+// if a report compression is given.
+// The figures of the analysis stages are handed back in stats if the caller
+// wants them. Up to invalidLineBudget invalid lines are skipped, and only
+// the events in the date range are analyzed.
+//
+int processLogFile(const std::string& inputFilePathString,
+				   const std::string& outputDirectoryString,
+				   bool bOverwrite,
+				   bool bConflicts,
+				   bool bLongUsage,
+				   bool bDenialUsage,
+				   bool bArrowExport,
+				   bool bSqliteExport,
+				   bool bJsonExport,
+				   bool bIncremental,
+				   bool bEventCache,
+				   bool bFollow,
+				   unsigned short servicePort,
+				   unsigned short metricsPort,
+				   unsigned int snapshotSeconds,
+				   const std::string& query,
+				   long long bucketSeconds,
+				   outputPartition partition,
+				   unsigned int reports,
+				   unsigned int writtenReports,
+				   size_t invalidLineBudget,
+				   const DateRange& dateRange,
+				   const EventFilter& eventFilter,
+				   const std::string& reportDestination,
+				   compressionFormat reportCompression,
+				   ThreadPool& pool,
+				   BatchSummary* batchSummary,
+				   ServerRun* serverRun,
+				   PipelineStats* stats,
+				   CatalogEntry* catalogEntry)
 {
 	int         returnVal = 0;
-	std::string inputFilePathString;
-	std::string outputDirectoryString;
 	std::string conflictedFileList;
-	bool        bOverwrite = false;
-	bool        bConflicts = false;
-	bool        bGoodArgs = false;
-	WCHAR       resourceString[MAX_STR_LEN];
-	WCHAR       wcArgv[MAX_STR_LEN];
 
-	//
-	// Initialize
-	//
-	SecureZeroMemory(wcArgv, (sizeof(WCHAR)*MAX_STR_LEN));
-	wcArgv[0] = L'\0'; // To pacify Visual Studio code analysis.
-
-	//
-	// Make sure we get command line parameters.
-	//
-	if (argc && argv)
+	try
 	{
 		//
-		// This will process the input and write to the output folder only if
-		// there are no existing results files.
+		// Checking for conflicts needs only the output paths. A run that would
+		// refuse to overwrite existing results checks them the same way first,
+		// so that nothing is parsed when nothing would be written.
 		//
-		if (argc == 3)
+		if (bConflicts || (!bOverwrite && !bIncremental && query.empty()))
 		{
-			inputFilePathString = ConvertToString(argv[1]);
-			if (inputFilePathString.empty())
+			LogData outputPaths(inputFilePathString, outputDirectoryString, &pool, bIncremental, false,
+								OutputPathsOnly, reports);
+			configureOutputs(outputPaths, writtenReports, bLongUsage, bDenialUsage, bucketSeconds, partition, bArrowExport, bSqliteExport, bJsonExport, reportDestination, reportCompression);
+			outputPaths.checkForExistingFiles(conflictedFileList);
+			if (bConflicts)
 			{
-				returnVal = UNKNOWN_ERROR;
-				LoadStringFromResource(IDS_INTERNAL_ERROR, resourceString);
-				wprintf_s(resourceString);
-				wprintf_s(L"\n\n");
-				goto exitRLMLogFileReport;
+				return(conflictedFileList.empty() ? 0 : 1);
 			}
-			outputDirectoryString = ConvertToString(argv[2]);
-			if (outputDirectoryString.empty())
+			if (!conflictedFileList.empty())
 			{
-				returnVal = UNKNOWN_ERROR;
-				LoadStringFromResource(IDS_INTERNAL_ERROR, resourceString);
-				wprintf_s(resourceString);
-				wprintf_s(L"\n\n");
-				goto exitRLMLogFileReport;
+				return(CONFLICTING_FILES);
 			}
-			bGoodArgs = true;
 		}
+
 		//
-		// This will either write the output files, overwriting any existing results,
-		// or simply check for conflicts, depending on the parameter used.
+		// This class reads the input string, parses the RLM LIC Imaris log file, generates
+		// statistics and gets it read to write out (publish) to the output folder.
+		// The output names are generated based on the input name. 
 		//
-		else if (argc == 4)
+		// This does not write the output files. that is done below.
+		//
+		std::unique_ptr<LogData> logData(new LogData(inputFilePathString, outputDirectoryString, &pool, bIncremental, bEventCache,
+													 FullAnalysis, reports, invalidLineBudget, dateRange, eventFilter));
+		configureOutputs(*logData, writtenReports, bLongUsage, bDenialUsage, bucketSeconds, partition, bArrowExport, bSqliteExport, bJsonExport, reportDestination, reportCompression);
+
+		if (!query.empty())
 		{
-			inputFilePathString = ConvertToString(argv[1]);
-			if (inputFilePathString.empty())
+			//
+			// Answer the query like the service would, without writing anything
+			//
+			std::string response;
+			QueryService queryService(*logData, 0);
+			queryService.answer(query, response);
+			printf_s("%s", response.c_str());
+			if (stats)
 			{
-				returnVal = UNKNOWN_ERROR;
-				LoadStringFromResource(IDS_INTERNAL_ERROR, resourceString);
-				wprintf_s(resourceString);
-				wprintf_s(L"\n\n");
-				goto exitRLMLogFileReport;
+				*stats = logData->stats();
 			}
-			wcsncpy_s(wcArgv, argv[2], MAX_STR_LEN);
-			if (0 == _wcsicmp(wcArgv, PARM_OVERWRITE))
+			if (catalogEntry)
 			{
-				bOverwrite = true;
+				logData->catalogEntry(*catalogEntry);
 			}
-			else if (0 == _wcsicmp(wcArgv, PARM_CONFLICT))
+			return(response.compare(0, 5, "ERROR") == 0 ? INVALID_ARGUMENTS : 0);
+		}
+
+		//
+		// Check to see if output files with the same name already exist, that is
+		// if we have conflicting files.
+		//
+		logData->checkForExistingFiles(conflictedFileList);
+		if (!conflictedFileList.empty())
+		{
+			//
+			// If results files already exist with the output name, check
+			// the overwrite flag. If the user wants them overwritten, do it.
+			// An incremental run appends to the results of the last one.
+			//
+			if (bOverwrite || (bIncremental && !bConflicts))
 			{
-				bConflicts = true;
-			}
+				//
+				// Write the output files.
+				//
+				logData->publishAllResults(pool);
+			}
 			else
 			{
 				//
-				// The given arguments were not valid
+				// Either the user said not to overwrite existing output files, which
+				// is the return of CONFLICTING_FILES or they are just checking for the 
+				// existance of existing files of the same name. So, if output naming 
+				// conflcits exist, set the return value to 1.
 				//
-				printUsage();
-				returnVal = INVALID_ARGUMENTS;
-				goto exitRLMLogFileReport;
+				if (bConflicts)
+				{
+					returnVal = 1;
+				}
+				else
+				{
+					returnVal = CONFLICTING_FILES;
+				}
+			}
+		}
+		else
+		{
+			// 
+			// No output file name conflicts exist, so if the user is just checking
+			// for naming conflicts, set the return value to zero. Otherwise, publish
+			// the results.
+			//
+			if (bConflicts)
+			{
+				returnVal = 0;
+			}
+			else
+			{
+				//
+				// Write the output files.
+				//
+				logData->publishAllResults(pool);
+			}
+		}
+
+		//
+		// A lenient parse lists the lines it skipped in the summary report,
+		// unless the reports go to a stream
+		//
+		if (!logData->invalidLines().empty() && reportDestination.empty() &&
+			outputDirectoryString != StandardOutputPath)
+		{
+			printf_s("Skipped %u invalid line(s) of %s\n",
+					 static_cast<unsigned int>(logData->invalidLines().size()), inputFilePathString.c_str());
+		}
+
+		if (stats)
+		{
+			*stats = logData->stats();
+		}
+
+		if (returnVal == 0 && !bConflicts)
+		{
+			if (bFollow)
+			{
+				std::unique_ptr<MetricsExporter> metricsExporter;
+				if (metricsPort != 0)
+				{
+					metricsExporter.reset(new MetricsExporter(metricsPort));
+				}
+
+				//
+				// A snapshot appends the lines followed so far to the results
+				// and saves their checkpoint like -i, so a restarted follow
+				// resumes from there.  The followed log data is left alone,
+				// and a failed snapshot only waits for the next one.
+				//
+				std::function<void()> snapshot;
+				if (snapshotSeconds > 0)
+				{
+					snapshot = [&]()
+					{
+						try
+						{
+							LogData snapshotData(inputFilePathString, outputDirectoryString, &pool, true, false,
+												 FullAnalysis, reports, invalidLineBudget, dateRange, eventFilter);
+							configureOutputs(snapshotData, writtenReports, bLongUsage, bDenialUsage, bucketSeconds, partition, bArrowExport, bSqliteExport, bJsonExport,
+											 reportDestination, reportCompression);
+							snapshotData.publishAllResults(pool);
+						}
+						catch (const exception& excpt)
+						{
+							fprintf(stderr, "Snapshot of %s failed: %s\n", inputFilePathString.c_str(), excpt.what());
+						}
+					};
+				}
+				LogFollower logFollower(*logData, metricsExporter.get(), 250, snapshot, snapshotSeconds);
+				logFollower.run();
+			}
+			if (servicePort != 0)
+			{
+				QueryService queryService(*logData, servicePort);
+				queryService.run();
+			}
+			if (batchSummary)
+			{
+				batchSummary->addLog(*logData);
+			}
+			if (catalogEntry)
+			{
+				logData->catalogEntry(*catalogEntry);
+			}
+			if (serverRun)
+			{
+				CombinedUsage::spillServer(*logData, *serverRun);
+			}
+		}
+	}
+
+	//
+	// Handle any exceptions, print the errors and set the return codes.
+	//
+	catch (InvalidIndexException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = INVALID_INDEX;
+	}
+	catch (EventDataException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = EVENT_DATA;
+	}
+	catch (INEventDetailException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = EVENT_DETAIL;
+	}
+	catch (InvalidProductVersionException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = INVALID_PRODUCT_VERSION;
+	}
+	catch (CannotOpenFileException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNABLE_TO_FIND_FILE;
+	}
+	catch (CannotFindDirException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNABLE_TO_FIND_DIR;
+	}
+	catch (InvalidFileFormatException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = INVALID_FILE_FORMAT;
+	}
+	catch (CancelledException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = CANCELLED;
+	}
+	catch (const exception& excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNKNOWN_ERROR;
+	}
+
+	return(returnVal);
+}
+
+//
+// Checks for and publishes the combined reports of a batch run (a BatchSummary
+// or a CombinedUsage) made from logCount logs.  Uses the same conflict rules
+// as the per-file outputs.
+//
+template <class CombinedResults>
+int publishCombinedResults(CombinedResults& combinedResults, size_t logCount, bool bOverwrite, bool bConflicts)
+{
+	int         returnVal = 0;
+	std::string conflictedFileList;
+
+	try
+	{
+		combinedResults.checkForExistingFiles(conflictedFileList);
+		if (!conflictedFileList.empty() && !bOverwrite)
+		{
+			returnVal = bConflicts ? 1 : CONFLICTING_FILES;
+		}
+		else if (!bConflicts && logCount > 0)
+		{
+			combinedResults.publishResults();
+		}
+	}
+	catch (CannotOpenFileException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNABLE_TO_FIND_FILE;
+	}
+	catch (CancelledException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = CANCELLED;
+	}
+	catch (const exception& excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNKNOWN_ERROR;
+	}
+
+	return(returnVal);
+}
+
+//
+// Whether the option changes only how a run goes, not what it writes, so
+// that the output cache leaves it out of the key of the run
+//
+bool isRuntimeOption(const wchar_t* option)
+{
+	const wchar_t* runtimeOptions[] = { PARM_OVERWRITE, PARM_PEAK_MEMORY, PARM_STATS, PARM_STATS_JSON, PARM_MEMORY_STATS, PARM_PROGRESS,
+										PARM_MAX_SECONDS, PARM_TRACE, PARM_THREADS, PARM_CPUS, PARM_LOW_PRIORITY, PARM_MAX_MEMORY,
+										PARM_READ_AHEAD, PARM_WRITE_BEHIND, PARM_EVENT_CACHE, PARM_CLUSTER, PARM_LAUNCHER, PARM_OUTPUT_CACHE };
+	for (size_t runtimeOption = 0; runtimeOption < sizeof(runtimeOptions) / sizeof(runtimeOptions[0]); ++runtimeOption)
+	{
+		if (0 == _wcsicmp(option, runtimeOptions[runtimeOption]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//
+// Copies the outputs of an earlier run with the same logs and options from
+// the output cache into the output folder, under the conflict rules of the
+// run itself
+//
+int restoreCachedOutputs(const OutputCache& outputCache, const std::vector<std::string>& fileNames, const std::string& outputDirectory, bool bOverwrite)
+{
+	for (size_t file = 0; file < fileNames.size() && !bOverwrite; ++file)
+	{
+		if (fileExists(outputDirectory + "/" + fileNames.at(file)))
+		{
+			return(CONFLICTING_FILES);
+		}
+	}
+	if (!outputCache.restore(fileNames, outputDirectory))
+	{
+		printf_s("Unable to copy the outputs from the output cache to %s\n", outputDirectory.c_str());
+		return(UNABLE_TO_FIND_FILE);
+	}
+	printf_s("Copied the outputs of an earlier run with the same logs and options from the output cache\n");
+	return(0);
+}
+
+//
+// Saves the batch summary of a run to a partial summary file, which a later
+// --merge-partials run merges with those of other runs
+//
+int savePartialSummary(const BatchSummary& batchSummary, const std::string& filePath)
+{
+	try
+	{
+		batchSummary.savePartial(filePath);
+	}
+	catch (CannotOpenFileException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		return(UNABLE_TO_FIND_FILE);
+	}
+	return(0);
+}
+
+//
+// Leaves out the logs of a batch that the catalog knows to have no event in
+// the date range or none of the selected products. A log not catalogued, or
+// changed since, is kept. With an instant for the range, a time between two
+// logs is in neither of them, so the catalogued log that ended last before
+// it is kept when no log holds the time.
+//
+void selectCatalogedLogs(const LogCatalog& catalog, const DateRange& dateRange, const NameFilter& products, bool bInstant,
+						 std::vector<std::string>& inputFiles)
+{
+	std::vector<std::string> selectedFiles;
+	std::string lastBefore;
+	long long lastBeforeTime = LLONG_MIN;
+	bool bHeld = false;
+
+	for (size_t file = 0; file < inputFiles.size(); ++file)
+	{
+		const CatalogEntry* entry = catalog.find(inputFiles.at(file));
+		bool bSelected = (entry == NULL);
+		if (entry)
+		{
+			bSelected = products.names.empty();
+			for (size_t product = 0; product < entry->products.size() && !bSelected; ++product)
+			{
+				bool bListed = std::find(products.names.begin(), products.names.end(), entry->products.at(product)) != products.names.end();
+				bSelected = (bListed != products.exclude);
+			}
+			bool bDated = (entry->firstTime <= entry->lastTime);
+			if (bSelected && dateRange.bounded() && bDated && entry->lastTime < dateRange.from && entry->lastTime >= lastBeforeTime)
+			{
+				lastBefore = inputFiles.at(file);
+				lastBeforeTime = entry->lastTime;
+			}
+			if (dateRange.bounded() && (!bDated || entry->firstTime >= dateRange.to || entry->lastTime < dateRange.from))
+			{
+				bSelected = false;
+			}
+			bHeld = bHeld || bSelected;
+		}
+		if (bSelected)
+		{
+			selectedFiles.push_back(inputFiles.at(file));
+		}
+	}
+
+	if (bInstant && !bHeld && !lastBefore.empty())
+	{
+		selectedFiles.insert(std::lower_bound(selectedFiles.begin(), selectedFiles.end(), lastBefore), lastBefore);
+	}
+	inputFiles.swap(selectedFiles);
+}
+
+//
+// Records the logs a run parsed whole in the catalog and saves it, if any
+//
+int updateCatalog(LogCatalog& catalog, const std::string& catalogPath, const std::vector<CatalogEntry>& catalogEntries)
+{
+	bool bUpdated = false;
+	for (size_t entry = 0; entry < catalogEntries.size(); ++entry)
+	{
+		if (!catalogEntries.at(entry).inputFilePath.empty() && catalog.update(catalogEntries.at(entry)))
+		{
+			bUpdated = true;
+		}
+	}
+	if (bUpdated && !catalog.save(catalogPath))
+	{
+		printf_s("Unable to save the log catalog %s\n", catalogPath.c_str());
+		return(UNABLE_TO_FIND_FILE);
+	}
+	return(0);
+}
+
+//
+// Splits the logs of a batch into at most shardCount shards of about the
+// same size, each a run of consecutive logs, so that the shards merged in
+// order merge the logs in input order. No shard is empty.
+//
+void splitIntoShards(const std::vector<std::string>& inputFiles, size_t shardCount, std::vector< std::vector<std::string> >& shards)
+{
+	std::vector<uint64_t> fileBytes(inputFiles.size());
+	uint64_t totalBytes = 0;
+	for (size_t file = 0; file < inputFiles.size(); ++file)
+	{
+		// An empty log still takes its turn
+		fileBytes.at(file) = static_cast<uint64_t>(std::max(getFileSize(inputFiles.at(file)), 0LL)) + 1;
+		totalBytes += fileBytes.at(file);
+	}
+
+	uint64_t doneBytes = 0;
+	for (size_t file = 0; file < inputFiles.size(); ++file)
+	{
+		if (shards.empty() || (shards.size() < shardCount && doneBytes * shardCount >= shards.size() * totalBytes))
+		{
+			shards.push_back(std::vector<std::string>());
+		}
+		shards.back().push_back(inputFiles.at(file));
+		doneBytes += fileBytes.at(file);
+	}
+}
+
+//
+// Cluster mode: the logs of a batch are split into shards and every shard
+// analyzed by a worker, this analyzer started again with the arguments of
+// the run on a list file of the shard's logs. The launcher, e.g.
+// "ssh node{shard}" or "srun -N1 -n1", is put in front of the command line
+// of each worker, with {shard} replaced by the number of its shard; without
+// one the workers run on this machine. A worker writes the outputs of its
+// logs and a partial summary, and records them in a catalog of its own,
+// in the output folder, which a worker on another node must reach at the
+// same path. The workers run at the same time; once all are done their
+// partial summaries are merged in shard order into the combined reports,
+// as --merge-partials does, their catalogs into the catalog, and their
+// files removed. A shard whose worker failed sets the return value, and
+// one that saved no partial summary leaves out the combined reports.
+//
+int runClusterShards(const std::vector<std::string>& inputFiles, size_t shardCount, const std::string& launcherTemplate,
+					 const std::vector<std::string>& workerArgs, size_t inputArg, const std::string& outputDirectory,
+					 bool bOverwrite, bool bApproximate, const std::string& partialPath, LogCatalog* catalog, const std::string& catalogPath)
+{
+	int returnVal = 0;
+	std::vector< std::vector<std::string> > shards;
+	splitIntoShards(inputFiles, shardCount, shards);
+
+	// A worker started here shares the working folder
+	bool bLocal = launcherTemplate.empty();
+	std::vector<std::string> shardPaths(shards.size());
+	std::vector<std::string> commandLines(shards.size());
+	for (size_t shard = 0; shard < shards.size() && returnVal == 0; ++shard)
+	{
+		shardPaths.at(shard) = outputDirectory + "/LIC_Imaris_Shard_" + std::to_string(shard);
+		if (!bLocal)
+		{
+			shardPaths.at(shard) = absolutePath(shardPaths.at(shard));
+		}
+		std::ofstream listFile((shardPaths.at(shard) + ".list").c_str(), std::ios::trunc);
+		for (size_t file = 0; file < shards.at(shard).size(); ++file)
+		{
+			listFile << (bLocal ? shards.at(shard).at(file) : absolutePath(shards.at(shard).at(file))) << "\n";
+		}
+		listFile.close();
+		if (!listFile)
+		{
+			printf_s("Unable to write the shard list %s.list\n", shardPaths.at(shard).c_str());
+			returnVal = UNABLE_TO_FIND_FILE;
+		}
+
+		std::string& commandLine = commandLines.at(shard);
+		commandLine = launcherTemplate;
+		for (size_t found = commandLine.find("{shard}"); found != std::string::npos; found = commandLine.find("{shard}", found))
+		{
+			commandLine.replace(found, 7, std::to_string(shard));
+		}
+		for (size_t arg = 0; arg < workerArgs.size(); ++arg)
+		{
+			if (!commandLine.empty())
+			{
+				commandLine += " ";
+			}
+			commandLine += quoteCommandArgument(arg == inputArg ? "@" + shardPaths.at(shard) + ".list" : workerArgs.at(arg));
+		}
+		commandLine += " --shard --save-partial " + quoteCommandArgument(shardPaths.at(shard) + ".partial");
+		if (catalog)
+		{
+			commandLine += " --catalog " + quoteCommandArgument(shardPaths.at(shard) + ".catalog");
+		}
+	}
+
+	if (returnVal == 0)
+	{
+		std::vector<int> workerReturnVals(shards.size(), 0);
+		std::vector<std::thread> workers;
+		for (size_t shard = 0; shard < shards.size(); ++shard)
+		{
+			workers.push_back(std::thread([&workerReturnVals, &commandLines, shard]()
+			{
+				workerReturnVals.at(shard) = runCommand(commandLines.at(shard));
+			}));
+		}
+		for (size_t shard = 0; shard < workers.size(); ++shard)
+		{
+			workers.at(shard).join();
+		}
+
+		BatchSummary batchSummary(outputDirectory, bApproximate);
+		bool bMerged = true;
+		for (size_t shard = 0; shard < shards.size(); ++shard)
+		{
+			if (workerReturnVals.at(shard) != 0)
+			{
+				printf_s("The worker of shard %zu failed (%d)\n", shard, workerReturnVals.at(shard));
+				if (returnVal == 0)
+				{
+					returnVal = UNKNOWN_ERROR;
+				}
+			}
+			if (!batchSummary.addPartial(shardPaths.at(shard) + ".partial"))
+			{
+				printf_s("Shard %zu saved no partial summary\n", shard);
+				bMerged = false;
 			}
 
-			outputDirectoryString = ConvertToString(argv[3]);
-			if (outputDirectoryString.empty())
-			{
-				returnVal = UNKNOWN_ERROR;
-				LoadStringFromResource(IDS_INTERNAL_ERROR, resourceString);
-				wprintf_s(resourceString);
-				wprintf_s(L"\n\n");
-				goto exitRLMLogFileReport;
-			}
-			bGoodArgs = true;
+			LogCatalog shardCatalog;
+			if (catalog && shardCatalog.load(shardPaths.at(shard) + ".catalog"))
+			{
+				catalog->merge(shardCatalog);
+			}
+		}
+
+		int summaryReturnVal = bMerged ? publishCombinedResults(batchSummary, batchSummary.logCount(), bOverwrite, false) : UNKNOWN_ERROR;
+		if (summaryReturnVal == 0 && !partialPath.empty())
+		{
+			summaryReturnVal = savePartialSummary(batchSummary, partialPath);
+		}
+		if (summaryReturnVal == 0 && catalog && !catalog->save(catalogPath))
+		{
+			printf_s("Unable to save the log catalog %s\n", catalogPath.c_str());
+			summaryReturnVal = UNABLE_TO_FIND_FILE;
+		}
+		if (summaryReturnVal != 0 && returnVal == 0)
+		{
+			returnVal = summaryReturnVal;
+		}
+	}
+
+	for (size_t shard = 0; shard < shardPaths.size(); ++shard)
+	{
+		std::remove((shardPaths.at(shard) + ".list").c_str());
+		std::remove((shardPaths.at(shard) + ".partial").c_str());
+		std::remove((shardPaths.at(shard) + ".catalog").c_str());
+	}
+
+	return(returnVal);
+}
+
+//
+// Starts reporting the progress of reading the logs against their total
+// size. A compressed log is read as more text than its file holds, so with
+// one of them there is no total.
+//
+void startProgress(std::unique_ptr<ProgressReporter>& progress, const std::vector<std::string>& inputFiles)
+{
+	uint64_t totalBytes = 0;
+	for (size_t file = 0; file < inputFiles.size(); ++file)
+	{
+		if (detectCompression(inputFiles.at(file)) != Uncompressed)
+		{
+			totalBytes = 0;
+			break;
+		}
+		totalBytes += static_cast<uint64_t>(std::max(getFileSize(inputFiles.at(file)), 0LL));
+	}
+	progress.reset(new ProgressReporter(totalBytes));
+	setProgressReporter(progress.get());
+}
+
+//
+// Compares two periods of the logs from the rollups an earlier full analysis
+// with the event cache (-e) kept next to each of them, without parsing any
+// log, and prints the comparison. A log whose rollups are missing or were
+// made from another state of it returns EVENT_DATA, and nothing is printed.
+//
+int compareLogPeriods(const std::vector<std::string>& inputFiles, PeriodComparison& comparison)
+{
+	for (size_t file = 0; file < inputFiles.size(); ++file)
+	{
+		RollupCache cache;
+		if (!cache.load(rollupCachePath(inputFiles.at(file)), inputFiles.at(file)) || !comparison.addRollups(cache))
+		{
+			printf_s("%s has no rollups of its current state; analyze it with -e first\n", inputFiles.at(file).c_str());
+			return(EVENT_DATA);
+		}
+	}
+
+	std::string comparisonText;
+	comparison.write(comparisonText, currentGroupMapping());
+	printf_s("%s", comparisonText.c_str());
+
+	return(0);
+}
+
+//
+// Checks a log without analyzing it or writing anything: its format, the
+// event and fields of every line and the dates and years, as the parse of a
+// full run does, but with no session, usage or report built. Prints the
+// events by type, the time range with the years it spans, the times the
+// log goes back in time and every invalid line. A log with invalid lines
+// returns EVENT_DATA, so that a script can hold it back.
+//
+int validateLogFile(const std::string& inputFilePathString, ThreadPool& pool, PipelineStats* stats)
+{
+	int returnVal = 0;
+
+	try
+	{
+		LogData logData(inputFilePathString, &pool);
+		logData.parse(false, SIZE_MAX);
+		if (stats)
+		{
+			*stats = logData.stats();
+		}
+
+		const EventStore& events = logData.events();
+		size_t typeCounts[ProductEvent + 1] = { 0 };
+		long long firstTime = 0;
+		long long lastTime = 0;
+		long long previousTime = 0;
+		size_t timedEvents = 0;
+		size_t backwardSteps = 0;
+		for (size_t row = 0; row < events.size(); ++row)
+		{
+			++typeCounts[events.types[row]];
+			if (events.types[row] == ProductEvent)
+			{
+				continue;
+			}
+			long long timestamp = events.timestamps[row];
+			if (timedEvents == 0)
+			{
+				firstTime = timestamp;
+				lastTime = timestamp;
+			}
+			else
+			{
+				firstTime = std::min(firstTime, timestamp);
+				lastTime = std::max(lastTime, timestamp);
+				if (timestamp < previousTime)
+				{
+					++backwardSteps;
+				}
+			}
+			previousTime = timestamp;
+			++timedEvents;
+		}
+
+		printf_s("%s: report log, server %s, RLM %s\n", inputFilePathString.c_str(),
+				 logData.serverName().empty() ? "unknown" : logData.serverName().c_str(),
+				 logData.rlmVersion().empty() ? "unknown" : logData.rlmVersion().c_str());
+		printf_s("Events: %zu (", events.size());
+		for (int type = OutEvent; type <= ProductEvent; ++type)
+		{
+			printf_s("%s%zu %s", type == OutEvent ? "" : ", ", typeCounts[type], eventTypeName(static_cast<eventType>(type)).c_str());
+		}
+		printf_s(")\n");
+		if (timedEvents > 0)
+		{
+			DateTime first;
+			DateTime last;
+			epochToDateTime(firstTime, first);
+			epochToDateTime(lastTime, last);
+			printf_s("Time range: %s to %s (years %d to %d)\n", formatLogDateTime(firstTime).c_str(),
+					 formatLogDateTime(lastTime).c_str(), first.year, last.year);
+			printf_s("Backward time steps: %zu\n", backwardSteps);
+		}
+		else
+		{
+			printf_s("Time range: no timed events\n");
+		}
+
+		const std::vector<InvalidLine>& invalidLines = logData.invalidLines();
+		printf_s("Invalid line(s): %zu\n", invalidLines.size());
+		for (size_t invalid = 0; invalid < invalidLines.size(); ++invalid)
+		{
+			printf_s("Line %llu: %s\n", static_cast<unsigned long long>(invalidLines.at(invalid).line),
+					 invalidLines.at(invalid).reason == MissingFields ? "missing data" : "invalid date or time");
+		}
+		if (!invalidLines.empty())
+		{
+			returnVal = EVENT_DATA;
+		}
+	}
+	catch (CannotOpenFileException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNABLE_TO_FIND_FILE;
+	}
+	catch (InvalidFileFormatException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = INVALID_FILE_FORMAT;
+	}
+	catch (CancelledException excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = CANCELLED;
+	}
+	catch (const exception& excpt)
+	{
+		printf_s("%s\n", excpt.what());
+		returnVal = UNKNOWN_ERROR;
+	}
+
+	return(returnVal);
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	int         returnVal = 0;
+	std::string inputFilePathString;
+	std::string outputDirectoryString;
+	bool        bOverwrite = false;
+	bool        bConflicts = false;
+	bool        bLongUsage = false;
+	bool        bDenialUsage = false;
+	bool        bArrowExport = false;
+	bool        bSqliteExport = false;
+	bool        bJsonExport = false;
+	long long   bucketSeconds = 0;
+	outputPartition partition = NoPartition;
+	bool        bMergeServers = false;
+	size_t      mergeMemory = DefaultMergeMemory;
+	bool        bApproximate = false;
+	std::string partialPath;
+	bool        bMergePartials = false;
+	std::string catalogPath;
+	size_t      clusterShards = 0;
+	std::string launcherTemplate;
+	bool        bShard = false;
+	std::vector<int> coordinatorArgs;
+	int         inputArg = 0;
+	int         outputArg = 0;
+	std::string outputCachePath;
+	std::vector<std::string> outputOptions;
+	bool        bValidate = false;
+	bool        bCompare = false;
+	std::string compareNames[2];
+	long long   compareFrom[2] = { 0, 0 };
+	long long   compareTo[2] = { 0, 0 };
+	bool        bProgress = false;
+	long long   maxSeconds = 0;
+	std::string tracePath;
+	TraceRecorder trace;
+	std::string userGroupsPath;
+	std::string hostGroupsPath;
+	bool        bIncremental = false;
+	bool        bEventCache = false;
+	bool        bFollow = false;
+	long        servicePort = 0;
+	long        metricsPort = 0;
+	long long   snapshotMinutes = 0;
+	std::string queryString;
+	bool        bPeakMemory = false;
+	bool        bStats = false;
+	bool        bMemoryStats = false;
+	std::string statsJsonPath;
+	unsigned int reports = AllReports;
+	unsigned int writtenReports = DefaultReports;
+	size_t      invalidLineBudget = 0;
+	DateRange   dateRange;
+	EventFilter eventFilter;
+	std::string reportDestination;
+	compressionFormat reportCompression = Uncompressed;
+	std::vector<PipelineStats> logStats;
+	bool        bGoodArgs = false;
+	WCHAR       resourceString[MAX_STR_LEN];
+
+	//
+	// Make sure we get command line parameters.
+	//
+	// The input log and the output folder are the two positional arguments.
+	// The input may also be a folder or a file name pattern, which analyzes
+	// every matching log in one run (batch mode).
+	// The options may be given anywhere after the executable name:
+	//   -o  write the output files, overwriting any existing results
+	//   -c  only check for existing result files
+	//   -l  write the concurrent license usage in the long (sparse) layout
+	//   -b  width  also write the usage resampled to buckets of the given
+	//              width: minute, hour, day or a number of minutes
+	//   --partition  week|month  split the processed log, concurrent usage,
+	//                license activity and denied requests into one file per
+	//                week or month. Not with -i or -f
+	//   -m  batch mode only: also merge the logs of several license servers
+	//       into one combined concurrent usage timeline
+	//   --merge-memory  MB  with -m: the memory the merge reads the spilled
+	//                 events of the servers with, 64 MB unless given
+	//   -i  incremental: resume from the checkpoint of the last -i run and
+	//       append only the new part of the log to the results
+	//   -f  follow: analyze like -i, then keep reading the lines appended
+	//       to the log and print the concurrent usage changes as they come
+	//   -a  also export the events, sessions and concurrency timeline as
+	//       Arrow IPC (Feather) files for pandas and BI tools
+	//   --sqlite  also load the events, sessions, denials and concurrency
+	//             timeline into an indexed SQLite database for ad hoc SQL
+	//   --jsonl  also export the events and sessions as JSON Lines, one
+	//            object per line, for log search ingestion
+	//   -e  keep the parsed events in a cache next to each log, so that the
+	//       next run on the unchanged log does not parse it again; a full
+	//       analysis also keeps its day, week and month rollups there
+	//   --metrics  port  with -f: also serve the current counters and the
+	//                    denials to Prometheus on the given TCP port
+	//                    (see MetricsExporter.h)
+	//   --snapshot  minutes  with -f: every so many minutes while lines are
+	//                        appended, bring the results and the checkpoint
+	//                        up to date, so a restart only replays the rest
+	//   -s  port  service: keep the analyzed log in memory and answer queries
+	//             on the given local TCP port (see QueryService.h)
+	//   -q  request  only analyze the log and print the answer to one of the
+	//                service requests, e.g. -q "usage 03/14/2023 14:05"
+	//   -p  print the peak memory use of the run, for sizing the machine
+	//   --stats  print the wall and CPU time, bytes, events per second and
+	//            peak memory of every analysis stage and report writer
+	//   --stats-json  file  write the same figures to a JSON file
+	//   --memory-stats  also estimate the heap of each major structure of
+	//                   the analysis after parsing, analysis and reports
+	//   --progress  print the percent of the logs read, MB/s, events/s and
+	//               the time left to the standard error every second
+	//   --max-seconds  seconds  stop the run cleanly once it has taken the
+	//               given time: the reports being written are dropped, and
+	//               those of the last run stay as they were
+	//   --trace  file  write a Chrome trace event file of when each thread
+	//                  ran which stage, for chrome://tracing or Perfetto
+	//   --user-groups  file  bill the sessions of the users named in the file,
+	//                  one "user,group" per line, to their groups in a
+	//                  chargeback report
+	//   --host-groups  file  bill the other sessions by host, one "host
+	//                  prefix,group" per line, the longest prefix matching
+	//   -r  list  only analyze and write the listed reports, e.g. -r usage,denied,
+	//             or all of them with -r all. Without -r the seven reports of
+	//             the earlier versions are written, from summary to denied.
+	//             An output folder of - writes them to the standard output
+	//   --report  name  destination  write the one report to - (the standard
+	//                   output) or a named pipe as it is produced; the output
+	//                   folder may then be left out
+	//   -z  gzip|zstd  write the reports compressed, as .gz or .zst files
+	//   --read-ahead  auto|on|off  read the log ahead of the parser instead
+	//                 of mapping it; auto does for logs on a network share
+	//   --write-behind  auto|on|off  keep several report writes in flight;
+	//                   auto does for output folders on a network share
+	//   --threads  count  the worker threads of every parallel stage, one per
+	//                 CPU the run may use unless given
+	//   --cpus  list  only run on the listed CPUs, e.g. 0-3,6
+	//   --low-priority  run at background CPU and I/O priority
+	//   --max-memory  MB  keep the buffers, batches and merge within the
+	//                 given memory (see ResourceLimits.h)
+	//   --invalid-lines  count  skip up to count invalid lines and list them
+	//                           in the summary instead of stopping at one
+	//   --from, --to  MM/DD/YYYY[ HH:MM]  only analyze the events in the range;
+	//                 the log is not parsed past its end
+	//   --products, --users, --hosts  name,...  only analyze the events of the
+	//                 listed products, users and hosts; --exclude-products,
+	//                 --exclude-users and --exclude-hosts leave them out instead
+	//   --coalesce-denials  seconds  merge the denials of a user, host, product
+	//                 and reason that come within seconds of each other into
+	//                 one, which tells its requests and the last one's time
+	//   --denial-usage  add the floating and reserved licenses in use and
+	//                 their limits at every denial to the denied requests
+	//                 report. Not with -i
+	//   --reorder-window  seconds  put events that are up to seconds late,
+	//                 e.g. around a DST change, back in time order; the
+	//                 summary tells how many were late. Not with -i or -f
+	//   --off-hours  HH-HH  the hours of the day a session held through is
+	//                 flagged by the forgotten sessions report (default
+	//                 22-6, equal hours for none)
+	//   --long-session  hours  the longest a session is held before that
+	//                 report flags it (default 12, 0 for no limit); an
+	//                 incremental analysis keeps the values of its first run
+	//   --approximate  batch mode only: estimate the distinct users and hosts
+	//                 of the batch summary in fixed memory instead of listing
+	//                 them, and write the distinct users of every product per
+	//                 month in place of the batch total duration tables
+	//   --save-partial  file  also save the batch summary of the logs to a
+	//                 partial summary file, for a later --merge-partials run
+	//   --merge-partials  the input names partial summary files instead of
+	//                 logs; they are merged and the batch summary written
+	//   --catalog  file  keep an index of the logs in the file: the time range,
+	//                 servers, products, event count and event cache of every
+	//                 log parsed whole. A batch run then leaves out the logs
+	//                 the catalog knows to be outside --from, --to and
+	//                 --products without opening them, and a query (-q) may
+	//                 go to a batch: only the logs of its interval and
+	//                 product answer it
+	//   --output-cache  folder  keep the outputs of every run in the folder,
+	//                 keyed by its logs, the options that shape its outputs
+	//                 and the build of the analyzer, and answer a run asked
+	//                 for again, with the logs unchanged, by copying them
+	//                 from there. Not with -c, -i, -f, -s, -q, a stream,
+	//                 --save-partial or --catalog
+	//   --cluster  n  batch mode only: split the logs into n shards of about
+	//                 the same size and analyze every shard in a worker
+	//                 process, then merge the workers' partial summaries into
+	//                 the combined reports. Not with -c, -i, -m or -r
+	//   --launcher  command  with --cluster: start every worker through the
+	//                 command, e.g. "ssh node{shard}" or "srun -N1 -n1", with
+	//                 {shard} replaced by its number; the output folder must
+	//                 then be on a file system the nodes share
+	//   --shard  with --save-partial: a worker of a cluster run, which
+	//                 writes the outputs of its logs and its partial summary
+	//                 but leaves out the combined reports
+	//   --validate  only check that the log is well-formed: print its events
+	//                 by type, time range and invalid lines without analyzing
+	//                 it or writing anything; the output folder is left out
+	//   --compare  period period  print the peak, hours and denials of every
+	//                 product, and the hours of every user and group, in the
+	//                 two periods (YYYY or YYYY-MM) and their changes, from
+	//                 the rollups of an earlier -e run; no log is parsed and
+	//                 the output folder is left out
+	//
+	if (argc && argv)
+	{
+		int positionalArgs = 0;
+
+		bGoodArgs = true;
+		for (int arg = 1; arg < argc && bGoodArgs; ++arg)
+		{
+			int optionArg = arg;
+			int positionalBefore = positionalArgs;
+
+			if (0 == _wcsicmp(argv[arg], PARM_OVERWRITE))
+			{
+				bOverwrite = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_CONFLICT))
+			{
+				bConflicts = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_LONG_USAGE))
+			{
+				bLongUsage = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_INCREMENTAL))
+			{
+				bIncremental = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_ARROW))
+			{
+				bArrowExport = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_SQLITE))
+			{
+				bSqliteExport = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_JSONL))
+			{
+				bJsonExport = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_EVENT_CACHE))
+			{
+				bEventCache = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_FOLLOW))
+			{
+				bFollow = true;
+				bIncremental = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_MERGE))
+			{
+				bMergeServers = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_VALIDATE))
+			{
+				bValidate = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_PROGRESS))
+			{
+				bProgress = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_MAX_SECONDS))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					maxSeconds = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && maxSeconds > 0)
+					{
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_TRACE))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					tracePath = ConvertToString(argv[arg]);
+				}
+				if (tracePath.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_USER_GROUPS) || 0 == _wcsicmp(argv[arg], PARM_HOST_GROUPS))
+			{
+				std::string& mappingPath = (0 == _wcsicmp(argv[arg], PARM_USER_GROUPS)) ? userGroupsPath : hostGroupsPath;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					mappingPath = ConvertToString(argv[arg]);
+				}
+				if (mappingPath.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_MERGE_MEMORY))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long long megabytes = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && megabytes > 0 && megabytes <= (1LL << 20))
+					{
+						mergeMemory = static_cast<size_t>(megabytes) << 20;
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_SERVE))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					servicePort = wcstol(argv[arg], &end, 10);
+					if (end == argv[arg] || *end != L'\0')
+					{
+						servicePort = 0;
+					}
+				}
+				if (servicePort <= 0 || servicePort > 65535)
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_METRICS))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					metricsPort = wcstol(argv[arg], &end, 10);
+					if (end == argv[arg] || *end != L'\0')
+					{
+						metricsPort = 0;
+					}
+				}
+				if (metricsPort <= 0 || metricsPort > 65535)
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_SNAPSHOT))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					snapshotMinutes = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && snapshotMinutes > 0 && snapshotMinutes <= 10080)
+					{
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_STATS))
+			{
+				bStats = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_MEMORY_STATS))
+			{
+				bStats = true;
+				bMemoryStats = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_STATS_JSON))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					statsJsonPath = ConvertToString(argv[arg]);
+				}
+				if (statsJsonPath.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_PEAK_MEMORY))
+			{
+				bPeakMemory = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_QUERY))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					queryString = ConvertToString(argv[arg]);
+				}
+				if (queryString.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_REPORTS))
+			{
+				reports = 0;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					reports = parseReportSelection(argv[arg]);
+				}
+				if (reports == 0)
+				{
+					bGoodArgs = false;
+				}
+				writtenReports = reports;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_REPORT))
+			{
+				reports = 0;
+				if (arg + 2 < argc)
+				{
+					reports = parseReportSelection(argv[arg + 1]);
+					reportDestination = ConvertToString(argv[arg + 2]);
+					arg += 2;
+				}
+				writtenReports = reports;
+
+				// A stream takes a single report
+				if (reports == 0 || (reports & (reports - 1)) != 0 || reportDestination.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_COMPRESS))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					if (0 == _wcsicmp(argv[arg], L"gzip") || 0 == _wcsicmp(argv[arg], L"gz"))
+					{
+						reportCompression = GzipCompressed;
+					}
+					else if (0 == _wcsicmp(argv[arg], L"zstd") || 0 == _wcsicmp(argv[arg], L"zst"))
+					{
+						reportCompression = ZstdCompressed;
+					}
+				}
+				if (reportCompression == Uncompressed)
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_READ_AHEAD))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					const wchar_t* modes[] = { L"auto", L"on", L"off" };
+					const readAheadMode readAheadModes[] = { AutoReadAhead, AlwaysReadAhead, NeverReadAhead };
+					for (size_t mode = 0; mode < 3; ++mode)
+					{
+						if (0 == _wcsicmp(argv[arg], modes[mode]))
+						{
+							setReadAheadMode(readAheadModes[mode]);
+							bGoodArgs = true;
+						}
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_WRITE_BEHIND))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					const wchar_t* modes[] = { L"auto", L"on", L"off" };
+					const writeBehindMode writeBehindModes[] = { AutoWriteBehind, AlwaysWriteBehind, NeverWriteBehind };
+					for (size_t mode = 0; mode < 3; ++mode)
+					{
+						if (0 == _wcsicmp(argv[arg], modes[mode]))
+						{
+							setWriteBehindMode(writeBehindModes[mode]);
+							bGoodArgs = true;
+						}
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_THREADS))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long threads = wcstol(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && threads > 0 && threads <= 1024)
+					{
+						setThreadLimit(static_cast<size_t>(threads));
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_CPUS))
+			{
+				// Set before the pool starts its threads, which take it over
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					bGoodArgs = setCpuAffinity(ConvertToString(argv[arg]));
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_LOW_PRIORITY))
+			{
+				lowerProcessPriority();
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_MAX_MEMORY))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long long megabytes = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && megabytes > 0 && megabytes <= (1LL << 30))
+					{
+						setMemoryLimit(static_cast<uint64_t>(megabytes) << 20);
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_INVALID_LINES))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long long count = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && count >= 0)
+					{
+						invalidLineBudget = static_cast<size_t>(count);
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_FROM) || 0 == _wcsicmp(argv[arg], PARM_TO))
+			{
+				bool bTo = (0 == _wcsicmp(argv[arg], PARM_TO));
+				if (arg + 1 < argc)
+				{
+					++arg;
+					bGoodArgs = parseRangeTime(argv[arg], bTo, bTo ? dateRange.to : dateRange.from);
+				}
+				else
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_PRODUCTS) || 0 == _wcsicmp(argv[arg], PARM_EXCLUDE_PRODUCTS) ||
+					 0 == _wcsicmp(argv[arg], PARM_USERS) || 0 == _wcsicmp(argv[arg], PARM_EXCLUDE_USERS) ||
+					 0 == _wcsicmp(argv[arg], PARM_HOSTS) || 0 == _wcsicmp(argv[arg], PARM_EXCLUDE_HOSTS))
+			{
+				const wchar_t* options[] = { PARM_PRODUCTS, PARM_EXCLUDE_PRODUCTS, PARM_USERS, PARM_EXCLUDE_USERS,
+											 PARM_HOSTS, PARM_EXCLUDE_HOSTS };
+				NameFilter* filters[] = { &eventFilter.products, &eventFilter.users, &eventFilter.hosts };
+				size_t option = 0;
+				while (0 != _wcsicmp(argv[arg], options[option]))
+				{
+					++option;
+				}
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					bGoodArgs = parseNameFilter(argv[arg], option % 2 == 1, *filters[option / 2]);
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_APPROXIMATE))
+			{
+				bApproximate = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_SAVE_PARTIAL))
+			{
+				coordinatorArgs.push_back(arg);
+				if (arg + 1 < argc)
+				{
+					++arg;
+					coordinatorArgs.push_back(arg);
+					partialPath = ConvertToString(argv[arg]);
+				}
+				if (partialPath.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_MERGE_PARTIALS))
+			{
+				bMergePartials = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_CATALOG))
+			{
+				coordinatorArgs.push_back(arg);
+				if (arg + 1 < argc)
+				{
+					++arg;
+					coordinatorArgs.push_back(arg);
+					catalogPath = ConvertToString(argv[arg]);
+				}
+				if (catalogPath.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_OUTPUT_CACHE))
+			{
+				coordinatorArgs.push_back(arg);
+				if (arg + 1 < argc)
+				{
+					++arg;
+					coordinatorArgs.push_back(arg);
+					outputCachePath = ConvertToString(argv[arg]);
+				}
+				if (outputCachePath.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_CLUSTER))
+			{
+				bGoodArgs = false;
+				coordinatorArgs.push_back(arg);
+				if (arg + 1 < argc)
+				{
+					++arg;
+					coordinatorArgs.push_back(arg);
+					wchar_t *end = NULL;
+					long shards = wcstol(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && shards > 0)
+					{
+						clusterShards = static_cast<size_t>(shards);
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_LAUNCHER))
+			{
+				coordinatorArgs.push_back(arg);
+				if (arg + 1 < argc)
+				{
+					++arg;
+					coordinatorArgs.push_back(arg);
+					launcherTemplate = ConvertToString(argv[arg]);
+				}
+				if (launcherTemplate.empty())
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_SHARD))
+			{
+				bShard = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_COALESCE_DENIALS))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long long seconds = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && seconds > 0)
+					{
+						eventFilter.denialWindow = seconds;
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_DENIAL_USAGE))
+			{
+				bDenialUsage = true;
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_REORDER_WINDOW))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long long seconds = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && seconds > 0)
+					{
+						eventFilter.reorderWindow = seconds;
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_OFF_HOURS))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long startHour = wcstol(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'-')
+					{
+						const wchar_t *endText = end + 1;
+						long endHour = wcstol(endText, &end, 10);
+						if (end != endText && *end == L'\0' && startHour >= 0 && startHour < 24 && endHour >= 0 && endHour < 24)
+						{
+							eventFilter.forgotten.offHoursStart = static_cast<int>(startHour);
+							eventFilter.forgotten.offHoursEnd = static_cast<int>(endHour);
+							bGoodArgs = true;
+						}
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_LONG_SESSION))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					wchar_t *end = NULL;
+					long long hours = wcstoll(argv[arg], &end, 10);
+					if (end != argv[arg] && *end == L'\0' && hours >= 0 && hours <= 24 * 366)
+					{
+						eventFilter.forgotten.longSeconds = hours * 3600;
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_COMPARE))
+			{
+				bGoodArgs = false;
+				if (arg + 2 < argc)
+				{
+					for (int period = 0; period < 2; ++period)
+					{
+						compareNames[period] = ConvertToString(argv[++arg]);
+					}
+					bGoodArgs = PeriodComparison::parsePeriod(compareNames[0], compareFrom[0], compareTo[0]) &&
+								PeriodComparison::parsePeriod(compareNames[1], compareFrom[1], compareTo[1]) &&
+								(compareTo[0] <= compareFrom[1] || compareTo[1] <= compareFrom[0]);
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_PARTITION))
+			{
+				bGoodArgs = false;
+				if (arg + 1 < argc)
+				{
+					++arg;
+					if (0 == _wcsicmp(argv[arg], L"week"))
+					{
+						partition = WeekPartition;
+						bGoodArgs = true;
+					}
+					else if (0 == _wcsicmp(argv[arg], L"month"))
+					{
+						partition = MonthPartition;
+						bGoodArgs = true;
+					}
+				}
+			}
+			else if (0 == _wcsicmp(argv[arg], PARM_BUCKETS))
+			{
+				if (arg + 1 < argc)
+				{
+					++arg;
+					bucketSeconds = parseBucketWidth(argv[arg]);
+				}
+				if (bucketSeconds <= 0)
+				{
+					bGoodArgs = false;
+				}
+			}
+			else if ((argv[arg][0] == L'-' && !(positionalArgs == 1 && argv[arg][1] == L'\0')) || positionalArgs == 2)
+			{
+				//
+				// Unknown option or too many arguments
+				//
+				bGoodArgs = false;
+			}
+			else
+			{
+				std::string& argString = (positionalArgs == 0) ? inputFilePathString : outputDirectoryString;
+				argString = ConvertToString(argv[arg]);
+				((positionalArgs == 0) ? inputArg : outputArg) = arg;
+				if (argString.empty())
+				{
+					returnVal = UNKNOWN_ERROR;
+					LoadStringFromResource(IDS_INTERNAL_ERROR, resourceString);
+					wprintf_s(resourceString);
+					wprintf_s(L"\n\n");
+					goto exitRLMLogFileReport;
+				}
+				++positionalArgs;
+			}
+
+			//
+			// The options that shape the outputs, with their values, key
+			// the run in the output cache
+			//
+			if (positionalArgs == positionalBefore && !isRuntimeOption(argv[optionArg]))
+			{
+				std::string option = ConvertToString(argv[optionArg]);
+				std::transform(option.begin(), option.end(), option.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+				for (int value = optionArg + 1; value <= arg; ++value)
+				{
+					option += " " + ConvertToString(argv[value]);
+				}
+				outputOptions.push_back(option);
+			}
+		}
+
+		//
+		// Overwriting and only checking for conflicts exclude each other
+		//
+		bCompare = !compareNames[0].empty();
+		if (positionalArgs == 1 && (!reportDestination.empty() || bValidate || bCompare))
+		{
+			outputDirectoryString = ".";
+			positionalArgs = 2;
+		}
+		if (positionalArgs != 2 || (bOverwrite && bConflicts) || ((bFollow || servicePort != 0) && bConflicts) || (bFollow && servicePort != 0) ||
+			(!queryString.empty() && (bConflicts || bFollow || servicePort != 0 || bIncremental)))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// The metrics and the snapshots are those of a followed log
+		//
+		if ((metricsPort != 0 || snapshotMinutes > 0) && !bFollow)
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// A selection of reports, or the standard output, leaves out what
+		// the other modes need, and the buckets are made from the usage
+		//
+		bool bStandardOutput = (outputDirectoryString == StandardOutputPath || !reportDestination.empty());
+		if ((reports != AllReports || bStandardOutput) &&
+			(bIncremental || bFollow || servicePort != 0 || !queryString.empty() || bArrowExport || bSqliteExport || bJsonExport || bMergeServers))
+		{
+			bGoodArgs = false;
+		}
+		if (bucketSeconds > 0 && !(reports & ConcurrentUsageReport))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// An incremental run appends to the reports of the last one, and a
+		// stream takes the reports whole
+		//
+		if (partition != NoPartition && (bIncremental || bFollow || bStandardOutput))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// A partial summary holds the summary of whole logs, and merging
+		// partial summaries analyzes no log
+		//
+		if ((!partialPath.empty() || bMergePartials) &&
+			(reports != AllReports || bStandardOutput || bFollow || servicePort != 0 || !queryString.empty()))
+		{
+			bGoodArgs = false;
+		}
+		if (bMergePartials && (bIncremental || bMergeServers || bArrowExport || bSqliteExport || bJsonExport || bEventCache))
+		{
+			bGoodArgs = false;
+		}
+		if (mergeMemory != DefaultMergeMemory && !bMergeServers)
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// The catalog records logs parsed whole, which an incremental run
+		// does not, and partial summaries are no logs
+		//
+		if (!catalogPath.empty() && (bIncremental || servicePort != 0 || bMergePartials))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// A cluster run analyzes whole logs in separate processes and only
+		// merges their partial summaries, and a shard of one saves its
+		// partial summary for that merge instead of the combined reports
+		//
+		if ((clusterShards > 0 || bShard) &&
+			(bConflicts || bIncremental || bFollow || servicePort != 0 || !queryString.empty() || bMergeServers || bMergePartials ||
+			 reports != AllReports || bStandardOutput || bValidate || bCompare))
+		{
+			bGoodArgs = false;
+		}
+		if ((clusterShards > 0 && (bShard || bProgress || !tracePath.empty() || !statsJsonPath.empty())) ||
+			(!launcherTemplate.empty() && clusterShards == 0) || (bShard && partialPath.empty()))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// The output cache keeps the reports a run writes to the output
+		// folder whole, and copies them over what is there
+		//
+		if (!outputCachePath.empty() &&
+			(bConflicts || bIncremental || bFollow || servicePort != 0 || !queryString.empty() || bStandardOutput || bValidate || bCompare ||
+			 !partialPath.empty() || !catalogPath.empty() || bShard))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// Partial summaries hold no sessions to bill
+		//
+		if ((!userGroupsPath.empty() || !hostGroupsPath.empty()) && bMergePartials)
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// Incremental runs append to the plain reports of the last run, and
+		// carry their state over the whole log
+		//
+		if ((reportCompression != Uncompressed || dateRange.bounded() || eventFilter.active() || eventFilter.denialWindow > 0 || eventFilter.reorderWindow > 0 || bApproximate || bDenialUsage) && bIncremental)
+		{
+			bGoodArgs = false;
+		}
+		if (dateRange.from >= dateRange.to)
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// A followed or served log is never done, and merging partial
+		// summaries reads no log nor takes long
+		//
+		if ((bProgress || maxSeconds > 0) && (bFollow || servicePort != 0 || bMergePartials))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// Nor would its trace ever be written
+		//
+		if (!tracePath.empty() && (bFollow || servicePort != 0))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// Validating only parses the logs, so it takes none of the options
+		// of the analysis or its outputs
+		//
+		if (bValidate &&
+			(bOverwrite || bConflicts || bLongUsage || bDenialUsage || bucketSeconds > 0 || partition != NoPartition || bMergeServers || bIncremental || bEventCache || servicePort != 0 ||
+			 !queryString.empty() || bArrowExport || bSqliteExport || bJsonExport || reports != AllReports || !reportDestination.empty() ||
+			 reportCompression != Uncompressed || invalidLineBudget != 0 || dateRange.bounded() || eventFilter.active() ||
+			 eventFilter.denialWindow > 0 || eventFilter.reorderWindow > 0 || bApproximate || !partialPath.empty() || bMergePartials ||
+			 !catalogPath.empty() || !userGroupsPath.empty() || !hostGroupsPath.empty()))
+		{
+			bGoodArgs = false;
+		}
+
+		//
+		// Nor does comparing periods, which reads only the rollups; the
+		// groups may still be mapped
+		//
+		if (bCompare &&
+			(bValidate || bOverwrite || bConflicts || bLongUsage || bDenialUsage || bucketSeconds > 0 || partition != NoPartition || bMergeServers || bIncremental || bEventCache ||
+			 servicePort != 0 || !queryString.empty() || bArrowExport || bSqliteExport || bJsonExport || reports != AllReports ||
+			 !reportDestination.empty() || reportCompression != Uncompressed || invalidLineBudget != 0 || dateRange.bounded() ||
+			 eventFilter.active() || eventFilter.denialWindow > 0 || eventFilter.reorderWindow > 0 || bApproximate || !partialPath.empty() ||
+			 bMergePartials || !catalogPath.empty() || bProgress || maxSeconds > 0 || !tracePath.empty()))
+		{
+			bGoodArgs = false;
 		}
 	}
 
@@ -226,127 +2395,479 @@ int _tmain(int argc, _TCHAR* argv[])
 	//
 	if (bGoodArgs)
 	{
-		try
+		std::vector<std::string> batchInputFiles;
+		ThreadPool               pool;
+		LogCatalog               catalog;
+		GroupMapping             groupMapping;
+		std::unique_ptr<ProgressReporter> progress;
+		CancellationToken        cancellation;
+
+		//
+		// The stages poll the token and stop the run once the time is up
+		//
+		if (maxSeconds > 0)
+		{
+			cancellation.cancelAfter(std::chrono::seconds(maxSeconds));
+			setCancellationToken(&cancellation);
+		}
+		if (!tracePath.empty())
+		{
+			setTraceRecorder(&trace);
+		}
+		setMemoryAccounting(bMemoryStats);
+		if (!userGroupsPath.empty() || !hostGroupsPath.empty())
+		{
+			// Loaded below before any log is analyzed
+			setGroupMapping(&groupMapping);
+		}
+
+		bool                     bBatch = getBatchInputFiles(inputFilePathString, batchInputFiles);
+
+		//
+		// The output cache keys the run by its logs, the group mappings its
+		// reports are made with, its options and the build of the analyzer.
+		// A log that cannot be inspected fails the run as usual.
+		//
+		OutputCache              outputCache(outputCachePath);
+		std::vector<std::string> cachedFiles;
+		long long                runStart = static_cast<long long>(time(NULL));
+		bool                     bCacheable = false;
+		if (!outputCachePath.empty())
+		{
+			std::vector<std::string> keyFiles(bBatch ? batchInputFiles : std::vector<std::string>(1, inputFilePathString));
+			for (const std::string& mappingPath : { userGroupsPath, hostGroupsPath })
+			{
+				if (!mappingPath.empty())
+				{
+					keyFiles.push_back(mappingPath);
+				}
+			}
+			outputOptions.push_back(std::string("build ") + CLCR_BUILD_VERSION + " " + __DATE__ + " " + __TIME__);
+			bCacheable = outputCache.setKey(keyFiles, outputOptions);
+		}
+
+		if (bBatch && (bFollow || servicePort != 0 || (!queryString.empty() && catalogPath.empty()) || reports != AllReports ||
+					   outputDirectoryString == StandardOutputPath || !reportDestination.empty()))
+		{
+			//
+			// Only a single log can be followed or served, and only a
+			// catalogued batch queried
+			//
+			printUsage();
+			returnVal = INVALID_ARGUMENTS;
+		}
+		else if (!bBatch && (clusterShards > 0 || bShard))
+		{
+			//
+			// Only the logs of a batch are split into shards
+			//
+			printUsage();
+			returnVal = INVALID_ARGUMENTS;
+		}
+		else if (!catalogPath.empty() && !catalog.load(catalogPath) && fileExists(catalogPath))
+		{
+			printf_s("%s is not a log catalog\n", catalogPath.c_str());
+			returnVal = INVALID_FILE_FORMAT;
+		}
+		else if (!userGroupsPath.empty() && !groupMapping.loadUsers(userGroupsPath))
+		{
+			printf_s("%s is not a user group mapping\n", userGroupsPath.c_str());
+			returnVal = INVALID_FILE_FORMAT;
+		}
+		else if (!hostGroupsPath.empty() && !groupMapping.loadHosts(hostGroupsPath))
+		{
+			printf_s("%s is not a host group mapping\n", hostGroupsPath.c_str());
+			returnVal = INVALID_FILE_FORMAT;
+		}
+		else if (bCacheable && outputCache.find(cachedFiles))
+		{
+			//
+			// An unchanged request is answered with the outputs of the run
+			// that made them, without analyzing anything
+			//
+			returnVal = restoreCachedOutputs(outputCache, cachedFiles, outputDirectoryString, bOverwrite);
+			bCacheable = false;
+		}
+		else if (bValidate)
+		{
+			//
+			// Every log of a batch is checked in turn, and the first one that
+			// fails sets the return value
+			//
+			if (!bBatch)
+			{
+				batchInputFiles.push_back(inputFilePathString);
+			}
+			if (bProgress)
+			{
+				startProgress(progress, batchInputFiles);
+			}
+			logStats.resize(batchInputFiles.size());
+			for (size_t file = 0; file < batchInputFiles.size(); ++file)
+			{
+				if (file > 0)
+				{
+					printf_s("\n");
+				}
+				int fileReturnVal = validateLogFile(batchInputFiles.at(file), pool, &logStats.at(file));
+				if (fileReturnVal != 0 && returnVal == 0)
+				{
+					returnVal = fileReturnVal;
+				}
+			}
+		}
+		else if (bCompare)
 		{
 			//
-			// This class reads the input string, parses the RLM LIC Imaris log file, generates
-			// statistics and gets it read to write out (publish) to the output folder.
-			// The output names are generated based on the input name. 
+			// The rollups of every log of a batch add up by name
+			//
+			if (!bBatch)
+			{
+				batchInputFiles.push_back(inputFilePathString);
+			}
+			PeriodComparison comparison(compareNames[0], compareFrom[0], compareTo[0], compareNames[1], compareFrom[1], compareTo[1]);
+			returnVal = compareLogPeriods(batchInputFiles, comparison);
+		}
+		else if (bMergePartials)
+		{
 			//
-			// This does not write the output files. that is done below.
+			// Reduce step: the partial summaries saved by other runs, e.g. on
+			// other machines, are merged in input order into one batch
+			// summary, which may itself be saved for a further merge
 			//
-			LogData logData(inputFilePathString, outputDirectoryString);
+			BatchSummary batchSummary(outputDirectoryString, bApproximate);
+			if (!bBatch)
+			{
+				batchInputFiles.push_back(inputFilePathString);
+			}
+			for (size_t file = 0; file < batchInputFiles.size() && returnVal == 0; ++file)
+			{
+				if (!batchSummary.addPartial(batchInputFiles.at(file)))
+				{
+					printf_s("%s is not a partial summary%s\n", batchInputFiles.at(file).c_str(),
+							 bApproximate ? " of an --approximate run" : "");
+					returnVal = INVALID_FILE_FORMAT;
+				}
+			}
 
+			if (returnVal == 0)
+			{
+				returnVal = publishCombinedResults(batchSummary, batchSummary.logCount(), bOverwrite, bConflicts);
+			}
+			if (returnVal == 0 && !partialPath.empty() && !bConflicts)
+			{
+				returnVal = savePartialSummary(batchSummary, partialPath);
+			}
+		}
+		else if (bBatch && !queryString.empty())
+		{
 			//
-			// Check to see if output files with the same name already exist, that is
-			// if we have conflicting files.
+			// A query over a catalogued archive goes to the logs of its
+			// interval and product, and of the date range and products, in
+			// input order. Each answers in turn, after a line naming it if
+			// several do, and the first one that fails ends the query.
 			//
-			logData.checkForExistingFiles(conflictedFileList);
-			if (!conflictedFileList.empty())
+			DateRange   queryRange;
+			NameFilter  queryProducts;
+			std::string queryProduct;
+			if (QueryService::requestScope(queryString, queryRange.from, queryRange.to, queryProduct))
+			{
+				if (!queryProduct.empty())
+				{
+					queryProducts.names.push_back(queryProduct);
+				}
+				selectCatalogedLogs(catalog, dateRange, eventFilter.products, false, batchInputFiles);
+				selectCatalogedLogs(catalog, queryRange, queryProducts, queryRange.to - queryRange.from == 1, batchInputFiles);
+			}
+			if (batchInputFiles.empty())
+			{
+				printf_s("ERROR no log of the batch holds the request\n");
+				returnVal = INVALID_ARGUMENTS;
+			}
+			else if (bProgress)
 			{
+				startProgress(progress, batchInputFiles);
+			}
+
+			std::vector<CatalogEntry> catalogEntries(batchInputFiles.size());
+			logStats.resize(batchInputFiles.size());
+			for (size_t file = 0; file < batchInputFiles.size() && returnVal == 0; ++file)
+			{
+				if (batchInputFiles.size() > 1)
+				{
+					printf_s("%s\n", batchInputFiles.at(file).c_str());
+				}
+				returnVal = processLogFile(batchInputFiles.at(file), outputDirectoryString,
+										   bOverwrite, bConflicts, bLongUsage, bDenialUsage, bArrowExport, bSqliteExport, bJsonExport, false, bEventCache, false, 0, 0, 0, queryString,
+										   bucketSeconds, partition, reports, writtenReports, invalidLineBudget, dateRange, eventFilter, reportDestination, reportCompression, pool,
+										   NULL, NULL, &logStats.at(file), &catalogEntries.at(file));
+			}
+
+			int catalogReturnVal = updateCatalog(catalog, catalogPath, catalogEntries);
+			if (catalogReturnVal != 0 && returnVal == 0)
+			{
+				returnVal = catalogReturnVal;
+			}
+		}
+		else if (bBatch && clusterShards > 0)
+		{
+			//
+			// Cluster mode: the workers get the arguments of this run but
+			// for those the coordinator keeps, with the paths they share
+			// made absolute for workers the launcher starts elsewhere
+			//
+			std::vector<std::string> workerArgs;
+			for (int arg = 0; arg < argc; ++arg)
+			{
+				if (std::find(coordinatorArgs.begin(), coordinatorArgs.end(), arg) != coordinatorArgs.end())
+				{
+					continue;
+				}
+				if (arg == inputArg)
+				{
+					inputArg = static_cast<int>(workerArgs.size());
+				}
+				std::string argString = ConvertToString(argv[arg]);
+				if (!launcherTemplate.empty() && (arg == outputArg || (arg == 0 && argString.find_first_of("/\\") != std::string::npos)))
+				{
+					argString = absolutePath(argString);
+				}
+				workerArgs.push_back(argString);
+			}
+
+			if (!catalogPath.empty())
+			{
+				selectCatalogedLogs(catalog, dateRange, eventFilter.products, false, batchInputFiles);
+			}
+			returnVal = runClusterShards(batchInputFiles, clusterShards, launcherTemplate, workerArgs, static_cast<size_t>(inputArg),
+										 outputDirectoryString, bOverwrite, bApproximate, partialPath,
+										 catalogPath.empty() ? NULL : &catalog, catalogPath);
+		}
+		else if (bBatch)
+		{
+			//
+			// Batch mode: the input is a folder or a file name pattern. Every log
+			// gets its own outputs and is merged into the combined reports. The
+			// logs are analyzed in parallel, each into a partial summary, and the
+			// partials are merged in input order. The first failing log sets the
+			// return value but the rest still run. When merging servers, each
+			// log spills its events for the combined timeline to a run file in
+			// the output folder, so that the logs are not kept in memory. A catalog leaves out the logs
+			// it knows to be outside the date range and products.
+			//
+			if (!catalogPath.empty())
+			{
+				selectCatalogedLogs(catalog, dateRange, eventFilter.products, false, batchInputFiles);
+			}
+			if (bProgress)
+			{
+				startProgress(progress, batchInputFiles);
+			}
+
+			BatchSummary batchSummary(outputDirectoryString, bApproximate);
+			std::vector< std::unique_ptr<BatchSummary> > partialSummaries;
+			std::vector<int> fileReturnVals(batchInputFiles.size(), 0);
+			std::vector<ServerRun> serverRuns(batchInputFiles.size());
+			for (size_t file = 0; file < serverRuns.size(); ++file)
+			{
+				serverRuns.at(file).path = outputDirectoryString + "/LIC_Imaris_Combined_Run_" + std::to_string(file) + ".tmp";
+			}
+			std::vector<CatalogEntry> catalogEntries(batchInputFiles.size());
+			logStats.resize(batchInputFiles.size());
+
+			for (size_t file = 0; file < batchInputFiles.size(); ++file)
+			{
+				partialSummaries.push_back(std::unique_ptr<BatchSummary>(new BatchSummary(outputDirectoryString, bApproximate)));
+			}
+
+			{
+				auto processBatchFile = [&](size_t file)
+				{
+					fileReturnVals.at(file) = processLogFile(batchInputFiles.at(file), outputDirectoryString,
+															 bOverwrite, bConflicts, bLongUsage, bDenialUsage, bArrowExport, bSqliteExport, bJsonExport, bIncremental, bEventCache, false, 0, 0, 0, std::string(),
+															 bucketSeconds, partition, reports, writtenReports, invalidLineBudget, dateRange, eventFilter, reportDestination, reportCompression, pool, partialSummaries.at(file).get(),
+															 bMergeServers ? &serverRuns.at(file) : NULL, &logStats.at(file),
+															 catalogPath.empty() ? NULL : &catalogEntries.at(file));
+				};
+
 				//
-				// If results files already exist with the output name, check
-				// the overwrite flag. If the user wants them overwritten, do it.
+				// Under a memory limit only one log's events are held at a
+				// time; each log still uses the pool for its own stages
 				//
-				if (bOverwrite)
+				if (memoryLimit() > 0)
 				{
-					//
-					// Write the output files.
-					//
-					logData.publishResults();
-					logData.publishEventDataResults();
+					for (size_t file = 0; file < batchInputFiles.size(); ++file)
+					{
+						processBatchFile(file);
+					}
 				}
 				else
 				{
-					//
-					// Either the user said not to overwrite existing output files, which
-					// is the return of CONFLICTING_FILES or they are just checking for the 
-					// existance of existing files of the same name. So, if output naming 
-					// conflcits exist, set the return value to 1.
-					//
-					if (bConflicts)
+					TaskGroup logFiles(pool);
+					for (size_t file = 0; file < batchInputFiles.size(); ++file)
 					{
-						returnVal = 1;
-					}
-					else
-					{
-						returnVal = CONFLICTING_FILES;
+						logFiles.run([&processBatchFile, file]()
+						{
+							processBatchFile(file);
+						});
 					}
+					logFiles.wait();
 				}
 			}
-			else
+
+			for (size_t file = 0; file < batchInputFiles.size(); ++file)
 			{
-				// 
-				// No output file name conflicts exist, so if the user is just checking
-				// for naming conflicts, set the return value to zero. Otherwise, publish
-				// the results.
-				//
-				if (bConflicts)
+				batchSummary.addSummary(*partialSummaries.at(file));
+				if (fileReturnVals.at(file) != 0 && returnVal == 0)
 				{
-					returnVal = 0;
+					returnVal = fileReturnVals.at(file);
 				}
-				else
+			}
+
+			// The combined reports of a shard are left to the merge
+			int summaryReturnVal = bShard ? 0 : publishCombinedResults(batchSummary, batchSummary.logCount(), bOverwrite || bIncremental, bConflicts);
+			if (summaryReturnVal == 0 && !partialPath.empty() && !bConflicts)
+			{
+				summaryReturnVal = savePartialSummary(batchSummary, partialPath);
+			}
+			if (summaryReturnVal == 0 && !catalogPath.empty())
+			{
+				summaryReturnVal = updateCatalog(catalog, catalogPath, catalogEntries);
+			}
+			if (summaryReturnVal != 0 && returnVal == 0)
+			{
+				returnVal = summaryReturnVal;
+			}
+
+			if (bMergeServers)
+			{
+				// A memory limit caps the read buffers of the merge
+				CombinedUsage combinedUsage(outputDirectoryString, limitedBufferSize(mergeMemory, 1 << 20, 1));
+				for (size_t file = 0; file < serverRuns.size(); ++file)
+				{
+					// Only a spilled run has its server name
+					if (!serverRuns.at(file).serverName.empty())
+					{
+						combinedUsage.addServer(serverRuns.at(file));
+					}
+				}
+
+				int combinedReturnVal = publishCombinedResults(combinedUsage, combinedUsage.serverCount(), bOverwrite || bIncremental, bConflicts);
+				if (combinedReturnVal != 0 && returnVal == 0)
 				{
-					//
-					// Write the output files.
-					//
-					logData.publishResults();
-					logData.publishEventDataResults();
+					returnVal = combinedReturnVal;
 				}
 			}
 		}
+		else
+		{
+			//
+			// A single log saved as a partial summary goes through the same
+			// summary as the logs of a batch
+			//
+			std::unique_ptr<BatchSummary> logSummary;
+			if (!partialPath.empty())
+			{
+				logSummary.reset(new BatchSummary(outputDirectoryString, bApproximate));
+			}
+
+			if (bProgress)
+			{
+				startProgress(progress, std::vector<std::string>(1, inputFilePathString));
+			}
+
+			std::vector<CatalogEntry> catalogEntries(1);
+			logStats.resize(1);
+			returnVal = processLogFile(inputFilePathString, outputDirectoryString,
+									   bOverwrite, bConflicts, bLongUsage, bDenialUsage, bArrowExport, bSqliteExport, bJsonExport, bIncremental, bEventCache, bFollow,
+									   static_cast<unsigned short>(servicePort), static_cast<unsigned short>(metricsPort),
+									   static_cast<unsigned int>(snapshotMinutes * 60), queryString,
+									   bucketSeconds, partition, reports, writtenReports, invalidLineBudget, dateRange, eventFilter, reportDestination, reportCompression, pool,
+									   logSummary.get(), NULL, &logStats.at(0), catalogPath.empty() ? NULL : &catalogEntries.at(0));
+			if (returnVal == 0 && logSummary && logSummary->logCount() > 0)
+			{
+				returnVal = savePartialSummary(*logSummary, partialPath);
+			}
+			if (returnVal == 0 && !catalogPath.empty())
+			{
+				returnVal = updateCatalog(catalog, catalogPath, catalogEntries);
+			}
+		}
 
 		//
-		// Handle any exceptions, print the errors and set the return codes.
+		// The outputs of a run that succeeded are kept for the next one;
+		// the cache only saves time, so failing to is no failure of the run
 		//
-		catch (InvalidIndexException excpt)
+		if (bCacheable && returnVal == 0 && !outputCache.store(outputDirectoryString, runStart))
 		{
-			printf_s("%s\n", excpt.what());
-			returnVal = INVALID_INDEX;
-		}
-		catch (EventDataException excpt)
-		{
-			printf_s("%s\n", excpt.what());
-			returnVal = EVENT_DATA;
+			printf_s("Unable to keep the outputs in the output cache %s\n", outputCachePath.c_str());
 		}
-		catch (INEventDetailException excpt)
+
+		setProgressReporter(NULL);
+		setCancellationToken(NULL);
+		setTraceRecorder(NULL);
+		setMemoryAccounting(false);
+		setGroupMapping(NULL);
+	}
+	else
+	{
+		//
+		// The given arguments were not valid
+		//
+		printUsage();
+		returnVal = INVALID_ARGUMENTS;
+	}
+
+	//
+	// Statistics of the logs that got analyzed
+	//
+	if (bStats)
+	{
+		for (size_t log = 0; log < logStats.size(); ++log)
 		{
-			printf_s("%s\n", excpt.what());
-			returnVal = EVENT_DETAIL;
+			if (!logStats.at(log).stages().empty())
+			{
+				printf_s("%s\n", logStats.at(log).format().c_str());
+			}
 		}
-		catch (InvalidProductVersionException excpt)
+	}
+	if (!statsJsonPath.empty() && !logStats.empty())
+	{
+		try
 		{
-			printf_s("%s\n", excpt.what());
-			returnVal = INVALID_PRODUCT_VERSION;
+			writePipelineStatsJson(statsJsonPath, logStats);
 		}
 		catch (CannotOpenFileException excpt)
 		{
 			printf_s("%s\n", excpt.what());
-			returnVal = UNABLE_TO_FIND_FILE;
-		}
-		catch (CannotFindDirException excpt)
-		{
-			printf_s("%s\n", excpt.what());
-			returnVal = UNABLE_TO_FIND_DIR;
+			if (returnVal == 0)
+			{
+				returnVal = UNABLE_TO_FIND_FILE;
+			}
 		}
-		catch (InvalidFileFormatException excpt)
+	}
+
+	if (bGoodArgs && !tracePath.empty())
+	{
+		try
 		{
-			printf_s("%s\n", excpt.what());
-			returnVal = INVALID_FILE_FORMAT;
+			trace.write(tracePath);
 		}
-		catch (exception excpt)
+		catch (CannotOpenFileException excpt)
 		{
 			printf_s("%s\n", excpt.what());
-			returnVal = UNKNOWN_ERROR;
+			if (returnVal == 0)
+			{
+				returnVal = UNABLE_TO_FIND_FILE;
+			}
 		}
 	}
-	else
+
+	if (bGoodArgs && bPeakMemory)
 	{
-		//
-		// The given arguments were not valid
-		//
-		printUsage();
-		returnVal = INVALID_ARGUMENTS;
+		LoadStringFromResource(IDS_PEAK_MEMORY, resourceString);
+		wprintf_s(resourceString, static_cast<double>(peakMemoryUsage()) / (1024.0 * 1024.0));
+		wprintf_s(L"\n");
 	}
 
 	exitRLMLogFileReport:
@@ -0,0 +1,65 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// The replaced global operator new and delete of the benchmarks.  They live
+// in a translation unit of their own, so that the compiler does not pair
+// the malloc and free inside them with the new and delete expressions of
+// the benchmarks.
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+    atomic<uint64_t> s_allocations(0);
+}
+
+uint64_t allocationCount()
+{
+    return s_allocations.load(memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+    s_allocations.fetch_add(1, memory_order_relaxed);
+    void* block = malloc(size ? size : 1);
+    if (block == NULL)
+    {
+        throw bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void* block) noexcept
+{
+    free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+    free(block);
+}
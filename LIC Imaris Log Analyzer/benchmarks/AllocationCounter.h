@@ -0,0 +1,30 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+// The heap allocations made through the global operator new so far.  The
+// benchmarks replace operator new in AllocationCounter.cpp to count them;
+// the difference of two readings is what the code in between allocated.
+uint64_t allocationCount();
@@ -0,0 +1,614 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// Checks that the fast paths of the analysis write the same reports as the
+// reference pipeline, byte for byte.  The reference is LogData on one thread
+// with the scalar tokenizer and no event cache.  Each log is analyzed by it
+// and then by every other engine configuration, and all the reports of every
+// configuration are compared with the reference's:
+//
+//   vectorized tokenizer  the best backend the CPU supports
+//   chunked parse         a thread pool, which parses logs over 4 MB in chunks
+//   event cache           a first run that saves the cache, a second one from it
+//   incremental           the first half of the log, then the rest appended
+//
+// An incremental analysis lists the license activity in check-in order and
+// leaves a last line without a line break for the next run, so its reports
+// are compared with those of a single incremental run of the whole log.
+//
+// The reference reports can also be saved as golden outputs and later runs,
+// e.g. of another build, compared with them:
+//
+//   lic_equivalence --save_golden=golden big.log
+//   lic_equivalence --golden=golden big.log
+//   lic_equivalence --synthetic --log_bytes=4G --log_shutdowns=5
+//
+// The logs are copied into a work directory first, so that every engine
+// reads the log under the same path and its License Summary is the same.
+// The summary names that path, so golden outputs are compared in the same
+// work directory they were saved in.
+
+#include "SyntheticLog.h"
+#include "BlockReader.h"
+#include "EventCache.h"
+#include "Exceptions.h"
+#include "LogData.h"
+#include "ThreadPool.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace
+{
+    struct HarnessOptions
+    {
+        HarnessOptions()
+            : threads(max(2u, thread::hardware_concurrency())),
+              synthetic(false),
+              keepWorkDirectory(false),
+              workDirectory((fs::temp_directory_path() / "lic-equivalence").string())
+        {
+        }
+
+        size_t threads;
+        bool synthetic;
+        bool keepWorkDirectory;
+        string workDirectory;
+        string goldenDirectory;
+        string saveGoldenDirectory;
+        SyntheticLogOptions logOptions;
+        vector<string> logPaths;
+    };
+
+    // Writes the reports of the log into the output directory
+    typedef function<void(const string& logPath, const string& outputDirectory)> engineRun;
+
+    struct Engine
+    {
+        string name;
+        engineRun run;
+        bool incremental;
+    };
+
+    // Check-outs, check-ins and denials
+    struct EventTotals
+    {
+        EventTotals() : checkOuts(0), checkIns(0), denials(0) {}
+
+        uint64_t checkOuts;
+        uint64_t checkIns;
+        uint64_t denials;
+    };
+
+    EventTotals analyzeAndPublish(const string& logPath, const string& outputDirectory,
+                                  ThreadPool* pool, bool incremental, bool useEventCache)
+    {
+        LogData logData(logPath, outputDirectory, pool, incremental, useEventCache);
+        if (pool)
+        {
+            logData.publishAllResults(*pool);
+        }
+        else
+        {
+            logData.publishAllResults();
+        }
+
+        EventTotals totals;
+        const EventStore& events = logData.events();
+        for (size_t row = 0; row < events.size(); ++row)
+        {
+            totals.checkOuts += events.types[row] == OutEvent;
+            totals.checkIns += events.types[row] == InEvent;
+            totals.denials += events.types[row] == DenyEvent;
+        }
+        return totals;
+    }
+
+    // The event lines of an uncompressed log by their first word, read
+    // without the analyzer, so that a parse which stops short of the end of
+    // the log, e.g. at 4 GB, is told from one that reads all of it
+    EventTotals countEventLines(const string& logPath)
+    {
+        ifstream log(logPath.c_str(), ios::binary);
+        if (! log)
+        {
+            throw CannotOpenFileException(logPath);
+        }
+        EventTotals totals;
+        string line;
+        while (getline(log, line))
+        {
+            totals.checkOuts += line.compare(0, 4, "OUT ") == 0;
+            totals.checkIns += line.compare(0, 3, "IN ") == 0;
+            totals.denials += line.compare(0, 5, "DENY ") == 0;
+        }
+        return totals;
+    }
+
+    vector<string> compareTotals(const EventTotals& lines, const EventTotals& events)
+    {
+        vector<string> differences;
+        const char* names[] = { "check-outs", "check-ins", "denials" };
+        const uint64_t expected[] = { lines.checkOuts, lines.checkIns, lines.denials };
+        const uint64_t actual[] = { events.checkOuts, events.checkIns, events.denials };
+        for (size_t total = 0; total < 3; ++total)
+        {
+            if (expected[total] != actual[total])
+            {
+                differences.push_back(to_string(expected[total]) + " " + names[total] + " in the log, " +
+                                      to_string(actual[total]) + " analyzed");
+            }
+        }
+        return differences;
+    }
+
+    // Restores the tokenizer backend when the run ends, whatever happens
+    class TokenizerScope
+    {
+        public:
+            explicit TokenizerScope(TokenizerBackend backend) : m_previous(tokenizerBackend())
+            {
+                setTokenizerBackend(backend);
+            }
+            ~TokenizerScope()
+            {
+                setTokenizerBackend(m_previous);
+            }
+
+        private:
+            TokenizerBackend m_previous;
+    };
+
+    // Restores the read-ahead mode when the run ends
+    class ReadAheadScope
+    {
+        public:
+            explicit ReadAheadScope(readAheadMode mode) : m_previous(currentReadAheadMode())
+            {
+                setReadAheadMode(mode);
+            }
+            ~ReadAheadScope()
+            {
+                setReadAheadMode(m_previous);
+            }
+
+        private:
+            readAheadMode m_previous;
+    };
+
+    EventTotals runReference(const string& logPath, const string& outputDirectory)
+    {
+        TokenizerScope scalar(ScalarTokenizer);
+        ReadAheadScope mapped(NeverReadAhead);
+        return analyzeAndPublish(logPath, outputDirectory, NULL, false, false);
+    }
+
+    void runEventCache(const string& logPath, const string& outputDirectory)
+    {
+        string cachePath = eventCachePath(logPath);
+        fs::remove(cachePath);
+        analyzeAndPublish(logPath, outputDirectory, NULL, false, true);
+        if (! fs::exists(cachePath))
+        {
+            throw runtime_error("no event cache was saved");
+        }
+        analyzeAndPublish(logPath, outputDirectory, NULL, false, true);
+        fs::remove(cachePath);
+    }
+
+    // Offset of the line start nearest after the middle of the log
+    uint64_t middleLineStart(const string& logPath)
+    {
+        ifstream log(logPath.c_str(), ios::binary);
+        uint64_t size = fs::file_size(logPath);
+        log.seekg(static_cast<streamoff>(size / 2));
+        string rest;
+        getline(log, rest);
+        return log ? static_cast<uint64_t>(log.tellg()) : size;
+    }
+
+    // The log is cut at its middle, analyzed, completed with the original's
+    // remaining lines and analyzed again from the checkpoint
+    void runIncremental(const string& logPath, const string& outputDirectory, const string& originalPath)
+    {
+        uint64_t split = middleLineStart(originalPath);
+        fs::resize_file(logPath, split);
+        analyzeAndPublish(logPath, outputDirectory, NULL, true, false);
+
+        {
+            ifstream original(originalPath.c_str(), ios::binary);
+            original.seekg(static_cast<streamoff>(split));
+            ofstream log(logPath.c_str(), ios::binary | ios::app);
+            log << original.rdbuf();
+            if (! log)
+            {
+                throw CannotOpenFileException(logPath);
+            }
+        }
+        analyzeAndPublish(logPath, outputDirectory, NULL, true, false);
+    }
+
+    // Reports only; the checkpoint of an incremental run is not one of them
+    vector<string> reportNames(const string& directory)
+    {
+        vector<string> names;
+        if (! fs::is_directory(directory))
+        {
+            return names;
+        }
+        for (fs::directory_iterator entry(directory); entry != fs::directory_iterator(); ++entry)
+        {
+            string name = entry->path().filename().string();
+            if (fs::is_regular_file(entry->status()) && name.find("_LIC_Imaris_Checkpoint") == string::npos)
+            {
+                names.push_back(name);
+            }
+        }
+        sort(names.begin(), names.end());
+        return names;
+    }
+
+    // Empty if the files are equal, otherwise where they first differ
+    string firstDifference(const string& expectedPath, const string& actualPath)
+    {
+        ifstream expected(expectedPath.c_str(), ios::binary);
+        ifstream actual(actualPath.c_str(), ios::binary);
+        if (! expected || ! actual)
+        {
+            return "cannot be read";
+        }
+
+        const size_t BlockSize = 1 << 16;
+        vector<char> expectedBlock(BlockSize);
+        vector<char> actualBlock(BlockSize);
+        uint64_t offset = 0;
+        uint64_t line = 1;
+        while (true)
+        {
+            expected.read(expectedBlock.data(), BlockSize);
+            actual.read(actualBlock.data(), BlockSize);
+            size_t expectedSize = static_cast<size_t>(expected.gcount());
+            size_t actualSize = static_cast<size_t>(actual.gcount());
+            size_t common = min(expectedSize, actualSize);
+            for (size_t byte = 0; byte < common; ++byte)
+            {
+                if (expectedBlock[byte] != actualBlock[byte])
+                {
+                    return "differs at byte " + to_string(offset + byte) + " (line " + to_string(line) + ")";
+                }
+                if (expectedBlock[byte] == '\n')
+                {
+                    ++line;
+                }
+            }
+            offset += common;
+            if (expectedSize != actualSize)
+            {
+                return (expectedSize < actualSize ? "is longer" : "is shorter") +
+                       string(", from byte ") + to_string(offset) + " (line " + to_string(line) + ")";
+            }
+            if (expectedSize < BlockSize)
+            {
+                return string();
+            }
+        }
+    }
+
+    // All reports of the expected directory must be in the actual one and
+    // equal, and the actual one must have no others
+    vector<string> compareReports(const string& expectedDirectory, const string& actualDirectory)
+    {
+        vector<string> differences;
+        vector<string> expected = reportNames(expectedDirectory);
+        vector<string> actual = reportNames(actualDirectory);
+        for (size_t report = 0; report < expected.size(); ++report)
+        {
+            if (! binary_search(actual.begin(), actual.end(), expected[report]))
+            {
+                differences.push_back(expected[report] + " is missing");
+                continue;
+            }
+            string difference = firstDifference(expectedDirectory + "/" + expected[report],
+                                                actualDirectory + "/" + expected[report]);
+            if (! difference.empty())
+            {
+                differences.push_back(expected[report] + " " + difference);
+            }
+        }
+        for (size_t report = 0; report < actual.size(); ++report)
+        {
+            if (! binary_search(expected.begin(), expected.end(), actual[report]))
+            {
+                differences.push_back(actual[report] + " is not written by the reference");
+            }
+        }
+        if (expected.empty())
+        {
+            differences.push_back("no reports in " + expectedDirectory);
+        }
+        return differences;
+    }
+
+    bool printResult(const string& name, const vector<string>& differences)
+    {
+        printf("  %-32s %s\n", name.c_str(), differences.empty() ? "identical" : "DIFFERENT");
+        for (size_t difference = 0; difference < differences.size(); ++difference)
+        {
+            printf("      %s\n", differences[difference].c_str());
+        }
+        return differences.empty();
+    }
+
+    // Runs the engine into a fresh output directory and compares its reports
+    bool checkEngine(const Engine& engine, const string& logPath, const string& referenceDirectory,
+                     const string& outputDirectory)
+    {
+        fs::remove_all(outputDirectory);
+        fs::create_directories(outputDirectory);
+        try
+        {
+            engine.run(logPath, outputDirectory);
+        }
+        catch (exception& e)
+        {
+            return printResult(engine.name, vector<string>(1, string("failed: ") + e.what()));
+        }
+        return printResult(engine.name, compareReports(referenceDirectory, outputDirectory));
+    }
+
+    void copyReports(const string& fromDirectory, const string& toDirectory)
+    {
+        fs::create_directories(toDirectory);
+        vector<string> names = reportNames(fromDirectory);
+        for (size_t report = 0; report < names.size(); ++report)
+        {
+            fs::copy_file(fromDirectory + "/" + names[report], toDirectory + "/" + names[report],
+                          fs::copy_option::overwrite_if_exists);
+        }
+    }
+
+    // Returns false if any engine wrote other reports than the reference
+    bool checkLog(const string& originalPath, const HarnessOptions& options, const fs::path& workDirectory)
+    {
+        string logName = fs::path(originalPath).filename().string();
+        fs::path logDirectory = workDirectory / logName;
+        fs::create_directories(logDirectory);
+        string logPath = (logDirectory / logName).string();
+        fs::copy_file(originalPath, logPath, fs::copy_option::overwrite_if_exists);
+        printf("%s\n", originalPath.c_str());
+
+        string referenceDirectory = (logDirectory / "reference").string();
+        fs::create_directories(referenceDirectory);
+        EventTotals referenceTotals;
+        try
+        {
+            referenceTotals = runReference(logPath, referenceDirectory);
+        }
+        catch (exception& e)
+        {
+            return printResult("reference", vector<string>(1, string("failed: ") + e.what()));
+        }
+
+        bool equal = true;
+        if (detectCompression(originalPath) == Uncompressed)
+        {
+            equal = printResult("reference against the log lines",
+                                compareTotals(countEventLines(logPath), referenceTotals)) && equal;
+        }
+        if (! options.saveGoldenDirectory.empty())
+        {
+            copyReports(referenceDirectory, options.saveGoldenDirectory + "/" + logName);
+        }
+        if (! options.goldenDirectory.empty())
+        {
+            equal = printResult("reference against golden",
+                                compareReports(options.goldenDirectory + "/" + logName, referenceDirectory)) && equal;
+        }
+
+        ThreadPool pool(options.threads);
+        vector<Engine> engines;
+        TokenizerBackend best = detectTokenizerBackend();
+        if (best != ScalarTokenizer)
+        {
+            Engine tokenizer = {tokenizerBackendName(best) + " tokenizer",
+                                [](const string& log, const string& output)
+                                {
+                                    analyzeAndPublish(log, output, NULL, false, false);
+                                },
+                                false};
+            engines.push_back(tokenizer);
+        }
+        Engine chunked = {"chunked parse, " + to_string(options.threads) + " threads",
+                          [&pool](const string& log, const string& output)
+                          {
+                              analyzeAndPublish(log, output, &pool, false, false);
+                          },
+                          false};
+        Engine readAhead = {"read-ahead, " + to_string(options.threads) + " threads",
+                            [&pool](const string& log, const string& output)
+                            {
+                                ReadAheadScope always(AlwaysReadAhead);
+                                analyzeAndPublish(log, output, &pool, false, false);
+                            },
+                            false};
+        Engine cached = {"event cache", runEventCache, false};
+        Engine incremental = {"incremental",
+                              [&originalPath](const string& log, const string& output)
+                              {
+                                  runIncremental(log, output, originalPath);
+                              },
+                              true};
+        engines.push_back(chunked);
+        engines.push_back(readAhead);
+        engines.push_back(cached);
+
+        // A compressed log cannot be cut into a growing one
+        if (detectCompression(originalPath) == Uncompressed)
+        {
+            engines.push_back(incremental);
+        }
+
+        string incrementalReferenceDirectory = (logDirectory / "incremental reference").string();
+        fs::create_directories(incrementalReferenceDirectory);
+        bool incrementalReference = true;
+        try
+        {
+            analyzeAndPublish(logPath, incrementalReferenceDirectory, NULL, true, false);
+        }
+        catch (exception& e)
+        {
+            incrementalReference = printResult("incremental reference", vector<string>(1, string("failed: ") + e.what()));
+            equal = false;
+        }
+
+        for (size_t engine = 0; engine < engines.size(); ++engine)
+        {
+            if (engines[engine].incremental && ! incrementalReference)
+            {
+                continue;
+            }
+            string outputDirectory = (logDirectory / ("engine" + to_string(engine))).string();
+            equal = checkEngine(engines[engine], logPath,
+                                engines[engine].incremental ? incrementalReferenceDirectory : referenceDirectory,
+                                outputDirectory) && equal;
+        }
+        if (! options.keepWorkDirectory)
+        {
+            fs::remove_all(logDirectory);
+        }
+
+        return equal;
+    }
+
+    bool parseHarnessOptions(int argc, char** argv, HarnessOptions& options)
+    {
+        for (int arg = 1; arg < argc; ++arg)
+        {
+            string argument = argv[arg];
+            if (parseSyntheticLogOption(argument, "log_", options.logOptions))
+            {
+                continue;
+            }
+            if (argument == "--synthetic")
+            {
+                options.synthetic = true;
+            }
+            else if (argument == "--keep")
+            {
+                options.keepWorkDirectory = true;
+            }
+            else if (argument.compare(0, 10, "--threads=") == 0 && atoi(argument.c_str() + 10) > 0)
+            {
+                options.threads = static_cast<size_t>(atoi(argument.c_str() + 10));
+            }
+            else if (argument.compare(0, 7, "--work=") == 0)
+            {
+                options.workDirectory = argument.substr(7);
+            }
+            else if (argument.compare(0, 9, "--golden=") == 0)
+            {
+                options.goldenDirectory = argument.substr(9);
+            }
+            else if (argument.compare(0, 14, "--save_golden=") == 0)
+            {
+                options.saveGoldenDirectory = argument.substr(14);
+            }
+            else if (argument.compare(0, 2, "--") == 0)
+            {
+                cerr << "Invalid argument: " << argument << endl;
+                return false;
+            }
+            else
+            {
+                options.logPaths.push_back(argument);
+            }
+        }
+        return options.synthetic || ! options.logPaths.empty();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    HarnessOptions options;
+    if (! parseHarnessOptions(argc, argv, options))
+    {
+        cerr << "Usage: lic_equivalence [options] [log files]" << endl
+             << "  --synthetic          also check a synthetic log of the --log_ options" << endl
+             << "  --threads=N          threads of the chunked parse" << endl
+             << "  --golden=DIR         compare the reference reports with the ones saved in DIR" << endl
+             << "  --save_golden=DIR    save the reference reports in DIR" << endl
+             << "  --work=DIR           work directory, emptied first (" << options.workDirectory << ")" << endl
+             << "  --keep               keep the work directory" << endl
+             << syntheticLogOptionsHelp("log_");
+        return 1;
+    }
+
+    fs::path workDirectory(options.workDirectory);
+    bool equal = true;
+    try
+    {
+        fs::remove_all(workDirectory);
+        fs::create_directories(workDirectory);
+        if (options.synthetic)
+        {
+            fs::create_directories(workDirectory / "synthetic");
+            fs::path syntheticPath = workDirectory / "synthetic" / "synthetic.log";
+            writeSyntheticLog(syntheticPath.string(), options.logOptions);
+            options.logPaths.push_back(syntheticPath.string());
+        }
+        for (size_t log = 0; log < options.logPaths.size(); ++log)
+        {
+            equal = checkLog(options.logPaths[log], options, workDirectory) && equal;
+        }
+    }
+    catch (exception& e)
+    {
+        cerr << e.what() << endl;
+        equal = false;
+    }
+
+    if (options.keepWorkDirectory)
+    {
+        printf("Work directory: %s\n", workDirectory.string().c_str());
+    }
+    else
+    {
+        fs::remove_all(workDirectory);
+    }
+    printf("%s\n", equal ? "All engines wrote the reference reports." : "Some engines wrote other reports.");
+
+    return equal ? 0 : 1;
+}
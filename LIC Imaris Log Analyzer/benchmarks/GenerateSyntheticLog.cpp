@@ -0,0 +1,72 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// Writes a synthetic RLM report log for scale and regression tests, e.g.
+//   lic_generate_log big.log --bytes=20G --open_handles=5000 --shutdowns=3
+
+#include "SyntheticLog.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    SyntheticLogOptions options;
+    string filePath;
+    bool valid = true;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        string argument = argv[arg];
+        if (parseSyntheticLogOption(argument, "", options))
+        {
+            continue;
+        }
+        if (argument.compare(0, 2, "--") == 0 || ! filePath.empty())
+        {
+            cerr << "Invalid argument: " << argument << endl;
+            valid = false;
+            break;
+        }
+        filePath = argument;
+    }
+    if (! valid || filePath.empty())
+    {
+        cerr << "Usage: lic_generate_log <output file> [options]" << endl
+             << syntheticLogOptionsHelp("");
+        return 1;
+    }
+
+    try
+    {
+        writeSyntheticLog(filePath, options);
+    }
+    catch (exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
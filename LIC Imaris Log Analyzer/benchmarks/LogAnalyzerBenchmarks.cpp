@@ -0,0 +1,627 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmarks of the parser and analysis hot paths.  The analysis stages run
+// inside LogData, so those benchmarks take their time from its stage
+// statistics (see PipelineStats) rather than from the whole constructor.
+//
+// The synthetic log is configured with the options of SyntheticLogOptions,
+// prefixed "log_" (e.g. --log_events=1000000 --log_open_handles=4096), next
+// to the usual --benchmark_* flags.  A change is compared against a baseline
+// with --benchmark_out=baseline.json.
+//
+// The benchmarks count the heap allocations of the code they run through
+// the global operator new of AllocationCounter.cpp; the *Allocations ones
+// report them per event, which stays near zero once the passes' buffers
+// have grown.
+
+#include "SyntheticLog.h"
+#include "AllocationCounter.h"
+#include "BlockReader.h"
+#include "BufferedWriter.h"
+#include "FlatHashMap.h"
+#include "LogData.h"
+#include "PipelineStats.h"
+#include "StringInterner.h"
+#include "SustainedPeaks.h"
+#include "ThreadPool.h"
+#include "Tokenizer.h"
+#include "Utilities.h"
+
+#include <benchmark/benchmark.h>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+namespace
+{
+    SyntheticLogOptions s_logOptions;
+    boost::filesystem::path s_workDirectory;
+
+    string logLabel(const SyntheticLogOptions& options)
+    {
+        string events = options.bytes ? "bytes=" + to_string(options.bytes)
+                                      : "events=" + to_string(options.events);
+        return events +
+               " users=" + to_string(options.users) +
+               " products=" + to_string(options.products) +
+               " open_handles=" + to_string(options.openHandles) +
+               (options.shutdowns ? " shutdowns=" + to_string(options.shutdowns) : string());
+    }
+
+    // Every shape of synthetic log is written once, on first use
+    const string& syntheticLogPath(const SyntheticLogOptions& options)
+    {
+        static map<string, string> paths;
+        string& path = paths[logLabel(options)];
+        if (path.empty())
+        {
+            path = (s_workDirectory / ("synthetic" + to_string(paths.size()) + ".log")).string();
+            writeSyntheticLog(path, options);
+        }
+        return path;
+    }
+
+    const string& syntheticLogPath()
+    {
+        return syntheticLogPath(s_logOptions);
+    }
+
+    const vector<string_view>& syntheticLogLines()
+    {
+        static MappedFile file;
+        static vector<string_view> lines;
+        if (lines.empty())
+        {
+            file.open(syntheticLogPath());
+            loadLineViewsFromFile(file, lines);
+        }
+        return lines;
+    }
+
+    string logLabel()
+    {
+        return logLabel(s_logOptions);
+    }
+
+    // Sum of the stages of that name, as an analysis may run one twice
+    double stageSeconds(const LogData& logData, const string& name, uint64_t& events)
+    {
+        double seconds = 0;
+        events = 0;
+        vector<StageStats> stages = logData.stats().stages();
+        for (size_t stage = 0; stage < stages.size(); ++stage)
+        {
+            if (stages[stage].name == name)
+            {
+                seconds += stages[stage].wallSeconds;
+                events += stages[stage].events;
+            }
+        }
+        return seconds;
+    }
+
+    // Runs the analysis and reports the time of the given stages only, also
+    // per event of the log
+    void benchmarkStages(benchmark::State& state,
+                         analysisScope scope,
+                         const vector<string>& stageNames,
+                         ThreadPool* pool = NULL,
+                         const SyntheticLogOptions& logOptions = s_logOptions)
+    {
+        const string& logPath = syntheticLogPath(logOptions);
+        uint64_t logSize = boost::filesystem::file_size(logPath);
+        uint64_t events = 0;
+        double totalSeconds = 0;
+        for (auto _ : state)
+        {
+            LogData logData(logPath, s_workDirectory.string(), pool, false, false, scope);
+            double seconds = 0;
+            events = 0;
+            for (size_t stage = 0; stage < stageNames.size(); ++stage)
+            {
+                uint64_t stageEvents;
+                seconds += stageSeconds(logData, stageNames[stage], stageEvents);
+                events = max(events, stageEvents);
+            }
+            state.SetIterationTime(seconds);
+            totalSeconds += seconds;
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * events));
+        if (scope == EventsOnly)
+        {
+            state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * logSize));
+        }
+        state.counters["ns/event"] = totalSeconds * 1e9 / static_cast<double>(max<uint64_t>(state.iterations() * events, 1));
+        state.SetLabel(logLabel(logOptions));
+    }
+
+    // The dimensions the scaling benchmarks stretch the synthetic log of the
+    // flags in, one at a time
+    enum LogDimension
+    {
+        ProductsDimension,      // columns of the usage rows
+        UsersDimension,         // holdings of the users by product
+        OpenHandlesDimension,   // sessions in flight at once
+        ShutdownsDimension      // restarts that close every open session
+    };
+
+    SyntheticLogOptions stretchedLog(int64_t dimension, int64_t value)
+    {
+        SyntheticLogOptions options = s_logOptions;
+        size_t size = static_cast<size_t>(value);
+        switch (dimension)
+        {
+            case ProductsDimension:
+                options.products = size;
+                break;
+            case UsersDimension:
+                options.users = size;
+                break;
+            case OpenHandlesDimension:
+                options.openHandles = size;
+                break;
+            default:
+                options.shutdowns = size;
+                break;
+        }
+        return options;
+    }
+
+    // From the usual shape of a log to well past the largest seen
+    void scalingCases(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({"dimension", "size"});
+        for (int64_t products : {8, 64, 512})
+        {
+            benchmark->Args({ProductsDimension, products});
+        }
+        for (int64_t users : {40, 4000, 100000})
+        {
+            benchmark->Args({UsersDimension, users});
+        }
+        for (int64_t openHandles : {64, 4096, 65536})
+        {
+            benchmark->Args({OpenHandlesDimension, openHandles});
+        }
+        for (int64_t shutdowns : {0, 100, 10000})
+        {
+            benchmark->Args({ShutdownsDimension, shutdowns});
+        }
+    }
+
+    // The names of BM_GetUniqueItems: every one of uniqueCount names 16 times
+    vector<string> repeatedNames(size_t uniqueCount)
+    {
+        vector<string> names;
+        for (size_t repeat = 0; repeat < 16; ++repeat)
+        {
+            for (size_t name = 0; name < uniqueCount; ++name)
+            {
+                names.push_back("user" + to_string(name));
+            }
+        }
+        return names;
+    }
+
+    // The lookup tables of BM_InternNames and BM_HandleTable
+    enum LookupTable
+    {
+        FlatTable,
+        UnorderedMapTable,
+        MapTable
+    };
+
+    // Checks events handles out and in again, openHandles of them open at
+    // once, as a log does with its dense handle ids
+    template <typename Table>
+    void cycleHandles(benchmark::State& state, size_t openHandles, size_t events)
+    {
+        for (auto _ : state)
+        {
+            Table table;
+            for (size_t handle = 0; handle < events; ++handle)
+            {
+                ++table[handle];
+                if (handle >= openHandles)
+                {
+                    table.erase(handle - openHandles);
+                }
+            }
+            benchmark::DoNotOptimize(table.size());
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * events));
+    }
+
+    // Takes the synthetic log flags out of the arguments, so that only the
+    // benchmark library's own flags are left for it
+    void parseLogOptions(int& argc, char** argv)
+    {
+        int kept = 1;
+        for (int arg = 1; arg < argc; ++arg)
+        {
+            if (! parseSyntheticLogOption(argv[arg], "log_", s_logOptions))
+            {
+                argv[kept++] = argv[arg];
+            }
+        }
+        argc = kept;
+    }
+}
+
+static void BM_TokenizeString(benchmark::State& state)
+{
+    const vector<string_view>& lines = syntheticLogLines();
+    vector<string> tokens;
+    size_t line = 0;
+    int64_t bytes = 0;
+    for (auto _ : state)
+    {
+        tokenizeString(" ", lines[line], tokens);
+        benchmark::DoNotOptimize(tokens.data());
+        bytes += lines[line].size();
+        line = (line + 1) % lines.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_TokenizeString);
+
+// The tokenizer extractEvents uses, for every backend the CPU supports
+static void BM_TokenizeLine(benchmark::State& state)
+{
+    TokenizerBackend backend = static_cast<TokenizerBackend>(state.range(0));
+    if (! tokenizerBackendSupported(backend))
+    {
+        state.SkipWithError("backend not supported by this CPU");
+        return;
+    }
+    TokenizerBackend previous = tokenizerBackend();
+    setTokenizerBackend(backend);
+
+    const vector<string_view>& lines = syntheticLogLines();
+    vector<string_view> tokens;
+    size_t line = 0;
+    int64_t bytes = 0;
+    for (auto _ : state)
+    {
+        tokenizeLine(lines[line], tokens);
+        benchmark::DoNotOptimize(tokens.data());
+        bytes += lines[line].size();
+        line = (line + 1) % lines.size();
+    }
+    setTokenizerBackend(previous);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(tokenizerBackendName(backend));
+}
+BENCHMARK(BM_TokenizeLine)->Arg(ScalarTokenizer)->Arg(SSE2Tokenizer)->Arg(AVX2Tokenizer);
+
+static void BM_StringToBoostTime(benchmark::State& state)
+{
+    vector<string> dates;
+    vector<string> times;
+    for (int day = 1; day <= 28; ++day)
+    {
+        dates.push_back("03/" + to_string(day) + "/2024");
+        times.push_back(to_string(day % 24) + ":" + to_string(day * 2) + ":" + to_string(59 - day));
+    }
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(stringToBoostTime(dates[index], times[index]));
+        index = (index + 1) % dates.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StringToBoostTime);
+
+// Collects the unique names of a list in which every one of range(0) names
+// occurs 16 times
+static void BM_GetUniqueItems(benchmark::State& state)
+{
+    vector<string> names = repeatedNames(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        vector<string> uniqueItems;
+        for (size_t name = 0; name < names.size(); ++name)
+        {
+            getUniqueItems(names[name], uniqueItems);
+        }
+        benchmark::DoNotOptimize(uniqueItems.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * names.size()));
+}
+BENCHMARK(BM_GetUniqueItems)->Arg(8)->Arg(64)->Arg(512);
+
+// The same names interned in the table range(1), a LookupTable: the
+// StringInterner of the parser, or a node based map of strings
+static void BM_InternNames(benchmark::State& state)
+{
+    vector<string> names = repeatedNames(static_cast<size_t>(state.range(0)));
+    LookupTable table = static_cast<LookupTable>(state.range(1));
+    for (auto _ : state)
+    {
+        size_t ids = 0;
+        if (table == FlatTable)
+        {
+            StringInterner interner;
+            for (size_t name = 0; name < names.size(); ++name)
+            {
+                ids += interner.intern(names[name]);
+            }
+        }
+        else if (table == UnorderedMapTable)
+        {
+            unordered_map<string, size_t> interner;
+            for (size_t name = 0; name < names.size(); ++name)
+            {
+                ids += interner.emplace(names[name], interner.size()).first->second;
+            }
+        }
+        else
+        {
+            map<string, size_t> interner;
+            for (size_t name = 0; name < names.size(); ++name)
+            {
+                ids += interner.emplace(names[name], interner.size()).first->second;
+            }
+        }
+        benchmark::DoNotOptimize(ids);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * names.size()));
+}
+BENCHMARK(BM_InternNames)->ArgsProduct({{8, 64, 512}, {FlatTable, UnorderedMapTable, MapTable}});
+
+// The open check-outs by handle, range(0) of them open at once, in the
+// table range(1), a LookupTable: the FlatHashMap or a node based map
+static void BM_HandleTable(benchmark::State& state)
+{
+    size_t openHandles = static_cast<size_t>(state.range(0));
+    const size_t events = 1 << 16;
+    switch (static_cast<LookupTable>(state.range(1)))
+    {
+        case FlatTable:
+            cycleHandles< FlatHashMap<size_t, size_t> >(state, openHandles, events);
+            break;
+        case UnorderedMapTable:
+            cycleHandles< unordered_map<size_t, size_t> >(state, openHandles, events);
+            break;
+        default:
+            cycleHandles< map<size_t, size_t> >(state, openHandles, events);
+            break;
+    }
+}
+BENCHMARK(BM_HandleTable)->ArgsProduct({{64, 4096}, {FlatTable, UnorderedMapTable, MapTable}});
+
+static void BM_ExtractEvents(benchmark::State& state)
+{
+    benchmarkStages(state, EventsOnly, {"tokenize and extract events"});
+}
+BENCHMARK(BM_ExtractEvents)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// Large logs are parsed in chunks on the threads of the pool, with the
+// read-ahead and huge page hints (second argument 1) or without them (0).
+// The hints pay off most on a log not yet in the page cache.
+static void BM_ExtractEventsChunked(benchmark::State& state)
+{
+    ThreadPool pool(static_cast<size_t>(state.range(0)));
+    setMemoryHints(state.range(1) != 0);
+    benchmarkStages(state, EventsOnly, {"map log", "tokenize and extract events"}, &pool);
+    setMemoryHints(true);
+}
+BENCHMARK(BM_ExtractEventsChunked)
+    ->ArgsProduct({{1, max(2u, thread::hardware_concurrency())}, {0, 1}})
+    ->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// The same, reading the log ahead in blocks as on a network share instead
+// of mapping it
+static void BM_ExtractEventsReadAhead(benchmark::State& state)
+{
+    ThreadPool pool(static_cast<size_t>(state.range(0)));
+    setReadAheadMode(AlwaysReadAhead);
+    benchmarkStages(state, EventsOnly, {"tokenize and extract events"}, &pool);
+    setReadAheadMode(AutoReadAhead);
+}
+BENCHMARK(BM_ExtractEventsReadAhead)
+    ->Arg(1)->Arg(max(2u, thread::hardware_concurrency()))
+    ->UseManualTime()->Unit(benchmark::kMillisecond);
+
+static void BM_ConcurrentUsage(benchmark::State& state)
+{
+    benchmarkStages(state, FullAnalysis, {"concurrent usage"});
+}
+BENCHMARK(BM_ConcurrentUsage)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// Pairing check-outs with check-ins and summing the session durations
+static void BM_SessionPairing(benchmark::State& state)
+{
+    benchmarkStages(state, FullAnalysis, {"pair sessions", "total durations"});
+}
+BENCHMARK(BM_SessionPairing)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// The concurrency pass and the session pairing with the synthetic log
+// stretched in one dimension, range(0) a LogDimension, to the size range(1),
+// so that the ns/event of each is told apart from those of the others
+static void BM_ConcurrentUsageScaling(benchmark::State& state)
+{
+    benchmarkStages(state, FullAnalysis, {"concurrent usage"}, NULL, stretchedLog(state.range(0), state.range(1)));
+}
+BENCHMARK(BM_ConcurrentUsageScaling)->Apply(scalingCases)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+static void BM_SessionPairingScaling(benchmark::State& state)
+{
+    benchmarkStages(state, FullAnalysis, {"pair sessions", "total durations"}, NULL, stretchedLog(state.range(0), state.range(1)));
+}
+BENCHMARK(BM_SessionPairingScaling)->Apply(scalingCases)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// The heap allocations of a whole analysis, from parsing to the reports,
+// per event of the log
+static void BM_AnalysisAllocations(benchmark::State& state)
+{
+    const string& logPath = syntheticLogPath();
+    uint64_t allocations = 0;
+    uint64_t events = 0;
+    for (auto _ : state)
+    {
+        uint64_t before = allocationCount();
+        LogData logData(logPath, s_workDirectory.string(), NULL, false, false, FullAnalysis);
+        allocations += allocationCount() - before;
+        uint64_t logEvents;
+        stageSeconds(logData, "tokenize and extract events", logEvents);
+        events += logEvents;
+    }
+    state.counters["allocations/event"] = static_cast<double>(allocations) / max<uint64_t>(events, 1);
+    state.SetLabel(logLabel());
+}
+BENCHMARK(BM_AnalysisAllocations)->Unit(benchmark::kMillisecond);
+
+// The sustained peaks the usage pass keeps, with range(0) products changing
+// their usage every minute in turn.  The changes of the first hours fill
+// the windows; after that the windows slide without allocating, which the
+// allocations/change counter checks.
+static void BM_SustainedPeaksAllocations(benchmark::State& state)
+{
+    const size_t products = static_cast<size_t>(state.range(0));
+    const long long warmUpMinutes = 2 * SustainedPeaks::WindowMinutes[SustainedPeaks::Windows - 1];
+    SustainedPeaks peaks;
+    peaks.resize(products);
+    long long minute = 0;
+    auto change = [&peaks, &minute, products]()
+    {
+        peaks.advance(minute * 60);
+        size_t product = static_cast<size_t>(minute) % products;
+        peaks.change(product, static_cast<int32_t>((minute * 7) % 11));
+        ++minute;
+    };
+    while (minute < warmUpMinutes * static_cast<long long>(products))
+    {
+        change();
+    }
+
+    uint64_t before = allocationCount();
+    for (auto _ : state)
+    {
+        change();
+    }
+    uint64_t allocations = allocationCount() - before;
+    state.counters["allocations/change"] = static_cast<double>(allocations) / max<int64_t>(state.iterations(), 1);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SustainedPeaksAllocations)->Arg(8)->Arg(64);
+
+// The timestamp and duration columns of range(0) report rows, a few
+// minutes apart like the events of a busy log, formatted into a string
+static void BM_FormatTimestamps(benchmark::State& state)
+{
+    size_t rows = static_cast<size_t>(state.range(0));
+    const long long start = 1710374400;
+    string text;
+    text.reserve(rows * 48);
+    for (auto _ : state)
+    {
+        text.clear();
+        BufferedWriter out(text);
+        for (size_t row = 0; row < rows; ++row)
+        {
+            long long checkOut = start + static_cast<long long>(row) * 97;
+            out.writeLogDateTime(checkOut);
+            out.write(',');
+            out.writeLogDateTime(checkOut + 5400);
+            out.write(',');
+            out.writeDuration(5400 + static_cast<long long>(row % 600));
+            out.write('\n');
+        }
+        out.flush();
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rows));
+}
+BENCHMARK(BM_FormatTimestamps)->Arg(100000);
+
+// A report of range(0) rows of six columns, compressed as range(1), a
+// compressionFormat.  The bytes are those of the uncompressed text.
+static void BM_Write2DVectorToFile(benchmark::State& state)
+{
+    compressionFormat compression = static_cast<compressionFormat>(state.range(1));
+    vector< vector<string> > data(static_cast<size_t>(state.range(0)));
+    for (size_t row = 0; row < data.size(); ++row)
+    {
+        data[row] = {"product" + to_string(row % 8), "user" + to_string(row % 40), "host" + to_string(row % 21),
+                     "03/14/2024 12:" + to_string(row % 60), to_string(row * 37), "10.0"};
+    }
+    size_t textSize = 0;
+    for (size_t row = 0; row < data.size(); ++row)
+    {
+        for (size_t col = 0; col < data[row].size(); ++col)
+        {
+            textSize += data[row][col].size() + 1;
+        }
+    }
+    string filePath = (s_workDirectory / ("report.csv" + compressionSuffix(compression))).string();
+    for (auto _ : state)
+    {
+        write2DVectorToFile(filePath, data, ",", compression);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * textSize));
+}
+BENCHMARK(BM_Write2DVectorToFile)
+    ->ArgsProduct({{1000, 100000}, {Uncompressed, GzipCompressed, ZstdCompressed}})
+    ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv)
+{
+    parseLogOptions(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    s_workDirectory = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path("lic-benchmarks-%%%%-%%%%");
+    boost::filesystem::create_directories(s_workDirectory);
+    benchmark::AddCustomContext("synthetic log", logLabel() + " seed=" + to_string(s_logOptions.seed));
+
+    try
+    {
+        benchmark::RunSpecifiedBenchmarks();
+    }
+    catch (exception& e)
+    {
+        cerr << e.what() << endl;
+        boost::filesystem::remove_all(s_workDirectory);
+        return 1;
+    }
+    benchmark::Shutdown();
+    boost::filesystem::remove_all(s_workDirectory);
+
+    return 0;
+}
@@ -0,0 +1,399 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SyntheticLog.h"
+#include "BufferedWriter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace boost::posix_time;
+using namespace boost::gregorian;
+
+// Bytes per event line of a typical synthetic log, to spread a log of a
+// given size over its days
+const uint64_t SyntheticEventLength = 76;
+
+// Handles of the licenses checked out before the log starts.  The server
+// hands out the ones below and starts over from 1 when it reaches them, by
+// which time the early sessions are long checked in.
+const unsigned long long PreCheckedOutHandle = 0x100000;
+
+namespace
+{
+    struct OpenSession
+    {
+        size_t product;
+        size_t user;
+        size_t host;
+        unsigned long long handle;
+    };
+
+    // Event lines carry the day without the year; only START and the date
+    // change lines give the year
+    void writeTimestamp(BufferedWriter& out, const ptime& time, bool withYear)
+    {
+        date day = time.date();
+        time_duration clock = time.time_of_day();
+        char text[32];
+        if (withYear)
+        {
+            snprintf(text, sizeof(text), "%02d/%02d/%04d %02d:%02d:%02d",
+                     static_cast<int>(day.month()), static_cast<int>(day.day()), static_cast<int>(day.year()),
+                     static_cast<int>(clock.hours()), static_cast<int>(clock.minutes()), static_cast<int>(clock.seconds()));
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "%02d/%02d %02d:%02d:%02d",
+                     static_cast<int>(day.month()), static_cast<int>(day.day()),
+                     static_cast<int>(clock.hours()), static_cast<int>(clock.minutes()), static_cast<int>(clock.seconds()));
+        }
+        out.write(text);
+    }
+
+    void writeName(BufferedWriter& out, const char* prefix, size_t index)
+    {
+        out.write(prefix);
+        out.writeInteger(static_cast<long long>(index));
+    }
+
+    void writeHandle(BufferedWriter& out, unsigned long long handle)
+    {
+        char text[24];
+        snprintf(text, sizeof(text), "%llx", handle);
+        out.write(text);
+    }
+
+    void writeUserAndHost(BufferedWriter& out, size_t user, size_t host)
+    {
+        writeName(out, " user", user);
+        writeName(out, " host", host);
+        out.write(" \"\" 1 ");
+    }
+
+    // The server writes its products after every START
+    void writeStart(BufferedWriter& out, const ptime& time, size_t products, size_t licenses)
+    {
+        out.write("START licsrv1 ");
+        writeTimestamp(out, time, true);
+        out.write("\r\n");
+        for (size_t product = 0; product < products; ++product)
+        {
+            writeName(out, "PRODUCT product", product);
+            out.write(" 10.0 0 ");
+            out.writeInteger(static_cast<long long>(licenses));
+            out.write(" 0 0 \"hostid\" \"\" \"\" \"\" \"\" 31-dec-2030\r\n");
+        }
+    }
+
+    // Comment lines of the given total size, CRLF included
+    void writePadding(BufferedWriter& out, size_t bytes)
+    {
+        const size_t MaxLineLength = 1024;
+        static const string filler(MaxLineLength, '.');
+        while (bytes >= 4)
+        {
+            size_t length = min(bytes, MaxLineLength);
+            if (bytes - length > 0 && bytes - length < 4)
+            {
+                length = bytes - 4;
+            }
+            out.write("# ");
+            out.write(string_view(filler.data(), length - 4));
+            out.write("\r\n");
+            bytes -= length;
+        }
+    }
+
+    bool parseSize(const string& value, uint64_t& size)
+    {
+        if (value.empty() || ! isdigit(static_cast<unsigned char>(value[0])))
+        {
+            return false;
+        }
+        char* end;
+        size = strtoull(value.c_str(), &end, 10);
+        switch (toupper(static_cast<unsigned char>(*end)))
+        {
+            case '\0':
+                return true;
+            case 'K':
+                size <<= 10;
+                break;
+            case 'M':
+                size <<= 20;
+                break;
+            case 'G':
+                size <<= 30;
+                break;
+            default:
+                return false;
+        }
+        return end[1] == '\0';
+    }
+
+    template <typename Option>
+    bool parseOption(const string& value, Option& option)
+    {
+        uint64_t parsed;
+        if (! parseSize(value, parsed))
+        {
+            return false;
+        }
+        option = static_cast<Option>(parsed);
+        return true;
+    }
+}
+
+SyntheticLogOptions::SyntheticLogOptions()
+    : events(100000),
+      bytes(0),
+      padding(0),
+      users(40),
+      products(8),
+      openHandles(64),
+      shutdowns(0),
+      preCheckedOut(0),
+      startDate("11/15/2023"),
+      days(90),
+      seed(1)
+{
+}
+
+bool parseSyntheticLogOption(const string& argument, const string& prefix, SyntheticLogOptions& options)
+{
+    string flag = "--" + prefix;
+    size_t separator = argument.find('=');
+    if (argument.compare(0, flag.size(), flag) != 0 || separator == string::npos)
+    {
+        return false;
+    }
+    string name = argument.substr(flag.size(), separator - flag.size());
+    string value = argument.substr(separator + 1);
+
+    if (name == "events")
+    {
+        return parseOption(value, options.events);
+    }
+    if (name == "bytes")
+    {
+        return parseOption(value, options.bytes);
+    }
+    if (name == "padding")
+    {
+        return parseOption(value, options.padding);
+    }
+    if (name == "users")
+    {
+        return parseOption(value, options.users);
+    }
+    if (name == "products")
+    {
+        return parseOption(value, options.products);
+    }
+    if (name == "open_handles")
+    {
+        return parseOption(value, options.openHandles);
+    }
+    if (name == "shutdowns")
+    {
+        return parseOption(value, options.shutdowns);
+    }
+    if (name == "pre_checked_out")
+    {
+        return parseOption(value, options.preCheckedOut);
+    }
+    if (name == "days")
+    {
+        return parseOption(value, options.days);
+    }
+    if (name == "seed")
+    {
+        return parseOption(value, options.seed);
+    }
+    if (name == "start_date")
+    {
+        try
+        {
+            from_us_string(value);
+        }
+        catch (exception&)
+        {
+            return false;
+        }
+        options.startDate = value;
+        return true;
+    }
+
+    return false;
+}
+
+string syntheticLogOptionsHelp(const string& prefix)
+{
+    SyntheticLogOptions defaults;
+    string flag = "  --" + prefix;
+    return flag + "events=N           events to write (" + to_string(defaults.events) + ")\n" +
+           flag + "bytes=SIZE         write up to this size instead, e.g. 20G\n" +
+           flag + "padding=SIZE       bytes of comment lines after every event (0)\n" +
+           flag + "users=N            distinct users (" + to_string(defaults.users) + ")\n" +
+           flag + "products=N         distinct products (" + to_string(defaults.products) + ")\n" +
+           flag + "open_handles=N     licenses held at once (" + to_string(defaults.openHandles) + ")\n" +
+           flag + "shutdowns=N        server restarts within the log (" + to_string(defaults.shutdowns) + ")\n" +
+           flag + "pre_checked_out=N  licenses checked out before the log starts (" + to_string(defaults.preCheckedOut) + ")\n" +
+           flag + "start_date=DATE    MM/DD/YYYY of the first event (" + defaults.startDate + ")\n" +
+           flag + "days=N             days the events span (" + to_string(defaults.days) + ")\n" +
+           flag + "seed=N             random seed (" + to_string(defaults.seed) + ")\n";
+}
+
+void writeSyntheticLog(const string& filePath, const SyntheticLogOptions& options)
+{
+    // The raw generator output is used rather than the standard
+    // distributions, whose results differ between standard libraries
+    mt19937 random(options.seed);
+    size_t products = max<size_t>(options.products, 1);
+    size_t users = max<size_t>(options.users, 1);
+    size_t hosts = users / 2 + 1;
+    uint64_t events = options.bytes ? max<uint64_t>(options.bytes / (SyntheticEventLength + options.padding), 1) : options.events;
+
+    // Every product has licenses for its share of the open handles and a
+    // few more, so that check-outs are denied only now and then
+    size_t licenses = (options.openHandles + options.preCheckedOut) / products + 2;
+
+    // The gaps between events average out to the span of the log.  They are
+    // kept in milliseconds, as large logs have many events per second.
+    uint64_t spanMilliseconds = static_cast<uint64_t>(max<size_t>(options.days, 1)) * 86400000;
+    uint64_t maxGap = max<uint64_t>(2 * spanMilliseconds / max<uint64_t>(events, 1), 1);
+    uint64_t shutdownInterval = options.shutdowns ? events / (options.shutdowns + 1) : 0;
+
+    BufferedWriter out(filePath);
+    ptime start(from_us_string(options.startDate), hours(8));
+    uint64_t elapsed = 0;
+    ptime time = start;
+    out.write("RLM Report Log Format 2, version 14.2 BL2, ISV bitplane\r\n\r\n");
+    writeStart(out, time, products, licenses);
+
+    vector<OpenSession> openSessions;
+    openSessions.reserve(options.openHandles + options.preCheckedOut + 1);
+    vector<size_t> inUse(products, 0);
+    for (size_t session = 0; session < options.preCheckedOut; ++session)
+    {
+        OpenSession preCheckedOut = {random() % products, random() % users, random() % hosts,
+                                     PreCheckedOutHandle + session};
+        openSessions.push_back(preCheckedOut);
+        ++inUse[preCheckedOut.product];
+    }
+    unsigned long long nextHandle = 1;
+    date today = time.date();
+
+    for (uint64_t event = 0; options.bytes ? true : event < events; ++event)
+    {
+        if (options.bytes && event % 4096 == 0 && out.position() >= options.bytes)
+        {
+            break;
+        }
+
+        elapsed += random() % (maxGap + 1);
+        time = start + milliseconds(static_cast<long long>(elapsed));
+        if (time.date() != today)
+        {
+            today = time.date();
+            char text[24];
+            snprintf(text, sizeof(text), "%02d/%02d/%04d 00:00\r\n",
+                     static_cast<int>(today.month()), static_cast<int>(today.day()), static_cast<int>(today.year()));
+            out.write(text);
+        }
+
+        // A restarted server has forgotten every license and starts its
+        // handles over
+        if (shutdownInterval && event && event % shutdownInterval == 0 &&
+            event / shutdownInterval <= options.shutdowns)
+        {
+            out.write("SHUTDOWN admin licsrv1 ");
+            writeTimestamp(out, time, false);
+            out.write("\r\n");
+            openSessions.clear();
+            fill(inUse.begin(), inUse.end(), 0);
+            nextHandle = 1;
+            elapsed += 30000;
+            time = start + milliseconds(static_cast<long long>(elapsed));
+            today = time.date();
+            writeStart(out, time, products, licenses);
+            continue;
+        }
+
+        // Below the open handle depth check-outs outnumber check-ins, at it
+        // they alternate
+        unsigned int roll = random() % 100;
+        bool checkOut = openSessions.empty() || (openSessions.size() < options.openHandles && roll < 55);
+        size_t product = random() % products;
+        size_t user = random() % users;
+        size_t host = random() % hosts;
+
+        if (roll < 5 || (checkOut && inUse[product] >= licenses))
+        {
+            writeName(out, "DENY product", product);
+            out.write(" 10.0");
+            writeUserAndHost(out, user, host);
+            out.writeInteger(1 + random() % 5);
+            out.write(" 0 x ");
+        }
+        else if (checkOut)
+        {
+            OpenSession session = {product, user, host, nextHandle};
+            nextHandle = nextHandle % (PreCheckedOutHandle - 1) + 1;
+            openSessions.push_back(session);
+            ++inUse[product];
+            writeName(out, "OUT product", product);
+            out.write(" 10.0 0");
+            writeUserAndHost(out, user, host);
+            out.writeInteger(static_cast<long long>(inUse[product]));
+            out.write(" 0 ");
+            writeHandle(out, session.handle);
+            writeName(out, " 0 100 \"\" \"product", product);
+            out.write("\" \"10.0\" ");
+        }
+        else
+        {
+            size_t index = random() % openSessions.size();
+            OpenSession session = openSessions[index];
+            openSessions[index] = openSessions.back();
+            openSessions.pop_back();
+            --inUse[session.product];
+            writeName(out, "IN 1 product", session.product);
+            out.write(" 10.0");
+            writeUserAndHost(out, session.user, session.host);
+            out.writeInteger(static_cast<long long>(inUse[session.product]));
+            out.write(" 0 ");
+            writeHandle(out, session.handle);
+            out.write(' ');
+        }
+        writeTimestamp(out, time, false);
+        out.write("\r\n");
+        writePadding(out, options.padding);
+    }
+    out.close();
+}
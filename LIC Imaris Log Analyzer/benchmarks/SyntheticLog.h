@@ -0,0 +1,71 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Shape of a synthetic RLM report log.  The events are check-outs, check-ins
+// and a few denials; the open handles are how many licenses are checked out
+// at once in the steady state, so they set the depth of the session pairing.
+//
+// The events are spread over the given days from the start date, so a log
+// that runs past the end of a year has a year rollover.  The server is shut
+// down and started again the given number of times, evenly spaced, and the
+// licenses checked out before the log starts are only ever checked in.  With
+// a size in bytes the log is written up to that size, whatever the events.
+// Padding puts that many bytes of comment lines after every event, which the
+// analysis skips, so that a log of a given size holds fewer events, e.g. a
+// log past 4 GB that an analysis still holds in little memory.
+struct SyntheticLogOptions
+{
+    SyntheticLogOptions();
+
+    size_t events;
+    uint64_t bytes;
+    size_t padding;
+    size_t users;
+    size_t products;
+    size_t openHandles;
+    size_t shutdowns;
+    size_t preCheckedOut;
+    string startDate;   // MM/DD/YYYY
+    size_t days;
+    unsigned int seed;
+};
+
+// Sets the option of a --<prefix><name>=<value> argument, e.g. --log_events=1000
+// for the prefix "log_".  Sizes may end in K, M or G.  Returns false if the
+// argument is no such option.
+bool parseSyntheticLogOption(const string& argument, const string& prefix, SyntheticLogOptions& options);
+
+// Usage lines for the options with that prefix
+string syntheticLogOptionsHelp(const string& prefix);
+
+// Writes a report log of the given shape as the license server does, CRLF
+// line ends included.  The same options always give the same log.  Throws
+// CannotOpenFileException if the file cannot be written.
+void writeSyntheticLog(const string& filePath, const SyntheticLogOptions& options);
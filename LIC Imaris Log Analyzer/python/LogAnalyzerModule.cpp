@@ -0,0 +1,640 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// Python module lic_analyzer over the staged LogData API:
+//
+//   import lic_analyzer
+//   log = lic_analyzer.LogData("server.log")
+//   log.analyze()
+//   events = log.events()          # dict of NumPy columns
+//   sessions = log.sessions()      # structured array, durations in seconds
+//   timeline = log.usage_timeline()
+//   for batch in log.iter_sessions(product=0, start=march, end=april):
+//       ...                        # indices into sessions(), on demand
+//
+// The tables are NumPy arrays over the columns of the engine, not copies.
+// They are read only and keep the log data alive as long as they are used.
+// pyarrow.array() wraps such a column without a copy as well, so
+// pyarrow.table(log.events()) gives an Arrow table of the events.  Ids index
+// the name lists (products, versions, users, hosts); NO_ID marks a field the
+// event does not carry and a session that is still checked out.
+
+#include "LogData.h"
+#include "LogCursors.h"
+#include "DurationHistograms.h"
+#include "EventStore.h"
+#include "LicenseSaturation.h"
+#include "SparseTotals.h"
+#include "StringInterner.h"
+#include "ThreadPool.h"
+#include "UsageHeatmap.h"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+
+PYBIND11_NUMPY_DTYPE_EX(UsageCounters,
+                        floatingInUse, "floating_in_use",
+                        totalInUse, "total_in_use",
+                        floatingLimit, "floating_limit",
+                        reservedInUse, "reserved_in_use",
+                        reservedLimit, "reserved_limit");
+PYBIND11_NUMPY_DTYPE_EX(UsageChange,
+                        product, "product",
+                        counters, "counters");
+PYBIND11_NUMPY_DTYPE_EX(Session,
+                        checkOutRow, "check_out_row",
+                        checkInRow, "check_in_row",
+                        duration, "duration");
+PYBIND11_NUMPY_DTYPE_EX(UsageStep,
+                        time, "time",
+                        eventRow, "event_row",
+                        change, "change");
+
+namespace
+{
+    // The event type column is handed out as its underlying integers
+    static_assert(sizeof(eventType) == sizeof(int32_t), "eventType is not 32 bits wide");
+
+    // A log data with the pool it parses on, which has to outlive it
+    class PythonLogData
+    {
+        public:
+            PythonLogData(const string& inputFilePath, size_t threads)
+                : m_pool(threads == 1 ? nullptr : new ThreadPool(threads)),
+                  m_logData(inputFilePath, m_pool.get())
+            {
+            }
+
+            LogData& logData()
+            {
+                return m_logData;
+            }
+
+        private:
+            unique_ptr<ThreadPool> m_pool;
+            LogData m_logData;
+    };
+
+    LogData& logDataOf(py::object& self)
+    {
+        return self.cast<PythonLogData&>().logData();
+    }
+
+    // Read only NumPy view of a column, which keeps owner alive
+    template <typename T>
+    py::array columnView(const T* data, size_t size, py::object& owner)
+    {
+        py::array_t<T> view(static_cast<py::ssize_t>(size), data, owner);
+        view.attr("setflags")(py::arg("write") = false);
+        return view;
+    }
+
+    template <typename T>
+    py::array columnView(const vector<T>& column, py::object& owner)
+    {
+        return columnView(column.data(), column.size(), owner);
+    }
+
+    py::list names(const StringInterner& interner)
+    {
+        py::list list;
+        for (size_t id = 0; id < interner.size(); ++id)
+        {
+            string_view name = interner.name(id);
+            list.append(py::str(name.data(), name.size()));
+        }
+        return list;
+    }
+
+    // The totals as a list of rows with a total for every product
+    py::list totalsList(const SparseTotals& totals)
+    {
+        py::list rows;
+        vector<long long> values;
+        for (size_t row = 0; row < totals.rows(); ++row)
+        {
+            totals.rowValues(row, values);
+            rows.append(py::cast(values));
+        }
+        return rows;
+    }
+
+    // Python iterator over a cursor that hands out its items in NumPy
+    // arrays of up to batchSize, pulled only when the next one is asked for.
+    // It keeps the log data alive, which must not be parsed or analyzed
+    // again while it is used.
+    template <typename Cursor, typename Item>
+    class CursorBatches
+    {
+        public:
+            CursorBatches(py::object owner, const Cursor& cursor, size_t batchSize)
+                : m_owner(owner), m_cursor(cursor), m_batchSize(max(batchSize, static_cast<size_t>(1)))
+            {
+            }
+
+            py::array next()
+            {
+                if (pullBatch(m_cursor, m_items, m_batchSize) == 0)
+                {
+                    throw py::stop_iteration();
+                }
+                py::array_t<Item> batch(static_cast<py::ssize_t>(m_items.size()));
+                std::copy(m_items.begin(), m_items.end(), batch.mutable_data());
+                return batch;
+            }
+
+        private:
+            py::object m_owner;
+            Cursor m_cursor;
+            size_t m_batchSize;
+            vector<Item> m_items;
+    };
+
+    typedef CursorBatches<SessionCursor, size_t> SessionBatches;
+    typedef CursorBatches<EventCursor, size_t> EventBatches;
+    typedef CursorBatches<UsageCursor, UsageStep> UsageBatches;
+
+    template <typename Batches>
+    void defineBatches(py::module_& module, const char* name, const char* doc)
+    {
+        py::class_<Batches>(module, name, doc)
+            .def("__iter__", [](Batches& batches) -> Batches& { return batches; })
+            .def("__next__", &Batches::next);
+    }
+
+    LogSelection selection(size_t product, size_t user, size_t host, long long start, long long end)
+    {
+        LogSelection logSelection;
+        logSelection.product = product;
+        logSelection.user = user;
+        logSelection.host = host;
+        logSelection.from = start;
+        logSelection.to = end;
+        return logSelection;
+    }
+
+    const size_t DefaultBatchSize = 4096;
+
+    py::array countersArray(const vector<UsageCounters>& counters)
+    {
+        py::array_t<UsageCounters> array(static_cast<py::ssize_t>(counters.size()));
+        std::copy(counters.begin(), counters.end(), array.mutable_data());
+        return array;
+    }
+}
+
+PYBIND11_MODULE(lic_analyzer, module)
+{
+    module.doc() = "LIC Imaris Log Analyzer: analysis of RLM report logs with NumPy results";
+
+    module.attr("NO_ID") = py::int_(NoId);
+
+    py::enum_<eventType>(module, "EventType")
+        .value("OUT", OutEvent)
+        .value("IN", InEvent)
+        .value("DENY", DenyEvent)
+        .value("START", StartEvent)
+        .value("SHUTDOWN", ShutdownEvent)
+        .value("PRODUCT", ProductEvent);
+
+    py::enum_<reportSelection>(module, "Report", py::arithmetic())
+        .value("SUMMARY", SummaryReport)
+        .value("PROCESSED_LOG", ProcessedLogReport)
+        .value("CONCURRENT_USAGE", ConcurrentUsageReport)
+        .value("LICENSE_ACTIVITY", LicenseActivityReport)
+        .value("TOTAL_DURATION_HOSTS", TotalDurationHostsReport)
+        .value("TOTAL_DURATION_USERS", TotalDurationUsersReport)
+        .value("DENIED_REQUESTS", DeniedRequestsReport)
+        .value("SESSION_DURATIONS", SessionDurationsReport)
+        .value("USAGE_HEATMAP", UsageHeatmapReport)
+        .value("LICENSE_SATURATION", LicenseSaturationReport)
+        .value("HOURLY_DENIALS", HourlyDenialsReport)
+        .value("SUSTAINED_PEAKS", SustainedPeaksReport)
+        .value("TOP_USAGE", TopUsageReport)
+        .value("VERSION_USAGE", VersionUsageReport)
+        .value("RESERVED_USAGE", ReservedUsageReport)
+        .value("FORGOTTEN_SESSIONS", ForgottenSessionsReport)
+        .value("DEMAND_PROFILE", DemandProfileReport)
+        .value("DEFAULT", DefaultReports)
+        .value("ALL", AllReports);
+
+    defineBatches<SessionBatches>(module, "SessionBatches",
+        "Iterator over arrays of session indices into LogData.sessions()");
+    defineBatches<EventBatches>(module, "EventBatches",
+        "Iterator over arrays of event rows into the columns of LogData.events()");
+    defineBatches<UsageBatches>(module, "UsageBatches",
+        "Iterator over arrays of (time, event_row, change) timeline changes");
+
+    py::class_<PythonLogData>(module, "LogData",
+        "An RLM report log.  Opening it only checks its format; parse() "
+        "extracts the events and analyze() builds the results of the "
+        "selected reports.")
+        .def(py::init<const string&, size_t>(),
+             py::arg("input_file_path"), py::arg("threads") = 0,
+             "threads is the size of the parser's pool, 0 for one per hardware thread")
+        .def("parse",
+             [](py::object self, bool useEventCache, size_t invalidLineBudget,
+                long long rangeFrom, long long rangeTo,
+                const vector<string>& products, const vector<string>& users, const vector<string>& hosts,
+                bool excludeProducts, bool excludeUsers, bool excludeHosts, long long denialWindow,
+                pair<int, int> offHours, long long longSession)
+             {
+                 EventFilter eventFilter;
+                 eventFilter.products.names = products;
+                 eventFilter.products.exclude = excludeProducts;
+                 eventFilter.users.names = users;
+                 eventFilter.users.exclude = excludeUsers;
+                 eventFilter.hosts.names = hosts;
+                 eventFilter.hosts.exclude = excludeHosts;
+                 eventFilter.denialWindow = denialWindow;
+                 if (offHours.first < 0 || offHours.first > 23 || offHours.second < 0 || offHours.second > 23 || longSession < 0)
+                 {
+                     throw py::value_error("off_hours are two hours of the day, long_session seconds of at least 0");
+                 }
+                 eventFilter.forgotten.offHoursStart = offHours.first;
+                 eventFilter.forgotten.offHoursEnd = offHours.second;
+                 eventFilter.forgotten.longSeconds = longSession;
+                 LogData& logData = logDataOf(self);
+                 py::gil_scoped_release release;
+                 logData.parse(useEventCache, invalidLineBudget, DateRange(rangeFrom, rangeTo), eventFilter);
+             },
+             py::arg("use_event_cache") = false, py::arg("invalid_line_budget") = 0,
+             py::arg("range_from") = LLONG_MIN, py::arg("range_to") = LLONG_MAX,
+             py::arg("products") = vector<string>(), py::arg("users") = vector<string>(),
+             py::arg("hosts") = vector<string>(), py::arg("exclude_products") = false,
+             py::arg("exclude_users") = false, py::arg("exclude_hosts") = false,
+             py::arg("denial_window") = 0,
+             py::arg("off_hours") = make_pair(ForgottenPolicy().offHoursStart, ForgottenPolicy().offHoursEnd),
+             py::arg("long_session") = ForgottenPolicy().longSeconds,
+             "Skips up to invalid_line_budget invalid lines, listed by invalid_lines().  "
+             "Only the events from range_from up to range_to (seconds since the epoch) are kept, "
+             "and only those of the listed products, users and hosts, or with exclude_... of all "
+             "but the listed ones.  An empty list keeps every name.  A denial_window of more than "
+             "0 seconds merges the denials of a user, host, product and reason that come within it "
+             "of each other, see denial_repeats().  off_hours (start and end hour) and long_session "
+             "(seconds, 0 for no limit) tell the sessions forgotten_sessions() flags.")
+        .def("analyze",
+             [](py::object self, unsigned int results)
+             {
+                 LogData& logData = logDataOf(self);
+                 py::gil_scoped_release release;
+                 logData.analyze(results);
+             },
+             py::arg("results") = static_cast<unsigned int>(AllReports),
+             "results is an or of Report values")
+        .def_property_readonly("input_file_path",
+             [](py::object self) { return logDataOf(self).inputFilePath(); })
+        .def_property_readonly("server_name",
+             [](py::object self) { return logDataOf(self).serverName(); })
+        .def_property_readonly("rlm_version",
+             [](py::object self) { return logDataOf(self).rlmVersion(); },
+             "The RLM server version from the log header, e.g. \"14.2 BL2\"")
+        .def_property_readonly("products",
+             [](py::object self) { return names(logDataOf(self).uniqueProducts()); })
+        .def_property_readonly("versions",
+             [](py::object self) { return names(logDataOf(self).uniqueVersions()); })
+        .def_property_readonly("users",
+             [](py::object self) { return names(logDataOf(self).uniqueUsers()); })
+        .def_property_readonly("hosts",
+             [](py::object self) { return names(logDataOf(self).uniqueHosts()); })
+        .def("events",
+             [](py::object self)
+             {
+                 const EventStore& events = logDataOf(self).events();
+                 py::dict columns;
+                 columns["type"] = columnView(reinterpret_cast<const int32_t*>(events.types.data()),
+                                              events.types.size(), self);
+                 columns["timestamp"] = columnView(events.timestamps, self);
+                 columns["product"] = columnView(events.products, self);
+                 columns["version"] = columnView(events.versions, self);
+                 columns["user"] = columnView(events.users, self);
+                 columns["host"] = columnView(events.hosts, self);
+                 columns["count"] = columnView(events.counts, self);
+                 columns["handle"] = columnView(events.handles, self);
+                 columns["reserved"] = columnView(events.reserved, self);
+                 return columns;
+             },
+             "The event columns in the order of the log, timestamps in seconds since the epoch")
+        .def("sessions",
+             [](py::object self) { return columnView(logDataOf(self).sessions(), self); },
+             "The license checkouts: the OUT and IN event rows and the duration in seconds")
+        .def("invalid_lines",
+             [](py::object self)
+             {
+                 py::list lines;
+                 for (const InvalidLine& invalidLine : logDataOf(self).invalidLines())
+                 {
+                     lines.append(py::make_tuple(invalidLine.line,
+                                                 invalidLine.reason == MissingFields ? "missing data" : "invalid date or time"));
+                 }
+                 return lines;
+             },
+             "The (line number, reason) of every line the parse skipped")
+        .def("denial_rows",
+             [](py::object self) { return columnView(logDataOf(self).denialRows(), self); })
+        .def("denial_counters",
+             [](py::object self) { return countersArray(logDataOf(self).denialCounters()); },
+             "The counters of the denied product at every denial, in the order of denial_rows()")
+        .def("denial_repeats",
+             [](py::object self) { return columnView(logDataOf(self).denialRepeats(), self); },
+             "With a denial_window, the requests every denial stands for, in the order of denial_rows()")
+        .def("denial_last_times",
+             [](py::object self) { return columnView(logDataOf(self).denialLastTimes(), self); },
+             "With a denial_window, the time of the last request of every denial")
+        .def("hourly_denials",
+             [](py::object self)
+             {
+                 py::list hours;
+                 for (const auto& hour : logDataOf(self).hourlyDenials())
+                 {
+                     hours.append(py::make_tuple(hour.first.first, hour.first.second,
+                                                 hour.second.denials, hour.second.atLimit));
+                 }
+                 return hours;
+             },
+             "The (hour start, product, denials, denials at the limit) of every hour and product "
+             "with denials, in seconds since the epoch")
+        .def("usage_timeline",
+             [](py::object self)
+             {
+                 LogData& logData = logDataOf(self);
+                 py::dict timeline;
+                 timeline["row"] = columnView(logData.usageRows(), self);
+                 timeline["change_offset"] = columnView(logData.usageChangeOffsets(), self);
+                 timeline["changes"] = columnView(logData.usageChanges(), self);
+                 return timeline;
+             },
+             "The concurrent usage timeline: the event row of every entry, the offset of "
+             "its first change (plus the end of the last) and the changed product counters")
+        .def("usage_at",
+             [](py::object self, long long timestamp)
+             {
+                 vector<UsageCounters> counters;
+                 logDataOf(self).usageAt(timestamp, counters);
+                 return countersArray(counters);
+             },
+             py::arg("timestamp"),
+             "The counters of every product at the time, in seconds since the epoch")
+        .def("peak_usage",
+             [](py::object self, long long start, long long end)
+             {
+                 vector<UsageCounters> maxima;
+                 logDataOf(self).peakUsage(start, end, maxima);
+                 return countersArray(maxima);
+             },
+             py::arg("start"), py::arg("end"),
+             "The largest counters of every product between the times")
+        .def("iter_sessions",
+             [](py::object self, size_t product, size_t user, size_t host, long long start, long long end, size_t batchSize)
+             {
+                 SessionCursor cursor(logDataOf(self), selection(product, user, host, start, end));
+                 return SessionBatches(self, cursor, batchSize);
+             },
+             py::arg("product") = NoId, py::arg("user") = NoId, py::arg("host") = NoId,
+             py::arg("start") = LLONG_MIN, py::arg("end") = LLONG_MAX,
+             py::arg("batch_size") = DefaultBatchSize,
+             "The sessions of the product, user and host (NO_ID for any) that held their license "
+             "between start and end, in batches found as they are asked for: with a product in "
+             "check-out order, without in the order of sessions()")
+        .def("iter_events",
+             [](py::object self, const vector<eventType>& types, size_t product, size_t user, size_t host,
+                long long start, long long end, size_t batchSize)
+             {
+                 unsigned int typeBits = types.empty() ? AllEventTypes : 0;
+                 for (eventType type : types)
+                 {
+                     typeBits |= eventTypeBit(type);
+                 }
+                 EventCursor cursor(logDataOf(self), selection(product, user, host, start, end), typeBits);
+                 return EventBatches(self, cursor, batchSize);
+             },
+             py::arg("types") = vector<eventType>(), py::arg("product") = NoId, py::arg("user") = NoId,
+             py::arg("host") = NoId, py::arg("start") = LLONG_MIN, py::arg("end") = LLONG_MAX,
+             py::arg("batch_size") = DefaultBatchSize,
+             "The rows of the events of the types (all for an empty list), product, user and host "
+             "from start up to end, in batches in the order of the log.  PRODUCT events have no "
+             "time and only come without start and end")
+        .def("iter_usage",
+             [](py::object self, size_t product, long long start, long long end, size_t batchSize)
+             {
+                 UsageCursor cursor(logDataOf(self), selection(product, NoId, NoId, start, end));
+                 return UsageBatches(self, cursor, batchSize);
+             },
+             py::arg("product") = NoId, py::arg("start") = LLONG_MIN, py::arg("end") = LLONG_MAX,
+             py::arg("batch_size") = DefaultBatchSize,
+             "The counter changes of the product (NO_ID for all) on the usage timeline from start "
+             "up to end, in batches")
+        .def("total_duration_users",
+             [](py::object self) { return totalsList(logDataOf(self).totalDurationUsers()); },
+             "Seconds of use by user and product, a copy")
+        .def("total_duration_hosts",
+             [](py::object self) { return totalsList(logDataOf(self).totalDurationHosts()); },
+             "Seconds of use by host and product, a copy")
+        .def("heaviest_users",
+             [](py::object self, size_t count)
+             {
+                 vector<CheckpointEntry> largest;
+                 logDataOf(self).totalDurationUsers().largestRows(count, largest);
+                 py::list users;
+                 for (const CheckpointEntry& entry : largest)
+                 {
+                     users.append(py::make_tuple(entry.product, entry.row, entry.value));
+                 }
+                 return users;
+             },
+             py::arg("count") = static_cast<size_t>(LongestSessions::Count),
+             "The (product, user, seconds) of the count users with the most time on every product, "
+             "most first.  Needs Report.TOP_USAGE or Report.TOTAL_DURATION_USERS")
+        .def("longest_sessions",
+             [](py::object self)
+             {
+                 const LongestSessions& longest = logDataOf(self).longestSessions();
+                 py::list products;
+                 vector<RankedSession> sessions;
+                 for (size_t product = 0; product < longest.products(); ++product)
+                 {
+                     longest.sessions(product, sessions);
+                     py::list ranked;
+                     for (const RankedSession& session : sessions)
+                     {
+                         py::object checkIn = (session.checkIn == LLONG_MIN) ? py::none() : py::object(py::int_(session.checkIn));
+                         ranked.append(py::make_tuple(session.user, session.host, session.checkOut, checkIn, session.duration));
+                     }
+                     products.append(ranked);
+                 }
+                 return products;
+             },
+             "For every product, the (user, host, check-out, check-in, seconds) of its longest "
+             "sessions, longest first; check-in is None for those still checked out.  Needs "
+             "Report.TOP_USAGE")
+        .def("version_usage",
+             [](py::object self)
+             {
+                 vector<VersionTotals> versions;
+                 logDataOf(self).versionUsage().totals(versions);
+                 py::list usage;
+                 for (const VersionTotals& totals : versions)
+                 {
+                     py::object peakTime = (totals.peakTime == LLONG_MIN) ? py::none() : py::object(py::int_(totals.peakTime));
+                     usage.append(py::make_tuple(totals.product, totals.version, totals.peak, peakTime,
+                                                 totals.sessions, totals.seconds));
+                 }
+                 return usage;
+             },
+             "The (product, version, peak check-outs, peak time, sessions, seconds) of every version "
+             "of a product in the log, by product and version id; peak time is None if none was ever "
+             "checked out.  Needs Report.VERSION_USAGE")
+        .def("forgotten_sessions",
+             [](py::object self)
+             {
+                 vector<ForgottenTotals> totals;
+                 logDataOf(self).forgottenSessions().totals(totals);
+                 py::list flagged;
+                 for (const ForgottenTotals& pair : totals)
+                 {
+                     flagged.append(py::make_tuple(pair.user, pair.product, pair.sessions, pair.offHoursSessions,
+                                                   pair.longSessions, pair.openSessions, pair.wastedSeconds));
+                 }
+                 return flagged;
+             },
+             "The (user, product, flagged sessions, those held through the off-hours, those held too "
+             "long, those still checked out, wasted seconds) of every user and product with sessions "
+             "that look forgotten, by user and product id.  Needs Report.FORGOTTEN_SESSIONS")
+        .def("total_duration_products",
+             [](py::object self)
+             {
+                 vector<long long> durations;
+                 logDataOf(self).totalDurationProducts(durations);
+                 return durations;
+             },
+             "Seconds of use by product")
+        .def_property_readonly("total_duration",
+             [](py::object self) { return logDataOf(self).totalDuration(); },
+             "Seconds of use of all products")
+        .def("session_durations",
+             [](py::object self, const vector<double>& percents)
+             {
+                 const DurationHistograms& histograms = logDataOf(self).sessionDurations();
+                 py::list products;
+                 for (size_t product = 0; product < histograms.products(); ++product)
+                 {
+                     py::dict durations;
+                     durations["sessions"] = histograms.sessions(product);
+                     durations["longest"] = histograms.longest(product);
+                     py::dict percentiles;
+                     for (double percent : percents)
+                     {
+                         percentiles[py::float_(percent)] = histograms.percentile(product, percent);
+                     }
+                     durations["percentiles"] = percentiles;
+                     products.append(durations);
+                 }
+                 return products;
+             },
+             py::arg("percents") = vector<double>{ 50.0, 90.0, 99.0 },
+             "By product, the number of closed sessions, the longest in seconds and the "
+             "percentiles of their lengths, within about 3%; needs Report.SESSION_DURATIONS")
+        .def("usage_heatmap",
+             [](py::object self)
+             {
+                 const UsageHeatmap& heatmap = logDataOf(self).usageHeatmap();
+                 const py::ssize_t products = static_cast<py::ssize_t>(heatmap.products());
+                 const py::ssize_t days = UsageHeatmap::Days;
+                 const py::ssize_t hours = UsageHeatmap::Hours;
+                 py::array_t<double> mean({ products, days, hours });
+                 py::array_t<int32_t> peak({ products, days, hours });
+                 py::array_t<long long> observed({ days, hours });
+                 for (size_t cell = 0; cell < UsageHeatmap::Cells; ++cell)
+                 {
+                     observed.mutable_data()[cell] = heatmap.observedSeconds(cell);
+                     for (size_t product = 0; product < heatmap.products(); ++product)
+                     {
+                         mean.mutable_data()[product * UsageHeatmap::Cells + cell] = heatmap.mean(product, cell);
+                         peak.mutable_data()[product * UsageHeatmap::Cells + cell] = heatmap.peak(product, cell);
+                     }
+                 }
+                 py::dict arrays;
+                 arrays["mean"] = mean;
+                 arrays["peak"] = peak;
+                 arrays["observed"] = observed;
+                 return arrays;
+             },
+             "The floating licenses in use by product, weekday (Monday first) and hour: the "
+             "time-weighted mean, the most at once and the seconds observed of every hour; "
+             "needs Report.USAGE_HEATMAP")
+        .def("saturation_intervals",
+             [](py::object self)
+             {
+                 const LicenseSaturation& saturation = logDataOf(self).licenseSaturation();
+                 py::list intervals;
+                 for (const SaturationInterval& interval : saturation.closedIntervals())
+                 {
+                     intervals.append(py::make_tuple(interval.product, interval.start, interval.end));
+                 }
+                 for (size_t product = 0; product < saturation.products(); ++product)
+                 {
+                     if (saturation.openSince(product) != LLONG_MIN)
+                     {
+                         intervals.append(py::make_tuple(product, saturation.openSince(product), py::none()));
+                     }
+                 }
+                 return intervals;
+             },
+             "The (product, start, end) of every time a product had all its floating licenses in "
+             "use, in seconds since the epoch and by their end; end is None for those still at the "
+             "limit, which come last.  Needs Report.LICENSE_SATURATION")
+        .def("sustained_peaks",
+             [](py::object self)
+             {
+                 const LogData& logData = logDataOf(self);
+                 const SustainedPeaks& peaks = logData.sustainedPeaks();
+                 py::list products;
+                 for (size_t product = 0; product < peaks.products(); ++product)
+                 {
+                     py::dict windows;
+                     for (size_t window = 0; window < SustainedPeaks::Windows; ++window)
+                     {
+                         SustainedPeak peak = peaks.peak(product, window, logData.endTime());
+                         py::object heldFrom = (peak.heldFrom == LLONG_MIN) ? py::none() : py::object(py::int_(peak.heldFrom));
+                         py::object averageFrom = (peak.averageFrom == LLONG_MIN) ? py::none() : py::object(py::int_(peak.averageFrom));
+                         windows[py::int_(SustainedPeaks::WindowMinutes[window])] =
+                             py::make_tuple(peak.held, heldFrom, peak.average, averageFrom);
+                     }
+                     products.append(windows);
+                 }
+                 return products;
+             },
+             "For every product, a dict from the window length in minutes to the (held, held from, "
+             "average, average from) peaks: the most floating licenses in use throughout a window and "
+             "the highest time-weighted mean over one, with the start of that window in seconds since "
+             "the epoch, None if no window was observed in full.  Needs Report.SUSTAINED_PEAKS");
+}
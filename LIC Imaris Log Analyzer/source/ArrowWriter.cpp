@@ -0,0 +1,659 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ArrowWriter.h"
+#include "EventStore.h"
+#include "Exceptions.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <boost/filesystem/operations.hpp>
+
+using namespace std;
+
+namespace
+{
+    // Values of the Arrow format's flatbuffer schema (Schema.fbs, Message.fbs)
+    const uint64_t MetadataVersionV5 = 4;
+    const uint64_t HeaderSchema = 1;
+    const uint64_t HeaderDictionaryBatch = 2;
+    const uint64_t HeaderRecordBatch = 3;
+    const uint64_t TypeInt = 2;
+    const uint64_t TypeUtf8 = 5;
+    const uint64_t TypeTimestamp = 10;
+    const uint64_t TimeUnitSecond = 0;
+
+    // Builds a flatbuffer from the back to the front, like the flatbuffers
+    // library: the objects a table refers to are added before the table.
+    // Positions are counted from the end of the buffer, and the bytes are
+    // kept in reverse order until finish().
+    class FlatBufferBuilder
+    {
+        public:
+            FlatBufferBuilder() : m_minAlign(1), m_tableStart(0) {}
+
+            size_t size() const { return m_bytes.size(); }
+
+            void pad(size_t count)
+            {
+                m_bytes.insert(m_bytes.end(), count, 0);
+            }
+
+            // Pads so that the size is a multiple of align once additional
+            // more bytes are added
+            void prep(size_t align, size_t additional)
+            {
+                m_minAlign = max(m_minAlign, align);
+                pad((align - (m_bytes.size() + additional) % align) % align);
+            }
+
+            // Little-endian value, placed in front of the buffer
+            void pushRaw(uint64_t value, size_t bytes)
+            {
+                for (size_t byte = bytes; byte > 0; --byte)
+                {
+                    m_bytes.push_back(static_cast<uint8_t>(value >> (8 * (byte - 1))));
+                }
+            }
+
+            void push(uint64_t value, size_t bytes)
+            {
+                prep(bytes, 0);
+                pushRaw(value, bytes);
+            }
+
+            // Offset to the object at position, which is at a higher address
+            void pushOffset(size_t position)
+            {
+                prep(4, 0);
+                pushRaw(size() + 4 - position, 4);
+            }
+
+            size_t createString(const string& text)
+            {
+                prep(4, text.size() + 1);
+                m_bytes.push_back(0);
+                for (size_t character = text.size(); character > 0; --character)
+                {
+                    m_bytes.push_back(static_cast<uint8_t>(text[character - 1]));
+                }
+                pushRaw(text.size(), 4);
+                return size();
+            }
+
+            // A vector of structs is started, its elements' fields are
+            // pushed with pushRaw from the last element to the first, and
+            // the vector is ended
+            void startVector(size_t elementSize, size_t count, size_t align)
+            {
+                prep(4, elementSize * count);
+                prep(align, elementSize * count);
+            }
+
+            size_t endVector(size_t count)
+            {
+                push(count, 4);
+                return size();
+            }
+
+            size_t createOffsetVector(const vector<size_t>& positions)
+            {
+                startVector(4, positions.size(), 4);
+                for (size_t element = positions.size(); element > 0; --element)
+                {
+                    pushOffset(positions.at(element - 1));
+                }
+                return endVector(positions.size());
+            }
+
+            void startTable()
+            {
+                m_fields.clear();
+                m_tableStart = size();
+            }
+
+            void addField(size_t slot, uint64_t value, size_t bytes)
+            {
+                push(value, bytes);
+                m_fields.push_back(make_pair(slot, size()));
+            }
+
+            void addOffsetField(size_t slot, size_t position)
+            {
+                pushOffset(position);
+                m_fields.push_back(make_pair(slot, size()));
+            }
+
+            // Adds the table's offset to its vtable and the vtable itself,
+            // in front of the table
+            size_t endTable()
+            {
+                push(0, 4);
+                size_t tablePosition = size();
+
+                size_t slots = 0;
+                for (size_t field = 0; field < m_fields.size(); ++field)
+                {
+                    slots = max(slots, m_fields.at(field).first + 1);
+                }
+                vector<size_t> fieldOffsets(slots, 0);
+                for (size_t field = 0; field < m_fields.size(); ++field)
+                {
+                    fieldOffsets.at(m_fields.at(field).first) = tablePosition - m_fields.at(field).second;
+                }
+                for (size_t slot = slots; slot > 0; --slot)
+                {
+                    pushRaw(fieldOffsets.at(slot - 1), 2);
+                }
+                pushRaw(tablePosition - m_tableStart, 2);
+                pushRaw(4 + 2 * slots, 2);
+
+                // The vtable is at the lower address, so the offset is positive
+                patch(tablePosition, size() - tablePosition, 4);
+                return tablePosition;
+            }
+
+            string finish(size_t root)
+            {
+                prep(max(m_minAlign, static_cast<size_t>(8)), 4);
+                pushOffset(root);
+                return string(m_bytes.rbegin(), m_bytes.rend());
+            }
+
+        private:
+            void patch(size_t position, uint64_t value, size_t bytes)
+            {
+                for (size_t byte = 0; byte < bytes; ++byte)
+                {
+                    m_bytes.at(position - 1 - byte) = static_cast<uint8_t>(value >> (8 * byte));
+                }
+            }
+
+            vector<uint8_t> m_bytes;
+            size_t m_minAlign;
+            size_t m_tableStart;
+            vector< pair<size_t, size_t> > m_fields;
+    };
+
+    // A body buffer of a record batch; the offsets are assigned in order and
+    // every buffer is padded to 8 bytes
+    struct BodyBuffer
+    {
+        const void* data;
+        size_t length;
+    };
+
+    struct FieldNode
+    {
+        size_t length;
+        size_t nullCount;
+    };
+
+    // Where a message is in the file, for the footer
+    struct Block
+    {
+        uint64_t offset;
+        uint64_t metaDataLength;
+        uint64_t bodyLength;
+    };
+
+    size_t paddedLength(size_t length)
+    {
+        return (length + 7) / 8 * 8;
+    }
+
+    size_t buildIntType(FlatBufferBuilder& builder, uint64_t bitWidth)
+    {
+        builder.startTable();
+        builder.addField(0, bitWidth, 4);
+        builder.addField(1, 1, 1);
+        return builder.endTable();
+    }
+
+    size_t buildRecordBatch(FlatBufferBuilder& builder,
+                            size_t length,
+                            const vector<FieldNode>& nodes,
+                            const vector<BodyBuffer>& buffers)
+    {
+        builder.startVector(16, nodes.size(), 8);
+        for (size_t node = nodes.size(); node > 0; --node)
+        {
+            builder.pushRaw(nodes.at(node - 1).nullCount, 8);
+            builder.pushRaw(nodes.at(node - 1).length, 8);
+        }
+        size_t nodeVector = builder.endVector(nodes.size());
+
+        vector<size_t> offsets;
+        size_t offset = 0;
+        for (size_t buffer = 0; buffer < buffers.size(); ++buffer)
+        {
+            offsets.push_back(offset);
+            offset += paddedLength(buffers.at(buffer).length);
+        }
+        builder.startVector(16, buffers.size(), 8);
+        for (size_t buffer = buffers.size(); buffer > 0; --buffer)
+        {
+            builder.pushRaw(buffers.at(buffer - 1).length, 8);
+            builder.pushRaw(offsets.at(buffer - 1), 8);
+        }
+        size_t bufferVector = builder.endVector(buffers.size());
+
+        builder.startTable();
+        builder.addField(0, length, 8);
+        builder.addOffsetField(1, nodeVector);
+        builder.addOffsetField(2, bufferVector);
+        return builder.endTable();
+    }
+
+    size_t buildBlocks(FlatBufferBuilder& builder, const vector<Block>& blocks)
+    {
+        builder.startVector(24, blocks.size(), 8);
+        for (size_t block = blocks.size(); block > 0; --block)
+        {
+            builder.pushRaw(blocks.at(block - 1).bodyLength, 8);
+            builder.pad(4);
+            builder.pushRaw(blocks.at(block - 1).metaDataLength, 4);
+            builder.pushRaw(blocks.at(block - 1).offset, 8);
+        }
+        return builder.endVector(blocks.size());
+    }
+
+    string buildMessage(FlatBufferBuilder& builder, uint64_t headerType, size_t header, size_t bodyLength)
+    {
+        builder.startTable();
+        builder.addField(3, bodyLength, 8);
+        builder.addOffsetField(2, header);
+        builder.addField(0, MetadataVersionV5, 2);
+        builder.addField(1, headerType, 1);
+        return builder.finish(builder.endTable());
+    }
+
+    // Appends to the file and keeps track of the position.  Like a report
+    // (see BufferedWriter), the file is written under a temporary name and
+    // renamed once it is closed; one left unclosed is removed.
+    class ArrowFile
+    {
+        public:
+            ArrowFile(const string& filePath)
+                : m_filePath(filePath),
+                  m_temporaryPath(filePath + ".tmp"),
+                  m_file(fopen(m_temporaryPath.c_str(), "wb")),
+                  m_position(0),
+                  m_good(m_file != NULL)
+            {
+                if (m_file == NULL)
+                {
+                    CannotOpenFileException cannotOpenFileException(m_filePath);
+                    throw cannotOpenFileException;
+                }
+            }
+
+            ~ArrowFile()
+            {
+                if (m_file != NULL)
+                {
+                    fclose(m_file);
+                    boost::system::error_code error;
+                    boost::filesystem::remove(m_temporaryPath, error);
+                }
+            }
+
+            uint64_t position() const { return m_position; }
+
+            void write(const void* data, size_t length)
+            {
+                if (length > 0 && fwrite(data, 1, length, m_file) != length)
+                {
+                    m_good = false;
+                }
+                m_position += length;
+            }
+
+            void writePadding(size_t length)
+            {
+                static const char zeros[8] = {0};
+                write(zeros, paddedLength(length) - length);
+            }
+
+            void writeInt32(uint32_t value)
+            {
+                unsigned char bytes[4];
+                for (size_t byte = 0; byte < 4; ++byte)
+                {
+                    bytes[byte] = static_cast<unsigned char>(value >> (8 * byte));
+                }
+                write(bytes, 4);
+            }
+
+            // An encapsulated message: continuation marker, length, the
+            // flatbuffer and the body
+            Block writeMessage(const string& metadata, const vector<BodyBuffer>& body)
+            {
+                Block block;
+                block.offset = m_position;
+                writeInt32(0xFFFFFFFFu);
+                writeInt32(static_cast<uint32_t>(metadata.size()));
+                write(metadata.data(), metadata.size());
+                block.metaDataLength = m_position - block.offset;
+
+                uint64_t bodyStart = m_position;
+                for (size_t buffer = 0; buffer < body.size(); ++buffer)
+                {
+                    write(body.at(buffer).data, body.at(buffer).length);
+                    writePadding(body.at(buffer).length);
+                }
+                block.bodyLength = m_position - bodyStart;
+                return block;
+            }
+
+            void close()
+            {
+                bool good = m_good && fclose(m_file) == 0;
+                m_file = NULL;
+                boost::system::error_code error;
+                if (good)
+                {
+                    boost::filesystem::rename(m_temporaryPath, m_filePath, error);
+                }
+                if (! good || error)
+                {
+                    boost::filesystem::remove(m_temporaryPath, error);
+                    CannotOpenFileException cannotOpenFileException(m_filePath);
+                    throw cannotOpenFileException;
+                }
+            }
+
+        private:
+            string m_filePath;
+            string m_temporaryPath;
+            FILE* m_file;
+            uint64_t m_position;
+            bool m_good;
+    };
+}
+
+ArrowTable::ArrowTable(size_t rows)
+    : m_rows(rows)
+{
+}
+
+void ArrowTable::addColumn(Column& column, const vector<uint8_t>& valid)
+{
+    column.nullCount = 0;
+    if (! valid.empty())
+    {
+        column.validity.assign((m_rows + 7) / 8, 0);
+        for (size_t row = 0; row < m_rows; ++row)
+        {
+            if (valid.at(row))
+            {
+                column.validity[row / 8] |= static_cast<uint8_t>(1 << (row % 8));
+            }
+            else
+            {
+                ++column.nullCount;
+            }
+        }
+        if (column.nullCount == 0)
+        {
+            column.validity.clear();
+        }
+    }
+    m_columns.push_back(column);
+}
+
+template <class T>
+void ArrowTable::addValueColumn(const string& name,
+                                columnType type,
+                                const vector<T>& values,
+                                const vector<uint8_t>& valid)
+{
+    Column column;
+    column.name = name;
+    column.type = type;
+    column.valueWidth = sizeof(T);
+    column.values.resize(values.size() * sizeof(T));
+    if (! values.empty())
+    {
+        memcpy(column.values.data(), values.data(), column.values.size());
+    }
+    addColumn(column, valid);
+}
+
+void ArrowTable::addInt32Column(const string& name, const vector<int32_t>& values, const vector<uint8_t>& valid)
+{
+    addValueColumn(name, Int32Column, values, valid);
+}
+
+void ArrowTable::addInt64Column(const string& name, const vector<int64_t>& values, const vector<uint8_t>& valid)
+{
+    addValueColumn(name, Int64Column, values, valid);
+}
+
+void ArrowTable::addTimestampColumn(const string& name, const vector<int64_t>& values, const vector<uint8_t>& valid)
+{
+    addValueColumn(name, TimestampColumn, values, valid);
+}
+
+void ArrowTable::addDictionaryColumn(const string& name, const vector<size_t>& ids, const StringInterner& dictionary)
+{
+    vector<uint8_t> valid(ids.size(), 1);
+    for (size_t row = 0; row < ids.size(); ++row)
+    {
+        valid[row] = (ids[row] != NoId);
+    }
+
+    if (dictionary.size() <= 0x80)
+    {
+        vector<int8_t> indices(ids.size(), 0);
+        for (size_t row = 0; row < ids.size(); ++row)
+        {
+            indices[row] = valid[row] ? static_cast<int8_t>(ids[row]) : 0;
+        }
+        addValueColumn(name, DictionaryColumn, indices, valid);
+    }
+    else if (dictionary.size() <= 0x8000)
+    {
+        vector<int16_t> indices(ids.size(), 0);
+        for (size_t row = 0; row < ids.size(); ++row)
+        {
+            indices[row] = valid[row] ? static_cast<int16_t>(ids[row]) : 0;
+        }
+        addValueColumn(name, DictionaryColumn, indices, valid);
+    }
+    else
+    {
+        vector<int32_t> indices(ids.size(), 0);
+        for (size_t row = 0; row < ids.size(); ++row)
+        {
+            indices[row] = valid[row] ? static_cast<int32_t>(ids[row]) : 0;
+        }
+        addValueColumn(name, DictionaryColumn, indices, valid);
+    }
+
+    Column& column = m_columns.back();
+    for (size_t id = 0; id < dictionary.size(); ++id)
+    {
+        column.dictionary.push_back(string(dictionary.name(id)));
+    }
+}
+
+// The file is the schema, one dictionary batch per string column, the
+// record batch and the footer that indexes them.  A dictionary's id is the
+// index of its column.
+void ArrowTable::write(const string& filePath) const
+{
+    ArrowFile file(filePath);
+    file.write("ARROW1\0\0", 8);
+
+    // The schema goes into the first message and again into the footer
+    auto buildSchema = [this](FlatBufferBuilder& builder)
+    {
+        vector<size_t> fields;
+        for (size_t column = 0; column < m_columns.size(); ++column)
+        {
+            const Column& data = m_columns.at(column);
+            size_t name = builder.createString(data.name);
+            size_t type;
+            uint64_t typeType;
+            size_t dictionary = 0;
+            if (data.type == DictionaryColumn)
+            {
+                size_t indexType = buildIntType(builder, 8 * data.valueWidth);
+                builder.startTable();
+                builder.addField(0, column, 8);
+                builder.addOffsetField(1, indexType);
+                builder.addField(2, 0, 1);
+                dictionary = builder.endTable();
+
+                builder.startTable();
+                type = builder.endTable();
+                typeType = TypeUtf8;
+            }
+            else if (data.type == TimestampColumn)
+            {
+                builder.startTable();
+                builder.addField(0, TimeUnitSecond, 2);
+                type = builder.endTable();
+                typeType = TypeTimestamp;
+            }
+            else
+            {
+                type = buildIntType(builder, 8 * data.valueWidth);
+                typeType = TypeInt;
+            }
+            size_t children = builder.createOffsetVector(vector<size_t>());
+
+            builder.startTable();
+            builder.addOffsetField(0, name);
+            builder.addOffsetField(3, type);
+            if (data.type == DictionaryColumn)
+            {
+                builder.addOffsetField(4, dictionary);
+            }
+            builder.addOffsetField(5, children);
+            builder.addField(1, 1, 1);
+            builder.addField(2, typeType, 1);
+            fields.push_back(builder.endTable());
+        }
+        size_t fieldVector = builder.createOffsetVector(fields);
+
+        builder.startTable();
+        builder.addOffsetField(1, fieldVector);
+        builder.addField(0, 0, 2);
+        return builder.endTable();
+    };
+
+    {
+        FlatBufferBuilder builder;
+        size_t schema = buildSchema(builder);
+        file.writeMessage(buildMessage(builder, HeaderSchema, schema, 0), vector<BodyBuffer>());
+    }
+
+    // Dictionaries: string columns of validity (none), offsets and the
+    // characters
+    vector<Block> dictionaryBlocks;
+    for (size_t column = 0; column < m_columns.size(); ++column)
+    {
+        const Column& data = m_columns.at(column);
+        if (data.type != DictionaryColumn)
+        {
+            continue;
+        }
+
+        vector<int32_t> offsets(1, 0);
+        string characters;
+        for (size_t name = 0; name < data.dictionary.size(); ++name)
+        {
+            characters += data.dictionary.at(name);
+            offsets.push_back(static_cast<int32_t>(characters.size()));
+        }
+        vector<BodyBuffer> body;
+        BodyBuffer validity = { NULL, 0 };
+        BodyBuffer offsetBuffer = { offsets.data(), offsets.size() * sizeof(int32_t) };
+        BodyBuffer characterBuffer = { characters.data(), characters.size() };
+        body.push_back(validity);
+        body.push_back(offsetBuffer);
+        body.push_back(characterBuffer);
+        FieldNode node = { data.dictionary.size(), 0 };
+
+        size_t bodyLength = 0;
+        for (size_t buffer = 0; buffer < body.size(); ++buffer)
+        {
+            bodyLength += paddedLength(body.at(buffer).length);
+        }
+
+        FlatBufferBuilder builder;
+        size_t recordBatch = buildRecordBatch(builder, data.dictionary.size(), vector<FieldNode>(1, node), body);
+        builder.startTable();
+        builder.addField(0, column, 8);
+        builder.addOffsetField(1, recordBatch);
+        builder.addField(2, 0, 1);
+        size_t dictionaryBatch = builder.endTable();
+        dictionaryBlocks.push_back(file.writeMessage(buildMessage(builder, HeaderDictionaryBatch, dictionaryBatch, bodyLength), body));
+    }
+
+    // The record batch: validity and values of every column
+    vector<FieldNode> nodes;
+    vector<BodyBuffer> body;
+    size_t bodyLength = 0;
+    for (size_t column = 0; column < m_columns.size(); ++column)
+    {
+        const Column& data = m_columns.at(column);
+        FieldNode node = { m_rows, data.nullCount };
+        nodes.push_back(node);
+
+        BodyBuffer validity = { data.validity.data(), data.validity.size() };
+        BodyBuffer values = { data.values.data(), data.values.size() };
+        body.push_back(validity);
+        body.push_back(values);
+        bodyLength += paddedLength(validity.length) + paddedLength(values.length);
+    }
+
+    vector<Block> recordBatchBlocks;
+    {
+        FlatBufferBuilder builder;
+        size_t recordBatch = buildRecordBatch(builder, m_rows, nodes, body);
+        recordBatchBlocks.push_back(file.writeMessage(buildMessage(builder, HeaderRecordBatch, recordBatch, bodyLength), body));
+    }
+
+    // End of the stream, then the footer and its length
+    file.writeInt32(0xFFFFFFFFu);
+    file.writeInt32(0);
+
+    FlatBufferBuilder builder;
+    size_t schema = buildSchema(builder);
+    size_t dictionaries = buildBlocks(builder, dictionaryBlocks);
+    size_t recordBatches = buildBlocks(builder, recordBatchBlocks);
+    builder.startTable();
+    builder.addOffsetField(1, schema);
+    builder.addOffsetField(2, dictionaries);
+    builder.addOffsetField(3, recordBatches);
+    builder.addField(0, MetadataVersionV5, 2);
+    string footer = builder.finish(builder.endTable());
+    file.write(footer.data(), footer.size());
+    file.writeInt32(static_cast<uint32_t>(footer.size()));
+    file.write("ARROW1", 6);
+    file.close();
+}
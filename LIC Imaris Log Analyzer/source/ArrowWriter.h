@@ -0,0 +1,97 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StringInterner.h"
+
+using namespace std;
+
+// A table written in the Arrow IPC file format (Feather V2), which pandas
+// (read_feather), pyarrow, R and Power BI load column by column without
+// any text parsing.  The table is a single record batch of fixed-width
+// integer and timestamp columns and of string columns that are dictionary
+// encoded: the names are stored once and each row holds an index of 8, 16
+// or 32 bits, the narrowest that fits the dictionary.  The values are
+// written as they are in memory, which is the little-endian layout the
+// format declares.
+class ArrowTable
+{
+    public:
+        ArrowTable(size_t rows);
+
+        // valid has one entry per row, 0 for a null value, or is empty if
+        // every value is valid
+        void addInt32Column(const string& name,
+                            const vector<int32_t>& values,
+                            const vector<uint8_t>& valid = vector<uint8_t>());
+        void addInt64Column(const string& name,
+                            const vector<int64_t>& values,
+                            const vector<uint8_t>& valid = vector<uint8_t>());
+
+        // Seconds since the epoch without a time zone, i.e. the local time
+        // of the log
+        void addTimestampColumn(const string& name,
+                                const vector<int64_t>& values,
+                                const vector<uint8_t>& valid = vector<uint8_t>());
+
+        // Ids of the dictionary's names, NoId for a null value
+        void addDictionaryColumn(const string& name,
+                                 const vector<size_t>& ids,
+                                 const StringInterner& dictionary);
+
+        // Throws CannotOpenFileException
+        void write(const string& filePath) const;
+
+    private:
+        enum columnType
+        {
+            Int32Column,
+            Int64Column,
+            TimestampColumn,
+            DictionaryColumn
+        };
+
+        struct Column
+        {
+            string name;
+            columnType type;
+            size_t valueWidth;           // bytes per value (or index)
+            vector<uint8_t> values;
+            vector<uint8_t> validity;    // bitmap, empty without nulls
+            size_t nullCount;
+            vector<string> dictionary;
+        };
+
+        template <class T>
+        void addValueColumn(const string& name,
+                            columnType type,
+                            const vector<T>& values,
+                            const vector<uint8_t>& valid);
+        void addColumn(Column& column, const vector<uint8_t>& valid);
+
+        size_t m_rows;
+        vector<Column> m_columns;
+};
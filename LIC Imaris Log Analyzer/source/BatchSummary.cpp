@@ -0,0 +1,497 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BatchSummary.h"
+#include "BufferedWriter.h"
+#include "Checkpoint.h"
+#include "LogData.h"
+#include "Utilities.h"
+
+using namespace std;
+
+namespace
+{
+    // Adds a log's users x products (or hosts x products) totals to the
+    // batch totals, translating both ids through the shared tables
+    void mergeTotals(const SparseTotals& logTotals,
+                     const StringInterner& logNames,
+                     const StringInterner& logProducts,
+                     StringInterner& batchNames,
+                     StringInterner& batchProducts,
+                     SparseTotals& batchTotals)
+    {
+        vector<size_t> productIds;
+        for (size_t product = 0; product < logProducts.size(); ++product)
+        {
+            productIds.push_back(batchProducts.intern(logProducts.name(product)));
+        }
+        vector<size_t> rowIds;
+        for (size_t row = 0; row < logNames.size(); ++row)
+        {
+            rowIds.push_back(batchNames.intern(logNames.name(row)));
+        }
+
+        vector<CheckpointEntry> totals;
+        vector<CheckpointEntry> logEntries;
+        batchTotals.entries(totals);
+        logTotals.entries(logEntries);
+        for (size_t entry = 0; entry < logEntries.size(); ++entry)
+        {
+            CheckpointEntry total = { rowIds.at(logEntries[entry].row), productIds.at(logEntries[entry].product),
+                                      logEntries[entry].value };
+            totals.push_back(total);
+        }
+        batchTotals.assign(batchNames.size(), batchProducts.size(), totals);
+    }
+
+    // The months of the timestamps one after the other, as year * 12 +
+    // month - 1.  The bounds of the last month are kept, since the
+    // timestamps of a log rarely leave it.
+    class MonthFinder
+    {
+        public:
+            MonthFinder() : m_month(0), m_start(0), m_end(0) {}
+
+            int month(long long timestamp)
+            {
+                if (timestamp < m_start || timestamp >= m_end)
+                {
+                    DateTime dateTime;
+                    epochToDateTime(timestamp, dateTime);
+                    DateTime start = { dateTime.year, dateTime.month, 1, 0, 0, 0 };
+                    DateTime end = { dateTime.year + dateTime.month / 12, dateTime.month % 12 + 1, 1, 0, 0, 0 };
+                    m_month = dateTime.year * 12 + dateTime.month - 1;
+                    m_start = dateTimeToEpoch(start);
+                    m_end = dateTimeToEpoch(end);
+                }
+                return m_month;
+            }
+
+        private:
+            int m_month;
+            long long m_start;
+            long long m_end;
+    };
+}
+
+BatchSummary::BatchSummary(const string& outputDirectory, bool approximate)
+    : m_outputDirectory(outputDirectory),
+      m_approximate(approximate),
+      m_startCount(0),
+      m_shutdownCount(0),
+      m_sessionCount(0),
+      m_denialCount(0)
+{
+    m_outputPaths.push_back(m_outputDirectory + "/LIC_Imaris_Batch_License_Summary.txt");
+    if (m_approximate)
+    {
+        m_outputPaths.push_back(m_outputDirectory + "/LIC_Imaris_Batch_Monthly_Distinct_Users.csv");
+    }
+    else
+    {
+        m_outputPaths.push_back(m_outputDirectory + "/LIC_Imaris_Batch_Total_Duration_Hosts.csv");
+        m_outputPaths.push_back(m_outputDirectory + "/LIC_Imaris_Batch_Total_Duration_Users.csv");
+    }
+}
+
+void BatchSummary::addLog(const LogData& logData)
+{
+    m_inputFilePaths.push_back(logData.inputFilePath());
+    if (! logData.serverName().empty())
+    {
+        m_serverNames.intern(logData.serverName());
+    }
+
+    // Products, users and hosts first, in each log's first-seen order, so
+    // names without any usage are listed too
+    vector<size_t> productIds;
+    for (size_t product = 0; product < logData.uniqueProducts().size(); ++product)
+    {
+        productIds.push_back(m_uniqueProducts.intern(logData.uniqueProducts().name(product)));
+    }
+
+    if (m_approximate)
+    {
+        // The users checking out a product count for the month of the
+        // check-out; every name is hashed once per log
+        vector<uint64_t> userHashes;
+        for (size_t user = 0; user < logData.uniqueUsers().size(); ++user)
+        {
+            userHashes.push_back(DistinctSketch::hashName(logData.uniqueUsers().name(user)));
+            m_distinctUsers.add(userHashes.back());
+        }
+        for (size_t host = 0; host < logData.uniqueHosts().size(); ++host)
+        {
+            m_distinctHosts.addName(logData.uniqueHosts().name(host));
+        }
+
+        const EventStore& events = logData.events();
+        MonthFinder months;
+        for (size_t row = 0; row < events.size(); ++row)
+        {
+            if (events.types[row] == OutEvent)
+            {
+                m_monthlyUsers[make_pair(productIds.at(events.products[row]), months.month(events.timestamps[row]))]
+                    .add(userHashes.at(events.users[row]));
+            }
+        }
+    }
+    else
+    {
+        for (size_t user = 0; user < logData.uniqueUsers().size(); ++user)
+        {
+            m_uniqueUsers.intern(logData.uniqueUsers().name(user));
+        }
+        for (size_t host = 0; host < logData.uniqueHosts().size(); ++host)
+        {
+            m_uniqueHosts.intern(logData.uniqueHosts().name(host));
+        }
+
+        mergeTotals(logData.totalDurationHosts(), logData.uniqueHosts(), logData.uniqueProducts(),
+                    m_uniqueHosts, m_uniqueProducts, m_totalDurationh);
+        mergeTotals(logData.totalDurationUsers(), logData.uniqueUsers(), logData.uniqueProducts(),
+                    m_uniqueUsers, m_uniqueProducts, m_totalDurationu);
+    }
+
+    m_startCount += logData.startCount();
+    m_shutdownCount += logData.shutdownCount();
+    m_sessionCount += logData.sessionCount();
+    m_denialCount += logData.denialCount();
+}
+
+// Merges the partial summary of other logs, e.g. one built by a batch task
+void BatchSummary::addSummary(const BatchSummary& other)
+{
+    m_inputFilePaths.insert(m_inputFilePaths.end(), other.m_inputFilePaths.begin(), other.m_inputFilePaths.end());
+    for (size_t server = 0; server < other.m_serverNames.size(); ++server)
+    {
+        m_serverNames.intern(other.m_serverNames.name(server));
+    }
+
+    for (size_t product = 0; product < other.m_uniqueProducts.size(); ++product)
+    {
+        m_uniqueProducts.intern(other.m_uniqueProducts.name(product));
+    }
+
+    if (m_approximate)
+    {
+        m_distinctUsers.merge(other.m_distinctUsers);
+        m_distinctHosts.merge(other.m_distinctHosts);
+        for (map<pair<size_t, int>, DistinctSketch>::const_iterator month = other.m_monthlyUsers.begin();
+             month != other.m_monthlyUsers.end(); ++month)
+        {
+            size_t product = m_uniqueProducts.intern(other.m_uniqueProducts.name(month->first.first));
+            m_monthlyUsers[make_pair(product, month->first.second)].merge(month->second);
+        }
+    }
+    else
+    {
+        for (size_t user = 0; user < other.m_uniqueUsers.size(); ++user)
+        {
+            m_uniqueUsers.intern(other.m_uniqueUsers.name(user));
+        }
+        for (size_t host = 0; host < other.m_uniqueHosts.size(); ++host)
+        {
+            m_uniqueHosts.intern(other.m_uniqueHosts.name(host));
+        }
+
+        mergeTotals(other.m_totalDurationh, other.m_uniqueHosts, other.m_uniqueProducts,
+                    m_uniqueHosts, m_uniqueProducts, m_totalDurationh);
+        mergeTotals(other.m_totalDurationu, other.m_uniqueUsers, other.m_uniqueProducts,
+                    m_uniqueUsers, m_uniqueProducts, m_totalDurationu);
+    }
+
+    m_startCount += other.m_startCount;
+    m_shutdownCount += other.m_shutdownCount;
+    m_sessionCount += other.m_sessionCount;
+    m_denialCount += other.m_denialCount;
+}
+
+size_t BatchSummary::logCount() const
+{
+    return m_inputFilePaths.size();
+}
+
+void BatchSummary::savePartial(const string& filePath) const
+{
+    PartialSummary partial;
+    partial.approximate = m_approximate;
+    partial.inputFilePaths = m_inputFilePaths;
+
+    const StringInterner* tables[] = { &m_serverNames, &m_uniqueProducts, &m_uniqueUsers, &m_uniqueHosts };
+    vector<string>* names[] = { &partial.servers, &partial.products, &partial.users, &partial.hosts };
+    for (size_t table = 0; table < 4; ++table)
+    {
+        for (size_t name = 0; name < tables[table]->size(); ++name)
+        {
+            names[table]->push_back(string(tables[table]->name(name)));
+        }
+    }
+    m_totalDurationh.entries(partial.hostDurations);
+    m_totalDurationu.entries(partial.userDurations);
+    partial.starts = m_startCount;
+    partial.shutdowns = m_shutdownCount;
+    partial.sessions = m_sessionCount;
+    partial.denials = m_denialCount;
+
+    if (m_approximate)
+    {
+        m_distinctUsers.save(partial.sketches);
+        m_distinctHosts.save(partial.sketches);
+        for (map<pair<size_t, int>, DistinctSketch>::const_iterator month = m_monthlyUsers.begin();
+             month != m_monthlyUsers.end(); ++month)
+        {
+            partial.monthlyProducts.push_back(month->first.first);
+            partial.monthlyMonths.push_back(month->first.second);
+            month->second.save(partial.sketches);
+        }
+    }
+
+    partial.save(filePath);
+}
+
+// Rebuilds the saved summary as a partial summary of its own and adds that,
+// so a saved summary merges exactly like one built in this run
+bool BatchSummary::addPartial(const string& filePath)
+{
+    PartialSummary partial;
+    if (! partial.load(filePath) || partial.approximate != m_approximate)
+    {
+        return false;
+    }
+
+    BatchSummary other(m_outputDirectory, m_approximate);
+    other.m_inputFilePaths = partial.inputFilePaths;
+    StringInterner* tables[] = { &other.m_serverNames, &other.m_uniqueProducts, &other.m_uniqueUsers, &other.m_uniqueHosts };
+    const vector<string>* names[] = { &partial.servers, &partial.products, &partial.users, &partial.hosts };
+    for (size_t table = 0; table < 4; ++table)
+    {
+        for (size_t name = 0; name < names[table]->size(); ++name)
+        {
+            if (tables[table]->intern(names[table]->at(name)) != name)
+            {
+                return false;
+            }
+        }
+    }
+
+    const vector<CheckpointEntry>* entries[] = { &partial.hostDurations, &partial.userDurations };
+    size_t rowCounts[] = { partial.hosts.size(), partial.users.size() };
+    for (size_t table = 0; table < 2; ++table)
+    {
+        for (size_t entry = 0; entry < entries[table]->size(); ++entry)
+        {
+            if (entries[table]->at(entry).row >= rowCounts[table] || entries[table]->at(entry).product >= partial.products.size())
+            {
+                return false;
+            }
+        }
+    }
+    other.m_totalDurationh.assign(partial.hosts.size(), partial.products.size(), partial.hostDurations);
+    other.m_totalDurationu.assign(partial.users.size(), partial.products.size(), partial.userDurations);
+    other.m_startCount = static_cast<size_t>(partial.starts);
+    other.m_shutdownCount = static_cast<size_t>(partial.shutdowns);
+    other.m_sessionCount = static_cast<size_t>(partial.sessions);
+    other.m_denialCount = static_cast<size_t>(partial.denials);
+
+    if (m_approximate)
+    {
+        size_t sketches = 2 + partial.monthlyProducts.size();
+        if (partial.sketches.size() != sketches * DistinctSketch::Registers)
+        {
+            return false;
+        }
+        string_view registers(partial.sketches);
+        if (! other.m_distinctUsers.restore(registers.substr(0, DistinctSketch::Registers)) ||
+            ! other.m_distinctHosts.restore(registers.substr(DistinctSketch::Registers, DistinctSketch::Registers)))
+        {
+            return false;
+        }
+        for (size_t month = 0; month < partial.monthlyProducts.size(); ++month)
+        {
+            if (partial.monthlyProducts.at(month) >= partial.products.size() ||
+                ! other.m_monthlyUsers[make_pair(static_cast<size_t>(partial.monthlyProducts.at(month)),
+                                                 static_cast<int>(partial.monthlyMonths.at(month)))]
+                      .restore(registers.substr((2 + month) * DistinctSketch::Registers, DistinctSketch::Registers)))
+            {
+                return false;
+            }
+        }
+    }
+    else if (! partial.sketches.empty() || ! partial.monthlyProducts.empty())
+    {
+        return false;
+    }
+
+    addSummary(other);
+    return true;
+}
+
+void BatchSummary::checkForExistingFiles(string& conflictedFileList)
+{
+    for (size_t file = 0; file < m_outputPaths.size(); ++file)
+    {
+        if (fileExists(m_outputPaths.at(file)))
+        {
+            conflictedFileList.append(m_outputPaths.at(file));
+            conflictedFileList.append("\n");
+        }
+    }
+}
+
+void BatchSummary::publishResults()
+{
+    writeSummaryData(m_outputPaths.at(0));
+    if (m_approximate)
+    {
+        writeMonthlyUsers(m_outputPaths.at(1));
+    }
+    else
+    {
+        writeTotalDurations(m_outputPaths.at(1), "Host", m_uniqueHosts, m_totalDurationh);
+        writeTotalDurations(m_outputPaths.at(2), "User", m_uniqueUsers, m_totalDurationu);
+    }
+}
+
+void BatchSummary::writeSummaryData(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath);
+
+    out.write("Batch Log Data Summary For: (");
+    out.writeInteger(m_inputFilePaths.size());
+    out.write(" Logs)\n");
+    for (size_t file = 0; file < m_inputFilePaths.size(); ++file)
+    {
+        out.write(m_inputFilePaths.at(file));
+        out.write('\n');
+    }
+    out.write('\n');
+
+    out.write("Server Name(s):\n");
+    for (size_t server = 0; server < m_serverNames.size(); ++server)
+    {
+        out.write(m_serverNames.name(server));
+        out.write('\n');
+    }
+    out.write('\n');
+
+    out.write("Server Start(s): ");
+    out.writeInteger(m_startCount);
+    out.write("\nServer Shutdown(s): ");
+    out.writeInteger(m_shutdownCount);
+    out.write("\nLicense Checkout(s): ");
+    out.writeInteger(m_sessionCount);
+    out.write("\nDenied License Request(s): ");
+    out.writeInteger(m_denialCount);
+    out.write("\n\n");
+
+    const StringInterner* lists[] = { &m_uniqueProducts, &m_uniqueUsers, &m_uniqueHosts };
+    const DistinctSketch* sketches[] = { NULL, &m_distinctUsers, &m_distinctHosts };
+    const char* titles[] = { "Product(s): (", "Users(s): (", "Host(s): (" };
+    for (size_t list = 0; list < 3; ++list)
+    {
+        out.write(titles[list]);
+        if (m_approximate && sketches[list] != NULL)
+        {
+            out.write('~');
+            out.writeInteger(sketches[list]->estimate());
+            out.write(" Estimated)\n\n");
+            continue;
+        }
+        out.writeInteger(lists[list]->size());
+        out.write(" Total)\n");
+        for (size_t row = 0; row < lists[list]->size(); ++row)
+        {
+            out.write(lists[list]->name(row));
+            out.write('\n');
+        }
+        out.write('\n');
+    }
+    out.close();
+}
+
+void BatchSummary::writeTotalDurations(const string& outputFilePath,
+                                       const string& label,
+                                       const StringInterner& names,
+                                       const SparseTotals& totals)
+{
+    BufferedWriter out(outputFilePath);
+
+    out.write(label);
+    out.write(',');
+    size_t columnSize = m_uniqueProducts.size();
+    for (size_t col = 0; col < columnSize; ++col)
+    {
+        out.write(m_uniqueProducts.name(col));
+        out.write(" Duration (HH:MM:SS)");
+        if (col != columnSize - 1)
+        {
+            out.write(',');
+        }
+    }
+    out.write('\n');
+
+    vector<long long> rowDurations;
+    for (size_t row = 0; row < names.size(); ++row)
+    {
+        out.write(names.name(row));
+        out.write(',');
+        totals.rowValues(row, rowDurations);
+        rowDurations.resize(columnSize, 0);
+        for (size_t col = 0; col < columnSize; ++col)
+        {
+            out.writeDuration(rowDurations[col]);
+            if (col != columnSize - 1)
+            {
+                out.write(',');
+            }
+        }
+        out.write('\n');
+    }
+    out.close();
+}
+
+// One row per product and month with check-outs, the months in order
+void BatchSummary::writeMonthlyUsers(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath);
+
+    out.write("Product,Month,Distinct Users (Estimated)\n");
+    for (map<pair<size_t, int>, DistinctSketch>::const_iterator month = m_monthlyUsers.begin();
+         month != m_monthlyUsers.end(); ++month)
+    {
+        int monthOfYear = month->first.second % 12 + 1;
+        out.write(m_uniqueProducts.name(month->first.first));
+        out.write(',');
+        if (monthOfYear < 10)
+        {
+            out.write('0');
+        }
+        out.writeInteger(monthOfYear);
+        out.write('/');
+        out.writeInteger(month->first.second / 12);
+        out.write(',');
+        out.writeInteger(month->second.estimate());
+        out.write('\n');
+    }
+    out.close();
+}
@@ -0,0 +1,100 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DistinctSketch.h"
+#include "SparseTotals.h"
+#include "StringInterner.h"
+
+using namespace std;
+
+class LogData;
+
+// Combined results of the logs analyzed in one batch run.  Products, users
+// and hosts are interned into tables shared by all logs, so the combined
+// reports have one column or row per name across the whole batch.  Logs
+// analyzed in parallel each fill a partial summary; adding those in input
+// order gives the same reports as adding the logs one after the other.
+//
+// An approximate summary, for archives of many years, keeps no user or host
+// names: it counts them with HyperLogLog sketches, overall and per product
+// and month, in fixed memory per product and month.  It writes the summary
+// with the estimated counts and the distinct users of every product per
+// month instead of the total duration tables.
+//
+// A summary saved as a partial summary file merges like a partial summary
+// of another thread, so archives can be summarized on several machines and
+// reduced into one in any grouping: adding summaries is associative.
+class BatchSummary
+{
+    public:
+        BatchSummary(const string& outputDirectory, bool approximate = false);
+        BatchSummary(const BatchSummary&) = delete;
+        BatchSummary& operator=(const BatchSummary&) = delete;
+
+        void addLog(const LogData& logData);
+        void addSummary(const BatchSummary& other);
+        size_t logCount() const;
+
+        // Writes the summary to a partial summary file (see PartialSummary),
+        // and adds one written by another run.  addPartial returns false if
+        // the file is not a partial summary, or not of the same kind (exact
+        // or approximate).  savePartial throws CannotOpenFileException.
+        void savePartial(const string& filePath) const;
+        bool addPartial(const string& filePath);
+
+        void checkForExistingFiles(string& conflictedFiles);
+        void publishResults();
+
+    private:
+        void writeSummaryData(const string& outputFilePath);
+        void writeTotalDurations(const string& outputFilePath,
+                                 const string& label,
+                                 const StringInterner& names,
+                                 const SparseTotals& totals);
+        void writeMonthlyUsers(const string& outputFilePath);
+
+        string m_outputDirectory;
+        bool m_approximate;
+        vector<string> m_outputPaths;
+        vector<string> m_inputFilePaths;
+        StringInterner m_serverNames;
+        StringInterner m_uniqueProducts;
+        StringInterner m_uniqueUsers;
+        StringInterner m_uniqueHosts;
+        SparseTotals m_totalDurationh;
+        SparseTotals m_totalDurationu;
+        size_t m_startCount;
+        size_t m_shutdownCount;
+        size_t m_sessionCount;
+        size_t m_denialCount;
+        // Approximate summaries only.  The monthly sketches are keyed by
+        // product id and year * 12 + month - 1.
+        DistinctSketch m_distinctUsers;
+        DistinctSketch m_distinctHosts;
+        map<pair<size_t, int>, DistinctSketch> m_monthlyUsers;
+};
@@ -0,0 +1,294 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockReader.h"
+#include "Exceptions.h"
+#include "TraceRecorder.h"
+
+#include <atomic>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+
+namespace
+{
+    atomic<int> s_readAheadMode(AutoReadAhead);
+
+    // Sequential reads of an uncompressed log, past the C library buffers
+    class RawFile
+    {
+    public:
+        RawFile(const string& filePath)
+        {
+#ifdef _WIN32
+            m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            bool opened = (m_file != INVALID_HANDLE_VALUE);
+#else
+            m_file = ::open(filePath.c_str(), O_RDONLY);
+            bool opened = (m_file >= 0);
+#ifdef POSIX_FADV_SEQUENTIAL
+            if (opened)
+            {
+                posix_fadvise(m_file, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+#endif
+#endif
+            if (! opened)
+            {
+                CannotOpenFileException cannotOpenFileException(filePath);
+                throw cannotOpenFileException;
+            }
+            m_filePath = filePath;
+            m_offset = 0;
+        }
+
+        ~RawFile()
+        {
+#ifdef _WIN32
+            CloseHandle(m_file);
+#else
+            ::close(m_file);
+#endif
+        }
+
+        // Reads up to size bytes, fewer only at the end of the file
+        size_t read(char* data, size_t size)
+        {
+            size_t length = 0;
+            while (length < size)
+            {
+#ifdef _WIN32
+                size_t request = size - length;
+                if (request > (1u << 30))
+                {
+                    request = 1u << 30;
+                }
+                DWORD count = 0;
+                if (! ReadFile(m_file, data + length, static_cast<DWORD>(request), &count, NULL))
+                {
+                    CannotOpenFileException cannotOpenFileException(m_filePath);
+                    throw cannotOpenFileException;
+                }
+#else
+                ssize_t count = pread(m_file, data + length, size - length, static_cast<off_t>(m_offset));
+                if (count < 0)
+                {
+                    CannotOpenFileException cannotOpenFileException(m_filePath);
+                    throw cannotOpenFileException;
+                }
+#endif
+                if (count == 0)
+                {
+                    break;
+                }
+                length += static_cast<size_t>(count);
+                m_offset += static_cast<uint64_t>(count);
+            }
+            return length;
+        }
+
+    private:
+        RawFile(const RawFile&);
+        RawFile& operator=(const RawFile&);
+
+        string m_filePath;
+        uint64_t m_offset;
+#ifdef _WIN32
+        HANDLE m_file;
+#else
+        int m_file;
+#endif
+    };
+}
+
+void setReadAheadMode(readAheadMode mode)
+{
+    s_readAheadMode = mode;
+}
+
+readAheadMode currentReadAheadMode()
+{
+    return static_cast<readAheadMode>(s_readAheadMode.load());
+}
+
+bool isOnNetworkShare(const string& filePath)
+{
+#ifdef _WIN32
+    if (filePath.compare(0, 2, "\\\\") == 0 || filePath.compare(0, 2, "//") == 0)
+    {
+        return true;
+    }
+    char volume[MAX_PATH];
+    if (! GetVolumePathNameA(filePath.c_str(), volume, MAX_PATH))
+    {
+        return false;
+    }
+    return GetDriveTypeA(volume) == DRIVE_REMOTE;
+#elif defined(__linux__)
+    const long nfsMagic = 0x6969;
+    const long smbMagic = 0x517B;
+    const long cifsMagic = 0xFF534D42;
+    const long smb2Magic = 0xFE534D42;
+
+    struct statfs fileSystem;
+    if (statfs(filePath.c_str(), &fileSystem) != 0)
+    {
+        return false;
+    }
+    long type = static_cast<long>(fileSystem.f_type);
+    return type == nfsMagic || type == smbMagic || type == cifsMagic || type == smb2Magic;
+#else
+    return false;
+#endif
+}
+
+bool useReadAhead(const string& filePath)
+{
+    switch (currentReadAheadMode())
+    {
+        case AlwaysReadAhead:
+            return true;
+        case NeverReadAhead:
+            return false;
+        default:
+            return isOnNetworkShare(filePath);
+    }
+}
+
+BlockReader::BlockReader(const string& filePath, compressionFormat compression, size_t blockSize)
+    : m_blocks(BlocksAhead),
+      m_spareBlocks(BlocksAhead + 1),
+      m_stopped(false)
+{
+    m_filePath = filePath;
+    m_compression = compression;
+    m_blockSize = blockSize;
+    m_thread = thread(&BlockReader::read, this);
+}
+
+// A reader dropped early, e.g. by an invalid line, stops reading
+BlockReader::~BlockReader()
+{
+    m_stopped = true;
+    m_thread.join();
+}
+
+bool BlockReader::nextBlock(string& block)
+{
+    LIC_TRACE_SCOPE("wait for block");
+    string next;
+    if (! m_blocks.pop(next))
+    {
+        if (m_error)
+        {
+            rethrow_exception(m_error);
+        }
+        return false;
+    }
+    block.swap(next);
+
+    // A block the reader has no room for is not recycled
+    m_spareBlocks.tryPush(next);
+    return true;
+}
+
+void BlockReader::read()
+{
+    try
+    {
+        // A compressed log of independent pieces is decompressed on all
+        // the threads, any other one as a stream on this one
+        unique_ptr<RawFile> file;
+        unique_ptr<ParallelDecompressingStream> pieces;
+        unique_ptr<DecompressingStream> stream;
+        if (m_compression == Uncompressed)
+        {
+            file.reset(new RawFile(m_filePath));
+        }
+        else
+        {
+            pieces.reset(new ParallelDecompressingStream(m_filePath, m_compression));
+            if (! pieces->parallel())
+            {
+                pieces.reset();
+                stream.reset(new DecompressingStream(m_filePath, m_compression));
+            }
+        }
+
+        // The bytes after the last line break of a block start the next one
+        string rest;
+        bool atEnd = false;
+        while (! atEnd)
+        {
+            string block;
+            m_spareBlocks.tryPop(block);
+            block.assign(rest);
+
+            size_t start = block.size();
+            block.resize(start + m_blockSize);
+            size_t length;
+            {
+                LIC_TRACE_SCOPE(file ? "read block" : "decompress block");
+                length = file ? file->read(&block[start], m_blockSize) :
+                         pieces ? pieces->read(&block[start], m_blockSize) : stream->read(&block[start], m_blockSize);
+            }
+            block.resize(start + length);
+            atEnd = (length < m_blockSize);
+
+            if (! atEnd)
+            {
+                size_t lastLineBreak = block.rfind('\n');
+                if (lastLineBreak == string::npos)
+                {
+                    rest.swap(block);
+                    continue;
+                }
+                rest.assign(block, lastLineBreak + 1, string::npos);
+                block.resize(lastLineBreak + 1);
+            }
+            if (block.empty())
+            {
+                break;
+            }
+
+            LIC_TRACE_SCOPE("wait for room ahead");
+            if (! m_blocks.push(block, [this]() { return m_stopped.load(); }))
+            {
+                return;
+            }
+        }
+    }
+    catch (...)
+    {
+        m_error = current_exception();
+    }
+    m_blocks.close();
+}
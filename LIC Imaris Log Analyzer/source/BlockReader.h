@@ -0,0 +1,94 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <string>
+#include <thread>
+#include "Compression.h"
+#include "SpscQueue.h"
+
+using namespace std;
+
+// How an uncompressed log is read.  A mapped log is parsed where it lies,
+// but on a network share every page the parser touches first waits for a
+// round trip.  There the log is read ahead instead: large sequential reads
+// on a thread of their own fill the blocks the parser takes next.
+enum readAheadMode
+{
+    AutoReadAhead,     // Read ahead for logs on a network share
+    AlwaysReadAhead,
+    NeverReadAhead
+};
+
+void setReadAheadMode(readAheadMode mode);
+
+readAheadMode currentReadAheadMode();
+
+// Whether the log is on an SMB/CIFS or NFS share (a UNC path or a mapped
+// network drive on Windows)
+bool isOnNetworkShare(const string& filePath);
+
+// Whether the current mode reads the uncompressed log ahead
+bool useReadAhead(const string& filePath);
+
+// Reads a log on a thread of its own, decompressed if it is compressed (on
+// several threads if it is made of independent pieces, see
+// ParallelDecompressingStream), and hands it out in blocks of whole lines, so that parsing a block overlaps
+// reading the next ones.  At most BlocksAhead blocks wait to be taken; a
+// block only ends early at the end of the log and grows to hold a line
+// longer than blockSize.  The blocks taken are recycled for the next reads.
+// The blocks go to the parser, and back for recycling, through lock-free
+// single-producer/single-consumer queues (see SpscQueue).
+class BlockReader
+{
+public:
+    static const size_t BlocksAhead = 2;
+    static const size_t DefaultBlockSize = 4 << 20;
+
+    BlockReader(const string& filePath, compressionFormat compression, size_t blockSize = DefaultBlockSize);
+    ~BlockReader();
+
+    // Swaps the next block into block, whose old text is reused, and
+    // returns false at the end of the log.  Rethrows what the reading failed
+    // with, i.e. CannotOpenFileException or DecompressionException.
+    bool nextBlock(string& block);
+
+private:
+    BlockReader(const BlockReader&);
+    BlockReader& operator=(const BlockReader&);
+
+    void read();
+
+    string m_filePath;
+    compressionFormat m_compression;
+    size_t m_blockSize;
+
+    SpscQueue<string> m_blocks;
+    SpscQueue<string> m_spareBlocks;
+    atomic<bool> m_stopped;
+    // Set before m_blocks is closed
+    exception_ptr m_error;
+    thread m_thread;
+};
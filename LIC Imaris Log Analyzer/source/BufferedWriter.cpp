@@ -0,0 +1,377 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BufferedWriter.h"
+#include "Cancellation.h"
+#include "TraceRecorder.h"
+#include "Exceptions.h"
+#include "Utilities.h"
+#include "ResourceLimits.h"
+#include "WriteBehind.h"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <boost/filesystem.hpp>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace std;
+
+// The smallest buffer of a report file under a memory limit, which every
+// thread may be writing one of at a time (see limitedBufferSize)
+const size_t MinLimitedBufferSize = 64 << 10;
+
+BufferedWriter::BufferedWriter(const string& filePath,
+                               bool append,
+                               compressionFormat compression,
+                               size_t bufferSize)
+    : m_filePath(filePath),
+      m_uncaughtExceptions(uncaught_exceptions()),
+      m_file(NULL),
+      m_text(NULL),
+      m_compressedText(0),
+      m_buffer(max(limitedBufferSize(bufferSize, MinLimitedBufferSize, availableThreads()), MaxFormattedTimeLength)),
+      m_used(0),
+      m_failed(false),
+      m_dateDay(LLONG_MIN),
+      m_isoDate(false),
+      m_dateLength(0)
+{
+    // Text mode, like the ofstream writers this replaces, so the reports
+    // keep the platform's line endings
+    if (m_filePath == StandardOutputPath)
+    {
+        m_file = stdout;
+        if (compression != Uncompressed)
+        {
+#ifdef _WIN32
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            m_compressor.reset(new CompressingOutput(m_file, compression));
+        }
+        return;
+    }
+    boost::system::error_code error;
+    boost::filesystem::file_status status = boost::filesystem::status(m_filePath, error);
+    bool regularFile = ! boost::filesystem::exists(status) || boost::filesystem::is_regular_file(status);
+    if (! append && regularFile)
+    {
+        m_temporaryPath = m_filePath + ".tmp";
+    }
+    const string& openedPath = m_temporaryPath.empty() ? m_filePath : m_temporaryPath;
+
+    // A plain report on a network share is written behind, with several
+    // writes in flight, instead of one synchronous write at a time
+    if (compression == Uncompressed && regularFile && useWriteBehind(openedPath))
+    {
+        m_writeBehind.reset(new WriteBehindOutput(openedPath, append));
+        return;
+    }
+    if (compression != Uncompressed)
+    {
+        m_file = fopen(openedPath.c_str(), append ? "ab" : "wb");
+    }
+    else
+    {
+        m_file = fopen(openedPath.c_str(), append ? "a" : "w");
+    }
+    if (m_file == NULL)
+    {
+        CannotOpenFileException cannotOpenFileException(m_filePath);
+        throw cannotOpenFileException;
+    }
+
+    // All buffering happens in m_buffer
+    setvbuf(m_file, NULL, _IONBF, 0);
+    if (compression != Uncompressed)
+    {
+        m_compressor.reset(new CompressingOutput(m_file, compression));
+    }
+
+    // Appends always go to the end; seeking there first makes position()
+    // report the file length before anything is written
+    if (append)
+    {
+        fseek(m_file, 0, SEEK_END);
+    }
+}
+
+BufferedWriter::BufferedWriter(string& text, size_t bufferSize)
+    : m_uncaughtExceptions(uncaught_exceptions()),
+      m_file(NULL),
+      m_text(&text),
+      m_compressedText(0),
+      m_buffer(bufferSize < MaxFormattedTimeLength ? MaxFormattedTimeLength : bufferSize),
+      m_used(0),
+      m_failed(false),
+      m_dateDay(LLONG_MIN),
+      m_isoDate(false),
+      m_dateLength(0)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    if (m_text != NULL)
+    {
+        flush();
+    }
+    else if (m_file != NULL || m_writeBehind)
+    {
+        // A report left unfinished by an exception is dropped
+        bool unwinding = uncaught_exceptions() > m_uncaughtExceptions;
+        if (! unwinding)
+        {
+            flush();
+        }
+        if (m_compressor)
+        {
+            m_compressor->finish();
+        }
+        if (m_file != stdout)
+        {
+            finishFile(! unwinding && ! m_failed);
+        }
+    }
+}
+
+bool BufferedWriter::finishFile(bool keep)
+{
+    bool closed = m_writeBehind ? m_writeBehind->finish() : (fclose(m_file) == 0);
+    m_writeBehind.reset();
+    m_file = NULL;
+    if (m_temporaryPath.empty())
+    {
+        return closed;
+    }
+
+    boost::system::error_code error;
+    if (keep && closed)
+    {
+        boost::filesystem::rename(m_temporaryPath, m_filePath, error);
+        if (! error)
+        {
+            return true;
+        }
+    }
+    boost::filesystem::remove(m_temporaryPath, error);
+    return false;
+}
+
+char* BufferedWriter::reserve(size_t size)
+{
+    if (m_buffer.size() - m_used < size)
+    {
+        flushFull();
+    }
+    return m_buffer.data() + m_used;
+}
+
+void BufferedWriter::flushFull()
+{
+    if (m_text == NULL)
+    {
+        throwIfCancelled();
+    }
+    flush();
+}
+
+void BufferedWriter::write(string_view text)
+{
+    if (text.size() > m_buffer.size() - m_used)
+    {
+        flushFull();
+        if (text.size() > m_buffer.size() && ! m_compressor && ! m_writeBehind && m_text == NULL)
+        {
+            if (fwrite(text.data(), 1, text.size(), m_file) != text.size())
+            {
+                m_failed = true;
+            }
+            return;
+        }
+    }
+    // A compressed file, or one written behind, takes a long text in
+    // buffers of the usual size
+    while (text.size() > m_buffer.size())
+    {
+        memcpy(m_buffer.data(), text.data(), m_buffer.size());
+        m_used = m_buffer.size();
+        text.remove_prefix(m_buffer.size());
+        flush();
+    }
+    memcpy(m_buffer.data() + m_used, text.data(), text.size());
+    m_used += text.size();
+}
+
+void BufferedWriter::write(char c)
+{
+    *reserve(1) = c;
+    ++m_used;
+}
+
+void BufferedWriter::writeInteger(long long value)
+{
+    char* out = reserve(MaxFormattedTimeLength);
+    m_used = to_chars(out, out + MaxFormattedTimeLength, value).ptr - m_buffer.data();
+}
+
+void BufferedWriter::writeFixed(double value, int precision)
+{
+    // Enough for any value in the reports at the precisions they use
+    const size_t maxFixedLength = 64;
+    char* out = reserve(maxFixedLength);
+    to_chars_result result = to_chars(out, out + maxFixedLength, value, chars_format::fixed, precision);
+    if (result.ec == errc())
+    {
+        m_used = result.ptr - m_buffer.data();
+    }
+}
+
+void BufferedWriter::writeLogDateTime(long long epochSeconds)
+{
+    writeDateTime(epochSeconds, false);
+}
+
+void BufferedWriter::writeIsoDateTime(long long epochSeconds)
+{
+    writeDateTime(epochSeconds, true);
+}
+
+// Rows come mostly in time order, so the date with its separator is
+// formatted once per day and format and copied for the rows after
+void BufferedWriter::writeDateTime(long long epochSeconds, bool iso)
+{
+    long long day = epochSeconds / 86400 - (epochSeconds % 86400 < 0 ? 1 : 0);
+    if (day != m_dateDay || iso != m_isoDate)
+    {
+        char* dateEnd = iso ? appendIsoDate(m_date, epochSeconds) : appendLogDate(m_date, epochSeconds);
+        *dateEnd++ = iso ? 'T' : ' ';
+        m_dateLength = dateEnd - m_date;
+        m_dateDay = day;
+        m_isoDate = iso;
+    }
+
+    char* out = reserve(MaxFormattedTimeLength);
+    memcpy(out, m_date, m_dateLength);
+    m_used = appendTimeOfDay(out + m_dateLength, epochSeconds - day * 86400) - m_buffer.data();
+}
+
+void BufferedWriter::writeDuration(long long durationSeconds)
+{
+    char* out = reserve(MaxFormattedTimeLength);
+    m_used = appendDuration(out, durationSeconds) - m_buffer.data();
+}
+
+void BufferedWriter::flush()
+{
+    if (m_used > 0 && m_text != NULL)
+    {
+        m_text->append(m_buffer.data(), m_used);
+        m_used = 0;
+    }
+    else if (m_used > 0 && m_compressor)
+    {
+        LIC_TRACE_SCOPE("flush report");
+        m_compressedText += m_used;
+        m_compressor->write(m_buffer, m_used);
+        m_used = 0;
+    }
+    else if (m_used > 0 && m_writeBehind)
+    {
+        LIC_TRACE_SCOPE("flush report");
+        m_writeBehind->write(m_buffer, m_used);
+        m_used = 0;
+    }
+    else if (m_used > 0)
+    {
+        LIC_TRACE_SCOPE("flush report");
+        if (fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+        {
+            m_failed = true;
+        }
+        m_used = 0;
+    }
+}
+
+uint64_t BufferedWriter::position()
+{
+    flush();
+    if (m_text != NULL)
+    {
+        return m_text->size();
+    }
+    if (m_compressor)
+    {
+        return m_compressedText;
+    }
+    if (m_writeBehind)
+    {
+        return m_writeBehind->position();
+    }
+#ifdef _MSC_VER
+    long long filePosition = _ftelli64(m_file);
+#else
+    long long filePosition = ftello(m_file);
+#endif
+    if (filePosition < 0)
+    {
+        m_failed = true;
+        return 0;
+    }
+    return static_cast<uint64_t>(filePosition);
+}
+
+void BufferedWriter::close()
+{
+    if (m_text != NULL)
+    {
+        flush();
+    }
+    else if (m_file != NULL || m_writeBehind)
+    {
+        flush();
+        if (m_compressor && ! m_compressor->finish())
+        {
+            m_failed = true;
+        }
+        if (m_file == stdout)
+        {
+            m_failed = (fflush(m_file) != 0) || m_failed;
+            m_file = NULL;
+        }
+        else if (! finishFile(! m_failed))
+        {
+            m_failed = true;
+        }
+    }
+
+    if (m_failed)
+    {
+        CannotOpenFileException cannotOpenFileException(m_filePath);
+        throw cannotOpenFileException;
+    }
+}
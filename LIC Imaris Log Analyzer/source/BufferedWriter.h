@@ -0,0 +1,123 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Compression.h"
+#include "WriteBehind.h"
+#include "Utilities.h"
+
+using namespace std;
+
+// Path that writes to the standard output instead of a file
+const char StandardOutputPath[] = "-";
+
+// Report file writer with a large user-space buffer.  Numbers, timestamps
+// and durations are formatted straight into the buffer (a log date only when
+// the day changes), and every flush is
+// a single write of the whole buffer.  A compressed file is written in
+// binary mode, so its text has '\n' line endings on every platform; each
+// flush hands the buffer to the compression thread (see CompressingOutput).
+// A plain file in a folder on a network share is written behind, with
+// several flushes in flight at once (see WriteBehindOutput).
+//
+// A new file is written as filePath.tmp and only renamed to filePath once
+// it is complete, so that a run that fails, is cancelled or is killed
+// never leaves a half-written report under the report's name, and the
+// report of the last run stays until the new one replaces it.  A writer
+// destroyed by an exception, e.g. the CancelledException of the current
+// cancellation token, which a full buffer polls (see Cancellation.h),
+// removes its temporary file.  Appends, the standard output and a named
+// pipe or device are written in place.
+class BufferedWriter
+{
+    public:
+        // Throws CannotOpenFileException if the file cannot be created, or
+        // opened for appending.  StandardOutputPath writes to the standard
+        // output, which stays open.  Appending to a compressed file adds
+        // another gzip member or zstd frame, which the tools read as one.
+        BufferedWriter(const string& filePath,
+                       bool append = false,
+                       compressionFormat compression = Uncompressed,
+                       size_t bufferSize = 1 << 20);
+
+        // Appends to text instead of a file, e.g. to format a batch of rows
+        // on a thread of its own (see OrderedMerge)
+        explicit BufferedWriter(string& text, size_t bufferSize = 64 << 10);
+        ~BufferedWriter();
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        void write(string_view text);
+        void write(char c);
+        void writeInteger(long long value);
+        void writeFixed(double value, int precision);
+        void writeLogDateTime(long long epochSeconds);
+        void writeIsoDateTime(long long epochSeconds);
+        void writeDuration(long long durationSeconds);
+
+        void flush();
+
+        // Flushes and returns the length of the file so far.  For a
+        // compressed file, it is the length of the text written by this
+        // writer.
+        uint64_t position();
+
+        // Flushes and closes the file and renames it to its name; throws
+        // CannotOpenFileException if any write or the rename failed
+        void close();
+
+    private:
+        // Makes room for at least size more bytes
+        char* reserve(size_t size);
+        // Flushes the full buffer, after a poll for cancellation
+        void flushFull();
+        // Closes the file, and renames it or removes it if it is temporary
+        bool finishFile(bool keep);
+        void writeDateTime(long long epochSeconds, bool iso);
+
+        string m_filePath;
+        string m_temporaryPath;
+        int m_uncaughtExceptions;
+        FILE* m_file;
+        string* m_text;
+        unique_ptr<CompressingOutput> m_compressor;
+        unique_ptr<WriteBehindOutput> m_writeBehind;
+        uint64_t m_compressedText;
+        vector<char> m_buffer;
+        size_t m_used;
+        bool m_failed;
+
+        // The date part of the last time written, with its separator, and
+        // its day and format, as the rows of a report mostly follow each
+        // other within a day
+        long long m_dateDay;
+        bool m_isoDate;
+        char m_date[MaxFormattedTimeLength];
+        size_t m_dateLength;
+};
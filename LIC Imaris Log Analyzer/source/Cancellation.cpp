@@ -0,0 +1,85 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "Cancellation.h"
+
+namespace
+{
+    atomic<CancellationToken*> s_cancellationToken(NULL);
+}
+
+CancellationToken::CancellationToken()
+    : m_cancelled(false),
+      m_stopping(false)
+{
+}
+
+CancellationToken::~CancellationToken()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeUp.notify_one();
+    if (m_timer.joinable())
+    {
+        m_timer.join();
+    }
+}
+
+void CancellationToken::cancel()
+{
+    m_cancelled.store(true, memory_order_relaxed);
+}
+
+void CancellationToken::cancelAfter(chrono::milliseconds timeout)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + timeout;
+    m_timer = thread([this, deadline]()
+    {
+        unique_lock<mutex> lock(m_mutex);
+        if (! m_wakeUp.wait_until(lock, deadline, [this] { return m_stopping; }))
+        {
+            cancel();
+        }
+    });
+}
+
+void setCancellationToken(CancellationToken* token)
+{
+    s_cancellationToken = token;
+}
+
+CancellationToken* currentCancellationToken()
+{
+    return s_cancellationToken;
+}
+
+void throwIfCancelled()
+{
+    CancellationToken* token = s_cancellationToken.load(memory_order_relaxed);
+    if (token != NULL)
+    {
+        token->throwIfCancelled();
+    }
+}
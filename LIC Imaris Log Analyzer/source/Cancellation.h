@@ -0,0 +1,83 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "Exceptions.h"
+
+using namespace std;
+
+// Cancels a run cooperatively.  The stages of the analysis poll the token
+// at their batch boundaries (a chunk of the log, a stretch of events, a
+// buffer of a report) and throw a CancelledException once it is
+// cancelled, which unwinds the run like any other error; the reports being
+// written are discarded (see BufferedWriter).  A time budget cancels the
+// token from a timer thread of its own, so a poll is one relaxed load.
+class CancellationToken
+{
+    public:
+        CancellationToken();
+        ~CancellationToken();
+        CancellationToken(const CancellationToken&) = delete;
+        CancellationToken& operator=(const CancellationToken&) = delete;
+
+        void cancel();
+        // Cancels the token once timeout has passed, unless it is destroyed
+        // before
+        void cancelAfter(chrono::milliseconds timeout);
+
+        bool cancelled() const
+        {
+            return m_cancelled.load(memory_order_relaxed);
+        }
+
+        void throwIfCancelled() const
+        {
+            if (cancelled())
+            {
+                CancelledException cancelledException;
+                throw cancelledException;
+            }
+        }
+
+    private:
+        atomic<bool> m_cancelled;
+        mutex m_mutex;
+        condition_variable m_wakeUp;
+        bool m_stopping;
+        thread m_timer;
+};
+
+// The token the logs analyzed and the reports written from now on poll, or
+// NULL (the default) for none.  The caller keeps it alive until then.
+void setCancellationToken(CancellationToken* token);
+
+CancellationToken* currentCancellationToken();
+
+// Polls the current token, if there is one
+void throwIfCancelled();
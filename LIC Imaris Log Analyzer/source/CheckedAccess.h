@@ -0,0 +1,51 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstddef>
+
+using namespace std;
+
+// The analysis passes index their tables by ids and rows checked once
+// where the events come in: the parser interns the ids itself, and
+// EventStore::validIds vets those of an event cache or a checkpoint.  So
+// the inner loops go through indexed(), which leaves out the bounds check
+// of at() in a release build.  A debug build, or one with
+// LIC_CHECKED_ACCESS defined, keeps the check, and an id that breaks the
+// invariant throws out_of_range there instead of reading past a table.
+#if ! defined(NDEBUG) || defined(LIC_CHECKED_ACCESS)
+#define LIC_CHECKED_INDEXING 1
+#else
+#define LIC_CHECKED_INDEXING 0
+#endif
+
+template <typename Container>
+inline auto indexed(Container& values, size_t index) -> decltype(values[index])
+{
+#if LIC_CHECKED_INDEXING
+    return values.at(index);
+#else
+    return values[index];
+#endif
+}
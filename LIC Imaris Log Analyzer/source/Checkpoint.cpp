@@ -0,0 +1,494 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Checkpoint.h"
+#include "Exceptions.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <boost/filesystem/operations.hpp>
+
+using namespace std;
+
+namespace
+{
+    const char CheckpointMagic[8] = { 'L', 'I', 'C', 'C', 'K', 'P', 'T', 'D' };
+    const char PartialSummaryMagic[8] = { 'L', 'I', 'C', 'P', 'A', 'R', 'T', '1' };
+
+    // Longest name or event list a checkpoint is trusted to hold
+    const uint64_t MaxCheckpointItems = 1ull << 32;
+
+    // Little-endian fixed-width values, so a checkpoint does not depend on
+    // the platform that wrote it
+    class CheckpointFile
+    {
+        public:
+            CheckpointFile(FILE* file) : m_file(file), m_good(file != NULL) {}
+
+            bool good() const { return m_good; }
+
+            void writeValue(uint64_t value)
+            {
+                unsigned char bytes[8];
+                for (size_t byte = 0; byte < 8; ++byte)
+                {
+                    bytes[byte] = static_cast<unsigned char>(value >> (8 * byte));
+                }
+                writeBytes(bytes, 8);
+            }
+
+            void writeString(const string& text)
+            {
+                writeValue(text.size());
+                writeBytes(text.data(), text.size());
+            }
+
+            template <class T>
+            void writeValues(const vector<T>& values)
+            {
+                writeValue(values.size());
+                for (size_t value = 0; value < values.size(); ++value)
+                {
+                    writeValue(static_cast<uint64_t>(values.at(value)));
+                }
+            }
+
+            void writeStrings(const vector<string>& strings)
+            {
+                writeValue(strings.size());
+                for (size_t text = 0; text < strings.size(); ++text)
+                {
+                    writeString(strings.at(text));
+                }
+            }
+
+            void writeEntries(const vector<CheckpointEntry>& entries)
+            {
+                writeValue(entries.size());
+                for (size_t entry = 0; entry < entries.size(); ++entry)
+                {
+                    writeValue(entries.at(entry).row);
+                    writeValue(entries.at(entry).product);
+                    writeValue(static_cast<uint64_t>(entries.at(entry).value));
+                }
+            }
+
+            uint64_t readValue()
+            {
+                unsigned char bytes[8] = {0};
+                readBytes(bytes, 8);
+                uint64_t value = 0;
+                for (size_t byte = 0; byte < 8; ++byte)
+                {
+                    value |= static_cast<uint64_t>(bytes[byte]) << (8 * byte);
+                }
+                return value;
+            }
+
+            uint64_t readCount()
+            {
+                uint64_t count = readValue();
+                if (count > MaxCheckpointItems)
+                {
+                    m_good = false;
+                    return 0;
+                }
+                return count;
+            }
+
+            string readString()
+            {
+                string text(readCount(), '\0');
+                if (! text.empty())
+                {
+                    readBytes(&text[0], text.size());
+                }
+                return text;
+            }
+
+            template <class T>
+            void readValues(vector<T>& values)
+            {
+                values.resize(readCount());
+                for (size_t value = 0; value < values.size() && m_good; ++value)
+                {
+                    values.at(value) = static_cast<T>(readValue());
+                }
+            }
+
+            void readStrings(vector<string>& strings)
+            {
+                strings.resize(readCount());
+                for (size_t text = 0; text < strings.size() && m_good; ++text)
+                {
+                    strings.at(text) = readString();
+                }
+            }
+
+            void readEntries(vector<CheckpointEntry>& entries)
+            {
+                entries.resize(readCount());
+                for (size_t entry = 0; entry < entries.size() && m_good; ++entry)
+                {
+                    entries.at(entry).row = readValue();
+                    entries.at(entry).product = readValue();
+                    entries.at(entry).value = static_cast<int64_t>(readValue());
+                }
+            }
+
+            // Closes the file and renames the temporary file it was written
+            // to onto filePath, or removes it and throws if anything failed
+            void commit(const string& temporaryPath, const string& filePath)
+            {
+                bool good = m_good;
+                if (m_file != NULL && fclose(m_file) != 0)
+                {
+                    good = false;
+                }
+                m_file = NULL;
+
+                boost::system::error_code error;
+                if (good)
+                {
+                    boost::filesystem::rename(temporaryPath, filePath, error);
+                }
+                if (! good || error)
+                {
+                    boost::filesystem::remove(temporaryPath, error);
+                    CannotOpenFileException cannotOpenFileException(filePath);
+                    throw cannotOpenFileException;
+                }
+            }
+
+            void writeBytes(const void* data, size_t size)
+            {
+                if (m_good && size > 0 && fwrite(data, 1, size, m_file) != size)
+                {
+                    m_good = false;
+                }
+            }
+
+            void readBytes(void* data, size_t size)
+            {
+                if (m_good && size > 0 && fread(data, 1, size, m_file) != size)
+                {
+                    m_good = false;
+                }
+            }
+
+        private:
+            FILE* m_file;
+            bool m_good;
+    };
+}
+
+Checkpoint::Checkpoint()
+    : inputOffset(0),
+      inputLines(0),
+      headHash(0),
+      tailHash(0),
+      eventYear(0),
+      endTimeRow(NoId),
+      closedSessions(0),
+      denials(0),
+      heatmapClock(LLONG_MIN),
+      peaksClock(LLONG_MIN),
+      peaksStart(0),
+      firstEventTime(LLONG_MAX)
+{
+}
+
+bool Checkpoint::load(const string& filePath)
+{
+    FILE* input = fopen(filePath.c_str(), "rb");
+    if (input == NULL)
+    {
+        return false;
+    }
+
+    CheckpointFile file(input);
+    char magic[sizeof(CheckpointMagic)];
+    file.readBytes(magic, sizeof(magic));
+    if (! file.good() || memcmp(magic, CheckpointMagic, sizeof(magic)) != 0)
+    {
+        fclose(input);
+        return false;
+    }
+
+    inputOffset = file.readValue();
+    inputLines = file.readValue();
+    headHash = file.readValue();
+    tailHash = file.readValue();
+    eventYear = static_cast<int32_t>(file.readValue());
+    serverName = file.readString();
+
+    file.readStrings(products);
+    file.readStrings(versions);
+    file.readStrings(users);
+    file.readStrings(hosts);
+    file.readStrings(handles);
+    file.readStrings(servers);
+
+    vector<uint64_t> types;
+    file.readValues(types);
+    carriedEvents.clear();
+    for (size_t row = 0; row < types.size() && file.good(); ++row)
+    {
+        carriedEvents.append(static_cast<eventType>(types.at(row)));
+    }
+    file.readValues(carriedEvents.timestamps);
+    file.readValues(carriedEvents.products);
+    file.readValues(carriedEvents.versions);
+    file.readValues(carriedEvents.users);
+    file.readValues(carriedEvents.hosts);
+    file.readValues(carriedEvents.counts);
+    file.readValues(carriedEvents.handles);
+    file.readValues(carriedEvents.reserved);
+    file.readValues(reservedCheckOuts);
+    endTimeRow = file.readValue();
+
+    file.readValues(usageCounters);
+    file.readValues(recordedCounters);
+    file.readEntries(licenseCounts);
+    file.readEntries(reservedCounts);
+    file.readEntries(hostDurations);
+    file.readEntries(userDurations);
+    file.readEntries(reservedUserDurations);
+    file.readEntries(floatingUserDurations);
+    closedSessions = file.readValue();
+    denials = file.readValue();
+    file.readEntries(durationCounts);
+    file.readValues(longestSessions);
+    heatmapClock = static_cast<int64_t>(file.readValue());
+    file.readValues(heatmapObserved);
+    file.readValues(heatmapSeconds);
+    file.readValues(heatmapPeaks);
+    file.readValues(heatmapInUse);
+    file.readValues(saturationStarts);
+    file.readValues(saturationCounts);
+    file.readValues(saturationSeconds);
+    file.readEntries(hourlyDenials);
+    file.readValues(hourlyDenialsAtLimit);
+    peaksClock = static_cast<int64_t>(file.readValue());
+    peaksStart = static_cast<int64_t>(file.readValue());
+    file.readValues(peakResults);
+    file.readValues(peakSegmentCounts);
+    file.readValues(peakSegmentStarts);
+    file.readValues(peakSegmentLevels);
+    file.readValues(peakLevelCounts);
+    file.readValues(peakLevelSince);
+    file.readValues(peakLevels);
+    file.readValues(topSessions);
+    file.readValues(versionUsage);
+    file.readValues(forgottenSessions);
+    file.readValues(demandProfile);
+    file.readStrings(chargebackGroups);
+    file.readEntries(chargebackSeconds);
+    file.readValues(chargebackSessions);
+    file.readValues(chargebackReservedSeconds);
+    file.readValues(eventTypeCounts);
+    firstEventTime = static_cast<int64_t>(file.readValue());
+    file.readValues(productDenials);
+
+    file.readStrings(reportPaths);
+    file.readValues(reportLengths);
+
+    bool good = file.good() && fgetc(input) == EOF;
+    fclose(input);
+
+    // Every column of the carried events has one entry per event
+    size_t events = carriedEvents.types.size();
+    return good &&
+           carriedEvents.timestamps.size() == events && carriedEvents.products.size() == events &&
+           carriedEvents.versions.size() == events && carriedEvents.users.size() == events &&
+           carriedEvents.hosts.size() == events && carriedEvents.counts.size() == events &&
+           carriedEvents.handles.size() == events && carriedEvents.reserved.size() == events &&
+           usageCounters.size() == recordedCounters.size() && reportPaths.size() == reportLengths.size();
+}
+
+void Checkpoint::save(const string& filePath) const
+{
+    string temporaryPath = filePath + ".tmp";
+    FILE* output = fopen(temporaryPath.c_str(), "wb");
+
+    CheckpointFile file(output);
+    file.writeBytes(CheckpointMagic, sizeof(CheckpointMagic));
+    file.writeValue(inputOffset);
+    file.writeValue(inputLines);
+    file.writeValue(headHash);
+    file.writeValue(tailHash);
+    file.writeValue(static_cast<uint64_t>(static_cast<int64_t>(eventYear)));
+    file.writeString(serverName);
+
+    file.writeStrings(products);
+    file.writeStrings(versions);
+    file.writeStrings(users);
+    file.writeStrings(hosts);
+    file.writeStrings(handles);
+    file.writeStrings(servers);
+
+    file.writeValues(carriedEvents.types);
+    file.writeValues(carriedEvents.timestamps);
+    file.writeValues(carriedEvents.products);
+    file.writeValues(carriedEvents.versions);
+    file.writeValues(carriedEvents.users);
+    file.writeValues(carriedEvents.hosts);
+    file.writeValues(carriedEvents.counts);
+    file.writeValues(carriedEvents.handles);
+    file.writeValues(carriedEvents.reserved);
+    file.writeValues(reservedCheckOuts);
+    file.writeValue(endTimeRow);
+
+    file.writeValues(usageCounters);
+    file.writeValues(recordedCounters);
+    file.writeEntries(licenseCounts);
+    file.writeEntries(reservedCounts);
+    file.writeEntries(hostDurations);
+    file.writeEntries(userDurations);
+    file.writeEntries(reservedUserDurations);
+    file.writeEntries(floatingUserDurations);
+    file.writeValue(closedSessions);
+    file.writeValue(denials);
+    file.writeEntries(durationCounts);
+    file.writeValues(longestSessions);
+    file.writeValue(static_cast<uint64_t>(heatmapClock));
+    file.writeValues(heatmapObserved);
+    file.writeValues(heatmapSeconds);
+    file.writeValues(heatmapPeaks);
+    file.writeValues(heatmapInUse);
+    file.writeValues(saturationStarts);
+    file.writeValues(saturationCounts);
+    file.writeValues(saturationSeconds);
+    file.writeEntries(hourlyDenials);
+    file.writeValues(hourlyDenialsAtLimit);
+    file.writeValue(static_cast<uint64_t>(peaksClock));
+    file.writeValue(static_cast<uint64_t>(peaksStart));
+    file.writeValues(peakResults);
+    file.writeValues(peakSegmentCounts);
+    file.writeValues(peakSegmentStarts);
+    file.writeValues(peakSegmentLevels);
+    file.writeValues(peakLevelCounts);
+    file.writeValues(peakLevelSince);
+    file.writeValues(peakLevels);
+    file.writeValues(topSessions);
+    file.writeValues(versionUsage);
+    file.writeValues(forgottenSessions);
+    file.writeValues(demandProfile);
+    file.writeStrings(chargebackGroups);
+    file.writeEntries(chargebackSeconds);
+    file.writeValues(chargebackSessions);
+    file.writeValues(chargebackReservedSeconds);
+    file.writeValues(eventTypeCounts);
+    file.writeValue(static_cast<uint64_t>(firstEventTime));
+    file.writeValues(productDenials);
+
+    file.writeStrings(reportPaths);
+    file.writeValues(reportLengths);
+
+    file.commit(temporaryPath, filePath);
+}
+
+PartialSummary::PartialSummary()
+    : approximate(false),
+      starts(0),
+      shutdowns(0),
+      sessions(0),
+      denials(0)
+{
+}
+
+bool PartialSummary::load(const string& filePath)
+{
+    FILE* input = fopen(filePath.c_str(), "rb");
+    if (input == NULL)
+    {
+        return false;
+    }
+
+    CheckpointFile file(input);
+    char magic[sizeof(PartialSummaryMagic)];
+    file.readBytes(magic, sizeof(magic));
+    if (! file.good() || memcmp(magic, PartialSummaryMagic, sizeof(magic)) != 0)
+    {
+        fclose(input);
+        return false;
+    }
+
+    approximate = (file.readValue() != 0);
+    file.readStrings(inputFilePaths);
+    file.readStrings(servers);
+    file.readStrings(products);
+    file.readStrings(users);
+    file.readStrings(hosts);
+    file.readEntries(hostDurations);
+    file.readEntries(userDurations);
+    starts = file.readValue();
+    shutdowns = file.readValue();
+    sessions = file.readValue();
+    denials = file.readValue();
+    sketches = file.readString();
+    file.readValues(monthlyProducts);
+    file.readValues(monthlyMonths);
+
+    bool good = file.good() && fgetc(input) == EOF;
+    fclose(input);
+
+    return good && monthlyProducts.size() == monthlyMonths.size();
+}
+
+void PartialSummary::save(const string& filePath) const
+{
+    string temporaryPath = filePath + ".tmp";
+    FILE* output = fopen(temporaryPath.c_str(), "wb");
+
+    CheckpointFile file(output);
+    file.writeBytes(PartialSummaryMagic, sizeof(PartialSummaryMagic));
+    file.writeValue(approximate ? 1 : 0);
+    file.writeStrings(inputFilePaths);
+    file.writeStrings(servers);
+    file.writeStrings(products);
+    file.writeStrings(users);
+    file.writeStrings(hosts);
+    file.writeEntries(hostDurations);
+    file.writeEntries(userDurations);
+    file.writeValue(starts);
+    file.writeValue(shutdowns);
+    file.writeValue(sessions);
+    file.writeValue(denials);
+    file.writeString(sketches);
+    file.writeValues(monthlyProducts);
+    file.writeValues(monthlyMonths);
+
+    file.commit(temporaryPath, filePath);
+}
+
+uint64_t checkpointHash(const char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t byte = 0; byte < size; ++byte)
+    {
+        hash ^= static_cast<unsigned char>(data[byte]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
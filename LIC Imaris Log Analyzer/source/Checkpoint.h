@@ -0,0 +1,221 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EventStore.h"
+
+using namespace std;
+
+// A sparse entry of a two-dimensional table, e.g. the seconds a user had a
+// product checked out
+struct CheckpointEntry
+{
+    uint64_t row;
+    uint64_t product;
+    int64_t value;
+};
+
+// State saved next to the reports after an incremental run, so that the
+// next run can resume reading the log at inputOffset instead of starting
+// over.  The head and tail hashes identify the part of the log already
+// read; if they no longer match, the log was rotated or rewritten and the
+// checkpoint is ignored.  See LogData for how the state is used.
+struct Checkpoint
+{
+    Checkpoint();
+
+    // Returns false if the file is missing, unreadable or of another version
+    bool load(const string& filePath);
+
+    // Writes a temporary file and renames it, so an interrupted save leaves
+    // the previous checkpoint in place.  Throws CannotOpenFileException.
+    void save(const string& filePath) const;
+
+    uint64_t inputOffset;
+    uint64_t inputLines;
+    uint64_t headHash;
+    uint64_t tailHash;
+    int32_t eventYear;
+    string serverName;
+
+    // Interned names in id order
+    vector<string> products;
+    vector<string> versions;
+    vector<string> users;
+    vector<string> hosts;
+    vector<string> handles;
+    vector<string> servers;
+
+    // Events later runs still need: the check-outs still open, the server
+    // starts and shutdowns for the summary and the event the open sessions
+    // run until (endTimeRow, NoId if none)
+    EventStore carriedEvents;
+    uint64_t endTimeRow;
+    // The carried check-outs that took a reserved license, in row order
+    vector<uint64_t> reservedCheckOuts;
+
+    // Concurrent usage state, five counters per product, and the licenses
+    // and reserved licenses held by user and product
+    vector<int32_t> usageCounters;
+    vector<int32_t> recordedCounters;
+    vector<CheckpointEntry> licenseCounts;
+    vector<CheckpointEntry> reservedCounts;
+
+    // Durations of the sessions already closed, by host or user and
+    // product, and those by user on reserved and on floating licenses
+    vector<CheckpointEntry> hostDurations;
+    vector<CheckpointEntry> userDurations;
+    vector<CheckpointEntry> reservedUserDurations;
+    vector<CheckpointEntry> floatingUserDurations;
+    uint64_t closedSessions;
+    uint64_t denials;
+
+    // Lengths of the sessions already closed, as the bucket counts and the
+    // longest session of every product (see DurationHistograms)
+    vector<CheckpointEntry> durationCounts;
+    vector<int64_t> longestSessions;
+
+    // Usage heatmap: the clock (LLONG_MIN if not started), the observed
+    // seconds of every cell, the seconds in use and peak of every product
+    // and cell, and the licenses of every product in use at the clock (see
+    // UsageHeatmap)
+    int64_t heatmapClock;
+    vector<int64_t> heatmapObserved;
+    vector<int64_t> heatmapSeconds;
+    vector<int32_t> heatmapPeaks;
+    vector<int32_t> heatmapInUse;
+
+    // License saturation: the start of every product's open interval
+    // (LLONG_MIN if none) and the count and seconds of those closed (see
+    // LicenseSaturation)
+    vector<int64_t> saturationStarts;
+    vector<uint64_t> saturationCounts;
+    vector<int64_t> saturationSeconds;
+
+    // Denials by hour (its start, as the row) and product, and those of
+    // them at the product's limit
+    vector<CheckpointEntry> hourlyDenials;
+    vector<uint64_t> hourlyDenialsAtLimit;
+
+    // Sustained peaks: the clock (LLONG_MIN if not started) and the start
+    // of the observation, then for every product and window length its
+    // held peak and start, best usage integral and start and the changes
+    // not yet measured as a window start, the changes of the last window
+    // and the levels in use (see SustainedPeaks)
+    int64_t peaksClock;
+    int64_t peaksStart;
+    vector<int64_t> peakResults;
+    vector<uint64_t> peakSegmentCounts;
+    vector<int64_t> peakSegmentStarts;
+    vector<int32_t> peakSegmentLevels;
+    vector<uint64_t> peakLevelCounts;
+    vector<int64_t> peakLevelSince;
+    vector<int32_t> peakLevels;
+
+    // The longest closed sessions of every product, as the product, user,
+    // host, check-out and check-in of each (see LongestSessions)
+    vector<int64_t> topSessions;
+
+    // Usage by product and version: the product, version, check-outs in
+    // use, peak and its time, and the closed sessions and their seconds of
+    // every pair seen (see VersionUsage)
+    vector<int64_t> versionUsage;
+
+    // Forgotten sessions: the policy (long seconds, off-hours start and
+    // end), then the user, product, closed flagged sessions, those held
+    // through the off-hours and too long, and their wasted seconds of every
+    // pair (see ForgottenSessions)
+    vector<int64_t> forgottenSessions;
+
+    // Demand profile: the product, hour of the week, closed check-outs,
+    // check-ins, denials, holding time bucket counts and the sum of the
+    // holding times and the bits of that of their squares of every cell
+    // with any (see DemandProfile)
+    vector<int64_t> demandProfile;
+
+    // Chargeback: the groups of the mapping the sessions were billed by,
+    // and the seconds of the closed sessions by group (the one past them
+    // for the unassigned) and product, with their session counts and
+    // reserved seconds
+    vector<string> chargebackGroups;
+    vector<CheckpointEntry> chargebackSeconds;
+    vector<uint64_t> chargebackSessions;
+    vector<int64_t> chargebackReservedSeconds;
+
+    // Event totals: the events by type, the time of the first dated one
+    // (LLONG_MAX if none) and the denied requests by product (see
+    // EventTotals)
+    vector<uint64_t> eventTypeCounts;
+    int64_t firstEventTime;
+    vector<uint64_t> productDenials;
+
+    // Reports the next run appends to and their length up to which they
+    // stay valid
+    vector<string> reportPaths;
+    vector<uint64_t> reportLengths;
+};
+
+// The combined results of a batch of logs (see BatchSummary), saved so that
+// the logs of one archive can be analyzed apart, e.g. on several machines,
+// and their summaries merged into the batch reports in one cheap step
+struct PartialSummary
+{
+    PartialSummary();
+
+    // Returns false if the file is missing, unreadable or of another version
+    bool load(const string& filePath);
+
+    // Writes a temporary file and renames it like a checkpoint.  Throws
+    // CannotOpenFileException.
+    void save(const string& filePath) const;
+
+    bool approximate;
+    vector<string> inputFilePaths;
+
+    // Interned names in id order
+    vector<string> servers;
+    vector<string> products;
+    vector<string> users;
+    vector<string> hosts;
+
+    // Durations by host or user and product, and the event counts
+    vector<CheckpointEntry> hostDurations;
+    vector<CheckpointEntry> userDurations;
+    uint64_t starts;
+    uint64_t shutdowns;
+    uint64_t sessions;
+    uint64_t denials;
+
+    // Approximate summaries: the registers of the user and host sketches,
+    // then those of the monthly user sketches of every product and month
+    // listed (see DistinctSketch)
+    string sketches;
+    vector<uint64_t> monthlyProducts;
+    vector<int64_t> monthlyMonths;
+};
+
+// FNV-1a hash of a piece of the input log
+uint64_t checkpointHash(const char* data, size_t size);
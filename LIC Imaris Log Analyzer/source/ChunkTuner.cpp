@@ -0,0 +1,142 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ChunkTuner.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    // The bounds of a chunk and its size until a parse was measured
+    const size_t MinTunedChunkBytes = 16 << 10;
+    const size_t MaxTunedChunkBytes = 64 << 20;
+    const size_t InitialChunkBytes = 1 << 20;
+
+    const double TargetChunkSeconds = 0.02;
+    const double MinScale = 0.125;
+    const double MaxScale = 8.0;
+}
+
+ChunkTuner::ChunkTuner(string_view text, size_t threads, size_t queueCapacity)
+    : m_text(text),
+      m_offset(0),
+      m_threads(max(threads, static_cast<size_t>(1))),
+      m_queueCapacity(queueCapacity),
+      m_scale(1.0),
+      m_parsedBytes(0.0),
+      m_parseSeconds(0.0),
+      m_chunks(0),
+      m_minBytes(0),
+      m_maxBytes(0),
+      m_lastBytes(0),
+      m_queuedSum(0)
+{
+}
+
+bool ChunkTuner::nextChunk(string_view& chunk, size_t queued)
+{
+    if (m_offset >= m_text.size())
+    {
+        return false;
+    }
+
+    size_t end = m_offset + chunkBytes(queued);
+    if (end >= m_text.size())
+    {
+        end = m_text.size();
+    }
+    else
+    {
+        size_t lineBreak = m_text.find('\n', end - 1);
+        end = (lineBreak == string_view::npos) ? m_text.size() : lineBreak + 1;
+    }
+    chunk = m_text.substr(m_offset, end - m_offset);
+    m_offset = end;
+
+    uint64_t bytes = chunk.size();
+    m_minBytes = (m_chunks == 0) ? bytes : min(m_minBytes, bytes);
+    m_maxBytes = max(m_maxBytes, bytes);
+    m_lastBytes = bytes;
+    m_queuedSum += queued;
+    ++m_chunks;
+    return true;
+}
+
+void ChunkTuner::recordParse(size_t bytes, double seconds)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_parsedBytes += static_cast<double>(bytes);
+    m_parseSeconds += seconds;
+}
+
+size_t ChunkTuner::chunkBytes(size_t queued)
+{
+    double bytesPerSecond = 0.0;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_parseSeconds > 0.0)
+        {
+            bytesPerSecond = m_parsedBytes / m_parseSeconds;
+        }
+    }
+
+    if (m_queueCapacity > 0 && m_chunks > 0)
+    {
+        if (queued == 0)
+        {
+            m_scale = max(MinScale, m_scale * 0.75);
+        }
+        else if (queued + 1 >= m_queueCapacity)
+        {
+            m_scale = min(MaxScale, m_scale * 1.25);
+        }
+    }
+
+    double bytes = (bytesPerSecond > 0.0) ? bytesPerSecond * TargetChunkSeconds * m_scale
+                                          : static_cast<double>(InitialChunkBytes);
+    size_t chunkBytes = static_cast<size_t>(min(bytes, static_cast<double>(MaxTunedChunkBytes)));
+
+    // Every thread gets a share of the rest
+    size_t share = (m_text.size() - m_offset + m_threads - 1) / m_threads;
+    return max(MinTunedChunkBytes, min(chunkBytes, share));
+}
+
+ChunkTuning ChunkTuner::tuning(const string& stage) const
+{
+    ChunkTuning tuning;
+    tuning.stage = stage;
+    tuning.chunks = m_chunks;
+    tuning.minBytes = m_minBytes;
+    tuning.maxBytes = m_maxBytes;
+    tuning.lastBytes = m_lastBytes;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        tuning.bytesPerSecond = (m_parseSeconds > 0.0) ? m_parsedBytes / m_parseSeconds : 0.0;
+    }
+    tuning.queueCapacity = m_queueCapacity;
+    tuning.meanQueued = (m_queueCapacity > 0 && m_chunks > 0)
+                            ? static_cast<double>(m_queuedSum) / static_cast<double>(m_chunks) : 0.0;
+    return tuning;
+}
@@ -0,0 +1,90 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include "PipelineStats.h"
+
+using namespace std;
+
+// Cuts a mapped log into the chunks that are parsed in parallel, sizing
+// every chunk when it is handed out from what the chunks before it
+// measured.  A fixed size is wrong at either end: a small daily log made
+// one chunk keeps the other threads idle, and a multi-gigabyte archive cut
+// into a chunk per thread holds all of its parsed events at once and starts
+// the pass after the parse late.
+//
+// A chunk should take about TargetChunkSeconds to parse at the throughput
+// the parsed chunks showed, so the work is spread in pieces small enough to
+// balance across the threads yet large enough to amortize their hand-off.
+// With a concurrent usage pass taking the parsed chunks, the chunks also
+// follow the batches waiting for it: an empty queue means the pass starves
+// and smaller chunks reach it sooner, a full one that the parse is ahead
+// and larger ones cost less.  The rest of the log is always split among
+// the threads, so the last chunks do not leave them idle.
+//
+// The chunks are cut on the thread that hands them out, in order; the
+// parse times are recorded from any thread.
+class ChunkTuner
+{
+    public:
+        ChunkTuner(string_view text, size_t threads, size_t queueCapacity = 0);
+        ChunkTuner(const ChunkTuner&) = delete;
+        ChunkTuner& operator=(const ChunkTuner&) = delete;
+
+        // The next chunk, ending at a line break, or false once the text is
+        // used up.  queued is the number of batches waiting for the usage
+        // pass, if there is one.
+        bool nextChunk(string_view& chunk, size_t queued = 0);
+
+        // A chunk of bytes took seconds to parse
+        void recordParse(size_t bytes, double seconds);
+
+        // The figures of the chunks for the stats of stage
+        ChunkTuning tuning(const string& stage) const;
+
+    private:
+        size_t chunkBytes(size_t queued);
+
+        string_view m_text;
+        size_t m_offset;
+        size_t m_threads;
+        size_t m_queueCapacity;
+        // Set by the queue occupancy, from 1/8 to 8 times the size the
+        // throughput calls for
+        double m_scale;
+
+        mutable mutex m_mutex;
+        double m_parsedBytes;
+        double m_parseSeconds;
+
+        uint64_t m_chunks;
+        uint64_t m_minBytes;
+        uint64_t m_maxBytes;
+        uint64_t m_lastBytes;
+        uint64_t m_queuedSum;
+};
@@ -0,0 +1,463 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "CombinedUsage.h"
+#include "BufferedWriter.h"
+#include "Exceptions.h"
+#include "LogData.h"
+#include "UserBitset.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <boost/filesystem/operations.hpp>
+
+using namespace std;
+
+namespace
+{
+    // One event of a run.  The runs are read back by the process that wrote
+    // them, so they keep its layout.  PRODUCT events have no timestamp and
+    // take that of the event before them.
+    struct RunEvent
+    {
+        long long timestamp;
+        uint32_t product;
+        uint32_t user;
+        int32_t count;
+        int32_t reserved;
+        uint32_t type;
+        uint32_t unused;
+    };
+
+    const uint32_t NoRunId = UINT32_MAX;
+
+    // Events written to a run at a time, and the smallest read of a run
+    const size_t RunWriteEvents = 1 << 15;
+    const size_t MinRunReadBytes = 64 << 10;
+
+    // Reads a run front to back, a buffer of events at a time.  Throws
+    // CannotOpenFileException if the run holds fewer events than written.
+    class RunReader
+    {
+        public:
+            RunReader(const string& path, uint64_t eventCount, size_t bufferEvents)
+                : m_path(path), m_file(fopen(path.c_str(), "rb")), m_remaining(eventCount),
+                  m_buffer(bufferEvents), m_next(0), m_count(0)
+            {
+            }
+            ~RunReader()
+            {
+                if (m_file != NULL)
+                {
+                    fclose(m_file);
+                }
+            }
+            RunReader(const RunReader&) = delete;
+            RunReader& operator=(const RunReader&) = delete;
+
+            // The next event, or NULL at the end of the run
+            const RunEvent* next()
+            {
+                if (m_next == m_count)
+                {
+                    if (m_remaining == 0)
+                    {
+                        return NULL;
+                    }
+                    size_t wanted = static_cast<size_t>(min(m_remaining, static_cast<uint64_t>(m_buffer.size())));
+                    m_count = (m_file != NULL) ? fread(m_buffer.data(), sizeof(RunEvent), wanted, m_file) : 0;
+                    if (m_count == 0)
+                    {
+                        CannotOpenFileException cannotOpenFileException(m_path);
+                        throw cannotOpenFileException;
+                    }
+                    m_remaining -= m_count;
+                    m_next = 0;
+                }
+                return &m_buffer[m_next++];
+            }
+
+        private:
+            string m_path;
+            FILE* m_file;
+            uint64_t m_remaining;
+            vector<RunEvent> m_buffer;
+            size_t m_next;
+            size_t m_count;
+    };
+
+    // Next event of one server's run
+    struct MergeCursor
+    {
+        long long timestamp;
+        size_t server;
+        size_t row;
+        RunEvent event;
+
+        bool operator>(const MergeCursor& other) const
+        {
+            if (timestamp != other.timestamp)
+            {
+                return timestamp > other.timestamp;
+            }
+            if (server != other.server)
+            {
+                return server > other.server;
+            }
+            return row > other.row;
+        }
+    };
+}
+
+CombinedUsage::CombinedUsage(const string& outputDirectory, size_t memoryCap)
+    : m_outputPath(outputDirectory + "/LIC_Imaris_Combined_Concurrent_License_Usage.csv"),
+      m_memoryCap(memoryCap)
+{
+}
+
+CombinedUsage::~CombinedUsage()
+{
+    for (size_t run = 0; run < m_runPaths.size(); ++run)
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(m_runPaths.at(run), error);
+    }
+}
+
+// The other events do not change the combined usage and are left out.  The
+// server name is only filled in once the run is written.
+void CombinedUsage::spillServer(const LogData& logData, ServerRun& run)
+{
+    FILE* output = fopen(run.path.c_str(), "wb");
+    bool good = (output != NULL);
+    const EventStore& events = logData.events();
+    vector<RunEvent> batch;
+    batch.reserve(RunWriteEvents);
+    long long timestamp = 0;
+    run.eventCount = 0;
+    for (size_t row = 0; row < events.size() && good; ++row)
+    {
+        eventType type = events.types[row];
+        if (type != ProductEvent)
+        {
+            timestamp = events.timestamps[row];
+        }
+        if (type != OutEvent && type != InEvent && type != ShutdownEvent && type != ProductEvent)
+        {
+            continue;
+        }
+
+        RunEvent event;
+        event.timestamp = timestamp;
+        event.product = (events.products[row] == NoId) ? NoRunId : static_cast<uint32_t>(events.products[row]);
+        event.user = (events.users[row] == NoId) ? NoRunId : static_cast<uint32_t>(events.users[row]);
+        event.count = events.counts[row];
+        event.reserved = events.reserved[row];
+        event.type = static_cast<uint32_t>(type);
+        event.unused = 0;
+        batch.push_back(event);
+        if (batch.size() == RunWriteEvents)
+        {
+            good = fwrite(batch.data(), sizeof(RunEvent), batch.size(), output) == batch.size();
+            run.eventCount += batch.size();
+            batch.clear();
+        }
+    }
+    if (good && ! batch.empty())
+    {
+        good = fwrite(batch.data(), sizeof(RunEvent), batch.size(), output) == batch.size();
+        run.eventCount += batch.size();
+    }
+    if (output != NULL && fclose(output) != 0)
+    {
+        good = false;
+    }
+    if (! good)
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(run.path, error);
+        CannotOpenFileException cannotOpenFileException(run.path);
+        throw cannotOpenFileException;
+    }
+
+    run.products.clear();
+    for (size_t product = 0; product < logData.uniqueProducts().size(); ++product)
+    {
+        run.products.push_back(string(logData.uniqueProducts().name(product)));
+    }
+    run.users.clear();
+    for (size_t user = 0; user < logData.uniqueUsers().size(); ++user)
+    {
+        run.users.push_back(string(logData.uniqueUsers().name(user)));
+    }
+    run.serverName = logData.serverName().empty() ? getFilenameFromFilepath(logData.inputFilePath())
+                                                  : logData.serverName();
+}
+
+// Products and users get combined ids in the order the servers are added
+void CombinedUsage::addServer(const ServerRun& run)
+{
+    m_runPaths.push_back(run.path);
+    m_runEvents.push_back(run.eventCount);
+    m_serverNames.push_back(run.serverName);
+
+    vector<size_t> productIds;
+    for (size_t product = 0; product < run.products.size(); ++product)
+    {
+        productIds.push_back(m_uniqueProducts.intern(run.products.at(product)));
+    }
+    m_productIds.push_back(productIds);
+
+    vector<size_t> userIds;
+    for (size_t user = 0; user < run.users.size(); ++user)
+    {
+        userIds.push_back(m_uniqueUsers.intern(run.users.at(user)));
+    }
+    m_userIds.push_back(userIds);
+}
+
+size_t CombinedUsage::serverCount() const
+{
+    return m_runPaths.size();
+}
+
+void CombinedUsage::checkForExistingFiles(string& conflictedFileList)
+{
+    if (fileExists(m_outputPath))
+    {
+        conflictedFileList.append(m_outputPath);
+        conflictedFileList.append("\n");
+    }
+}
+
+void CombinedUsage::publishResults()
+{
+    writeCombinedUsage(m_outputPath);
+}
+
+// One row per OUT, IN and SHUTDOWN event of any server, in time order, with
+// the server it came from and the combined counters after it
+void CombinedUsage::writeCombinedUsage(const string& outputFilePath)
+{
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    const size_t numberOfUsers = m_uniqueUsers.size();
+    const size_t numberOfServers = m_runPaths.size();
+
+    // Per server: the counters as that server's log reports them, each
+    // user's licenses by product and the users that hold each product.  A
+    // product's users in use across servers are the union of the latter.
+    vector< vector<UsageCounters> > serverCounters(numberOfServers, vector<UsageCounters>(numberOfProducts, UsageCounters()));
+    vector< vector<uint32_t> > serverLicenseCounts(numberOfServers, vector<uint32_t>(numberOfUsers * numberOfProducts, 0));
+    vector< vector<UserBitset> > serverHolders(numberOfServers, vector<UserBitset>(numberOfProducts));
+    for (size_t server = 0; server < numberOfServers; ++server)
+    {
+        for (size_t product = 0; product < numberOfProducts; ++product)
+        {
+            serverHolders.at(server).at(product).reset(numberOfUsers);
+        }
+    }
+    vector<int32_t> usersInUse(numberOfProducts, 0);
+    UserBitset heldElsewhere;
+    vector<long long> lastTimestamps(numberOfServers, 0);
+
+    BufferedWriter out(outputFilePath);
+
+    out.write("Date/Time,Server");
+    for (size_t product=0; product<numberOfProducts; ++product)
+    {
+        string_view productName = m_uniqueProducts.name(product);
+        out.write(',');
+        out.write(productName);
+        out.write(" Floating Licenses in use,");
+        out.write(productName);
+        out.write(" Total Licenses in use,");
+        out.write(productName);
+        out.write(" Floating Licenses Limit,");
+        out.write(productName);
+        out.write(" Reserved Licenses in use,");
+        out.write(productName);
+        out.write(" Reserved Licenses Limit");
+    }
+    out.write('\n');
+
+    // The read buffers share the memory cap
+    size_t bufferBytes = max(MinRunReadBytes, m_memoryCap / max(numberOfServers, static_cast<size_t>(1)));
+    vector< unique_ptr<RunReader> > runs;
+    priority_queue< MergeCursor, vector<MergeCursor>, greater<MergeCursor> > cursors;
+    for (size_t server = 0; server < numberOfServers; ++server)
+    {
+        runs.push_back(unique_ptr<RunReader>(new RunReader(m_runPaths.at(server), m_runEvents.at(server),
+                                                           bufferBytes / sizeof(RunEvent))));
+        const RunEvent* event = runs.back()->next();
+        if (event != NULL)
+        {
+            MergeCursor cursor = { event->timestamp, server, 0, *event };
+            cursors.push(cursor);
+        }
+    }
+
+    while (! cursors.empty())
+    {
+        MergeCursor cursor = cursors.top();
+        cursors.pop();
+
+        const size_t server = cursor.server;
+        const RunEvent& event = cursor.event;
+        const eventType type = static_cast<eventType>(event.type);
+        lastTimestamps.at(server) = cursor.timestamp;
+
+        const RunEvent* nextEvent = runs.at(server)->next();
+        if (nextEvent != NULL)
+        {
+            MergeCursor next = { nextEvent->timestamp, server, cursor.row + 1, *nextEvent };
+            cursors.push(next);
+        }
+
+        vector<UsageCounters>& counters = serverCounters.at(server);
+        vector<uint32_t>& serverCounts = serverLicenseCounts.at(server);
+        vector<UserBitset>& holders = serverHolders.at(server);
+
+        // Whether another server has the user holding the product
+        auto heldByOtherServer = [&](size_t user, size_t product)
+        {
+            for (size_t otherServer = 0; otherServer < numberOfServers; ++otherServer)
+            {
+                if (otherServer != server && serverHolders[otherServer][product].contains(user))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        if (type == OutEvent || type == InEvent)
+        {
+            size_t product = m_productIds.at(server).at(event.product);
+            size_t user = m_userIds.at(server).at(event.user);
+            size_t countIndex = user * numberOfProducts + product;
+            counters.at(product).floatingInUse = event.count;
+            counters.at(product).reservedInUse = event.reserved;
+
+            if (type == OutEvent)
+            {
+                if (++serverCounts.at(countIndex) == 1)
+                {
+                    holders.at(product).insert(user);
+                    if (! heldByOtherServer(user, product))
+                    {
+                        ++usersInUse.at(product);
+                    }
+                }
+            }
+            else if (serverCounts.at(countIndex) > 0)
+            {
+                // A check-in without a check-out in this log is ignored,
+                // as in the per-server usage
+                if (--serverCounts.at(countIndex) == 0)
+                {
+                    holders.at(product).erase(user);
+                    if (! heldByOtherServer(user, product))
+                    {
+                        --usersInUse.at(product);
+                    }
+                }
+            }
+        }
+        else if (type == ShutdownEvent)
+        {
+            // The server's users leave the union unless another server has
+            // them too; only their own license counts are cleared
+            for (size_t product = 0; product < numberOfProducts; ++product)
+            {
+                counters.at(product).floatingInUse = 0;
+
+                UserBitset& productHolders = holders.at(product);
+                heldElsewhere.reset(numberOfUsers);
+                for (size_t otherServer = 0; otherServer < numberOfServers; ++otherServer)
+                {
+                    if (otherServer != server)
+                    {
+                        heldElsewhere.unionWith(serverHolders[otherServer][product]);
+                    }
+                }
+                usersInUse.at(product) -= static_cast<int32_t>(productHolders.countNotIn(heldElsewhere));
+                for (size_t user = productHolders.next(0); user != NoId; user = productHolders.next(user + 1))
+                {
+                    serverCounts[user * numberOfProducts + product] = 0;
+                }
+                productHolders.reset(numberOfUsers);
+            }
+        }
+        else if (type == ProductEvent)
+        {
+            size_t product = m_productIds.at(server).at(event.product);
+            counters.at(product).floatingLimit = event.count;
+            counters.at(product).reservedLimit = event.reserved;
+            continue;
+        }
+        else
+        {
+            continue;
+        }
+
+        out.writeLogDateTime(cursor.timestamp);
+        out.write(',');
+        out.write(m_serverNames.at(server));
+        for (size_t product = 0; product < numberOfProducts; ++product)
+        {
+            UsageCounters combined;
+            for (size_t counterServer = 0; counterServer < numberOfServers; ++counterServer)
+            {
+                const UsageCounters& productCounters = serverCounters.at(counterServer).at(product);
+                combined.floatingInUse += productCounters.floatingInUse;
+                combined.floatingLimit += productCounters.floatingLimit;
+                combined.reservedInUse += productCounters.reservedInUse;
+                combined.reservedLimit += productCounters.reservedLimit;
+            }
+
+            // Licenses checked out before the logs started have no user; at
+            // least one is in use then, as in the per-server usage
+            combined.totalInUse = usersInUse.at(product);
+            if (combined.totalInUse == 0 && combined.floatingInUse > 0)
+            {
+                combined.totalInUse = 1;
+            }
+
+            out.write(',');
+            out.writeInteger(combined.floatingInUse);
+            out.write(',');
+            out.writeInteger(combined.totalInUse);
+            out.write(',');
+            out.writeInteger(combined.floatingLimit);
+            out.write(',');
+            out.writeInteger(combined.reservedInUse);
+            out.write(',');
+            out.writeInteger(combined.reservedLimit);
+        }
+        out.write('\n');
+    }
+    out.close();
+}
@@ -0,0 +1,95 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StringInterner.h"
+
+using namespace std;
+
+class LogData;
+
+// Read buffers of the merge in all, unless set (see CombinedUsage)
+const size_t DefaultMergeMemory = 64 << 20;
+
+// The events of one server's log that the combined usage needs, spilled in
+// time order to a run file as soon as the log is analyzed, with the names
+// the events refer to by the log's ids (see CombinedUsage::spillServer)
+struct ServerRun
+{
+    ServerRun() : eventCount(0) {}
+
+    string path;
+    string serverName;
+    vector<string> products;
+    vector<string> users;
+    uint64_t eventCount;
+};
+
+// Concurrent license usage of several license servers, e.g. a primary and a
+// failover server, on one timeline.  The events of every server's log are
+// already in time order, so each log is spilled to a run file of its own
+// and the runs are k-way merged by timestamp, read sequentially in large
+// blocks, and streamed straight into the report instead of being
+// concatenated and re-sorted.  The logs are thus not kept in memory while
+// the others are analyzed, and the merge holds only the read buffers, which
+// share memoryCap bytes, whatever the length of the runs.  The per-server
+// usage is each log's own concurrent usage report.
+//
+// The combined floating counts and limits are the sums over the servers; the
+// total licenses in use count the users across all servers once.  The run
+// files belong to the CombinedUsage once added and are removed with it.
+class CombinedUsage
+{
+    public:
+        CombinedUsage(const string& outputDirectory, size_t memoryCap = DefaultMergeMemory);
+        ~CombinedUsage();
+        CombinedUsage(const CombinedUsage&) = delete;
+        CombinedUsage& operator=(const CombinedUsage&) = delete;
+
+        // Writes the OUT, IN, SHUTDOWN and PRODUCT events of the log to
+        // run.path and fills in the rest of the run, the server name last.
+        // Throws CannotOpenFileException if the run cannot be written.
+        static void spillServer(const LogData& logData, ServerRun& run);
+
+        void addServer(const ServerRun& run);
+        size_t serverCount() const;
+
+        void checkForExistingFiles(string& conflictedFiles);
+        void publishResults();
+
+    private:
+        void writeCombinedUsage(const string& outputFilePath);
+
+        string m_outputPath;
+        size_t m_memoryCap;
+        vector<string> m_runPaths;
+        vector<uint64_t> m_runEvents;
+        vector<string> m_serverNames;
+        StringInterner m_uniqueProducts;
+        StringInterner m_uniqueUsers;
+        vector< vector<size_t> > m_productIds;
+        vector< vector<size_t> > m_userIds;
+};
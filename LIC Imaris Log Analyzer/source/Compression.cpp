@@ -0,0 +1,669 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Compression.h"
+#include "Exceptions.h"
+#include "ResourceLimits.h"
+#include "TraceRecorder.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+namespace io = boost::iostreams;
+
+namespace
+{
+    void pushDecompressor(compressionFormat compression, io::filtering_istream& in)
+    {
+        if (compression == GzipCompressed)
+        {
+            in.push(io::gzip_decompressor());
+        }
+        else
+        {
+            in.push(io::zstd_decompressor());
+        }
+    }
+
+    // Sets up in to read the decompressed log.  A damaged stream makes the
+    // reads throw instead of ending the log early.
+    void openDecompressed(const string& filePath, compressionFormat compression, io::filtering_istream& in)
+    {
+        io::file_source file(filePath, ios::in | ios::binary);
+        if (! file.is_open())
+        {
+            CannotOpenFileException cannotOpenFileException(filePath);
+            throw cannotOpenFileException;
+        }
+        pushDecompressor(compression, in);
+        in.push(file);
+        in.exceptions(ios::badbit);
+    }
+
+    // Writes the compressed stream to an open file
+    class FileSink
+    {
+    public:
+        typedef char char_type;
+        typedef io::sink_tag category;
+
+        FileSink(FILE* file, bool& failed) : m_file(file), m_failed(&failed) {}
+
+        streamsize write(const char* data, streamsize size)
+        {
+            if (fwrite(data, 1, static_cast<size_t>(size), m_file) != static_cast<size_t>(size))
+            {
+                *m_failed = true;
+            }
+            return size;
+        }
+
+    private:
+        FILE* m_file;
+        bool* m_failed;
+    };
+
+    const uint64_t UnknownContentSize = UINT64_MAX;
+
+    // The text a ParallelDecompressingStream decompresses in one go.  A
+    // piece that does not record its size is taken to be a tenth of its
+    // text, as a log usually is.
+    const size_t PieceBatchText = 4 << 20;
+    const size_t MinPieceBatchText = 256 << 10;
+    const uint64_t CompressionRatio = 10;
+
+    // The decompressed size a zstd frame header records, if any, and the
+    // length of the header; 0 if length bytes do not hold all of it
+    uint64_t zstdFrameHeader(const unsigned char* header, size_t length, size_t& headerLength)
+    {
+        headerLength = 0;
+        if (length < 5)
+        {
+            return UnknownContentSize;
+        }
+
+        // Frame header descriptor: content size flag, single segment flag
+        // and dictionary id flag.  A single segment frame has no window
+        // descriptor and always records its size.
+        unsigned char descriptor = header[4];
+        unsigned int sizeFlag = descriptor >> 6;
+        bool singleSegment = (descriptor & 0x20) != 0;
+        const size_t dictionaryIdSizes[] = {0, 1, 2, 4};
+        const size_t contentSizeSizes[] = {static_cast<size_t>(singleSegment ? 1 : 0), 2, 4, 8};
+        size_t offset = 5 + (singleSegment ? 0 : 1) + dictionaryIdSizes[descriptor & 0x3];
+        size_t sizeLength = contentSizeSizes[sizeFlag];
+        if (offset + sizeLength > length)
+        {
+            return UnknownContentSize;
+        }
+        headerLength = offset + sizeLength;
+        if (sizeLength == 0)
+        {
+            return UnknownContentSize;
+        }
+
+        uint64_t contentSize = 0;
+        for (size_t byte = 0; byte < sizeLength; ++byte)
+        {
+            contentSize |= static_cast<uint64_t>(header[offset + byte]) << (8 * byte);
+        }
+        return (sizeLength == 2) ? contentSize + 256 : contentSize;
+    }
+
+    // The decompressed size the header of the first zstd frame records, if
+    // any.  The zstd filter ends a truncated log without an error, so its
+    // length is checked against this; a log of several frames is longer.
+    uint64_t zstdContentSize(const string& filePath)
+    {
+        ifstream inputFile(filePath.c_str(), ios::binary);
+        unsigned char header[18] = {0};
+        inputFile.read(reinterpret_cast<char*>(header), sizeof(header));
+        size_t headerLength;
+        return zstdFrameHeader(header, static_cast<size_t>(inputFile.gcount()), headerLength);
+    }
+
+    uint32_t readLittleEndian(const unsigned char* data, size_t bytes)
+    {
+        uint32_t value = 0;
+        for (size_t byte = 0; byte < bytes; ++byte)
+        {
+            value |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+        }
+        return value;
+    }
+
+    // The members of a BGZF gzip: each has the extra field BC, which holds
+    // its size less one, and ends with its decompressed size
+    bool findGzipPieces(const unsigned char* data, size_t size, vector<CompressedPiece>& pieces)
+    {
+        const size_t headerLength = 12;
+        const size_t trailerLength = 8;
+        size_t offset = 0;
+        while (offset < size)
+        {
+            const unsigned char* header = data + offset;
+            size_t left = size - offset;
+            if (left < headerLength || header[0] != 0x1F || header[1] != 0x8B || header[2] != 8 || (header[3] & 0x04) == 0)
+            {
+                return false;
+            }
+            size_t extraEnd = headerLength + readLittleEndian(header + 10, 2);
+            if (extraEnd > left)
+            {
+                return false;
+            }
+
+            size_t memberSize = 0;
+            for (size_t field = headerLength; field + 4 <= extraEnd; field += 4 + readLittleEndian(header + field + 2, 2))
+            {
+                if (header[field] == 'B' && header[field + 1] == 'C' && readLittleEndian(header + field + 2, 2) == 2 &&
+                    field + 6 <= extraEnd)
+                {
+                    memberSize = readLittleEndian(header + field + 4, 2) + 1;
+                }
+            }
+            if (memberSize < extraEnd + trailerLength || memberSize > left)
+            {
+                return false;
+            }
+
+            CompressedPiece piece = { offset, memberSize, readLittleEndian(header + memberSize - 4, 4) };
+            pieces.push_back(piece);
+            offset += memberSize;
+        }
+        return true;
+    }
+
+    // The frames of a zstd log, walked block by block, whose headers hold
+    // their sizes.  Skippable frames, e.g. the seek table of the seekable
+    // format, are left out.
+    bool findZstdPieces(const unsigned char* data, size_t size, vector<CompressedPiece>& pieces)
+    {
+        const uint32_t frameMagic = 0xFD2FB528;
+        const uint32_t skippableMagic = 0x184D2A50;
+        size_t offset = 0;
+        while (offset < size)
+        {
+            const unsigned char* frame = data + offset;
+            size_t left = size - offset;
+            uint32_t magic = (left >= 4) ? readLittleEndian(frame, 4) : 0;
+            if ((magic & 0xFFFFFFF0) == skippableMagic)
+            {
+                if (left < 8 || readLittleEndian(frame + 4, 4) > left - 8)
+                {
+                    return false;
+                }
+                offset += 8 + readLittleEndian(frame + 4, 4);
+                continue;
+            }
+            size_t headerLength;
+            uint64_t contentSize = zstdFrameHeader(frame, left, headerLength);
+            if (magic != frameMagic || headerLength == 0)
+            {
+                return false;
+            }
+
+            // Each block has a header of three bytes: whether it is the
+            // last, its type and its size.  An RLE block holds one byte.
+            size_t position = headerLength;
+            bool lastBlock = false;
+            while (! lastBlock)
+            {
+                if (left - position < 3)
+                {
+                    return false;
+                }
+                uint32_t blockHeader = readLittleEndian(frame + position, 3);
+                lastBlock = (blockHeader & 1) != 0;
+                unsigned int blockType = (blockHeader >> 1) & 3;
+                size_t blockSize = (blockType == 1) ? 1 : (blockHeader >> 3);
+                position += 3;
+                if (blockType == 3 || blockSize > left - position)
+                {
+                    return false;
+                }
+                position += blockSize;
+            }
+            // The content checksum
+            if ((frame[4] & 0x04) != 0)
+            {
+                if (left - position < 4)
+                {
+                    return false;
+                }
+                position += 4;
+            }
+
+            CompressedPiece piece = { offset, position, contentSize };
+            pieces.push_back(piece);
+            offset += position;
+        }
+        return true;
+    }
+
+    // Reads up to size bytes, fewer only at the end of the log
+    size_t readDecompressed(const string& filePath, io::filtering_istream& in, char* data, size_t size)
+    {
+        try
+        {
+            in.read(data, static_cast<streamsize>(size));
+        }
+        catch (const ios_base::failure&)
+        {
+            DecompressionException decompressionException(filePath);
+            throw decompressionException;
+        }
+        return static_cast<size_t>(in.gcount());
+    }
+}
+
+compressionFormat detectCompression(const string& filePath)
+{
+    ifstream inputFile(filePath.c_str(), ios::binary);
+    unsigned char magic[4] = {0};
+    inputFile.read(reinterpret_cast<char*>(magic), sizeof(magic));
+    streamsize length = inputFile.gcount();
+
+    if (length >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+    {
+        return GzipCompressed;
+    }
+    if (length >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+    {
+        return ZstdCompressed;
+    }
+    return Uncompressed;
+}
+
+string compressionSuffix(compressionFormat compression)
+{
+    switch (compression)
+    {
+        case GzipCompressed:
+            return ".gz";
+        case ZstdCompressed:
+            return ".zst";
+        default:
+            return "";
+    }
+}
+
+string readDecompressedHead(const string& filePath, compressionFormat compression, size_t size)
+{
+    DecompressingStream stream(filePath, compression);
+    string head(size, '\0');
+    head.resize(stream.read(&head[0], size));
+
+    return head;
+}
+
+struct DecompressingStream::Stream
+{
+    io::filtering_istream in;
+};
+
+DecompressingStream::DecompressingStream(const string& filePath, compressionFormat compression)
+    : m_filePath(filePath),
+      m_stream(new Stream()),
+      m_expectedSize(UnknownContentSize),
+      m_decompressedSize(0)
+{
+    openDecompressed(filePath, compression, m_stream->in);
+    if (compression == ZstdCompressed)
+    {
+        m_expectedSize = zstdContentSize(filePath);
+    }
+}
+
+DecompressingStream::~DecompressingStream()
+{
+}
+
+size_t DecompressingStream::read(char* data, size_t size)
+{
+    size_t length = readDecompressed(m_filePath, m_stream->in, data, size);
+    m_decompressedSize += length;
+    if (length < size && m_expectedSize != UnknownContentSize && m_decompressedSize < m_expectedSize)
+    {
+        DecompressionException decompressionException(m_filePath);
+        throw decompressionException;
+    }
+    return length;
+}
+
+bool findCompressedPieces(const char* data, size_t size, compressionFormat compression,
+                          vector<CompressedPiece>& pieces)
+{
+    pieces.clear();
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    bool found = (compression == GzipCompressed) ? findGzipPieces(bytes, size, pieces) :
+                 (compression == ZstdCompressed) ? findZstdPieces(bytes, size, pieces) : false;
+    if (! found)
+    {
+        pieces.clear();
+    }
+    return found;
+}
+
+struct ParallelDecompressingStream::Mapping
+{
+    MappedFile file;
+};
+
+ParallelDecompressingStream::ParallelDecompressingStream(const string& filePath, compressionFormat compression)
+    : m_filePath(filePath),
+      m_compression(compression),
+      m_readBatch(0),
+      m_nextBatch(0),
+      m_stopped(false),
+      m_textOffset(0)
+{
+    size_t threads = availableThreads();
+    if (threads < 2 || ! MappedFile::fits(filePath))
+    {
+        return;
+    }
+    m_mapping.reset(new Mapping());
+    m_mapping->file.open(filePath);
+    vector<CompressedPiece> pieces;
+    if (! findCompressedPieces(m_mapping->file.data(), m_mapping->file.size(), compression, pieces) || pieces.size() < 2)
+    {
+        m_mapping.reset();
+        return;
+    }
+
+    // Consecutive pieces make a batch of about PieceBatchText bytes of
+    // text, less under a memory limit
+    size_t slots = 2 * threads;
+    uint64_t batchText = limitedBufferSize(PieceBatchText, MinPieceBatchText, slots);
+    uint64_t text = 0;
+    for (size_t piece = 0; piece < pieces.size(); ++piece)
+    {
+        const CompressedPiece& next = pieces.at(piece);
+        bool contiguous = ! m_batches.empty() && m_batches.back().offset + m_batches.back().size == next.offset;
+        if (! contiguous || text >= batchText)
+        {
+            Batch batch = { next.offset, 0, 0 };
+            m_batches.push_back(batch);
+            text = 0;
+        }
+        Batch& batch = m_batches.back();
+        batch.size += next.size;
+        batch.contentSize = (batch.contentSize == UnknownContentSize || next.contentSize == UnknownContentSize) ?
+                            UnknownContentSize : batch.contentSize + next.contentSize;
+        text += (next.contentSize == UnknownContentSize) ? next.size * CompressionRatio : next.contentSize;
+    }
+
+    m_slots.resize(min(slots, m_batches.size()));
+    for (size_t thread = 0; thread < min(threads, m_batches.size()); ++thread)
+    {
+        m_threads.push_back(std::thread(&ParallelDecompressingStream::decompress, this));
+    }
+}
+
+// A stream dropped early stops the threads at their next batch
+ParallelDecompressingStream::~ParallelDecompressingStream()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_changed.notify_all();
+    for (size_t thread = 0; thread < m_threads.size(); ++thread)
+    {
+        m_threads.at(thread).join();
+    }
+}
+
+bool ParallelDecompressingStream::parallel() const
+{
+    return ! m_threads.empty();
+}
+
+size_t ParallelDecompressingStream::read(char* data, size_t size)
+{
+    size_t length = 0;
+    while (length < size)
+    {
+        if (m_textOffset == m_text.size())
+        {
+            if (m_readBatch == m_batches.size())
+            {
+                break;
+            }
+
+            // The text read before goes back to the slot for reuse
+            unique_lock<mutex> lock(m_mutex);
+            Slot& slot = m_slots.at(m_readBatch % m_slots.size());
+            m_changed.wait(lock, [&slot]() { return slot.ready; });
+            if (slot.error)
+            {
+                rethrow_exception(slot.error);
+            }
+            m_text.swap(slot.text);
+            m_textOffset = 0;
+            slot.ready = false;
+            ++m_readBatch;
+            lock.unlock();
+            m_changed.notify_all();
+            continue;
+        }
+
+        size_t count = min(size - length, m_text.size() - m_textOffset);
+        memcpy(data + length, m_text.data() + m_textOffset, count);
+        length += count;
+        m_textOffset += count;
+    }
+    return length;
+}
+
+// Takes the next batch whose slot is free, i.e. whose predecessor in the
+// slot has been read, until every batch is taken
+void ParallelDecompressingStream::decompress()
+{
+    while (true)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_changed.wait(lock, [this]() { return m_stopped || m_nextBatch == m_batches.size() ||
+                                               m_nextBatch < m_readBatch + m_slots.size(); });
+        if (m_stopped || m_nextBatch == m_batches.size())
+        {
+            return;
+        }
+        size_t batchIndex = m_nextBatch++;
+        Slot& slot = m_slots.at(batchIndex % m_slots.size());
+        string text;
+        text.swap(slot.text);
+        lock.unlock();
+
+        LIC_TRACE_SCOPE("decompress batch");
+        exception_ptr error;
+        try
+        {
+            const Batch& batch = m_batches.at(batchIndex);
+            io::filtering_istream in;
+            pushDecompressor(m_compression, in);
+            in.push(io::array_source(m_mapping->file.data() + batch.offset, batch.size));
+            in.exceptions(ios::badbit);
+
+            // One byte more than the pieces record shows whether they hold
+            // more; a batch of unknown size is read in growing steps
+            text.clear();
+            size_t step = (batch.contentSize != UnknownContentSize) ? static_cast<size_t>(batch.contentSize) + 1 :
+                          batch.size * static_cast<size_t>(CompressionRatio);
+            while (true)
+            {
+                size_t start = text.size();
+                text.resize(start + step);
+                size_t length = readDecompressed(m_filePath, in, &text[start], step);
+                text.resize(start + length);
+                if (length < step)
+                {
+                    break;
+                }
+                step = text.size();
+            }
+            if (batch.contentSize != UnknownContentSize && text.size() != batch.contentSize)
+            {
+                DecompressionException decompressionException(m_filePath);
+                throw decompressionException;
+            }
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+
+        lock.lock();
+        slot.text.swap(text);
+        slot.error = error;
+        slot.ready = true;
+        lock.unlock();
+        m_changed.notify_all();
+    }
+}
+
+CompressingOutput::CompressingOutput(FILE* file, compressionFormat compression)
+{
+    m_file = file;
+    m_compression = compression;
+    m_finishing = false;
+    m_failed = false;
+    m_thread = thread(&CompressingOutput::compress, this);
+}
+
+CompressingOutput::~CompressingOutput()
+{
+    finish();
+}
+
+void CompressingOutput::write(vector<char>& buffer, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    size_t bufferSize = buffer.size();
+    unique_lock<mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]() { return m_blocks.size() < BlocksAhead || m_failed; });
+    if (m_failed)
+    {
+        return;
+    }
+    buffer.resize(size);
+    m_blocks.push_back(move(buffer));
+    if (m_spareBlocks.empty())
+    {
+        buffer = vector<char>();
+    }
+    else
+    {
+        buffer = move(m_spareBlocks.back());
+        m_spareBlocks.pop_back();
+    }
+    lock.unlock();
+    m_changed.notify_all();
+
+    buffer.resize(bufferSize);
+}
+
+bool CompressingOutput::finish()
+{
+    if (m_thread.joinable())
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_finishing = true;
+        }
+        m_changed.notify_all();
+        m_thread.join();
+    }
+    return ! m_failed;
+}
+
+void CompressingOutput::compress()
+{
+    bool failed = false;
+    try
+    {
+        // gzip at its fastest level, which keeps up with the writers far
+        // better than the default and still shrinks the reports several
+        // times over; zstd is fast enough at its default level
+        io::filtering_ostream out;
+        if (m_compression == GzipCompressed)
+        {
+            out.push(io::gzip_compressor(io::gzip_params(io::gzip::best_speed)));
+        }
+        else
+        {
+            out.push(io::zstd_compressor());
+        }
+        out.push(FileSink(m_file, failed));
+        out.exceptions(ios::badbit);
+
+        while (true)
+        {
+            vector<char> block;
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_changed.wait(lock, [this]() { return ! m_blocks.empty() || m_finishing; });
+                if (m_blocks.empty())
+                {
+                    break;
+                }
+                block = move(m_blocks.front());
+                m_blocks.pop_front();
+            }
+            m_changed.notify_all();
+
+            out.write(block.data(), static_cast<streamsize>(block.size()));
+
+            lock_guard<mutex> lock(m_mutex);
+            m_spareBlocks.push_back(move(block));
+        }
+
+        // Ends the stream, which writes the rest and the trailer
+        out.reset();
+    }
+    catch (...)
+    {
+        failed = true;
+    }
+
+    // A failed stream drops the rest of the buffers
+    lock_guard<mutex> lock(m_mutex);
+    m_failed = failed;
+    m_blocks.clear();
+    m_finishing = true;
+    m_changed.notify_all();
+}
@@ -0,0 +1,204 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Report logs are often archived compressed.  A gzip (.gz) or zstd (.zst)
+// log is recognized by its magic bytes, whatever it is called, and read
+// decompressed; everything else is read as it is.  The reports may be
+// written compressed as well (see CompressingOutput).
+enum compressionFormat
+{
+    Uncompressed,
+    GzipCompressed,
+    ZstdCompressed
+};
+
+// Uncompressed also for a file that cannot be read, which opening it
+// reports later
+compressionFormat detectCompression(const string& filePath);
+
+// The file name extension of the format: .gz, .zst or nothing
+string compressionSuffix(compressionFormat compression);
+
+// Up to size bytes from the start of the decompressed log, for probing its
+// format without decompressing all of it
+string readDecompressedHead(const string& filePath, compressionFormat compression, size_t size);
+
+// Reads a compressed log decompressed.  See BlockReader for reading it
+// ahead of the parser.
+class DecompressingStream
+{
+public:
+    // Throws CannotOpenFileException
+    DecompressingStream(const string& filePath, compressionFormat compression);
+    ~DecompressingStream();
+
+    // Reads up to size bytes, fewer only at the end of the log.  Throws
+    // DecompressionException if the stream is damaged or truncated.
+    size_t read(char* data, size_t size);
+
+private:
+    DecompressingStream(const DecompressingStream&);
+    DecompressingStream& operator=(const DecompressingStream&);
+
+    struct Stream;
+
+    string m_filePath;
+    unique_ptr<Stream> m_stream;
+    uint64_t m_expectedSize;
+    uint64_t m_decompressedSize;
+};
+
+// A piece of a compressed log that decompresses on its own: a member of a
+// BGZF gzip (bgzip), whose header records its size, or a frame of a zstd
+// log (zstd -T, pzstd, the seekable format), whose block headers do.
+// contentSize is the decompressed size the piece records, if any.
+struct CompressedPiece
+{
+    size_t offset;
+    size_t size;
+    uint64_t contentSize;
+};
+
+// Lists the pieces of a compressed log in memory.  Returns false, leaving
+// pieces empty, for a log that is not made of such pieces, e.g. an ordinary
+// gzip whose members do not record their sizes, or one cut short; those are
+// read as a stream.
+bool findCompressedPieces(const char* data, size_t size, compressionFormat compression,
+                          vector<CompressedPiece>& pieces);
+
+// Reads a compressed log of several pieces decompressed, like a
+// DecompressingStream, but decompresses batches of pieces on all the
+// available threads a few batches ahead of the reads.  At most two batches
+// per thread are held at once.
+class ParallelDecompressingStream
+{
+public:
+    // Throws CannotOpenFileException
+    ParallelDecompressingStream(const string& filePath, compressionFormat compression);
+    ~ParallelDecompressingStream();
+
+    // Whether the log is of several pieces and there is more than one
+    // thread to decompress them on.  Otherwise nothing is read, and the log
+    // is better read by a DecompressingStream.
+    bool parallel() const;
+
+    // Reads up to size bytes, fewer only at the end of the log.  Throws
+    // DecompressionException if a piece is damaged.
+    size_t read(char* data, size_t size);
+
+private:
+    ParallelDecompressingStream(const ParallelDecompressingStream&);
+    ParallelDecompressingStream& operator=(const ParallelDecompressingStream&);
+
+    // Consecutive pieces decompressed in one go
+    struct Batch
+    {
+        size_t offset;
+        size_t size;
+        uint64_t contentSize;
+    };
+
+    struct Slot
+    {
+        Slot() : ready(false) {}
+
+        string text;
+        bool ready;
+        exception_ptr error;
+    };
+
+    struct Mapping;
+
+    void decompress();
+
+    string m_filePath;
+    compressionFormat m_compression;
+    unique_ptr<Mapping> m_mapping;
+    vector<Batch> m_batches;
+
+    mutex m_mutex;
+    condition_variable m_changed;
+    // The batch the next read takes from its slot, and the next one a
+    // thread decompresses into the slot of its index modulo the slot count
+    size_t m_readBatch;
+    size_t m_nextBatch;
+    vector<Slot> m_slots;
+    bool m_stopped;
+    vector<thread> m_threads;
+
+    // The text of the batch being read
+    string m_text;
+    size_t m_textOffset;
+};
+
+// Compresses the buffers a BufferedWriter flushes on a thread of its own and
+// writes them to file, so that compressing one buffer overlaps formatting
+// the next.  At most BlocksAhead buffers wait to be compressed.
+class CompressingOutput
+{
+public:
+    static const size_t BlocksAhead = 2;
+
+    // The file must be open for writing in binary mode and stays open
+    CompressingOutput(FILE* file, compressionFormat compression);
+    ~CompressingOutput();
+
+    // Takes over the first size bytes of buffer and hands back a spare
+    // buffer of the same size, so that the caller never copies or allocates
+    void write(vector<char>& buffer, size_t size);
+
+    // Compresses what is left and ends the stream.  Returns false if the
+    // compression or any write of the file failed.
+    bool finish();
+
+private:
+    CompressingOutput(const CompressingOutput&);
+    CompressingOutput& operator=(const CompressingOutput&);
+
+    void compress();
+
+    FILE* m_file;
+    compressionFormat m_compression;
+
+    mutex m_mutex;
+    condition_variable m_changed;
+    deque< vector<char> > m_blocks;
+    vector< vector<char> > m_spareBlocks;
+    bool m_finishing;
+    bool m_failed;
+    thread m_thread;
+};
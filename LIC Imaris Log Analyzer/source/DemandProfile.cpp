@@ -0,0 +1,219 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "DemandProfile.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+    const long long HourSeconds = 3600;
+
+    // Values saved for every cell with any demand: product, cell, closed
+    // check-outs, check-ins, denials, the holding time bucket counts, the
+    // sum of the holding times and the bits of the sum of their squares
+    const size_t CellValues = 5 + DemandProfile::HoldingBuckets + 2;
+
+    long long floorDivide(long long value, long long divisor)
+    {
+        return value / divisor - ((value % divisor < 0) ? 1 : 0);
+    }
+}
+
+const long long DemandProfile::HoldingBucketEnds[HoldingBuckets - 1] = { 60, 300, 900, 1800, 3600, 7200, 14400, 28800, 86400 };
+
+void DemandProfile::clear()
+{
+    m_cells.clear();
+}
+
+size_t DemandProfile::memoryBytes() const
+{
+    return heapBytes(m_cells);
+}
+
+void DemandProfile::resize(size_t products)
+{
+    if (products * Cells > m_cells.size())
+    {
+        CellDemand none;
+        memset(&none, 0, sizeof(none));
+        m_cells.resize(products * Cells, none);
+    }
+}
+
+void DemandProfile::addSession(size_t product, long long checkOut, long long checkIn, bool closed)
+{
+    CellDemand& checkOutCell = m_cells.at(product * Cells + UsageHeatmap::cellOf(checkOut));
+    ++checkOutCell.checkOuts;
+    if (! closed)
+    {
+        return;
+    }
+    long long seconds = checkIn - checkOut;
+    ++checkOutCell.closedCheckOuts;
+    ++checkOutCell.holdingCounts[holdingBucket(seconds)];
+    checkOutCell.holdingSeconds += seconds;
+    checkOutCell.holdingSquares += static_cast<double>(seconds) * static_cast<double>(seconds);
+    ++m_cells.at(product * Cells + UsageHeatmap::cellOf(checkIn)).checkIns;
+}
+
+void DemandProfile::addDenials(size_t product, long long time, uint64_t requests)
+{
+    m_cells.at(product * Cells + UsageHeatmap::cellOf(time)).denials += requests;
+}
+
+size_t DemandProfile::products() const
+{
+    return m_cells.size() / Cells;
+}
+
+uint64_t DemandProfile::checkOuts(size_t product, size_t cell) const
+{
+    return m_cells.at(product * Cells + cell).checkOuts;
+}
+
+uint64_t DemandProfile::checkIns(size_t product, size_t cell) const
+{
+    return m_cells.at(product * Cells + cell).checkIns;
+}
+
+uint64_t DemandProfile::denials(size_t product, size_t cell) const
+{
+    return m_cells.at(product * Cells + cell).denials;
+}
+
+uint64_t DemandProfile::closedSessions(size_t product, size_t cell) const
+{
+    return m_cells.at(product * Cells + cell).closedCheckOuts;
+}
+
+double DemandProfile::meanHolding(size_t product, size_t cell) const
+{
+    const CellDemand& demand = m_cells.at(product * Cells + cell);
+    if (demand.closedCheckOuts == 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(demand.holdingSeconds) / static_cast<double>(demand.closedCheckOuts);
+}
+
+double DemandProfile::holdingDeviation(size_t product, size_t cell) const
+{
+    const CellDemand& demand = m_cells.at(product * Cells + cell);
+    if (demand.closedCheckOuts == 0)
+    {
+        return 0.0;
+    }
+    double mean = meanHolding(product, cell);
+    double variance = demand.holdingSquares / static_cast<double>(demand.closedCheckOuts) - mean * mean;
+    return sqrt(max(variance, 0.0));
+}
+
+uint64_t DemandProfile::holdingCount(size_t product, size_t cell, size_t bucket) const
+{
+    return m_cells.at(product * Cells + cell).holdingCounts[bucket];
+}
+
+// The hours [from, to] touches are numbered from the epoch on; every cell
+// gets one of each full week of them and the hours left over go to the
+// cells from that of from on
+uint64_t DemandProfile::observedHours(size_t cell, long long from, long long to)
+{
+    if (from > to)
+    {
+        return 0;
+    }
+    uint64_t hours = static_cast<uint64_t>(floorDivide(to, HourSeconds) - floorDivide(from, HourSeconds) + 1);
+    size_t firstCell = UsageHeatmap::cellOf(from);
+    size_t offset = (cell + Cells - firstCell) % Cells;
+    return hours / Cells + ((offset < hours % Cells) ? 1 : 0);
+}
+
+void DemandProfile::save(Checkpoint& checkpoint) const
+{
+    checkpoint.demandProfile.clear();
+    for (size_t index = 0; index < m_cells.size(); ++index)
+    {
+        const CellDemand& demand = m_cells[index];
+        if (demand.closedCheckOuts == 0 && demand.checkIns == 0 && demand.denials == 0)
+        {
+            continue;
+        }
+        int64_t squares;
+        memcpy(&squares, &demand.holdingSquares, sizeof(squares));
+        checkpoint.demandProfile.push_back(static_cast<int64_t>(index / Cells));
+        checkpoint.demandProfile.push_back(static_cast<int64_t>(index % Cells));
+        checkpoint.demandProfile.push_back(static_cast<int64_t>(demand.closedCheckOuts));
+        checkpoint.demandProfile.push_back(static_cast<int64_t>(demand.checkIns));
+        checkpoint.demandProfile.push_back(static_cast<int64_t>(demand.denials));
+        for (size_t bucket = 0; bucket < HoldingBuckets; ++bucket)
+        {
+            checkpoint.demandProfile.push_back(static_cast<int64_t>(demand.holdingCounts[bucket]));
+        }
+        checkpoint.demandProfile.push_back(demand.holdingSeconds);
+        checkpoint.demandProfile.push_back(squares);
+    }
+}
+
+bool DemandProfile::restore(const Checkpoint& checkpoint)
+{
+    const vector<int64_t>& values = checkpoint.demandProfile;
+    if (values.size() % CellValues != 0)
+    {
+        return false;
+    }
+    for (size_t value = 0; value < values.size(); value += CellValues)
+    {
+        if (values[value] < 0 || static_cast<uint64_t>(values[value]) >= checkpoint.products.size() ||
+            values[value + 1] < 0 || static_cast<uint64_t>(values[value + 1]) >= Cells)
+        {
+            return false;
+        }
+    }
+
+    resize(checkpoint.products.size());
+    for (size_t value = 0; value < values.size(); value += CellValues)
+    {
+        CellDemand& demand = m_cells[static_cast<size_t>(values[value]) * Cells + static_cast<size_t>(values[value + 1])];
+        demand.checkOuts = demand.closedCheckOuts = static_cast<uint64_t>(values[value + 2]);
+        demand.checkIns = static_cast<uint64_t>(values[value + 3]);
+        demand.denials = static_cast<uint64_t>(values[value + 4]);
+        for (size_t bucket = 0; bucket < HoldingBuckets; ++bucket)
+        {
+            demand.holdingCounts[bucket] = static_cast<uint64_t>(values[value + 5 + bucket]);
+        }
+        demand.holdingSeconds = values[value + 5 + HoldingBuckets];
+        memcpy(&demand.holdingSquares, &values[value + 6 + HoldingBuckets], sizeof(demand.holdingSquares));
+    }
+    return true;
+}
+
+size_t DemandProfile::holdingBucket(long long seconds)
+{
+    return static_cast<size_t>(upper_bound(HoldingBucketEnds, HoldingBucketEnds + HoldingBuckets - 1, seconds) - HoldingBucketEnds);
+}
@@ -0,0 +1,104 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+#include "UsageHeatmap.h"
+
+using namespace std;
+
+// Check-out demand by product and hour of the week, the input of demand
+// forecasts: the check-outs (arrivals), check-ins (departures) and denied
+// requests of every cell, and the holding times of the sessions checked out
+// in it as their mean, standard deviation and counts in fixed buckets.  The
+// session pass fills it as it pairs the sessions, so its size depends on
+// the products alone.  The cells are those of the usage heatmap; a session
+// still checked out counts as an arrival but has no holding time yet.
+class DemandProfile
+{
+    public:
+        static const size_t Cells = UsageHeatmap::Cells;
+        static const size_t HoldingBuckets = 10;
+        // The upper ends of the holding time buckets but the last, in
+        // seconds: 1, 5, 15 and 30 minutes, 1, 2, 4, 8 and 24 hours
+        static const long long HoldingBucketEnds[HoldingBuckets - 1];
+
+        DemandProfile() {}
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Room for the product ids below products; the counts already made
+        // are kept
+        void resize(size_t products);
+
+        // The session pass, which starts over from the checkpoint every
+        // run: a session checked out at checkOut, and if closed, checked in
+        // at checkIn; and denied requests of the product at time
+        void addSession(size_t product, long long checkOut, long long checkIn, bool closed);
+        void addDenials(size_t product, long long time, uint64_t requests);
+
+        size_t products() const;
+        uint64_t checkOuts(size_t product, size_t cell) const;
+        uint64_t checkIns(size_t product, size_t cell) const;
+        uint64_t denials(size_t product, size_t cell) const;
+        // The closed sessions checked out in the cell, the mean and the
+        // standard deviation of their holding times in seconds (0 if none)
+        // and their number in a holding time bucket
+        uint64_t closedSessions(size_t product, size_t cell) const;
+        double meanHolding(size_t product, size_t cell) const;
+        double holdingDeviation(size_t product, size_t cell) const;
+        uint64_t holdingCount(size_t product, size_t cell, size_t bucket) const;
+
+        // The hours of the week's cell that fall into [from, to], for the
+        // rates per hour
+        static uint64_t observedHours(size_t cell, long long from, long long to);
+
+        // The closed sessions and the denials of every cell with any, for a
+        // checkpoint; restore is false if the checkpoint does not fit the
+        // products
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+    private:
+        // The closed check-outs are counted apart, as only they go into a
+        // checkpoint
+        struct CellDemand
+        {
+            uint64_t checkOuts;
+            uint64_t closedCheckOuts;
+            uint64_t checkIns;
+            uint64_t denials;
+            uint64_t holdingCounts[HoldingBuckets];
+            long long holdingSeconds;
+            double holdingSquares;
+        };
+
+        static size_t holdingBucket(long long seconds);
+
+        // The cells of product p are at p * Cells on
+        vector<CellDemand> m_cells;
+};
@@ -0,0 +1,148 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "DistinctSketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // The number of leading zero bits of a nonzero value
+    inline size_t leadingZeros(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - index;
+#else
+        return static_cast<size_t>(__builtin_clzll(value));
+#endif
+    }
+}
+
+DistinctSketch::DistinctSketch()
+    : m_registers(Registers, 0)
+{
+}
+
+// FNV-1a, then the splitmix64 finalizer, which spreads its poorly mixed
+// high bits over the register index
+uint64_t DistinctSketch::hashName(string_view name)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t index = 0; index < name.size(); ++index)
+    {
+        hash ^= static_cast<unsigned char>(name[index]);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+// The high bits choose the register, which keeps the longest run of
+// leading zeros of the rest plus one
+void DistinctSketch::add(uint64_t hash)
+{
+    size_t index = static_cast<size_t>(hash >> (64 - Precision));
+    uint64_t rest = (hash << Precision) | (uint64_t(1) << (Precision - 1));
+    uint8_t rank = static_cast<uint8_t>(leadingZeros(rest) + 1);
+    if (rank > m_registers[index])
+    {
+        m_registers[index] = rank;
+    }
+}
+
+void DistinctSketch::addName(string_view name)
+{
+    add(hashName(name));
+}
+
+void DistinctSketch::merge(const DistinctSketch& other)
+{
+    for (size_t index = 0; index < Registers; ++index)
+    {
+        m_registers[index] = max(m_registers[index], other.m_registers[index]);
+    }
+}
+
+bool DistinctSketch::empty() const
+{
+    return find_if(m_registers.begin(), m_registers.end(), [](uint8_t rank) { return rank != 0; }) == m_registers.end();
+}
+
+// The harmonic mean of the registers, with linear counting over the empty
+// registers for the small counts where that is biased.  64-bit hashes do
+// not need a correction for large counts.
+size_t DistinctSketch::estimate() const
+{
+    const double registers = static_cast<double>(Registers);
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (size_t index = 0; index < Registers; ++index)
+    {
+        sum += ldexp(1.0, -static_cast<int>(m_registers[index]));
+        zeros += (m_registers[index] == 0);
+    }
+
+    double alpha = 0.7213 / (1.0 + 1.079 / registers);
+    double estimate = alpha * registers * registers / sum;
+    if (estimate <= 2.5 * registers && zeros > 0)
+    {
+        estimate = registers * log(registers / static_cast<double>(zeros));
+    }
+    return static_cast<size_t>(estimate + 0.5);
+}
+
+void DistinctSketch::save(string& registers) const
+{
+    registers.append(m_registers.begin(), m_registers.end());
+}
+
+bool DistinctSketch::restore(string_view registers)
+{
+    if (registers.size() != Registers)
+    {
+        return false;
+    }
+    for (size_t index = 0; index < Registers; ++index)
+    {
+        uint8_t rank = static_cast<uint8_t>(registers[index]);
+        if (rank > 64 - Precision + 1)
+        {
+            return false;
+        }
+        m_registers[index] = rank;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// HyperLogLog estimate of the number of distinct names added, in a fixed
+// 4 KiB of registers however many names there are.  The standard error is
+// about 1.6%; counts of a few hundred names come from linear counting over
+// the empty registers and are close to exact.  Sketches of the same names
+// from other logs or threads merge by taking the larger register.
+class DistinctSketch
+{
+    public:
+        static const size_t Precision = 12;
+        static const size_t Registers = size_t(1) << Precision;
+
+        DistinctSketch();
+
+        // The 64-bit hash a name is added by
+        static uint64_t hashName(string_view name);
+
+        void add(uint64_t hash);
+        void addName(string_view name);
+        void merge(const DistinctSketch& other);
+
+        bool empty() const;
+        // The estimated number of distinct names, rounded
+        size_t estimate() const;
+
+        // Appends the registers to a saved summary, and takes them back
+        // from the Registers bytes there; restore is false if they are not
+        // registers of a sketch
+        void save(string& registers) const;
+        bool restore(string_view registers);
+
+    private:
+        vector<uint8_t> m_registers;
+};
@@ -0,0 +1,199 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "DurationHistograms.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // 64 exact buckets, then 32 for each power of two from 2^6 up to 2^40
+    // seconds; longer sessions count in the last bucket
+    const size_t SubBucketBits = 5;
+    const size_t SubBuckets = size_t(1) << SubBucketBits;
+    const size_t ExactBuckets = 2 * SubBuckets;
+    const size_t ExactBits = SubBucketBits + 1;
+    const size_t LongestBits = 40;
+    const size_t Buckets = ExactBuckets + (LongestBits - ExactBits) * SubBuckets;
+
+    // The index of the highest set bit of a nonzero value
+    inline size_t highestBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return index;
+#else
+        return 63 - static_cast<size_t>(__builtin_clzll(value));
+#endif
+    }
+}
+
+void DurationHistograms::clear()
+{
+    m_counts.clear();
+    m_sessions.clear();
+    m_longest.clear();
+}
+
+size_t DurationHistograms::memoryBytes() const
+{
+    return heapBytes(m_counts) + heapBytes(m_sessions) + heapBytes(m_longest);
+}
+
+void DurationHistograms::resize(size_t products)
+{
+    if (products > m_sessions.size())
+    {
+        m_counts.resize(products * Buckets, 0);
+        m_sessions.resize(products, 0);
+        m_longest.resize(products, 0);
+    }
+}
+
+void DurationHistograms::add(size_t product, long long seconds)
+{
+    seconds = max(seconds, 0LL);
+    ++m_counts.at(product * Buckets + bucket(seconds));
+    ++m_sessions.at(product);
+    m_longest.at(product) = max(m_longest.at(product), seconds);
+}
+
+size_t DurationHistograms::products() const
+{
+    return m_sessions.size();
+}
+
+uint64_t DurationHistograms::sessions(size_t product) const
+{
+    return m_sessions.at(product);
+}
+
+long long DurationHistograms::longest(size_t product) const
+{
+    return m_longest.at(product);
+}
+
+long long DurationHistograms::percentile(size_t product, double percent) const
+{
+    uint64_t sessions = m_sessions.at(product);
+    if (sessions == 0)
+    {
+        return 0;
+    }
+
+    // The rank of the session at the percentile, from 1
+    double rank = ceil(min(max(percent, 0.0), 100.0) / 100.0 * static_cast<double>(sessions));
+    uint64_t wanted = max(static_cast<uint64_t>(rank), uint64_t(1));
+    uint64_t counted = 0;
+    const uint64_t* counts = &m_counts.at(product * Buckets);
+    for (size_t index = 0; index < Buckets; ++index)
+    {
+        counted += counts[index];
+        if (counted >= wanted)
+        {
+            return min(bucketEnd(index), m_longest.at(product));
+        }
+    }
+    return m_longest.at(product);
+}
+
+void DurationHistograms::entries(vector<CheckpointEntry>& counts, vector<int64_t>& longest) const
+{
+    counts.clear();
+    for (size_t index = 0; index < m_counts.size(); ++index)
+    {
+        if (m_counts[index] > 0)
+        {
+            CheckpointEntry entry = { index / Buckets, index % Buckets, static_cast<int64_t>(m_counts[index]) };
+            counts.push_back(entry);
+        }
+    }
+    longest.assign(m_longest.begin(), m_longest.end());
+}
+
+bool DurationHistograms::addEntries(const vector<CheckpointEntry>& counts, const vector<int64_t>& longest)
+{
+    for (size_t entry = 0; entry < counts.size(); ++entry)
+    {
+        if (counts[entry].row >= m_sessions.size() || counts[entry].product >= Buckets || counts[entry].value < 0)
+        {
+            return false;
+        }
+    }
+    if (longest.size() > m_sessions.size())
+    {
+        return false;
+    }
+
+    for (size_t entry = 0; entry < counts.size(); ++entry)
+    {
+        size_t product = static_cast<size_t>(counts[entry].row);
+        m_counts[product * Buckets + static_cast<size_t>(counts[entry].product)] += static_cast<uint64_t>(counts[entry].value);
+        m_sessions[product] += static_cast<uint64_t>(counts[entry].value);
+    }
+    for (size_t product = 0; product < longest.size(); ++product)
+    {
+        m_longest[product] = max(m_longest[product], static_cast<long long>(longest[product]));
+    }
+    return true;
+}
+
+// A length from 2^e on falls in one of the 32 buckets of [2^e, 2^(e + 1)),
+// picked by its 5 bits below the highest
+size_t DurationHistograms::bucket(long long seconds)
+{
+    uint64_t value = static_cast<uint64_t>(seconds);
+    if (value < ExactBuckets)
+    {
+        return static_cast<size_t>(value);
+    }
+    size_t bit = highestBit(value);
+    if (bit >= LongestBits)
+    {
+        return Buckets - 1;
+    }
+    size_t subBucket = static_cast<size_t>(value >> (bit - SubBucketBits)) - SubBuckets;
+    return ExactBuckets + (bit - ExactBits) * SubBuckets + subBucket;
+}
+
+// The longest length that falls in the bucket
+long long DurationHistograms::bucketEnd(size_t bucket)
+{
+    if (bucket < ExactBuckets)
+    {
+        return static_cast<long long>(bucket);
+    }
+    size_t offset = bucket - ExactBuckets;
+    size_t bit = ExactBits + offset / SubBuckets;
+    uint64_t start = static_cast<uint64_t>(SubBuckets + offset % SubBuckets) << (bit - SubBucketBits);
+    return static_cast<long long>(start + (uint64_t(1) << (bit - SubBucketBits)) - 1);
+}
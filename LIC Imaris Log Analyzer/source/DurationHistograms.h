@@ -0,0 +1,77 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+
+using namespace std;
+
+// The session lengths of every product as counts in log-scaled buckets, so
+// that the typical and the longest sessions are known without keeping the
+// sessions.  Lengths below 64 seconds have a bucket each; above, every
+// power of two is split into 32 buckets, which keeps a percentile within
+// about 3% of the exact one.  A product takes the same fixed number of
+// buckets however many sessions it has.
+class DurationHistograms
+{
+    public:
+        DurationHistograms() {}
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Room for the product ids below products; the counts already made
+        // are kept
+        void resize(size_t products);
+
+        // Counts a session of the product lasting seconds
+        void add(size_t product, long long seconds);
+
+        size_t products() const;
+        uint64_t sessions(size_t product) const;
+        long long longest(size_t product) const;
+
+        // The length percent of the product's sessions do not exceed, as
+        // the longest length of its bucket but no longer than the longest
+        // session; 0 without sessions
+        long long percentile(size_t product, double percent) const;
+
+        // The nonzero counts as entries of product, bucket and count, and
+        // the longest session of every product, e.g. for a checkpoint
+        void entries(vector<CheckpointEntry>& counts, vector<int64_t>& longest) const;
+        // Adds entries made by entries(); false if one is out of range
+        bool addEntries(const vector<CheckpointEntry>& counts, const vector<int64_t>& longest);
+
+    private:
+        static size_t bucket(long long seconds);
+        static long long bucketEnd(size_t bucket);
+
+        // The counts of product p are m_counts[p * Buckets] on
+        vector<uint64_t> m_counts;
+        vector<uint64_t> m_sessions;
+        vector<long long> m_longest;
+};
@@ -0,0 +1,671 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "EventCache.h"
+#include "Checkpoint.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <boost/filesystem/operations.hpp>
+
+using namespace std;
+
+namespace
+{
+    const char EventCacheMagic[8] = { 'L', 'I', 'C', 'E', 'V', 'C', '0', '3' };
+    const char RollupCacheMagic[8] = { 'L', 'I', 'C', 'R', 'O', 'L', 'L', '2' };
+    const char LogCatalogMagic[8] = { 'L', 'I', 'C', 'C', 'A', 'T', 'L', '2' };
+
+    const uint32_t NoCachedId = 0xFFFFFFFFu;
+
+    // How much of each end of the log is hashed into its key
+    const size_t KeyHashedLength = 4096;
+
+    // The key of the log as it is now: its absolute path, size and
+    // modification time, and hashes of its first and last few kilobytes.
+    // The hashes tell a log rewritten within the resolution of its
+    // modification time, or copied over with its time preserved, from the
+    // one that was cached, at the cost of two small reads.
+    struct InputKey
+    {
+        string path;
+        uint64_t size;
+        int64_t modified;
+        uint64_t headHash;
+        uint64_t tailHash;
+
+        bool operator==(const InputKey& other) const
+        {
+            return path == other.path && size == other.size && modified == other.modified &&
+                   headHash == other.headHash && tailHash == other.tailHash;
+        }
+    };
+
+    // Hashes length bytes of the log from offset
+    bool hashInput(ifstream& input, uint64_t offset, size_t length, uint64_t& hash)
+    {
+        char data[KeyHashedLength];
+        input.seekg(static_cast<streamoff>(offset));
+        input.read(data, static_cast<streamsize>(length));
+        hash = checkpointHash(data, length);
+        return static_cast<size_t>(input.gcount()) == length;
+    }
+
+    // Returns false if the log cannot be inspected
+    bool inputKey(const string& inputFilePath, InputKey& key)
+    {
+        boost::system::error_code error;
+        key.path = boost::filesystem::absolute(inputFilePath).string();
+        key.size = boost::filesystem::file_size(inputFilePath, error);
+        if (error)
+        {
+            return false;
+        }
+        key.modified = static_cast<int64_t>(boost::filesystem::last_write_time(inputFilePath, error));
+        if (error)
+        {
+            return false;
+        }
+
+        ifstream input(inputFilePath, ios::binary);
+        size_t hashedLength = static_cast<size_t>(min<uint64_t>(key.size, KeyHashedLength));
+        return input.is_open() &&
+               hashInput(input, 0, hashedLength, key.headHash) &&
+               hashInput(input, key.size - hashedLength, hashedLength, key.tailHash);
+    }
+
+    // Packs the columns into a buffer that is written in one go
+    class CacheWriter
+    {
+        public:
+            void writeFixed(uint64_t value, size_t bytes)
+            {
+                for (size_t byte = 0; byte < bytes; ++byte)
+                {
+                    m_buffer.push_back(static_cast<char>(value >> (8 * byte)));
+                }
+            }
+
+            void writeBytes(const char* data, size_t size)
+            {
+                m_buffer.append(data, size);
+            }
+
+            void writeString(const string& text)
+            {
+                writeFixed(text.size(), 4);
+                m_buffer.append(text);
+            }
+
+            void writeStrings(const vector<string>& strings)
+            {
+                writeFixed(strings.size(), 8);
+                for (size_t text = 0; text < strings.size(); ++text)
+                {
+                    writeString(strings.at(text));
+                }
+            }
+
+            template <class T>
+            void writeColumn(const vector<T>& values, size_t bytes)
+            {
+                for (size_t value = 0; value < values.size(); ++value)
+                {
+                    writeFixed(static_cast<uint64_t>(values[value]), bytes);
+                }
+            }
+
+            void writeIds(const vector<size_t>& ids)
+            {
+                for (size_t id = 0; id < ids.size(); ++id)
+                {
+                    writeFixed(ids[id] == NoId ? NoCachedId : static_cast<uint32_t>(ids[id]), 4);
+                }
+            }
+
+            // Rows are 8 bytes wide, unlike the ids of the interned names,
+            // so that a log of more than 4G events can be cached
+            void writeRows(const vector<size_t>& rows)
+            {
+                writeFixed(rows.size(), 8);
+                writeColumn(rows, 8);
+            }
+
+            const string& buffer() const { return m_buffer; }
+
+        private:
+            string m_buffer;
+    };
+
+    // Reads the columns back from the mapped cache.  Any read past the end
+    // marks the reader bad and returns zeros.
+    class CacheReader
+    {
+        public:
+            CacheReader(const char* data, size_t size) : m_data(data), m_size(size), m_offset(0), m_good(true) {}
+
+            bool good() const { return m_good; }
+            bool atEnd() const { return m_offset == m_size; }
+
+            bool readBytes(void* data, size_t size)
+            {
+                if (! m_good || size > m_size - m_offset)
+                {
+                    m_good = false;
+                    return false;
+                }
+                memcpy(data, m_data + m_offset, size);
+                m_offset += size;
+                return true;
+            }
+
+            uint64_t readFixed(size_t bytes)
+            {
+                if (! m_good || bytes > m_size - m_offset)
+                {
+                    m_good = false;
+                    return 0;
+                }
+                const unsigned char* data = reinterpret_cast<const unsigned char*>(m_data + m_offset);
+                uint64_t value = 0;
+                for (size_t byte = 0; byte < bytes; ++byte)
+                {
+                    value |= static_cast<uint64_t>(data[byte]) << (8 * byte);
+                }
+                m_offset += bytes;
+                return value;
+            }
+
+            // A count of items of at least itemSize bytes each that must fit
+            // into the rest of the file
+            size_t readCount(size_t itemSize)
+            {
+                uint64_t count = readFixed(8);
+                if (count > (m_size - m_offset) / itemSize)
+                {
+                    m_good = false;
+                    return 0;
+                }
+                return static_cast<size_t>(count);
+            }
+
+            string readString()
+            {
+                size_t size = static_cast<size_t>(readFixed(4));
+                if (! m_good || size > m_size - m_offset)
+                {
+                    m_good = false;
+                    return string();
+                }
+                string text(m_data + m_offset, size);
+                m_offset += size;
+                return text;
+            }
+
+            void readStrings(vector<string>& strings)
+            {
+                strings.resize(readCount(4));
+                for (size_t text = 0; text < strings.size() && m_good; ++text)
+                {
+                    strings.at(text) = readString();
+                }
+            }
+
+            template <class T>
+            void readColumn(vector<T>& values, size_t count, size_t bytes)
+            {
+                if (! m_good || count > (m_size - m_offset) / bytes)
+                {
+                    m_good = false;
+                    return;
+                }
+                values.resize(count);
+                for (size_t value = 0; value < count; ++value)
+                {
+                    uint64_t packed = readFixed(bytes);
+                    // Sign-extend the values narrower than 64 bits
+                    if (bytes < 8 && (packed >> (8 * bytes - 1)) != 0)
+                    {
+                        packed |= ~0ull << (8 * bytes);
+                    }
+                    values[value] = static_cast<T>(static_cast<int64_t>(packed));
+                }
+            }
+
+            void readIds(vector<size_t>& ids, size_t count)
+            {
+                if (! m_good || count > (m_size - m_offset) / 4)
+                {
+                    m_good = false;
+                    return;
+                }
+                ids.resize(count);
+                for (size_t id = 0; id < count; ++id)
+                {
+                    uint32_t packed = static_cast<uint32_t>(readFixed(4));
+                    ids[id] = packed == NoCachedId ? NoId : packed;
+                }
+            }
+
+            void readRows(vector<size_t>& rows)
+            {
+                readColumn(rows, readCount(8), 8);
+            }
+
+        private:
+            const char* m_data;
+            size_t m_size;
+            size_t m_offset;
+            bool m_good;
+    };
+
+    // Checks the magic and the key of a mapped cache against the log as it
+    // is now
+    bool readHeader(CacheReader& file, const char (&magic)[8], const string& inputFilePath)
+    {
+        InputKey key;
+        char fileMagic[sizeof(magic)];
+        if (! inputKey(inputFilePath, key) ||
+            ! file.readBytes(fileMagic, sizeof(fileMagic)) || memcmp(fileMagic, magic, sizeof(magic)) != 0)
+        {
+            return false;
+        }
+        InputKey cachedKey;
+        cachedKey.path = file.readString();
+        cachedKey.size = file.readFixed(8);
+        cachedKey.modified = static_cast<int64_t>(file.readFixed(8));
+        cachedKey.headHash = file.readFixed(8);
+        cachedKey.tailHash = file.readFixed(8);
+        return file.good() && cachedKey == key;
+    }
+
+    bool writeHeader(CacheWriter& file, const char (&magic)[8], const string& inputFilePath)
+    {
+        InputKey key;
+        if (! inputKey(inputFilePath, key))
+        {
+            return false;
+        }
+        file.writeBytes(magic, sizeof(magic));
+        file.writeString(key.path);
+        file.writeFixed(key.size, 8);
+        file.writeFixed(static_cast<uint64_t>(key.modified), 8);
+        file.writeFixed(key.headHash, 8);
+        file.writeFixed(key.tailHash, 8);
+        return true;
+    }
+
+    // Writes the packed cache to a temporary file and renames it
+    bool writeCacheFile(const string& cachePath, const string& buffer)
+    {
+        string temporaryPath = cachePath + ".tmp";
+        FILE* output = fopen(temporaryPath.c_str(), "wb");
+        if (output == NULL)
+        {
+            return false;
+        }
+        bool good = fwrite(buffer.data(), 1, buffer.size(), output) == buffer.size();
+        if (fclose(output) != 0)
+        {
+            good = false;
+        }
+
+        boost::system::error_code error;
+        if (good)
+        {
+            boost::filesystem::rename(temporaryPath, cachePath, error);
+        }
+        if (! good || error)
+        {
+            boost::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    // A column of 64-bit values with its length
+    void writeValues(CacheWriter& file, const vector<int64_t>& values)
+    {
+        file.writeFixed(values.size(), 8);
+        file.writeColumn(values, 8);
+    }
+
+    void readValues(CacheReader& file, vector<int64_t>& values)
+    {
+        size_t count = file.readCount(8);
+        file.readColumn(values, count, 8);
+    }
+}
+
+EventCache::EventCache()
+    : eventYear(0),
+      endTimeRow(NoId)
+{
+}
+
+bool EventCache::load(const string& cachePath, const string& inputFilePath)
+{
+    if (! fileExists(cachePath))
+    {
+        return false;
+    }
+
+    MappedFile cacheFile;
+    try
+    {
+        cacheFile.open(cachePath);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    CacheReader file(cacheFile.data(), cacheFile.size());
+    if (! readHeader(file, EventCacheMagic, inputFilePath))
+    {
+        return false;
+    }
+
+    eventYear = static_cast<int32_t>(file.readFixed(4));
+    serverName = file.readString();
+    endTimeRow = file.readFixed(8);
+
+    file.readStrings(products);
+    file.readStrings(versions);
+    file.readStrings(users);
+    file.readStrings(hosts);
+    file.readStrings(handles);
+    file.readStrings(servers);
+
+    // One byte of type and 36 bytes of fields per event
+    size_t rows = file.readCount(37);
+    vector<uint8_t> types;
+    file.readColumn(types, rows, 1);
+    events.types.resize(types.size());
+    for (size_t row = 0; row < types.size(); ++row)
+    {
+        if (types[row] > ProductEvent)
+        {
+            return false;
+        }
+        events.types[row] = static_cast<eventType>(types[row]);
+    }
+    file.readColumn(events.timestamps, rows, 8);
+    file.readIds(events.products, rows);
+    file.readIds(events.versions, rows);
+    file.readIds(events.users, rows);
+    file.readIds(events.hosts, rows);
+    file.readColumn(events.counts, rows, 4);
+    file.readIds(events.handles, rows);
+    file.readColumn(events.reserved, rows, 4);
+
+    file.readRows(denialRows);
+    file.readRows(shutdownRows);
+    file.readRows(startRows);
+
+    return file.good() && file.atEnd();
+}
+
+bool EventCache::save(const string& cachePath, const string& inputFilePath) const
+{
+    CacheWriter file;
+    if (! writeHeader(file, EventCacheMagic, inputFilePath))
+    {
+        return false;
+    }
+
+    file.writeFixed(static_cast<uint32_t>(eventYear), 4);
+    file.writeString(serverName);
+    file.writeFixed(endTimeRow, 8);
+
+    file.writeStrings(products);
+    file.writeStrings(versions);
+    file.writeStrings(users);
+    file.writeStrings(hosts);
+    file.writeStrings(handles);
+    file.writeStrings(servers);
+
+    file.writeFixed(events.size(), 8);
+    file.writeColumn(events.types, 1);
+    file.writeColumn(events.timestamps, 8);
+    file.writeIds(events.products);
+    file.writeIds(events.versions);
+    file.writeIds(events.users);
+    file.writeIds(events.hosts);
+    file.writeColumn(events.counts, 4);
+    file.writeIds(events.handles);
+    file.writeColumn(events.reserved, 4);
+
+    file.writeRows(denialRows);
+    file.writeRows(shutdownRows);
+    file.writeRows(startRows);
+
+    return writeCacheFile(cachePath, file.buffer());
+}
+
+bool RollupCache::load(const string& cachePath, const string& inputFilePath)
+{
+    if (! fileExists(cachePath))
+    {
+        return false;
+    }
+
+    MappedFile cacheFile;
+    try
+    {
+        cacheFile.open(cachePath);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    CacheReader file(cacheFile.data(), cacheFile.size());
+    if (! readHeader(file, RollupCacheMagic, inputFilePath))
+    {
+        return false;
+    }
+
+    file.readStrings(products);
+    file.readStrings(users);
+    file.readStrings(hosts);
+    readValues(file, usage);
+    readValues(file, observed);
+    readValues(file, userDurations);
+    readValues(file, hostDurations);
+
+    return file.good() && file.atEnd();
+}
+
+bool RollupCache::save(const string& cachePath, const string& inputFilePath) const
+{
+    CacheWriter file;
+    if (! writeHeader(file, RollupCacheMagic, inputFilePath))
+    {
+        return false;
+    }
+
+    file.writeStrings(products);
+    file.writeStrings(users);
+    file.writeStrings(hosts);
+    writeValues(file, usage);
+    writeValues(file, observed);
+    writeValues(file, userDurations);
+    writeValues(file, hostDurations);
+
+    return writeCacheFile(cachePath, file.buffer());
+}
+
+bool LogCatalog::load(const string& catalogPath)
+{
+    m_entries.clear();
+    if (! fileExists(catalogPath))
+    {
+        return false;
+    }
+
+    MappedFile catalogFile;
+    try
+    {
+        catalogFile.open(catalogPath);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    CacheReader file(catalogFile.data(), catalogFile.size());
+    char fileMagic[sizeof(LogCatalogMagic)];
+    if (! file.readBytes(fileMagic, sizeof(fileMagic)) || memcmp(fileMagic, LogCatalogMagic, sizeof(fileMagic)) != 0)
+    {
+        return false;
+    }
+
+    // Two strings, seven numbers and two lists make at least 80 bytes
+    size_t entries = file.readCount(80);
+    for (size_t log = 0; log < entries && file.good(); ++log)
+    {
+        CatalogEntry entry;
+        entry.inputFilePath = file.readString();
+        entry.size = file.readFixed(8);
+        entry.modified = static_cast<int64_t>(file.readFixed(8));
+        entry.headHash = file.readFixed(8);
+        entry.tailHash = file.readFixed(8);
+        entry.firstTime = static_cast<long long>(file.readFixed(8));
+        entry.lastTime = static_cast<long long>(file.readFixed(8));
+        file.readStrings(entry.servers);
+        file.readStrings(entry.products);
+        entry.eventCount = file.readFixed(8);
+        entry.cachePath = file.readString();
+        m_entries[entry.inputFilePath] = move(entry);
+    }
+
+    if (! file.good() || ! file.atEnd())
+    {
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool LogCatalog::save(const string& catalogPath) const
+{
+    CacheWriter file;
+    file.writeBytes(LogCatalogMagic, sizeof(LogCatalogMagic));
+    file.writeFixed(m_entries.size(), 8);
+    for (const auto& log : m_entries)
+    {
+        const CatalogEntry& entry = log.second;
+        file.writeString(entry.inputFilePath);
+        file.writeFixed(entry.size, 8);
+        file.writeFixed(static_cast<uint64_t>(entry.modified), 8);
+        file.writeFixed(entry.headHash, 8);
+        file.writeFixed(entry.tailHash, 8);
+        file.writeFixed(static_cast<uint64_t>(entry.firstTime), 8);
+        file.writeFixed(static_cast<uint64_t>(entry.lastTime), 8);
+        file.writeStrings(entry.servers);
+        file.writeStrings(entry.products);
+        file.writeFixed(entry.eventCount, 8);
+        file.writeString(entry.cachePath);
+    }
+
+    return writeCacheFile(catalogPath, file.buffer());
+}
+
+const CatalogEntry* LogCatalog::find(const string& inputFilePath) const
+{
+    InputKey key;
+    if (! inputKey(inputFilePath, key))
+    {
+        return NULL;
+    }
+    auto log = m_entries.find(key.path);
+    if (log == m_entries.end() || log->second.size != key.size || log->second.modified != key.modified ||
+        log->second.headHash != key.headHash || log->second.tailHash != key.tailHash)
+    {
+        return NULL;
+    }
+    return &log->second;
+}
+
+bool LogCatalog::update(const CatalogEntry& entry)
+{
+    InputKey key;
+    if (! inputKey(entry.inputFilePath, key))
+    {
+        return false;
+    }
+    CatalogEntry& catalogued = m_entries[key.path];
+    catalogued = entry;
+    catalogued.inputFilePath = key.path;
+    catalogued.size = key.size;
+    catalogued.modified = key.modified;
+    catalogued.headHash = key.headHash;
+    catalogued.tailHash = key.tailHash;
+    return true;
+}
+
+size_t LogCatalog::merge(const LogCatalog& other)
+{
+    for (const auto& entry : other.m_entries)
+    {
+        m_entries[entry.first] = entry.second;
+    }
+    return other.m_entries.size();
+}
+
+size_t LogCatalog::size() const
+{
+    return m_entries.size();
+}
+
+bool inputFingerprint(const string& inputFilePath, uint64_t& fingerprint)
+{
+    InputKey key;
+    if (! inputKey(inputFilePath, key))
+    {
+        return false;
+    }
+    CacheWriter keyData;
+    keyData.writeString(key.path);
+    keyData.writeFixed(key.size, 8);
+    keyData.writeFixed(static_cast<uint64_t>(key.modified), 8);
+    keyData.writeFixed(key.headHash, 8);
+    keyData.writeFixed(key.tailHash, 8);
+    fingerprint = checkpointHash(keyData.buffer().data(), keyData.buffer().size());
+    return true;
+}
+
+string eventCachePath(const string& inputFilePath)
+{
+    return inputFilePath + ".evcache";
+}
+
+string rollupCachePath(const string& inputFilePath)
+{
+    return inputFilePath + ".rollups";
+}
@@ -0,0 +1,151 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "EventStore.h"
+
+using namespace std;
+
+// The parsed events of a report log, saved in a binary file next to the log
+// (see eventCachePath) so that later runs, e.g. with other report options,
+// memory-map it instead of parsing the log again.  The cache is keyed by the
+// log's absolute path, size and modification time and by hashes of its first
+// and last 4 KB, so that a log rewritten with the same size and time is told
+// apart too; a log that changed in any of them is parsed again.  The columns are packed little-endian: timestamps
+// in 64 bits, ids (NoId as 0xFFFFFFFF) and counts in 32 bits and event
+// types in one byte each.  See LogData for how the events are used.
+struct EventCache
+{
+    EventCache();
+
+    // Returns false if the file is missing, unreadable, of another version
+    // or was made from another state of the log
+    bool load(const string& cachePath, const string& inputFilePath);
+
+    // Writes a temporary file and renames it.  The cache only saves time, so
+    // a failure (e.g. a log in a read-only folder) just returns false.
+    bool save(const string& cachePath, const string& inputFilePath) const;
+
+    int32_t eventYear;
+    string serverName;
+    uint64_t endTimeRow;
+
+    // Interned names in id order
+    vector<string> products;
+    vector<string> versions;
+    vector<string> users;
+    vector<string> hosts;
+    vector<string> handles;
+    vector<string> servers;
+
+    EventStore events;
+    vector<size_t> denialRows;
+    vector<size_t> shutdownRows;
+    vector<size_t> startRows;
+};
+
+// The day, week and month rollups of a log's analysis (see UsageRollups),
+// saved next to its event cache and keyed by the log the same way.  The
+// rows are flattened into columns of 64-bit values, the period first.
+struct RollupCache
+{
+    bool load(const string& cachePath, const string& inputFilePath);
+    bool save(const string& cachePath, const string& inputFilePath) const;
+
+    // Interned names in id order
+    vector<string> products;
+    vector<string> users;
+    vector<string> hosts;
+
+    // Period, start, product, peak, seconds in use and denials
+    vector<int64_t> usage;
+    // Period, start and observed seconds
+    vector<int64_t> observed;
+    // Period, start, user (or host), product and seconds checked out
+    vector<int64_t> userDurations;
+    vector<int64_t> hostDurations;
+};
+
+// What a catalog of logs records of one of them: its key, as for the event
+// cache, the time range of its dated events, the servers of its START
+// events, its products, its number of events and its event cache, empty if
+// it has none
+struct CatalogEntry
+{
+    CatalogEntry() : size(0), modified(0), headHash(0), tailHash(0), firstTime(LLONG_MAX), lastTime(LLONG_MIN), eventCount(0) {}
+
+    // Absolute once catalogued
+    string inputFilePath;
+    uint64_t size;
+    int64_t modified;
+    // Of the first and last few kilobytes of the log
+    uint64_t headHash;
+    uint64_t tailHash;
+    long long firstTime;
+    long long lastTime;
+    vector<string> servers;
+    vector<string> products;
+    uint64_t eventCount;
+    string cachePath;
+};
+
+// An index of an archive of logs in one file, so that runs over years of
+// rotated logs open only those of the time range and products they ask
+// about.  A log that changed since it was catalogued is not found, like
+// one never catalogued, and has to be opened.
+class LogCatalog
+{
+    public:
+        // Returns false, and leaves the catalog empty, if the file is
+        // missing or not a catalog
+        bool load(const string& catalogPath);
+        // Writes a temporary file and renames it; false on a failure
+        bool save(const string& catalogPath) const;
+
+        // The entry of the log, NULL if it is not catalogued or changed
+        const CatalogEntry* find(const string& inputFilePath) const;
+        // Records the entry of the log it names, keyed as the log is now.
+        // Returns false if the log cannot be inspected.
+        bool update(const CatalogEntry& entry);
+        // Records the entries of another catalog, e.g. that of a shard of
+        // a cluster run, over those of this one; returns their number
+        size_t merge(const LogCatalog& other);
+        size_t size() const;
+
+    private:
+        // By absolute path
+        map<string, CatalogEntry> m_entries;
+};
+
+// A hash of the key of the log as it is now, as the caches key it; false
+// if the log cannot be inspected
+bool inputFingerprint(const string& inputFilePath, uint64_t& fingerprint);
+
+// <log>.evcache and <log>.rollups, next to the log
+string eventCachePath(const string& inputFilePath);
+string rollupCachePath(const string& inputFilePath);
@@ -0,0 +1,193 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "EventStore.h"
+#include "HeapBytes.h"
+#include "Utilities.h"
+
+#include <algorithm>
+
+using namespace std;
+
+size_t EventStore::append(eventType type)
+{
+    types.push_back(type);
+    timestamps.push_back(0);
+    products.push_back(NoId);
+    versions.push_back(NoId);
+    users.push_back(NoId);
+    hosts.push_back(NoId);
+    counts.push_back(0);
+    handles.push_back(NoId);
+    reserved.push_back(0);
+
+    return types.size() - 1;
+}
+
+void EventStore::removeLast()
+{
+    types.pop_back();
+    timestamps.pop_back();
+    products.pop_back();
+    versions.pop_back();
+    users.pop_back();
+    hosts.pop_back();
+    counts.pop_back();
+    handles.pop_back();
+    reserved.pop_back();
+}
+
+bool EventStore::validIds(size_t productCount, size_t versionCount, size_t userCount, size_t hostCount,
+                          size_t handleCount, size_t serverCount) const
+{
+    for (size_t row = 0; row < size(); ++row)
+    {
+        eventType type = types[row];
+        size_t hostIds = (type == StartEvent) ? serverCount : hostCount;
+        if ((products[row] != NoId && products[row] >= productCount) ||
+            (versions[row] != NoId && versions[row] >= versionCount) ||
+            (users[row] != NoId && users[row] >= userCount) ||
+            (hosts[row] != NoId && hosts[row] >= hostIds) ||
+            (handles[row] != NoId && handles[row] >= handleCount))
+        {
+            return false;
+        }
+        bool session = (type == OutEvent || type == InEvent);
+        if ((session || type == DenyEvent || type == ProductEvent) && products[row] == NoId)
+        {
+            return false;
+        }
+        if (session && (users[row] == NoId || hosts[row] == NoId || handles[row] == NoId))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t EventStore::size() const
+{
+    return types.size();
+}
+
+size_t EventStore::capacity() const
+{
+    return min({ types.capacity(), timestamps.capacity(), products.capacity(), versions.capacity(), users.capacity(),
+                 hosts.capacity(), counts.capacity(), handles.capacity(), reserved.capacity() });
+}
+
+void EventStore::reserve(size_t rows)
+{
+    types.reserve(rows);
+    timestamps.reserve(rows);
+    products.reserve(rows);
+    versions.reserve(rows);
+    users.reserve(rows);
+    hosts.reserve(rows);
+    counts.reserve(rows);
+    handles.reserve(rows);
+    reserved.reserve(rows);
+
+    // The columns of a large log are filled front to back once; huge pages
+    // save most of their page faults and TLB misses
+    adviseHugePages(types.data(), types.capacity() * sizeof(types[0]));
+    adviseHugePages(timestamps.data(), timestamps.capacity() * sizeof(timestamps[0]));
+    adviseHugePages(products.data(), products.capacity() * sizeof(products[0]));
+    adviseHugePages(versions.data(), versions.capacity() * sizeof(versions[0]));
+    adviseHugePages(users.data(), users.capacity() * sizeof(users[0]));
+    adviseHugePages(hosts.data(), hosts.capacity() * sizeof(hosts[0]));
+    adviseHugePages(counts.data(), counts.capacity() * sizeof(counts[0]));
+    adviseHugePages(handles.data(), handles.capacity() * sizeof(handles[0]));
+    adviseHugePages(reserved.data(), reserved.capacity() * sizeof(reserved[0]));
+}
+
+void EventStore::clear()
+{
+    types.clear();
+    timestamps.clear();
+    products.clear();
+    versions.clear();
+    users.clear();
+    hosts.clear();
+    counts.clear();
+    handles.clear();
+    reserved.clear();
+}
+
+size_t EventStore::memoryBytes() const
+{
+    return heapBytes(types) + heapBytes(timestamps) + heapBytes(products) + heapBytes(versions) + heapBytes(users) +
+           heapBytes(hosts) + heapBytes(counts) + heapBytes(handles) + heapBytes(reserved);
+}
+
+string eventTypeName(eventType type)
+{
+    switch (type)
+    {
+        case OutEvent:
+            return "OUT";
+        case InEvent:
+            return "IN";
+        case DenyEvent:
+            return "DENY";
+        case StartEvent:
+            return "START";
+        case ShutdownEvent:
+            return "SHUTDOWN";
+        default:
+            return "PRODUCT";
+    }
+}
+
+bool startsEpoch(eventType type)
+{
+    return type == StartEvent || type == ShutdownEvent;
+}
+
+// The keywords all differ in length, so the length picks the only event a
+// keyword can be and a single compare confirms it
+bool classifyEvent(string_view keyword, eventType& type)
+{
+    switch (keyword.size())
+    {
+        case 2:
+            type = InEvent;
+            return keyword == "IN";
+        case 3:
+            type = OutEvent;
+            return keyword == "OUT";
+        case 4:
+            type = DenyEvent;
+            return keyword == "DENY";
+        case 5:
+            type = StartEvent;
+            return keyword == "START";
+        case 7:
+            type = ProductEvent;
+            return keyword == "PRODUCT";
+        case 8:
+            type = ShutdownEvent;
+            return keyword == "SHUTDOWN";
+        default:
+            return false;
+    }
+}
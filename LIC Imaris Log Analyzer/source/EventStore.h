@@ -0,0 +1,102 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+const size_t NoId = static_cast<size_t>(-1);
+
+enum eventType
+{
+    OutEvent,
+    InEvent,
+    DenyEvent,
+    StartEvent,
+    ShutdownEvent,
+    ProductEvent
+};
+
+// Name of the event as it appears in the report log ("OUT", "IN", ...)
+string eventTypeName(eventType type);
+
+// The event a report log keyword names, the inverse of eventTypeName.
+// Returns false for any other keyword.
+bool classifyEvent(string_view keyword, eventType& type);
+
+// Whether the event starts a new restart epoch of the license server.  RLM
+// hands its license handles out again after a restart, so a START returns
+// every license still checked out just like a SHUTDOWN does, e.g. after the
+// server went down without one: no handle pairs across the epochs.
+bool startsEpoch(eventType type);
+
+// The extracted report log events, one column per field (struct of arrays).
+// Every column holds one entry per event; a field the event type does not
+// carry is NoId (ids) or 0 (numbers).  Timestamps are seconds since the
+// epoch; PRODUCT events do not have one.
+//
+// Field use by event type:
+//   OUT, IN    product, version, user, host, count, handle, reserved
+//   DENY       product, version, user, host, count (the denial reason)
+//   START      host (the license server)
+//   SHUTDOWN   -
+//   PRODUCT    product, version, count (license count), reserved (limit)
+struct EventStore
+{
+    vector<eventType> types;
+    vector<long long> timestamps;
+    vector<size_t> products;
+    vector<size_t> versions;
+    vector<size_t> users;
+    vector<size_t> hosts;
+    vector<int32_t> counts;
+    vector<size_t> handles;
+    vector<int32_t> reserved;
+
+    // Adds an event with all fields unset and returns its row
+    size_t append(eventType type);
+
+    // Drops the last event, e.g. one whose line turned out to be invalid
+    void removeLast();
+
+    size_t size() const;
+    // The events the columns hold without being reallocated
+    size_t capacity() const;
+    void reserve(size_t rows);
+    void clear();
+    // The heap the columns hold, an estimate for the memory accounting
+    size_t memoryBytes() const;
+
+    // Whether every id is below the size of its name table (a START's host
+    // is a server) and every license event carries the ids the analysis
+    // indexes its tables by: product, user, host and handle for OUT and
+    // IN, the product for DENY and PRODUCT.  The parser guarantees both;
+    // events read back from a file are checked once, so that the passes
+    // over them need no bounds checks (see CheckedAccess.h).
+    bool validIds(size_t productCount, size_t versionCount, size_t userCount, size_t hostCount, size_t handleCount,
+                  size_t serverCount) const;
+};
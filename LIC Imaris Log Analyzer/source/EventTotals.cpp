@@ -0,0 +1,107 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "EventTotals.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void EventTotals::clear()
+{
+    fill(m_events, m_events + ProductEvent + 1, 0);
+    m_firstTime = LLONG_MAX;
+    m_denials.clear();
+}
+
+size_t EventTotals::memoryBytes() const
+{
+    return heapBytes(m_denials);
+}
+
+void EventTotals::add(const EventStore& events, size_t firstRow, size_t endRow)
+{
+    for (size_t row = firstRow; row < endRow; ++row)
+    {
+        eventType type = events.types[row];
+        ++m_events[type];
+        if (type != ProductEvent)
+        {
+            m_firstTime = min(m_firstTime, events.timestamps[row]);
+        }
+        if (type == DenyEvent)
+        {
+            addDenials(events.products[row], 1);
+        }
+    }
+}
+
+void EventTotals::addEvents(eventType type, uint64_t count)
+{
+    m_events[type] += count;
+}
+
+void EventTotals::addDenials(size_t product, uint64_t requests)
+{
+    if (product >= m_denials.size())
+    {
+        m_denials.resize(product + 1, 0);
+    }
+    m_denials[product] += requests;
+}
+
+uint64_t EventTotals::events(eventType type) const
+{
+    return m_events[type];
+}
+
+long long EventTotals::firstTime() const
+{
+    return m_firstTime;
+}
+
+uint64_t EventTotals::denials(size_t product) const
+{
+    return product < m_denials.size() ? m_denials[product] : 0;
+}
+
+void EventTotals::save(Checkpoint& checkpoint) const
+{
+    checkpoint.eventTypeCounts.assign(m_events, m_events + ProductEvent + 1);
+    checkpoint.firstEventTime = m_firstTime;
+    checkpoint.productDenials.assign(m_denials.begin(), m_denials.end());
+}
+
+bool EventTotals::restore(const Checkpoint& checkpoint)
+{
+    if (checkpoint.eventTypeCounts.size() != ProductEvent + 1 ||
+        checkpoint.productDenials.size() > checkpoint.products.size())
+    {
+        return false;
+    }
+
+    copy(checkpoint.eventTypeCounts.begin(), checkpoint.eventTypeCounts.end(), m_events);
+    m_firstTime = checkpoint.firstEventTime;
+    m_denials.assign(checkpoint.productDenials.begin(), checkpoint.productDenials.end());
+    return true;
+}
@@ -0,0 +1,69 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+#include "EventStore.h"
+
+using namespace std;
+
+// Totals of the events kept up to date while they are read, so a summary
+// of the log so far, e.g. of a followed log, takes no walk over its events:
+// the events by type, the time of the first dated one and the denied
+// requests by product.  A coalesced denial counts for every request it
+// stands for, and the events left out for a summary alone count as well.
+class EventTotals
+{
+    public:
+        EventTotals() { clear(); }
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Counts the events [firstRow, endRow) of the store
+        void add(const EventStore& events, size_t firstRow, size_t endRow);
+        // Counts events of the type, or denials of the product, that are
+        // not in the store
+        void addEvents(eventType type, uint64_t count);
+        void addDenials(size_t product, uint64_t requests);
+
+        uint64_t events(eventType type) const;
+        // Time of the first event with one, LLONG_MAX if none
+        long long firstTime() const;
+        // The denied requests of the product
+        uint64_t denials(size_t product) const;
+
+        // The totals, for a checkpoint; restore is false if the checkpoint
+        // does not hold them
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+    private:
+        uint64_t m_events[ProductEvent + 1];
+        long long m_firstTime;
+        vector<uint64_t> m_denials;
+};
@@ -24,6 +24,8 @@
 
 #include <exception>
 #include <sstream>
+#include <string>
+#include <vector>
 #include "Utilities.h"
 
 using namespace std;
@@ -93,6 +95,14 @@ public:
             m_error = "Unable to open file: " + filePath;
         }
     }
+    CannotOpenFileException(const vector<string>& filePaths)
+    {
+        m_error = "Unable to open file(s):";
+        for (size_t file = 0; file < filePaths.size(); ++file)
+        {
+            m_error += "\n" + filePaths.at(file);
+        }
+    }
     ~CannotOpenFileException() throw() {}
     virtual const char* what() const throw()
     {
@@ -130,8 +140,12 @@ class InvalidFileFormatException: public exception
 public:
     InvalidFileFormatException()
     {
-        m_error = "Log file format invalid. Only RLM report formated logs are supported for the LIC Imaris Log Analyzer.  "
-            "ISV logs are not supported";
+        m_error = "Log file format invalid. Only RLM report logs and ISV server logs are supported for the LIC Imaris Log Analyzer";
+    }
+    InvalidFileFormatException(int reportFormat, int supportedFormat)
+    {
+        m_error = "RLM Report Log Format " + toString(reportFormat) + " is not supported.  Only Format " +
+            toString(supportedFormat) + " logs can be analyzed by the LIC Imaris Log Analyzer";
     }
     ~InvalidFileFormatException() throw() {}
     virtual const char* what() const throw()
@@ -142,6 +156,38 @@ private:
     string m_error;
 };
 
+class DecompressionException: public exception
+{
+public:
+    DecompressionException(string filePath)
+    {
+        m_error = "Unable to decompress file (damaged or truncated): " + filePath;
+    }
+    ~DecompressionException() throw() {}
+    virtual const char* what() const throw()
+    {
+        return m_error.c_str();
+    }
+private:
+    string m_error;
+};
+
+class CancelledException: public exception
+{
+public:
+    CancelledException()
+    {
+        m_error = "The run was cancelled or ran out of time; no partial report was left behind";
+    }
+    ~CancelledException() throw() {}
+    virtual const char* what() const throw()
+    {
+        return m_error.c_str();
+    }
+private:
+    string m_error;
+};
+
 class InvalidIndexException: public exception
 {
 public:
@@ -0,0 +1,233 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "HeapBytes.h"
+
+using namespace std;
+
+// Hashes the integer keys of the flat tables, and pairs and tuples of them,
+// with the finalizer of splitmix64, so that dense ids spread over the slots
+struct FlatHash
+{
+    static uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    template <typename T>
+    typename enable_if<is_integral<T>::value, uint64_t>::type operator()(T value) const
+    {
+        return mix(static_cast<uint64_t>(value));
+    }
+
+    template <typename A, typename B>
+    uint64_t operator()(const pair<A, B>& value) const
+    {
+        return mix((*this)(value.first) + 0x9e3779b97f4a7c15ULL * (*this)(value.second));
+    }
+
+    template <typename... T>
+    uint64_t operator()(const tuple<T...>& value) const
+    {
+        uint64_t hash = 0;
+        apply([this, &hash](const T&... fields)
+              {
+                  ((hash = mix(hash + 0x9e3779b97f4a7c15ULL + (*this)(fields))), ...);
+              },
+              value);
+        return hash;
+    }
+};
+
+// Hash map in one flat array of slots, for the small keys looked up on every
+// event: open addressing with linear probing over a power of two of slots,
+// at most half of them used.  Every slot keeps the hash of its key, so a
+// probe compares the key only on a hash match and growing does not hash
+// again; erasing shifts the following entries back instead of leaving
+// tombstones.  Unlike the node based maps, nothing is allocated per entry,
+// and the order of the entries is unspecified.
+template <typename Key, typename Value, typename Hash = FlatHash>
+class FlatHashMap
+{
+    public:
+        FlatHashMap() : m_size(0) {}
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        size_t memoryBytes() const { return heapBytes(m_slots); }
+
+        void clear()
+        {
+            m_slots.clear();
+            m_size = 0;
+        }
+
+        // The value of key, NULL if it is not in the map
+        Value* find(const Key& key)
+        {
+            if (m_slots.empty())
+            {
+                return NULL;
+            }
+            Slot& slot = m_slots[findSlot(key, hashOf(key))];
+            return slot.hash != 0 ? &slot.value : NULL;
+        }
+
+        const Value* find(const Key& key) const
+        {
+            return const_cast<FlatHashMap*>(this)->find(key);
+        }
+
+        // The value of key, default constructed if it was not in the map
+        Value& operator[](const Key& key)
+        {
+            uint64_t hash = hashOf(key);
+            if (2 * (m_size + 1) > m_slots.size())
+            {
+                grow();
+            }
+            Slot& slot = m_slots[findSlot(key, hash)];
+            if (slot.hash == 0)
+            {
+                slot.hash = hash;
+                slot.key = key;
+                slot.value = Value();
+                ++m_size;
+            }
+            return slot.value;
+        }
+
+        // Returns false if key was not in the map
+        bool erase(const Key& key)
+        {
+            if (m_slots.empty())
+            {
+                return false;
+            }
+            size_t slot = findSlot(key, hashOf(key));
+            if (m_slots[slot].hash == 0)
+            {
+                return false;
+            }
+            eraseSlot(slot);
+            return true;
+        }
+
+        // Calls visit(key, value) for every entry, in slot order
+        template <typename Visit>
+        void forEach(Visit visit)
+        {
+            for (size_t slot = 0; slot < m_slots.size(); ++slot)
+            {
+                if (m_slots[slot].hash != 0)
+                {
+                    visit(m_slots[slot].key, m_slots[slot].value);
+                }
+            }
+        }
+
+    private:
+        // A hash of 0 marks a free slot, so the top bit of every key's
+        // hash is set
+        struct Slot
+        {
+            Slot() : hash(0), key(), value() {}
+
+            uint64_t hash;
+            Key key;
+            Value value;
+        };
+
+        static uint64_t hashOf(const Key& key)
+        {
+            return Hash()(key) | (1ULL << 63);
+        }
+
+        // The slot that holds key, or the free slot where it would go
+        size_t findSlot(const Key& key, uint64_t hash) const
+        {
+            const size_t mask = m_slots.size() - 1;
+            for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+            {
+                const Slot& entry = m_slots[slot];
+                if (entry.hash == 0 || (entry.hash == hash && entry.key == key))
+                {
+                    return slot;
+                }
+            }
+        }
+
+        // Moves every entry after the erased one that probed past it back
+        // into the gap, so the probes never meet a hole in their run
+        void eraseSlot(size_t gap)
+        {
+            const size_t mask = m_slots.size() - 1;
+            for (size_t slot = (gap + 1) & mask; m_slots[slot].hash != 0; slot = (slot + 1) & mask)
+            {
+                size_t home = m_slots[slot].hash & mask;
+                if (((slot - home) & mask) >= ((slot - gap) & mask))
+                {
+                    m_slots[gap] = move(m_slots[slot]);
+                    gap = slot;
+                }
+            }
+            m_slots[gap] = Slot();
+            --m_size;
+        }
+
+        void grow()
+        {
+            vector<Slot> slots(max(static_cast<size_t>(16), 2 * m_slots.size()));
+            swap(slots, m_slots);
+            const size_t mask = m_slots.size() - 1;
+            for (size_t old = 0; old < slots.size(); ++old)
+            {
+                if (slots[old].hash == 0)
+                {
+                    continue;
+                }
+                size_t slot = slots[old].hash & mask;
+                while (m_slots[slot].hash != 0)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                m_slots[slot] = move(slots[old]);
+            }
+        }
+
+        vector<Slot> m_slots;
+        size_t m_size;
+};
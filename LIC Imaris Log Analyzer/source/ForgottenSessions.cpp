@@ -0,0 +1,220 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ForgottenSessions.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    const long long SecondsPerDay = 24 * 3600;
+
+    // Values saved ahead of the pairs: the policy
+    const size_t PolicyValues = 3;
+
+    // Values saved for every pair: user, product, closed sessions, those
+    // held through the off-hours and those held too long, and their wasted
+    // seconds
+    const size_t PairValues = 6;
+
+    long long floorDivide(long long value, long long divisor)
+    {
+        return value / divisor - ((value % divisor < 0) ? 1 : 0);
+    }
+}
+
+void ForgottenSessions::setPolicy(const ForgottenPolicy& policy)
+{
+    m_policy = policy;
+}
+
+const ForgottenPolicy& ForgottenSessions::policy() const
+{
+    return m_policy;
+}
+
+void ForgottenSessions::clear()
+{
+    m_index.clear();
+    m_totals.clear();
+}
+
+size_t ForgottenSessions::memoryBytes() const
+{
+    return m_index.memoryBytes() + heapBytes(m_totals);
+}
+
+void ForgottenSessions::add(size_t user, size_t product, long long checkOut, long long seconds, bool closed)
+{
+    if (seconds <= 0)
+    {
+        return;
+    }
+
+    // Held through the first off-hours that start at or after the check-out
+    long long offHoursStart = m_policy.offHoursStart * 3600LL;
+    long long offHoursLength = ((m_policy.offHoursEnd - m_policy.offHoursStart + 24) % 24) * 3600LL;
+    long long checkIn = checkOut + seconds;
+    bool offHours = false;
+    long long wastedSeconds = 0;
+    if (offHoursLength > 0)
+    {
+        long long nextStart = offHoursStart + (floorDivide(checkOut - offHoursStart - 1, SecondsPerDay) + 1) * SecondsPerDay;
+        if (nextStart + offHoursLength <= checkIn)
+        {
+            offHours = true;
+            wastedSeconds = offHoursBefore(checkIn) - offHoursBefore(checkOut);
+        }
+    }
+    bool tooLong = m_policy.longSeconds > 0 && seconds > m_policy.longSeconds;
+    if (tooLong)
+    {
+        wastedSeconds = max(wastedSeconds, seconds - m_policy.longSeconds);
+    }
+    if (! offHours && ! tooLong)
+    {
+        return;
+    }
+
+    ForgottenTotals& totals = totalsOf(user, product);
+    ++totals.sessions;
+    totals.offHoursSessions += offHours ? 1 : 0;
+    totals.longSessions += tooLong ? 1 : 0;
+    totals.wastedSeconds += wastedSeconds;
+    if (closed)
+    {
+        ++totals.closedSessions;
+        totals.closedOffHoursSessions += offHours ? 1 : 0;
+        totals.closedLongSessions += tooLong ? 1 : 0;
+        totals.closedWastedSeconds += wastedSeconds;
+    }
+    else
+    {
+        ++totals.openSessions;
+    }
+}
+
+void ForgottenSessions::totals(vector<ForgottenTotals>& totals) const
+{
+    totals = m_totals;
+    sort(totals.begin(), totals.end(), [](const ForgottenTotals& first, const ForgottenTotals& second)
+         {
+             return first.user != second.user ? first.user < second.user : first.product < second.product;
+         });
+}
+
+void ForgottenSessions::save(Checkpoint& checkpoint) const
+{
+    checkpoint.forgottenSessions.clear();
+    checkpoint.forgottenSessions.reserve(PolicyValues + m_totals.size() * PairValues);
+    checkpoint.forgottenSessions.push_back(m_policy.longSeconds);
+    checkpoint.forgottenSessions.push_back(m_policy.offHoursStart);
+    checkpoint.forgottenSessions.push_back(m_policy.offHoursEnd);
+    for (const ForgottenTotals& totals : m_totals)
+    {
+        if (totals.closedSessions == 0)
+        {
+            continue;
+        }
+        checkpoint.forgottenSessions.push_back(static_cast<int64_t>(totals.user));
+        checkpoint.forgottenSessions.push_back(static_cast<int64_t>(totals.product));
+        checkpoint.forgottenSessions.push_back(static_cast<int64_t>(totals.closedSessions));
+        checkpoint.forgottenSessions.push_back(static_cast<int64_t>(totals.closedOffHoursSessions));
+        checkpoint.forgottenSessions.push_back(static_cast<int64_t>(totals.closedLongSessions));
+        checkpoint.forgottenSessions.push_back(totals.closedWastedSeconds);
+    }
+}
+
+bool ForgottenSessions::restore(const Checkpoint& checkpoint)
+{
+    if (! validEntries(checkpoint))
+    {
+        return false;
+    }
+    const vector<int64_t>& values = checkpoint.forgottenSessions;
+    if (values.empty())
+    {
+        return true;
+    }
+    m_policy.longSeconds = values[0];
+    m_policy.offHoursStart = static_cast<int>(values[1]);
+    m_policy.offHoursEnd = static_cast<int>(values[2]);
+    for (size_t value = PolicyValues; value < values.size(); value += PairValues)
+    {
+        ForgottenTotals& totals = totalsOf(static_cast<size_t>(values[value]), static_cast<size_t>(values[value + 1]));
+        totals.sessions = totals.closedSessions = static_cast<uint64_t>(values[value + 2]);
+        totals.offHoursSessions = totals.closedOffHoursSessions = static_cast<uint64_t>(values[value + 3]);
+        totals.longSessions = totals.closedLongSessions = static_cast<uint64_t>(values[value + 4]);
+        totals.wastedSeconds = totals.closedWastedSeconds = values[value + 5];
+    }
+    return true;
+}
+
+// The off-hours seconds from a fixed origin up to time, so that those of an
+// interval are the difference of its ends
+long long ForgottenSessions::offHoursBefore(long long time) const
+{
+    long long offHoursStart = m_policy.offHoursStart * 3600LL;
+    long long offHoursLength = ((m_policy.offHoursEnd - m_policy.offHoursStart + 24) % 24) * 3600LL;
+    long long days = floorDivide(time - offHoursStart, SecondsPerDay);
+    return days * offHoursLength + min(time - offHoursStart - days * SecondsPerDay, offHoursLength);
+}
+
+ForgottenTotals& ForgottenSessions::totalsOf(size_t user, size_t product)
+{
+    // The map holds every index plus one, so a new pair reads as 0
+    size_t& index = m_index[make_pair(user, product)];
+    if (index == 0)
+    {
+        ForgottenTotals totals = { user, product, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+        m_totals.push_back(totals);
+        index = m_totals.size();
+    }
+    return m_totals[index - 1];
+}
+
+bool ForgottenSessions::validEntries(const Checkpoint& checkpoint)
+{
+    const vector<int64_t>& values = checkpoint.forgottenSessions;
+    if (values.empty())
+    {
+        return true;
+    }
+    if (values.size() < PolicyValues || (values.size() - PolicyValues) % PairValues != 0 ||
+        values[1] < 0 || values[1] > 23 || values[2] < 0 || values[2] > 23)
+    {
+        return false;
+    }
+    for (size_t value = PolicyValues; value < values.size(); value += PairValues)
+    {
+        if (values[value] < 0 || static_cast<uint64_t>(values[value]) >= checkpoint.users.size() ||
+            values[value + 1] < 0 || static_cast<uint64_t>(values[value + 1]) >= checkpoint.products.size() ||
+            values[value + 2] <= 0 || values[value + 3] < 0 || values[value + 4] < 0 || values[value + 5] < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
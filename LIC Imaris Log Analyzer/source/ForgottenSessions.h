@@ -0,0 +1,107 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Checkpoint.h"
+#include "FlatHashMap.h"
+
+using namespace std;
+
+// When a session counts as forgotten: checked out through the whole of the
+// off-hours, the hours [offHoursStart, offHoursEnd) of the day, which wrap
+// around midnight if they end before they start, or for longer than
+// longSeconds.  Equal hours (longSeconds 0) turn that test off.
+struct ForgottenPolicy
+{
+    ForgottenPolicy() : longSeconds(12 * 3600), offHoursStart(22), offHoursEnd(6) {}
+
+    long long longSeconds;
+    int offHoursStart;
+    int offHoursEnd;
+};
+
+// The flagged sessions of a user and product: those held through the
+// off-hours and those held too long (a session may be both), those still
+// checked out among them, and their wasted seconds.  The closed sessions
+// are also counted apart, as only they go into a checkpoint.
+struct ForgottenTotals
+{
+    size_t user;
+    size_t product;
+    uint64_t sessions;
+    uint64_t offHoursSessions;
+    uint64_t longSessions;
+    uint64_t openSessions;
+    long long wastedSeconds;
+    uint64_t closedSessions;
+    uint64_t closedOffHoursSessions;
+    uint64_t closedLongSessions;
+    long long closedWastedSeconds;
+};
+
+// Forgotten check-outs by user and product for the forgotten sessions
+// report: sessions left open overnight or far longer than work takes hold
+// licenses others are denied.  The session pass adds every session as it
+// pairs it, so the report costs no pass of its own.  The wasted time of a
+// session is the larger of its off-hours seconds, if it was held through
+// the off-hours, and its seconds past longSeconds.  Only the (user,
+// product) pairs with flagged sessions take room.
+class ForgottenSessions
+{
+    public:
+        ForgottenSessions() {}
+
+        void setPolicy(const ForgottenPolicy& policy);
+        const ForgottenPolicy& policy() const;
+
+        void clear();
+        // The map and the totals, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // The session pass, which starts over from the closed sessions of
+        // the checkpoint every run
+        void add(size_t user, size_t product, long long checkOut, long long seconds, bool closed);
+
+        // The totals of every pair with flagged sessions, by user and then
+        // product id
+        void totals(vector<ForgottenTotals>& totals) const;
+
+        // The policy and the closed sessions of every pair, for a
+        // checkpoint.  A restored analysis keeps the policy of its first
+        // run, as the sessions it already closed were flagged by it.
+        // restore is false if the checkpoint does not fit the names.
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+    private:
+        long long offHoursBefore(long long time) const;
+        ForgottenTotals& totalsOf(size_t user, size_t product);
+        static bool validEntries(const Checkpoint& checkpoint);
+
+        ForgottenPolicy m_policy;
+        FlatHashMap<pair<size_t, size_t>, size_t> m_index;
+        vector<ForgottenTotals> m_totals;
+};
@@ -0,0 +1,195 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "GroupMapping.h"
+
+#include <atomic>
+#include <fstream>
+
+using namespace std;
+
+namespace
+{
+    atomic<const GroupMapping*> s_groupMapping(NULL);
+
+    string trimmed(const string& text)
+    {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == string::npos)
+        {
+            return string();
+        }
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+}
+
+GroupMapping::GroupMapping()
+{
+    TrieNode root;
+    root.group = NoGroup;
+    m_hostTrie.push_back(root);
+}
+
+bool GroupMapping::loadUsers(const string& filePath)
+{
+    return loadFile(filePath, [this](const string& user, size_t group)
+                    {
+                        m_userGroups[user] = group;
+                    });
+}
+
+bool GroupMapping::loadHosts(const string& filePath)
+{
+    return loadFile(filePath, [this](const string& prefix, size_t group)
+                    {
+                        addHostPrefix(prefix, group);
+                    });
+}
+
+bool GroupMapping::empty() const
+{
+    return m_groups.empty();
+}
+
+size_t GroupMapping::groups() const
+{
+    return m_groups.size();
+}
+
+const string& GroupMapping::group(size_t group) const
+{
+    return m_groups.at(group);
+}
+
+size_t GroupMapping::userGroup(string_view user) const
+{
+    unordered_map<string, size_t>::const_iterator found = m_userGroups.find(string(user));
+    return found != m_userGroups.end() ? found->second : NoGroup;
+}
+
+size_t GroupMapping::hostGroup(string_view host) const
+{
+    size_t group = NoGroup;
+    uint32_t node = 0;
+    for (char letter : host)
+    {
+        const vector<pair<char, uint32_t> >& children = m_hostTrie[node].children;
+        size_t child = 0;
+        while (child < children.size() && children[child].first != letter)
+        {
+            ++child;
+        }
+        if (child == children.size())
+        {
+            break;
+        }
+        node = children[child].second;
+        if (m_hostTrie[node].group != NoGroup)
+        {
+            group = m_hostTrie[node].group;
+        }
+    }
+    return group;
+}
+
+// A later line of the same name maps it anew
+template <typename AddName>
+bool GroupMapping::loadFile(const string& filePath, AddName addName)
+{
+    ifstream file(filePath.c_str());
+    if (! file.is_open())
+    {
+        return false;
+    }
+    string line;
+    while (getline(file, line))
+    {
+        string text = trimmed(line);
+        if (text.empty() || text[0] == '#')
+        {
+            continue;
+        }
+        size_t comma = text.find(',');
+        if (comma == string::npos)
+        {
+            return false;
+        }
+        string name = trimmed(text.substr(0, comma));
+        string group = trimmed(text.substr(comma + 1));
+        if (name.empty() || group.empty())
+        {
+            return false;
+        }
+        addName(name, addGroup(group));
+    }
+    return ! file.bad();
+}
+
+size_t GroupMapping::addGroup(const string& group)
+{
+    pair<unordered_map<string, size_t>::iterator, bool> added = m_groupIds.insert(make_pair(group, m_groups.size()));
+    if (added.second)
+    {
+        m_groups.push_back(group);
+    }
+    return added.first->second;
+}
+
+void GroupMapping::addHostPrefix(const string& prefix, size_t group)
+{
+    uint32_t node = 0;
+    for (char letter : prefix)
+    {
+        vector<pair<char, uint32_t> >& children = m_hostTrie[node].children;
+        size_t child = 0;
+        while (child < children.size() && children[child].first != letter)
+        {
+            ++child;
+        }
+        if (child == children.size())
+        {
+            TrieNode added;
+            added.group = NoGroup;
+            uint32_t addedNode = static_cast<uint32_t>(m_hostTrie.size());
+            children.push_back(make_pair(letter, addedNode));
+            m_hostTrie.push_back(added);
+            node = addedNode;
+        }
+        else
+        {
+            node = children[child].second;
+        }
+    }
+    m_hostTrie[node].group = group;
+}
+
+void setGroupMapping(const GroupMapping* mapping)
+{
+    s_groupMapping = mapping;
+}
+
+const GroupMapping* currentGroupMapping()
+{
+    return s_groupMapping;
+}
@@ -0,0 +1,90 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The groups license time is billed to, e.g. research groups or labs, from
+// mapping files of "name,group" lines: users to groups, and host name
+// prefixes to groups.  The users are looked up in a hash table and the host
+// names in a prefix trie, where the longest prefix mapped wins.  A session
+// goes to the group of its user, else to that of its host; one of neither
+// is unassigned.  Blank lines and those starting with # are skipped.  The
+// analysis resolves every user and host it interns once.
+class GroupMapping
+{
+    public:
+        static const size_t NoGroup = SIZE_MAX;
+
+        GroupMapping();
+
+        // Returns false if the file cannot be read or has a line without a
+        // name and a group
+        bool loadUsers(const string& filePath);
+        bool loadHosts(const string& filePath);
+
+        bool empty() const;
+
+        // The groups in the order the files first named them
+        size_t groups() const;
+        const string& group(size_t group) const;
+
+        // The group of the user, or of the longest prefix of the host
+        // mapped, NoGroup if none
+        size_t userGroup(string_view user) const;
+        size_t hostGroup(string_view host) const;
+
+    private:
+        // Every node of the trie lists its children by the next character
+        // of the prefix, and the group of the prefix up to it, if mapped
+        struct TrieNode
+        {
+            vector<pair<char, uint32_t> > children;
+            size_t group;
+        };
+
+        template <typename AddName>
+        bool loadFile(const string& filePath, AddName addName);
+        size_t addGroup(const string& group);
+        void addHostPrefix(const string& prefix, size_t group);
+
+        vector<string> m_groups;
+        unordered_map<string, size_t> m_groupIds;
+        unordered_map<string, size_t> m_userGroups;
+        vector<TrieNode> m_hostTrie;
+};
+
+// The group mapping the logs analyzed from now on bill their sessions by,
+// or NULL (the default) for no chargeback report.  The caller keeps it
+// alive until then.
+void setGroupMapping(const GroupMapping* mapping);
+
+const GroupMapping* currentGroupMapping();
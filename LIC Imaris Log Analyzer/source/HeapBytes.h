@@ -0,0 +1,54 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+// Estimates of the heap a container holds, for the memory accounting of
+// the analysis (see setMemoryAccounting): the elements it has room for,
+// plus what the allocator keeps beside each block it hands out.  A map
+// allocates a node of three links and a colour per element.
+const size_t HeapBlockOverhead = 16;
+
+template <typename T>
+size_t heapBytes(const vector<T>& values)
+{
+    return values.capacity() == 0 ? 0 : values.capacity() * sizeof(T) + HeapBlockOverhead;
+}
+
+template <typename T>
+size_t heapBytes(const deque<T>& values)
+{
+    return values.size() * sizeof(T) + HeapBlockOverhead;
+}
+
+template <typename K, typename V, typename C>
+size_t heapBytes(const map<K, V, C>& values)
+{
+    return values.size() * (sizeof(typename map<K, V, C>::value_type) + 4 * sizeof(void*) + HeapBlockOverhead);
+}
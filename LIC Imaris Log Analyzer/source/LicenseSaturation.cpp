@@ -0,0 +1,134 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "LicenseSaturation.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void LicenseSaturation::clear()
+{
+    m_closedIntervals.clear();
+    m_openSince.clear();
+    m_closedCounts.clear();
+    m_closedSeconds.clear();
+}
+
+size_t LicenseSaturation::memoryBytes() const
+{
+    return heapBytes(m_closedIntervals) + heapBytes(m_openSince) + heapBytes(m_closedCounts) + heapBytes(m_closedSeconds);
+}
+
+void LicenseSaturation::resize(size_t products)
+{
+    if (products > m_openSince.size())
+    {
+        m_openSince.resize(products, LLONG_MIN);
+        m_closedCounts.resize(products, 0);
+        m_closedSeconds.resize(products, 0);
+    }
+}
+
+void LicenseSaturation::update(size_t product, long long time, int32_t inUse, int32_t limit)
+{
+    bool saturated = limit > 0 && inUse >= limit;
+    long long& openSince = m_openSince.at(product);
+    if (saturated && openSince == LLONG_MIN)
+    {
+        openSince = time;
+    }
+    else if (! saturated && openSince != LLONG_MIN)
+    {
+        // Events slightly out of order do not end an interval before it starts
+        SaturationInterval interval = { openSince, max(time, openSince), product };
+        m_closedIntervals.push_back(interval);
+        ++m_closedCounts.at(product);
+        m_closedSeconds.at(product) += interval.end - interval.start;
+        openSince = LLONG_MIN;
+    }
+}
+
+void LicenseSaturation::takeProducts(const LicenseSaturation& shard, size_t firstProduct, size_t endProduct)
+{
+    copy(shard.m_openSince.begin() + firstProduct, shard.m_openSince.begin() + endProduct, m_openSince.begin() + firstProduct);
+    copy(shard.m_closedCounts.begin() + firstProduct, shard.m_closedCounts.begin() + endProduct,
+         m_closedCounts.begin() + firstProduct);
+    copy(shard.m_closedSeconds.begin() + firstProduct, shard.m_closedSeconds.begin() + endProduct,
+         m_closedSeconds.begin() + firstProduct);
+}
+
+void LicenseSaturation::addClosedInterval(const SaturationInterval& interval)
+{
+    m_closedIntervals.push_back(interval);
+}
+
+const vector<SaturationInterval>& LicenseSaturation::closedIntervals() const
+{
+    return m_closedIntervals;
+}
+
+size_t LicenseSaturation::products() const
+{
+    return m_openSince.size();
+}
+
+long long LicenseSaturation::openSince(size_t product) const
+{
+    return m_openSince.at(product);
+}
+
+uint64_t LicenseSaturation::closedCount(size_t product) const
+{
+    return m_closedCounts.at(product);
+}
+
+long long LicenseSaturation::closedSeconds(size_t product) const
+{
+    return m_closedSeconds.at(product);
+}
+
+void LicenseSaturation::save(Checkpoint& checkpoint) const
+{
+    checkpoint.saturationStarts.assign(m_openSince.begin(), m_openSince.end());
+    checkpoint.saturationCounts.assign(m_closedCounts.begin(), m_closedCounts.end());
+    checkpoint.saturationSeconds.assign(m_closedSeconds.begin(), m_closedSeconds.end());
+}
+
+bool LicenseSaturation::restore(const Checkpoint& checkpoint)
+{
+    size_t products = checkpoint.saturationStarts.size();
+    if (checkpoint.saturationCounts.size() != products ||
+        checkpoint.saturationSeconds.size() != products ||
+        products > checkpoint.products.size())
+    {
+        return false;
+    }
+
+    m_closedIntervals.clear();
+    m_openSince.assign(checkpoint.saturationStarts.begin(), checkpoint.saturationStarts.end());
+    m_closedCounts.assign(checkpoint.saturationCounts.begin(), checkpoint.saturationCounts.end());
+    m_closedSeconds.assign(checkpoint.saturationSeconds.begin(), checkpoint.saturationSeconds.end());
+    return true;
+}
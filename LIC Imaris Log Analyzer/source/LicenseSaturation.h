@@ -0,0 +1,90 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+
+using namespace std;
+
+// A time a product had all its floating licenses in use
+struct SaturationInterval
+{
+    long long start;
+    long long end;
+    size_t product;
+};
+
+// Finds the times products sat at their license limit while the usage
+// pass walks the events: a product is saturated from the change that puts
+// as many floating licenses in use as its limit allows, until the change
+// that takes one back.  A product without a limit is never saturated.  The
+// intervals are listed as they close; those still open are kept by their
+// start.
+class LicenseSaturation
+{
+    public:
+        LicenseSaturation() {}
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Room for the product ids below products
+        void resize(size_t products);
+
+        // The product's floating licenses in use and limit from time on
+        void update(size_t product, long long time, int32_t inUse, int32_t limit);
+
+        // Takes the products [firstProduct, endProduct) from the saturation
+        // of one shard of a parallel pass, which counted those products
+        // alone.  Its closed intervals are merged in the order they closed
+        // with addClosedInterval.
+        void takeProducts(const LicenseSaturation& shard, size_t firstProduct, size_t endProduct);
+        void addClosedInterval(const SaturationInterval& interval);
+
+        // The intervals closed since the start or restore, by their end
+        const vector<SaturationInterval>& closedIntervals() const;
+
+        size_t products() const;
+        // The start of the product's open interval, LLONG_MIN if none
+        long long openSince(size_t product) const;
+        // The intervals and seconds at the limit of those closed, the ones
+        // closed before the restore included
+        uint64_t closedCount(size_t product) const;
+        long long closedSeconds(size_t product) const;
+
+        // The totals and open intervals, for a checkpoint; restore is false
+        // if the checkpoint does not fit the products
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+    private:
+        vector<SaturationInterval> m_closedIntervals;
+        vector<long long> m_openSince;
+        vector<uint64_t> m_closedCounts;
+        vector<long long> m_closedSeconds;
+};
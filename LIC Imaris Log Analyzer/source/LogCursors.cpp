@@ -0,0 +1,145 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LogCursors.h"
+
+SessionCursor::SessionCursor(const LogData& logData, const LogSelection& selection)
+    : m_logData(logData),
+      m_selection(selection),
+      m_index(selection.product != NoId ? &logData.sessionIndex() : NULL),
+      m_position(0)
+{
+}
+
+bool SessionCursor::next(size_t& session)
+{
+    if (m_index != NULL)
+    {
+        for (;;)
+        {
+            session = m_index->nextOverlapping(m_selection.product, m_selection.from, m_selection.to, m_position);
+            if (session == NoId)
+            {
+                return false;
+            }
+            if (selects(session))
+            {
+                return true;
+            }
+        }
+    }
+
+    const vector<Session>& sessions = m_logData.sessions();
+    const EventStore& events = m_logData.events();
+    while (m_position < sessions.size())
+    {
+        session = m_position++;
+        long long checkOut = events.timestamps[sessions[session].checkOutRow];
+        long long checkIn = checkOut + sessions[session].duration;
+        if (checkIn > checkOut && checkOut < m_selection.to && checkIn > m_selection.from && selects(session))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SessionCursor::selects(size_t session) const
+{
+    const EventStore& events = m_logData.events();
+    size_t row = m_logData.sessions()[session].checkOutRow;
+    return (m_selection.user == NoId || events.users[row] == m_selection.user) &&
+           (m_selection.host == NoId || events.hosts[row] == m_selection.host);
+}
+
+EventCursor::EventCursor(const LogData& logData, const LogSelection& selection, unsigned int types)
+    : m_events(logData.events()),
+      m_selection(selection),
+      m_types(types),
+      m_row(0)
+{
+    if (m_selection.from != LLONG_MIN || m_selection.to != LLONG_MAX)
+    {
+        m_types &= ~eventTypeBit(ProductEvent);
+    }
+    if (m_selection.host != NoId)
+    {
+        m_types &= ~eventTypeBit(StartEvent);
+    }
+}
+
+bool EventCursor::next(size_t& row)
+{
+    while (m_row < m_events.size())
+    {
+        row = m_row++;
+        long long timestamp = m_events.timestamps[row];
+        if ((m_types & eventTypeBit(m_events.types[row])) != 0 &&
+            timestamp >= m_selection.from && timestamp < m_selection.to &&
+            (m_selection.product == NoId || m_events.products[row] == m_selection.product) &&
+            (m_selection.user == NoId || m_events.users[row] == m_selection.user) &&
+            (m_selection.host == NoId || m_events.hosts[row] == m_selection.host))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+UsageCursor::UsageCursor(const LogData& logData, const LogSelection& selection)
+    : m_logData(logData),
+      m_selection(selection),
+      m_usageRow(selection.from == LLONG_MIN ? 0 : logData.firstUsageRowAfter(selection.from - 1)),
+      m_change(NoId)
+{
+}
+
+bool UsageCursor::next(UsageStep& step)
+{
+    const vector<size_t>& offsets = m_logData.usageChangeOffsets();
+    const vector<UsageChange>& changes = m_logData.usageChanges();
+    for (; m_usageRow < m_logData.usageRowCount(); ++m_usageRow, m_change = NoId)
+    {
+        long long time = m_logData.usageRowTime(m_usageRow);
+        if (time >= m_selection.to)
+        {
+            m_usageRow = m_logData.usageRowCount();
+            return false;
+        }
+        if (m_change == NoId)
+        {
+            m_change = offsets[m_usageRow];
+        }
+        while (m_change < offsets[m_usageRow + 1])
+        {
+            const UsageChange& change = changes[m_change++];
+            if (m_selection.product == NoId || change.product == m_selection.product)
+            {
+                step.time = time;
+                step.eventRow = m_logData.usageRows()[m_usageRow];
+                step.change = change;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+#include "EventStore.h"
+#include "LogData.h"
+
+using namespace std;
+
+// What a cursor walks: the sessions, events or usage changes of a product,
+// user and host (NoId for any) at times in [from, to)
+struct LogSelection
+{
+    LogSelection() : product(NoId), user(NoId), host(NoId), from(LLONG_MIN), to(LLONG_MAX) {}
+
+    size_t product;
+    size_t user;
+    size_t host;
+    long long from;
+    long long to;
+};
+
+// The event types an event cursor takes, one bit per eventType
+inline unsigned int eventTypeBit(eventType type)
+{
+    return 1u << static_cast<unsigned int>(type);
+}
+const unsigned int AllEventTypes = (1u << (ProductEvent + 1)) - 1;
+
+// A change of the timeline a usage cursor yields: the counters of the
+// product after the event at eventRow
+struct UsageStep
+{
+    long long time;
+    size_t eventRow;
+    UsageChange change;
+};
+
+// Pull-based walks over the results of an analyzed log.  Each next() finds
+// the next match when it is asked for, so a caller that stops early, e.g.
+// after the first sessions of a product in March, does not pay for the
+// rest, and none of them copies the results.  A cursor reads the log data
+// in place and is valid until it is parsed or analyzed again.
+//
+// A session overlaps [from, to) while it holds its license, as in the
+// session index: sessions without checked out time never do.  With a
+// product, the sessions come from the index in check-out order; without,
+// every session is looked at in the order of sessions().
+class SessionCursor
+{
+    public:
+        SessionCursor(const LogData& logData, const LogSelection& selection);
+
+        // The index of the next session into sessions(); false after the last
+        bool next(size_t& session);
+
+    private:
+        bool selects(size_t session) const;
+
+        const LogData& m_logData;
+        LogSelection m_selection;
+        const SessionIndex* m_index;
+        size_t m_position;
+};
+
+// The events of the types (an or of eventTypeBit) in the order of the log.
+// PRODUCT events have no time and are only taken without a time range; a
+// host selects the OUT, IN and DENY events of the host, not the servers of
+// START events.
+class EventCursor
+{
+    public:
+        EventCursor(const LogData& logData, const LogSelection& selection, unsigned int types = AllEventTypes);
+
+        // The next event row; false after the last
+        bool next(size_t& row);
+
+    private:
+        const EventStore& m_events;
+        LogSelection m_selection;
+        unsigned int m_types;
+        size_t m_row;
+};
+
+// The changes of the concurrent usage timeline from the first entry at or
+// after from up to the first at or after to, of the product or of every
+// product.  A user or host does not select counter changes and is ignored.
+class UsageCursor
+{
+    public:
+        UsageCursor(const LogData& logData, const LogSelection& selection);
+
+        bool next(UsageStep& step);
+
+    private:
+        const LogData& m_logData;
+        LogSelection m_selection;
+        size_t m_usageRow;
+        size_t m_change;
+};
+
+// Pulls up to maxItems more items of a cursor into items, e.g. to hand
+// them out in batches; returns their number, 0 after the last
+template <typename Cursor, typename Item>
+size_t pullBatch(Cursor& cursor, vector<Item>& items, size_t maxItems)
+{
+    items.clear();
+    Item item;
+    while (items.size() < maxItems && cursor.next(item))
+    {
+        items.push_back(item);
+    }
+    return items.size();
+}
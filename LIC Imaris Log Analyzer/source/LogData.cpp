@@ -22,6 +22,18 @@
 
 #include "Exceptions.h"
 #include "Utilities.h"
+#include "Tokenizer.h"
+#include "BufferedWriter.h"
+#include "BlockReader.h"
+#include "ArrowWriter.h"
+#include "SqliteDatabase.h"
+#include "ThreadPool.h"
+#include "ResourceLimits.h"
+#include "OrderedMerge.h"
+#include "Cancellation.h"
+#include "TraceRecorder.h"
+#include "HeapBytes.h"
+#include "CheckedAccess.h"
 
 #include <iostream>
 #include <sstream>
@@ -29,1033 +41,6509 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
 #include <assert.h>
 #include <map>
+#include <memory>
+#include <limits>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include "LogData.h"
 
 using namespace std;
 
+// Bytes at the start of the log and before the checkpoint offset that must
+// be unchanged for an incremental run to resume
+const size_t CheckpointHashedLength = 4096;
 
-LogData::LogData(const string& inputFilePath, const string& outputDirectory)
+// The reports that need the concurrent usage pass
+const unsigned int UsageReports = ConcurrentUsageReport | UsageHeatmapReport | LicenseSaturationReport |
+                                  DeniedRequestsReport | HourlyDenialsReport | SustainedPeaksReport | VersionUsageReport |
+                                  ReservedUsageReport;
+
+// A pipelined analysis parses the log in more, smaller chunks, so that the
+// concurrent usage pass can start on the first ones while the others are
+// parsed; at most UsageBatchesAhead of them wait for the pass
+const size_t PipelinedChunksPerThread = 4;
+const size_t MinPipelinedChunkSize = 1 << 20;
+const size_t UsageBatchesAhead = 8;
+
+// The passes over the events poll for cancellation every so many rows (see
+// Cancellation.h), the parse every LineIndexStride lines
+const size_t CancellationPollRows = 1 << 16;
+
+// A concurrent usage pass over fewer events is not split by product, nor
+// the session pairing by handle
+const size_t MinShardedUsageEvents = 1 << 16;
+const size_t MinShardedSessionEvents = 1 << 16;
+
+// The large reports of a large analysis are formatted in batches of rows
+// on the pool, at most ReportBatchesAheadPerThread of them per thread ahead
+// of the writer (see writeRowRanges)
+const size_t ReportRowsPerBatch = 1 << 14;
+const size_t ReportBatchesAheadPerThread = 2;
+
+// The offset of every LineIndexStride-th line of a chunk is indexed, so a
+// line is read back after skipping at most as many lines of the log
+const size_t LineIndexStride = 1024;
+
+namespace
+{
+    // Rearranges the rows of a column from firstRow on in the given order
+    // of the old rows
+    template <typename T>
+    void permuteRows(vector<T>& column, size_t firstRow, const vector<size_t>& order)
+    {
+        vector<T> rows(order.size());
+        for (size_t row = 0; row < order.size(); ++row)
+        {
+            rows[row] = column[order[row]];
+        }
+        copy(rows.begin(), rows.end(), column.begin() + firstRow);
+    }
+
+    // Raises every counter of maxima to at least the one in counters
+    void raiseCounters(vector<UsageCounters>& maxima, const vector<UsageCounters>& counters)
+    {
+        if (maxima.size() < counters.size())
+        {
+            maxima.resize(counters.size(), UsageCounters());
+        }
+        for (size_t product = 0; product < counters.size(); ++product)
+        {
+            UsageCounters& maximum = maxima[product];
+            const UsageCounters& productCounters = counters[product];
+            maximum.floatingInUse = max(maximum.floatingInUse, productCounters.floatingInUse);
+            maximum.totalInUse = max(maximum.totalInUse, productCounters.totalInUse);
+            maximum.floatingLimit = max(maximum.floatingLimit, productCounters.floatingLimit);
+            maximum.reservedInUse = max(maximum.reservedInUse, productCounters.reservedInUse);
+            maximum.reservedLimit = max(maximum.reservedLimit, productCounters.reservedLimit);
+        }
+    }
+
+    // Every name of a table as a quoted JSON string, so that the JSON
+    // exports escape each name once rather than on every line
+    vector<string> jsonNames(const StringInterner& names)
+    {
+        vector<string> quoted(names.size());
+        for (size_t name = 0; name < names.size(); ++name)
+        {
+            appendJsonString(quoted[name], names.name(name));
+        }
+        return quoted;
+    }
+
+    // A name of jsonNames, or null for none
+    void writeJsonName(BufferedWriter& out, const vector<string>& names, size_t id)
+    {
+        out.write(id == NoId ? string_view("null") : string_view(names[id]));
+    }
+
+    // One shard of a parallel concurrent usage pass: the products
+    // [firstProduct, endProduct) and the tables it fills for them
+    // Whether the sessions of a checkpoint were billed by the groups of the
+    // mapping, none without one.  Those of another mapping cannot be billed
+    // anew, so its checkpoint is not resumed from.
+    bool billedByGroups(const GroupMapping* mapping, const vector<string>& groups)
+    {
+        if (mapping == NULL || groups.size() != mapping->groups())
+        {
+            return mapping == NULL && groups.empty();
+        }
+        for (size_t group = 0; group < groups.size(); ++group)
+        {
+            if (groups[group] != mapping->group(group))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct UsageShard
+    {
+        size_t firstProduct;
+        size_t endProduct;
+        UsageHeatmap heatmap;
+        SustainedPeaks peaks;
+        LicenseSaturation saturation;
+        VersionUsage versions;
+        vector<size_t> saturationRows;
+        vector<size_t> usageChangeOffsets;
+        vector<UsageChange> usageChanges;
+        vector<size_t> heldLicenseCounts;
+        vector<size_t> reservedCheckOuts;
+        map<pair<long long, size_t>, HourlyDenials> hourlyDenials;
+    };
+}
+
+LogData::LogData(const string& inputFilePath,
+                 const string& outputDirectory,
+                 ThreadPool* pool,
+                 bool incremental,
+                 bool useEventCache,
+                 analysisScope scope,
+                 unsigned int reports,
+                 size_t invalidLineBudget,
+                 const DateRange& dateRange,
+                 const EventFilter& eventFilter)
+{
+    initialize(inputFilePath, outputDirectory, pool, incremental, useEventCache, scope, reports,
+               invalidLineBudget, dateRange, eventFilter);
+
+    // The format is probed from the head of the file first, so that a file
+    // which is not a report log is rejected without being loaded.  Every
+    // stage is timed for the statistics (see PipelineStats).
+    {
+        StageTimer stage(m_stats, "detect format");
+        findFileFormat();
+    }
+    if (m_analysisScope == OutputPathsOnly)
+    {
+        setOutputPaths();
+        return;
+    }
+
+    bool cached = openInput();
+    setOutputPaths();
+    if (m_incremental && m_fileFormat == ReportLog)
+    {
+        StageTimer stage(m_stats, "resume from checkpoint");
+        resumeFromCheckpoint();
+    }
+    if (cached)
+    {
+        describeLog(true, true);
+        applyDateRange();
+        indexServerRuns();
+        m_parsed = true;
+        analyzeEvents();
+    }
+    else
+    {
+        analyzeLog();
+    }
+    m_analyzed = true;
+}
+
+LogData::LogData(const string& inputFilePath, ThreadPool* pool)
+{
+    initialize(inputFilePath, string(), pool, false, false, FullAnalysis, AllReports, 0, DateRange(), EventFilter());
+
+    StageTimer stage(m_stats, "detect format");
+    findFileFormat();
+}
+
+void LogData::initialize(const string& inputFilePath,
+                         const string& outputDirectory,
+                         ThreadPool* pool,
+                         bool incremental,
+                         bool useEventCache,
+                         analysisScope scope,
+                         unsigned int reports,
+                         size_t invalidLineBudget,
+                         const DateRange& dateRange,
+                         const EventFilter& eventFilter)
 {
     m_inputFilePath = inputFilePath;
+    m_stats = PipelineStats(inputFilePath);
+    m_progress = currentProgressReporter();
+    m_groupMapping = currentGroupMapping();
     m_outputDirectory = outputDirectory;
     m_inputFileName = getFilenameFromFilepath(m_inputFilePath);
+    m_compression = detectCompression(inputFilePath);
+    // The reports of server.log.gz are named like those of server.log
+    if (m_compression != Uncompressed && m_inputFileName.size() > 4 &&
+        m_inputFileName.compare(m_inputFileName.size() - 4, 4, ".log") == 0)
+    {
+        m_inputFileName = getFilenameFromFilepath(m_inputFileName);
+    }
+    m_eventYear = 0;
+    m_endTimeRow = 0;
+    m_filteredEndTime = LLONG_MIN;
+    m_usageFormat = WideUsage;
+    m_usageBucketSeconds = 0;
+    m_outputPartition = NoPartition;
+    m_pool = pool;
+    // A compressed log cannot grow by whole lines, so it is always analyzed
+    // in full
+    m_incremental = incremental && m_compression == Uncompressed;
+    m_useEventCache = useEventCache && ! incremental;
+    m_arrowExport = false;
+    m_sqliteExport = false;
+    m_jsonExport = false;
+    m_usagePipelined = false;
+    m_described = false;
+    // A log on a network share, one too large to map, or one that would
+    // take more than a quarter of the memory limit mapped, is read ahead
+    // instead, unless an incremental analysis needs the mapping to resume
+    // and follow
+    m_blockInput = (m_compression != Uncompressed) ||
+                   (! m_incremental && (useReadAhead(inputFilePath) || ! MappedFile::fits(inputFilePath) ||
+                                        (memoryLimit() > 0 && static_cast<uint64_t>(max(getFileSize(inputFilePath), 0LL)) > memoryLimit() / 4)));
+    // Only the output paths of an incremental analysis can be derived
+    // without resuming it
+    m_analysisScope = (m_incremental && scope != OutputPathsOnly) ? FullAnalysis : scope;
+    m_reports = m_incremental ? static_cast<unsigned int>(AllReports) : (reports & AllReports);
+    m_reportDestination = (outputDirectory == StandardOutputPath) ? outputDirectory : string();
+    m_writtenReports = AllReports;
+    m_denialUsage = false;
+    m_reportCompression = Uncompressed;
+    m_indexedUsageTime = 0;
+    m_indexedUsageRows = 0;
+    m_sessionIndexBuilt = false;
+    m_resumed = false;
+    m_inputOffset = 0;
+    m_inputEnd = 0;
+    m_inputLines = 0;
+    m_firstNewRow = 0;
+    m_activityLength = 0;
+    m_saturationLength = 0;
+    m_parsed = false;
+    m_analyzed = false;
+    m_invalidLineBudget = invalidLineBudget;
+    // An incremental analysis carries its state over the whole log
+    m_dateRange = m_incremental ? DateRange() : dateRange;
+    m_pastRangeEnd = false;
+    m_mergedDenials = 0;
+    m_eventsPerByte = 0.0;
+    m_usageRowsPerByte = 0.0;
+    setEventFilter(eventFilter);
+    // The cache holds the events of the whole log as they are written, each
+    // denial on its own
+    m_useEventCache = m_useEventCache && ! m_filtering && m_denialWindow == 0 && m_reorderWindow == 0;
+}
 
-    loadDataFromFile(m_inputFilePath, m_rawData);
-
-    findFileFormat();
-    setOutputPaths();
-    parseDataInto2DVector(m_rawData, m_allData);
-    extractEvents();
-    getConcurrentUsage();
+void LogData::setEventFilter(const EventFilter& eventFilter)
+{
+    const NameFilter* filters[] = { &eventFilter.products, &eventFilter.users, &eventFilter.hosts };
+    for (size_t field = 0; field < FilterFields; ++field)
+    {
+        m_filterNames[field].clear();
+        for (size_t name = 0; name < filters[field]->names.size(); ++name)
+        {
+            m_filterNames[field].intern(filters[field]->names.at(name));
+        }
+        m_filterExcludes[field] = filters[field]->exclude;
+    }
+    m_filtering = ! m_incremental && eventFilter.active();
+    // Merged denials could not be split up again when the log grows, nor
+    // could the events appended before be reordered
+    m_denialWindow = m_incremental ? 0 : max(eventFilter.denialWindow, 0LL);
+    m_reorderWindow = m_incremental ? 0 : max(eventFilter.reorderWindow, 0LL);
+    m_reorderBuffer.setWindow(m_reorderWindow);
+    m_reorderBuffer.clear();
+    m_forgottenSessions.setPolicy(eventFilter.forgotten);
+}
 
-    if (m_fileFormat == ReportLog)
+// The events of an unchanged log may come from its event cache, and then
+// the log is not read at all.  Otherwise the input is memory-mapped and
+// read in a single pass: each line is tokenized, projected into the event
+// store and dropped again.  A compressed log, or one read ahead, is read
+// block by block during that pass instead (see extractBlockEvents).
+// Returns whether the events came from the cache.
+bool LogData::openInput()
+{
+    bool cached = false;
+    if (m_useEventCache)
+    {
+        StageTimer stage(m_stats, "load event cache");
+        cached = loadEventCache();
+        if (cached && ! m_dateRange.bounded())
+        {
+            loadRollupCache();
+        }
+        if (cached && m_progress != NULL)
+        {
+            m_progress->add(static_cast<uint64_t>(max(getFileSize(m_inputFilePath), 0LL)), m_events.size());
+        }
+        stage.setEvents(m_events.size());
+    }
+    if (! cached && ! m_blockInput)
     {
-        getUsageDurationUser(); 
-        getUsageDurationHost();
-        getDeniedRequests();
+        StageTimer stage(m_stats, "map log");
+        m_inputFile.open(m_inputFilePath);
+        stage.setBytes(m_inputFile.size());
     }
+    return cached;
 }
 
-// Function to get the LOG Format. Imaris License Server RLM uses the RLM "ReportLog" Format. 
-// Any ISV-related code was removed for LIC Imaris Log Analyzer since it does not contain all required data
-void LogData::findFileFormat()
+void LogData::parse(bool useEventCache, size_t invalidLineBudget, const DateRange& dateRange,
+                    const EventFilter& eventFilter)
 {
-    m_fileFormat = Invalid;
-    size_t found;
+    if (m_parsed)
+    {
+        return;
+    }
+    m_invalidLineBudget = invalidLineBudget;
+    m_dateRange = dateRange;
+    setEventFilter(eventFilter);
+    m_useEventCache = useEventCache && ! m_filtering && m_denialWindow == 0 && m_reorderWindow == 0;
+    if (openInput())
+    {
+        describeLog(true, true);
+        applyDateRange();
+        indexServerRuns();
+    }
+    else
+    {
+        extractLog();
+    }
+    m_parsed = true;
+    accountMemory("parse");
+}
 
-    // Don't search the whole file when the identifying markers are near the beginning
-    size_t linesToSearch = 20;
-    if (m_rawData.size() < linesToSearch)
+void LogData::analyze(unsigned int results)
+{
+    if (m_analyzed)
     {
-        linesToSearch = m_rawData.size();
+        return;
     }
+    parse();
+    m_reports = results & AllReports;
+    analyzeEvents();
+    m_analyzed = true;
+}
+
+// The stages of the analysis.  Each one drops what only it needed once it
+// is done, unless an incremental analysis still needs it to save a
+// checkpoint or follow the log.
+void LogData::analyzeLog()
+{
+    extractLog(canPipelineUsage());
+    m_parsed = true;
+    accountMemory("parse");
+    analyzeEvents();
+}
 
-    for (size_t line=0; line<m_rawData.size(); ++line)
+void LogData::extractLog(bool pipelineUsage)
+{
     {
-        found = m_rawData.at(line).find("RLM Report Log Format");
-        if (found!=std::string::npos)
+        StageTimer stage(m_stats, "tokenize and extract events");
+        size_t firstRow = m_events.size();
+        ChunkTuning tuning = ChunkTuning();
+        if (pipelineUsage)
         {
-            m_fileFormat = ReportLog;
-            return;
+            startConcurrentUsage();
+            size_t countedRows = m_firstNewRow;
+            m_usageStage.reset(new PipelineStage<UsageBatch>(UsageBatchesAhead, [this, countedRows](UsageBatch& batch) mutable
+            {
+                countUsage(countedRows, batch.endRow, batch.products, batch.users);
+                countedRows = batch.endRow;
+            }));
         }
-        // Looking for the ISV log format, which is of this form:
-        //   MM/YY HH:MM (isv)
-        found = m_rawData.at(line).find("/");
-        if (found!=std::string::npos)
+        try
         {
-            found = m_rawData.at(line).find(":");
-            if (found!=std::string::npos)
-            {
-                found = m_rawData.at(line).find("(");
-                if (found!=std::string::npos)
-                {
-                    found = m_rawData.at(line).find(")");
-                    if (found!=std::string::npos)
-                    {
-                        // RLM itself has a log file that matches the form of the ISV log file, except instead
-                        // of each line containing '(isv)', each line contains '(rlm)'.
-                        // This log file doesn't have usage data in it, so it's not supported.
-                        found = m_rawData.at(line).find("(rlm)");
-                        if (found==std::string::npos)
-                        {
-                            m_fileFormat = ISVLog;
-
-                            // Throw error if ISV log is detected
-                            // ISV Logs not supported for LIC Imaris Log Analyzer 
-                            InvalidFileFormatException invalidFileFormatException;
-                            throw invalidFileFormatException;
-                            return;
-                        }
-                    }
-                }
-            }
+            extractEvents(m_pool, &tuning);
+        }
+        catch (...)
+        {
+            m_usageStage.reset();
+            throw;
+        }
+        if (tuning.chunks > 0)
+        {
+            tuning.stage = "tokenize and extract events";
+            m_stats.recordTuning(tuning);
         }
+        stage.setBytes(m_inputEnd - m_inputOffset);
+        stage.setEvents(m_events.size() - firstRow);
+    }
+    if (pipelineUsage)
+    {
+        finishUsagePipeline();
+    }
+    releaseInput();
+    // A cache without the skipped lines would hide them from later runs, and
+    // a limited date range leaves out the rest of the log
+    bool cached = false;
+    if (m_useEventCache && m_invalidLines.empty() && ! m_dateRange.bounded())
+    {
+        StageTimer stage(m_stats, "save event cache");
+        cached = saveEventCache();
+        stage.setEvents(m_events.size());
     }
+    describeLog(! m_dateRange.bounded(), cached);
+    recountSelectedUsage();
+    applyDateRange();
+    indexServerRuns();
+}
 
-    // Throw error if file format is not Report Log (RLM)
-    InvalidFileFormatException invalidFileFormatException;
-    throw invalidFileFormatException;
+// The concurrent usage pass can run while the log is parsed only if the
+// events do not change once they are appended: no date range, no merged
+// denials and no recount of the in-use counts.  An incremental
+// analysis resumes the pass from its checkpoint instead.  The pass takes a
+// thread of its own, which only pays off with a second core.
+bool LogData::canPipelineUsage() const
+{
+    return m_pool != NULL && m_pool->size() > 1 && m_analysisScope == FullAnalysis && ! m_incremental && countsUsage() &&
+           ! m_dateRange.bounded() && m_denialWindow == 0 && ! recountsUsage();
 }
 
-size_t LogData::fileFormat()
+// Hands the rows appended since the last batch to the concurrent usage pass
+void LogData::pushUsageBatch()
 {
-    return m_fileFormat;
+    UsageBatch batch;
+    batch.endRow = m_events.size();
+    batch.products = m_uniqueProducts.size();
+    batch.users = m_uniqueUsers.size();
+    m_usageStage->push(batch);
 }
 
+// Waits for the pass to count the last batch and completes it like
+// updateConcurrentUsage does.  The pass started with no products, so the
+// timeline starts from zero counters for all of them.
+void LogData::finishUsagePipeline()
+{
+    StageTimer stage(m_stats, "concurrent usage");
+    unique_ptr< PipelineStage<UsageBatch> > usageStage(move(m_usageStage));
+    usageStage->finish();
+    m_usageHeatmap.flush();
+    indexConcurrentUsage();
+    m_initialUsageCounters.resize(m_uniqueProducts.size(), UsageCounters());
+    releaseUsageCounters();
+    m_usagePipelined = true;
+    stage.setEvents(m_events.size() - m_firstNewRow);
+}
 
-void LogData::extractEvents()
+// Takes down what a catalog records of the log while its events are still
+// all there, if they are those of the whole log
+void LogData::describeLog(bool wholeLog, bool cached)
 {
-    // Call for indices (check LogData.cpp and header LogData.h)
-    getEventIndices();
+    m_described = wholeLog && ! m_incremental && ! m_filtering && m_denialWindow == 0 && keepsLicenseEvents();
+    m_catalogEntry = CatalogEntry();
+    if (! m_described)
+    {
+        return;
+    }
 
-    string productName;
-    string userName;
-    string hostName;
-    string denialReason;
-    size_t eventRow;
+    m_catalogEntry.inputFilePath = m_inputFilePath;
+    for (size_t row = 0; row < m_events.size(); ++row)
+    {
+        if (m_events.types[row] != ProductEvent)
+        {
+            m_catalogEntry.firstTime = min(m_catalogEntry.firstTime, m_events.timestamps[row]);
+            m_catalogEntry.lastTime = max(m_catalogEntry.lastTime, m_events.timestamps[row]);
+        }
+    }
+    for (size_t server = 0; server < m_uniqueServers.size(); ++server)
+    {
+        m_catalogEntry.servers.push_back(string(m_uniqueServers.name(server)));
+    }
+    for (size_t product = 0; product < m_uniqueProducts.size(); ++product)
+    {
+        m_catalogEntry.products.push_back(string(m_uniqueProducts.name(product)));
+    }
+    m_catalogEntry.eventCount = m_events.size();
+    if (cached)
+    {
+        m_catalogEntry.cachePath = eventCachePath(m_inputFilePath);
+    }
+}
+
+// Leaves out the events outside the date range, once they are all
+// extracted.  The state the range starts from is kept: the limits of the
+// PRODUCT events and the check-outs still open at its start, which then
+// count from its start.  Everything after the first event past its end is
+// dropped, as the parser stops there.  The users and hosts are interned
+// again, so that only the ones in the range show in the reports.
+void LogData::applyDateRange()
+{
+    if (! m_dateRange.bounded())
+    {
+        return;
+    }
+    StageTimer stage(m_stats, "date range");
+
+    size_t eventCount = m_events.size();
+    vector<bool> keep(eventCount, false);
+
+    // The check-outs open before the range, listed by handle like the
+    // sessions of getSessions
+    vector<size_t> lastOpenOut(m_uniqueHandles.size(), NoId);
+    vector<size_t> nextOpenOut(eventCount, NoId);
+    vector<size_t> openHandles;
+    // The last check-out or check-in of every product before the range,
+    // whose counts are the ones in use at its start
+    vector<size_t> lastCountRow(m_uniqueProducts.size(), NoId);
 
-    for (size_t row=0; row<m_allData.size(); ++row)
+    for (size_t row = 0; row < eventCount; ++row)
     {
-        // Check for existence of date, and if so update the year
-        if (m_allData.at(row).size() == 2)
+        eventType type = m_events.types[row];
+        long long timestamp = m_events.timestamps[row];
+        if (type == ProductEvent)
         {
-            vector<string> tempVector;
-            tokenizeString("/", m_allData.at(row).at(0), tempVector);
-            if (tempVector.size() == 3)
+            keep[row] = true;
+        }
+        else if (timestamp >= m_dateRange.to)
+        {
+            break;
+        }
+        else if (timestamp >= m_dateRange.from)
+        {
+            keep[row] = true;
+        }
+        else if (type == OutEvent)
+        {
+            size_t handle = m_events.handles[row];
+            if (lastOpenOut[handle] == NoId)
             {
-                m_eventYear = tempVector.at(2);
+                openHandles.push_back(handle);
             }
+            nextOpenOut[row] = lastOpenOut[handle];
+            lastOpenOut[handle] = row;
+            lastCountRow[m_events.products[row]] = row;
         }
-
-        if (m_allData.at(row).size() > m_eventIndex)
+        else if (type == InEvent)
+        {
+            lastOpenOut[m_events.handles[row]] = NoId;
+            lastCountRow[m_events.products[row]] = row;
+        }
+        else if (startsEpoch(type))
         {
-            // Load Imaris license check-out events into vector
-            if (m_allData.at(row).at(m_eventIndex) == "OUT")
+            for (size_t handle = 0; handle < openHandles.size(); ++handle)
             {
-                loadEventIntoVector(m_allData.at(row), row, m_OUTindices);
-                eventRow = m_eventData.size()-1;
-                productName = m_eventData.at(eventRow).at(IndexProduct);
-                getUniqueItems(productName, m_uniqueProducts);
-                userName = m_eventData.at(eventRow).at(IndexUser);
-                getUniqueItems(userName, m_uniqueUsers);
-
-                // extract hostnames too for OUT events
-                hostName = m_eventData.at(eventRow).at(IndexHost);
-                getUniqueItems(hostName, m_uniqueHosts);
-                
-                eventRow = m_eventData.size()-1;
-                addYearToDate();
-                m_endTimeRow = eventRow;
+                lastOpenOut[openHandles[handle]] = NoId;
             }
+            openHandles.clear();
+        }
+    }
+    vector<bool> carried(eventCount, false);
+    vector<long long> carriedCount(m_uniqueProducts.size(), 0);
+    for (size_t handle = 0; handle < openHandles.size(); ++handle)
+    {
+        for (size_t row = lastOpenOut[openHandles[handle]]; row != NoId; row = nextOpenOut[row])
+        {
+            keep[row] = true;
+            carried[row] = true;
+            m_events.timestamps[row] = m_dateRange.from;
+            ++carriedCount[m_events.products[row]];
+        }
+    }
+    // The open check-outs of a product count up to the server's counts of
+    // its last event before the range, so that none of them shows more in
+    // use at the start than there was
+    vector<long long> carriedSeen(m_uniqueProducts.size(), 0);
+    for (size_t row = 0; row < eventCount; ++row)
+    {
+        if (carried[row])
+        {
+            size_t product = m_events.products[row];
+            size_t countRow = lastCountRow[product];
+            long long inUse = static_cast<long long>(m_events.counts[countRow]) - carriedCount[product] + (++carriedSeen[product]);
+            m_events.counts[row] = static_cast<int32_t>(max(inUse, 0LL));
+            m_events.reserved[row] = m_events.reserved[countRow];
+        }
+    }
 
-            // Load Imaris license check-in events into vector
-            else if (m_allData.at(row).at(m_eventIndex) == "IN")
+    // Compact the kept events and renumber the rows, users and hosts
+    vector<size_t> newRows(eventCount, NoId);
+    vector<size_t> newUsers(m_uniqueUsers.size(), NoId);
+    vector<size_t> newHosts(m_uniqueHosts.size(), NoId);
+    StringInterner users;
+    StringInterner hosts;
+    size_t endTimeRow = 0;
+    size_t keptRows = 0;
+    for (size_t row = 0; row < eventCount; ++row)
+    {
+        if (! keep[row])
+        {
+            continue;
+        }
+        eventType type = m_events.types[row];
+        size_t user = m_events.users[row];
+        size_t host = m_events.hosts[row];
+        if (user != NoId)
+        {
+            if (newUsers[user] == NoId)
             {
-                loadEventIntoVector(m_allData.at(row), row, m_INindices);
-                eventRow = m_eventData.size()-1;
-                productName = m_eventData.at(m_eventData.size()-1).at(IndexProduct);
-                getUniqueItems(productName, m_uniqueProducts);
-                userName = m_eventData.at(eventRow).at(IndexUser);
-                getUniqueItems(userName, m_uniqueUsers);
-                
-                // extract hostnames too for IN events
-                hostName = m_eventData.at(eventRow).at(IndexHost);
-                getUniqueItems(hostName, m_uniqueHosts);
-                
-                eventRow = m_eventData.size()-1;
-                addYearToDate();
-                m_endTimeRow = eventRow;
+                newUsers[user] = users.intern(m_uniqueUsers.name(user));
             }
-
-            // Load Imaris license denial events into vector
-            else if (m_allData.at(row).at(m_eventIndex) == "DENY")
+            user = newUsers[user];
+        }
+        // A START event's host is the license server, a name of its own
+        if (host != NoId && type != StartEvent)
+        {
+            if (newHosts[host] == NoId)
             {
-                loadEventIntoVector(m_allData.at(row), row, m_DENYindices);
-                eventRow = m_eventData.size() - 1;
-                productName = m_eventData.at(m_eventData.size() - 1).at(IndexProduct);
-                getUniqueItems(productName, m_uniqueProducts);
-                userName = m_eventData.at(eventRow).at(IndexUser);
-                getUniqueItems(userName, m_uniqueUsers);
-                                
-                // extract hostnames too for DENY events
-                hostName = m_eventData.at(eventRow).at(IndexHost);
-                getUniqueItems(hostName, m_uniqueHosts);
-                
-                eventRow = m_eventData.size() - 1;
-                addYearToDate();
-                m_denialEvents.push_back(m_eventData.at(eventRow));
-                m_endTimeRow = eventRow;
+                newHosts[host] = hosts.intern(m_uniqueHosts.name(host));
             }
+            host = newHosts[host];
+        }
+        if (type != ProductEvent && (type != StartEvent || m_fileFormat == ReportLog))
+        {
+            endTimeRow = keptRows;
+        }
 
-            // Load Imaris Log Server Start events into vector
-            else if (m_allData.at(row).at(m_eventIndex) == "START")
-            {
-                loadEventIntoVector(m_allData.at(row), row, m_STARTindices);
-                eventRow = m_eventData.size()-1;
-                m_serverName = m_eventData.at(eventRow).at(3);
-                m_startEvents.push_back(m_eventData.at(eventRow));
+        m_events.types[keptRows] = type;
+        m_events.timestamps[keptRows] = m_events.timestamps[row];
+        m_events.products[keptRows] = m_events.products[row];
+        m_events.versions[keptRows] = m_events.versions[row];
+        m_events.users[keptRows] = user;
+        m_events.hosts[keptRows] = host;
+        m_events.counts[keptRows] = m_events.counts[row];
+        m_events.handles[keptRows] = m_events.handles[row];
+        m_events.reserved[keptRows] = m_events.reserved[row];
+        m_eventLines[keptRows] = m_eventLines[row];
+        newRows[row] = keptRows++;
+    }
+    while (m_events.size() > keptRows)
+    {
+        m_events.removeLast();
+    }
+    m_eventLines.resize(keptRows);
+    m_uniqueUsers = move(users);
+    m_uniqueHosts = move(hosts);
+    m_endTimeRow = endTimeRow;
 
-                if (m_fileFormat == ReportLog)
-                {
-                    vector<string> tempVector;
-                    tokenizeString("/", m_allData.at(row).at(RepSTARTIndexDate), tempVector);
-                    m_eventYear =  tempVector.at(2);
-                    m_endTimeRow = eventRow;
-                }
-            }
+    // The requests of the coalesced denials go with their denials.  Only
+    // those in the range were merged, so the dropped ones stand for one
+    size_t keptDenials = 0;
+    for (size_t denial = 0; denial < m_denialRepeats.size(); ++denial)
+    {
+        if (newRows.at(m_denialRows[denial]) != NoId)
+        {
+            m_denialRepeats[keptDenials] = m_denialRepeats[denial];
+            m_denialLastTimes[keptDenials] = m_denialLastTimes[denial];
+            ++keptDenials;
+        }
+    }
+    m_denialRepeats.resize(keptDenials);
+    m_denialLastTimes.resize(keptDenials);
 
-            // Load Imaris license Server Shutdown Events into vector
-            else if (m_allData.at(row).at(m_eventIndex) == "SHUTDOWN")
+    vector<size_t>* rowLists[] = { &m_denialRows, &m_shutdownRows, &m_startRows, &m_checkOutRows, &m_checkInRows };
+    for (size_t list = 0; list < 5; ++list)
+    {
+        vector<size_t> keptList;
+        for (size_t entry = 0; entry < rowLists[list]->size(); ++entry)
+        {
+            size_t row = rowLists[list]->at(entry);
+            if (newRows.at(row) != NoId)
             {
-                loadEventIntoVector(m_allData.at(row), row, m_SHUTindices);
-                eventRow = m_eventData.size()-1;
-                addYearToDate();
-                m_shutdownEvents.push_back(m_eventData.at(eventRow));
-                m_endTimeRow = eventRow;
+                keptList.push_back(newRows.at(row));
             }
+        }
+        rowLists[list]->swap(keptList);
+    }
+    recountEvents();
+    stage.setEvents(keptRows);
+}
+
+// Whether the event the chunk just added is known to be before or after
+// the date range.  While the chunk has not seen a year, the time of its
+// events is not known yet and applyDateRange sorts them out.
+bool LogData::beforeDateRange(const EventChunk& chunk, size_t eventRow) const
+{
+    return chunk.yearKnown && chunk.events.timestamps[eventRow] < m_dateRange.from;
+}
+
+bool LogData::afterDateRange(const EventChunk& chunk, size_t eventRow) const
+{
+    return chunk.yearKnown && chunk.events.timestamps[eventRow] >= m_dateRange.to;
+}
+
+// Whether the event filter keeps a name.  The lists are short and the
+// lookup does not allocate, so the parser tests the fields of every event
+// before it interns them: the names of a left out event never get into
+// the tables and reports.
+bool LogData::selectsName(filterField field, string_view name) const
+{
+    size_t id;
+    return m_filterNames[field].empty() || m_filterNames[field].find(name, id) != m_filterExcludes[field];
+}
+
+template <eventType Type>
+bool LogData::selectsEvent(const vector<string_view>& allDataRow) const
+{
+    typedef ReportEventLayout<Type> Layout;
+    return selectsName(FilterProducts, allDataRow[Layout::product]) &&
+           selectsName(FilterUsers, allDataRow[Layout::user]) &&
+           selectsName(FilterHosts, allDataRow[Layout::host]);
+}
+
+// The in-use counts of OUT and IN events are the server's, which include
+// the licenses of the users and hosts a filter left out.  With a user or
+// host filter they are counted again from the selected check-outs still
+// open after each event, one license each.
+// An event the filter leaves out still moves the end of the log on, up to
+// which the sessions never checked in run.  Its time is kept, and taken off
+// the pending timestamps if its year is not known yet.
+void LogData::keepFilteredEndTime(size_t eventRow, EventChunk& chunk)
+{
+    if (! chunk.pendingTimestamps.empty() && chunk.pendingTimestamps.back().eventRow == eventRow)
+    {
+        chunk.filteredEndDateTime = chunk.pendingTimestamps.back().dateTime;
+        chunk.filteredEndPending = true;
+        chunk.pendingTimestamps.pop_back();
+    }
+    else
+    {
+        chunk.filteredEndTime = chunk.events.timestamps.at(eventRow);
+        chunk.filteredEndPending = false;
+    }
+}
+
+// The in-use counts are counted again with a user or host filter, and for
+// an ISV log, whose lines carry none
+bool LogData::recountsUsage() const
+{
+    return m_fileFormat == ISVLog ||
+           (m_filtering && (! m_filterNames[FilterUsers].empty() || ! m_filterNames[FilterHosts].empty()));
+}
+
+// The OUT, IN and DENY events are kept unless the summary is the only
+// report of the analysis, which lists the starts, the shutdowns and the
+// names of the log.  The event cache, the catalog and the chargeback need
+// every event, the reorder buffer counts the late ones, and a date range
+// takes the names of the events in it.
+bool LogData::keepsLicenseEvents() const
+{
+    return m_analysisScope != FullAnalysis || (m_reports & ~SummaryReport) != 0 || m_useEventCache ||
+           m_reorderWindow > 0 || m_dateRange.bounded() || m_groupMapping != NULL;
+}
 
-            // Load product information from Imaris License Serve rinto vector
-            else if (m_allData.at(row).at(m_eventIndex) == "PRODUCT")
+void LogData::recountSelectedUsage()
+{
+    if (! recountsUsage())
+    {
+        return;
+    }
+    StageTimer stage(m_stats, "recount selected usage");
+
+    vector<uint32_t> inUse(m_uniqueProducts.size(), 0);
+    vector<bool> open(m_uniqueHandles.size(), false);
+    forLicenseRows([&](size_t row, eventType type)
+    {
+        if (type == OutEvent || type == InEvent)
+        {
+            size_t product = m_events.products[row];
+            size_t handle = m_events.handles[row];
+            if (open[handle] != (type == OutEvent))
             {
-                loadEventIntoVector(m_allData.at(row), row, m_PRODUCTindices);
-                eventRow = m_eventData.size()-1;
-                productName = m_eventData.at(eventRow).at(1);
-                getUniqueItems(productName, m_uniqueProducts);
+                open[handle] = (type == OutEvent);
+                inUse[product] = (type == OutEvent) ? inUse[product] + 1 : inUse[product] - 1;
             }
+            m_events.counts[row] = inUse[product];
         }
-    }
+        else
+        {
+            fill(inUse.begin(), inUse.end(), 0);
+            fill(open.begin(), open.end(), false);
+        }
+    });
+    stage.setEvents(m_events.size());
 }
 
-
-void LogData::addYearToDate()
+void LogData::analyzeEvents()
 {
-    if (m_fileFormat == ReportLog)
+    if (m_analysisScope != FullAnalysis)
+    {
+        return;
+    }
+    throwIfCancelled();
+
+    if (countsUsage() && ! m_usagePipelined)
+    {
+        StageTimer stage(m_stats, "concurrent usage");
+        getConcurrentUsage();
+        releaseUsageCounters();
+        stage.setEvents(m_events.size() - m_firstNewRow);
+    }
+
+    if (m_fileFormat == ReportLog &&
+        (reportSelected(LicenseActivityReport | TotalDurationHostsReport | TotalDurationUsersReport | SessionDurationsReport |
+                        TopUsageReport | VersionUsageReport | ReservedUsageReport | ForgottenSessionsReport |
+                        DemandProfileReport) ||
+         m_groupMapping != NULL))
+    {
+        {
+            StageTimer stage(m_stats, "pair sessions");
+            getSessions();
+            stage.setEvents(m_sessions.size());
+        }
+        if (reportSelected(TotalDurationHostsReport | TotalDurationUsersReport | TopUsageReport))
+        {
+            StageTimer stage(m_stats, "total durations");
+            getTotalDurations();
+            stage.setEvents(m_sessions.size());
+        }
+    }
+
+    // The rollups cover the whole log, so they are kept only from an
+    // analysis of all of it that every later run of the cache could share
+    if (m_useEventCache && m_rollups.empty() && m_reports == AllReports && m_fileFormat == ReportLog &&
+        m_invalidLines.empty() && ! m_dateRange.bounded())
+    {
+        StageTimer stage(m_stats, "rollups");
+        buildRollups();
+        saveRollupCache();
+        stage.setEvents(m_usageRows.size() + m_sessions.size());
+    }
+    accountMemory("analysis");
+}
+
+bool LogData::reportSelected(unsigned int reports) const
+{
+    return (m_reports & reports) != 0;
+}
+
+bool LogData::reportWritten(unsigned int reports) const
+{
+    return (m_reports & m_writtenReports & reports) != 0;
+}
+
+// The events are all extracted, so the mapping of the log is no longer read
+void LogData::releaseInput()
+{
+    if (! m_incremental)
+    {
+        m_inputFile.close();
+    }
+}
+
+// The timeline holds the concurrent usage, so the counters of the pass and
+// the license count by user and product are no longer read.  The reserved
+// licenses held are kept as totals for the reserved usage report.
+void LogData::releaseUsageCounters()
+{
+    vector<CheckpointEntry> holdings;
+    listReservedCounts(holdings);
+    m_reservedHoldings.assign(m_uniqueUsers.size(), m_uniqueProducts.size(), holdings);
+    if (! m_incremental)
+    {
+        vector<UsageCounters>().swap(m_usageCounters);
+        vector<UsageCounters>().swap(m_recordedCounters);
+        vector<uint32_t>().swap(m_licenseCounts);
+        vector<size_t>().swap(m_heldLicenseCounts);
+        vector<uint32_t>().swap(m_reservedCounts);
+    }
+}
+
+// The concurrent usage pass also finds the check-outs of reserved licenses,
+// which the reserved usage and the chargeback split the session time by
+bool LogData::countsUsage() const
+{
+    return reportSelected(UsageReports) || m_groupMapping != NULL;
+}
+
+// The reserved licenses held by user and product, as entries
+void LogData::listReservedCounts(vector<CheckpointEntry>& counts) const
+{
+    counts.clear();
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    for (size_t countIndex = 0; countIndex < m_reservedCounts.size(); ++countIndex)
+    {
+        if (m_reservedCounts[countIndex] > 0)
+        {
+            CheckpointEntry count = { countIndex / numberOfProducts, countIndex % numberOfProducts, m_reservedCounts[countIndex] };
+            counts.push_back(count);
+        }
+    }
+}
+
+// The heap of the structures that grow with the log, for sizing machines
+// and picking what to slim down next.  Only the thread running the stages
+// calls it, between them, so nothing changes the structures meanwhile.
+void LogData::accountMemory(const string& stage)
+{
+    if (! memoryAccounting())
+    {
+        return;
+    }
+    MemoryAccount account;
+    account.stage = stage;
+    size_t names = 0;
+    const StringInterner* interners[] = { &m_uniqueProducts, &m_uniqueUsers, &m_uniqueHosts,
+                                          &m_uniqueVersions, &m_uniqueHandles, &m_uniqueServers };
+    for (size_t interner = 0; interner < 6; ++interner)
+    {
+        names += interners[interner]->memoryBytes();
+    }
+    account.structures.push_back(make_pair(string("mapped log"), static_cast<uint64_t>(m_inputFile.size())));
+    account.structures.push_back(make_pair(string("events"), static_cast<uint64_t>(m_events.memoryBytes())));
+    account.structures.push_back(make_pair(string("line index"),
+        static_cast<uint64_t>(heapBytes(m_eventLines) + heapBytes(m_lineOffsets) + heapBytes(m_invalidLines))));
+    account.structures.push_back(make_pair(string("names"), static_cast<uint64_t>(names)));
+    account.structures.push_back(make_pair(string("denials"),
+        static_cast<uint64_t>(heapBytes(m_denialRows) + heapBytes(m_denialCounters) + heapBytes(m_hourlyDenials) +
+                              m_denialBursts.memoryBytes() + heapBytes(m_denialRepeats) + heapBytes(m_denialLastTimes))));
+    account.structures.push_back(make_pair(string("usage timeline"),
+        static_cast<uint64_t>(heapBytes(m_usageRows) + heapBytes(m_usageChangeOffsets) + heapBytes(m_usageChanges) +
+                              heapBytes(m_usageSnapshots) + heapBytes(m_indexedCounters))));
+    account.structures.push_back(make_pair(string("usage counters"),
+        static_cast<uint64_t>(heapBytes(m_usageCounters) + heapBytes(m_recordedCounters) + heapBytes(m_initialUsageCounters) +
+                              heapBytes(m_licenseCounts) + heapBytes(m_heldLicenseCounts) + heapBytes(m_reservedCounts) +
+                              heapBytes(m_reservedCheckOuts))));
+    account.structures.push_back(make_pair(string("server runs"), static_cast<uint64_t>(m_serverRuns.memoryBytes())));
+    account.structures.push_back(make_pair(string("sessions"), static_cast<uint64_t>(heapBytes(m_sessions) + heapBytes(m_checkOutRows) +
+                                                                          heapBytes(m_checkInRows))));
+    account.structures.push_back(make_pair(string("session index"), static_cast<uint64_t>(m_sessionIndex.memoryBytes())));
+    account.structures.push_back(make_pair(string("duration totals"),
+        static_cast<uint64_t>(m_totalDurationh.memoryBytes() + m_totalDurationu.memoryBytes() +
+                              m_reservedDurationu.memoryBytes() + m_floatingDurationu.memoryBytes() +
+                              m_reservedHoldings.memoryBytes())));
+    account.structures.push_back(make_pair(string("duration histograms"), static_cast<uint64_t>(m_sessionDurations.memoryBytes())));
+    account.structures.push_back(make_pair(string("usage heatmap"), static_cast<uint64_t>(m_usageHeatmap.memoryBytes())));
+    account.structures.push_back(make_pair(string("license saturation"), static_cast<uint64_t>(m_licenseSaturation.memoryBytes())));
+    account.structures.push_back(make_pair(string("event totals"), static_cast<uint64_t>(m_eventTotals.memoryBytes())));
+    account.structures.push_back(make_pair(string("sustained peaks"), static_cast<uint64_t>(m_sustainedPeaks.memoryBytes())));
+    account.structures.push_back(make_pair(string("longest sessions"),
+        static_cast<uint64_t>(m_longestSessions.memoryBytes() + m_longestClosedSessions.memoryBytes())));
+    account.structures.push_back(make_pair(string("version usage"), static_cast<uint64_t>(m_versionUsage.memoryBytes())));
+    account.structures.push_back(make_pair(string("forgotten sessions"), static_cast<uint64_t>(m_forgottenSessions.memoryBytes())));
+    account.structures.push_back(make_pair(string("demand profile"), static_cast<uint64_t>(m_demandProfile.memoryBytes())));
+    account.structures.push_back(make_pair(string("chargeback"),
+        static_cast<uint64_t>(heapBytes(m_userGroups) + heapBytes(m_hostGroups) + heapBytes(m_chargeback))));
+    account.structures.push_back(make_pair(string("rollups"), static_cast<uint64_t>(m_rollups.memoryBytes())));
+    m_stats.recordMemory(account);
+}
+
+// Drops a resumed analysis, so that the whole log is read again
+void LogData::resetAnalysis()
+{
+    m_events.clear();
+    m_eventLines.clear();
+    m_lineOffsets.clear();
+    m_denialRows.clear();
+    m_denialCounters.clear();
+    m_hourlyDenials.clear();
+    m_denialBursts.clear();
+    m_denialRepeats.clear();
+    m_denialLastTimes.clear();
+    m_mergedDenials = 0;
+    m_reorderBuffer.clear();
+    m_shutdownRows.clear();
+    m_startRows.clear();
+    m_checkOutRows.clear();
+    m_checkInRows.clear();
+    m_serverRuns.clear();
+    m_uniqueProducts.clear();
+    m_uniqueUsers.clear();
+    m_uniqueHosts.clear();
+    m_uniqueVersions.clear();
+    m_uniqueHandles.clear();
+    m_uniqueServers.clear();
+    m_eventYear = 0;
+    m_serverName.clear();
+    m_sessions.clear();
+    m_sessionIndex.clear();
+    m_sessionIndexBuilt = false;
+    m_usageRows.clear();
+    m_usageChangeOffsets.clear();
+    m_usageChanges.clear();
+    m_usageSnapshots.clear();
+    m_indexedCounters.clear();
+    m_indexedUsageTime = 0;
+    m_indexedUsageRows = 0;
+    m_totalDurationh.clear();
+    m_totalDurationu.clear();
+    m_reservedDurationu.clear();
+    m_floatingDurationu.clear();
+    m_reservedHoldings.clear();
+    m_sessionDurations.clear();
+    m_usageHeatmap.clear();
+    m_licenseSaturation.clear();
+    m_eventTotals.clear();
+    m_sustainedPeaks.clear();
+    m_longestSessions.clear();
+    m_longestClosedSessions.clear();
+    m_versionUsage.clear();
+    m_forgottenSessions.clear();
+    m_demandProfile.clear();
+    m_userGroups.clear();
+    m_hostGroups.clear();
+    m_chargeback.clear();
+    m_rollups.clear();
+    m_endTimeRow = 0;
+    m_filteredEndTime = LLONG_MIN;
+    m_usageCounters.clear();
+    m_recordedCounters.clear();
+    m_initialUsageCounters.clear();
+    m_licenseCounts.clear();
+    m_heldLicenseCounts.clear();
+    m_reservedCounts.clear();
+    m_reservedCheckOuts.clear();
+    m_usagePipelined = false;
+    m_resumed = false;
+    m_inputOffset = 0;
+    m_inputLines = 0;
+    m_firstNewRow = 0;
+    m_invalidLines.clear();
+    m_checkpoint = Checkpoint();
+}
+
+// Takes the events from the log's event cache, if there is one for the log
+// as it is now
+bool LogData::loadEventCache()
+{
+    EventCache cache;
+    if (! cache.load(eventCachePath(m_inputFilePath), m_inputFilePath))
+    {
+        return false;
+    }
+
+    // Ids and rows out of range would mean a damaged cache
+    const vector<string>* names[] = { &cache.products, &cache.versions, &cache.users,
+                                      &cache.hosts, &cache.handles, &cache.servers };
+    const EventStore& events = cache.events;
+    if (! events.validIds(names[0]->size(), names[1]->size(), names[2]->size(), names[3]->size(), names[4]->size(),
+                          names[5]->size()))
+    {
+        return false;
+    }
+    const vector<size_t>* rowLists[] = { &cache.denialRows, &cache.shutdownRows, &cache.startRows };
+    for (size_t list = 0; list < 3; ++list)
+    {
+        for (size_t row = 0; row < rowLists[list]->size(); ++row)
+        {
+            if (rowLists[list]->at(row) >= events.size())
+            {
+                return false;
+            }
+        }
+    }
+    if (cache.endTimeRow != static_cast<uint64_t>(NoId) && cache.endTimeRow >= max(events.size(), static_cast<size_t>(1)))
+    {
+        return false;
+    }
+
+    StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueVersions, &m_uniqueUsers,
+                                 &m_uniqueHosts, &m_uniqueHandles, &m_uniqueServers };
+    for (size_t table = 0; table < 6; ++table)
+    {
+        for (size_t name = 0; name < names[table]->size(); ++name)
+        {
+            tables[table]->intern(names[table]->at(name));
+        }
+    }
+    m_events = move(cache.events);
+    m_eventLines.assign(m_events.size(), 0);
+    m_denialRows = move(cache.denialRows);
+    m_shutdownRows = move(cache.shutdownRows);
+    m_startRows = move(cache.startRows);
+    listLicenseRows();
+    m_endTimeRow = static_cast<size_t>(cache.endTimeRow);
+    m_eventYear = cache.eventYear;
+    m_serverName = cache.serverName;
+    recountEvents();
+
+    return true;
+}
+
+// Saves the events just parsed to the log's event cache.  They are moved
+// into the cache and back, so they are not copied.  Returns whether the
+// cache was written.
+bool LogData::saveEventCache()
+{
+    EventCache cache;
+    const StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueVersions, &m_uniqueUsers,
+                                       &m_uniqueHosts, &m_uniqueHandles, &m_uniqueServers };
+    vector<string>* names[] = { &cache.products, &cache.versions, &cache.users,
+                                &cache.hosts, &cache.handles, &cache.servers };
+    for (size_t table = 0; table < 6; ++table)
+    {
+        for (size_t name = 0; name < tables[table]->size(); ++name)
+        {
+            names[table]->push_back(string(tables[table]->name(name)));
+        }
+    }
+    cache.events = move(m_events);
+    cache.denialRows = move(m_denialRows);
+    cache.shutdownRows = move(m_shutdownRows);
+    cache.startRows = move(m_startRows);
+    cache.endTimeRow = m_endTimeRow;
+    cache.eventYear = m_eventYear;
+    cache.serverName = m_serverName;
+
+    bool saved = cache.save(eventCachePath(m_inputFilePath), m_inputFilePath);
+
+    m_events = move(cache.events);
+    m_denialRows = move(cache.denialRows);
+    m_shutdownRows = move(cache.shutdownRows);
+    m_startRows = move(cache.startRows);
+
+    return saved;
+}
+
+// Takes the rollups kept with the event cache just loaded.  They name the
+// products, users and hosts by the ids of the same cache.
+bool LogData::loadRollupCache()
+{
+    RollupCache cache;
+    if (! cache.load(rollupCachePath(m_inputFilePath), m_inputFilePath))
+    {
+        return false;
+    }
+
+    const vector<string>* names[] = { &cache.products, &cache.users, &cache.hosts };
+    const StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueUsers, &m_uniqueHosts };
+    for (size_t table = 0; table < 3; ++table)
+    {
+        if (names[table]->size() != tables[table]->size())
+        {
+            return false;
+        }
+        for (size_t name = 0; name < names[table]->size(); ++name)
+        {
+            if (names[table]->at(name) != tables[table]->name(name))
+            {
+                return false;
+            }
+        }
+    }
+
+    return m_rollups.restore(cache);
+}
+
+// Rolls the usage timeline, the sessions and the denials by hour up into
+// days, weeks and months.  The log is observed from its first dated event
+// up to the end the open sessions run until.
+void LogData::buildRollups()
+{
+    m_rollups.clear();
+    size_t firstRow = 0;
+    while (firstRow < m_events.size() && m_events.types[firstRow] == ProductEvent)
+    {
+        ++firstRow;
+    }
+    if (firstRow == m_events.size())
+    {
+        return;
+    }
+    const long long start = m_events.timestamps[firstRow];
+    const long long end = max(endTime(), start);
+    m_rollups.addObserved(start, end);
+
+    vector<int32_t> inUse(m_uniqueProducts.size(), 0);
+    vector<long long> since(m_uniqueProducts.size(), start);
+    for (size_t usageRow = 0; usageRow < m_usageRows.size(); ++usageRow)
+    {
+        long long time = m_events.timestamps[m_usageRows[usageRow]];
+        for (size_t change = m_usageChangeOffsets[usageRow]; change < m_usageChangeOffsets[usageRow + 1]; ++change)
+        {
+            size_t product = m_usageChanges[change].product;
+            int32_t level = m_usageChanges[change].counters.floatingInUse;
+            if (level == inUse[product])
+            {
+                continue;
+            }
+            // The interval of a level, even an empty one, counts for the
+            // peak of the period it starts in
+            long long changed = max(time, since[product]);
+            if (inUse[product] > 0)
+            {
+                m_rollups.addUsage(product, since[product], changed, inUse[product]);
+            }
+            inUse[product] = level;
+            since[product] = changed;
+        }
+    }
+    for (size_t product = 0; product < inUse.size(); ++product)
+    {
+        if (inUse[product] > 0)
+        {
+            m_rollups.addUsage(product, since[product], max(end, since[product]), inUse[product]);
+        }
+    }
+
+    for (size_t session = 0; session < m_sessions.size(); ++session)
+    {
+        size_t row = m_sessions[session].checkOutRow;
+        long long checkOut = m_events.timestamps[row];
+        m_rollups.addSession(m_events.products[row], m_events.users[row], m_events.hosts[row],
+                             checkOut, checkOut + m_sessions[session].duration);
+    }
+
+    for (const auto& hour : m_hourlyDenials)
+    {
+        m_rollups.addDenials(hour.first.second, hour.first.first, hour.second.denials);
+    }
+    m_rollups.rollUp();
+}
+
+void LogData::saveRollupCache()
+{
+    RollupCache cache;
+    const StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueUsers, &m_uniqueHosts };
+    vector<string>* names[] = { &cache.products, &cache.users, &cache.hosts };
+    for (size_t table = 0; table < 3; ++table)
+    {
+        for (size_t name = 0; name < tables[table]->size(); ++name)
+        {
+            names[table]->push_back(string(tables[table]->name(name)));
+        }
+    }
+    m_rollups.save(cache);
+
+    cache.save(rollupCachePath(m_inputFilePath), m_inputFilePath);
+}
+
+// Restores the state the last incremental run saved, if its checkpoint
+// still matches the part of the log it had read
+void LogData::resumeFromCheckpoint()
+{
+    Checkpoint& checkpoint = m_checkpoint;
+    if (! checkpoint.load(m_checkpointPath) || checkpoint.inputOffset > m_inputFile.size())
+    {
+        m_checkpoint = Checkpoint();
+        return;
+    }
+
+    const char* data = m_inputFile.data();
+    size_t offset = static_cast<size_t>(checkpoint.inputOffset);
+    size_t hashedLength = min(offset, CheckpointHashedLength);
+    if (checkpointHash(data, hashedLength) != checkpoint.headHash ||
+        checkpointHash(data + offset - hashedLength, hashedLength) != checkpoint.tailHash)
+    {
+        m_checkpoint = Checkpoint();
+        return;
+    }
+
+    // Ids out of range would mean a damaged checkpoint
+    const EventStore& carried = checkpoint.carriedEvents;
+    if (! carried.validIds(checkpoint.products.size(), checkpoint.versions.size(), checkpoint.users.size(),
+                           checkpoint.hosts.size(), checkpoint.handles.size(), checkpoint.servers.size()))
+    {
+        m_checkpoint = Checkpoint();
+        return;
+    }
+    const vector<CheckpointEntry>* entries[] = { &checkpoint.licenseCounts, &checkpoint.hostDurations, &checkpoint.userDurations,
+                                                 &checkpoint.hourlyDenials, &checkpoint.chargebackSeconds, &checkpoint.reservedCounts,
+                                                 &checkpoint.reservedUserDurations, &checkpoint.floatingUserDurations };
+    size_t rowCounts[] = { checkpoint.users.size(), checkpoint.hosts.size(), checkpoint.users.size(), NoId,
+                           checkpoint.chargebackGroups.size() + 1, checkpoint.users.size(), checkpoint.users.size(),
+                           checkpoint.users.size() };
+    for (size_t list = 0; list < 8; ++list)
+    {
+        for (size_t entry = 0; entry < entries[list]->size(); ++entry)
+        {
+            if ((rowCounts[list] != NoId && entries[list]->at(entry).row >= rowCounts[list]) ||
+                entries[list]->at(entry).product >= checkpoint.products.size())
+            {
+                m_checkpoint = Checkpoint();
+                return;
+            }
+        }
+    }
+    for (size_t entry = 0; entry < checkpoint.reservedCheckOuts.size(); ++entry)
+    {
+        uint64_t row = checkpoint.reservedCheckOuts[entry];
+        if (row >= carried.size() || carried.types.at(row) != OutEvent ||
+            (entry > 0 && row <= checkpoint.reservedCheckOuts[entry - 1]))
+        {
+            m_checkpoint = Checkpoint();
+            return;
+        }
+    }
+    DurationHistograms durations;
+    durations.resize(checkpoint.products.size());
+    UsageHeatmap heatmap;
+    LicenseSaturation saturation;
+    SustainedPeaks peaks;
+    LongestSessions sessions;
+    VersionUsage versions;
+    EventTotals totals;
+    if (checkpoint.usageCounters.size() != 5 * checkpoint.products.size() ||
+        (checkpoint.endTimeRow != NoId && checkpoint.endTimeRow >= carried.size()) ||
+        ! durations.addEntries(checkpoint.durationCounts, checkpoint.longestSessions) ||
+        ! heatmap.restore(checkpoint) ||
+        ! saturation.restore(checkpoint) ||
+        ! peaks.restore(checkpoint) ||
+        ! sessions.restore(checkpoint) ||
+        ! versions.restoreConcurrency(checkpoint) ||
+        ! totals.restore(checkpoint) ||
+        ! billedByGroups(m_groupMapping, checkpoint.chargebackGroups) ||
+        checkpoint.chargebackSessions.size() != checkpoint.chargebackSeconds.size() ||
+        checkpoint.chargebackReservedSeconds.size() != checkpoint.chargebackSeconds.size() ||
+        checkpoint.hourlyDenialsAtLimit.size() != checkpoint.hourlyDenials.size())
+    {
+        m_checkpoint = Checkpoint();
+        return;
+    }
+
+    const vector<string>* names[] = { &checkpoint.products, &checkpoint.versions, &checkpoint.users,
+                                      &checkpoint.hosts, &checkpoint.handles, &checkpoint.servers };
+    StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueVersions, &m_uniqueUsers,
+                                 &m_uniqueHosts, &m_uniqueHandles, &m_uniqueServers };
+    for (size_t table = 0; table < 6; ++table)
+    {
+        for (size_t name = 0; name < names[table]->size(); ++name)
+        {
+            tables[table]->intern(names[table]->at(name));
+        }
+    }
+
+    // The carried events were counted by the run that read them
+    m_events = carried;
+    m_eventLines.assign(m_events.size(), 0);
+    m_eventTotals = totals;
+    m_reservedCheckOuts.assign(checkpoint.reservedCheckOuts.begin(), checkpoint.reservedCheckOuts.end());
+    for (size_t row = 0; row < m_events.size(); ++row)
+    {
+        if (m_events.types[row] == StartEvent)
+        {
+            m_startRows.push_back(row);
+        }
+        else if (m_events.types[row] == ShutdownEvent)
+        {
+            m_shutdownRows.push_back(row);
+        }
+    }
+    listLicenseRows();
+    if (checkpoint.endTimeRow != NoId)
+    {
+        m_endTimeRow = static_cast<size_t>(checkpoint.endTimeRow);
+    }
+
+    for (size_t product = 0; product < checkpoint.products.size(); ++product)
+    {
+        const int32_t* usage = &checkpoint.usageCounters.at(5 * product);
+        const int32_t* recorded = &checkpoint.recordedCounters.at(5 * product);
+        UsageCounters counters;
+        counters.floatingInUse = usage[0];
+        counters.totalInUse = usage[1];
+        counters.floatingLimit = usage[2];
+        counters.reservedInUse = usage[3];
+        counters.reservedLimit = usage[4];
+        m_usageCounters.push_back(counters);
+        counters.floatingInUse = recorded[0];
+        counters.totalInUse = recorded[1];
+        counters.floatingLimit = recorded[2];
+        counters.reservedInUse = recorded[3];
+        counters.reservedLimit = recorded[4];
+        m_recordedCounters.push_back(counters);
+    }
+
+    m_eventYear = checkpoint.eventYear;
+    m_serverName = checkpoint.serverName;
+    m_inputOffset = offset;
+    m_inputLines = checkpoint.inputLines;
+    m_firstNewRow = m_events.size();
+    m_resumed = true;
+}
+
+// Function to get the LOG Format. Imaris License Server RLM uses the RLM "ReportLog" Format.
+// The debug log of the ISV server is read as well, for the reports its events allow (see
+// projectIsvLine).
+void LogData::findFileFormat()
+{
+    m_fileFormat = Invalid;
+    size_t found;
+
+    // Only the header is searched: the first linesToSearch lines, within
+    // the first headerProbeSize bytes
+    const size_t linesToSearch = 20;
+    const size_t headerProbeSize = 8192;
+
+    string header;
+    if (m_compression != Uncompressed)
+    {
+        header = readDecompressedHead(m_inputFilePath, m_compression, headerProbeSize);
+    }
+    else
+    {
+        ifstream inputFile(m_inputFilePath.c_str(), ios::binary);
+        if (! inputFile.is_open())
+        {
+            CannotOpenFileException cannotOpenFileException(m_inputFilePath);
+            throw cannotOpenFileException;
+        }
+        header.resize(headerProbeSize);
+        inputFile.read(&header[0], headerProbeSize);
+        header.resize(static_cast<size_t>(inputFile.gcount()));
+    }
+
+    string_view headerView(header);
+    size_t offset = 0;
+    for (size_t line = 0; line < linesToSearch && offset < headerView.size(); ++line)
+    {
+        size_t lineEnd = headerView.find('\n', offset);
+        if (lineEnd == string_view::npos)
+        {
+            lineEnd = headerView.size();
+        }
+        string_view lineView = headerView.substr(offset, lineEnd - offset);
+        offset = lineEnd + 1;
+
+        found = lineView.find("RLM Report Log Format");
+        if (found!=std::string::npos)
+        {
+            readReportLogHeader(lineView.substr(found));
+            m_fileFormat = ReportLog;
+            return;
+        }
+        // Looking for the ISV log format, which is of this form:
+        //   MM/YY HH:MM (isv)
+        found = lineView.find("/");
+        if (found!=std::string::npos)
+        {
+            found = lineView.find(":");
+            if (found!=std::string::npos)
+            {
+                found = lineView.find("(");
+                if (found!=std::string::npos)
+                {
+                    found = lineView.find(")");
+                    if (found!=std::string::npos)
+                    {
+                        // RLM itself has a log file that matches the form of the ISV log file, except instead
+                        // of each line containing '(isv)', each line contains '(rlm)'.
+                        // This log file doesn't have usage data in it, so it's not supported.
+                        found = lineView.find("(rlm)");
+                        if (found==std::string::npos)
+                        {
+                            m_fileFormat = ISVLog;
+                            m_eventYear = isvLogYear(firstToken(lineView));
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Throw error if file format is not Report Log (RLM)
+    InvalidFileFormatException invalidFileFormatException;
+    throw invalidFileFormatException;
+}
+
+// The year of the first line of an ISV log, whose dates have none: that
+// of the log's last change, or the year before if the log starts in a
+// later month than it was last written in
+int LogData::isvLogYear(string_view firstDate) const
+{
+    DateTime modified;
+    epochToDateTime(max(getFileModifiedTime(m_inputFilePath), 0LL), modified);
+    DateTime first;
+    first.year = -1;
+    if (parseLogDate(firstDate, first) && first.month > modified.month)
+    {
+        return modified.year - 1;
+    }
+    return modified.year;
+}
+
+// Reads the format number and server version of the report log header,
+// "RLM Report Log Format 2, version 14.2 BL2, ISV bitplane".  The field
+// layouts are those of ReportLogFormat, so a log of another format is
+// refused rather than read from the wrong fields.  A header without a
+// number is taken to be of that format, as before it was checked.
+void LogData::readReportLogHeader(string_view header)
+{
+    const string_view formatLabel = "RLM Report Log Format";
+    string_view formatNumber = firstToken(header.substr(formatLabel.size()));
+    if (! formatNumber.empty() && isdigit(static_cast<unsigned char>(formatNumber[0])))
+    {
+        int format = stringViewToInt(formatNumber);
+        if (format != ReportLogFormat)
+        {
+            InvalidFileFormatException invalidFileFormatException(format, ReportLogFormat);
+            throw invalidFileFormatException;
+        }
+    }
+
+    m_rlmVersion.clear();
+    const string_view versionLabel = "version ";
+    size_t versionStart = header.find(versionLabel);
+    if (versionStart != string_view::npos)
+    {
+        versionStart += versionLabel.size();
+        size_t versionEnd = header.find(',', versionStart);
+        string_view version = header.substr(versionStart, versionEnd == string_view::npos ? string_view::npos
+                                                                                         : versionEnd - versionStart);
+        while (! version.empty() && isspace(static_cast<unsigned char>(version.back())))
+        {
+            version.remove_suffix(1);
+        }
+        m_rlmVersion = string(version);
+    }
+}
+
+size_t LogData::fileFormat()
+{
+    return m_fileFormat;
+}
+
+const string& LogData::inputFilePath() const
+{
+    return m_inputFilePath;
+}
+
+const string& LogData::serverName() const
+{
+    return m_serverName;
+}
+
+const string& LogData::rlmVersion() const
+{
+    return m_rlmVersion;
+}
+
+const StringInterner& LogData::uniqueProducts() const
+{
+    return m_uniqueProducts;
+}
+
+const StringInterner& LogData::uniqueUsers() const
+{
+    return m_uniqueUsers;
+}
+
+const StringInterner& LogData::uniqueServers() const
+{
+    return m_uniqueServers;
+}
+
+const StringInterner& LogData::uniqueHosts() const
+{
+    return m_uniqueHosts;
+}
+
+const StringInterner& LogData::uniqueVersions() const
+{
+    return m_uniqueVersions;
+}
+
+const SparseTotals& LogData::totalDurationHosts() const
+{
+    return m_totalDurationh;
+}
+
+const SparseTotals& LogData::totalDurationUsers() const
+{
+    return m_totalDurationu;
+}
+
+// Every session has one user, so the user totals add up to those of the
+// products
+void LogData::totalDurationProducts(vector<long long>& durations) const
+{
+    m_totalDurationu.productTotals(durations);
+}
+
+long long LogData::totalDuration() const
+{
+    return m_totalDurationu.total();
+}
+
+const DurationHistograms& LogData::sessionDurations() const
+{
+    return m_sessionDurations;
+}
+
+const UsageHeatmap& LogData::usageHeatmap() const
+{
+    return m_usageHeatmap;
+}
+
+const LicenseSaturation& LogData::licenseSaturation() const
+{
+    return m_licenseSaturation;
+}
+const SustainedPeaks& LogData::sustainedPeaks() const
+{
+    return m_sustainedPeaks;
+}
+
+const LongestSessions& LogData::longestSessions() const
+{
+    return m_longestSessions;
+}
+
+const VersionUsage& LogData::versionUsage() const
+{
+    return m_versionUsage;
+}
+
+const ForgottenSessions& LogData::forgottenSessions() const
+{
+    return m_forgottenSessions;
+}
+
+const DemandProfile& LogData::demandProfile() const
+{
+    return m_demandProfile;
+}
+
+const UsageRollups& LogData::rollups() const
+{
+    return m_rollups;
+}
+
+const vector<UsageCounters>& LogData::denialCounters() const
+{
+    return m_denialCounters;
+}
+
+const map<pair<long long, size_t>, HourlyDenials>& LogData::hourlyDenials() const
+{
+    return m_hourlyDenials;
+}
+
+const vector<uint32_t>& LogData::denialRepeats() const
+{
+    return m_denialRepeats;
+}
+
+const vector<long long>& LogData::denialLastTimes() const
+{
+    return m_denialLastTimes;
+}
+
+size_t LogData::startCount() const
+{
+    return m_startRows.size();
+}
+
+size_t LogData::shutdownCount() const
+{
+    return m_shutdownRows.size();
+}
+
+size_t LogData::sessionCount() const
+{
+    return static_cast<size_t>(m_checkpoint.closedSessions) + m_sessions.size();
+}
+
+size_t LogData::denialCount() const
+{
+    return static_cast<size_t>(m_checkpoint.denials) + m_denialRows.size() + m_mergedDenials;
+}
+
+const EventTotals& LogData::eventTotals() const
+{
+    return m_eventTotals;
+}
+
+const vector<InvalidLine>& LogData::invalidLines() const
+{
+    return m_invalidLines;
+}
+
+uint64_t LogData::eventLine(size_t row) const
+{
+    return m_eventLines.at(row);
+}
+
+bool LogData::readLogLine(uint64_t line, string& text) const
+{
+    text.clear();
+    if (m_compression != Uncompressed || line == 0)
+    {
+        return false;
+    }
+    // The last indexed line at or before the line
+    vector<pair<uint64_t, uint64_t> >::const_iterator entry =
+        upper_bound(m_lineOffsets.begin(), m_lineOffsets.end(), make_pair(line, UINT64_MAX));
+    if (entry == m_lineOffsets.begin())
+    {
+        return false;
+    }
+    --entry;
+
+    ifstream input(m_inputFilePath, ios::binary);
+    input.seekg(static_cast<streamoff>(entry->second));
+    for (uint64_t skipped = entry->first; skipped < line; ++skipped)
+    {
+        input.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+    if (! getline(input, text))
+    {
+        return false;
+    }
+    if (! text.empty() && text.back() == '\r')
+    {
+        text.pop_back();
+    }
+
+    return true;
+}
+
+const PipelineStats& LogData::stats() const
+{
+    return m_stats;
+}
+
+const EventStore& LogData::events() const
+{
+    return m_events;
+}
+
+const vector<Session>& LogData::sessions() const
+{
+    return m_sessions;
+}
+
+const SessionIndex& LogData::sessionIndex() const
+{
+    if (! m_sessionIndexBuilt)
+    {
+        m_sessionIndex.build(m_events, m_sessions, m_uniqueProducts.size(), m_uniqueUsers.size(), m_uniqueHosts.size());
+        m_sessionIndexBuilt = true;
+    }
+    return m_sessionIndex;
+}
+
+const vector<size_t>& LogData::denialRows() const
+{
+    return m_denialRows;
+}
+
+const ServerRuns& LogData::serverRuns() const
+{
+    return m_serverRuns;
+}
+
+// The counters of every product after the last timeline entry at or before
+// timestamp
+void LogData::usageAt(long long timestamp, vector<UsageCounters>& counters) const
+{
+    usageBefore(firstUsageRowAfter(timestamp), counters);
+}
+
+// The largest counters of every product while the timeline was in any of
+// its states between from and to.  The blocks that lie wholly inside the
+// interval are taken from the maxima of their snapshots.
+void LogData::peakUsage(long long from, long long to, vector<UsageCounters>& maxima) const
+{
+    vector<UsageCounters> counters;
+    size_t usageRow = firstUsageRowAfter(from);
+    size_t endRow = max(usageRow, firstUsageRowAfter(to));
+    usageBefore(usageRow, counters);
+    maxima = counters;
+
+    while (usageRow < endRow)
+    {
+        if (usageRow % UsageSnapshotInterval == 0 && usageRow + UsageSnapshotInterval <= endRow)
+        {
+            const size_t snapshot = usageRow / UsageSnapshotInterval;
+            raiseCounters(maxima, m_usageSnapshots[snapshot].maxima);
+            usageRow += UsageSnapshotInterval;
+            if (usageRow < endRow)
+            {
+                counters = m_usageSnapshots[snapshot + 1].counters;
+                counters.resize(m_uniqueProducts.size(), UsageCounters());
+            }
+        }
+        else
+        {
+            applyUsageChanges(usageRow, counters);
+            raiseCounters(maxima, counters);
+            ++usageRow;
+        }
+    }
+}
+
+// Index of the first timeline entry after timestamp (or the number of
+// entries).  This is the first entry past the last snapshot at or before
+// timestamp that is later than it.
+size_t LogData::firstUsageRowAfter(long long timestamp) const
+{
+    vector<UsageSnapshot>::const_iterator snapshot =
+        upper_bound(m_usageSnapshots.begin(), m_usageSnapshots.end(), timestamp,
+                    [](long long time, const UsageSnapshot& usageSnapshot) { return time < usageSnapshot.time; });
+    if (snapshot == m_usageSnapshots.begin())
+    {
+        return 0;
+    }
+
+    size_t usageRow = static_cast<size_t>(snapshot - m_usageSnapshots.begin() - 1) * UsageSnapshotInterval;
+    while (usageRow < m_indexedUsageRows && m_events.timestamps[m_usageRows[usageRow]] <= timestamp)
+    {
+        ++usageRow;
+    }
+
+    return usageRow;
+}
+
+// The counters of every product before the timeline entry usageRow,
+// replayed from the snapshot of its block
+void LogData::usageBefore(size_t usageRow, vector<UsageCounters>& counters) const
+{
+    if (m_usageSnapshots.empty())
+    {
+        counters = m_initialUsageCounters;
+        counters.resize(m_uniqueProducts.size(), UsageCounters());
+        return;
+    }
+
+    size_t snapshot = min(usageRow / UsageSnapshotInterval, m_usageSnapshots.size() - 1);
+    counters = m_usageSnapshots[snapshot].counters;
+    counters.resize(m_uniqueProducts.size(), UsageCounters());
+    for (size_t row = snapshot * UsageSnapshotInterval; row < usageRow; ++row)
+    {
+        applyUsageChanges(row, counters);
+    }
+}
+
+void LogData::applyUsageChanges(size_t usageRow, vector<UsageCounters>& counters) const
+{
+    for (size_t change = m_usageChangeOffsets[usageRow]; change < m_usageChangeOffsets[usageRow + 1]; ++change)
+    {
+        counters.at(m_usageChanges[change].product) = m_usageChanges[change].counters;
+    }
+}
+
+const vector<UsageCounters>& LogData::currentUsage() const
+{
+    return m_usageCounters;
+}
+
+size_t LogData::usageRowCount() const
+{
+    return m_usageRows.size();
+}
+
+long long LogData::usageRowTime(size_t usageRow) const
+{
+    return m_events.timestamps.at(m_usageRows.at(usageRow));
+}
+
+void LogData::usageRowChanges(size_t usageRow, vector<UsageChange>& changes) const
+{
+    changes.assign(m_usageChanges.begin() + m_usageChangeOffsets.at(usageRow),
+                   m_usageChanges.begin() + m_usageChangeOffsets.at(usageRow + 1));
+}
+
+const vector<size_t>& LogData::usageRows() const
+{
+    return m_usageRows;
+}
+
+const vector<size_t>& LogData::usageChangeOffsets() const
+{
+    return m_usageChangeOffsets;
+}
+
+const vector<UsageChange>& LogData::usageChanges() const
+{
+    return m_usageChanges;
+}
+
+// Reads the whole lines the license server appended to the log since the
+// last read and runs them through the event extraction and the concurrent
+// usage pass.  Sessions and durations are not updated.  A log that got
+// shorter was restarted (or rotated) by the server and is read again from
+// the start.
+followResult LogData::readAppendedLines()
+{
+    if (m_blockInput)
+    {
+        return NoNewLines;
+    }
+
+    long long fileSize = getFileSize(m_inputFilePath);
+    if (fileSize < 0 || static_cast<uint64_t>(fileSize) == m_inputEnd)
+    {
+        return NoNewLines;
+    }
+
+    if (static_cast<uint64_t>(fileSize) < m_inputEnd)
+    {
+        resetAnalysis();
+        m_inputFile.open(m_inputFilePath);
+        extractEvents(m_pool);
+        indexServerRuns();
+        getConcurrentUsage();
+        return LogRestarted;
+    }
+
+    // The mapping is renewed to cover the appended bytes
+    m_inputFile.open(m_inputFilePath);
+    const char* data = m_inputFile.data();
+    m_inputLines += count(data + static_cast<size_t>(m_inputOffset), data + static_cast<size_t>(m_inputEnd),
+                          '\n');
+    m_inputOffset = m_inputEnd;
+
+    size_t firstRow = m_events.size();
+    extractEvents(m_pool);
+    if (m_inputEnd == m_inputOffset)
+    {
+        return NoNewLines;
+    }
+    indexServerRuns();
+    updateConcurrentUsage(firstRow);
+
+    return LinesAppended;
+}
+
+
+// Files smaller than this per thread are parsed in one piece
+const size_t MinChunkSize = 4 << 20;
+
+// The smallest block a log is read in under a memory limit
+const size_t MinLimitedBlockSize = 256 << 10;
+
+// The bytes sampled at the start, middle and end of a log to size its
+// tables before it is parsed, and the share the estimate is padded by
+const size_t SizingSampleBytes = 256 << 10;
+const double SizingMargin = 1.05;
+
+// Makes room for extra more elements at once.  A later estimate, e.g. of
+// the lines a followed log grew by, at least doubles the capacity, so the
+// growth stays geometric.
+template <typename T>
+void reserveMore(vector<T>& values, size_t extra)
+{
+    if (values.size() + extra > values.capacity())
+    {
+        values.reserve(max(values.size() + extra, 2 * values.capacity()));
+    }
+}
+
+// The lines are independent except for the year, which date lines and START
+// events set and later events inherit.  A large file is therefore split at
+// line breaks into chunks that are parsed in parallel, each with its own
+// event store, interning the names in tables the threads share; appending
+// the chunks in order fixes up the years of the events that come before a
+// chunk's first dated line and builds the log's tables in the same
+// first-seen order as a single pass would.  With more than one thread the
+// chunks are sized as they are handed out (see ChunkTuner), and tuning
+// takes down how.
+void LogData::extractEvents(ThreadPool* pool, ChunkTuning* tuning)
+{
+    if (m_blockInput)
+    {
+        extractBlockEvents(pool);
+        return;
+    }
+
+    // An incremental analysis only reads whole lines; a line still being
+    // written is left for the next run
+    string_view text(m_inputFile.data(), m_inputFile.size());
+    text = text.substr(static_cast<size_t>(m_inputOffset));
+    if (m_incremental)
+    {
+        size_t lastLineBreak = text.rfind('\n');
+        text = text.substr(0, lastLineBreak == string_view::npos ? 0 : lastLineBreak + 1);
+    }
+    m_inputEnd = m_inputOffset + text.size();
+    // The chunks read the text front to back, so it is read in ahead
+    m_inputFile.adviseRead(static_cast<size_t>(m_inputOffset), text.size());
+
+    // The reorder window is flushed at the end of every chunk, so its
+    // chunks are cut by size alone, the same on every run
+    if (pool != NULL && pool->size() > 1 && m_reorderWindow == 0)
+    {
+        sizeForLog(text, text.size());
+        ChunkTuner tuner(text, pool->size(), m_usageStage ? UsageBatchesAhead : 0);
+        extractChunks([this, &tuner](string_view& chunk)
+                      {
+                          return tuner.nextChunk(chunk, m_usageStage ? m_usageStage->pending() : 0);
+                      },
+                      m_inputOffset, pool, pool->size() * PipelinedChunksPerThread, &tuner);
+        if (tuning != NULL)
+        {
+            *tuning = tuner.tuning(string());
+        }
+        return;
+    }
+
+    size_t chunkCount = 1;
+    if (pool != NULL && m_usageStage)
+    {
+        chunkCount = max(static_cast<size_t>(1), min(pool->size() * PipelinedChunksPerThread, text.size() / MinPipelinedChunkSize));
+    }
+    else if (pool != NULL)
+    {
+        chunkCount = max(static_cast<size_t>(1), min(pool->size(), text.size() / MinChunkSize));
+    }
+
+    vector<string_view> chunkTexts;
+    size_t chunkStart = 0;
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+    {
+        size_t lineBreak = text.find('\n', max(chunkStart, text.size() / chunkCount * chunk));
+        if (lineBreak == string_view::npos)
+        {
+            break;
+        }
+        chunkTexts.push_back(text.substr(chunkStart, lineBreak + 1 - chunkStart));
+        chunkStart = lineBreak + 1;
+    }
+    chunkTexts.push_back(text.substr(chunkStart));
+
+    sizeForLog(text, text.size());
+    extractChunks(chunkTexts, m_inputOffset, pool);
+}
+
+// Estimates the events of the text from the lines of up to three samples
+// of it, and reserves the event columns and line index for them up front.
+// Grown by doubling, they would be copied over and over and briefly take
+// twice their size on a large log.  text may be a first block of a log of
+// textBytes.  A date range or filter keeps an unknown share of the events,
+// so the tables then grow as they must.
+void LogData::sizeForLog(string_view text, uint64_t textBytes)
+{
+    if (m_dateRange.bounded() || m_filtering || ! keepsLicenseEvents() || textBytes == 0 || text.empty())
+    {
+        return;
+    }
+
+    size_t samples = (text.size() > 3 * SizingSampleBytes) ? 3 : 1;
+    uint64_t sampledBytes = 0;
+    uint64_t events = 0;
+    uint64_t usageRows = 0;
+    for (size_t sample = 0; sample < samples; ++sample)
+    {
+        // Each sample starts after a line break, so it holds whole lines
+        size_t start = (samples == 1) ? 0 : (text.size() - SizingSampleBytes) / 2 * sample;
+        if (start > 0)
+        {
+            start = text.find('\n', start);
+            start = (start == string_view::npos) ? text.size() : start + 1;
+        }
+        string_view sampleText = text.substr(start, SizingSampleBytes);
+        size_t offset = 0;
+        string_view line;
+        while (nextLineView(sampleText, offset, line))
+        {
+            eventType type;
+            if (classifyEvent(line.substr(0, line.find(' ')), type))
+            {
+                ++events;
+                usageRows += (type == OutEvent || type == InEvent || type == ShutdownEvent) ? 1 : 0;
+            }
+        }
+        sampledBytes += offset;
+    }
+    if (sampledBytes == 0)
+    {
+        return;
+    }
+
+    m_eventsPerByte = static_cast<double>(events) / static_cast<double>(sampledBytes);
+    m_usageRowsPerByte = static_cast<double>(usageRows) / static_cast<double>(sampledBytes);
+    size_t expectedEvents = static_cast<size_t>(m_eventsPerByte * static_cast<double>(textBytes) * SizingMargin);
+    if (m_events.size() + expectedEvents > m_events.capacity())
+    {
+        m_events.reserve(max(m_events.size() + expectedEvents, 2 * m_events.capacity()));
+    }
+    reserveMore(m_eventLines, expectedEvents);
+
+    // A pipelined usage pass has not been handed a batch yet, so its
+    // timeline can still be sized from here
+    if (m_usageStage)
+    {
+        reserveUsageTimeline(static_cast<size_t>(m_usageRowsPerByte * static_cast<double>(textBytes) * SizingMargin));
+    }
+}
+
+// Room for the timeline entries of the concurrent usage report: one per
+// OUT, IN and SHUTDOWN event.  Most change a single product, a shutdown
+// every product in use.
+void LogData::reserveUsageTimeline(size_t entries)
+{
+    if (reportSelected(ConcurrentUsageReport))
+    {
+        reserveMore(m_usageRows, entries);
+        reserveMore(m_usageChangeOffsets, entries);
+        reserveMore(m_usageChanges, static_cast<size_t>(static_cast<double>(entries) * SizingMargin));
+    }
+}
+
+size_t LogData::usageEventsBetween(size_t firstRow, size_t endRow) const
+{
+    size_t usageEvents = 0;
+    for (size_t row = firstRow; row < endRow; ++row)
+    {
+        eventType type = m_events.types[row];
+        usageEvents += (type == OutEvent || type == InEvent || type == ShutdownEvent) ? 1 : 0;
+    }
+    return usageEvents;
+}
+
+// The texts follow each other in the log, from line m_inputLines and byte
+// firstOffset on.  The chunks count their own rows, so their invalid lines
+// get their line numbers, and are checked against the budget, once they are
+// appended.
+void LogData::extractChunks(const vector<string_view>& texts, uint64_t firstOffset, ThreadPool* pool)
+{
+    size_t nextText = 0;
+    extractChunks([&texts, &nextText](string_view& text)
+                  {
+                      if (nextText == texts.size())
+                      {
+                          return false;
+                      }
+                      text = texts[nextText++];
+                      return true;
+                  },
+                  firstOffset, texts.size() > 1 ? pool : NULL, texts.size(), NULL);
+}
+
+// As above, for texts cut one after the other by nextText, at most window
+// of them parsed ahead of the one appended.  The tuner, if any, is told how
+// long each took to parse.
+void LogData::extractChunks(function<bool(string_view&)> nextText, uint64_t firstOffset, ThreadPool* pool, size_t window,
+                            ChunkTuner* tuner)
+{
+    // A read that ended in an exception may have left names behind
+    clearParsedNames();
+
+    // Up to window chunks are parsed at once and appended in order, each as
+    // soon as it and the ones before it are parsed, while the later ones
+    // still are.  The chunks after one that ran past the date range are dropped.
+    int eventYear = m_eventYear;
+    uint64_t firstLine = m_inputLines;
+    auto prepareChunk = [this, &nextText](size_t chunk, unique_ptr<EventChunk>& chunkData)
+    {
+        string_view text;
+        if (! nextText(text))
+        {
+            return false;
+        }
+        chunkData.reset(new EventChunk());
+        chunkData->text = text;
+        if (chunk == 0)
+        {
+            chunkData->yearKnown = true;
+            chunkData->eventYear = m_eventYear;
+        }
+        return true;
+    };
+    auto parseChunk = [this, tuner](size_t, unique_ptr<EventChunk>& chunkData)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        extractChunk(chunkData->text, *chunkData);
+        if (tuner != NULL)
+        {
+            tuner->recordParse(chunkData->text.size(),
+                               chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+    };
+    auto appendParsedChunk = [this, &eventYear, &firstLine, &firstOffset](size_t, unique_ptr<EventChunk>& chunkData)
+    {
+        LIC_TRACE_SCOPE("append chunk");
+        recordInvalidLines(*chunkData, firstLine);
+        indexLines(*chunkData, firstLine, firstOffset);
+        firstLine += chunkData->lineBreaks;
+        firstOffset += chunkData->text.size();
+        size_t firstRow = m_events.size();
+        size_t previousEndTimeRow = m_endTimeRow;
+
+        // The concurrent usage pass reads the events appended before, so
+        // they are only moved once it has caught up
+        if (m_usageStage && m_events.capacity() < firstRow + chunkData->events.size())
+        {
+            m_usageStage->drain();
+        }
+        appendChunk(*chunkData, eventYear);
+        countEvents(*chunkData, firstRow);
+        if (m_reorderWindow > 0)
+        {
+            reorderEvents(firstRow);
+        }
+        if (m_denialWindow > 0)
+        {
+            coalesceDenials(firstRow, previousEndTimeRow);
+        }
+        if (! keepsLicenseEvents())
+        {
+            dropLicenseEvents(firstRow, previousEndTimeRow);
+        }
+        if (m_usageStage)
+        {
+            pushUsageBatch();
+        }
+        m_pastRangeEnd = chunkData->pastRangeEnd;
+        chunkData.reset();
+        return ! m_pastRangeEnd;
+    };
+    if (! m_pastRangeEnd)
+    {
+        OrderedMerge< unique_ptr<EventChunk> > chunks(pool, window);
+        chunks.run(prepareChunk, parseChunk, appendParsedChunk);
+    }
+    m_eventYear = eventYear;
+
+    // The names live on in the log's tables once no chunk is being parsed
+    clearParsedNames();
+}
+
+void LogData::clearParsedNames()
+{
+    SharedInterner* parsedTables[] = { &m_parsedProducts, &m_parsedVersions, &m_parsedUsers,
+                                       &m_parsedHosts, &m_parsedHandles, &m_parsedServers };
+    for (size_t table = 0; table < 6; ++table)
+    {
+        parsedTables[table]->clear();
+        m_parsedIds[table].clear();
+    }
+}
+
+// A log that is not mapped comes in blocks from a BlockReader, which
+// decompresses or reads ahead while the blocks are parsed.  A pool's worth
+// of blocks is parsed at a time, in parallel like the chunks of a mapped
+// log, so only a few of them are held at once.  m_inputLines counts the
+// lines of the blocks before, for the line numbers of invalid events.
+void LogData::extractBlockEvents(ThreadPool* pool)
+{
+    // The blocks read ahead and those parsed at once give way to a memory
+    // limit
+    size_t batchSize = (pool != NULL) ? max(static_cast<size_t>(1), pool->size()) : 1;
+    BlockReader reader(m_inputFilePath, m_compression,
+                       limitedBufferSize(BlockReader::DefaultBlockSize, MinLimitedBlockSize, BlockReader::BlocksAhead + batchSize));
+    vector<string> blocks(batchSize);
+    vector<string_view> blockTexts;
+
+    bool atEnd = false;
+    while (! atEnd && ! m_pastRangeEnd)
+    {
+        blockTexts.clear();
+        while (blockTexts.size() < batchSize && reader.nextBlock(blocks.at(blockTexts.size())))
+        {
+            blockTexts.push_back(blocks.at(blockTexts.size()));
+        }
+        atEnd = (blockTexts.size() < batchSize);
+        if (blockTexts.empty())
+        {
+            break;
+        }
+
+        // The first block samples the lines of a plain log read ahead; the
+        // text of a compressed one is of unknown length
+        if (m_inputEnd == m_inputOffset && m_compression == Uncompressed)
+        {
+            sizeForLog(blockTexts.front(), static_cast<uint64_t>(max(getFileSize(m_inputFilePath), 0LL)));
+        }
+        extractChunks(blockTexts, m_inputEnd, pool);
+        for (size_t block = 0; block < blockTexts.size(); ++block)
+        {
+            m_inputLines += count(blockTexts.at(block).begin(), blockTexts.at(block).end(), '\n');
+            m_inputEnd += blockTexts.at(block).size();
+        }
+    }
+}
+
+void LogData::extractChunk(string_view text, EventChunk& chunk)
+{
+    LIC_TRACE_SCOPE("parse chunk");
+    if (m_eventsPerByte > 0.0)
+    {
+        size_t expectedEvents = static_cast<size_t>(m_eventsPerByte * static_cast<double>(text.size()) * SizingMargin);
+        chunk.events.reserve(expectedEvents);
+        chunk.eventLines.reserve(expectedEvents);
+    }
+    vector<string_view> allDataRow;
+    vector<string_view> isvRow;
+    size_t offset = 0;
+    string_view lineView;
+
+    size_t row = 0;
+    size_t lineStart = 0;
+    size_t reportedBytes = 0;
+    size_t reportedEvents = 0;
+    for (; ! chunk.pastRangeEnd && nextLineView(text, offset, lineView); ++row)
+    {
+        if (row % LineIndexStride == 0)
+        {
+            chunk.lineOffsets.push_back(make_pair(row, lineStart));
+            if (m_progress != NULL)
+            {
+                m_progress->add(lineStart - reportedBytes, chunk.events.size() - reportedEvents);
+                reportedBytes = lineStart;
+                reportedEvents = chunk.events.size();
+            }
+            throwIfCancelled();
+        }
+        size_t fields = fieldsToTokenize(lineView);
+        if (fields > 0)
+        {
+            tokenizeLine(lineView, allDataRow, fields);
+            if (m_fileFormat == ISVLog)
+            {
+                if (projectIsvLine(allDataRow, isvRow))
+                {
+                    extractEvent(isvRow, row, chunk);
+                }
+            }
+            else
+            {
+                extractEvent(allDataRow, row, chunk);
+            }
+            chunk.eventLines.resize(chunk.events.size(), row);
+        }
+        lineStart = offset;
+    }
+    // Every line break starts a row, the last one perhaps an empty one
+    chunk.lineBreaks = row - 1;
+    if (m_progress != NULL)
+    {
+        m_progress->add(text.size() - reportedBytes, chunk.events.size() - reportedEvents);
+    }
+}
+
+// Lists the invalid lines of a chunk that starts after line firstLine.  The
+// line that exceeds the budget ends the parse like it does without one.
+void LogData::recordInvalidLines(const EventChunk& chunk, uint64_t firstLine)
+{
+    for (size_t invalid = 0; invalid < chunk.invalidLines.size(); ++invalid)
+    {
+        InvalidLine invalidLine = chunk.invalidLines.at(invalid);
+        invalidLine.line += firstLine + 1;
+        if (m_invalidLines.size() >= m_invalidLineBudget)
+        {
+            EventDataException eventDataException(invalidLine.line);
+            throw eventDataException;
+        }
+        m_invalidLines.push_back(invalidLine);
+    }
+}
+
+// Numbers the lines of a chunk that starts after line firstLine, at byte
+// firstOffset of the log.  The lines go with the events before appendChunk
+// takes them over and coalesceDenials compacts them.
+void LogData::indexLines(const EventChunk& chunk, uint64_t firstLine, uint64_t firstOffset)
+{
+    for (size_t event = 0; event < chunk.eventLines.size(); ++event)
+    {
+        m_eventLines.push_back(firstLine + chunk.eventLines[event] + 1);
+    }
+    for (size_t entry = 0; entry < chunk.lineOffsets.size(); ++entry)
+    {
+        m_lineOffsets.push_back(make_pair(firstLine + chunk.lineOffsets[entry].first + 1,
+                                          firstOffset + chunk.lineOffsets[entry].second));
+    }
+}
+
+// Adds a parsed chunk to the log.  eventYear is the year at the end of the
+// previous chunks and is advanced past this one.
+void LogData::appendChunk(EventChunk& chunk, int& eventYear)
+{
+    for (size_t pending = 0; pending < chunk.pendingTimestamps.size(); ++pending)
+    {
+        DateTime dateTime = chunk.pendingTimestamps.at(pending).dateTime;
+        dateTime.year += eventYear;
+        chunk.events.timestamps.at(chunk.pendingTimestamps.at(pending).eventRow) = dateTimeToEpoch(dateTime);
+    }
+    if (chunk.filteredEndPending)
+    {
+        DateTime dateTime = chunk.filteredEndDateTime;
+        dateTime.year += eventYear;
+        chunk.filteredEndTime = dateTimeToEpoch(dateTime);
+    }
+    m_filteredEndTime = max(m_filteredEndTime, chunk.filteredEndTime);
+    eventYear = chunk.yearKnown ? chunk.eventYear : eventYear + chunk.eventYear;
+
+    size_t firstRow = m_events.size();
+    if (! chunk.serverName.empty())
+    {
+        m_serverName = chunk.serverName;
+    }
+    if (chunk.endTimeRow != NoId)
+    {
+        m_endTimeRow = firstRow + chunk.endTimeRow;
+    }
+
+    // The chunk's ids are translated to the log's tables.  Each table takes
+    // the names of one column, in the order of the chunk's events, so they
+    // are added to the log in the same first-seen order as a single pass
+    // would add them, whichever thread interned them first.
+    SharedInterner* parsedTables[] = { &m_parsedProducts, &m_parsedVersions, &m_parsedUsers,
+                                       &m_parsedHosts, &m_parsedHandles, &m_parsedServers };
+    StringInterner* logTables[] = { &m_uniqueProducts, &m_uniqueVersions, &m_uniqueUsers,
+                                    &m_uniqueHosts, &m_uniqueHandles, &m_uniqueServers };
+    EventStore& events = chunk.events;
+    vector<size_t>* columns[] = { &events.products, &events.versions, &events.users,
+                                  &events.hosts, &events.handles };
+    for (size_t column = 0; column < 5; ++column)
+    {
+        vector<size_t>& ids = *columns[column];
+        for (size_t row = 0; row < ids.size(); ++row)
+        {
+            if (ids[row] == NoId)
+            {
+                continue;
+            }
+            // START events keep their license server in the host column
+            size_t table = (column == 3 && events.types[row] == StartEvent) ? 5 : column;
+            vector<size_t>& logIds = m_parsedIds[table];
+            if (ids[row] >= logIds.size())
+            {
+                logIds.resize(ids[row] + 1, NoId);
+            }
+            size_t& logId = logIds[ids[row]];
+            if (logId == NoId)
+            {
+                logId = logTables[table]->intern(parsedTables[table]->name(ids[row]));
+            }
+            ids[row] = logId;
+        }
+    }
+
+    // The first chunk is taken over as it is
+    if (firstRow == 0)
+    {
+        m_events = move(chunk.events);
+        m_denialRows = move(chunk.denialRows);
+        m_shutdownRows = move(chunk.shutdownRows);
+        m_startRows = move(chunk.startRows);
+        m_checkOutRows = move(chunk.checkOutRows);
+        m_checkInRows = move(chunk.checkInRows);
+        return;
+    }
+
+    m_events.types.insert(m_events.types.end(), events.types.begin(), events.types.end());
+    m_events.timestamps.insert(m_events.timestamps.end(), events.timestamps.begin(), events.timestamps.end());
+    m_events.products.insert(m_events.products.end(), events.products.begin(), events.products.end());
+    m_events.versions.insert(m_events.versions.end(), events.versions.begin(), events.versions.end());
+    m_events.users.insert(m_events.users.end(), events.users.begin(), events.users.end());
+    m_events.hosts.insert(m_events.hosts.end(), events.hosts.begin(), events.hosts.end());
+    m_events.counts.insert(m_events.counts.end(), events.counts.begin(), events.counts.end());
+    m_events.handles.insert(m_events.handles.end(), events.handles.begin(), events.handles.end());
+    m_events.reserved.insert(m_events.reserved.end(), events.reserved.begin(), events.reserved.end());
+
+    const vector<size_t>* chunkRows[] = { &chunk.denialRows, &chunk.shutdownRows, &chunk.startRows,
+                                          &chunk.checkOutRows, &chunk.checkInRows };
+    vector<size_t>* logRows[] = { &m_denialRows, &m_shutdownRows, &m_startRows, &m_checkOutRows, &m_checkInRows };
+    for (size_t list = 0; list < 5; ++list)
+    {
+        for (size_t row = 0; row < chunkRows[list]->size(); ++row)
+        {
+            logRows[list]->push_back(firstRow + chunkRows[list]->at(row));
+        }
+    }
+}
+
+// Puts the events a chunk appended from firstRow on in time order, as far
+// as the reorder window allows.  The buffer is flushed at the end of every
+// chunk, as the concurrent usage pass may take the rows appended so far, so
+// an event late across a chunk boundary stays out of order.
+void LogData::reorderEvents(size_t firstRow)
+{
+    vector<size_t> order;
+    order.reserve(m_events.size() - firstRow);
+    for (size_t row = firstRow; row < m_events.size(); ++row)
+    {
+        if (m_events.types[row] == ProductEvent)
+        {
+            m_reorderBuffer.pushUntimed(row, order);
+        }
+        else
+        {
+            m_reorderBuffer.push(m_events.timestamps[row], row, order);
+        }
+    }
+    m_reorderBuffer.flush(order);
+
+    size_t moved = 0;
+    while (moved < order.size() && order[moved] == firstRow + moved)
+    {
+        ++moved;
+    }
+    if (moved == order.size())
+    {
+        return;
+    }
+
+    // Rearrange the columns, then renumber the rows that refer to events
+    permuteRows(m_events.types, firstRow, order);
+    permuteRows(m_events.timestamps, firstRow, order);
+    permuteRows(m_events.products, firstRow, order);
+    permuteRows(m_events.versions, firstRow, order);
+    permuteRows(m_events.users, firstRow, order);
+    permuteRows(m_events.hosts, firstRow, order);
+    permuteRows(m_events.counts, firstRow, order);
+    permuteRows(m_events.handles, firstRow, order);
+    permuteRows(m_events.reserved, firstRow, order);
+    permuteRows(m_eventLines, firstRow, order);
+
+    vector<size_t> newRows(order.size());
+    for (size_t row = 0; row < order.size(); ++row)
+    {
+        newRows[order[row] - firstRow] = firstRow + row;
+    }
+    vector<size_t>* rowLists[] = { &m_denialRows, &m_shutdownRows, &m_startRows, &m_checkOutRows, &m_checkInRows };
+    for (size_t list = 0; list < 5; ++list)
+    {
+        vector<size_t>& rows = *rowLists[list];
+        vector<size_t>::iterator first = lower_bound(rows.begin(), rows.end(), firstRow);
+        for (vector<size_t>::iterator entry = first; entry != rows.end(); ++entry)
+        {
+            *entry = newRows[*entry - firstRow];
+        }
+        sort(first, rows.end());
+    }
+
+    // The end time row is the last event of the chunk that has a time
+    if (m_endTimeRow >= firstRow)
+    {
+        for (size_t row = m_events.size(); row > firstRow; --row)
+        {
+            eventType type = m_events.types[row - 1];
+            if (type != ProductEvent && (type != StartEvent || m_fileFormat == ReportLog))
+            {
+                m_endTimeRow = row - 1;
+                break;
+            }
+        }
+    }
+}
+
+// Merges every denial the chunk appended from firstRow on into the last
+// one of the same user, host, product and reason, if it came at most
+// m_denialWindow seconds after that one's last request.  A merged denial is
+// dropped from the events like one the filter leaves out, so it still
+// counts for the end of the log.  Denials outside the date range are left
+// alone, applyDateRange drops them with their requests.
+void LogData::coalesceDenials(size_t firstRow, size_t previousEndTimeRow)
+{
+    size_t firstDenial = lower_bound(m_denialRows.begin(), m_denialRows.end(), firstRow) - m_denialRows.begin();
+    vector<bool> merged(m_events.size() - firstRow, false);
+    bool anyMerged = false;
+    for (size_t denial = firstDenial; denial < m_denialRows.size(); ++denial)
+    {
+        size_t row = m_denialRows[denial];
+        long long timestamp = m_events.timestamps[row];
+        bool inRange = timestamp >= m_dateRange.from && timestamp < m_dateRange.to;
+        auto key = make_tuple(m_events.users[row], m_events.hosts[row], m_events.products[row], m_events.counts[row]);
+        const size_t* burst = m_denialBursts.find(key);
+        if (inRange && burst != NULL && timestamp - m_denialLastTimes[*burst] <= m_denialWindow)
+        {
+            ++m_denialRepeats[*burst];
+            m_denialLastTimes[*burst] = max(m_denialLastTimes[*burst], timestamp);
+            m_filteredEndTime = max(m_filteredEndTime, timestamp);
+            merged[row - firstRow] = true;
+            anyMerged = true;
+            ++m_mergedDenials;
+            continue;
+        }
+        // The kept denials are numbered in the order of m_denialRows
+        if (inRange)
+        {
+            m_denialBursts[key] = m_denialRepeats.size();
+        }
+        m_denialRepeats.push_back(1);
+        m_denialLastTimes.push_back(timestamp);
+    }
+    if (anyMerged)
+    {
+        removeRows(firstRow, previousEndTimeRow, merged);
+    }
+}
+
+// Adds the events the chunk appended from firstRow on to the event totals,
+// before any of them is merged or dropped, and those it dropped at once.
+// The product of a dropped denial was named by an event the chunk kept.
+void LogData::countEvents(const EventChunk& chunk, size_t firstRow)
+{
+    m_eventTotals.add(m_events, firstRow, m_events.size());
+    for (size_t type = 0; type <= DenyEvent; ++type)
+    {
+        m_eventTotals.addEvents(static_cast<eventType>(type), chunk.droppedEvents[type]);
+    }
+    for (size_t product = 0; product < chunk.droppedDenials.size(); ++product)
+    {
+        if (chunk.droppedDenials[product] > 0)
+        {
+            m_eventTotals.addDenials(m_parsedIds[0].at(product), chunk.droppedDenials[product]);
+        }
+    }
+}
+
+// Counts the event totals anew from the events, for events that were not
+// read one chunk at a time or that a date range left out.  A coalesced
+// denial counts for its requests.
+void LogData::recountEvents()
+{
+    m_eventTotals.clear();
+    m_eventTotals.add(m_events, 0, m_events.size());
+    for (size_t denial = 0; denial < m_denialRepeats.size(); ++denial)
+    {
+        uint64_t repeats = m_denialRepeats[denial] - 1;
+        m_eventTotals.addEvents(DenyEvent, repeats);
+        m_eventTotals.addDenials(m_events.products[m_denialRows[denial]], repeats);
+    }
+}
+
+// Takes the STARTs and SHUTDOWNs the last read added into the index of the
+// server runs, once their rows no longer move
+void LogData::indexServerRuns()
+{
+    m_serverRuns.extend(m_events, m_startRows, m_shutdownRows);
+}
+
+// Lists the rows of the OUTs and INs anew, for events that were not read
+// one chunk at a time.  The event cache keeps only the other row lists.
+void LogData::listLicenseRows()
+{
+    m_checkOutRows.clear();
+    m_checkInRows.clear();
+    for (size_t row = 0; row < m_events.size(); ++row)
+    {
+        if (m_events.types[row] == OutEvent)
+        {
+            m_checkOutRows.push_back(row);
+        }
+        else if (m_events.types[row] == InEvent)
+        {
+            m_checkInRows.push_back(row);
+        }
+    }
+}
+
+// Whether the event names a product, version, user or host no event of the
+// chunk before it did, and marks them named
+bool LogData::namesNew(EventChunk& chunk, size_t eventRow) const
+{
+    const vector<size_t>* columns[] = { &chunk.events.products, &chunk.events.versions, &chunk.events.users,
+                                        &chunk.events.hosts };
+    bool anyNew = false;
+    for (size_t column = 0; column < 4; ++column)
+    {
+        size_t id = columns[column]->at(eventRow);
+        vector<bool>& named = chunk.namedIds[column];
+        if (id >= named.size())
+        {
+            named.resize(max(id + 1, 2 * named.size()), false);
+        }
+        if (! named[id])
+        {
+            named[id] = true;
+            anyNew = true;
+        }
+    }
+    return anyNew;
+}
+
+// The license events the chunk appended from firstRow on, once their names
+// are in the log's tables, for a summary alone.  They are dropped like those
+// a filter leaves out, so they still count for the end of the log.
+void LogData::dropLicenseEvents(size_t firstRow, size_t previousEndTimeRow)
+{
+    vector<bool> dropped(m_events.size() - firstRow, false);
+    for (size_t row = firstRow; row < m_events.size(); ++row)
+    {
+        eventType type = m_events.types[row];
+        if (type == OutEvent || type == InEvent || type == DenyEvent)
+        {
+            m_filteredEndTime = max(m_filteredEndTime, m_events.timestamps[row]);
+            dropped[row - firstRow] = true;
+        }
+    }
+    removeRows(firstRow, previousEndTimeRow, dropped);
+}
+
+// Compacts the events appended from firstRow on, leaving out those removed
+// marks, and renumbers the rows that refer to them
+void LogData::removeRows(size_t firstRow, size_t previousEndTimeRow, const vector<bool>& removed)
+{
+    vector<size_t> newRows(removed.size(), NoId);
+    size_t keptRows = firstRow;
+    for (size_t row = firstRow; row < m_events.size(); ++row)
+    {
+        if (removed[row - firstRow])
+        {
+            continue;
+        }
+        m_events.types[keptRows] = m_events.types[row];
+        m_events.timestamps[keptRows] = m_events.timestamps[row];
+        m_events.products[keptRows] = m_events.products[row];
+        m_events.versions[keptRows] = m_events.versions[row];
+        m_events.users[keptRows] = m_events.users[row];
+        m_events.hosts[keptRows] = m_events.hosts[row];
+        m_events.counts[keptRows] = m_events.counts[row];
+        m_events.handles[keptRows] = m_events.handles[row];
+        m_events.reserved[keptRows] = m_events.reserved[row];
+        m_eventLines[keptRows] = m_eventLines[row];
+        newRows[row - firstRow] = keptRows++;
+    }
+    while (m_events.size() > keptRows)
+    {
+        m_events.removeLast();
+    }
+    m_eventLines.resize(keptRows);
+
+    vector<size_t>* rowLists[] = { &m_denialRows, &m_shutdownRows, &m_startRows, &m_checkOutRows, &m_checkInRows };
+    for (size_t list = 0; list < 5; ++list)
+    {
+        vector<size_t>& rows = *rowLists[list];
+        size_t kept = lower_bound(rows.begin(), rows.end(), firstRow) - rows.begin();
+        for (size_t entry = kept; entry < rows.size(); ++entry)
+        {
+            if (newRows[rows[entry] - firstRow] != NoId)
+            {
+                rows[kept++] = newRows[rows[entry] - firstRow];
+            }
+        }
+        rows.resize(kept);
+    }
+
+    // The end time row moves to the last kept event that has a time
+    if (m_endTimeRow >= firstRow)
+    {
+        size_t endTimeRow = previousEndTimeRow;
+        for (size_t row = m_endTimeRow + 1; row > firstRow; --row)
+        {
+            size_t newRow = newRows[row - 1 - firstRow];
+            eventType type = (newRow != NoId) ? m_events.types[newRow] : ProductEvent;
+            if (type != ProductEvent && (type != StartEvent || m_fileFormat == ReportLog))
+            {
+                endTimeRow = newRow;
+                break;
+            }
+        }
+        m_endTimeRow = endTimeRow;
+    }
+}
+
+// How many leading fields of a line extractEvent can use, judged by its
+// first token; the line is tokenized no further.  An event line needs the
+// fields of its event type, a date line, whose date starts with a digit,
+// is told by having exactly two.  0 means the line can be left alone:
+// headers, comments and the records the analysis does not use are only
+// looked at up to their first space.
+size_t LogData::fieldsToTokenize(string_view line) const
+{
+    if (m_fileFormat != ReportLog)
+    {
+        return SIZE_MAX;
+    }
+    string_view keyword = firstToken(line);
+    eventType type;
+    if (keyword.empty())
+    {
+        return 0;
+    }
+    if (classifyEvent(keyword, type))
+    {
+        return ReportEventFields[type];
+    }
+    return isdigit(static_cast<unsigned char>(keyword[0])) ? 3 : 0;
+}
+
+// An invalid line is listed in the chunk and skipped: an event is only
+// added once its fields are all there and its time is valid
+void LogData::extractEvent(const vector<string_view>& allDataRow,
+                           const size_t row,
+                           EventChunk& chunk)
+{
+    size_t eventRow;
+    EventStore& events = chunk.events;
+
+    // Check for existence of date, and if so update the year
+    if (allDataRow.size() == 2)
+    {
+        vector<string_view> tempVector;
+        tokenizeStringView("/", allDataRow.at(0), tempVector);
+        if (tempVector.size() == 3)
+        {
+            chunk.eventYear = stringViewToInt(tempVector.at(2));
+            chunk.eventMonth = stringViewToInt(tempVector.at(0));
+            chunk.yearKnown = true;
+        }
+    }
+
+    if (allDataRow.size() > RepIndexEvent)
+    {
+        eventType type;
+        if (! classifyEvent(allDataRow.at(RepIndexEvent), type))
+        {
+            return;
+        }
+        if (! hasEventFields(allDataRow, type))
+        {
+            InvalidLine invalidLine = { row, MissingFields };
+            chunk.invalidLines.push_back(invalidLine);
+            return;
+        }
+
+        // Load Imaris license check-out events into the event store
+        if (type == OutEvent)
+        {
+            eventRow = loadLicenseEvent<OutEvent>(allDataRow, row, chunk);
+            if (eventRow == NoId)
+            {
+                return;
+            }
+            chunk.checkOutRows.push_back(eventRow);
+            chunk.endTimeRow = eventRow;
+        }
+
+        // Load Imaris license check-in events into the event store
+        else if (type == InEvent)
+        {
+            eventRow = loadLicenseEvent<InEvent>(allDataRow, row, chunk);
+            if (eventRow == NoId)
+            {
+                return;
+            }
+            chunk.checkInRows.push_back(eventRow);
+            chunk.endTimeRow = eventRow;
+        }
+
+        // Load Imaris license denial events into the event store
+        else if (type == DenyEvent)
+        {
+            eventRow = loadLicenseEvent<DenyEvent>(allDataRow, row, chunk);
+            if (eventRow == NoId)
+            {
+                return;
+            }
+            chunk.denialRows.push_back(eventRow);
+            chunk.endTimeRow = eventRow;
+        }
+
+        // Load Imaris Log Server Start events into the event store
+        else if (type == StartEvent)
+        {
+            eventRow = events.append(StartEvent);
+            if (! setEventTimestamp(allDataRow[ReportEventLayout<StartEvent>::date],
+                                    allDataRow[ReportEventLayout<StartEvent>::time],
+                                    eventRow, chunk))
+            {
+                events.removeLast();
+                InvalidLine invalidLine = { row, InvalidDateTime };
+                chunk.invalidLines.push_back(invalidLine);
+                return;
+            }
+            if (afterDateRange(chunk, eventRow))
+            {
+                events.removeLast();
+                chunk.pastRangeEnd = true;
+                return;
+            }
+            string_view server = allDataRow[ReportEventLayout<StartEvent>::server];
+            events.hosts.at(eventRow) = m_parsedServers.intern(server);
+            chunk.serverName = string(server);
+            chunk.startRows.push_back(eventRow);
+
+            if (m_fileFormat == ReportLog)
+            {
+                chunk.endTimeRow = eventRow;
+            }
+        }
+
+        // Load Imaris license Server Shutdown Events into the event store
+        else if (type == ShutdownEvent)
+        {
+            eventRow = events.append(ShutdownEvent);
+            if (! setEventTimestamp(allDataRow[ReportEventLayout<ShutdownEvent>::date],
+                                    allDataRow[ReportEventLayout<ShutdownEvent>::time],
+                                    eventRow, chunk))
+            {
+                events.removeLast();
+                InvalidLine invalidLine = { row, InvalidDateTime };
+                chunk.invalidLines.push_back(invalidLine);
+                return;
+            }
+            if (afterDateRange(chunk, eventRow))
+            {
+                events.removeLast();
+                chunk.pastRangeEnd = true;
+                return;
+            }
+            chunk.shutdownRows.push_back(eventRow);
+            chunk.endTimeRow = eventRow;
+        }
+
+        // Load product information from Imaris License Server into the event store
+        else
+        {
+            typedef ReportEventLayout<ProductEvent> Layout;
+            if (m_filtering && ! selectsName(FilterProducts, allDataRow[Layout::product]))
+            {
+                return;
+            }
+            eventRow = events.append(ProductEvent);
+            events.products.at(eventRow) = m_parsedProducts.intern(allDataRow[Layout::product]);
+            events.versions.at(eventRow) = m_parsedVersions.intern(allDataRow[Layout::version]);
+            events.counts.at(eventRow) = stringViewToInt(allDataRow[Layout::count]);
+            events.reserved.at(eventRow) = stringViewToInt(allDataRow[Layout::rlimit]);
+        }
+    }
+}
+
+// Stores an OUT, IN or DENY event and returns the new event row, or NoId
+// for an invalid time, one outside the date range or an event the filter
+// leaves out.  extractEvent has checked that the line holds the fields of
+// the layout.
+template <eventType Type>
+size_t LogData::loadLicenseEvent(const vector<string_view>& allDataRow,
+                                 const size_t row,
+                                 EventChunk& chunk)
+{
+    typedef ReportEventLayout<Type> Layout;
+    EventStore& events = chunk.events;
+    size_t eventRow = events.append(Type);
+    if (! setEventTimestamp(allDataRow[Layout::date],
+                            allDataRow[Layout::time],
+                            eventRow, chunk))
+    {
+        events.removeLast();
+        InvalidLine invalidLine = { row, InvalidDateTime };
+        chunk.invalidLines.push_back(invalidLine);
+        return NoId;
+    }
+    // Denials before the date range leave no state behind, so they are
+    // dropped before any of their names is interned
+    if (afterDateRange(chunk, eventRow) || (Type == DenyEvent && beforeDateRange(chunk, eventRow)))
+    {
+        chunk.pastRangeEnd = afterDateRange(chunk, eventRow);
+        events.removeLast();
+        return NoId;
+    }
+    // Nor are the names of an event the filter leaves out, which is
+    // dropped once its time has moved the chunk's year on
+    if (m_filtering && ! selectsEvent<Type>(allDataRow))
+    {
+        keepFilteredEndTime(eventRow, chunk);
+        events.removeLast();
+        return NoId;
+    }
+    events.products.at(eventRow) = m_parsedProducts.intern(allDataRow[Layout::product]);
+    events.versions.at(eventRow) = m_parsedVersions.intern(allDataRow[Layout::version]);
+    events.users.at(eventRow) = m_parsedUsers.intern(allDataRow[Layout::user]);
+    events.hosts.at(eventRow) = m_parsedHosts.intern(allDataRow[Layout::host]);
+    // A summary alone lists only the names, so an event naming none the
+    // chunk has not is dropped at once, and the others once their names are
+    // in the log's tables (see dropLicenseEvents)
+    if (! keepsLicenseEvents() && ! namesNew(chunk, eventRow))
+    {
+        ++chunk.droppedEvents[Type];
+        if constexpr (Type == DenyEvent)
+        {
+            size_t product = events.products.at(eventRow);
+            if (product >= chunk.droppedDenials.size())
+            {
+                chunk.droppedDenials.resize(product + 1, 0);
+            }
+            ++chunk.droppedDenials[product];
+        }
+        keepFilteredEndTime(eventRow, chunk);
+        events.removeLast();
+        return NoId;
+    }
+    events.counts.at(eventRow) = stringViewToInt(allDataRow[Layout::count]);
+    if constexpr (Type != DenyEvent)
+    {
+        events.handles.at(eventRow) = m_parsedHandles.intern(allDataRow[Layout::handle]);
+        events.reserved.at(eventRow) = stringViewToInt(allDataRow[Layout::reserved]);
+    }
+
+    return eventRow;
+}
+
+// Converts an event date and time to seconds since the epoch.  Most events
+// carry only "MM/DD", so the year comes from the last date line or START
+// event; a START event's own year becomes the current one.  While the chunk
+// has not seen a year the event is left for appendChunk to fill in.
+// Returns false, without touching the chunk, if the date or time is invalid.
+bool LogData::setEventTimestamp(string_view dateString,
+                                string_view timeString,
+                                const size_t eventRow,
+                                EventChunk& chunk)
+{
+    DateTime dateTime;
+    dateTime.year = -1;
+    if (! parseLogDate(dateString, dateTime) || ! parseLogTime(timeString, dateTime))
+    {
+        return false;
+    }
+
+    if (dateTime.year >= 0)
+    {
+        chunk.eventYear = dateTime.year;
+        chunk.eventMonth = dateTime.month;
+        chunk.yearKnown = true;
+    }
+    else
+    {
+        // If a log event occurs within the first minute after midnight, it is logged before
+        // the string that provides the new year.  This code checks for events on Jan 1 at 00:00
+        // and increments the year, once: the date line and the events after it are in the new
+        // year already.
+        if (dateTime.month == 1 && dateTime.day == 1 && dateTime.hours == 0 && dateTime.minutes == 0 &&
+            chunk.eventMonth == 12)
+        {
+            ++chunk.eventYear;
+        }
+        // An ISV log may have no date lines at all; its year moves on when
+        // the months start over
+        else if (m_fileFormat == ISVLog && dateTime.month < chunk.eventMonth)
+        {
+            ++chunk.eventYear;
+        }
+        dateTime.year = chunk.eventYear;
+        chunk.eventMonth = dateTime.month;
+
+        if (! chunk.yearKnown)
+        {
+            PendingTimestamp pending = { eventRow, dateTime };
+            chunk.pendingTimestamps.push_back(pending);
+            return true;
+        }
+    }
+
+    chunk.events.timestamps.at(eventRow) = dateTimeToEpoch(dateTime);
+    return true;
+}
+
+namespace
+{
+    // A full date, "MM/DD/YYYY", which an ISV log line may carry
+    bool isFullDate(string_view token)
+    {
+        return token.size() == 10 && token[2] == '/' && token[5] == '/';
+    }
+
+    // The user and host of an ISV event, the two sides of "user@host"
+    void splitUserHost(string_view userHost, string_view& user, string_view& host)
+    {
+        size_t at = userHost.find('@');
+        user = userHost.substr(0, at);
+        host = (at == string_view::npos) ? string_view() : userHost.substr(at + 1);
+    }
+}
+
+// Projects an OUT, IN or DENY line of an ISV log,
+//   MM/DD HH:MM (isv) OUT: product v1.0 by user@host (2 licenses)
+// onto the fields of the report log line of the event.  IN and DENIED
+// lines may give a reason in parentheses before the product.  ISV logs have
+// no handles; the handle is the text from the product to the host, which a
+// check-out shares with its check-in.  A line cut short keeps only its
+// keyword, and extractEvent lists it as invalid.
+template <eventType Type>
+void LogData::projectIsvLicenseEvent(const vector<string_view>& isvTokens,
+                                     string_view keyword,
+                                     vector<string_view>& reportRow) const
+{
+    typedef ReportEventLayout<Type> Layout;
+    reportRow.assign(1, keyword);
+
+    size_t field = IsvIndexEvent + 1;
+    if (field < isvTokens.size() && ! isvTokens[field].empty() && isvTokens[field].front() == '(')
+    {
+        while (field < isvTokens.size() && (isvTokens[field].empty() || isvTokens[field].back() != ')'))
+        {
+            ++field;
+        }
+        ++field;
+    }
+    size_t userHost = field + 2;
+    while (userHost < isvTokens.size() && isvTokens[userHost].find('@') == string_view::npos)
+    {
+        ++userHost;
+    }
+    if (userHost >= isvTokens.size())
+    {
+        return;
+    }
+
+    reportRow.resize(Layout::fields);
+    reportRow[Layout::date] = isvTokens[IsvIndexDate];
+    reportRow[Layout::time] = isvTokens[IsvIndexTime];
+    reportRow[Layout::product] = isvTokens[field];
+    string_view version = isvTokens[field + 1];
+    reportRow[Layout::version] = (! version.empty() && version.front() == 'v') ? version.substr(1) : version;
+    splitUserHost(isvTokens[userHost], reportRow[Layout::user], reportRow[Layout::host]);
+    reportRow[Layout::count] = "1";
+    if (userHost + 2 < isvTokens.size() && isvTokens[userHost + 1].size() > 1 &&
+        isvTokens[userHost + 1].front() == '(' && isvTokens[userHost + 2].substr(0, 7) == "license")
+    {
+        reportRow[Layout::count] = isvTokens[userHost + 1].substr(1);
+    }
+    if constexpr (Type != DenyEvent)
+    {
+        const char* handleEnd = isvTokens[userHost].data() + isvTokens[userHost].size();
+        reportRow[Layout::handle] = string_view(isvTokens[field].data(), static_cast<size_t>(handleEnd - isvTokens[field].data()));
+    }
+}
+
+// Projects a line of an ISV log onto the fields of a report log line,
+// which extractEvent reads the same way: the fields are views into the
+// line, nothing is copied.  A server start, "Server started on host", and a
+// shutdown become START and SHUTDOWN events, and a line with a full date
+// becomes a date line.  Returns false for a line with neither.
+bool LogData::projectIsvLine(const vector<string_view>& isvTokens, vector<string_view>& reportRow) const
+{
+    if (isvTokens.size() <= IsvIndexEvent)
+    {
+        return false;
+    }
+    string_view keyword = isvTokens[IsvIndexEvent];
+    if (keyword == "OUT:")
+    {
+        projectIsvLicenseEvent<OutEvent>(isvTokens, "OUT", reportRow);
+        return true;
+    }
+    if (keyword == "IN:")
+    {
+        projectIsvLicenseEvent<InEvent>(isvTokens, "IN", reportRow);
+        return true;
+    }
+    if (keyword == "DENIED:")
+    {
+        projectIsvLicenseEvent<DenyEvent>(isvTokens, "DENY", reportRow);
+        return true;
+    }
+    if (keyword == "Server" && isvTokens.size() > IsvIndexEvent + 1 && isvTokens[IsvIndexEvent + 1] == "started")
+    {
+        typedef ReportEventLayout<StartEvent> Layout;
+        reportRow.assign(Layout::fields, string_view());
+        reportRow[RepIndexEvent] = "START";
+        reportRow[Layout::date] = isvTokens[IsvIndexDate];
+        reportRow[Layout::time] = isvTokens[IsvIndexTime];
+        for (size_t field = IsvIndexEvent + 2; field + 1 < isvTokens.size(); ++field)
+        {
+            if (isvTokens[field] == "on")
+            {
+                reportRow[Layout::server] = isvTokens[field + 1];
+                break;
+            }
+        }
+        return true;
+    }
+    if (keyword == "Shutdown")
+    {
+        typedef ReportEventLayout<ShutdownEvent> Layout;
+        reportRow.assign(Layout::fields, string_view());
+        reportRow[RepIndexEvent] = "SHUTDOWN";
+        reportRow[Layout::date] = isvTokens[IsvIndexDate];
+        reportRow[Layout::time] = isvTokens[IsvIndexTime];
+        return true;
+    }
+    for (size_t field = IsvIndexEvent; field < isvTokens.size(); ++field)
+    {
+        if (isFullDate(isvTokens[field]))
+        {
+            reportRow.assign(1, isvTokens[field]);
+            reportRow.push_back(isvTokens[IsvIndexTime]);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether the line is long enough to hold every field of its event type
+bool LogData::hasEventFields(const vector<string_view>& allDataRow, eventType type) const
+{
+    return allDataRow.size() >= ReportEventFields[type];
+}
+
+void LogData::getConcurrentUsage()
+{
+    startConcurrentUsage();
+    if (canShardUsage())
+    {
+        shardConcurrentUsage();
+    }
+    else
+    {
+        updateConcurrentUsage(m_firstNewRow);
+    }
+}
+
+// Sets up the concurrent usage pass.  A pipelined pass starts before any
+// product or user is known and lays the tables out as they come.
+void LogData::startConcurrentUsage()
+{
+    // A resumed analysis continues from the counters of the checkpoint
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    m_usageCounters.resize(numberOfProducts, UsageCounters());
+    m_recordedCounters.resize(numberOfProducts, UsageCounters());
+    m_initialUsageCounters = m_recordedCounters;
+
+    // Imaris license count by user and product (Imaris module), one flat
+    // array indexed by user * numberOfProducts + product
+    m_licenseCounts.assign(m_uniqueUsers.size() * numberOfProducts, 0);
+    for (size_t entry = 0; entry < m_checkpoint.licenseCounts.size(); ++entry)
+    {
+        const CheckpointEntry& licenseCount = m_checkpoint.licenseCounts.at(entry);
+        m_licenseCounts.at(licenseCount.row * numberOfProducts + licenseCount.product) = static_cast<uint32_t>(licenseCount.value);
+    }
+    m_reservedCounts.assign(m_licenseCounts.size(), 0);
+    for (size_t entry = 0; entry < m_checkpoint.reservedCounts.size(); ++entry)
+    {
+        const CheckpointEntry& reservedCount = m_checkpoint.reservedCounts.at(entry);
+        m_reservedCounts.at(reservedCount.row * numberOfProducts + reservedCount.product) = static_cast<uint32_t>(reservedCount.value);
+    }
+    listHeldLicenseCounts();
+
+    m_usageHeatmap.clear();
+    m_licenseSaturation.clear();
+    m_sustainedPeaks.clear();
+    m_versionUsage.clear();
+    m_denialCounters.clear();
+    m_hourlyDenials.clear();
+    if (m_resumed)
+    {
+        m_usageHeatmap.restore(m_checkpoint);
+        m_licenseSaturation.restore(m_checkpoint);
+        m_sustainedPeaks.restore(m_checkpoint);
+        m_versionUsage.restoreConcurrency(m_checkpoint);
+        for (size_t entry = 0; entry < m_checkpoint.hourlyDenials.size(); ++entry)
+        {
+            const CheckpointEntry& denials = m_checkpoint.hourlyDenials.at(entry);
+            HourlyDenials& hour = m_hourlyDenials[make_pair(static_cast<long long>(denials.row), static_cast<size_t>(denials.product))];
+            hour.denials = static_cast<uint64_t>(denials.value);
+            hour.atLimit = static_cast<uint64_t>(m_checkpoint.hourlyDenialsAtLimit.at(entry));
+        }
+    }
+
+    m_usageChangeOffsets.push_back(0);
+}
+
+// Runs the concurrent usage pass over the events from firstRow on.  A
+// followed log calls it again for the events of every read.
+void LogData::updateConcurrentUsage(size_t firstRow)
+{
+    reserveUsageTimeline(usageEventsBetween(firstRow, m_events.size()));
+    countUsage(firstRow, m_events.size(), m_uniqueProducts.size(), m_uniqueUsers.size());
+    m_usageHeatmap.flush();
+    indexConcurrentUsage();
+}
+
+// The counters of every product evolve on their own but for a shutdown,
+// which resets all of them, so a fresh pass over many events is split by
+// product across the pool: every shard walks all the events, counts those
+// of its products and takes each shutdown and the time of every event.
+bool LogData::canShardUsage() const
+{
+    return m_pool != NULL && m_pool->size() > 1 && ! m_resumed && m_uniqueProducts.size() > 1 &&
+           m_events.size() - m_firstNewRow >= MinShardedUsageEvents;
+}
+
+// Runs the concurrent usage pass over the new events in shards of products
+// with about as many events each, and merges them in the order of the
+// events: the timeline entries take the changes of the shards in product
+// order, the saturation intervals are listed by the row that closed them.
+void LogData::shardConcurrentUsage()
+{
+    const size_t firstRow = m_firstNewRow;
+    const size_t endRow = m_events.size();
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    layOutUsage(numberOfProducts, m_uniqueUsers.size());
+    size_t firstDenial = addDenialCounters(firstRow, endRow);
+
+    vector<size_t> productEvents(numberOfProducts, 0);
+    size_t productRows = 0;
+    for (size_t row = firstRow; row < endRow; ++row)
+    {
+        if (m_events.products[row] < numberOfProducts)
+        {
+            ++productEvents[m_events.products[row]];
+            ++productRows;
+        }
+    }
+    // Every shard takes a timeline entry for each of these events
+    const size_t usageEvents = reportSelected(ConcurrentUsageReport) ? usageEventsBetween(firstRow, endRow) : 0;
+    reserveUsageTimeline(usageEvents);
+    const size_t shardCount = min(m_pool->size(), numberOfProducts);
+    vector<UsageShard> shards;
+    shards.reserve(shardCount);
+    size_t firstProduct = 0;
+    size_t counted = 0;
+    for (size_t product = 0; product < numberOfProducts; ++product)
+    {
+        counted += productEvents[product];
+        if (product + 1 == numberOfProducts ||
+            (shards.size() + 1 < shardCount && counted * shardCount >= productRows * (shards.size() + 1)))
+        {
+            shards.emplace_back();
+            shards.back().firstProduct = firstProduct;
+            shards.back().endProduct = product + 1;
+            firstProduct = product + 1;
+        }
+    }
+
+    vector<UsagePass> passes(shards.size());
+    for (size_t shard = 0; shard < shards.size(); ++shard)
+    {
+        UsageShard& tables = shards[shard];
+        tables.heatmap.resize(numberOfProducts);
+        tables.peaks.resize(numberOfProducts);
+        tables.saturation.resize(numberOfProducts);
+        tables.usageChangeOffsets.reserve(usageEvents + 1);
+        tables.usageChangeOffsets.push_back(0);
+        UsagePass pass = { tables.firstProduct, tables.endProduct, &tables.heatmap, &tables.peaks, &tables.saturation,
+                           &tables.versions, &tables.saturationRows, (shard == 0) ? &m_usageRows : NULL,
+                           &tables.usageChangeOffsets, &tables.usageChanges, &tables.heldLicenseCounts, &tables.reservedCheckOuts,
+                           &tables.hourlyDenials };
+        passes[shard] = pass;
+    }
+    {
+        TaskGroup shardTasks(*m_pool);
+        for (size_t shard = 0; shard < passes.size(); ++shard)
+        {
+            UsagePass* pass = &passes[shard];
+            shardTasks.run([this, pass, firstRow, endRow, numberOfProducts, firstDenial]()
+            {
+                countUsageRows(*pass, firstRow, endRow, numberOfProducts, firstDenial);
+            });
+        }
+        shardTasks.wait();
+    }
+
+    for (size_t shard = 0; shard < shards.size(); ++shard)
+    {
+        const UsageShard& tables = shards[shard];
+        m_usageHeatmap.takeProducts(tables.heatmap, tables.firstProduct, tables.endProduct);
+        m_sustainedPeaks.takeProducts(tables.peaks, tables.firstProduct, tables.endProduct);
+        m_versionUsage.takeProducts(tables.versions, tables.firstProduct, tables.endProduct);
+        m_licenseSaturation.takeProducts(tables.saturation, tables.firstProduct, tables.endProduct);
+        m_hourlyDenials.insert(tables.hourlyDenials.begin(), tables.hourlyDenials.end());
+        m_reservedCheckOuts.insert(m_reservedCheckOuts.end(), tables.reservedCheckOuts.begin(), tables.reservedCheckOuts.end());
+    }
+    sort(m_reservedCheckOuts.begin(), m_reservedCheckOuts.end());
+    vector<size_t> nextInterval(shards.size(), 0);
+    for (;;)
+    {
+        size_t closing = shards.size();
+        for (size_t shard = 0; shard < shards.size(); ++shard)
+        {
+            if (nextInterval[shard] < shards[shard].saturationRows.size() &&
+                (closing == shards.size() ||
+                 shards[shard].saturationRows[nextInterval[shard]] < shards[closing].saturationRows[nextInterval[closing]]))
+            {
+                closing = shard;
+            }
+        }
+        if (closing == shards.size())
+        {
+            break;
+        }
+        m_licenseSaturation.addClosedInterval(shards[closing].saturation.closedIntervals()[nextInterval[closing]++]);
+    }
+    if (reportSelected(ConcurrentUsageReport))
+    {
+        for (size_t entry = 0; entry + 1 < shards.front().usageChangeOffsets.size(); ++entry)
+        {
+            for (size_t shard = 0; shard < shards.size(); ++shard)
+            {
+                const UsageShard& tables = shards[shard];
+                m_usageChanges.insert(m_usageChanges.end(), tables.usageChanges.begin() + tables.usageChangeOffsets[entry],
+                                      tables.usageChanges.begin() + tables.usageChangeOffsets[entry + 1]);
+            }
+            m_usageChangeOffsets.push_back(m_usageChanges.size());
+        }
+    }
+    listHeldLicenseCounts();
+
+    m_usageHeatmap.flush();
+    indexConcurrentUsage();
+}
+
+// Lays the tables of the concurrent usage pass out for the products and
+// users known.  The license count table is laid out again when products or
+// users were added.
+void LogData::layOutUsage(size_t numberOfProducts, size_t numberOfUsers)
+{
+    const size_t countedProducts = m_usageCounters.size();
+    if (countedProducts != numberOfProducts || m_licenseCounts.size() != numberOfUsers * numberOfProducts)
+    {
+        vector<uint32_t> licenseCounts(numberOfUsers * numberOfProducts, 0);
+        vector<uint32_t> reservedCounts(licenseCounts.size(), 0);
+        for (size_t countIndex = 0; countedProducts > 0 && countIndex < m_licenseCounts.size(); ++countIndex)
+        {
+            size_t laidOut = countIndex / countedProducts * numberOfProducts + countIndex % countedProducts;
+            licenseCounts.at(laidOut) = m_licenseCounts.at(countIndex);
+            reservedCounts.at(laidOut) = m_reservedCounts.at(countIndex);
+        }
+        m_licenseCounts.swap(licenseCounts);
+        m_reservedCounts.swap(reservedCounts);
+        listHeldLicenseCounts();
+        m_usageCounters.resize(numberOfProducts, UsageCounters());
+        m_recordedCounters.resize(numberOfProducts, UsageCounters());
+    }
+    m_usageHeatmap.resize(numberOfProducts);
+    m_licenseSaturation.resize(numberOfProducts);
+    m_sustainedPeaks.resize(numberOfProducts);
+}
+
+// Makes room for the counters of the denials among the events [firstRow,
+// endRow) and returns the index of the first one
+size_t LogData::addDenialCounters(size_t firstRow, size_t endRow)
+{
+    size_t firstDenial = m_denialCounters.size();
+    size_t denials = 0;
+    for (size_t row = firstRow; row < endRow; ++row)
+    {
+        if (m_events.types[row] == DenyEvent)
+        {
+            ++denials;
+        }
+    }
+    m_denialCounters.resize(firstDenial + denials, UsageCounters());
+    return firstDenial;
+}
+
+// Counts the events [firstRow, endRow) of the concurrent usage pass, with
+// the products and users known up to endRow.  A pipelined pass runs on its
+// own thread while later events are appended, so it reads nothing but these
+// rows of the events, through operator[].
+void LogData::countUsage(size_t firstRow, size_t endRow, size_t numberOfProducts, size_t numberOfUsers)
+{
+    layOutUsage(numberOfProducts, numberOfUsers);
+    size_t firstDenial = addDenialCounters(firstRow, endRow);
+    UsagePass pass = { 0, numberOfProducts, &m_usageHeatmap, &m_sustainedPeaks, &m_licenseSaturation, &m_versionUsage, NULL,
+                       &m_usageRows, &m_usageChangeOffsets, &m_usageChanges, &m_heldLicenseCounts, &m_reservedCheckOuts,
+                       &m_hourlyDenials };
+    countUsageRows(pass, firstRow, endRow, numberOfProducts, firstDenial);
+}
+
+// Counts the events [firstRow, endRow) of the products of the pass; the
+// first denial among them has the counters at index denial.  The events of
+// other products only move the clocks of the pass on.  Passes over other
+// products change other counters and license counts than this one.  The
+// log gives the reserved licenses in use after every OUT and IN but not
+// whose they are: an OUT that raises them took a reserved license, and an
+// IN that lowers them returned one of its user's.
+void LogData::countUsageRows(UsagePass& pass, size_t firstRow, size_t endRow, size_t numberOfProducts, size_t denial)
+{
+    vector<UsageCounters>& counters = m_usageCounters;
+    vector<UsageCounters>& recordedCounters = m_recordedCounters;
+    vector<uint32_t>& licenseCountByProductAndUser = m_licenseCounts;
+    vector<uint32_t>& reservedCountByProductAndUser = m_reservedCounts;
+    vector<size_t>& heldLicenseCounts = *pass.heldLicenseCounts;
+    const bool countVersions = reportSelected(VersionUsageReport);
+    size_t productCountIndex;
+
+    for (size_t row=firstRow; row<endRow; ++row)
+    {
+        if ((row - firstRow) % CancellationPollRows == 0)
+        {
+            throwIfCancelled();
+        }
+        if (m_events.types[row] != ShutdownEvent &&
+            (m_events.products[row] < pass.firstProduct || m_events.products[row] >= pass.endProduct))
+        {
+            if (m_events.types[row] == OutEvent || m_events.types[row] == InEvent)
+            {
+                gatherConcurrentUsageData(pass, row, counters, recordedCounters);
+            }
+            else if (m_events.types[row] == DenyEvent)
+            {
+                ++denial;
+            }
+            continue;
+        }
+
+        if (m_events.types[row] == OutEvent)
+        {
+            productCountIndex = m_events.products[row];
+            UsageCounters& productCounters = indexed(counters, productCountIndex);
+            size_t countIndex = m_events.users[row] * numberOfProducts + productCountIndex;
+            uint32_t& userLicenseCount = indexed(licenseCountByProductAndUser, countIndex);
+
+            // Total usage
+            productCounters.floatingInUse = m_events.counts[row];
+            
+            // Unique usage
+            ++userLicenseCount;
+            if (userLicenseCount == 1)
+            {
+                ++productCounters.totalInUse;
+                if (heldLicenseCounts.size() < licenseCountByProductAndUser.size())
+                {
+                    heldLicenseCounts.push_back(countIndex);
+                }
+            }
+
+            // Reserved Imaris License Usage Data
+            if (m_events.reserved[row] > productCounters.reservedInUse)
+            {
+                ++indexed(reservedCountByProductAndUser, countIndex);
+                pass.reservedCheckOuts->push_back(row);
+            }
+            productCounters.reservedInUse = m_events.reserved[row];
+
+            if (countVersions)
+            {
+                pass.versions->checkOut(productCountIndex, m_events.versions[row], m_events.timestamps[row]);
+            }
+
+            gatherConcurrentUsageData(pass, row, counters, recordedCounters);
+        }
+        else if (m_events.types[row] == InEvent)
+        {
+            productCountIndex = m_events.products[row];
+            UsageCounters& productCounters = indexed(counters, productCountIndex);
+            size_t countIndex = m_events.users[row] * numberOfProducts + productCountIndex;
+            uint32_t& userLicenseCount = indexed(licenseCountByProductAndUser, countIndex);
+            uint32_t& userReservedCount = indexed(reservedCountByProductAndUser, countIndex);
+
+            // Total usage
+            productCounters.floatingInUse = m_events.counts[row];
+            
+            // Unique usage
+
+            // Make sure we can't iterate below zero
+            // (could happen if the log file started with licenses already checked out and the first event is a check-in)
+            if (userLicenseCount > 0)
+            {
+                --userLicenseCount;
+            }
+
+            // Reserved Imaris License Usage Data
+            if (m_events.reserved[row] < productCounters.reservedInUse && userReservedCount > 0)
+            {
+                --userReservedCount;
+            }
+            userReservedCount = min(userReservedCount, userLicenseCount);
+            productCounters.reservedInUse = m_events.reserved[row];
+
+            if (userLicenseCount == 0 && productCounters.totalInUse > 0)
+            {
+                --productCounters.totalInUse;
+            }
+
+            if (countVersions)
+            {
+                pass.versions->checkIn(productCountIndex, m_events.versions[row]);
+            }
+
+            if (productCounters.floatingInUse > 0 && productCounters.totalInUse == 0)
+            {
+                // This deals with the special case where a report log started after licenses were checked out.
+                // The log has no data on who checked out the licenses, it just gives a count of what's checked out.
+                // We post "1".  The actual value would be greater than or equal to that value.
+                productCounters.totalInUse = 1;
+                gatherConcurrentUsageData(pass, row, counters, recordedCounters);
+
+                // Set the unique value back down to zero.  Otherwise, a subsequent OUT event will cause the unique users to go up
+                // to "2", even though we're not sure if the check-out is unique or not.
+                productCounters.totalInUse = 0;
+            }
+            else
+            {
+                gatherConcurrentUsageData(pass, row, counters, recordedCounters);
+            }
+        }
+        else if (m_events.types[row] == ShutdownEvent)
+        {
+            for (size_t product=pass.firstProduct; product<pass.endProduct; ++product)
+            {
+                UsageCounters& productCounters = indexed(counters, product);
+                productCounters.floatingInUse = 0;
+                productCounters.totalInUse = 0;
+                productCounters.reservedInUse = 0;
+            }
+            if (heldLicenseCounts.size() < licenseCountByProductAndUser.size())
+            {
+                for (size_t countIndex : heldLicenseCounts)
+                {
+                    licenseCountByProductAndUser[countIndex] = 0;
+                    reservedCountByProductAndUser[countIndex] = 0;
+                }
+            }
+            else
+            {
+                for (size_t userCounts = 0; userCounts < licenseCountByProductAndUser.size(); userCounts += numberOfProducts)
+                {
+                    fill(licenseCountByProductAndUser.begin() + userCounts + pass.firstProduct,
+                         licenseCountByProductAndUser.begin() + userCounts + pass.endProduct, 0);
+                    fill(reservedCountByProductAndUser.begin() + userCounts + pass.firstProduct,
+                         reservedCountByProductAndUser.begin() + userCounts + pass.endProduct, 0);
+                }
+            }
+            heldLicenseCounts.clear();
+            if (countVersions)
+            {
+                pass.versions->shutDown(pass.firstProduct, pass.endProduct);
+            }
+            gatherConcurrentUsageData(pass, row, counters, recordedCounters);
+        }
+        else if (m_events.types[row] == ProductEvent)
+        {
+            productCountIndex = m_events.products[row];
+            UsageCounters& productCounters = indexed(counters, productCountIndex);
+            productCounters.floatingLimit = m_events.counts[row];
+            productCounters.reservedLimit = m_events.reserved[row];
+        }
+        // A denial takes the counters of its product as they are, for the
+        // denied requests and the denials by hour.  The requests merged into
+        // a coalesced denial count for the hour of its first one.
+        else if (m_events.types[row] == DenyEvent)
+        {
+            const UsageCounters& productCounters = indexed(counters, m_events.products[row]);
+            indexed(m_denialCounters, denial) = productCounters;
+
+            size_t requests = m_denialRepeats.empty() ? 1 : indexed(m_denialRepeats, denial);
+            long long time = m_events.timestamps[row];
+            long long hourStart = time - ((time % 3600) + 3600) % 3600;
+            HourlyDenials& hour = (*pass.hourlyDenials)[make_pair(hourStart, static_cast<size_t>(m_events.products[row]))];
+            hour.denials += requests;
+            if (productCounters.floatingLimit > 0 && productCounters.floatingInUse >= productCounters.floatingLimit)
+            {
+                hour.atLimit += requests;
+            }
+            ++denial;
+        }
+    }
+}
+
+// Lists the license counts above zero, after the table was filled or laid
+// out again
+void LogData::listHeldLicenseCounts()
+{
+    m_heldLicenseCounts.clear();
+    for (size_t countIndex = 0; countIndex < m_licenseCounts.size(); ++countIndex)
+    {
+        if (m_licenseCounts[countIndex] > 0)
+        {
+            m_heldLicenseCounts.push_back(countIndex);
+        }
+    }
+}
+
+// Takes the snapshots of the timeline entries added since the last call
+void LogData::indexConcurrentUsage()
+{
+    if (m_indexedUsageRows == 0)
+    {
+        m_indexedCounters = m_initialUsageCounters;
+    }
+    m_indexedCounters.resize(m_uniqueProducts.size(), UsageCounters());
+
+    for (; m_indexedUsageRows < m_usageRows.size(); ++m_indexedUsageRows)
+    {
+        long long eventTime = m_events.timestamps[m_usageRows[m_indexedUsageRows]];
+        if (m_indexedUsageRows == 0 || eventTime > m_indexedUsageTime)
+        {
+            m_indexedUsageTime = eventTime;
+        }
+
+        if (m_indexedUsageRows % UsageSnapshotInterval == 0)
+        {
+            UsageSnapshot snapshot;
+            snapshot.time = m_indexedUsageTime;
+            snapshot.counters = m_indexedCounters;
+            m_usageSnapshots.push_back(snapshot);
+        }
+        applyUsageChanges(m_indexedUsageRows, m_indexedCounters);
+        raiseCounters(m_usageSnapshots.back().maxima, m_indexedCounters);
+    }
+}
+
+int LogData::getCountOffset(const size_t& row)
+{
+    return m_events.counts.at(row);
+}
+
+// Adds a row to the concurrent usage timeline.  Only the products of the
+// pass whose counters differ from the ones last recorded are stored with it.
+void LogData::gatherConcurrentUsageData(UsagePass& pass,
+                                        const size_t& row,
+                                        const vector<UsageCounters>& counters,
+                                        vector<UsageCounters>& recordedCounters)
+{
+    // The timeline is only kept for the concurrent usage report and the
+    // queries; the heatmap, the saturation and the sustained peaks take the
+    // changes as they come
+    bool timeline = reportSelected(ConcurrentUsageReport);
+    bool heatmap = reportSelected(UsageHeatmapReport);
+    bool saturation = reportSelected(LicenseSaturationReport);
+    bool peaks = reportSelected(SustainedPeaksReport);
+    if (heatmap)
+    {
+        pass.heatmap->advance(m_events.timestamps[row]);
+    }
+    if (peaks)
+    {
+        pass.peaks->advance(m_events.timestamps[row]);
+    }
+    for (size_t product=pass.firstProduct; product<pass.endProduct; ++product)
+    {
+        const UsageCounters& productCounters = indexed(counters, product);
+        UsageCounters& recorded = indexed(recordedCounters, product);
+        if (productCounters != recorded)
+        {
+            if (heatmap && productCounters.floatingInUse != recorded.floatingInUse)
+            {
+                pass.heatmap->change(product, productCounters.floatingInUse);
+            }
+            if (peaks && productCounters.floatingInUse != recorded.floatingInUse)
+            {
+                pass.peaks->change(product, productCounters.floatingInUse);
+            }
+            if (saturation)
+            {
+                pass.saturation->update(product, m_events.timestamps[row],
+                                           productCounters.floatingInUse, productCounters.floatingLimit);
+            }
+            if (timeline)
+            {
+                UsageChange change;
+                change.product = product;
+                change.counters = productCounters;
+                pass.usageChanges->push_back(change);
+            }
+            recorded = productCounters;
+        }
+    }
+    if (pass.saturationRows != NULL)
+    {
+        pass.saturationRows->resize(pass.saturation->closedIntervals().size(), row);
+    }
+    if (timeline)
+    {
+        if (pass.usageRows != NULL)
+        {
+            pass.usageRows->push_back(row);
+        }
+        pass.usageChangeOffsets->push_back(pass.usageChanges->size());
+    }
+}
+
+// Concurrent usage in the wide layout: one row per timeline entry with
+// five columns per product.  The rows are expanded from the change log
+// while they are written.
+void LogData::writeConcurrentUsage(const string& outputFilePath)
+{
+    auto writeHeader = [this](BufferedWriter& out)
+    {
+        out.write("Date/Time");
+        for (size_t product=0; product<m_uniqueProducts.size(); ++product)
+        {
+            string_view productName = m_uniqueProducts.name(product);
+            out.write(',');
+            out.write(productName);
+            out.write(" Floating Licenses in use,");
+            out.write(productName);
+            out.write(" Total Licenses in use,");
+            out.write(productName);
+            out.write(" Floating Licenses Limit,");
+            out.write(productName);
+            out.write(" Reserved Licenses in use,");
+            out.write(productName);
+            out.write(" Reserved Licenses Limit");
+        }
+        out.write('\n');
+    };
+
+    writeTimeOrdered(outputFilePath, 0, m_usageRows.size(), [this](size_t usageRow)
+    {
+        return m_events.timestamps[m_usageRows[usageRow]];
+    }, writeHeader, [this](BufferedWriter& rangeOut, size_t firstUsageRow, size_t endUsageRow)
+    {
+        // A range further on starts from the usage replayed up to it
+        vector<UsageCounters> counters(m_initialUsageCounters);
+        if (firstUsageRow > 0)
+        {
+            usageBefore(firstUsageRow, counters);
+            counters.resize(m_initialUsageCounters.size(), UsageCounters());
+        }
+        for (size_t usageRow=firstUsageRow; usageRow<endUsageRow; ++usageRow)
+        {
+            for (size_t change=m_usageChangeOffsets[usageRow]; change<m_usageChangeOffsets[usageRow+1]; ++change)
+            {
+                counters[m_usageChanges[change].product] = m_usageChanges[change].counters;
+            }
+
+            rangeOut.writeLogDateTime(m_events.timestamps[m_usageRows[usageRow]]);
+            for (size_t product=0; product<counters.size(); ++product)
+            {
+                const UsageCounters& productCounters = counters[product];
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.floatingInUse);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.totalInUse);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.floatingLimit);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.reservedInUse);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.reservedLimit);
+            }
+            rangeOut.write('\n');
+        }
+    });
+}
+
+// Concurrent usage resampled to buckets of m_usageBucketSeconds: the max,
+// time-weighted mean and min of the floating licenses in use per product.
+// The usage is constant between timeline entries; several entries at the
+// same time all count for the max and min but not for the mean.  The first
+// and last buckets only average over the part the log covers.
+void LogData::writeConcurrentUsageBuckets(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Bucket Start");
+    for (size_t product=0; product<m_uniqueProducts.size(); ++product)
+    {
+        string_view productName = m_uniqueProducts.name(product);
+        out.write(',');
+        out.write(productName);
+        out.write(" Max Floating Licenses in use,");
+        out.write(productName);
+        out.write(" Mean Floating Licenses in use,");
+        out.write(productName);
+        out.write(" Min Floating Licenses in use");
+    }
+    out.write('\n');
+
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    vector<int32_t> inUse(numberOfProducts, 0);
+    vector<int32_t> bucketMax(numberOfProducts, 0);
+    vector<int32_t> bucketMin(numberOfProducts, 0);
+    vector<double> bucketIntegral(numberOfProducts, 0.0);
+    long long bucketStart = 0;
+    long long coveredStart = 0;
+    long long lastTime = 0;
+
+    for (size_t usageRow=0; usageRow<m_usageRows.size(); ++usageRow)
+    {
+        long long eventTime = m_events.timestamps.at(m_usageRows.at(usageRow));
+
+        if (usageRow == 0)
+        {
+            bucketStart = eventTime - ((eventTime % m_usageBucketSeconds) + m_usageBucketSeconds) % m_usageBucketSeconds;
+            coveredStart = eventTime;
+            lastTime = eventTime;
+        }
+        else
+        {
+            // Events slightly out of order do not move the clock back
+            if (eventTime < lastTime)
+            {
+                eventTime = lastTime;
+            }
+
+            while (eventTime >= bucketStart + m_usageBucketSeconds)
+            {
+                long long bucketEnd = bucketStart + m_usageBucketSeconds;
+                out.writeLogDateTime(bucketStart);
+                for (size_t product=0; product<numberOfProducts; ++product)
+                {
+                    bucketIntegral.at(product) += static_cast<double>(inUse.at(product)) * (bucketEnd - lastTime);
+                    out.write(',');
+                    out.writeInteger(bucketMax.at(product));
+                    out.write(',');
+                    out.writeFixed(bucketIntegral.at(product) / (bucketEnd - coveredStart), 2);
+                    out.write(',');
+                    out.writeInteger(bucketMin.at(product));
+
+                    bucketMax.at(product) = inUse.at(product);
+                    bucketMin.at(product) = inUse.at(product);
+                    bucketIntegral.at(product) = 0.0;
+                }
+                out.write('\n');
+
+                bucketStart = bucketEnd;
+                coveredStart = bucketEnd;
+                lastTime = bucketEnd;
+            }
+
+            for (size_t product=0; product<numberOfProducts; ++product)
+            {
+                bucketIntegral.at(product) += static_cast<double>(inUse.at(product)) * (eventTime - lastTime);
+            }
+            lastTime = eventTime;
+        }
+
+        for (size_t change=m_usageChangeOffsets.at(usageRow); change<m_usageChangeOffsets.at(usageRow+1); ++change)
+        {
+            inUse.at(m_usageChanges.at(change).product) = m_usageChanges.at(change).counters.floatingInUse;
+        }
+        for (size_t product=0; product<numberOfProducts; ++product)
+        {
+            if (usageRow == 0 || inUse.at(product) > bucketMax.at(product))
+            {
+                bucketMax.at(product) = inUse.at(product);
+            }
+            if (usageRow == 0 || inUse.at(product) < bucketMin.at(product))
+            {
+                bucketMin.at(product) = inUse.at(product);
+            }
+        }
+    }
+
+    // The last bucket ends with the last event
+    if (! m_usageRows.empty())
+    {
+        out.writeLogDateTime(bucketStart);
+        for (size_t product=0; product<numberOfProducts; ++product)
+        {
+            double mean = inUse.at(product);
+            if (lastTime > coveredStart)
+            {
+                mean = bucketIntegral.at(product) / (lastTime - coveredStart);
+            }
+            out.write(',');
+            out.writeInteger(bucketMax.at(product));
+            out.write(',');
+            out.writeFixed(mean, 2);
+            out.write(',');
+            out.writeInteger(bucketMin.at(product));
+        }
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Concurrent usage in the long (sparse) layout: one row per product whose
+// counters changed at a timeline entry
+void LogData::writeConcurrentUsageLong(const string& outputFilePath)
+{
+    auto writeHeader = [](BufferedWriter& out)
+    {
+        out.write("Date/Time,Product,Floating Licenses in use,Total Licenses in use,"
+                  "Floating Licenses Limit,Reserved Licenses in use,Reserved Licenses Limit\n");
+    };
+
+    writeTimeOrdered(outputFilePath, 0, m_usageRows.size(), [this](size_t usageRow)
+    {
+        return m_events.timestamps[m_usageRows[usageRow]];
+    }, writeHeader, [this](BufferedWriter& rangeOut, size_t firstUsageRow, size_t endUsageRow)
+    {
+        for (size_t usageRow=firstUsageRow; usageRow<endUsageRow; ++usageRow)
+        {
+            long long eventTime = m_events.timestamps[m_usageRows[usageRow]];
+            for (size_t change=m_usageChangeOffsets[usageRow]; change<m_usageChangeOffsets[usageRow+1]; ++change)
+            {
+                const UsageCounters& productCounters = m_usageChanges[change].counters;
+                rangeOut.writeLogDateTime(eventTime);
+                rangeOut.write(',');
+                rangeOut.write(m_uniqueProducts.name(m_usageChanges[change].product));
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.floatingInUse);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.totalInUse);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.floatingLimit);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.reservedInUse);
+                rangeOut.write(',');
+                rangeOut.writeInteger(productCounters.reservedLimit);
+                rangeOut.write('\n');
+            }
+        }
+    });
+}
+
+// Calls visit with the row and type of every OUT, IN, START and SHUTDOWN
+// in log order, merging their row lists, so the passes that only follow
+// the handles and the epochs of the server skip the denials and products
+// without looking at them.
+template <typename Visit>
+void LogData::forLicenseRows(Visit visit) const
+{
+    size_t nextOut = 0;
+    size_t nextIn = 0;
+    size_t nextStart = 0;
+    size_t nextShutdown = 0;
+    while (true)
+    {
+        size_t outRow = (nextOut < m_checkOutRows.size()) ? m_checkOutRows[nextOut] : NoId;
+        size_t inRow = (nextIn < m_checkInRows.size()) ? m_checkInRows[nextIn] : NoId;
+        size_t startRow = (nextStart < m_startRows.size()) ? m_startRows[nextStart] : NoId;
+        size_t shutdownRow = (nextShutdown < m_shutdownRows.size()) ? m_shutdownRows[nextShutdown] : NoId;
+        if (outRow < inRow && outRow < startRow && outRow < shutdownRow)
+        {
+            ++nextOut;
+            visit(outRow, OutEvent);
+        }
+        else if (inRow < startRow && inRow < shutdownRow)
+        {
+            ++nextIn;
+            visit(inRow, InEvent);
+        }
+        else if (startRow < shutdownRow)
+        {
+            ++nextStart;
+            visit(startRow, StartEvent);
+        }
+        else if (shutdownRow != NoId)
+        {
+            ++nextShutdown;
+            visit(shutdownRow, ShutdownEvent);
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+// Pairs every OUT with the event that returns its license, which is the
+// next IN with the same handle or, failing that, the next SHUTDOWN.  A
+// single forward pass keeps the open sessions by handle; an IN closes every
+// session open on its handle and a SHUTDOWN closes all of them.  checkOut
+// is called with the row of every OUT and returns the session it opens,
+// checkIn with the session and the row that closes it.  The open sessions
+// are keyed by the handle within the restart epoch of the server (see
+// startsEpoch): a START or SHUTDOWN closes all of them in bulk, so the
+// table is empty whenever a handle may be handed out again.  As only the
+// events of one handle pair with each other, and the epoch boundaries, the
+// pass can be split into shards of the handles: shard pairs the events of
+// the handles whose id modulo shards is shard, and every shard takes all
+// epoch boundaries.
+template <typename CheckOut, typename CheckIn>
+void LogData::pairSessions(CheckOut checkOut, CheckIn checkIn, size_t shard, size_t shards) const
+{
+    // The sessions open on each handle form a list through nextOpen,
+    // starting at the entry of the handle's latest check-out.  Handle ids
+    // are dense, so the lists live in plain arrays.  The entries of closed
+    // sessions are reused through the free list, so the arrays grow with
+    // the sessions open at once rather than with all of them.  openHandles
+    // lists the handles the end of the epoch may have to close, some of
+    // them already closed again by a check-in.
+    vector<size_t> lastOpen(m_uniqueHandles.size(), NoId);
+    vector<size_t> nextOpen;
+    vector<size_t> openSession;
+    vector<size_t> openHandles;
+    size_t freeEntries = NoId;
+
+    auto closeHandle = [&](size_t handle, size_t row)
+    {
+        size_t entry = indexed(lastOpen, handle);
+        while (entry != NoId)
+        {
+            checkIn(openSession[entry], row);
+            size_t next = nextOpen[entry];
+            nextOpen[entry] = freeEntries;
+            freeEntries = entry;
+            entry = next;
+        }
+        indexed(lastOpen, handle) = NoId;
+    };
+
+    size_t walked = 0;
+    forLicenseRows([&](size_t row, eventType type)
+    {
+        if (walked++ % CancellationPollRows == 0)
+        {
+            throwIfCancelled();
+        }
+        if ((type == OutEvent || type == InEvent) && shards > 1 && indexed(m_events.handles, row) % shards != shard)
+        {
+            return;
+        }
+        if (type == OutEvent)
+        {
+            size_t handle = indexed(m_events.handles, row);
+            size_t entry = freeEntries;
+            if (entry != NoId)
+            {
+                freeEntries = nextOpen[entry];
+            }
+            else
+            {
+                entry = nextOpen.size();
+                nextOpen.push_back(NoId);
+                openSession.push_back(NoId);
+            }
+            if (indexed(lastOpen, handle) == NoId)
+            {
+                openHandles.push_back(handle);
+            }
+            openSession[entry] = checkOut(row);
+            nextOpen[entry] = indexed(lastOpen, handle);
+            indexed(lastOpen, handle) = entry;
+        }
+        else if (type == InEvent)
+        {
+            closeHandle(indexed(m_events.handles, row), row);
+        }
+        // A shutdown or restart forces the return of any licenses so it will be the checkin time of
+        // any checked out licenses
+        else
+        {
+            for (size_t handle = 0; handle < openHandles.size(); ++handle)
+            {
+                closeHandle(indexed(openHandles, handle), row);
+            }
+            openHandles.clear();
+        }
+    });
+}
+
+// Sessions are paired by handle in shards across the pool when there are
+// enough events to pay for every shard walking them all
+bool LogData::canShardSessions() const
+{
+    return m_pool != NULL && m_pool->size() > 1 && m_events.size() >= MinShardedSessionEvents;
+}
+
+// Pairs the sessions in shards of handles.  The sessions are listed by
+// their OUT first, so every shard finds the session an OUT opens by its row
+// and closes sessions no other shard touches.
+void LogData::shardSessions()
+{
+    const size_t firstSession = m_sessions.size();
+    for (size_t checkOut = 0; checkOut < m_checkOutRows.size(); ++checkOut)
+    {
+        Session session;
+        session.checkOutRow = m_checkOutRows[checkOut];
+        session.checkInRow = NoId;
+        m_sessions.push_back(session);
+    }
+
+    const size_t shards = m_pool->size();
+    TaskGroup shardTasks(*m_pool);
+    for (size_t shard = 0; shard < shards; ++shard)
+    {
+        shardTasks.run([this, firstSession, shard, shards]()
+        {
+            pairSessions([this, firstSession](size_t row)
+                         {
+                             auto session = lower_bound(m_sessions.begin() + firstSession, m_sessions.end(), row,
+                                                        [](const Session& listed, size_t checkOutRow)
+                                                        {
+                                                            return listed.checkOutRow < checkOutRow;
+                                                        });
+                             return static_cast<size_t>(session - m_sessions.begin());
+                         },
+                         [this](size_t session, size_t row)
+                         {
+                             m_sessions[session].checkInRow = row;
+                         },
+                         shard, shards);
+        });
+    }
+    shardTasks.wait();
+}
+
+// Builds the session table for the license activity, the total durations,
+// the top usage, the version usage, the reserved usage and the chargeback,
+// counts the lengths of the closed sessions for the session durations
+// report, ranks the longest sessions for the top usage and adds them up by
+// version, by reserved or floating license and by group.  Sessions never closed run until m_endTimeRow, or the later last
+// event the filter left out.  With the session durations the only report
+// of the sessions, the pass keeps no sessions at all.
+void LogData::getSessions()
+{
+    bool countDurations = reportSelected(SessionDurationsReport);
+    if (countDurations)
+    {
+        m_sessionDurations.clear();
+        m_sessionDurations.resize(m_uniqueProducts.size());
+        m_sessionDurations.addEntries(m_checkpoint.durationCounts, m_checkpoint.longestSessions);
+    }
+    bool rankSessions = reportSelected(TopUsageReport);
+    LongestSessions openSessions;
+    if (rankSessions)
+    {
+        m_longestClosedSessions.clear();
+        m_longestClosedSessions.restore(m_checkpoint);
+        m_longestClosedSessions.resize(m_uniqueProducts.size());
+        openSessions.resize(m_uniqueProducts.size());
+    }
+    bool versionSessions = reportSelected(VersionUsageReport);
+    if (versionSessions)
+    {
+        m_versionUsage.clearSessions();
+        m_versionUsage.restoreSessions(m_checkpoint);
+    }
+    bool flagForgotten = reportSelected(ForgottenSessionsReport);
+    if (flagForgotten)
+    {
+        m_forgottenSessions.clear();
+        m_forgottenSessions.restore(m_checkpoint);
+    }
+    bool profileDemand = reportSelected(DemandProfileReport);
+    if (profileDemand)
+    {
+        m_demandProfile.clear();
+        m_demandProfile.restore(m_checkpoint);
+        m_demandProfile.resize(m_uniqueProducts.size());
+        for (size_t denial = 0; denial < m_denialRows.size(); ++denial)
+        {
+            size_t row = m_denialRows[denial];
+            m_demandProfile.addDenials(m_events.products[row], m_events.timestamps[row],
+                                       denial < m_denialRepeats.size() ? m_denialRepeats[denial] : 1);
+        }
+    }
+    bool billSessions = (m_groupMapping != NULL);
+    if (billSessions)
+    {
+        resolveGroups();
+        startChargeback();
+    }
+    bool splitReserved = reportSelected(ReservedUsageReport);
+    vector<CheckpointEntry> reservedDurations(m_checkpoint.reservedUserDurations);
+    vector<CheckpointEntry> floatingDurations(m_checkpoint.floatingUserDurations);
+
+    if (! reportSelected(LicenseActivityReport | TotalDurationHostsReport | TotalDurationUsersReport | TopUsageReport |
+                         VersionUsageReport | ReservedUsageReport | ForgottenSessionsReport | DemandProfileReport) &&
+        ! billSessions)
+    {
+        pairSessions([](size_t row)
+                     {
+                         return row;
+                     },
+                     [this](size_t checkOutRow, size_t row)
+                     {
+                         m_sessionDurations.add(m_events.products[checkOutRow],
+                                                m_events.timestamps[row] - m_events.timestamps[checkOutRow]);
+                     });
+        return;
+    }
+
+    // One session per OUT
+    reserveMore(m_sessions, m_checkOutRows.size());
+
+    if (canShardSessions())
+    {
+        shardSessions();
+    }
+    else
+    {
+        pairSessions([this](size_t row)
+                     {
+                         Session session;
+                         session.checkOutRow = row;
+                         session.checkInRow = NoId;
+                         m_sessions.push_back(session);
+                         return m_sessions.size() - 1;
+                     },
+                     [this](size_t session, size_t row)
+                     {
+                         m_sessions[session].checkInRow = row;
+                     });
+    }
+
+    size_t nextReserved = 0;
+    for (size_t session = 0; session < m_sessions.size(); ++session)
+    {
+        Session& current = indexed(m_sessions, session);
+        size_t checkOutRow = current.checkOutRow;
+        size_t endRow = current.checkInRow;
+        bool reserved = reservedCheckOut(checkOutRow, nextReserved);
+        long long endTime;
+        if (endRow != NoId)
+        {
+            endTime = indexed(m_events.timestamps, endRow);
+        }
+        else
+        {
+            endTime = this->endTime();
+        }
+
+        current.duration = endTime - indexed(m_events.timestamps, checkOutRow);
+        if (countDurations && endRow != NoId)
+        {
+            m_sessionDurations.add(indexed(m_events.products, checkOutRow), current.duration);
+        }
+        if (rankSessions)
+        {
+            RankedSession ranked = { indexed(m_events.products, checkOutRow), indexed(m_events.users, checkOutRow),
+                                     indexed(m_events.hosts, checkOutRow), indexed(m_events.timestamps, checkOutRow),
+                                     (endRow != NoId) ? endTime : LLONG_MIN, current.duration };
+            (endRow != NoId ? m_longestClosedSessions : openSessions).add(ranked);
+        }
+        if (versionSessions)
+        {
+            m_versionUsage.addSession(indexed(m_events.products, checkOutRow), indexed(m_events.versions, checkOutRow),
+                                      current.duration, endRow != NoId);
+        }
+        if (flagForgotten)
+        {
+            m_forgottenSessions.add(indexed(m_events.users, checkOutRow), indexed(m_events.products, checkOutRow),
+                                    indexed(m_events.timestamps, checkOutRow), current.duration, endRow != NoId);
+        }
+        if (profileDemand)
+        {
+            m_demandProfile.addSession(indexed(m_events.products, checkOutRow), indexed(m_events.timestamps, checkOutRow),
+                                       endTime, endRow != NoId);
+        }
+        if (billSessions)
+        {
+            ChargebackTotals& billed = m_chargeback[chargebackGroup(checkOutRow) * m_uniqueProducts.size() +
+                                                    indexed(m_events.products, checkOutRow)];
+            ++billed.sessions;
+            billed.seconds += current.duration;
+            billed.reservedSeconds += reserved ? current.duration : 0;
+            if (endRow != NoId)
+            {
+                ++billed.closedSessions;
+                billed.closedSeconds += current.duration;
+                billed.closedReservedSeconds += reserved ? current.duration : 0;
+            }
+        }
+        if (splitReserved)
+        {
+            CheckpointEntry duration = { indexed(m_events.users, checkOutRow), indexed(m_events.products, checkOutRow),
+                                         current.duration };
+            (reserved ? reservedDurations : floatingDurations).push_back(duration);
+        }
+    }
+    if (splitReserved)
+    {
+        m_reservedDurationu.assign(m_uniqueUsers.size(), m_uniqueProducts.size(), reservedDurations);
+        m_floatingDurationu.assign(m_uniqueUsers.size(), m_uniqueProducts.size(), floatingDurations);
+    }
+
+    // The sessions still checked out are ranked anew by every run, as they
+    // only grow longer
+    if (rankSessions)
+    {
+        m_longestSessions = m_longestClosedSessions;
+        m_longestSessions.add(openSessions);
+    }
+}
+
+// The time the sessions, saturation intervals and sustained peaks still
+// open run until: m_endTimeRow, or the later last event the filter left out
+long long LogData::endTime() const
+{
+    if (m_events.size() == 0)
+    {
+        return m_filteredEndTime;
+    }
+    return max(m_events.timestamps.at(m_endTimeRow), m_filteredEndTime);
+}
+
+bool LogData::catalogEntry(CatalogEntry& entry) const
+{
+    if (m_described)
+    {
+        entry = m_catalogEntry;
+    }
+    return m_described;
+}
+
+// License activity: one row per session.  An incremental analysis lists the
+// sessions in check-in order with the ones still checked out last, so the
+// next run can cut those off and append from there.
+void LogData::writeUsageDuration(const string& outputFilePath)
+{
+    auto writeHeader = [](BufferedWriter& out)
+    {
+        out.write("Checkout Date/Time,Checkin Date/Time,Product,Version,User,Host,Duration (HH:MM:SS)\n");
+    };
+
+    vector<size_t> order(m_sessions.size());
+    for (size_t session = 0; session < order.size(); ++session)
+    {
+        order[session] = session;
+    }
+    size_t closedSessions = order.size();
+    if (m_incremental)
+    {
+        // NoId sorts the open sessions last
+        stable_sort(order.begin(), order.end(), [this](size_t first, size_t second)
+        {
+            return m_sessions[first].checkInRow < m_sessions[second].checkInRow;
+        });
+        while (closedSessions > 0 && m_sessions[order[closedSessions - 1]].checkInRow == NoId)
+        {
+            --closedSessions;
+        }
+    }
+
+    // A resumed run cuts the report off before the sessions still open
+    auto writeSessions = [this, &order](BufferedWriter& rangeOut, size_t firstPosition, size_t endPosition)
+    {
+        for (size_t position = firstPosition; position < endPosition; ++position)
+        {
+            size_t session = order[position];
+            size_t row = m_sessions[session].checkOutRow;
+            size_t checkInRow = m_sessions[session].checkInRow;
+
+            rangeOut.writeLogDateTime(m_events.timestamps[row]);
+            rangeOut.write(',');
+            if (checkInRow != NoId)
+            {
+                rangeOut.writeLogDateTime(m_events.timestamps[checkInRow]);
+            }
+            else
+            {
+                rangeOut.write("(Still checked out)");
+            }
+            rangeOut.write(',');
+            rangeOut.write(m_uniqueProducts.name(m_events.products[row]));
+            rangeOut.write(',');
+            rangeOut.write(m_uniqueVersions.name(m_events.versions[row]));
+            rangeOut.write(',');
+            rangeOut.write(m_uniqueUsers.name(m_events.users[row]));
+            rangeOut.write(',');
+            rangeOut.write(m_uniqueHosts.name(m_events.hosts[row]));
+            rangeOut.write(',');
+            rangeOut.writeDuration(m_sessions[session].duration);
+            rangeOut.write('\n');
+        }
+    };
+
+    // Partitioned, a session goes to the period it was checked out in
+    if (partitionsReports())
+    {
+        writePartitions(outputFilePath, 0, order.size(), [this, &order](size_t position)
+        {
+            return m_events.timestamps[m_sessions[order[position]].checkOutRow];
+        }, writeHeader, writeSessions);
+        return;
+    }
+
+    BufferedWriter out(outputFilePath, m_resumed, m_reportCompression);
+    if (! m_resumed)
+    {
+        writeHeader(out);
+    }
+    writeRowRanges(out, 0, closedSessions, writeSessions);
+    if (m_incremental)
+    {
+        m_activityLength = out.position();
+    }
+    writeRowRanges(out, closedSessions, order.size(), writeSessions);
+    out.close();
+}
+
+// Total duration by host and by user for each product (Imaris module),
+// reduced from the session table and the sessions closed before the
+// checkpoint
+// Resolves the users and hosts interned since the last session pass to
+// their groups, so that billing a session takes no lookup of its names
+void LogData::resolveGroups()
+{
+    for (size_t user = m_userGroups.size(); user < m_uniqueUsers.size(); ++user)
+    {
+        m_userGroups.push_back(m_groupMapping->userGroup(m_uniqueUsers.name(user)));
+    }
+    for (size_t host = m_hostGroups.size(); host < m_uniqueHosts.size(); ++host)
+    {
+        m_hostGroups.push_back(m_groupMapping->hostGroup(m_uniqueHosts.name(host)));
+    }
+}
+
+// Lays the chargeback table out for the groups and products and starts it
+// from the closed sessions of the checkpoint
+void LogData::startChargeback()
+{
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    m_chargeback.assign((m_groupMapping->groups() + 1) * numberOfProducts, ChargebackTotals());
+    for (size_t entry = 0; entry < m_checkpoint.chargebackSeconds.size(); ++entry)
+    {
+        const CheckpointEntry& seconds = m_checkpoint.chargebackSeconds[entry];
+        ChargebackTotals& billed = m_chargeback.at(seconds.row * numberOfProducts + seconds.product);
+        billed.sessions = billed.closedSessions = m_checkpoint.chargebackSessions.at(entry);
+        billed.seconds = billed.closedSeconds = seconds.value;
+        billed.reservedSeconds = billed.closedReservedSeconds = m_checkpoint.chargebackReservedSeconds.at(entry);
+    }
+}
+
+// The group a session is billed to: its user's, else its host's, else the
+// unassigned row after the groups
+size_t LogData::chargebackGroup(size_t checkOutRow) const
+{
+    size_t group = indexed(m_userGroups, indexed(m_events.users, checkOutRow));
+    if (group == GroupMapping::NoGroup)
+    {
+        group = indexed(m_hostGroups, indexed(m_events.hosts, checkOutRow));
+    }
+    return (group != GroupMapping::NoGroup) ? group : m_groupMapping->groups();
+}
+
+// Whether the session checked out at checkOutRow took a reserved license.
+// The sessions are asked in check-out order, with nextReserved the first of
+// the reserved check-outs not passed yet.
+bool LogData::reservedCheckOut(size_t checkOutRow, size_t& nextReserved) const
+{
+    while (nextReserved < m_reservedCheckOuts.size() && m_reservedCheckOuts[nextReserved] < checkOutRow)
+    {
+        ++nextReserved;
+    }
+    return nextReserved < m_reservedCheckOuts.size() && m_reservedCheckOuts[nextReserved] == checkOutRow;
+}
+
+void LogData::getTotalDurations()
+{
+    vector<CheckpointEntry> durations;
+    if (reportSelected(TotalDurationHostsReport))
+    {
+        collectDurations(m_checkpoint.hostDurations, m_events.hosts, false, durations);
+        m_totalDurationh.assign(m_uniqueHosts.size(), m_uniqueProducts.size(), durations);
+    }
+    if (reportSelected(TotalDurationUsersReport | TopUsageReport))
+    {
+        collectDurations(m_checkpoint.userDurations, m_events.users, false, durations);
+        m_totalDurationu.assign(m_uniqueUsers.size(), m_uniqueProducts.size(), durations);
+    }
+}
+
+// Lists the checkpoint's durations and those of the sessions, by the host
+// or user column given, as entries of a SparseTotals; only the closed
+// sessions with closedOnly
+void LogData::collectDurations(const vector<CheckpointEntry>& checkpointDurations,
+                               const vector<size_t>& rowColumn,
+                               bool closedOnly,
+                               vector<CheckpointEntry>& durations) const
+{
+    durations.assign(checkpointDurations.begin(), checkpointDurations.end());
+    durations.reserve(durations.size() + m_sessions.size());
+    for (size_t session = 0; session < m_sessions.size(); ++session)
+    {
+        if (closedOnly && m_sessions[session].checkInRow == NoId)
+        {
+            continue;
+        }
+        size_t row = m_sessions[session].checkOutRow;
+        CheckpointEntry duration = { indexed(rowColumn, row), indexed(m_events.products, row), m_sessions[session].duration };
+        durations.push_back(duration);
+    }
+}
+
+// Denied License Requests
+void LogData::writeDeniedRequests(const string& outputFilePath)
+{
+    auto writeHeader = [this](BufferedWriter& out)
+    {
+        out.write("Request,Product,Version,User,Host,Reason");
+        if (m_denialUsage)
+        {
+            out.write(",Floating Licenses in use,Floating Licenses Limit,Reserved Licenses in use,Reserved Licenses Limit");
+        }
+        // Coalesced denials tell how many requests they stand for
+        out.write(m_denialWindow > 0 ? ",Requests,Last Request\n" : "\n");
+    };
+
+    writeTimeOrdered(outputFilePath, 0, m_denialRows.size(), [this](size_t denial)
+    {
+        return m_events.timestamps[m_denialRows[denial]];
+    }, writeHeader, [this](BufferedWriter& out, size_t firstDenial, size_t endDenial)
+    {
+        for (size_t denial = firstDenial; denial < endDenial; ++denial)
+        {
+            size_t row = m_denialRows[denial];
+
+            out.writeLogDateTime(m_events.timestamps[row]);
+            out.write(',');
+            out.write(m_uniqueProducts.name(m_events.products[row]));
+            out.write(',');
+            out.write(m_uniqueVersions.name(m_events.versions[row]));
+            out.write(',');
+            out.write(m_uniqueUsers.name(m_events.users[row]));
+            out.write(',');
+            out.write(m_uniqueHosts.name(m_events.hosts[row]));
+            out.write(',');
+            out.writeInteger(m_events.counts[row]);
+            if (m_denialUsage)
+            {
+                const UsageCounters& counters = m_denialCounters.at(denial);
+
+                out.write(',');
+                out.writeInteger(counters.floatingInUse);
+                out.write(',');
+                out.writeInteger(counters.floatingLimit);
+                out.write(',');
+                out.writeInteger(counters.reservedInUse);
+                out.write(',');
+                out.writeInteger(counters.reservedLimit);
+            }
+            if (m_denialWindow > 0)
+            {
+                out.write(',');
+                out.writeInteger(static_cast<long long>(m_denialRepeats.at(denial)));
+                out.write(',');
+                out.writeLogDateTime(m_denialLastTimes.at(denial));
+            }
+            out.write('\n');
+        }
+    });
+}
+
+// Denials by hour: for every hour of the log and product with denials, how
+// many there were and how many came while the product was at its limit.
+// Those that did not are the ones a license count does not explain.
+void LogData::writeHourlyDenials(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Hour,Product,Denials,Denials at the Limit\n");
+    for (const auto& hour : m_hourlyDenials)
+    {
+        out.writeLogDateTime(hour.first.first);
+        out.write(',');
+        out.write(m_uniqueProducts.name(hour.first.second));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(hour.second.denials));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(hour.second.atLimit));
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Data Summary (TXT File) for quick evaluation
+void LogData::writeSummaryData(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Log Data Summary For:\n");
+    out.write(m_inputFilePath);
+    out.write("\n\n");
+    out.write("Server Name: ");
+    out.write(m_serverName);
+    out.write("\n\n");
+
+    size_t numberOfStarts = m_startRows.size();
+    out.write("Server Start(s): (");
+    out.writeInteger(numberOfStarts);
+    out.write(" Total)\n");
+    for (size_t start = 0; start < numberOfStarts; ++start)
+    {
+        size_t row = m_startRows.at(start);
+        out.writeLogDateTime(m_events.timestamps.at(row));
+        out.write(' ');
+        out.write(m_uniqueServers.name(m_events.hosts.at(row)));
+        out.write(" \n");
+    }
+    out.write('\n');
+
+    size_t numberOfShutdowns = m_shutdownRows.size();
+    out.write("Server Shutdown(s): (");
+    out.writeInteger(numberOfShutdowns);
+    out.write(" Total)\n");
+    for (size_t shutdown = 0; shutdown < numberOfShutdowns; ++shutdown)
+    {
+        size_t row = m_shutdownRows.at(shutdown);
+        out.writeLogDateTime(m_events.timestamps.at(row));
+        out.write(" \n");
+    }
+    out.write('\n');
+
+    size_t numberOfProducts = m_uniqueProducts.size();
+    out.write("Product(s): (");
+    out.writeInteger(numberOfProducts);
+    out.write(" Total)\n");
+    for (size_t row = 0; row < numberOfProducts; ++row)
+    {
+        out.write(m_uniqueProducts.name(row));
+        out.write('\n');
+    }
+    out.write('\n');
+
+    size_t numberOfUsers = m_uniqueUsers.size();
+    out.write("Users(s): (");
+    out.writeInteger(numberOfUsers);
+    out.write(" Total)\n");
+    for (size_t row = 0; row < numberOfUsers; ++row)
+    {
+        out.write(m_uniqueUsers.name(row));
+        out.write('\n');
+    }
+    out.write('\n');
+
+    size_t numberOfHosts = m_uniqueHosts.size();
+    out.write("Host(s): (");
+    out.writeInteger(numberOfHosts);
+    out.write(" Total)\n");
+    for (size_t row = 0; row < numberOfHosts; ++row)
+    {
+        out.write(m_uniqueHosts.name(row));
+        out.write('\n');
+    }
+    out.write('\n');
+
+    // The saturation totals come only with the saturation report, so that
+    // the summary does not change with the reports analyzed; they count
+    // the intervals still open up to the end
+    if (m_fileFormat == ReportLog && reportWritten(LicenseSaturationReport))
+    {
+        out.write("License Saturation:\n");
+        for (size_t product = 0; product < m_licenseSaturation.products(); ++product)
+        {
+            uint64_t intervals = m_licenseSaturation.closedCount(product);
+            long long seconds = m_licenseSaturation.closedSeconds(product);
+            long long start = m_licenseSaturation.openSince(product);
+            if (start != LLONG_MIN)
+            {
+                ++intervals;
+                seconds += max(endTime() - start, 0LL);
+            }
+            out.write(m_uniqueProducts.name(product));
+            out.write(": ");
+            out.writeInteger(static_cast<long long>(intervals));
+            out.write(" time(s) at the limit, ");
+            out.writeDuration(seconds);
+            out.write(" in all\n");
+        }
+        out.write('\n');
+    }
+
+    // Only a lenient parse skips lines, and only then are they listed
+    size_t numberOfInvalidLines = m_invalidLines.size();
+    if (numberOfInvalidLines > 0)
+    {
+        out.write("Skipped Invalid Line(s): (");
+        out.writeInteger(numberOfInvalidLines);
+        out.write(" Total)\n");
+        for (size_t invalid = 0; invalid < numberOfInvalidLines; ++invalid)
+        {
+            out.write("Line ");
+            out.writeInteger(m_invalidLines.at(invalid).line);
+            out.write(m_invalidLines.at(invalid).reason == MissingFields ? ": missing data\n" : ": invalid date or time\n");
+        }
+        out.write('\n');
+    }
+
+    if (m_reorderWindow > 0)
+    {
+        out.write("Late Event(s): (");
+        out.writeInteger(m_reorderBuffer.lateEvents());
+        out.write(" Total, ");
+        out.writeInteger(m_reorderBuffer.unorderedEvents());
+        out.write(" more than ");
+        out.writeInteger(m_reorderWindow);
+        out.write(" seconds late and left out of order)\n\n");
+    }
+
+    // Removed Denied Events from Summary since Imaris generates a lot of denied license requests in LIC setting
+    out.close();
+}
+
+void LogData::writeTotalDurationHosts(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Host,");
+    size_t columnSize = m_uniqueProducts.size();
+    for (size_t col = 0; col < columnSize; ++col)
+    {
+        out.write(m_uniqueProducts.name(col));
+        out.write(" Duration (HH:MM:SS)");
+        if (col != columnSize - 1)
+        {
+            out.write(',');
+        }
+    }
+    out.write('\n');
+
+    vector<long long> rowDurations;
+    for (size_t row = 0; row < m_uniqueHosts.size(); ++row)
+    {
+        out.write(m_uniqueHosts.name(row));
+        out.write(',');
+        m_totalDurationh.rowValues(row, rowDurations);
+        rowDurations.resize(columnSize, 0);
+        for (size_t col = 0; col < columnSize; ++col)
+        {
+            out.writeDuration(rowDurations[col]);
+            if (col != columnSize - 1)
+            {
+                out.write(',');
+            }
+        }
+        out.write('\n');
+    }
+    out.close();
+}
+
+void LogData::writeTotalDurationUsers(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("User,");
+    size_t columnSize = m_uniqueProducts.size();
+    for (size_t col = 0; col < columnSize; ++col)
+    {
+        out.write(m_uniqueProducts.name(col));
+        out.write(" Duration (HH:MM:SS)");
+        if (col != columnSize - 1)
+        {
+            out.write(',');
+        }
+    }
+    out.write('\n');
+
+    vector<long long> rowDurations;
+    for (size_t row = 0; row < m_uniqueUsers.size(); ++row)
+    {
+        out.write(m_uniqueUsers.name(row));
+        out.write(',');
+        m_totalDurationu.rowValues(row, rowDurations);
+        rowDurations.resize(columnSize, 0);
+        for (size_t col = 0; col < columnSize; ++col)
+        {
+            out.writeDuration(rowDurations[col]);
+            if (col != columnSize - 1)
+            {
+                out.write(',');
+            }
+        }
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Session durations: the count and the median, 90th and 99th percentile
+// and longest length of the closed sessions of every product.  Sessions
+// still checked out are left out, as their length is not known yet.
+void LogData::writeSessionDurations(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Product,Sessions,Median (HH:MM:SS),90th Percentile (HH:MM:SS),99th Percentile (HH:MM:SS),Longest (HH:MM:SS)\n");
+    const double percents[] = { 50.0, 90.0, 99.0 };
+    for (size_t product = 0; product < m_uniqueProducts.size(); ++product)
+    {
+        bool counted = product < m_sessionDurations.products();
+        out.write(m_uniqueProducts.name(product));
+        out.write(',');
+        out.writeInteger(counted ? static_cast<long long>(m_sessionDurations.sessions(product)) : 0);
+        for (size_t percent = 0; percent < 3; ++percent)
+        {
+            out.write(',');
+            out.writeDuration(counted ? m_sessionDurations.percentile(product, percents[percent]) : 0);
+        }
+        out.write(',');
+        out.writeDuration(counted ? m_sessionDurations.longest(product) : 0);
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Usage heatmap: for every product and hour of the week, the time-weighted
+// mean and the most floating licenses in use at once, and how long the log
+// covered that hour over all its weeks
+void LogData::writeUsageHeatmap(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Product,Weekday,Hour,Mean Floating Licenses in use,Max Floating Licenses in use,Observed (HH:MM:SS)\n");
+    const char* weekdays[] = { "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday" };
+    for (size_t product = 0; product < m_uniqueProducts.size() && product < m_usageHeatmap.products(); ++product)
+    {
+        for (size_t cell = 0; cell < UsageHeatmap::Cells; ++cell)
+        {
+            out.write(m_uniqueProducts.name(product));
+            out.write(',');
+            out.write(weekdays[cell / UsageHeatmap::Hours]);
+            out.write(',');
+            out.writeInteger(static_cast<long long>(cell % UsageHeatmap::Hours));
+            out.write(',');
+            out.writeFixed(m_usageHeatmap.mean(product, cell), 2);
+            out.write(',');
+            out.writeInteger(m_usageHeatmap.peak(product, cell));
+            out.write(',');
+            out.writeDuration(m_usageHeatmap.observedSeconds(cell));
+            out.write('\n');
+        }
+    }
+    out.close();
+}
+
+// License saturation: one row per time a product sat at its limit.  The
+// intervals closed are listed as they closed, those still open last, so an
+// incremental analysis can cut those off and append from there.
+void LogData::writeLicenseSaturation(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, m_resumed, m_reportCompression);
+
+    if (! m_resumed)
+    {
+        out.write("Start Date/Time,End Date/Time,Product,Duration (HH:MM:SS)\n");
+    }
+
+    const vector<SaturationInterval>& intervals = m_licenseSaturation.closedIntervals();
+    for (size_t interval = 0; interval < intervals.size(); ++interval)
+    {
+        out.writeLogDateTime(intervals[interval].start);
+        out.write(',');
+        out.writeLogDateTime(intervals[interval].end);
+        out.write(',');
+        out.write(m_uniqueProducts.name(intervals[interval].product));
+        out.write(',');
+        out.writeDuration(intervals[interval].end - intervals[interval].start);
+        out.write('\n');
+    }
+    m_saturationLength = out.position();
+
+    for (size_t product = 0; product < m_licenseSaturation.products(); ++product)
+    {
+        long long start = m_licenseSaturation.openSince(product);
+        if (start == LLONG_MIN)
+        {
+            continue;
+        }
+        out.writeLogDateTime(start);
+        out.write(",(Still at the limit),");
+        out.write(m_uniqueProducts.name(product));
+        out.write(',');
+        out.writeDuration(max(endTime() - start, 0LL));
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Sustained peaks: for every product and window length, the most floating
+// licenses in use throughout a window and the highest time-weighted mean
+// over a window, with the start of the first such window.  The usage up to
+// the end of the log counts; a log shorter than the window has none.
+void LogData::writeSustainedPeaks(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Product,Window (Minutes),Peak Held,Held From,Peak Average,Average From\n");
+    long long end = endTime();
+    for (size_t product = 0; product < m_uniqueProducts.size() && product < m_sustainedPeaks.products(); ++product)
+    {
+        for (size_t window = 0; window < SustainedPeaks::Windows; ++window)
+        {
+            SustainedPeak peak = m_sustainedPeaks.peak(product, window, end);
+            out.write(m_uniqueProducts.name(product));
+            out.write(',');
+            out.writeInteger(SustainedPeaks::WindowMinutes[window]);
+            out.write(',');
+            out.writeInteger(peak.held);
+            out.write(',');
+            if (peak.heldFrom != LLONG_MIN)
+            {
+                out.writeLogDateTime(peak.heldFrom);
+            }
+            out.write(',');
+            out.writeFixed(peak.average, 2);
+            out.write(',');
+            if (peak.averageFrom != LLONG_MIN)
+            {
+                out.writeLogDateTime(peak.averageFrom);
+            }
+            out.write('\n');
+        }
+    }
+    out.close();
+}
+
+// Top usage, for license audits: the longest sessions of every product,
+// those still checked out included, and the users with the most time on it
+// over all their sessions.  Both are selected without sorting the sessions
+// or the users x products totals.
+void LogData::writeTopUsage(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Product,Rank,Ranking,User,Host,Checkout Date/Time,Checkin Date/Time,Duration (HH:MM:SS)\n");
+    vector<CheckpointEntry> heaviestUsers;
+    m_totalDurationu.largestRows(LongestSessions::Count, heaviestUsers);
+    size_t userEntry = 0;
+    vector<RankedSession> sessions;
+    for (size_t product = 0; product < m_uniqueProducts.size(); ++product)
+    {
+        if (product < m_longestSessions.products())
+        {
+            m_longestSessions.sessions(product, sessions);
+        }
+        else
+        {
+            sessions.clear();
+        }
+        for (size_t rank = 0; rank < sessions.size(); ++rank)
+        {
+            out.write(m_uniqueProducts.name(product));
+            out.write(',');
+            out.writeInteger(static_cast<long long>(rank + 1));
+            out.write(",Longest Session,");
+            out.write(m_uniqueUsers.name(sessions[rank].user));
+            out.write(',');
+            out.write(m_uniqueHosts.name(sessions[rank].host));
+            out.write(',');
+            out.writeLogDateTime(sessions[rank].checkOut);
+            out.write(',');
+            if (sessions[rank].checkIn != LLONG_MIN)
+            {
+                out.writeLogDateTime(sessions[rank].checkIn);
+            }
+            else
+            {
+                out.write("(Still checked out)");
+            }
+            out.write(',');
+            out.writeDuration(sessions[rank].duration);
+            out.write('\n');
+        }
+
+        for (size_t rank = 1; userEntry < heaviestUsers.size() && heaviestUsers[userEntry].product == product; ++rank, ++userEntry)
+        {
+            out.write(m_uniqueProducts.name(product));
+            out.write(',');
+            out.writeInteger(static_cast<long long>(rank));
+            out.write(",Heaviest User,");
+            out.write(m_uniqueUsers.name(heaviestUsers[userEntry].row));
+            out.write(",,,,");
+            out.writeDuration(heaviestUsers[userEntry].value);
+            out.write('\n');
+        }
+    }
+    out.close();
+}
+
+// Version usage, for planning upgrades: the check-outs of every version of
+// a product in use at once at most and when, and its sessions and their
+// time, those still checked out included
+void LogData::writeVersionUsage(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Product,Version,Peak Checkouts,Peak Date/Time,Sessions,Total Duration (HH:MM:SS)\n");
+    vector<VersionTotals> versions;
+    m_versionUsage.totals(versions);
+    for (const VersionTotals& totals : versions)
+    {
+        out.write(m_uniqueProducts.name(totals.product));
+        out.write(',');
+        out.write(m_uniqueVersions.name(totals.version));
+        out.write(',');
+        out.writeInteger(totals.peak);
+        out.write(',');
+        if (totals.peakTime != LLONG_MIN)
+        {
+            out.writeLogDateTime(totals.peakTime);
+        }
+        out.write(',');
+        out.writeInteger(static_cast<long long>(totals.sessions));
+        out.write(',');
+        out.writeDuration(totals.seconds);
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Chargeback, for billing license time to research groups: the sessions of
+// every product billed to each group of the mapping and their time, those
+// still checked out included, split into reserved and floating licenses
+void LogData::writeChargeback(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Group,Product,Sessions,Total Duration (HH:MM:SS),Reserved Duration (HH:MM:SS),Floating Duration (HH:MM:SS)\n");
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    for (size_t index = 0; index < m_chargeback.size(); ++index)
+    {
+        const ChargebackTotals& billed = m_chargeback[index];
+        if (billed.sessions == 0)
+        {
+            continue;
+        }
+        size_t group = index / numberOfProducts;
+        string_view name = (group < m_groupMapping->groups()) ? string_view(m_groupMapping->group(group)) : "(Unassigned)";
+        if (name.find(',') != string_view::npos)
+        {
+            out.write('"');
+            out.write(name);
+            out.write('"');
+        }
+        else
+        {
+            out.write(name);
+        }
+        out.write(',');
+        out.write(m_uniqueProducts.name(index % numberOfProducts));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(billed.sessions));
+        out.write(',');
+        out.writeDuration(billed.seconds);
+        out.write(',');
+        out.writeDuration(billed.reservedSeconds);
+        out.write(',');
+        out.writeDuration(billed.seconds - billed.reservedSeconds);
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Reserved usage: for every user and product with sessions, the reserved
+// licenses the user holds at the end of the log and the time on reserved
+// and on floating licenses, those still checked out included
+void LogData::writeReservedUsage(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("User,Product,Reserved Licenses Held,Reserved Duration (HH:MM:SS),Floating Duration (HH:MM:SS)\n");
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    vector<long long> held;
+    vector<long long> reserved;
+    vector<long long> floating;
+    for (size_t user = 0; user < m_uniqueUsers.size(); ++user)
+    {
+        m_reservedHoldings.rowValues(user, held);
+        m_reservedDurationu.rowValues(user, reserved);
+        m_floatingDurationu.rowValues(user, floating);
+        held.resize(numberOfProducts, 0);
+        reserved.resize(numberOfProducts, 0);
+        floating.resize(numberOfProducts, 0);
+        for (size_t product = 0; product < numberOfProducts; ++product)
+        {
+            if (held[product] == 0 && reserved[product] == 0 && floating[product] == 0)
+            {
+                continue;
+            }
+            out.write(m_uniqueUsers.name(user));
+            out.write(',');
+            out.write(m_uniqueProducts.name(product));
+            out.write(',');
+            out.writeInteger(held[product]);
+            out.write(',');
+            out.writeDuration(reserved[product]);
+            out.write(',');
+            out.writeDuration(floating[product]);
+            out.write('\n');
+        }
+    }
+    out.close();
+}
+
+// Forgotten sessions: for every user and product with flagged sessions,
+// those held through the off-hours, those held longer than the policy
+// allows, those of them still checked out and the time they wasted
+void LogData::writeForgottenSessions(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("User,Product,Flagged Sessions,Off-Hours Sessions,Long Sessions,Still Checked Out,Wasted Duration (HH:MM:SS)\n");
+    vector<ForgottenTotals> totals;
+    m_forgottenSessions.totals(totals);
+    for (const ForgottenTotals& flagged : totals)
+    {
+        out.write(m_uniqueUsers.name(flagged.user));
+        out.write(',');
+        out.write(m_uniqueProducts.name(flagged.product));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(flagged.sessions));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(flagged.offHoursSessions));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(flagged.longSessions));
+        out.write(',');
+        out.writeInteger(static_cast<long long>(flagged.openSessions));
+        out.write(',');
+        out.writeDuration(flagged.wastedSeconds);
+        out.write('\n');
+    }
+    out.close();
+}
+
+// Demand profile: for every product and hour of the week, the hours of it
+// the log covers, the check-outs, check-ins and denied requests and the
+// rates of the check-outs and denials per hour, and the holding times of
+// the closed sessions checked out in it.  Its size depends on the products
+// alone, so it is a compact input for demand forecasts.
+void LogData::writeDemandProfile(const string& outputFilePath)
+{
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+
+    out.write("Product,Weekday,Hour,Observed Hours,Check-outs,Check-outs per Hour,Check-ins,Denied Requests,"
+              "Denials per Hour,Closed Sessions,Mean Holding (s),Holding Std Dev (s),"
+              "Holding <1m,1-5m,5-15m,15-30m,30m-1h,1-2h,2-4h,4-8h,8-24h,>=24h\n");
+    const char* weekdays[] = { "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday" };
+    const long long firstTime = m_eventTotals.firstTime();
+    const long long lastTime = endTime();
+    for (size_t product = 0; product < m_uniqueProducts.size() && product < m_demandProfile.products(); ++product)
+    {
+        for (size_t cell = 0; cell < DemandProfile::Cells; ++cell)
+        {
+            uint64_t hours = (firstTime == LLONG_MAX) ? 0 : DemandProfile::observedHours(cell, firstTime, lastTime);
+            double perHour = (hours > 0) ? 1.0 / static_cast<double>(hours) : 0.0;
+            out.write(m_uniqueProducts.name(product));
+            out.write(',');
+            out.write(weekdays[cell / UsageHeatmap::Hours]);
+            out.write(',');
+            out.writeInteger(static_cast<long long>(cell % UsageHeatmap::Hours));
+            out.write(',');
+            out.writeInteger(static_cast<long long>(hours));
+            out.write(',');
+            out.writeInteger(static_cast<long long>(m_demandProfile.checkOuts(product, cell)));
+            out.write(',');
+            out.writeFixed(static_cast<double>(m_demandProfile.checkOuts(product, cell)) * perHour, 4);
+            out.write(',');
+            out.writeInteger(static_cast<long long>(m_demandProfile.checkIns(product, cell)));
+            out.write(',');
+            out.writeInteger(static_cast<long long>(m_demandProfile.denials(product, cell)));
+            out.write(',');
+            out.writeFixed(static_cast<double>(m_demandProfile.denials(product, cell)) * perHour, 4);
+            out.write(',');
+            out.writeInteger(static_cast<long long>(m_demandProfile.closedSessions(product, cell)));
+            out.write(',');
+            out.writeFixed(m_demandProfile.meanHolding(product, cell), 1);
+            out.write(',');
+            out.writeFixed(m_demandProfile.holdingDeviation(product, cell), 1);
+            for (size_t bucket = 0; bucket < DemandProfile::HoldingBuckets; ++bucket)
+            {
+                out.write(',');
+                out.writeInteger(static_cast<long long>(m_demandProfile.holdingCount(product, cell, bucket)));
+            }
+            out.write('\n');
+        }
+    }
+    out.close();
+}
+
+void LogData::setOutputPaths()
+{
+    string suffix = compressionSuffix(m_reportCompression);
+    m_checkpointPath = m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Checkpoint.dat";
+    m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_License_Summary.txt" + suffix);
+    m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Processed_Log_File.txt" + suffix);
+    m_outputPaths.push_back(concurrentUsagePath());
+    if (m_fileFormat == ReportLog)
+    {
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_License_Activity.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Total_Duration_Hosts.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Total_Duration_Users.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Denied_License_Requests.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Session_Durations.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Usage_Heatmap.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_License_Saturation.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Denied_License_Requests_Hourly.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Sustained_Peaks.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Top_Usage.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Version_Usage.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Reserved_Usage.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Forgotten_Sessions.csv" + suffix);
+        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Demand_Profile.csv" + suffix);
+        if (m_groupMapping != NULL)
+        {
+            m_outputPaths.push_back(chargebackPath());
+        }
+    }
+}
+
+string LogData::concurrentUsagePath()
+{
+    if (m_usageFormat == LongUsage)
+    {
+        return m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Concurrent_License_Usage_Long.csv" + compressionSuffix(m_reportCompression);
+    }
+    return m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Concurrent_License_Usage.csv" + compressionSuffix(m_reportCompression);
+}
+
+void LogData::setReportDestination(const string& destination)
+{
+    m_reportDestination = destination;
+}
+
+void LogData::setWrittenReports(unsigned int reports)
+{
+    m_writtenReports = reports & AllReports;
+}
+
+void LogData::setDenialUsage(bool denialUsage)
+{
+    m_denialUsage = m_incremental ? false : denialUsage;
+}
+
+void LogData::setReportCompression(compressionFormat compression)
+{
+    m_reportCompression = m_incremental ? Uncompressed : compression;
+    m_outputPaths.clear();
+    setOutputPaths();
+}
+
+void LogData::setConcurrentUsageFormat(usageFormat format)
+{
+    m_usageFormat = format;
+    m_outputPaths.at(2) = concurrentUsagePath();
+}
+
+string LogData::chargebackPath()
+{
+    return m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Chargeback.csv" + compressionSuffix(m_reportCompression);
+}
+
+string LogData::usageBucketsPath()
+{
+    return m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Concurrent_License_Usage_Buckets.csv" +
+        compressionSuffix(m_reportCompression);
+}
+
+// The Arrow exports of the events, the sessions and the concurrency timeline
+vector<string> LogData::arrowPaths()
+{
+    vector<string> paths;
+    paths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Events.arrow");
+    paths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Sessions.arrow");
+    paths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Concurrent_License_Usage.arrow");
+    return paths;
+}
+
+// Adds the Arrow exports to the outputs, or removes them
+void LogData::setArrowExport(bool arrowExport)
+{
+    vector<string> paths = arrowPaths();
+    for (size_t path = 0; path < paths.size(); ++path)
+    {
+        vector<string>::iterator found = find(m_outputPaths.begin(), m_outputPaths.end(), paths.at(path));
+        if (found != m_outputPaths.end())
+        {
+            m_outputPaths.erase(found);
+        }
+    }
+
+    m_arrowExport = arrowExport && m_fileFormat == ReportLog;
+    if (m_arrowExport)
+    {
+        m_outputPaths.insert(m_outputPaths.end(), paths.begin(), paths.end());
+    }
+}
+
+// The SQLite export of the events, the sessions, the denials and the
+// concurrency timeline
+string LogData::sqlitePath()
+{
+    return m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris.sqlite";
+}
+
+// Adds the SQLite export to the outputs, or removes it
+void LogData::setSqliteExport(bool sqliteExport)
+{
+    string databasePath = sqlitePath();
+    vector<string>::iterator found = find(m_outputPaths.begin(), m_outputPaths.end(), databasePath);
+    if (found != m_outputPaths.end())
+    {
+        m_outputPaths.erase(found);
+    }
+
+    m_sqliteExport = sqliteExport && m_fileFormat == ReportLog;
+    if (m_sqliteExport)
+    {
+        m_outputPaths.push_back(databasePath);
+    }
+}
+
+// The JSON Lines exports of the events and the sessions, compressed like
+// the reports
+vector<string> LogData::jsonPaths()
+{
+    vector<string> paths;
+    paths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Events.jsonl" +
+                    compressionSuffix(m_reportCompression));
+    paths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Sessions.jsonl" +
+                    compressionSuffix(m_reportCompression));
+    return paths;
+}
+
+// Adds the JSON Lines exports to the outputs, or removes them
+void LogData::setJsonExport(bool jsonExport)
+{
+    vector<string> paths = jsonPaths();
+    for (size_t path = 0; path < paths.size(); ++path)
+    {
+        vector<string>::iterator found = find(m_outputPaths.begin(), m_outputPaths.end(), paths.at(path));
+        if (found != m_outputPaths.end())
+        {
+            m_outputPaths.erase(found);
+        }
+    }
+
+    m_jsonExport = jsonExport && m_fileFormat == ReportLog;
+    if (m_jsonExport)
+    {
+        m_outputPaths.insert(m_outputPaths.end(), paths.begin(), paths.end());
+    }
+}
+
+// Adds the bucketed concurrency report, or removes it for a width of 0
+void LogData::setUsageBucketWidth(long long bucketSeconds)
+{
+    string bucketPath = usageBucketsPath();
+    vector<string>::iterator found = find(m_outputPaths.begin(), m_outputPaths.end(), bucketPath);
+    if (found != m_outputPaths.end())
+    {
+        m_outputPaths.erase(found);
+    }
+
+    m_usageBucketSeconds = bucketSeconds;
+    if (m_usageBucketSeconds > 0 && m_fileFormat == ReportLog)
+    {
+        m_outputPaths.push_back(bucketPath);
+    }
+}
+
+void LogData::setOutputPartition(outputPartition partition)
+{
+    m_outputPartition = partition;
+}
+
+// Only the reports written can conflict, and none written to a stream.
+// The exports and buckets after the reports are checked whenever set.
+void LogData::checkForExistingFiles(string& conflictedFileList)
+{
+    if (! m_reportDestination.empty())
+    {
+        return;
+    }
+    for (size_t file=0; file < m_outputPaths.size(); ++file)
+    {
+        if (file <= 16 && ! reportWritten(1u << file))
+        {
+            continue;
+        }
+        if (fileExists(m_outputPaths.at(file)))
+        {
+            conflictedFileList.append(m_outputPaths.at(file));
+            conflictedFileList.append("\n");
+        }
+    }
+}
+
+void LogData::publishResults()
+{
+    publishReports(false);
+}
+
+void LogData::publishEventDataResults()
+{
+    publishReports(true, false);
+}
+
+void LogData::publishAllResults()
+{
+    publishReports(true);
+}
+
+void LogData::publishAllResults(ThreadPool& pool)
+{
+    publishReports(true, true, &pool);
+}
+
+// Writes the selected reports concurrently.  They only read the analysis
+// results, so each one runs as a task of its own.  Every report is
+// attempted; the files that could not be written are reported together in
+// one CannotOpenFileException once all of them have finished.  Without a
+// shared pool a pool is created for the call.  A shared pool may be the one
+// running the caller, as in a batch run.
+void LogData::publishReports(bool includeEventData, bool includeReports, ThreadPool* sharedPool)
+{
+    typedef void (LogData::*reportWriter)(const string&);
+    vector<reportWriter> writers;
+    vector<string> paths;
+
+    // Only what the analysis scope covered can be published, and a log
+    // data opened for queries has no reports at all
+    if (m_analysisScope == OutputPathsOnly || m_outputPaths.empty())
+    {
+        return;
+    }
+    includeReports = includeReports && m_analysisScope == FullAnalysis;
+    throwIfCancelled();
+    StageTimer publishing(m_stats, "publish reports");
+
+    // The reports of the last run are appended to only if they are still
+    // the ones its checkpoint describes; the parts written after the
+    // checkpoint, like the sessions that were still checked out, are cut off
+    if (m_resumed && ! canAppendReports())
+    {
+        resetAnalysis();
+        analyzeLog();
+    }
+    for (size_t report = 0; report < m_checkpoint.reportPaths.size() && m_resumed; ++report)
+    {
+        if (! truncateFile(m_checkpoint.reportPaths.at(report), m_checkpoint.reportLengths.at(report)))
+        {
+            CannotOpenFileException cannotOpenFileException(m_checkpoint.reportPaths.at(report));
+            throw cannotOpenFileException;
+        }
+    }
+
+    // The exports need every stage of the analysis, the buckets the
+    // concurrent usage
+    if (includeReports)
+    {
+        if (reportWritten(SummaryReport))
+        {
+            writers.push_back(&LogData::writeSummaryData);
+            paths.push_back(m_outputPaths.at(0));
+        }
+        if (reportWritten(ConcurrentUsageReport))
+        {
+            writers.push_back(m_usageFormat == LongUsage ? &LogData::writeConcurrentUsageLong : &LogData::writeConcurrentUsage);
+            paths.push_back(m_outputPaths.at(2));
+        }
+
+        if (m_fileFormat == ReportLog)
+        {
+            const reportWriter sessionWriters[] = { &LogData::writeUsageDuration,
+                                                    &LogData::writeTotalDurationHosts,
+                                                    &LogData::writeTotalDurationUsers,
+                                                    &LogData::writeDeniedRequests,
+                                                    &LogData::writeSessionDurations,
+                                                    &LogData::writeUsageHeatmap,
+                                                    &LogData::writeLicenseSaturation,
+                                                    &LogData::writeHourlyDenials,
+                                                    &LogData::writeSustainedPeaks,
+                                                    &LogData::writeTopUsage,
+                                                    &LogData::writeVersionUsage,
+                                                    &LogData::writeReservedUsage,
+                                                    &LogData::writeForgottenSessions,
+                                                    &LogData::writeDemandProfile };
+            for (size_t report = 3; report <= 16; ++report)
+            {
+                if (reportWritten(1u << report))
+                {
+                    writers.push_back(sessionWriters[report - 3]);
+                    paths.push_back(m_outputPaths.at(report));
+                }
+            }
+            if (m_groupMapping != NULL)
+            {
+                writers.push_back(&LogData::writeChargeback);
+                paths.push_back(chargebackPath());
+            }
+            if (m_usageBucketSeconds > 0 && reportSelected(ConcurrentUsageReport))
+            {
+                writers.push_back(&LogData::writeConcurrentUsageBuckets);
+                paths.push_back(usageBucketsPath());
+            }
+            if (m_arrowExport && m_reports == AllReports)
+            {
+                vector<string> exportPaths = arrowPaths();
+                writers.push_back(&LogData::writeArrowEvents);
+                writers.push_back(&LogData::writeArrowSessions);
+                writers.push_back(&LogData::writeArrowUsage);
+                paths.insert(paths.end(), exportPaths.begin(), exportPaths.end());
+            }
+            if (m_sqliteExport && m_reports == AllReports)
+            {
+                writers.push_back(&LogData::writeSqliteDatabase);
+                paths.push_back(sqlitePath());
+            }
+            if (m_jsonExport && m_reports == AllReports)
+            {
+                vector<string> exportPaths = jsonPaths();
+                writers.push_back(&LogData::writeJsonEvents);
+                writers.push_back(&LogData::writeJsonSessions);
+                paths.insert(paths.end(), exportPaths.begin(), exportPaths.end());
+            }
+        }
+    }
+    if (includeEventData && reportWritten(ProcessedLogReport))
+    {
+        writers.push_back(&LogData::writeEventData);
+        paths.push_back(m_outputPaths.at(1));
+    }
+
+    // One flag per report, each set only by its own task
+    vector<char> failed(writers.size(), 0);
+    bool stream = ! m_reportDestination.empty();
+    auto writeReport = [this, &writers, &paths, &failed, stream](size_t report)
+    {
+        const string& path = paths.at(report);
+        StageTimer stage(m_stats, "write " + path.substr(path.find_last_of("/\\") + 1), StageTimer::ThreadCpu);
+        const string& destination = stream ? m_reportDestination : path;
+        long long lengthBefore = stream ? 0 : max(getFileSize(path), 0LL);
+        try
+        {
+            (this->*writers.at(report))(destination);
+        }
+        catch (CannotOpenFileException&)
+        {
+            failed.at(report) = 1;
+        }
+        if (! stream)
+        {
+            stage.setBytes(static_cast<uint64_t>(max(getFileSize(path) - lengthBefore, 0LL)));
+        }
+    };
+
+    // A stream takes the reports one after the other
+    if (stream)
+    {
+        for (size_t report = 0; report < writers.size(); ++report)
+        {
+            writeReport(report);
+        }
+    }
+    else if (! writers.empty())
+    {
+        unique_ptr<ThreadPool> ownPool;
+        if (sharedPool == NULL)
+        {
+            ownPool.reset(new ThreadPool(min(writers.size(), availableThreads())));
+        }
+        TaskGroup reports(sharedPool ? *sharedPool : *ownPool);
+
+        for (size_t report = 0; report < writers.size(); ++report)
+        {
+            reports.run([&writeReport, report]()
+            {
+                writeReport(report);
+            });
+        }
+        reports.wait();
+    }
+
+    vector<string> failedPaths;
+    for (size_t report = 0; report < writers.size(); ++report)
+    {
+        if (failed.at(report))
+        {
+            failedPaths.push_back(stream ? m_reportDestination : paths.at(report));
+        }
+    }
+    if (! failedPaths.empty())
+    {
+        CannotOpenFileException cannotOpenFileException(failedPaths);
+        throw cannotOpenFileException;
+    }
+
+    accountMemory("reports");
+
+    // Only a run that wrote every report can be resumed from
+    if (m_incremental && m_fileFormat == ReportLog && includeEventData && includeReports)
+    {
+        saveCheckpoint();
+    }
+}
+
+// Reports a resumed analysis appends to: the processed log, the concurrent
+// usage, the license activity, the denied requests and the license
+// saturation, of those that are written.  The others are small and
+// rewritten from the totals.
+bool LogData::canAppendReports()
+{
+    // The buckets and the Arrow, SQLite and JSON exports need all the events
+    if (m_usageBucketSeconds > 0 || m_arrowExport || m_sqliteExport || m_jsonExport)
+    {
+        return false;
+    }
+
+    // New products would add columns to the wide usage report
+    if (m_usageFormat == WideUsage && m_uniqueProducts.size() != m_checkpoint.products.size())
+    {
+        return false;
+    }
+
+    const size_t appendedReports[] = { 1, 2, 3, 6, 9 };
+    for (size_t report = 0; report < 5; ++report)
+    {
+        if (! reportWritten(1u << appendedReports[report]))
+        {
+            continue;
+        }
+        const string& path = m_outputPaths.at(appendedReports[report]);
+        vector<string>::const_iterator found = find(m_checkpoint.reportPaths.begin(), m_checkpoint.reportPaths.end(), path);
+        if (found == m_checkpoint.reportPaths.end())
+        {
+            return false;
+        }
+        long long length = getFileSize(path);
+        if (length < 0 || static_cast<uint64_t>(length) < m_checkpoint.reportLengths.at(found - m_checkpoint.reportPaths.begin()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LogData::saveCheckpoint()
+{
+    Checkpoint checkpoint;
+    // The log of an incremental analysis is mapped, so its offsets fit
+    const char* data = m_inputFile.data();
+    size_t offset = static_cast<size_t>(m_inputOffset);
+    size_t end = static_cast<size_t>(m_inputEnd);
+    size_t hashedLength = min(end, CheckpointHashedLength);
+
+    checkpoint.inputOffset = m_inputEnd;
+    checkpoint.inputLines = m_inputLines + count(data + offset, data + end, '\n');
+    checkpoint.headHash = checkpointHash(data, hashedLength);
+    checkpoint.tailHash = checkpointHash(data + end - hashedLength, hashedLength);
+    checkpoint.eventYear = m_eventYear;
+    checkpoint.serverName = m_serverName;
+
+    const StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueVersions, &m_uniqueUsers,
+                                       &m_uniqueHosts, &m_uniqueHandles, &m_uniqueServers };
+    vector<string>* names[] = { &checkpoint.products, &checkpoint.versions, &checkpoint.users,
+                                &checkpoint.hosts, &checkpoint.handles, &checkpoint.servers };
+    for (size_t table = 0; table < 6; ++table)
+    {
+        for (size_t name = 0; name < tables[table]->size(); ++name)
+        {
+            names[table]->push_back(string(tables[table]->name(name)));
+        }
+    }
+
+    // The events to carry, in log order.  The open check-outs come after
+    // the last shutdown, so they stay open when the next run replays them.
+    vector<char> carry(m_events.size(), 0);
+    for (size_t start = 0; start < m_startRows.size(); ++start)
+    {
+        carry.at(m_startRows.at(start)) = 1;
+    }
+    for (size_t shutdown = 0; shutdown < m_shutdownRows.size(); ++shutdown)
+    {
+        carry.at(m_shutdownRows.at(shutdown)) = 1;
+    }
+    if (m_events.size() > 0)
+    {
+        carry.at(m_endTimeRow) = 1;
+    }
+
+    checkpoint.closedSessions = m_checkpoint.closedSessions;
+    for (size_t session = 0; session < m_sessions.size(); ++session)
+    {
+        size_t row = m_sessions.at(session).checkOutRow;
+        if (m_sessions.at(session).checkInRow == NoId)
+        {
+            carry.at(row) = 1;
+        }
+        else
+        {
+            ++checkpoint.closedSessions;
+        }
+    }
+    checkpoint.denials = m_checkpoint.denials + m_denialRows.size();
+
+    size_t nextReserved = 0;
+    for (size_t row = 0; row < m_events.size(); ++row)
+    {
+        if (! carry.at(row))
+        {
+            continue;
+        }
+        if (row == m_endTimeRow)
+        {
+            checkpoint.endTimeRow = checkpoint.carriedEvents.size();
+        }
+        if (m_events.types.at(row) == OutEvent && reservedCheckOut(row, nextReserved))
+        {
+            checkpoint.reservedCheckOuts.push_back(checkpoint.carriedEvents.size());
+        }
+        size_t carried = checkpoint.carriedEvents.append(m_events.types.at(row));
+        checkpoint.carriedEvents.timestamps.at(carried) = m_events.timestamps.at(row);
+        checkpoint.carriedEvents.products.at(carried) = m_events.products.at(row);
+        checkpoint.carriedEvents.versions.at(carried) = m_events.versions.at(row);
+        checkpoint.carriedEvents.users.at(carried) = m_events.users.at(row);
+        checkpoint.carriedEvents.hosts.at(carried) = m_events.hosts.at(row);
+        checkpoint.carriedEvents.counts.at(carried) = m_events.counts.at(row);
+        checkpoint.carriedEvents.handles.at(carried) = m_events.handles.at(row);
+        checkpoint.carriedEvents.reserved.at(carried) = m_events.reserved.at(row);
+    }
+
+    const size_t numberOfProducts = m_uniqueProducts.size();
+    for (size_t product = 0; product < numberOfProducts; ++product)
+    {
+        const UsageCounters* counters[] = { &m_usageCounters.at(product), &m_recordedCounters.at(product) };
+        vector<int32_t>* values[] = { &checkpoint.usageCounters, &checkpoint.recordedCounters };
+        for (size_t list = 0; list < 2; ++list)
+        {
+            values[list]->push_back(counters[list]->floatingInUse);
+            values[list]->push_back(counters[list]->totalInUse);
+            values[list]->push_back(counters[list]->floatingLimit);
+            values[list]->push_back(counters[list]->reservedInUse);
+            values[list]->push_back(counters[list]->reservedLimit);
+        }
+    }
+    for (size_t countIndex = 0; countIndex < m_licenseCounts.size(); ++countIndex)
+    {
+        if (m_licenseCounts.at(countIndex) > 0)
+        {
+            CheckpointEntry licenseCount = { countIndex / numberOfProducts, countIndex % numberOfProducts, m_licenseCounts.at(countIndex) };
+            checkpoint.licenseCounts.push_back(licenseCount);
+        }
+    }
+    listReservedCounts(checkpoint.reservedCounts);
+
+    // The totals of the closed sessions, summed by host (user) and product
+    vector<CheckpointEntry> durations;
+    SparseTotals closedDurations;
+    collectDurations(m_checkpoint.hostDurations, m_events.hosts, true, durations);
+    closedDurations.assign(m_uniqueHosts.size(), numberOfProducts, durations);
+    closedDurations.entries(checkpoint.hostDurations);
+    collectDurations(m_checkpoint.userDurations, m_events.users, true, durations);
+    closedDurations.assign(m_uniqueUsers.size(), numberOfProducts, durations);
+    closedDurations.entries(checkpoint.userDurations);
+    vector<CheckpointEntry> reservedDurations(m_checkpoint.reservedUserDurations);
+    vector<CheckpointEntry> floatingDurations(m_checkpoint.floatingUserDurations);
+    nextReserved = 0;
+    for (size_t session = 0; session < m_sessions.size(); ++session)
+    {
+        size_t row = m_sessions[session].checkOutRow;
+        bool reserved = reservedCheckOut(row, nextReserved);
+        if (m_sessions[session].checkInRow != NoId)
+        {
+            CheckpointEntry duration = { m_events.users.at(row), m_events.products.at(row), m_sessions[session].duration };
+            (reserved ? reservedDurations : floatingDurations).push_back(duration);
+        }
+    }
+    closedDurations.assign(m_uniqueUsers.size(), numberOfProducts, reservedDurations);
+    closedDurations.entries(checkpoint.reservedUserDurations);
+    closedDurations.assign(m_uniqueUsers.size(), numberOfProducts, floatingDurations);
+    closedDurations.entries(checkpoint.floatingUserDurations);
+    m_sessionDurations.entries(checkpoint.durationCounts, checkpoint.longestSessions);
+    m_usageHeatmap.save(checkpoint);
+    m_licenseSaturation.save(checkpoint);
+    m_eventTotals.save(checkpoint);
+    m_sustainedPeaks.save(checkpoint);
+    m_longestClosedSessions.save(checkpoint);
+    m_versionUsage.save(checkpoint);
+    m_forgottenSessions.save(checkpoint);
+    m_demandProfile.save(checkpoint);
+    if (m_groupMapping != NULL)
     {
-        size_t eventRow = m_eventData.size()-1;
-        string currentDate = m_eventData.at(eventRow).at(IndexDate);
-
-        // If a log event occurs within the first minute after midnight, it is logged before
-        // the string that provides the new year.  This code checks for events on Jan 1 at 00:00
-        // and increments the year.
-        if (currentDate == "01/01")
+        for (size_t group = 0; group < m_groupMapping->groups(); ++group)
         {
-            vector<string> timeVector;
-            tokenizeString(":", m_eventData.at(eventRow).at(IndexTime), timeVector);
-            if (timeVector.at(0) == "00" && timeVector.at(1) == "00")
+            checkpoint.chargebackGroups.push_back(m_groupMapping->group(group));
+        }
+        for (size_t index = 0; index < m_chargeback.size(); ++index)
+        {
+            if (m_chargeback[index].closedSessions > 0)
             {
-                int eventYearNumber = atoi(m_eventYear.c_str());
-                ++eventYearNumber;
-                m_eventYear = toString(eventYearNumber);
+                CheckpointEntry seconds = { index / numberOfProducts, index % numberOfProducts, m_chargeback[index].closedSeconds };
+                checkpoint.chargebackSeconds.push_back(seconds);
+                checkpoint.chargebackSessions.push_back(m_chargeback[index].closedSessions);
+                checkpoint.chargebackReservedSeconds.push_back(m_chargeback[index].closedReservedSeconds);
             }
         }
-        (m_eventData.at(eventRow).at(IndexDate)).append("/" + m_eventYear);
     }
-}
-
-// Event Indices (check also header LogData.h)
-void LogData::getEventIndices()
-{
-    if (m_fileFormat == ReportLog)
+    for (const auto& hour : m_hourlyDenials)
     {
-        m_eventIndex = 0;
-
-        m_OUTindices.push_back(m_eventIndex);
-        m_OUTindices.push_back(RepOUTIndexDate);
-        m_OUTindices.push_back(RepOUTIndexTime);
-        m_OUTindices.push_back(RepOUTIndexProduct);
-        m_OUTindices.push_back(RepOUTIndexVersion);
-        m_OUTindices.push_back(RepOUTIndexUser);
-        m_OUTindices.push_back(RepOUTIndexHost);
-        m_OUTindices.push_back(RepOUTIndexCount);
-        m_OUTindices.push_back(RepOUTIndexHandle);
-        m_OUTindices.push_back(RepOUTIndexReserved);
-
-        m_INindices.push_back(m_eventIndex);
-        m_INindices.push_back(RepINIndexDate);
-        m_INindices.push_back(RepINIndexTime);
-        m_INindices.push_back(RepINIndexProduct);
-        m_INindices.push_back(RepINIndexVersion);
-        m_INindices.push_back(RepINIndexUser);
-        m_INindices.push_back(RepINIndexHost);
-        m_INindices.push_back(RepINIndexCount);
-        m_INindices.push_back(RepINIndexHandle);
-        m_INindices.push_back(RepINIndexReserved);
-
-        m_DENYindices.push_back(m_eventIndex);
-        m_DENYindices.push_back(RepDENYIndexDate);
-        m_DENYindices.push_back(RepDENYIndexTime);
-        m_DENYindices.push_back(RepDENYIndexProduct);
-        m_DENYindices.push_back(RepDENYIndexVersion);
-        m_DENYindices.push_back(RepDENYIndexUser);
-        m_DENYindices.push_back(RepDENYIndexHost);
-        m_DENYindices.push_back(RepDENYIndexCount);
-        m_DENYindices.push_back(RepDENYIndexReason);
-
-
-        m_STARTindices.push_back(m_eventIndex);
-        m_STARTindices.push_back(RepSTARTIndexDate);
-        m_STARTindices.push_back(RepSTARTIndexTime);
-        m_STARTindices.push_back(RepSTARTIndexServer);
-
-        m_SHUTindices.push_back(m_eventIndex);
-        m_SHUTindices.push_back(RepSHUTIndexDate);
-        m_SHUTindices.push_back(RepSHUTIndexTime);
-
-        m_PRODUCTindices.push_back(m_eventIndex);
-        m_PRODUCTindices.push_back(RepPRODUCTIndexProduct);
-        m_PRODUCTindices.push_back(RepPRODUCTIndexVersion);
-        m_PRODUCTindices.push_back(RepPRODUCTIndexCount);
-        m_PRODUCTindices.push_back(RepPRODUCTIndexRLimit);
-    }    
-}
-
-void LogData::standardizeLogFormatting()
-{
-    size_t i = 0;
-    int licenseUsageCount = 0;
+        CheckpointEntry denials = { static_cast<uint64_t>(hour.first.first), hour.first.second, static_cast<int64_t>(hour.second.denials) };
+        checkpoint.hourlyDenials.push_back(denials);
+        checkpoint.hourlyDenialsAtLimit.push_back(hour.second.atLimit);
+    }
 
-    for (size_t row=0; row<m_allData.size(); ++row)
+    const size_t appendedReports[] = { 1, 2, 3, 6, 9 };
+    for (size_t report = 0; report < 5; ++report)
     {
-        if (m_allData.at(row).size() > m_eventIndex)
+        if (! reportWritten(1u << appendedReports[report]))
         {
-            if (m_allData.at(row).at(m_eventIndex) == "OUT:")
-            {   
-                reformatEventName(row, "OUT");
-                // reformatProductVersion(row, isvOUTIndexVersion, m_allData.at(row));
-                reformatUserHost(row, m_OUTindices);
-            }
-            else if (m_allData.at(row).at(m_eventIndex) == "IN:")
-            {
-                reformatEventName(row, "IN");
-                // reformatProductVersion(row, isvINIndexVersion, m_allData.at(row));
-                reformatUserHost(row, m_INindices);
-            }
-            else if (m_allData.at(row).at(m_eventIndex) == "DENIED:")
-            {
-                reformatEventName(row, "DENY");
-                // reformatProductVersion(row, isvDENYIndexVersion, m_allData.at(row));
-                reformatUserHost(row, m_DENYindices);
-            }
-            else if (m_allData.at(row).at(m_eventIndex) == "Server")
-            {
-                reformatEventName(row, "START");
-            }
-            else if (m_allData.at(row).at(m_eventIndex) == "Shutdown")
-            {
-                reformatEventName(row, "SHUTDOWN");
-            }
+            continue;
+        }
+        const string& path = m_outputPaths.at(appendedReports[report]);
+        uint64_t length = static_cast<uint64_t>(max(getFileSize(path), 0LL));
+        if (appendedReports[report] == 3)
+        {
+            length = m_activityLength;
         }
+        else if (appendedReports[report] == 9)
+        {
+            length = m_saturationLength;
+        }
+        checkpoint.reportPaths.push_back(path);
+        checkpoint.reportLengths.push_back(length);
     }
-}
 
-void LogData::reformatEventName(const size_t row,
-                                const string newLabel)
-{
-    m_allData.at(row).at(m_eventIndex) = newLabel;
+    checkpoint.save(m_checkpointPath);
 }
 
-void LogData::reformatUserHost(const size_t row,
-                               const vector<size_t>& indices)
+// Processed log: one line per event with the fields of its type
+// Writes the rows firstRow to endRow of a report, which writeRows formats
+// a range at a time.  With threads to spare, ranges of ReportRowsPerBatch
+// rows are formatted on the pool into buffers of their own, which are
+// written in the order of the rows, so the report is the same either way.
+void LogData::writeRowRanges(BufferedWriter& out, size_t firstRow, size_t endRow,
+                             const function<void(BufferedWriter&, size_t, size_t)>& writeRows)
 {
-    vector<string> tempVector;
-    size_t userIndex = indices.at(IndexUser);
-    size_t hostIndex = indices.at(IndexHost);
-
-    tokenizeString("@", m_allData.at(row).at(userIndex), tempVector);
-    m_allData.at(row).erase(m_allData.at(row).begin()+userIndex);
-    m_allData.at(row).insert(m_allData.at(row).begin()+userIndex, tempVector.at(0));
-    m_allData.at(row).insert(m_allData.at(row).begin()+hostIndex, tempVector.at(1));
-}
+    size_t rows = endRow - firstRow;
+    if (m_pool == NULL || m_pool->size() <= 1 || rows <= ReportRowsPerBatch)
+    {
+        writeRows(out, firstRow, endRow);
+        return;
+    }
 
-void LogData::reformatProductVersion(const size_t row,
-                                     const size_t col,
-                                     vector<string>& allDataRow)
-{
-    checkForValidProductVersion(row, col, allDataRow);
-    string tempString = allDataRow.at(col);
-    tempString.erase(0,1);
-    allDataRow.at(col) = tempString;
+    OrderedMerge<string> batches(m_pool, m_pool->size() * ReportBatchesAheadPerThread);
+    batches.run((rows + ReportRowsPerBatch - 1) / ReportRowsPerBatch,
+                [firstRow, endRow, &writeRows](size_t batch, string& text)
+                {
+                    text.clear();
+                    BufferedWriter batchOut(text);
+                    size_t batchStart = firstRow + batch * ReportRowsPerBatch;
+                    writeRows(batchOut, batchStart, min(batchStart + ReportRowsPerBatch, endRow));
+                    batchOut.close();
+                },
+                [&out](size_t, string& text)
+                {
+                    out.write(text);
+                    return true;
+                });
 }
 
-void LogData::licenseCountAdjust(vector<size_t>& licenseCountNumbers,
-                        vector<string>& licenseCountsByProduct)
+// The reports of a row per event, timeline entry, session or denial are
+// split by period only in a full analysis written to files
+bool LogData::partitionsReports() const
 {
-    licenseCountsByProduct.clear();
-    for (size_t product=0; product<licenseCountNumbers.size(); ++product)
-    {
-        string licenseCountString = toString(licenseCountNumbers.at(product));
-        licenseCountsByProduct.push_back(licenseCountString);
-    }
+    return m_outputPartition != NoPartition && ! m_incremental && m_reportDestination.empty();
 }
 
-void LogData::loadEventIntoVector(const vector<string>& allDataRow,
-                                  const size_t row,
-                                  const vector<size_t>& indices)
+// The file of the period starting at periodStart: the report's with the
+// month, or the first day of the week, before the extension
+string LogData::partitionPath(const string& outputFilePath, long long periodStart) const
 {
-    vector<string> eventLine;
-    if (allDataRow.size() >= indices.size())
+    DateTime start;
+    epochToDateTime(periodStart, start);
+    char period[16];
+    if (m_outputPartition == MonthPartition)
     {
-        for (size_t col=0; col<indices.size(); ++col)
-        {
-            eventLine.push_back(allDataRow.at(indices.at(col)));
-        }
-        m_eventData.push_back(eventLine);
+        snprintf(period, sizeof(period), "_%04d-%02d", start.year, start.month);
     }
     else
     {
-        EventDataException eventDataException(row+1);
-        throw eventDataException;
+        snprintf(period, sizeof(period), "_%04d-%02d-%02d", start.year, start.month, start.day);
     }
+    size_t extension = outputFilePath.find_last_of('.', outputFilePath.size() - compressionSuffix(m_reportCompression).size() - 1);
+    return outputFilePath.substr(0, extension) + period + outputFilePath.substr(extension);
 }
 
-size_t LogData::getIndex(const string& name, const vector<string>& list)
+// Writes the rows [firstRow, endRow) of a report in time order, the time
+// of a row given by rowTime: appended to the report of the last run when
+// resumed, after the header otherwise, or split by period
+void LogData::writeTimeOrdered(const string& outputFilePath, size_t firstRow, size_t endRow,
+                               const function<long long(size_t)>& rowTime,
+                               const function<void(BufferedWriter&)>& writeHeader,
+                               const function<void(BufferedWriter&, size_t, size_t)>& writeRows)
 {
-    for (size_t index=0; index < list.size(); ++index)
+    if (partitionsReports())
     {
-        if (list.at(index) == name)
-        {
-            return index;
-        }
+        writePartitions(outputFilePath, firstRow, endRow, rowTime, writeHeader, writeRows);
+        return;
     }
-    InvalidIndexException invalidIndexException(name);
-    throw invalidIndexException;
-}
-
-void LogData::checkForValidProductVersion(const size_t row,
-                                 const size_t col,
-                                 vector<string>& allDataRow)
-{
-    string productVersion = allDataRow.at(col);
 
-    // Check for the "v" at the beginning of the product version
-    size_t found = productVersion.find("v");
-    if (found != 0)
+    BufferedWriter out(outputFilePath, m_resumed, m_reportCompression);
+    if (! m_resumed)
     {
-        InvalidProductVersionException invalidProductVersionException(row+1);
-        throw invalidProductVersionException;
+        writeHeader(out);
     }
+    writeRowRanges(out, firstRow, endRow, writeRows);
+    out.close();
 }
 
-void LogData::getConcurrentUsage()
+// Writes the rows [firstRow, endRow) into one file per period, each with
+// the header.  A row out of time order starts a run of its own, so the runs
+// of rows are gathered by period first; a row without a time, e.g. a PRODUCT
+// event, stays in the run it is in, or opens one with the next row that has
+// a time.  The periods are then written as tasks of their own; a single
+// period is written in batches instead.
+void LogData::writePartitions(const string& outputFilePath, size_t firstRow, size_t endRow,
+                              const function<long long(size_t)>& rowTime,
+                              const function<void(BufferedWriter&)>& writeHeader,
+                              const function<void(BufferedWriter&, size_t, size_t)>& writeRows)
 {
-    vector<string> reservedLicenseUsageCount (m_uniqueProducts.size(), "0");
-    vector<string> licenseCountsByProduct(m_uniqueProducts.size(), "0");
-    vector<size_t> uniqueLicenseCountsByProduct (m_uniqueProducts.size(), 0);
-    vector< vector<size_t> > licenseCountByProductAndUser;
-    vector<string> maxLicenseCountsByProduct (m_uniqueProducts.size(), "0");
-    vector<string> maxreservedLicenseCountsByProduct(m_uniqueProducts.size(), "0");
-    vector<size_t> licenseCountNumbers (m_uniqueProducts.size(), 0);
-    size_t productCountIndex;
-    size_t userCountIndex;
-
-    // Initialize matrix for Imaris license count by user and product (Imaris module)
-    for (size_t row=0; row < m_uniqueUsers.size(); ++row)
+    const rollupPeriod period = (m_outputPartition == WeekPartition) ? WeekRollup : MonthRollup;
+    map<long long, vector< pair<size_t, size_t> > > periodRuns;
+    for (size_t row = firstRow; row < endRow; )
     {
-        vector<size_t> tempCountVector;
-        for (size_t col=0; col < m_uniqueProducts.size(); ++col)
+        size_t timedRow = row;
+        while (timedRow + 1 < endRow && rowTime(timedRow) == 0)
         {
-            tempCountVector.push_back(0);
+            ++timedRow;
         }
-        licenseCountByProductAndUser.push_back(tempCountVector);
-    }
-
-    vector<string> tempVector;
-    tempVector.push_back("Date/Time");
-    for (size_t product=0; product<m_uniqueProducts.size(); ++product)
-    {
-        // Set CSV Headers       
-        if (m_fileFormat == ReportLog)
+        long long start = UsageRollups::periodStart(period, rowTime(timedRow));
+        long long end = UsageRollups::nextPeriodStart(period, start);
+        size_t runEnd = timedRow + 1;
+        while (runEnd < endRow)
         {
-            tempVector.push_back(m_uniqueProducts.at(product) + " Floating Licenses in use");
-            tempVector.push_back(m_uniqueProducts.at(product) + " Total Licenses in use");
-            tempVector.push_back(m_uniqueProducts.at(product) + " Floating Licenses Limit");
-            tempVector.push_back(m_uniqueProducts.at(product) + " Reserved Licenses in use");
-            tempVector.push_back(m_uniqueProducts.at(product) + " Reserved Licenses Limit");
+            long long time = rowTime(runEnd);
+            if (time != 0 && (time < start || time >= end))
+            {
+                break;
+            }
+            ++runEnd;
         }
+        periodRuns[start].push_back(make_pair(row, runEnd));
+        row = runEnd;
     }
-    m_usage.push_back(tempVector);
 
-    for (size_t row=0; row<m_eventData.size(); ++row)
+    const bool parallel = m_pool != NULL && m_pool->size() > 1 && periodRuns.size() > 1;
+    auto writePeriod = [this, &outputFilePath, &writeHeader, &writeRows, parallel](long long start,
+                                                                                   const vector< pair<size_t, size_t> >& runs)
     {
-        if (m_eventData.at(row).at(IndexEvent) == "OUT")
-        {
-            productCountIndex = getIndex(m_eventData.at(row).at(IndexProduct), m_uniqueProducts);
-            userCountIndex = getIndex(m_eventData.at(row).at(IndexUser), m_uniqueUsers);
-
-            // Total usage
-            if (m_fileFormat == ReportLog)
-            {
-                licenseCountsByProduct.at(productCountIndex) = m_eventData.at(row).at(IndexCount);
-            }
-            
-            // Unique usage
-            ++licenseCountByProductAndUser.at(userCountIndex).at(productCountIndex);
-            if (licenseCountByProductAndUser.at(userCountIndex).at(productCountIndex) == 1)
-            {
-                ++uniqueLicenseCountsByProduct.at(productCountIndex);
-            }
-
-            // Reserved Imaris License Usage Data
-            reservedLicenseUsageCount.at(productCountIndex) = m_eventData.at(row).at(9);
-
-            gatherConcurrentUsageData(row, licenseCountsByProduct, uniqueLicenseCountsByProduct, maxLicenseCountsByProduct, reservedLicenseUsageCount, maxreservedLicenseCountsByProduct);
-        }
-        else if (m_eventData.at(row).at(IndexEvent) == "IN")
+        BufferedWriter out(partitionPath(outputFilePath, start), false, m_reportCompression);
+        writeHeader(out);
+        for (const pair<size_t, size_t>& run : runs)
         {
-            productCountIndex = getIndex(m_eventData.at(row).at(IndexProduct), m_uniqueProducts);
-            userCountIndex = getIndex(m_eventData.at(row).at(IndexUser), m_uniqueUsers);
-
-            // Total usage
-            if (m_fileFormat == ReportLog)
-            {
-                licenseCountsByProduct.at(productCountIndex) = m_eventData.at(row).at(IndexCount);
-            }
-            
-            // Unique usage
-
-            // Make sure we can't iterate below zero
-            // (could happen if the log file started with licenses already checked out and the first event is a check-in)
-            if (licenseCountByProductAndUser.at(userCountIndex).at(productCountIndex) > 0)
-            {
-                --licenseCountByProductAndUser.at(userCountIndex).at(productCountIndex);
-            }
-
-            if (licenseCountByProductAndUser.at(userCountIndex).at(productCountIndex) == 0 && uniqueLicenseCountsByProduct.at(productCountIndex) > 0)
-            {
-                --uniqueLicenseCountsByProduct.at(productCountIndex);
-            }
-
-            if (atoi(licenseCountsByProduct.at(productCountIndex).c_str()) > 0 && uniqueLicenseCountsByProduct.at(productCountIndex) == 0)
+            if (parallel)
             {
-                // This deals with the special case where a report log started after licenses were checked out.
-                // The log has no data on who checked out the licenses, it just gives a count of what's checked out.
-                // We post "1".  The actual value would be greater than or equal to that value.
-                uniqueLicenseCountsByProduct.at(productCountIndex) = 1;
-                gatherConcurrentUsageData(row, licenseCountsByProduct, uniqueLicenseCountsByProduct, maxLicenseCountsByProduct, reservedLicenseUsageCount, maxreservedLicenseCountsByProduct);
-
-                // Set the unique value back down to zero.  Otherwise, a subsequent OUT event will cause the unique users to go up
-                // to "2", even though we're not sure if the check-out is unique or not.
-                uniqueLicenseCountsByProduct.at(productCountIndex) = 0;
+                writeRows(out, run.first, run.second);
             }
             else
             {
-                gatherConcurrentUsageData(row, licenseCountsByProduct, uniqueLicenseCountsByProduct, maxLicenseCountsByProduct, reservedLicenseUsageCount, maxreservedLicenseCountsByProduct);
+                writeRowRanges(out, run.first, run.second, writeRows);
             }
         }
-        else if (m_eventData.at(row).at(IndexEvent) == "SHUTDOWN")
-        {
-            setVectorToZero(licenseCountNumbers);
-            setVectorToZero(uniqueLicenseCountsByProduct);
-            setMatrixToZero(licenseCountByProductAndUser);
-            licenseCountAdjust(licenseCountNumbers, licenseCountsByProduct);
-            gatherConcurrentUsageData(row, licenseCountsByProduct, uniqueLicenseCountsByProduct, maxLicenseCountsByProduct, reservedLicenseUsageCount, maxreservedLicenseCountsByProduct);
-        }
-        else if (m_eventData.at(row).at(IndexEvent) == "PRODUCT")
+        out.close();
+    };
+    if (! parallel)
+    {
+        for (const auto& runs : periodRuns)
         {
-            string tempProduct = m_eventData.at(row).at(1);
-            productCountIndex = getIndex(tempProduct, m_uniqueProducts);
-            if (m_fileFormat == ReportLog)
-            {
-                maxLicenseCountsByProduct.at(productCountIndex) = m_eventData.at(row).at(3);
-                maxreservedLicenseCountsByProduct.at(productCountIndex) = m_eventData.at(row).at(4);
-            }
+            writePeriod(runs.first, runs.second);
         }
+        return;
     }
-}
 
-int LogData::getCountOffset(const size_t& row)
-{
-    return atoi(m_eventData.at(row).at(IndexCount).c_str());
+    TaskGroup periods(*m_pool);
+    for (const auto& runs : periodRuns)
+    {
+        const auto* periodRun = &runs;
+        periods.run([&writePeriod, periodRun]()
+        {
+            writePeriod(periodRun->first, periodRun->second);
+        });
+    }
+    periods.wait();
 }
 
-void LogData::gatherConcurrentUsageData(const size_t& row,
-                                        const vector<string>& licenseUsageCount,
-                                        const vector<size_t>& uniqueLicenseCountsByProduct,
-                                        const vector<string>& maxLicenseUsageCount,
-                                        const vector<string>& reservedLicenseUsageCount,
-                                        const vector<string>& maxreservedLicenseCountsByProduct)
+void LogData::writeEventData(const string& outputFilePath)
 {
-    vector<string> tempVector;
-    tempVector.push_back(m_eventData.at(row).at(IndexDate) + " " + m_eventData.at(row).at(IndexTime));
-
-    for (size_t product=0; product<licenseUsageCount.size(); ++product)
+    writeTimeOrdered(outputFilePath, m_firstNewRow, m_events.size(), [this](size_t row)
     {
-        tempVector.push_back(licenseUsageCount.at(product));
-        tempVector.push_back(toString(uniqueLicenseCountsByProduct.at(product)));
-        if (m_fileFormat == ReportLog)
+        return m_events.timestamps[row];
+    }, [](BufferedWriter&)
+    {
+    }, [this](BufferedWriter& rangeOut, size_t firstRow, size_t endRow)
+    {
+        for (size_t row = firstRow; row < endRow; ++row)
         {
-            tempVector.push_back(maxLicenseUsageCount.at(product));
-            tempVector.push_back(reservedLicenseUsageCount.at(product));
-            tempVector.push_back(maxreservedLicenseCountsByProduct.at(product));
+            writeEventRow(rangeOut, row);
         }
-    }
-    m_usage.push_back(tempVector);
+    });
 }
 
-void LogData::getUsageDurationHost()
+// One line of the processed log
+void LogData::writeEventRow(BufferedWriter& out, size_t row) const
 {
-    int checkInRow = -1;
-
-    vector<string> tempVector;
-    tempVector.push_back("Checkout Date/Time");
-    tempVector.push_back("Checkin Date/Time");
-    tempVector.push_back("Product");
-    tempVector.push_back("Version");
-    tempVector.push_back("User");
-    tempVector.push_back("Host");
-    tempVector.push_back("Duration (HH:MM:SS)");
-    m_usageDurationh.push_back(tempVector);
+    eventType type = m_events.types[row];
+    out.write(eventTypeName(type));
 
-    // Initialize matrix for total duration by host and product (Imaris module)
-    for (int row=0; row < m_uniqueHosts.size(); ++row)
+    if (type == ProductEvent)
     {
-        vector<time_duration> tempDurationVector;
-        for (int col=0; col < m_uniqueProducts.size(); ++col)
-        {
-            time_duration td = seconds(0);
-            tempDurationVector.push_back(td);
-        }
-        m_totalDurationh.push_back(tempDurationVector);
+        out.write(' ');
+        out.write(m_uniqueProducts.name(m_events.products[row]));
+        out.write(' ');
+        out.write(m_uniqueVersions.name(m_events.versions[row]));
+        out.write(' ');
+        out.writeInteger(m_events.counts[row]);
+        out.write(' ');
+        out.writeInteger(m_events.reserved[row]);
     }
-
-    for (int row=0; row < m_eventData.size(); ++row)
+    else
     {
-        if (m_eventData.at(row).at(IndexEvent) == "OUT")
-        {
-            string handle = m_eventData.at(row).at(IndexHandle);
-            string product = m_eventData.at(row).at(IndexProduct);
-            string userName = m_eventData.at(row).at(IndexUser);
-            string hostName = m_eventData.at(row).at(IndexHost);
-            
-            ptime startTime = stringToBoostTime(m_eventData.at(row).at(IndexDate),
-                                                m_eventData.at(row).at(IndexTime));
-            ptime endTime;
-
-            for(int newRow=row+1; newRow < m_eventData.size(); ++newRow)
-            {
-                if (m_eventData.at(newRow).at(IndexEvent) == "IN")
-                {
-                    if (m_eventData.at(newRow).at(IndexHandle) == handle)
-                    {
-                        endTime = stringToBoostTime(m_eventData.at(newRow).at(IndexDate),
-                                                    m_eventData.at(newRow).at(IndexTime));
-                        checkInRow = newRow;
-                        break;
-                    }
-                }
-                // A shutdown forces the return of any licenses so it will be the checkin time of 
-                // any checked out licenses
-                if (m_eventData.at(newRow).at(IndexEvent) == "SHUTDOWN")
-                {
-                    endTime = stringToBoostTime(m_eventData.at(newRow).at(IndexDate),
-                                                m_eventData.at(newRow).at(IndexTime));
-                    checkInRow = newRow;
-                    break;
-                }
-            }
+        out.write(' ');
+        out.writeLogDateTime(m_events.timestamps[row]);
+    }
 
-            if (checkInRow == -1)
-            {
-                endTime = stringToBoostTime(m_eventData.at(m_endTimeRow).at(IndexDate),
-                                            m_eventData.at(m_endTimeRow).at(IndexTime));
-            }
-            time_duration usageDuration = endTime - startTime;
-            m_totalDurationh.at(getIndex(hostName, m_uniqueHosts)).at(getIndex(product, m_uniqueProducts)) += usageDuration;
-            
-            string usageDurationString = toString(usageDuration);
-            vector<string> tempVector;
-            string dateTimeCheckOut = m_eventData.at(row).at(IndexDate) + " " + m_eventData.at(row).at(IndexTime);
+    if (type == StartEvent)
+    {
+        out.write(' ');
+        out.write(m_uniqueServers.name(m_events.hosts[row]));
+    }
+    else if (type == OutEvent || type == InEvent || type == DenyEvent)
+    {
+        out.write(' ');
+        out.write(m_uniqueProducts.name(m_events.products[row]));
+        out.write(' ');
+        out.write(m_uniqueVersions.name(m_events.versions[row]));
+        out.write(' ');
+        out.write(m_uniqueUsers.name(m_events.users[row]));
+        out.write(' ');
+        out.write(m_uniqueHosts.name(m_events.hosts[row]));
+        out.write(' ');
+        out.writeInteger(m_events.counts[row]);
+        out.write(' ');
 
-            tempVector.push_back(dateTimeCheckOut);
-            if (checkInRow != -1)
+        // The denial reason is the count field of a DENY event
+        if (type == DenyEvent)
+        {
+            out.writeInteger(m_events.counts[row]);
+        }
+        else
+        {
+            // The handle of an ISV event is a text with spaces (see
+            // projectIsvLine), quoted to stay one field
+            string_view handle = m_uniqueHandles.name(m_events.handles[row]);
+            if (handle.find(' ') != string_view::npos)
             {
-                string dateTimeCheckIn = m_eventData.at(checkInRow).at(IndexDate) + " " + m_eventData.at(checkInRow).at(IndexTime);
-                tempVector.push_back(dateTimeCheckIn);
+                out.write('"');
+                out.write(handle);
+                out.write('"');
             }
             else
             {
-                tempVector.push_back("(Still checked out)");
+                out.write(handle);
             }
-            tempVector.push_back(m_eventData.at(row).at(IndexProduct));
-            tempVector.push_back(m_eventData.at(row).at(IndexVersion));
-            tempVector.push_back(m_eventData.at(row).at(IndexUser));
-            tempVector.push_back(m_eventData.at(row).at(IndexHost));
-            tempVector.push_back(usageDurationString);
-                      
-            m_usageDurationh.push_back(tempVector);
-            checkInRow = -1;
+            out.write(' ');
+            out.writeInteger(m_events.reserved[row]);
         }
     }
+    out.write('\n');
 }
 
-void LogData::getUsageDurationUser()
+// Arrow export of the events, one row per event as in the processed log.
+// Fields an event type does not have are null; START events have their
+// license server in the Server column.
+void LogData::writeArrowEvents(const string& outputFilePath)
 {
-    int checkInRow = -1;
-
-    vector<string> tempVector;
-    tempVector.push_back("Checkout Date/Time");
-    tempVector.push_back("Checkin Date/Time");
-    tempVector.push_back("Product");
-    tempVector.push_back("Version");
-    tempVector.push_back("User");
-    tempVector.push_back("Host");
-    tempVector.push_back("Duration (HH:MM:SS)");
-    m_usageDurationu.push_back(tempVector);
-
-    // Initialize matrix for total duration by user and product (Imaris module)
-    for (int row = 0; row < m_uniqueUsers.size(); ++row)
+    const size_t rows = m_events.size();
+    StringInterner eventNames;
+    for (int type = OutEvent; type <= ProductEvent; ++type)
     {
-        vector<time_duration> tempDurationVector;
-        for (int col = 0; col < m_uniqueProducts.size(); ++col)
-        {
-            time_duration td = seconds(0);
-            tempDurationVector.push_back(td);
-        }
-        m_totalDurationu.push_back(tempDurationVector);
+        eventNames.intern(eventTypeName(static_cast<eventType>(type)));
     }
 
-    for (int row = 0; row < m_eventData.size(); ++row)
+    vector<size_t> types(rows);
+    vector<int64_t> timestamps(rows);
+    vector<uint8_t> timed(rows);
+    vector<size_t> hosts(m_events.hosts);
+    vector<size_t> servers(rows, NoId);
+    vector<size_t> handles(m_events.handles);
+    vector<uint8_t> licenseFields(rows);
+    for (size_t row = 0; row < rows; ++row)
     {
-        if (m_eventData.at(row).at(IndexEvent) == "OUT")
+        eventType type = m_events.types[row];
+        types[row] = static_cast<size_t>(type);
+        timestamps[row] = m_events.timestamps[row];
+        timed[row] = (type != ProductEvent);
+        if (type == StartEvent)
         {
-            string handle = m_eventData.at(row).at(IndexHandle);
-            string product = m_eventData.at(row).at(IndexProduct);
-            string userName = m_eventData.at(row).at(IndexUser);
-            string hostName = m_eventData.at(row).at(IndexHost);
-            ptime startTime = stringToBoostTime(m_eventData.at(row).at(IndexDate),
-                m_eventData.at(row).at(IndexTime));
-            ptime endTime;
-
-            for (int newRow = row + 1; newRow < m_eventData.size(); ++newRow)
-            {
-                if (m_eventData.at(newRow).at(IndexEvent) == "IN")
-                {
-                    if (m_eventData.at(newRow).at(IndexHandle) == handle)
-                    {
-                        endTime = stringToBoostTime(m_eventData.at(newRow).at(IndexDate),
-                            m_eventData.at(newRow).at(IndexTime));
-                        checkInRow = newRow;
-                        break;
-                    }
-                }
-                // A shutdown forces the return of any licenses so it will be the checkin time of 
-                // any checked out licenses
-                if (m_eventData.at(newRow).at(IndexEvent) == "SHUTDOWN")
-                {
-                    endTime = stringToBoostTime(m_eventData.at(newRow).at(IndexDate),
-                        m_eventData.at(newRow).at(IndexTime));
-                    checkInRow = newRow;
-                    break;
-                }
-            }
-
-            if (checkInRow == -1)
-            {
-                endTime = stringToBoostTime(m_eventData.at(m_endTimeRow).at(IndexDate),
-                    m_eventData.at(m_endTimeRow).at(IndexTime));
-            }
-            time_duration usageDuration = endTime - startTime;
-            m_totalDurationu.at(getIndex(userName, m_uniqueUsers)).at(getIndex(product, m_uniqueProducts)) += usageDuration;
-            
-            string usageDurationString = toString(usageDuration);
-            vector<string> tempVector;
-            string dateTimeCheckOut = m_eventData.at(row).at(IndexDate) + " " + m_eventData.at(row).at(IndexTime);
-
-            tempVector.push_back(dateTimeCheckOut);
-            if (checkInRow != -1)
-            {
-                string dateTimeCheckIn = m_eventData.at(checkInRow).at(IndexDate) + " " + m_eventData.at(checkInRow).at(IndexTime);
-                tempVector.push_back(dateTimeCheckIn);
-            }
-            else
-            {
-                tempVector.push_back("(Still checked out)");
-            }
-
-            tempVector.push_back(m_eventData.at(row).at(IndexProduct));
-            tempVector.push_back(m_eventData.at(row).at(IndexVersion));
-            tempVector.push_back(m_eventData.at(row).at(IndexUser));
-            tempVector.push_back(m_eventData.at(row).at(IndexHost));
-            tempVector.push_back(usageDurationString);
-            m_usageDurationu.push_back(tempVector);
-
-            checkInRow = -1;
+            servers[row] = hosts[row];
+            hosts[row] = NoId;
         }
+        licenseFields[row] = (type == OutEvent || type == InEvent || type == DenyEvent || type == ProductEvent);
     }
+
+    ArrowTable table(rows);
+    table.addDictionaryColumn("Event", types, eventNames);
+    table.addTimestampColumn("Date/Time", timestamps, timed);
+    table.addDictionaryColumn("Product", m_events.products, m_uniqueProducts);
+    table.addDictionaryColumn("Version", m_events.versions, m_uniqueVersions);
+    table.addDictionaryColumn("User", m_events.users, m_uniqueUsers);
+    table.addDictionaryColumn("Host", hosts, m_uniqueHosts);
+    table.addDictionaryColumn("Server", servers, m_uniqueServers);
+    table.addInt32Column("Count", m_events.counts, licenseFields);
+    table.addDictionaryColumn("Handle", handles, m_uniqueHandles);
+    table.addInt32Column("Reserved", m_events.reserved, licenseFields);
+    table.write(outputFilePath);
 }
 
-// Denied License Requests
-void LogData::getDeniedRequests()
+// Arrow export of the sessions (license activity).  Sessions still checked
+// out have a null check-in and last until the end of the log.
+void LogData::writeArrowSessions(const string& outputFilePath)
 {
-    int checkInRow = -1;
+    const size_t rows = m_sessions.size();
+    vector<size_t> products(rows);
+    vector<size_t> versions(rows);
+    vector<size_t> users(rows);
+    vector<size_t> hosts(rows);
+    vector<size_t> handles(rows);
+    vector<int64_t> checkOuts(rows);
+    vector<int64_t> checkIns(rows);
+    vector<uint8_t> checkedIn(rows);
+    vector<int64_t> durations(rows);
+    for (size_t session = 0; session < rows; ++session)
+    {
+        size_t row = m_sessions[session].checkOutRow;
+        products[session] = m_events.products[row];
+        versions[session] = m_events.versions[row];
+        users[session] = m_events.users[row];
+        hosts[session] = m_events.hosts[row];
+        handles[session] = m_events.handles[row];
+        checkOuts[session] = m_events.timestamps[row];
+        checkedIn[session] = (m_sessions[session].checkInRow != NoId);
+        checkIns[session] = checkedIn[session] ? m_events.timestamps[m_sessions[session].checkInRow] : 0;
+        durations[session] = m_sessions[session].duration;
+    }
 
-    vector<string> tempVector;
-    tempVector.push_back("Request");
-    tempVector.push_back("Product");
-    tempVector.push_back("Version");
-    tempVector.push_back("User");
-    tempVector.push_back("Host");
-    tempVector.push_back("Reason");
-    m_deniedRequest.push_back(tempVector);
+    ArrowTable table(rows);
+    table.addDictionaryColumn("Product", products, m_uniqueProducts);
+    table.addDictionaryColumn("Version", versions, m_uniqueVersions);
+    table.addDictionaryColumn("User", users, m_uniqueUsers);
+    table.addDictionaryColumn("Host", hosts, m_uniqueHosts);
+    table.addDictionaryColumn("Handle", handles, m_uniqueHandles);
+    table.addTimestampColumn("Check Out", checkOuts);
+    table.addTimestampColumn("Check In", checkIns, checkedIn);
+    table.addInt64Column("Duration (seconds)", durations);
+    table.write(outputFilePath);
+}
 
-    for (size_t row = 0; row < m_eventData.size(); ++row)
+// Arrow export of the concurrency timeline in the long layout: one row per
+// product whose counters changed at a timeline entry
+void LogData::writeArrowUsage(const string& outputFilePath)
+{
+    const size_t rows = m_usageChanges.size();
+    vector<int64_t> timestamps;
+    vector<size_t> products;
+    vector<int32_t> counters[5];
+    timestamps.reserve(rows);
+    products.reserve(rows);
+    for (size_t usageRow = 0; usageRow < m_usageRows.size(); ++usageRow)
     {
-        if (m_eventData.at(row).at(IndexEvent) == "DENY")
+        long long eventTime = m_events.timestamps[m_usageRows[usageRow]];
+        for (size_t change = m_usageChangeOffsets[usageRow]; change < m_usageChangeOffsets[usageRow + 1]; ++change)
         {
-            vector<string> tempVectorx;
-            string dateTimeDenied = m_eventData.at(row).at(IndexDate) + " " + m_eventData.at(row).at(IndexTime);
-           
-            tempVectorx.push_back(dateTimeDenied);
-            tempVectorx.push_back(m_eventData.at(row).at(IndexProduct));
-            tempVectorx.push_back(m_eventData.at(row).at(IndexVersion));
-            tempVectorx.push_back(m_eventData.at(row).at(IndexUser));
-            tempVectorx.push_back(m_eventData.at(row).at(IndexHost));
-            tempVectorx.push_back(m_eventData.at(row).at(IndexCount));
-            m_deniedRequest.push_back(tempVectorx);
-
-            checkInRow = -1;
+            const UsageCounters& productCounters = m_usageChanges[change].counters;
+            timestamps.push_back(eventTime);
+            products.push_back(m_usageChanges[change].product);
+            counters[0].push_back(productCounters.floatingInUse);
+            counters[1].push_back(productCounters.totalInUse);
+            counters[2].push_back(productCounters.floatingLimit);
+            counters[3].push_back(productCounters.reservedInUse);
+            counters[4].push_back(productCounters.reservedLimit);
         }
     }
+
+    ArrowTable table(rows);
+    table.addTimestampColumn("Date/Time", timestamps);
+    table.addDictionaryColumn("Product", products, m_uniqueProducts);
+    table.addInt32Column("Floating Licenses in use", counters[0]);
+    table.addInt32Column("Total Licenses in use", counters[1]);
+    table.addInt32Column("Floating Licenses Limit", counters[2]);
+    table.addInt32Column("Reserved Licenses in use", counters[3]);
+    table.addInt32Column("Reserved Licenses Limit", counters[4]);
+    table.write(outputFilePath);
 }
 
-// Data Summary (TXT File) for quick evaluation
-void LogData::writeSummaryData(const string& outputFilePath)
+// SQLite export of the events, the sessions, the denials and the
+// concurrency timeline in the long layout, for ad hoc SQL.  Names are text
+// and times "YYYY-MM-DD HH:MM:SS"; the fields an event type does not have,
+// the time of PRODUCT events and the check-in of sessions still checked out
+// are NULL.  START events have their license server in the server column.
+// The rows go in first and the time, product, user and host columns are
+// indexed after them.
+void LogData::writeSqliteDatabase(const string& outputFilePath)
 {
-    ofstream myfile;
-    myfile.open (outputFilePath.c_str());
+    SqliteDatabase database(outputFilePath);
+    database.execute("CREATE TABLE events (event TEXT, time TEXT, product TEXT, version TEXT, user TEXT, host TEXT, "
+                     "server TEXT, count INTEGER, handle TEXT, reserved INTEGER);"
+                     "CREATE TABLE sessions (product TEXT, version TEXT, user TEXT, host TEXT, handle TEXT, "
+                     "check_out TEXT, check_in TEXT, duration INTEGER);"
+                     "CREATE TABLE denials (time TEXT, product TEXT, version TEXT, user TEXT, host TEXT, reason INTEGER, "
+                     "floating_in_use INTEGER, floating_limit INTEGER, reserved_in_use INTEGER, reserved_limit INTEGER, "
+                     "requests INTEGER, last_request TEXT);"
+                     "CREATE TABLE usage (time TEXT, product TEXT, floating_in_use INTEGER, total_in_use INTEGER, "
+                     "floating_limit INTEGER, reserved_in_use INTEGER, reserved_limit INTEGER)");
 
-    if (myfile.is_open())
+    const StringInterner* tables[] = { &m_uniqueProducts, &m_uniqueVersions, &m_uniqueUsers, &m_uniqueHosts };
+    auto bindName = [&database](int column, size_t id, const StringInterner& names)
     {
-        myfile << "Log Data Summary For:" << "\n" << m_inputFilePath << "\n\n";
-        myfile << "Server Name: " << m_serverName << "\n\n";
-
-        size_t numberOfStarts = m_startEvents.size();
-        myfile << "Server Start(s): (" << numberOfStarts << " Total)\n";
-        for (size_t row = 0; row < numberOfStarts; ++row)
+        if (id == NoId)
         {
-            for (size_t col = 1; col < m_startEvents.at(row).size(); ++col)
-            {
-                myfile << m_startEvents.at(row).at(col) << " ";
-            }
-            myfile << "\n";
+            database.bindNull(column);
         }
-        myfile << "\n";
-
-        size_t numberOfShutdowns = m_shutdownEvents.size();
-        myfile << "Server Shutdown(s): (" << numberOfShutdowns << " Total)\n";
-        for (size_t row = 0; row < numberOfShutdowns; ++row)
+        else
         {
-            for (size_t col = 1; col < m_shutdownEvents.at(row).size(); ++col)
-            {
-                myfile << m_shutdownEvents.at(row).at(col) << " ";
-            }
-            myfile << "\n";
+            database.bindText(column, names.name(id));
         }
-        myfile << "\n";
+    };
 
-        size_t numberOfProducts = m_uniqueProducts.size();
-        myfile << "Product(s): (" << numberOfProducts << " Total)\n";
-        for (size_t row = 0; row < numberOfProducts; ++row)
+    vector<string> eventNames;
+    for (int type = OutEvent; type <= ProductEvent; ++type)
+    {
+        eventNames.push_back(eventTypeName(static_cast<eventType>(type)));
+    }
+    database.prepare("INSERT INTO events VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    for (size_t row = 0; row < m_events.size(); ++row)
+    {
+        eventType type = m_events.types[row];
+        database.bindText(1, eventNames.at(type));
+        if (type == ProductEvent)
         {
-            myfile << m_uniqueProducts.at(row) << "\n";
+            database.bindNull(2);
         }
-        myfile << "\n";
-
-        size_t numberOfUsers = m_uniqueUsers.size();
-        myfile << "Users(s): (" << numberOfUsers << " Total)\n";
-        for (size_t row = 0; row < numberOfUsers; ++row)
+        else
         {
-            myfile << m_uniqueUsers.at(row) << "\n";
+            database.bindTime(2, m_events.timestamps[row]);
         }
-        myfile << "\n";
-
-       size_t numberOfHosts = m_uniqueHosts.size();
-        myfile << "Host(s): (" << numberOfHosts << " Total)\n";
-        for (size_t row = 0; row < numberOfHosts; ++row)
+        bindName(3, m_events.products[row], m_uniqueProducts);
+        bindName(4, m_events.versions[row], m_uniqueVersions);
+        bindName(5, m_events.users[row], m_uniqueUsers);
+        bindName(6, type == StartEvent ? NoId : m_events.hosts[row], m_uniqueHosts);
+        bindName(7, type == StartEvent ? m_events.hosts[row] : NoId, m_uniqueServers);
+        bindName(9, m_events.handles[row], m_uniqueHandles);
+        if (type == OutEvent || type == InEvent || type == DenyEvent || type == ProductEvent)
+        {
+            database.bindInteger(8, m_events.counts[row]);
+            database.bindInteger(10, m_events.reserved[row]);
+        }
+        else
         {
-            myfile << m_uniqueHosts.at(row) << "\n";
+            database.bindNull(8);
+            database.bindNull(10);
         }
-        myfile << "\n";
-        
-        // Removed Denied Events from Summary since Imaris generates a lot of denied license requests in LIC setting
-        // 
-        // size_t numberOfDenials = m_denialEvents.size();
-        // myfile << "Denials(s): (" << numberOfDenials << " Total)\n";
-        // for (size_t row = 0; row < numberOfDenials; ++row)
-        // {
-        //     for (size_t col = 1; col < 6; ++col)
-        //     {
-        //         myfile << m_denialEvents.at(row).at(col) << " ";
-        //     }
-        //     myfile << "\n";
-        // }
-        myfile.close();
+        database.insertRow();
     }
-    else
+
+    database.prepare("INSERT INTO sessions VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    for (size_t session = 0; session < m_sessions.size(); ++session)
     {
-        CannotOpenFileException cannotOpenFileException(outputFilePath);
-        throw cannotOpenFileException;
+        size_t row = m_sessions[session].checkOutRow;
+        size_t checkInRow = m_sessions[session].checkInRow;
+        const size_t ids[] = { m_events.products[row], m_events.versions[row], m_events.users[row], m_events.hosts[row] };
+        for (size_t field = 0; field < 4; ++field)
+        {
+            bindName(static_cast<int>(field + 1), ids[field], *tables[field]);
+        }
+        bindName(5, m_events.handles[row], m_uniqueHandles);
+        database.bindTime(6, m_events.timestamps[row]);
+        if (checkInRow == NoId)
+        {
+            database.bindNull(7);
+        }
+        else
+        {
+            database.bindTime(7, m_events.timestamps[checkInRow]);
+        }
+        database.bindInteger(8, m_sessions[session].duration);
+        database.insertRow();
     }
-}
-
-void LogData::writeTotalDurationHosts(const string& outputFilePath)
-{
-    ofstream myfile;
-    myfile.open (outputFilePath.c_str());
 
-    if (myfile.is_open())
+    // Every denial stands for one request unless denials were coalesced
+    database.prepare("INSERT INTO denials VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    for (size_t denial = 0; denial < m_denialRows.size(); ++denial)
     {
-        myfile << "Host,";
-        size_t columnSize = m_uniqueProducts.size();
-        for (size_t col=0; col < m_uniqueProducts.size(); ++col)
+        size_t row = m_denialRows[denial];
+        database.bindTime(1, m_events.timestamps[row]);
+        const size_t ids[] = { m_events.products[row], m_events.versions[row], m_events.users[row], m_events.hosts[row] };
+        for (size_t field = 0; field < 4; ++field)
         {
-            myfile << m_uniqueProducts.at(col) << " Duration (HH:MM:SS)";
-            if (col != columnSize-1)
-            {
-                myfile << ",";
-            }
+            bindName(static_cast<int>(field + 2), ids[field], *tables[field]);
         }
-        myfile << "\n";
-
-        for (size_t row=0; row < m_uniqueHosts.size(); ++row)
+        database.bindInteger(6, m_events.counts[row]);
+        if (denial < m_denialCounters.size())
         {
-            vector<time_duration> tempDurationVector;
-            myfile << m_uniqueHosts.at(row) << ",";
-            
-            size_t columnSize = m_uniqueProducts.size();
-            for (size_t col=0; col < columnSize; ++col)
+            const UsageCounters& counters = m_denialCounters[denial];
+            database.bindInteger(7, counters.floatingInUse);
+            database.bindInteger(8, counters.floatingLimit);
+            database.bindInteger(9, counters.reservedInUse);
+            database.bindInteger(10, counters.reservedLimit);
+        }
+        else
+        {
+            for (int column = 7; column <= 10; ++column)
             {
-                string usageDurationString = toString(m_totalDurationh.at(row).at(col));
-                myfile << usageDurationString;
-                if (col != columnSize-1)
-                {
-                    myfile << ",";
-                }
+                database.bindNull(column);
             }
-            myfile << "\n";
         }
-        myfile.close();
+        bool coalesced = denial < m_denialRepeats.size();
+        database.bindInteger(11, coalesced ? m_denialRepeats[denial] : 1);
+        database.bindTime(12, coalesced ? m_denialLastTimes[denial] : m_events.timestamps[row]);
+        database.insertRow();
     }
-    else
+
+    database.prepare("INSERT INTO usage VALUES (?, ?, ?, ?, ?, ?, ?)");
+    for (size_t usageRow = 0; usageRow < m_usageRows.size(); ++usageRow)
     {
-        CannotOpenFileException cannotOpenFileException(outputFilePath);
-        throw cannotOpenFileException;
+        long long eventTime = m_events.timestamps[m_usageRows[usageRow]];
+        for (size_t change = m_usageChangeOffsets[usageRow]; change < m_usageChangeOffsets[usageRow + 1]; ++change)
+        {
+            const UsageCounters& counters = m_usageChanges[change].counters;
+            database.bindTime(1, eventTime);
+            database.bindText(2, m_uniqueProducts.name(m_usageChanges[change].product));
+            database.bindInteger(3, counters.floatingInUse);
+            database.bindInteger(4, counters.totalInUse);
+            database.bindInteger(5, counters.floatingLimit);
+            database.bindInteger(6, counters.reservedInUse);
+            database.bindInteger(7, counters.reservedLimit);
+            database.insertRow();
+        }
     }
+
+    database.execute("CREATE INDEX events_time ON events (time);"
+                     "CREATE INDEX events_product ON events (product, time);"
+                     "CREATE INDEX events_user ON events (user);"
+                     "CREATE INDEX events_host ON events (host);"
+                     "CREATE INDEX sessions_check_out ON sessions (check_out);"
+                     "CREATE INDEX sessions_product ON sessions (product, check_out);"
+                     "CREATE INDEX sessions_user ON sessions (user);"
+                     "CREATE INDEX sessions_host ON sessions (host);"
+                     "CREATE INDEX denials_time ON denials (time);"
+                     "CREATE INDEX denials_product ON denials (product, time);"
+                     "CREATE INDEX denials_user ON denials (user);"
+                     "CREATE INDEX denials_host ON denials (host);"
+                     "CREATE INDEX usage_time ON usage (time);"
+                     "CREATE INDEX usage_product ON usage (product, time)");
+    database.close();
 }
 
-void LogData::writeTotalDurationUsers(const string& outputFilePath)
+// JSON Lines export of the events, one object per line in log order.  The
+// fields an event type does not have are left out, as in the processed
+// log: START events have their license server, DENY events their reason.
+void LogData::writeJsonEvents(const string& outputFilePath)
 {
-    ofstream myfile;
-    myfile.open (outputFilePath.c_str());
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+    const vector<string> products = jsonNames(m_uniqueProducts);
+    const vector<string> versions = jsonNames(m_uniqueVersions);
+    const vector<string> users = jsonNames(m_uniqueUsers);
+    const vector<string> hosts = jsonNames(m_uniqueHosts);
+    const vector<string> servers = jsonNames(m_uniqueServers);
+    const vector<string> handles = jsonNames(m_uniqueHandles);
+    vector<string> eventNames;
+    for (int type = OutEvent; type <= ProductEvent; ++type)
+    {
+        eventNames.push_back("{\"event\":\"" + eventTypeName(static_cast<eventType>(type)) + "\"");
+    }
 
-    if (myfile.is_open())
+    for (size_t row = 0; row < m_events.size(); ++row)
     {
-        myfile << "User,";
-        size_t columnSize = m_uniqueProducts.size();
-        for (size_t col = 0; col < m_uniqueProducts.size(); ++col)
+        eventType type = m_events.types[row];
+        out.write(eventNames[type]);
+        if (type != ProductEvent)
         {
-            myfile << m_uniqueProducts.at(col) << " Duration (HH:MM:SS)";
-            if (col != columnSize - 1)
-            {
-                myfile << ",";
-            }
+            out.write(",\"time\":\"");
+            out.writeIsoDateTime(m_events.timestamps[row]);
+            out.write('"');
         }
-        myfile << "\n";
 
-        for (size_t row = 0; row < m_uniqueUsers.size(); ++row)
+        if (type == StartEvent)
+        {
+            out.write(",\"server\":");
+            writeJsonName(out, servers, m_events.hosts[row]);
+        }
+        else if (type != ShutdownEvent)
         {
-            vector<time_duration> tempDurationVector;
-            myfile << m_uniqueUsers.at(row) << ",";
+            out.write(",\"product\":");
+            writeJsonName(out, products, m_events.products[row]);
+            out.write(",\"version\":");
+            writeJsonName(out, versions, m_events.versions[row]);
+            if (type != ProductEvent)
+            {
+                out.write(",\"user\":");
+                writeJsonName(out, users, m_events.users[row]);
+                out.write(",\"host\":");
+                writeJsonName(out, hosts, m_events.hosts[row]);
+            }
 
-            size_t columnSize = m_uniqueProducts.size();
-            for (size_t col = 0; col < columnSize; ++col)
+            // The denial reason is the count field of a DENY event
+            if (type == DenyEvent)
+            {
+                out.write(",\"reason\":");
+                out.writeInteger(m_events.counts[row]);
+            }
+            else
             {
-                string usageDurationString = toString(m_totalDurationu.at(row).at(col));
-                myfile << usageDurationString;
-                if (col != columnSize - 1)
+                out.write(",\"count\":");
+                out.writeInteger(m_events.counts[row]);
+                if (type != ProductEvent)
                 {
-                    myfile << ",";
+                    out.write(",\"handle\":");
+                    writeJsonName(out, handles, m_events.handles[row]);
                 }
+                out.write(",\"reserved\":");
+                out.writeInteger(m_events.reserved[row]);
             }
-            myfile << "\n";
         }
-
-        myfile.close();
-    }
-    else
-    {
-        CannotOpenFileException cannotOpenFileException(outputFilePath);
-        throw cannotOpenFileException;
+        out.write("}\n");
     }
+    out.close();
 }
 
-void LogData::setOutputPaths()
+// JSON Lines export of the sessions (license activity).  Sessions still
+// checked out have no check-in and last until the end of the log.
+void LogData::writeJsonSessions(const string& outputFilePath)
 {
-    m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_License_Summary.txt");
-    m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Processed_Log_File.txt");
-    m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Concurrent_License_Usage.csv");
-    if (m_fileFormat == ReportLog)
-    {
-        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_License_Activity.csv");
-        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Total_Duration_Hosts.csv");
-        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Total_Duration_Users.csv");
-        m_outputPaths.push_back(m_outputDirectory + "/" + m_inputFileName + "_LIC_Imaris_Denied_License_Requests.csv");
-    }
-}
+    BufferedWriter out(outputFilePath, false, m_reportCompression);
+    const vector<string> products = jsonNames(m_uniqueProducts);
+    const vector<string> versions = jsonNames(m_uniqueVersions);
+    const vector<string> users = jsonNames(m_uniqueUsers);
+    const vector<string> hosts = jsonNames(m_uniqueHosts);
+    const vector<string> handles = jsonNames(m_uniqueHandles);
 
-void LogData::checkForExistingFiles(string& conflictedFileList)
-{
-    for (size_t file=0; file < m_outputPaths.size(); ++file)
+    for (size_t session = 0; session < m_sessions.size(); ++session)
     {
-        if (fileExists(m_outputPaths.at(file)))
+        size_t row = m_sessions[session].checkOutRow;
+        out.write("{\"product\":");
+        writeJsonName(out, products, m_events.products[row]);
+        out.write(",\"version\":");
+        writeJsonName(out, versions, m_events.versions[row]);
+        out.write(",\"user\":");
+        writeJsonName(out, users, m_events.users[row]);
+        out.write(",\"host\":");
+        writeJsonName(out, hosts, m_events.hosts[row]);
+        out.write(",\"handle\":");
+        writeJsonName(out, handles, m_events.handles[row]);
+        out.write(",\"check_out\":\"");
+        out.writeIsoDateTime(m_events.timestamps[row]);
+        if (m_sessions[session].checkInRow != NoId)
         {
-            conflictedFileList.append(m_outputPaths.at(file));
-            conflictedFileList.append("\n");
+            out.write("\",\"check_in\":\"");
+            out.writeIsoDateTime(m_events.timestamps[m_sessions[session].checkInRow]);
         }
+        out.write("\",\"duration\":");
+        out.writeInteger(m_sessions[session].duration);
+        out.write("}\n");
     }
-}
-
-void LogData::publishResults()
-{
-    writeSummaryData(m_outputPaths.at(0));
-    
-    
-     write2DVectorToFile(m_outputPaths.at(2), m_usage, ",");
-    
-
-    if (m_fileFormat == ReportLog)
-    {
-        write2DVectorToFile(m_outputPaths.at(3), m_usageDurationh, ",");
-        write2DVectorToFile(m_outputPaths.at(6), m_deniedRequest, ",");
-        writeTotalDurationHosts(m_outputPaths.at(4));
-        writeTotalDurationUsers(m_outputPaths.at(5));
-     }
-}
-
-void LogData::publishEventDataResults()
-{
-    write2DVectorToFile(m_outputPaths.at(1), m_eventData, " ");
+    out.close();
 }
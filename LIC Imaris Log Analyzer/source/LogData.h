@@ -22,11 +22,45 @@
 
 #pragma once
 
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <tuple>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include "Utilities.h"
+#include "StringInterner.h"
+#include "EventStore.h"
+#include "ThreadPool.h"
+#include "PipelineStage.h"
+#include "FlatHashMap.h"
+#include "Checkpoint.h"
+#include "EventCache.h"
+#include "SessionIndex.h"
+#include "ServerRuns.h"
+#include "SparseTotals.h"
+#include "DurationHistograms.h"
+#include "UsageHeatmap.h"
+#include "LicenseSaturation.h"
+#include "EventTotals.h"
+#include "SustainedPeaks.h"
+#include "LongestSessions.h"
+#include "VersionUsage.h"
+#include "ForgottenSessions.h"
+#include "DemandProfile.h"
+#include "GroupMapping.h"
+#include "ReorderBuffer.h"
+#include "UsageRollups.h"
+#include "PipelineStats.h"
+#include "ChunkTuner.h"
+#include "ProgressReporter.h"
+#include "BufferedWriter.h"
+#include "Compression.h"
 
 using namespace std;
 using namespace boost::posix_time;
@@ -39,125 +73,898 @@ enum fileFormat
     ISVLog
 };
 
+// A license checkout: the OUT row and the IN or SHUTDOWN row that ended it
+// (NoId while still checked out), with its duration in seconds
+struct Session
+{
+    size_t checkOutRow;
+    size_t checkInRow;
+    long long duration;
+};
+
+// The five counters the concurrent usage report shows for a product.  They
+// are kept as fixed-width integers and formatted only by the writers.
+struct UsageCounters
+{
+    UsageCounters() : floatingInUse(0), totalInUse(0), floatingLimit(0), reservedInUse(0), reservedLimit(0) {}
+    bool operator!=(const UsageCounters& other) const
+    {
+        return floatingInUse != other.floatingInUse || totalInUse != other.totalInUse ||
+               floatingLimit != other.floatingLimit || reservedInUse != other.reservedInUse ||
+               reservedLimit != other.reservedLimit;
+    }
+
+    int32_t floatingInUse;
+    int32_t totalInUse;
+    int32_t floatingLimit;
+    int32_t reservedInUse;
+    int32_t reservedLimit;
+};
+
+// New counters of one product at a row of the concurrent usage timeline
+struct UsageChange
+{
+    size_t product;
+    UsageCounters counters;
+};
+
+// The denials of a product in an hour of the log, and how many of them came
+// while all its floating licenses were in use
+struct HourlyDenials
+{
+    HourlyDenials() : denials(0), atLimit(0) {}
+
+    uint64_t denials;
+    uint64_t atLimit;
+};
+
+// The sessions of a product billed to a group and their seconds, those on
+// reserved licenses among them, and the same of the closed sessions, which
+// alone go into a checkpoint
+struct ChargebackTotals
+{
+    ChargebackTotals() : sessions(0), seconds(0), reservedSeconds(0), closedSessions(0), closedSeconds(0),
+                         closedReservedSeconds(0) {}
+
+    uint64_t sessions;
+    long long seconds;
+    long long reservedSeconds;
+    uint64_t closedSessions;
+    long long closedSeconds;
+    long long closedReservedSeconds;
+};
+
+// Checkpoint of the concurrent usage timeline, taken every
+// UsageSnapshotInterval entries.  counters is the state before the first
+// entry of the block and maxima the largest counters after any entry of
+// it.  time is the latest event time up to the first entry, which keeps
+// the snapshots sorted even where the log's clock went back.
+struct UsageSnapshot
+{
+    long long time;
+    vector<UsageCounters> counters;
+    vector<UsageCounters> maxima;
+};
+
+const size_t UsageSnapshotInterval = 256;
+
+// Why a line of the log could not be read as its event
+enum invalidLineReason
+{
+    MissingFields,
+    InvalidDateTime
+};
+
+// A line skipped by a lenient parse (see LogData::invalidLines).  Within an
+// EventChunk line is the chunk's own row, in the log data the line number.
+struct InvalidLine
+{
+    uint64_t line;
+    invalidLineReason reason;
+};
+
+// Event of a chunk that comes before the chunk's first dated line, so its
+// year is only known once the previous chunks are parsed.  dateTime.year
+// holds the number of Jan 1 rollovers seen in the chunk up to the event.
+struct PendingTimestamp
+{
+    size_t eventRow;
+    DateTime dateTime;
+};
+
+// The time range, in seconds since the epoch, an analysis is limited to:
+// from is the first second in it, to the first one after it
+struct DateRange
+{
+    DateRange() : from(LLONG_MIN), to(LLONG_MAX) {}
+    DateRange(long long rangeFrom, long long rangeTo) : from(rangeFrom), to(rangeTo) {}
+    bool bounded() const
+    {
+        return from != LLONG_MIN || to != LLONG_MAX;
+    }
+
+    long long from;
+    long long to;
+};
+
+// Names of one field an analysis is limited to: the listed ones, or with
+// exclude all but the listed ones.  An empty list selects every name.
+struct NameFilter
+{
+    NameFilter() : exclude(false) {}
+
+    vector<string> names;
+    bool exclude;
+};
+
+// The products, users and hosts an analysis is limited to.  With a
+// denialWindow of more than 0 seconds, a denial that comes at most that long
+// after the last one of the same user, host, product and reason is merged
+// into it instead of being kept as an event of its own.  With a
+// reorderWindow of more than 0 seconds, events up to that late are put back
+// in time order (see ReorderBuffer).  The forgotten policy tells the
+// sessions the forgotten sessions report flags.
+struct EventFilter
+{
+    EventFilter() : denialWindow(0), reorderWindow(0) {}
+
+    bool active() const
+    {
+        return ! products.names.empty() || ! users.names.empty() || ! hosts.names.empty();
+    }
+
+    NameFilter products;
+    NameFilter users;
+    NameFilter hosts;
+    long long denialWindow;
+    long long reorderWindow;
+    ForgottenPolicy forgotten;
+};
+
+// The fields of an EventFilter, in the order LogData tests them
+enum filterField
+{
+    FilterProducts,
+    FilterUsers,
+    FilterHosts,
+    FilterFields
+};
+
+// Events parsed from one run of lines of the log, with its own name tables.
+// Chunks are parsed independently and then appended to the log's event
+// store in order.  Only the first chunk knows the year it starts in.
+struct EventChunk
+{
+    EventChunk() : endTimeRow(NoId), yearKnown(false), eventYear(0), eventMonth(0), lineBreaks(0), pastRangeEnd(false),
+                   filteredEndTime(LLONG_MIN), filteredEndPending(false), droppedEvents() {}
+
+    // The lines it is parsed from, and the events with the name columns
+    // holding the ids of LogData's parsed-name interners
+    string_view text;
+    EventStore events;
+    vector<size_t> denialRows;
+    vector<size_t> shutdownRows;
+    vector<size_t> startRows;
+    vector<size_t> checkOutRows;
+    vector<size_t> checkInRows;
+    size_t endTimeRow;
+    string serverName;
+    bool yearKnown;
+    int eventYear;
+    // Month of the last dated line, 0 while the chunk has not seen one
+    int eventMonth;
+    vector<PendingTimestamp> pendingTimestamps;
+    vector<InvalidLine> invalidLines;
+    // The row of every event, and the offset in the chunk's text of every
+    // LineIndexStride-th row (see LogData::readLogLine)
+    vector<size_t> eventLines;
+    vector<pair<size_t, size_t> > lineOffsets;
+    uint64_t lineBreaks;
+    // Set when the chunk stopped at an event after the date range
+    bool pastRangeEnd;
+    // Time of the last event the filter left out, or its date while the
+    // year is pending; LLONG_MIN if none
+    long long filteredEndTime;
+    bool filteredEndPending;
+    DateTime filteredEndDateTime;
+    // The parsed-name ids of the products, versions, users and hosts the
+    // chunk's events named, while only the names of its license events are
+    // kept (see LogData::namesNew)
+    vector<bool> namedIds[4];
+    // The license events dropped for a summary alone, by type, and the
+    // denials among them by parsed-name product id
+    uint64_t droppedEvents[DenyEvent + 1];
+    vector<uint64_t> droppedDenials;
+};
+
+// What a read of a followed log found (see LogData::readAppendedLines)
+enum followResult
+{
+    NoNewLines,
+    LinesAppended,
+    LogRestarted
+};
+
+// How much of the log the constructor analyzes.  A check for existing
+// results needs only the output paths, and the processed log file only the
+// events.  The reports a narrower scope did not analyze are not published.
+enum analysisScope
+{
+    FullAnalysis,
+    EventsOnly,
+    OutputPathsOnly
+};
+
+// The reports of an analysis, one bit each in the order of the output
+// paths.  The analysis skips the stages no selected report needs: the
+// concurrent usage is only built for its report, the sessions only for the
+// license activity, the total durations, the top usage and the version
+// usage, and the host and user totals only for the reports that list them.
+// The session durations alone are counted as the sessions are paired,
+// without keeping the sessions, and the usage heatmap, license saturation
+// and sustained peaks alone are found by the usage pass without keeping its
+// timeline.  The usage pass also takes the counters at every denial for the
+// denied requests.  The summary alone keeps only the names of the OUT, IN
+// and DENY events, not the events.
+enum reportSelection
+{
+    SummaryReport = 1 << 0,
+    ProcessedLogReport = 1 << 1,
+    ConcurrentUsageReport = 1 << 2,
+    LicenseActivityReport = 1 << 3,
+    TotalDurationHostsReport = 1 << 4,
+    TotalDurationUsersReport = 1 << 5,
+    DeniedRequestsReport = 1 << 6,
+    SessionDurationsReport = 1 << 7,
+    UsageHeatmapReport = 1 << 8,
+    LicenseSaturationReport = 1 << 9,
+    HourlyDenialsReport = 1 << 10,
+    SustainedPeaksReport = 1 << 11,
+    TopUsageReport = 1 << 12,
+    VersionUsageReport = 1 << 13,
+    ReservedUsageReport = 1 << 14,
+    ForgottenSessionsReport = 1 << 15,
+    DemandProfileReport = 1 << 16,
+    AllReports = (1 << 17) - 1,
+    // The reports the analyzer wrote before the others were added, which a
+    // run without a selection still writes alone
+    DefaultReports = SummaryReport | ProcessedLogReport | ConcurrentUsageReport | LicenseActivityReport |
+                     TotalDurationHostsReport | TotalDurationUsersReport | DeniedRequestsReport
+};
+
+enum usageFormat
+{
+    WideUsage,  // one row per event, five columns per product
+    LongUsage   // one row per changed product and event
+};
+
+// The calendar periods the time-ordered reports can be split into, one
+// file per period (see setOutputPartition)
+enum outputPartition
+{
+    NoPartition,
+    WeekPartition,  // weeks starting on Monday, as in the usage heatmap
+    MonthPartition
+};
+
 class LogData
 {
     public:
-        LogData(const string& inputFilePath, const string& outputDirectory);
+        // With a pool, large files are parsed in chunks on its threads.  An
+        // incremental analysis resumes from the checkpoint the last one left
+        // next to the reports, appends to them and saves a new checkpoint.
+        // With the event cache, the parsed events are saved next to the log
+        // and later analyses of the unchanged log start from them.  Only
+        // the selected reports are analyzed, checked for and published (see
+        // reportSelection); an output directory of StandardOutputPath writes
+        // them to the standard output, one after the other.  An incremental
+        // analysis is always a full one of all reports, unless only its
+        // output paths are asked for.  Up to invalidLineBudget lines that
+        // are too short for their event or have no valid date and time are
+        // skipped and listed (see invalidLines); the next one throws an
+        // EventDataException, as the first one does without a budget.  A
+        // bounded date range limits a non-incremental analysis to the
+        // events in it (see applyDateRange), and an active event filter to
+        // the events of its products, users and hosts (see selectsEvent).
+        LogData(const string& inputFilePath,
+                const string& outputDirectory,
+                ThreadPool* pool = NULL,
+                bool incremental = false,
+                bool useEventCache = false,
+                analysisScope scope = FullAnalysis,
+                unsigned int reports = AllReports,
+                size_t invalidLineBudget = 0,
+                const DateRange& dateRange = DateRange(),
+                const EventFilter& eventFilter = EventFilter());
+
+        // Staged use as a library, without reports: the constructor only
+        // opens the log and checks its format, parse() extracts the events
+        // and analyze() builds the results the selected reports would show
+        // (see reportSelection) for the queries below.  Each stage runs
+        // once and runs the ones before it if they have not run yet.
+        explicit LogData(const string& inputFilePath, ThreadPool* pool = NULL);
+        void parse(bool useEventCache = false,
+                   size_t invalidLineBudget = 0,
+                   const DateRange& dateRange = DateRange(),
+                   const EventFilter& eventFilter = EventFilter());
+        void analyze(unsigned int results = AllReports);
         ~LogData() {}
         void checkForExistingFiles(string& conflictedFiles);
         void publishResults();
         void publishEventDataResults();
+        void publishAllResults();
+        void publishAllResults(ThreadPool& pool);
+        // Writes the selected reports to one stream instead of their files,
+        // e.g. StandardOutputPath or a named pipe, as they are produced.  A
+        // file or pipe takes a single report; the next one would replace it.
+        void setReportDestination(const string& destination);
+        // Writes only these of the selected reports (all of them by
+        // default), while the analysis still covers every selected one, e.g.
+        // for the exports and the checkpoint
+        void setWrittenReports(unsigned int reports);
+        // Adds the floating and reserved licenses in use and their limits of
+        // the product at every denial to the denied requests report.  An
+        // incremental analysis appends to the plain layout, so it leaves them out.
+        void setDenialUsage(bool denialUsage);
+        // Writes the reports gzip or zstd compressed, with .gz or .zst added
+        // to their names.  An incremental analysis appends to plain reports,
+        // so it keeps them uncompressed.
+        void setReportCompression(compressionFormat compression);
+        void setConcurrentUsageFormat(usageFormat format);
+        void setUsageBucketWidth(long long bucketSeconds);
+        // Splits the processed log, concurrent usage, license activity and
+        // denied requests into one file per week or month, named after its
+        // first day, e.g. _Concurrent_License_Usage_2023-11.csv.  The files
+        // of the periods are written in parallel.  The other reports cover
+        // the whole log; an incremental analysis or a report written to a
+        // stream is not split.
+        void setOutputPartition(outputPartition partition);
+        void setArrowExport(bool arrowExport);
+        // Adds the SQLite database of the events, sessions, denials and
+        // concurrency timeline (see SqliteDatabase) to the outputs
+        void setSqliteExport(bool sqliteExport);
+        // Adds the JSON Lines exports of the events and sessions, one object
+        // per line for log search ingestion, to the outputs
+        void setJsonExport(bool jsonExport);
         size_t fileFormat();
-    private:
-        void findFileFormat();
-        void setOutputPaths();
-        void extractEvents();
-        void getEventIndices();
-        void addYearToDate();
-        void standardizeLogFormatting();
-        void loadEventIntoVector(const vector<string>& allDataRow,
-                                 const size_t row,
-                                 const vector<size_t>& indices);
-        void getConcurrentUsage();
-        int getCountOffset(const size_t& row);
-        void gatherConcurrentUsageData(const size_t& row,
-                                       const vector<string>& licenseUsageCount,
-                                       const vector<size_t>& uniqueLicenseCountsByProduct,
-                                       const vector<string>& maxLicenseUsageCount,
-                                       const vector<string>& reservedLicenseUsageCount,
-                                       const vector<string>& maxreservedLicenseCountsByProduct);
-        void getUsageDurationUser();
-        void getUsageDurationHost();
-        void getDeniedRequests();
-        size_t getIndex(const string& name, const vector<string>& list);
 
-        void writeSummaryData(const string& outputFilePath);
-        void writeTotalDurationUsers(const string& outputFilePath);
-        void writeTotalDurationHosts(const string& outputFilePath);
+        // Results for combining several logs (see BatchSummary)
+        const string& inputFilePath() const;
+        const string& serverName() const;
+        // The RLM server version from the report log header, e.g. "14.2 BL2"
+        const string& rlmVersion() const;
+        const StringInterner& uniqueProducts() const;
+        const StringInterner& uniqueUsers() const;
+        const StringInterner& uniqueHosts() const;
+        const StringInterner& uniqueVersions() const;
+        const SparseTotals& totalDurationHosts() const;
+        const SparseTotals& totalDurationUsers() const;
+        // Seconds of use by product and in all, of the sessions in the
+        // duration reports
+        void totalDurationProducts(vector<long long>& durations) const;
+        long long totalDuration() const;
+        // Lengths of the closed sessions of every product, for the
+        // percentiles of the session durations report
+        const DurationHistograms& sessionDurations() const;
+        // Floating licenses in use by product and hour of the week, for the
+        // usage heatmap report
+        const UsageHeatmap& usageHeatmap() const;
+        // Times products had all their floating licenses in use, for the
+        // license saturation report
+        const LicenseSaturation& licenseSaturation() const;
+        // Floating licenses in use by product sustained over 15, 30 and 60
+        // minutes, for the sustained peaks report
+        const SustainedPeaks& sustainedPeaks() const;
+        // The longest sessions of every product, those still checked out
+        // included, for the top usage report
+        const LongestSessions& longestSessions() const;
+        // Check-outs in use at once and sessions by product and version,
+        // for the version usage report
+        const VersionUsage& versionUsage() const;
+        // Sessions held through the off-hours or too long by user and
+        // product, for the forgotten sessions report
+        const ForgottenSessions& forgottenSessions() const;
+        // Check-outs, check-ins, denials and holding times by product and
+        // hour of the week, for the demand profile report
+        const DemandProfile& demandProfile() const;
+        // Day, week and month rollups of the whole log, built by a full
+        // analysis that uses the event cache and kept with it; empty
+        // otherwise
+        const UsageRollups& rollups() const;
+        // The time the sessions still open run until, which the sustained
+        // peaks are counted up to
+        long long endTime() const;
+        // What a catalog of logs records of this one (see LogCatalog).
+        // Returns false unless all its events were parsed: not by an
+        // incremental analysis, with an event filter, merged denials or up
+        // to the end of a date range.  Events of the event cache are all
+        // there before the date range leaves some out.
+        bool catalogEntry(CatalogEntry& entry) const;
+        // The counters of the denied product at every denial, in the order
+        // of denialRows(), and the denials by hour (its start) and product
+        const vector<UsageCounters>& denialCounters() const;
+        const map<pair<long long, size_t>, HourlyDenials>& hourlyDenials() const;
+        // With coalesced denials, the requests every denial stands for and
+        // the time of its last one, in the order of denialRows(); empty
+        // otherwise
+        const vector<uint32_t>& denialRepeats() const;
+        const vector<long long>& denialLastTimes() const;
+        size_t startCount() const;
+        size_t shutdownCount() const;
+        size_t sessionCount() const;
+        size_t denialCount() const;
+        // The events by type, first event time and denied requests by
+        // product, kept up to date while the events are read
+        const EventTotals& eventTotals() const;
+
+        // The lines a lenient parse skipped, in the order of the log
+        const vector<InvalidLine>& invalidLines() const;
 
-        // Methods that tweak the log format
-        // mainly for deprecated ISV quirks
-        void reformatEventName(const size_t row,
-                               const string newLabel);
+        // The raw log behind the events, for a drill-down from a session or
+        // denial.  The line of an event is 1-based, and 0 for the events of
+        // the event cache or a checkpoint, which were not parsed from the
+        // log.  A line is read back from the log file, found through the
+        // offset of every LineIndexStride-th line parsed; readLogLine
+        // returns false for a line that was not parsed or a compressed log.
+        uint64_t eventLine(size_t row) const;
+        bool readLogLine(uint64_t line, string& text) const;
 
-        void reformatUserHost(const size_t row,
-                              const vector<size_t>& indices);
+        // Wall and CPU time, bytes, events and peak memory of every stage of
+        // the analysis and of every report written
+        const PipelineStats& stats() const;
 
-        void reformatProductVersion(const size_t row,
-                                    const size_t col,
-                                    vector<string>& allDataRow);
+        // Extracted events, in the order of the log (see CombinedUsage)
+        const EventStore& events() const;
 
-        void reformatToken(vector<string>& allDataRow);
+        // Analysis results for queries (see QueryService).  Sessions still
+        // checked out have checkInRow NoId and last until the end of the log.
+        // The usage queries search the snapshots of the timeline and replay
+        // at most one block of it.
+        const vector<Session>& sessions() const;
+        const SessionIndex& sessionIndex() const;
+        const vector<size_t>& denialRows() const;
+        const ServerRuns& serverRuns() const;
+        const StringInterner& uniqueServers() const;
+        void usageAt(long long timestamp, vector<UsageCounters>& counters) const;
+        void peakUsage(long long from, long long to, vector<UsageCounters>& maxima) const;
 
-        void removeInDetails(const size_t row,
-                              vector<string>& allDataRow);
+        // Follow mode (see LogFollower).  Only an incremental analysis reads
+        // whole lines, so only such a log data can follow its log.
+        followResult readAppendedLines();
+        const vector<UsageCounters>& currentUsage() const;
 
-        void removeNoGood(const size_t row,
-                          vector<string>& allDataRow);
+        // The concurrent usage timeline, one row per event that changed the
+        // counters, with the products it changed
+        size_t usageRowCount() const;
+        long long usageRowTime(size_t usageRow) const;
+        // The first entry later than timestamp, or usageRowCount()
+        size_t firstUsageRowAfter(long long timestamp) const;
+        void usageRowChanges(size_t usageRow, vector<UsageChange>& changes) const;
 
-        void licenseCountAdjust(vector<size_t>& licenseCountNumbers,
-                        vector<string>& licenseCountsByProduct);
+        // The columns of the timeline itself, e.g. to hand them out without
+        // a copy: the event row of every entry, the offset of its first
+        // change (plus the end of the last) and the changes
+        const vector<size_t>& usageRows() const;
+        const vector<size_t>& usageChangeOffsets() const;
+        const vector<UsageChange>& usageChanges() const;
+    private:
+        void findFileFormat();
+        void readReportLogHeader(string_view header);
+        void publishReports(bool includeEventData,
+                            bool includeReports = true,
+                            ThreadPool* sharedPool = NULL);
+        void initialize(const string& inputFilePath,
+                        const string& outputDirectory,
+                        ThreadPool* pool,
+                        bool incremental,
+                        bool useEventCache,
+                        analysisScope scope,
+                        unsigned int reports,
+                        size_t invalidLineBudget,
+                        const DateRange& dateRange,
+                        const EventFilter& eventFilter);
+        void setOutputPaths();
+        bool openInput();
+        void analyzeLog();
+        void extractLog(bool pipelineUsage = false);
+        bool canPipelineUsage() const;
+        void finishUsagePipeline();
+        void pushUsageBatch();
+        void describeLog(bool wholeLog, bool cached);
+        void applyDateRange();
+        bool beforeDateRange(const EventChunk& chunk, size_t eventRow) const;
+        bool afterDateRange(const EventChunk& chunk, size_t eventRow) const;
+        void setEventFilter(const EventFilter& eventFilter);
+        bool selectsName(filterField field, string_view name) const;
+        template <eventType Type>
+        bool selectsEvent(const vector<string_view>& allDataRow) const;
+        bool recountsUsage() const;
+        bool keepsLicenseEvents() const;
+        void recountSelectedUsage();
+        void keepFilteredEndTime(size_t eventRow, EventChunk& chunk);
+        void analyzeEvents();
+        bool reportSelected(unsigned int reports) const;
+        bool reportWritten(unsigned int reports) const;
+        bool loadEventCache();
+        bool saveEventCache();
+        bool loadRollupCache();
+        void buildRollups();
+        void saveRollupCache();
+        void resetAnalysis();
+        void releaseInput();
+        void releaseUsageCounters();
+        bool countsUsage() const;
+        void listReservedCounts(vector<CheckpointEntry>& counts) const;
+        void accountMemory(const string& stage);
+        void sizeForLog(string_view text, uint64_t textBytes);
+        void reserveUsageTimeline(size_t entries);
+        size_t usageEventsBetween(size_t firstRow, size_t endRow) const;
+        void resumeFromCheckpoint();
+        bool canAppendReports();
+        void saveCheckpoint();
+        void extractEvents(ThreadPool* pool, ChunkTuning* tuning = NULL);
+        void extractChunks(const vector<string_view>& texts, uint64_t firstOffset, ThreadPool* pool);
+        void extractChunks(function<bool(string_view&)> nextText, uint64_t firstOffset, ThreadPool* pool, size_t window,
+                           ChunkTuner* tuner);
+        void extractBlockEvents(ThreadPool* pool);
+        void extractChunk(string_view text, EventChunk& chunk);
+        size_t fieldsToTokenize(string_view line) const;
+        void extractEvent(const vector<string_view>& allDataRow,
+                          const size_t row,
+                          EventChunk& chunk);
+        void clearParsedNames();
+        void appendChunk(EventChunk& chunk, int& eventYear);
+        void coalesceDenials(size_t firstRow, size_t previousEndTimeRow);
+        bool namesNew(EventChunk& chunk, size_t eventRow) const;
+        void dropLicenseEvents(size_t firstRow, size_t previousEndTimeRow);
+        void removeRows(size_t firstRow, size_t previousEndTimeRow, const vector<bool>& removed);
+        void countEvents(const EventChunk& chunk, size_t firstRow);
+        void recountEvents();
+        void listLicenseRows();
+        void indexServerRuns();
+        void reorderEvents(size_t firstRow);
+        void recordInvalidLines(const EventChunk& chunk, uint64_t firstLine);
+        void indexLines(const EventChunk& chunk, uint64_t firstLine, uint64_t firstOffset);
+        bool setEventTimestamp(string_view dateString,
+                               string_view timeString,
+                               const size_t eventRow,
+                               EventChunk& chunk);
+        bool hasEventFields(const vector<string_view>& allDataRow, eventType type) const;
+        template <eventType Type>
+        size_t loadLicenseEvent(const vector<string_view>& allDataRow,
+                                const size_t row,
+                                EventChunk& chunk);
+        // Where a run of the concurrent usage pass counts the products
+        // [firstProduct, endProduct) to: the log's own tables, or those of
+        // one shard of a parallel pass.  Only one run records the timeline
+        // rows, and the rows that closed saturation intervals are only
+        // recorded where shards are merged.
+        struct UsagePass
+        {
+            size_t firstProduct;
+            size_t endProduct;
+            UsageHeatmap* heatmap;
+            SustainedPeaks* peaks;
+            LicenseSaturation* saturation;
+            VersionUsage* versions;
+            vector<size_t>* saturationRows;
+            vector<size_t>* usageRows;
+            vector<size_t>* usageChangeOffsets;
+            vector<UsageChange>* usageChanges;
+            vector<size_t>* heldLicenseCounts;
+            vector<size_t>* reservedCheckOuts;
+            map<pair<long long, size_t>, HourlyDenials>* hourlyDenials;
+        };
+        void getConcurrentUsage();
+        void startConcurrentUsage();
+        void updateConcurrentUsage(size_t firstRow);
+        bool canShardUsage() const;
+        void shardConcurrentUsage();
+        void layOutUsage(size_t numberOfProducts, size_t numberOfUsers);
+        size_t addDenialCounters(size_t firstRow, size_t endRow);
+        void countUsage(size_t firstRow, size_t endRow, size_t numberOfProducts, size_t numberOfUsers);
+        void countUsageRows(UsagePass& pass, size_t firstRow, size_t endRow, size_t numberOfProducts, size_t denial);
+        void listHeldLicenseCounts();
+        int getCountOffset(const size_t& row);
+        void gatherConcurrentUsageData(UsagePass& pass,
+                                       const size_t& row,
+                                       const vector<UsageCounters>& counters,
+                                       vector<UsageCounters>& recordedCounters);
+        void indexConcurrentUsage();
+        void usageBefore(size_t usageRow, vector<UsageCounters>& counters) const;
+        void applyUsageChanges(size_t usageRow, vector<UsageCounters>& counters) const;
+        template <typename Visit>
+        void forLicenseRows(Visit visit) const;
+        template <typename CheckOut, typename CheckIn>
+        void pairSessions(CheckOut checkOut, CheckIn checkIn, size_t shard = 0, size_t shards = 1) const;
+        bool canShardSessions() const;
+        void shardSessions();
+        void getSessions();
+        void resolveGroups();
+        void startChargeback();
+        size_t chargebackGroup(size_t checkOutRow) const;
+        bool reservedCheckOut(size_t checkOutRow, size_t& nextReserved) const;
+        void getTotalDurations();
+        void collectDurations(const vector<CheckpointEntry>& checkpointDurations,
+                              const vector<size_t>& rowColumn,
+                              bool closedOnly,
+                              vector<CheckpointEntry>& durations) const;
 
-        void checkForValidProductVersion(const size_t row,
-                                         const size_t col,
-                                         vector<string>& allDataRow);
+        void writeSummaryData(const string& outputFilePath);
+        void writeUsageDuration(const string& outputFilePath);
+        void writeDeniedRequests(const string& outputFilePath);
+        void writeConcurrentUsage(const string& outputFilePath);
+        void writeConcurrentUsageLong(const string& outputFilePath);
+        void writeConcurrentUsageBuckets(const string& outputFilePath);
+        string concurrentUsagePath();
+        string usageBucketsPath();
+        string chargebackPath();
+        vector<string> arrowPaths();
+        void writeArrowEvents(const string& outputFilePath);
+        void writeArrowSessions(const string& outputFilePath);
+        void writeArrowUsage(const string& outputFilePath);
+        string sqlitePath();
+        void writeSqliteDatabase(const string& outputFilePath);
+        vector<string> jsonPaths();
+        void writeJsonEvents(const string& outputFilePath);
+        void writeJsonSessions(const string& outputFilePath);
+        void writeRowRanges(BufferedWriter& out, size_t firstRow, size_t endRow,
+                            const function<void(BufferedWriter&, size_t, size_t)>& writeRows);
+        bool partitionsReports() const;
+        string partitionPath(const string& outputFilePath, long long periodStart) const;
+        void writeTimeOrdered(const string& outputFilePath, size_t firstRow, size_t endRow,
+                              const function<long long(size_t)>& rowTime,
+                              const function<void(BufferedWriter&)>& writeHeader,
+                              const function<void(BufferedWriter&, size_t, size_t)>& writeRows);
+        void writePartitions(const string& outputFilePath, size_t firstRow, size_t endRow,
+                             const function<long long(size_t)>& rowTime,
+                             const function<void(BufferedWriter&)>& writeHeader,
+                             const function<void(BufferedWriter&, size_t, size_t)>& writeRows);
+        void writeEventData(const string& outputFilePath);
+        void writeEventRow(BufferedWriter& out, size_t row) const;
+        void writeTotalDurationUsers(const string& outputFilePath);
+        void writeTotalDurationHosts(const string& outputFilePath);
+        void writeSessionDurations(const string& outputFilePath);
+        void writeUsageHeatmap(const string& outputFilePath);
+        void writeLicenseSaturation(const string& outputFilePath);
+        void writeSustainedPeaks(const string& outputFilePath);
+        void writeTopUsage(const string& outputFilePath);
+        void writeVersionUsage(const string& outputFilePath);
+        void writeChargeback(const string& outputFilePath);
+        void writeReservedUsage(const string& outputFilePath);
+        void writeForgottenSessions(const string& outputFilePath);
+        void writeDemandProfile(const string& outputFilePath);
+        void writeHourlyDenials(const string& outputFilePath);
 
-        void checkForUnhandledINDetails(const size_t row);
+        // ISV logs are read through the report log parser (see projectIsvLine)
+        int isvLogYear(string_view firstDate) const;
+        bool projectIsvLine(const vector<string_view>& isvTokens, vector<string_view>& reportRow) const;
+        template <eventType Type>
+        void projectIsvLicenseEvent(const vector<string_view>& isvTokens,
+                                    string_view keyword,
+                                    vector<string_view>& reportRow) const;
 
         string m_inputFilePath;
         string m_inputFileName;
         string m_outputDirectory;
         enum fileFormat m_fileFormat;
         vector<string> m_outputPaths;
-        vector<string> m_rawData;
-        vector< vector<string> > m_allData;
-        vector< vector<string> > m_eventData;
-        vector< vector<string> > m_denialEvents;
-        vector< vector<string> > m_shutdownEvents;
-        vector< vector<string> > m_startEvents;
-        vector<string> m_uniqueProducts;
-        vector<string> m_uniqueUsers;
-        vector<string> m_uniqueHosts;
+        // A compressed log, or one read ahead, is not mapped but read in
+        // blocks while it is parsed
+        MappedFile m_inputFile;
+        compressionFormat m_compression;
+        bool m_blockInput;
+        EventStore m_events;
+        vector<size_t> m_denialRows;
+        vector<UsageCounters> m_denialCounters;
+        map<pair<long long, size_t>, HourlyDenials> m_hourlyDenials;
+        vector<size_t> m_shutdownRows;
+        vector<size_t> m_startRows;
+        // The rows of the OUTs and INs, which the session pass walks with
+        // the STARTs and SHUTDOWNs instead of every event
+        vector<size_t> m_checkOutRows;
+        vector<size_t> m_checkInRows;
+        // The runs of the server between the STARTs and SHUTDOWNs, indexed
+        // once the events of a read are in place
+        ServerRuns m_serverRuns;
+        StringInterner m_uniqueProducts;
+        StringInterner m_uniqueUsers;
+        StringInterner m_uniqueHosts;
+        StringInterner m_uniqueVersions;
+        StringInterner m_uniqueHandles;
+        StringInterner m_uniqueServers;
+
+        // The names the parser threads intern while the chunks of one read
+        // are parsed, and the log id of each of their ids, NoId until an
+        // appended event has it
+        SharedInterner m_parsedProducts;
+        SharedInterner m_parsedVersions;
+        SharedInterner m_parsedUsers;
+        SharedInterner m_parsedHosts;
+        SharedInterner m_parsedHandles;
+        SharedInterner m_parsedServers;
+        vector<size_t> m_parsedIds[6];
         
-        string m_eventYear;
+        int m_eventYear;
         string m_serverName;
+        string m_rlmVersion;
+
+        vector<Session> m_sessions;
+
+        // Built on the first query, reports do not need it
+        mutable SessionIndex m_sessionIndex;
+        mutable bool m_sessionIndexBuilt;
+        enum usageFormat m_usageFormat;
+        long long m_usageBucketSeconds;
+        enum outputPartition m_outputPartition;
+
+        // Concurrent usage timeline, delta encoded: entry i is the state after
+        // event m_usageRows[i] and changes the products listed in
+        // m_usageChanges[m_usageChangeOffsets[i], m_usageChangeOffsets[i+1])
+        vector<size_t> m_usageRows;
+        vector<size_t> m_usageChangeOffsets;
+        vector<UsageChange> m_usageChanges;
 
-        size_t m_eventIndex;
-        vector<size_t> m_OUTindices;
-        vector<size_t> m_INindices;
-        vector<size_t> m_DENYindices;
-        vector<size_t> m_STARTindices;
-        vector<size_t> m_SHUTindices;
-        vector<size_t> m_PRODUCTindices;
-
-        vector< vector<string> > m_usage;
-        vector< vector<string> > m_usageDuration;
-        vector< vector<string> > m_usageDurationh;
-        vector< vector<string> > m_usageDurationu;
-        vector< vector<string> > m_deniedRequest;
-        vector< vector<time_duration> > m_totalDuration;
-        vector< vector<time_duration> > m_totalDurationh;
-        vector< vector<time_duration> > m_totalDurationu;
+        // Snapshots of the timeline for the usage queries, and the state
+        // and latest time after the m_indexedUsageRows entries they cover
+        vector<UsageSnapshot> m_usageSnapshots;
+        vector<UsageCounters> m_indexedCounters;
+        long long m_indexedUsageTime;
+        size_t m_indexedUsageRows;
+        SparseTotals m_totalDurationh;
+        SparseTotals m_totalDurationu;
+        DurationHistograms m_sessionDurations;
+        UsageHeatmap m_usageHeatmap;
+        LicenseSaturation m_licenseSaturation;
+        EventTotals m_eventTotals;
+        SustainedPeaks m_sustainedPeaks;
+        // The closed ones alone are carried over by the checkpoint
+        LongestSessions m_longestSessions;
+        LongestSessions m_longestClosedSessions;
+        VersionUsage m_versionUsage;
+        // Reserved and floating license time by user and product, and the
+        // reserved licenses every user holds at the end of the log
+        SparseTotals m_reservedDurationu;
+        SparseTotals m_floatingDurationu;
+        SparseTotals m_reservedHoldings;
+        ForgottenSessions m_forgottenSessions;
+        DemandProfile m_demandProfile;
+
+        // The group of every user and host id, resolved once, and the
+        // billed sessions by group and product, the unassigned ones in the
+        // row after the mapping's groups.  Without a mapping (NULL) there is
+        // no chargeback report.
+        const GroupMapping* m_groupMapping;
+        vector<size_t> m_userGroups;
+        vector<size_t> m_hostGroups;
+        vector<ChargebackTotals> m_chargeback;
+        UsageRollups m_rollups;
 
         size_t m_endTimeRow;
-};
+        // The last event the filter left out may be later, LLONG_MIN if none
+        long long m_filteredEndTime;
 
-enum eventIndices
-{
-    IndexEvent,
-    IndexDate,
-    IndexTime,
-    IndexProduct,
-    IndexVersion,
-    IndexUser,
-    IndexHost,
-    IndexCount,
-    IndexHandle,
-    IndexReason,
-    IndexReserved,
-    IndexRLimit
+        // Current counters of the concurrent usage pass, the ones last
+        // recorded in the timeline and the ones the timeline starts from,
+        // plus the license count by user and product
+        vector<UsageCounters> m_usageCounters;
+        vector<UsageCounters> m_recordedCounters;
+        vector<UsageCounters> m_initialUsageCounters;
+        vector<uint32_t> m_licenseCounts;
+        // The license counts raised from zero since the last shutdown, which
+        // is all a shutdown has to clear.  A count raised again is listed
+        // again, up to as many entries as the table has; a full list stands
+        // for the whole table.
+        vector<size_t> m_heldLicenseCounts;
+        // The reserved licenses by user and product, laid out like the
+        // license counts.  A user holds no more reserved licenses than
+        // licenses, so the held license counts cover these as well.
+        vector<uint32_t> m_reservedCounts;
+        // The rows of the check-outs that took a reserved license, in row
+        // order: those whose OUT raised the product's reserved licenses in
+        // use
+        vector<size_t> m_reservedCheckOuts;
+
+        // A pipelined analysis runs the concurrent usage pass on a thread
+        // of its own while the log is still being parsed.  Every appended
+        // chunk is handed to it as a batch: the end of its rows and the
+        // size of the name tables then, as the tables keep growing.  The
+        // events are only moved, or their columns reallocated, once the
+        // pass has caught up.
+        struct UsageBatch
+        {
+            size_t endRow;
+            size_t products;
+            size_t users;
+        };
+        unique_ptr< PipelineStage<UsageBatch> > m_usageStage;
+        bool m_usagePipelined;
+
+        // Incremental analysis.  A resumed run reads the log from
+        // m_inputOffset (line m_inputLines) on; the events before
+        // m_firstNewRow are carried over from the checkpoint and are not
+        // reported again.
+        ThreadPool* m_pool;
+        bool m_incremental;
+        bool m_resumed;
+        string m_checkpointPath;
+        uint64_t m_inputOffset;
+        uint64_t m_inputEnd;
+        uint64_t m_inputLines;
+        size_t m_firstNewRow;
+        // The line of every event and the offsets of the indexed lines, by
+        // line (see readLogLine)
+        vector<uint64_t> m_eventLines;
+        vector<pair<uint64_t, uint64_t> > m_lineOffsets;
+        Checkpoint m_checkpoint;
+        uint64_t m_activityLength;
+        uint64_t m_saturationLength;
+
+        // Whether the parsed events are taken from and saved to the event
+        // cache next to the log (see EventCache)
+        bool m_useEventCache;
+        bool m_arrowExport;
+        bool m_sqliteExport;
+        bool m_jsonExport;
+        // The whole log, described before the date range is applied
+        bool m_described;
+        CatalogEntry m_catalogEntry;
+        enum analysisScope m_analysisScope;
+        unsigned int m_reports;
+        bool m_parsed;
+        bool m_analyzed;
+        size_t m_invalidLineBudget;
+        vector<InvalidLine> m_invalidLines;
+
+        // The parser stops at the first event after the date range, and
+        // m_pastRangeEnd tells the block reads to stop too
+        DateRange m_dateRange;
+        bool m_pastRangeEnd;
+
+        // The names of the event filter by field, interned once so that the
+        // parser threads test a name with a lookup in a small table
+        StringInterner m_filterNames[FilterFields];
+        bool m_filterExcludes[FilterFields];
+        bool m_filtering;
+
+        // The last denial by user, host, product and reason, which the next
+        // one within m_denialWindow seconds is merged into, and the requests
+        // merged so far
+        long long m_denialWindow;
+        FlatHashMap<tuple<size_t, size_t, size_t, int32_t>, size_t> m_denialBursts;
+        vector<uint32_t> m_denialRepeats;
+        vector<long long> m_denialLastTimes;
+        size_t m_mergedDenials;
+
+        // Holds the events of the last m_reorderWindow seconds of a chunk
+        // to put late ones back in order
+        long long m_reorderWindow;
+        ReorderBuffer m_reorderBuffer;
+        string m_reportDestination;
+        unsigned int m_writtenReports;
+        bool m_denialUsage;
+        compressionFormat m_reportCompression;
+        PipelineStats m_stats;
+        // Where the parse adds the bytes and events it consumed, if anywhere
+        // (see setProgressReporter)
+        ProgressReporter* m_progress;
+
+        // The events, and of them the OUT, IN and SHUTDOWN events the usage
+        // timeline gets a row for, per byte of the log, as sampled before
+        // it is parsed (see sizeForLog); 0 without a sample
+        double m_eventsPerByte;
+        double m_usageRowsPerByte;
 };
 
+// The report log format whose field layout follows, from the header line
+// "RLM Report Log Format 2, version 14.2 BL2, ISV bitplane".  RLM changes
+// the format number when fields move; newer servers writing the same format
+// only append fields, which the parser does not tokenize.
+const int ReportLogFormat = 2;
+
+// Every report log line starts with its event keyword
+const size_t RepIndexEvent = 0;
+
 enum RepOUTEventIndices
 {
     RepOUTIndexDate = 16,
@@ -211,3 +1018,110 @@ enum
     RepPRODUCTIndexCount = 4,
     RepPRODUCTIndexRLimit = 5
 };
+
+// The fields every line of an ISV log starts with,
+// "MM/DD HH:MM (isv) keyword ...".  The events are projected onto the
+// fields of the report log lines above.
+enum IsvIndices
+{
+    IsvIndexDate = 0,
+    IsvIndexTime = 1,
+    IsvIndexEvent = 3
+};
+
+// The number of leading fields that hold the given indices: the highest
+// one plus one, the event keyword at RepIndexEvent included
+constexpr size_t fieldCount(std::initializer_list<size_t> indices)
+{
+    size_t highest = RepIndexEvent;
+    for (size_t index : indices)
+    {
+        highest = index > highest ? index : highest;
+    }
+    return highest + 1;
+}
+
+// The field layout of each report log event type, from the indices above.
+// The parser is instantiated per event type, so that it reads every field
+// at an offset known to the compiler.
+template <eventType Type> struct ReportEventLayout;
+
+template <> struct ReportEventLayout<OutEvent>
+{
+    static constexpr size_t date = RepOUTIndexDate;
+    static constexpr size_t time = RepOUTIndexTime;
+    static constexpr size_t product = RepOUTIndexProduct;
+    static constexpr size_t version = RepOUTIndexVersion;
+    static constexpr size_t user = RepOUTIndexUser;
+    static constexpr size_t host = RepOUTIndexHost;
+    static constexpr size_t count = RepOUTIndexCount;
+    static constexpr size_t handle = RepOUTIndexHandle;
+    static constexpr size_t reserved = RepOUTIndexReserved;
+    static constexpr size_t fields = fieldCount({ date, time, product, version, user, host,
+                                                  count, handle, reserved });
+};
+
+template <> struct ReportEventLayout<InEvent>
+{
+    static constexpr size_t date = RepINIndexDate;
+    static constexpr size_t time = RepINIndexTime;
+    static constexpr size_t product = RepINIndexProduct;
+    static constexpr size_t version = RepINIndexVersion;
+    static constexpr size_t user = RepINIndexUser;
+    static constexpr size_t host = RepINIndexHost;
+    static constexpr size_t count = RepINIndexCount;
+    static constexpr size_t handle = RepINIndexHandle;
+    static constexpr size_t reserved = RepINIndexReserved;
+    static constexpr size_t fields = fieldCount({ date, time, product, version, user, host,
+                                                  count, handle, reserved });
+};
+
+template <> struct ReportEventLayout<DenyEvent>
+{
+    static constexpr size_t date = RepDENYIndexDate;
+    static constexpr size_t time = RepDENYIndexTime;
+    static constexpr size_t product = RepDENYIndexProduct;
+    static constexpr size_t version = RepDENYIndexVersion;
+    static constexpr size_t user = RepDENYIndexUser;
+    static constexpr size_t host = RepDENYIndexHost;
+    static constexpr size_t count = RepDENYIndexCount;
+    static constexpr size_t reason = RepDENYIndexReason;
+    static constexpr size_t fields = fieldCount({ date, time, product, version, user, host,
+                                                  count, reason });
+};
+
+template <> struct ReportEventLayout<StartEvent>
+{
+    static constexpr size_t date = RepSTARTIndexDate;
+    static constexpr size_t time = RepSTARTIndexTime;
+    static constexpr size_t server = RepSTARTIndexServer;
+    static constexpr size_t fields = fieldCount({ date, time, server });
+};
+
+template <> struct ReportEventLayout<ShutdownEvent>
+{
+    static constexpr size_t date = RepSHUTIndexDate;
+    static constexpr size_t time = RepSHUTIndexTime;
+    static constexpr size_t fields = fieldCount({ date, time });
+};
+
+template <> struct ReportEventLayout<ProductEvent>
+{
+    static constexpr size_t product = RepPRODUCTIndexProduct;
+    static constexpr size_t version = RepPRODUCTIndexVersion;
+    static constexpr size_t count = RepPRODUCTIndexCount;
+    static constexpr size_t rlimit = RepPRODUCTIndexRLimit;
+    static constexpr size_t fields = fieldCount({ product, version, count, rlimit });
+};
+
+// The leading fields a line of each event type needs, by eventType; lines
+// are not tokenized further
+constexpr size_t ReportEventFields[ProductEvent + 1] =
+{
+    ReportEventLayout<OutEvent>::fields,
+    ReportEventLayout<InEvent>::fields,
+    ReportEventLayout<DenyEvent>::fields,
+    ReportEventLayout<StartEvent>::fields,
+    ReportEventLayout<ShutdownEvent>::fields,
+    ReportEventLayout<ProductEvent>::fields
+};
@@ -0,0 +1,201 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LogFollower.h"
+#include "LogData.h"
+#include "MetricsExporter.h"
+#include "Utilities.h"
+
+#include <chrono>
+#include <cstdio>
+#include <boost/filesystem.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <thread>
+#endif
+
+using namespace std;
+
+namespace
+{
+    void appendUsageLine(string& text,
+                         long long eventTime,
+                         string_view product,
+                         const UsageCounters& counters)
+    {
+        char dateTime[MaxFormattedTimeLength];
+        text.append(dateTime, appendLogDateTime(dateTime, eventTime));
+        text += ',';
+        text += product;
+        text += ',' + to_string(counters.floatingInUse);
+        text += ',' + to_string(counters.totalInUse);
+        text += ',' + to_string(counters.floatingLimit);
+        text += ',' + to_string(counters.reservedInUse);
+        text += ',' + to_string(counters.reservedLimit);
+        text += '\n';
+    }
+}
+
+LogFollower::LogFollower(LogData& logData, MetricsExporter* metricsExporter, unsigned int pollMilliseconds,
+                         function<void()> snapshot, unsigned int snapshotSeconds)
+    : m_logData(logData),
+      m_metricsExporter(metricsExporter),
+      m_pollMilliseconds(pollMilliseconds),
+      m_snapshot(snapshot),
+      m_snapshotSeconds(snapshotSeconds),
+      m_stopped(false),
+      m_printedUsageRows(0)
+{
+}
+
+void LogFollower::run()
+{
+    print("Date/Time,Product,Floating Licenses in use,Total Licenses in use,"
+          "Floating Licenses Limit,Reserved Licenses in use,Reserved Licenses Limit\n");
+    printCurrentUsage();
+    if (m_metricsExporter)
+    {
+        m_metricsExporter->update(m_logData);
+    }
+
+#ifdef _WIN32
+    // The notification covers every file of the directory, and it may come
+    // late or not at all on network shares, so it only cuts the wait short
+    string directory = boost::filesystem::path(m_logData.inputFilePath()).parent_path().string();
+    if (directory.empty())
+    {
+        directory = ".";
+    }
+    HANDLE changeNotification = FindFirstChangeNotificationA(directory.c_str(),
+                                                             FALSE,
+                                                             FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+#endif
+
+    // Lines appended since the last snapshot, or since the results were
+    // written before following
+    bool snapshotDue = false;
+    chrono::steady_clock::time_point lastSnapshot = chrono::steady_clock::now();
+
+    while (! m_stopped)
+    {
+#ifdef _WIN32
+        if (changeNotification != INVALID_HANDLE_VALUE)
+        {
+            if (WaitForSingleObject(changeNotification, m_pollMilliseconds) == WAIT_OBJECT_0)
+            {
+                FindNextChangeNotification(changeNotification);
+            }
+        }
+        else
+        {
+            Sleep(m_pollMilliseconds);
+        }
+#else
+        this_thread::sleep_for(chrono::milliseconds(m_pollMilliseconds));
+#endif
+
+        followResult result = m_logData.readAppendedLines();
+        if (result == LinesAppended)
+        {
+            printUsageChanges();
+        }
+        else if (result == LogRestarted)
+        {
+            printCurrentUsage();
+        }
+        if (result != NoNewLines && m_metricsExporter)
+        {
+            m_metricsExporter->update(m_logData, result == LogRestarted);
+        }
+
+        snapshotDue = snapshotDue || result != NoNewLines;
+        if (m_snapshot && snapshotDue &&
+            chrono::steady_clock::now() - lastSnapshot >= chrono::seconds(m_snapshotSeconds))
+        {
+            m_snapshot();
+            snapshotDue = false;
+            lastSnapshot = chrono::steady_clock::now();
+        }
+    }
+
+#ifdef _WIN32
+    if (changeNotification != INVALID_HANDLE_VALUE)
+    {
+        FindCloseChangeNotification(changeNotification);
+    }
+#endif
+}
+
+void LogFollower::stop()
+{
+    m_stopped = true;
+}
+
+// The counters of every product after the last event read so far
+void LogFollower::printCurrentUsage()
+{
+    m_printedUsageRows = m_logData.usageRowCount();
+
+    const EventStore& events = m_logData.events();
+    if (events.size() == 0)
+    {
+        return;
+    }
+
+    string text;
+    const vector<UsageCounters>& counters = m_logData.currentUsage();
+    for (size_t product = 0; product < counters.size(); ++product)
+    {
+        appendUsageLine(text, events.timestamps.back(), m_logData.uniqueProducts().name(product), counters.at(product));
+    }
+    print(text);
+}
+
+// The timeline rows added by the last read
+void LogFollower::printUsageChanges()
+{
+    string text;
+    vector<UsageChange> changes;
+    for (; m_printedUsageRows < m_logData.usageRowCount(); ++m_printedUsageRows)
+    {
+        long long eventTime = m_logData.usageRowTime(m_printedUsageRows);
+        m_logData.usageRowChanges(m_printedUsageRows, changes);
+        for (size_t change = 0; change < changes.size(); ++change)
+        {
+            appendUsageLine(text, eventTime, m_logData.uniqueProducts().name(changes.at(change).product), changes.at(change).counters);
+        }
+    }
+    print(text);
+}
+
+// Every batch of lines goes out at once, so a reader of a pipe sees it
+// without waiting for the stream buffer to fill
+void LogFollower::print(const string& text)
+{
+    if (! text.empty())
+    {
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+    }
+}
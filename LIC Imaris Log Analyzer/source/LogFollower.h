@@ -0,0 +1,81 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class LogData;
+class MetricsExporter;
+
+// Follows a report log that the license server is still writing to, for
+// live monitoring of the license usage.  The lines appended to the log are
+// fed through the log data's incremental parsing and concurrent usage state
+// as they arrive, and every change of a product's counters is printed at
+// once in the long layout of the concurrent usage report (one CSV line per
+// changed product), so that a dashboard can read them from the output.
+//
+// With a metrics exporter, the counters are also handed to it after every
+// read, for Prometheus to scrape.
+//
+// The follower's own state lives in memory only, so a follow that is
+// stopped or crashes starts again from the checkpoint of the last -i run
+// and replays every line appended since.  With a snapshot, the follower
+// calls it every snapshotSeconds once lines were appended, to bring the
+// results and their checkpoint up to date (see processLogFile); a restart
+// then replays only the lines since the last snapshot.  The log itself is
+// the journal of the check-outs and check-ins between snapshots.
+//
+// Windows notifies the follower of changes to the log's directory; other
+// platforms poll the log's size.  Either way the log is checked at least
+// every pollMilliseconds.
+class LogFollower
+{
+    public:
+        LogFollower(LogData& logData, MetricsExporter* metricsExporter = NULL, unsigned int pollMilliseconds = 250,
+                    function<void()> snapshot = nullptr, unsigned int snapshotSeconds = 0);
+        LogFollower(const LogFollower&) = delete;
+        LogFollower& operator=(const LogFollower&) = delete;
+
+        // Prints the current counters of every product, then the changes
+        // until stop() is called (from another thread)
+        void run();
+        void stop();
+
+    private:
+        void printCurrentUsage();
+        void printUsageChanges();
+        void print(const string& text);
+
+        LogData& m_logData;
+        MetricsExporter* m_metricsExporter;
+        unsigned int m_pollMilliseconds;
+        function<void()> m_snapshot;
+        unsigned int m_snapshotSeconds;
+        atomic<bool> m_stopped;
+        size_t m_printedUsageRows;
+};
@@ -0,0 +1,153 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LongestSessions.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    // Values saved for every session: product, user, host, check-out and
+    // check-in
+    const size_t SessionValues = 5;
+}
+
+void LongestSessions::clear()
+{
+    m_heaps.clear();
+}
+
+size_t LongestSessions::memoryBytes() const
+{
+    size_t bytes = heapBytes(m_heaps);
+    for (size_t product = 0; product < m_heaps.size(); ++product)
+    {
+        bytes += heapBytes(m_heaps.at(product));
+    }
+    return bytes;
+}
+
+void LongestSessions::resize(size_t products)
+{
+    if (products > m_heaps.size())
+    {
+        m_heaps.resize(products);
+    }
+}
+
+void LongestSessions::add(const RankedSession& session)
+{
+    vector<RankedSession>& heap = m_heaps.at(session.product);
+    if (heap.size() < Count)
+    {
+        heap.push_back(session);
+        push_heap(heap.begin(), heap.end(), longer);
+    }
+    else if (longer(session, heap.front()))
+    {
+        pop_heap(heap.begin(), heap.end(), longer);
+        heap.back() = session;
+        push_heap(heap.begin(), heap.end(), longer);
+    }
+}
+
+void LongestSessions::add(const LongestSessions& other)
+{
+    resize(other.m_heaps.size());
+    for (size_t product = 0; product < other.m_heaps.size(); ++product)
+    {
+        for (const RankedSession& session : other.m_heaps[product])
+        {
+            add(session);
+        }
+    }
+}
+
+size_t LongestSessions::products() const
+{
+    return m_heaps.size();
+}
+
+void LongestSessions::sessions(size_t product, vector<RankedSession>& sessions) const
+{
+    sessions = m_heaps.at(product);
+    sort(sessions.begin(), sessions.end(), longer);
+}
+
+void LongestSessions::save(Checkpoint& checkpoint) const
+{
+    checkpoint.topSessions.clear();
+    for (size_t product = 0; product < m_heaps.size(); ++product)
+    {
+        for (const RankedSession& session : m_heaps[product])
+        {
+            checkpoint.topSessions.push_back(static_cast<int64_t>(session.product));
+            checkpoint.topSessions.push_back(static_cast<int64_t>(session.user));
+            checkpoint.topSessions.push_back(static_cast<int64_t>(session.host));
+            checkpoint.topSessions.push_back(session.checkOut);
+            checkpoint.topSessions.push_back(session.checkIn);
+        }
+    }
+}
+
+// Only closed sessions are saved, so the lengths follow from their times
+bool LongestSessions::restore(const Checkpoint& checkpoint)
+{
+    const vector<int64_t>& values = checkpoint.topSessions;
+    if (values.size() % SessionValues != 0)
+    {
+        return false;
+    }
+    m_heaps.assign(checkpoint.products.size(), vector<RankedSession>());
+    for (size_t value = 0; value < values.size(); value += SessionValues)
+    {
+        if (values[value] < 0 || static_cast<uint64_t>(values[value]) >= checkpoint.products.size() ||
+            values[value + 1] < 0 || static_cast<uint64_t>(values[value + 1]) >= checkpoint.users.size() ||
+            values[value + 2] < 0 || static_cast<uint64_t>(values[value + 2]) >= checkpoint.hosts.size() ||
+            values[value + 4] < values[value + 3])
+        {
+            m_heaps.clear();
+            return false;
+        }
+        RankedSession session = { static_cast<size_t>(values[value]), static_cast<size_t>(values[value + 1]),
+                                  static_cast<size_t>(values[value + 2]), values[value + 3], values[value + 4],
+                                  values[value + 4] - values[value + 3] };
+        add(session);
+    }
+    return true;
+}
+
+bool LongestSessions::longer(const RankedSession& first, const RankedSession& second)
+{
+    if (first.duration != second.duration)
+    {
+        return first.duration > second.duration;
+    }
+    if (first.checkOut != second.checkOut)
+    {
+        return first.checkOut < second.checkOut;
+    }
+    return first.user != second.user ? first.user < second.user : first.host < second.host;
+}
@@ -0,0 +1,81 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+
+using namespace std;
+
+// A session ranked by its length; checkIn is LLONG_MIN while it is still
+// checked out, and the length then runs until the end of the log
+struct RankedSession
+{
+    size_t product;
+    size_t user;
+    size_t host;
+    long long checkOut;
+    long long checkIn;
+    long long duration;
+};
+
+// The Count longest sessions of every product, for license audits: the
+// sessions a forgotten client held for days stand out among them.  Every
+// product keeps a bounded min-heap of its longest sessions so far, so the
+// sessions are offered one at a time as they are paired and never sorted
+// as a whole.  Ties go to the earlier check-out, then the lower user and
+// host ids.
+class LongestSessions
+{
+    public:
+        static const size_t Count = 10;
+
+        LongestSessions() {}
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Room for the product ids below products
+        void resize(size_t products);
+
+        void add(const RankedSession& session);
+        void add(const LongestSessions& other);
+
+        size_t products() const;
+        // The product's longest sessions, longest first
+        void sessions(size_t product, vector<RankedSession>& sessions) const;
+
+        // The sessions of every product, for a checkpoint; restore is false
+        // if the checkpoint does not fit the names
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+    private:
+        static bool longer(const RankedSession& first, const RankedSession& second);
+
+        // The heap of each product has its shortest session in front
+        vector<vector<RankedSession>> m_heaps;
+};
@@ -0,0 +1,283 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "MetricsExporter.h"
+#include "LogData.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio.hpp>
+
+using namespace std;
+
+using boost::asio::ip::tcp;
+
+namespace
+{
+    // Longest request head read from a scraper
+    const size_t MaxRequestLength = 8192;
+
+    struct UsageFamily
+    {
+        const char* name;
+        const char* help;
+        int32_t UsageCounters::* counter;
+    };
+
+    const UsageFamily UsageFamilies[] =
+    {
+        { "lic_imaris_floating_in_use", "Floating licenses in use.", &UsageCounters::floatingInUse },
+        { "lic_imaris_total_in_use", "Floating and reserved licenses in use.", &UsageCounters::totalInUse },
+        { "lic_imaris_floating_limit", "Floating licenses available.", &UsageCounters::floatingLimit },
+        { "lic_imaris_reserved_in_use", "Reserved licenses in use.", &UsageCounters::reservedInUse },
+        { "lic_imaris_reserved_limit", "Reserved licenses available.", &UsageCounters::reservedLimit }
+    };
+
+    // One connection of a scraper: the request head, and the snapshot
+    // answered, which stays alive until it is written
+    struct Scrape
+    {
+        explicit Scrape(tcp::socket connectedSocket)
+            : socket(std::move(connectedSocket)),
+              request(MaxRequestLength)
+        {
+        }
+
+        tcp::socket socket;
+        boost::asio::streambuf request;
+        string head;
+        shared_ptr<const string> body;
+    };
+
+    void appendFamily(string& text, const char* name, const char* type, const char* help)
+    {
+        text += "# TYPE ";
+        text += name;
+        text += ' ';
+        text += type;
+        text += "\n# HELP ";
+        text += name;
+        text += ' ';
+        text += help;
+        text += '\n';
+    }
+
+    void appendSample(string& text, const char* name, string_view product, unsigned long long value)
+    {
+        text += name;
+        text += "{product=\"";
+        for (size_t character = 0; character < product.size(); ++character)
+        {
+            char c = product[character];
+            if (c == '\\' || c == '"')
+            {
+                text += '\\';
+                text += c;
+            }
+            else if (c == '\n')
+            {
+                text += "\\n";
+            }
+            else
+            {
+                text += c;
+            }
+        }
+        text += "\"} ";
+        text += to_string(value);
+        text += '\n';
+    }
+}
+
+struct MetricsExporter::Server
+{
+    explicit Server(unsigned short port)
+        : acceptor(context, tcp::endpoint(tcp::v4(), port))
+    {
+    }
+
+    boost::asio::io_context context;
+    tcp::acceptor acceptor;
+};
+
+MetricsExporter::MetricsExporter(unsigned short port)
+    : m_server(new Server(port)),
+      m_snapshot(make_shared<const string>("# EOF\n")),
+      m_countedRows(0)
+{
+    accept();
+    m_thread = thread([this]()
+    {
+        m_server->context.run();
+    });
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    m_server->context.stop();
+    m_thread.join();
+}
+
+// Serves one scrape after the other on the exporter's thread.  Every
+// response closes its connection.
+void MetricsExporter::accept()
+{
+    m_server->acceptor.async_accept([this](const boost::system::error_code& error, tcp::socket socket)
+    {
+        if (error == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        if (! error)
+        {
+            shared_ptr<Scrape> scrape = make_shared<Scrape>(std::move(socket));
+            boost::asio::async_read_until(scrape->socket, scrape->request, "\r\n\r\n",
+                                          [this, scrape](const boost::system::error_code& readError, size_t)
+            {
+                if (readError)
+                {
+                    return;
+                }
+
+                istream requestStream(&scrape->request);
+                string method;
+                string target;
+                requestStream >> method >> target;
+                string status = "200 OK";
+                if (method != "GET")
+                {
+                    status = "405 Method Not Allowed";
+                }
+                else if (target.compare(0, target.find('?'), "/metrics") != 0)
+                {
+                    status = "404 Not Found";
+                }
+
+                scrape->body = (status == "200 OK") ? atomic_load(&m_snapshot) : make_shared<const string>();
+                scrape->head = "HTTP/1.1 " + status + "\r\n"
+                               "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                               "Content-Length: " + to_string(scrape->body->size()) + "\r\n"
+                               "Connection: close\r\n\r\n";
+                vector<boost::asio::const_buffer> response;
+                response.push_back(boost::asio::buffer(scrape->head));
+                response.push_back(boost::asio::buffer(*scrape->body));
+                boost::asio::async_write(scrape->socket, response,
+                                         [scrape](const boost::system::error_code&, size_t)
+                {
+                    boost::system::error_code closeError;
+                    scrape->socket.shutdown(tcp::socket::shutdown_both, closeError);
+                    scrape->socket.close(closeError);
+                });
+            });
+        }
+        accept();
+    });
+}
+
+void MetricsExporter::update(const LogData& logData, bool restarted)
+{
+    if (restarted)
+    {
+        m_countedRows = 0;
+        m_openCheckOuts.clear();
+        m_holders.clear();
+    }
+    countEvents(logData);
+
+    const StringInterner& products = logData.uniqueProducts();
+    const vector<UsageCounters>& counters = logData.currentUsage();
+    string text;
+    for (const UsageFamily& family : UsageFamilies)
+    {
+        appendFamily(text, family.name, "gauge", family.help);
+        for (size_t product = 0; product < counters.size(); ++product)
+        {
+            appendSample(text, family.name, products.name(product), static_cast<unsigned long long>(max(counters[product].*family.counter, 0)));
+        }
+    }
+
+    appendFamily(text, "lic_imaris_users", "gauge", "Distinct users holding a license.");
+    for (size_t product = 0; product < m_holders.size(); ++product)
+    {
+        appendSample(text, "lic_imaris_users", products.name(product), m_holders[product].size());
+    }
+
+    appendFamily(text, "lic_imaris_denials", "counter", "Denied license requests.");
+    const EventTotals& totals = logData.eventTotals();
+    for (size_t product = 0; product < products.size(); ++product)
+    {
+        appendSample(text, "lic_imaris_denials_total", products.name(product), totals.denials(product));
+    }
+    text += "# EOF\n";
+
+    atomic_store(&m_snapshot, shared_ptr<const string>(make_shared<const string>(std::move(text))));
+}
+
+// Pairs the check-outs and check-ins like the sessions of the reports: a
+// check-in returns every license open on its handle, and a shutdown or
+// restart all
+void MetricsExporter::countEvents(const LogData& logData)
+{
+    const EventStore& events = logData.events();
+    m_holders.resize(logData.uniqueProducts().size());
+
+    auto returnCheckOuts = [this](const size_t&, vector<pair<size_t, size_t> >& checkOuts)
+    {
+        for (const pair<size_t, size_t>& checkOut : checkOuts)
+        {
+            FlatHashMap<size_t, size_t>& holders = m_holders.at(checkOut.first);
+            size_t* holder = holders.find(checkOut.second);
+            if (holder != NULL && --*holder == 0)
+            {
+                holders.erase(checkOut.second);
+            }
+        }
+    };
+
+    for (; m_countedRows < events.size(); ++m_countedRows)
+    {
+        size_t row = m_countedRows;
+        eventType type = events.types[row];
+        if (type == OutEvent)
+        {
+            size_t product = events.products[row];
+            size_t user = events.users[row];
+            m_openCheckOuts[events.handles[row]].push_back(make_pair(product, user));
+            ++m_holders.at(product)[user];
+        }
+        else if (type == InEvent)
+        {
+            vector<pair<size_t, size_t> >* checkOuts = m_openCheckOuts.find(events.handles[row]);
+            if (checkOuts != NULL)
+            {
+                returnCheckOuts(events.handles[row], *checkOuts);
+                m_openCheckOuts.erase(events.handles[row]);
+            }
+        }
+        else if (startsEpoch(type))
+        {
+            m_openCheckOuts.forEach(returnCheckOuts);
+            m_openCheckOuts.clear();
+        }
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "FlatHashMap.h"
+
+using namespace std;
+
+class LogData;
+
+// Exposes the live license usage of a followed log (see LogFollower) to
+// Prometheus over HTTP.  A GET of /metrics on the given TCP port, on every
+// interface, answers in the OpenMetrics text format with these families,
+// labelled by product:
+//
+//   lic_imaris_floating_in_use      floating licenses in use
+//   lic_imaris_total_in_use         floating and reserved licenses in use
+//   lic_imaris_floating_limit       floating licenses available
+//   lic_imaris_reserved_in_use      reserved licenses in use
+//   lic_imaris_reserved_limit       reserved licenses available
+//   lic_imaris_users                distinct users holding a license
+//   lic_imaris_denials_total        denied requests of the log read so far
+//
+// The follower calls update() after every read of the log.  It formats the
+// whole response once and swaps it in atomically, so the scrapes, served on
+// a thread of their own, only copy the latest snapshot and never wait for
+// the parsing, nor the parsing for them.
+class MetricsExporter
+{
+    public:
+        // Throws boost::system::system_error if the port cannot be bound
+        explicit MetricsExporter(unsigned short port);
+        ~MetricsExporter();
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        // Counts the events read since the last update and publishes a new
+        // snapshot.  After the log restarted, all its events are counted
+        // anew.
+        void update(const LogData& logData, bool restarted = false);
+
+    private:
+        struct Server;
+
+        void accept();
+        void countEvents(const LogData& logData);
+
+        unique_ptr<Server> m_server;
+        thread m_thread;
+        shared_ptr<const string> m_snapshot;
+
+        // The events counted so far, the (product, user) of every check-out
+        // still open on each handle and the open check-outs of every
+        // product by user
+        size_t m_countedRows;
+        FlatHashMap<size_t, vector<pair<size_t, size_t> > > m_openCheckOuts;
+        vector< FlatHashMap<size_t, size_t> > m_holders;
+};
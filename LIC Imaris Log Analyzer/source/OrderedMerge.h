@@ -0,0 +1,148 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Runs the producers of numbered batches on a pool and hands the batches to
+// one consumer in their order, so that the output of a parallel stage is the
+// same as that of a single pass.  At most window batches are produced ahead
+// of the consumer; each has a slot of the reorder buffer and a task group of
+// its own, and the consumer waits for the group of the next batch, running
+// queued tasks meanwhile (see TaskGroup::wait), so it may itself be a task
+// of the pool.  Without a pool, every batch is produced just before it is
+// consumed.
+template <typename Batch>
+class OrderedMerge
+{
+    public:
+        OrderedMerge(ThreadPool* pool, size_t window)
+            : m_pool(pool),
+              m_window(max(window, static_cast<size_t>(1)))
+        {
+        }
+
+        // produce(sequence, batch) fills batch number sequence of count; it
+        // may run on any thread and finds the slot as the consumer left it.
+        // consume(sequence, batch) runs on the calling thread and returns
+        // false to stop before the later batches.  What a producer throws
+        // is rethrown when its batch is due; either way the batches in
+        // flight are finished before run returns.
+        void run(size_t count,
+                 function<void(size_t, Batch&)> produce,
+                 function<bool(size_t, Batch&)> consume)
+        {
+            run(min(m_window, count),
+                [count](size_t sequence, Batch&)
+                {
+                    return sequence < count;
+                },
+                produce, consume);
+        }
+
+        // As above, for batches whose count is not known ahead, e.g. those
+        // sized from the ones before: prepare(sequence, batch) runs on the
+        // calling thread, in order, just before batch number sequence is
+        // produced, and returns false once there are no more.  It may leave
+        // in the batch what the producer is to work on.
+        void run(function<bool(size_t, Batch&)> prepare,
+                 function<void(size_t, Batch&)> produce,
+                 function<bool(size_t, Batch&)> consume)
+        {
+            run(m_window, prepare, produce, consume);
+        }
+
+    private:
+        void run(size_t slots,
+                 function<bool(size_t, Batch&)> prepare,
+                 function<void(size_t, Batch&)> produce,
+                 function<bool(size_t, Batch&)> consume)
+        {
+            if (m_pool == NULL)
+            {
+                Batch batch;
+                for (size_t sequence = 0; prepare(sequence, batch); ++sequence)
+                {
+                    produce(sequence, batch);
+                    if (! consume(sequence, batch))
+                    {
+                        return;
+                    }
+                }
+                return;
+            }
+
+            // The groups are declared after the batches, so on a stop or an
+            // exception they wait for the tasks in flight before the
+            // batches go away
+            slots = max(slots, static_cast<size_t>(1));
+            vector<Batch> batches(slots);
+            vector< unique_ptr<TaskGroup> > groups;
+            for (size_t slot = 0; slot < slots; ++slot)
+            {
+                groups.push_back(unique_ptr<TaskGroup>(new TaskGroup(*m_pool)));
+            }
+            auto start = [&prepare, &produce, &batches, &groups, slots](size_t sequence)
+            {
+                Batch* batch = &batches.at(sequence % slots);
+                if (! prepare(sequence, *batch))
+                {
+                    return false;
+                }
+                groups.at(sequence % slots)->run([&produce, batch, sequence]()
+                {
+                    produce(sequence, *batch);
+                });
+                return true;
+            };
+
+            size_t started = 0;
+            bool more = true;
+            while (started < slots && (more = start(started)))
+            {
+                ++started;
+            }
+            for (size_t sequence = 0; sequence < started; ++sequence)
+            {
+                groups.at(sequence % slots)->wait();
+                if (! consume(sequence, batches.at(sequence % slots)))
+                {
+                    return;
+                }
+                if (more && (more = start(started)))
+                {
+                    ++started;
+                }
+            }
+        }
+
+        ThreadPool* m_pool;
+        size_t m_window;
+};
@@ -0,0 +1,209 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "OutputCache.h"
+#include "Checkpoint.h"
+#include "EventCache.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+
+using namespace std;
+
+namespace
+{
+    const char OutputCacheMagic[] = "LIC Imaris output cache 1";
+    const char ManifestName[] = "outputs.txt";
+
+    // Copies the file under a temporary name and renames it
+    bool copyFile(const string& fromPath, const string& toPath)
+    {
+        string temporaryPath = toPath + ".tmp";
+        {
+            ifstream from(fromPath.c_str(), ios::binary);
+            ofstream to(temporaryPath.c_str(), ios::binary | ios::trunc);
+            if (! from.is_open() || ! to.is_open())
+            {
+                return false;
+            }
+            // An empty report copies no characters, which is no failure
+            if (from.peek() != ifstream::traits_type::eof())
+            {
+                to << from.rdbuf();
+            }
+            to.close();
+            if (! to)
+            {
+                boost::system::error_code error;
+                boost::filesystem::remove(temporaryPath, error);
+                return false;
+            }
+        }
+
+        boost::system::error_code error;
+        boost::filesystem::rename(temporaryPath, toPath, error);
+        if (error)
+        {
+            boost::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+        return true;
+    }
+}
+
+OutputCache::OutputCache(const string& cacheDirectory) :
+    m_cacheDirectory(cacheDirectory),
+    m_keyHash(0)
+{
+}
+
+bool OutputCache::setKey(const vector<string>& inputFiles, vector<string> options)
+{
+    // The reports name the logs as they were given, so the given path goes
+    // into the key beside the log's own
+    m_key.clear();
+    for (size_t file = 0; file < inputFiles.size(); ++file)
+    {
+        uint64_t fingerprint = 0;
+        if (! inputFingerprint(inputFiles.at(file), fingerprint))
+        {
+            return false;
+        }
+        char text[24];
+        snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(fingerprint));
+        m_key += "input " + inputFiles.at(file) + " " + text + "\n";
+    }
+    sort(options.begin(), options.end());
+    for (size_t option = 0; option < options.size(); ++option)
+    {
+        m_key += "option " + options.at(option) + "\n";
+    }
+    m_keyHash = checkpointHash(m_key.data(), m_key.size());
+    return true;
+}
+
+bool OutputCache::find(vector<string>& fileNames) const
+{
+    ifstream manifest((entryPath() + "/" + ManifestName).c_str(), ios::binary);
+    string line;
+    if (! getline(manifest, line) || line != OutputCacheMagic)
+    {
+        return false;
+    }
+
+    // The whole key, then the outputs up to the end
+    string key;
+    while (getline(manifest, line) && ! line.empty())
+    {
+        key += line + "\n";
+    }
+    if (key != m_key)
+    {
+        return false;
+    }
+    fileNames.clear();
+    while (getline(manifest, line))
+    {
+        if (! line.empty())
+        {
+            fileNames.push_back(line);
+        }
+    }
+    return true;
+}
+
+bool OutputCache::restore(const vector<string>& fileNames, const string& outputDirectory) const
+{
+    for (size_t file = 0; file < fileNames.size(); ++file)
+    {
+        if (! copyFile(entryPath() + "/" + fileNames.at(file), outputDirectory + "/" + fileNames.at(file)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OutputCache::store(const string& outputDirectory, long long runStart) const
+{
+    vector<string> outputFiles;
+    getFileListInDirectory(outputDirectory, outputFiles);
+    sort(outputFiles.begin(), outputFiles.end());
+
+    // The entry is filled in a folder of its own and renamed when complete,
+    // so that a run reading the cache meanwhile finds it whole or not at all
+    string temporaryPath = entryPath() + ".tmp";
+    boost::system::error_code error;
+    boost::filesystem::remove_all(temporaryPath, error);
+    boost::filesystem::create_directories(temporaryPath, error);
+    if (error)
+    {
+        return false;
+    }
+
+    string manifest = string(OutputCacheMagic) + "\n" + m_key + "\n";
+    bool bStored = true;
+    for (size_t file = 0; file < outputFiles.size() && bStored; ++file)
+    {
+        string fileName = boost::filesystem::path(outputFiles.at(file)).filename().string();
+        size_t tmpLength = sizeof(".tmp") - 1;
+        bool bTemporary = fileName.size() > tmpLength && fileName.compare(fileName.size() - tmpLength, tmpLength, ".tmp") == 0;
+        if (fileName.find("LIC_Imaris") == string::npos || bTemporary || getFileModifiedTime(outputFiles.at(file)) < runStart)
+        {
+            continue;
+        }
+        bStored = copyFile(outputFiles.at(file), temporaryPath + "/" + fileName);
+        manifest += fileName + "\n";
+    }
+
+    if (bStored)
+    {
+        ofstream manifestFile((temporaryPath + "/" + ManifestName).c_str(), ios::binary | ios::trunc);
+        manifestFile << manifest;
+        manifestFile.close();
+        bStored = static_cast<bool>(manifestFile);
+    }
+    if (bStored)
+    {
+        // An entry of the same key stored meanwhile is as good
+        boost::filesystem::remove_all(entryPath(), error);
+        boost::filesystem::rename(temporaryPath, entryPath(), error);
+        bStored = ! error;
+    }
+    if (! bStored)
+    {
+        boost::filesystem::remove_all(temporaryPath, error);
+    }
+    return bStored;
+}
+
+string OutputCache::entryPath() const
+{
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(m_keyHash));
+    return m_cacheDirectory + "/" + name;
+}
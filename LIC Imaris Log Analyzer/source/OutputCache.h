@@ -0,0 +1,71 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A cache of the outputs of whole runs, so that reports asked for again with
+// the same logs and options are copied from the last run instead of being
+// analyzed again.  A run is keyed by the key of every input file, as the
+// event cache keys a log (see inputFingerprint), by the options that shape
+// its outputs, in any order, and by the build of the analyzer; the caller
+// gives the options and the build as text.  An entry is a folder of the cache
+// named after a hash of the key, holding copies of the outputs and a list of
+// them with the whole key, written last: a run cut short leaves no entry, and
+// two keys of the same hash are told apart.  The files are copied, not linked,
+// both ways, as an incremental run later appends to its reports in place.
+// Entries are never removed; clearing the folder empties the cache.
+class OutputCache
+{
+    public:
+        explicit OutputCache(const string& cacheDirectory);
+
+        // Returns false if an input file cannot be inspected
+        bool setKey(const vector<string>& inputFiles, vector<string> options);
+
+        // The names of the cached outputs of the run; false if it has none
+        bool find(vector<string>& fileNames) const;
+
+        // Copies the cached outputs into the output folder, each under a
+        // temporary name that is renamed when it is complete; false if a
+        // file could not be copied
+        bool restore(const vector<string>& fileNames, const string& outputDirectory) const;
+
+        // Keeps the outputs the run wrote to the output folder, the reports
+        // changed since runStart (seconds since the epoch), as the entry of
+        // its key.  The cache only saves time, so a failure just returns
+        // false.
+        bool store(const string& outputDirectory, long long runStart) const;
+
+    private:
+        string entryPath() const;
+
+        string m_cacheDirectory;
+        string m_key;
+        uint64_t m_keyHash;
+};
@@ -0,0 +1,237 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "PeriodComparison.h"
+#include "GroupMapping.h"
+#include "UsageRollups.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+using namespace std;
+
+namespace
+{
+    const string Unassigned = "(Unassigned)";
+}
+
+bool PeriodComparison::parsePeriod(string_view name, long long& from, long long& to)
+{
+    if ((name.size() != 4 && name.size() != 7) || (name.size() == 7 && name[4] != '-'))
+    {
+        return false;
+    }
+    for (size_t digit = 0; digit < name.size(); ++digit)
+    {
+        if (digit != 4 && (name[digit] < '0' || name[digit] > '9'))
+        {
+            return false;
+        }
+    }
+
+    DateTime start = { stringViewToInt(name.substr(0, 4)), 1, 1, 0, 0, 0 };
+    DateTime end = start;
+    if (name.size() == 7)
+    {
+        start.month = stringViewToInt(name.substr(5, 2));
+        if (start.month < 1 || start.month > 12)
+        {
+            return false;
+        }
+        end = start;
+        end.year += start.month / 12;
+        end.month = start.month % 12 + 1;
+    }
+    else
+    {
+        ++end.year;
+    }
+    from = dateTimeToEpoch(start);
+    to = dateTimeToEpoch(end);
+
+    return true;
+}
+
+PeriodComparison::PeriodComparison(const string& firstName, long long firstFrom, long long firstTo,
+                                   const string& secondName, long long secondFrom, long long secondTo)
+{
+    m_names[0] = firstName;
+    m_from[0] = firstFrom;
+    m_to[0] = firstTo;
+    m_names[1] = secondName;
+    m_from[1] = secondFrom;
+    m_to[1] = secondTo;
+}
+
+bool PeriodComparison::addRollups(const RollupCache& cache)
+{
+    UsageRollups rollups;
+    if (! rollups.restore(cache))
+    {
+        return false;
+    }
+
+    for (const auto& usage : rollups.usage(MonthRollup))
+    {
+        int period = periodOf(usage.first.first);
+        if (period < 0)
+        {
+            continue;
+        }
+        ProductTotals& totals = m_products[period][cache.products.at(usage.first.second)];
+        totals.peak = max(totals.peak, usage.second.peak);
+        totals.inUseSeconds += usage.second.inUseSeconds;
+        totals.denials += usage.second.denials;
+    }
+
+    const map<tuple<long long, size_t, size_t>, int64_t>* durations[] = { &rollups.userDurations(MonthRollup),
+                                                                          &rollups.hostDurations(MonthRollup) };
+    const vector<string>* names[] = { &cache.users, &cache.hosts };
+    DurationTable* tables[] = { &m_users, &m_hosts };
+    for (size_t table = 0; table < 2; ++table)
+    {
+        for (const auto& duration : *durations[table])
+        {
+            int period = periodOf(get<0>(duration.first));
+            if (period < 0)
+            {
+                continue;
+            }
+            pair<int64_t, int64_t>& seconds = (*tables[table])[make_pair(names[table]->at(get<1>(duration.first)),
+                                                                          cache.products.at(get<2>(duration.first)))];
+            (period == 0 ? seconds.first : seconds.second) += duration.second;
+        }
+    }
+
+    return true;
+}
+
+int PeriodComparison::periodOf(long long monthStart) const
+{
+    for (int period = 0; period < 2; ++period)
+    {
+        if (monthStart >= m_from[period] && monthStart < m_to[period])
+        {
+            return period;
+        }
+    }
+    return -1;
+}
+
+void PeriodComparison::appendHours(string& out, int64_t seconds)
+{
+    char hours[32];
+    snprintf(hours, sizeof(hours), "%.2f", static_cast<double>(seconds) / 3600.0);
+    out += hours;
+}
+
+// The products of either period, with a period without the product as 0
+void PeriodComparison::write(string& out, const GroupMapping* groups) const
+{
+    const string& first = m_names[0];
+    const string& second = m_names[1];
+    out += "Product,Peak " + first + ",Peak " + second + ",Peak Change,Hours " + first + ",Hours " + second +
+           ",Hours Change,Denials " + first + ",Denials " + second + ",Denials Change\n";
+    set<string> products;
+    for (size_t period = 0; period < 2; ++period)
+    {
+        for (const auto& product : m_products[period])
+        {
+            products.insert(product.first);
+        }
+    }
+    for (const string& product : products)
+    {
+        ProductTotals totals[2];
+        for (size_t period = 0; period < 2; ++period)
+        {
+            auto found = m_products[period].find(product);
+            if (found != m_products[period].end())
+            {
+                totals[period] = found->second;
+            }
+        }
+        out += product;
+        out += ',' + to_string(totals[0].peak) + ',' + to_string(totals[1].peak) + ',' + to_string(totals[1].peak - totals[0].peak) + ',';
+        appendHours(out, totals[0].inUseSeconds);
+        out += ',';
+        appendHours(out, totals[1].inUseSeconds);
+        out += ',';
+        appendHours(out, totals[1].inUseSeconds - totals[0].inUseSeconds);
+        out += ',' + to_string(totals[0].denials) + ',' + to_string(totals[1].denials) + ',' +
+               to_string(static_cast<int64_t>(totals[1].denials) - static_cast<int64_t>(totals[0].denials)) + '\n';
+    }
+    out += '\n';
+
+    writeDurations(out, "User", m_users);
+
+    if (groups == NULL || groups->empty())
+    {
+        return;
+    }
+    // Once a user is mapped, the users of no group are unassigned
+    bool byUser = false;
+    for (auto user = m_users.begin(); user != m_users.end() && ! byUser; ++user)
+    {
+        byUser = groups->userGroup(user->first.first) != GroupMapping::NoGroup;
+    }
+    DurationTable groupDurations;
+    for (const auto& duration : byUser ? m_users : m_hosts)
+    {
+        size_t group = byUser ? groups->userGroup(duration.first.first) : groups->hostGroup(duration.first.first);
+        const string& name = (group == GroupMapping::NoGroup) ? Unassigned : groups->group(group);
+        pair<int64_t, int64_t>& seconds = groupDurations[make_pair(name, duration.first.second)];
+        seconds.first += duration.second.first;
+        seconds.second += duration.second.second;
+    }
+    writeDurations(out, "Group", groupDurations);
+}
+
+void PeriodComparison::writeDurations(string& out, const char* column, const DurationTable& durations) const
+{
+    out += column;
+    out += ",Product,Hours " + m_names[0] + ",Hours " + m_names[1] + ",Hours Change\n";
+    for (const auto& duration : durations)
+    {
+        // Group names may hold commas, as in the chargeback report
+        if (duration.first.first.find(',') != string::npos)
+        {
+            out += '"' + duration.first.first + '"';
+        }
+        else
+        {
+            out += duration.first.first;
+        }
+        out += ',' + duration.first.second + ',';
+        appendHours(out, duration.second.first);
+        out += ',';
+        appendHours(out, duration.second.second);
+        out += ',';
+        appendHours(out, duration.second.second - duration.second.first);
+        out += '\n';
+    }
+    out += '\n';
+}
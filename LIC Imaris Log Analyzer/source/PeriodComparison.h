@@ -0,0 +1,88 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "EventCache.h"
+
+using namespace std;
+
+class GroupMapping;
+
+// Two periods of analyzed logs compared from the month rollups kept with
+// their event caches (see UsageRollups), so that a yearly report does not
+// parse years of logs twice: per product the peak floating licenses in use,
+// the license hours and the denied requests, and per user and per group the
+// hours checked out of every product, each with the change from the first
+// period to the second.  The logs are matched by name, so those of several
+// logs, e.g. rotated ones, add up; the peak of several logs is the largest.
+// The rollups keep the users and the hosts of the sessions apart, so a
+// session goes to the group of its user, or with host groups alone, to
+// that of its host.
+class PeriodComparison
+{
+    public:
+        // "YYYY" or "YYYY-MM": the months [from, to) of the period
+        static bool parsePeriod(string_view name, long long& from, long long& to);
+
+        PeriodComparison(const string& firstName, long long firstFrom, long long firstTo,
+                         const string& secondName, long long secondFrom, long long secondTo);
+
+        // Adds the rollups of a log; false if they do not fit their names
+        bool addRollups(const RollupCache& cache);
+
+        // The products, users and groups as three CSV tables, each followed
+        // by an empty line; the groups only with a mapping
+        void write(string& out, const GroupMapping* groups) const;
+
+    private:
+        struct ProductTotals
+        {
+            ProductTotals() : peak(0), inUseSeconds(0), denials(0) {}
+
+            int32_t peak;
+            int64_t inUseSeconds;
+            uint64_t denials;
+        };
+
+        // Hours checked out by name and product, in each period
+        typedef map<pair<string, string>, pair<int64_t, int64_t> > DurationTable;
+
+        // 0 or 1 for the period holding the month, -1 for neither
+        int periodOf(long long monthStart) const;
+        static void appendHours(string& out, int64_t seconds);
+        void writeDurations(string& out, const char* column, const DurationTable& durations) const;
+
+        string m_names[2];
+        long long m_from[2];
+        long long m_to[2];
+        map<string, ProductTotals> m_products[2];
+        DurationTable m_users;
+        DurationTable m_hosts;
+};
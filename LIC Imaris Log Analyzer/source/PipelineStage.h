@@ -0,0 +1,134 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <thread>
+#include "SpscQueue.h"
+#include "TraceRecorder.h"
+
+using namespace std;
+
+// The last stage of a pipeline: a thread of its own that hands every item
+// one producer pushes, in order, to consume().  The items wait in an
+// SpscQueue, whose capacity bounds how far the producer may run ahead.  If
+// consume() throws, the later items are dropped and finish() rethrows.
+template <typename T>
+class PipelineStage
+{
+    public:
+        PipelineStage(size_t capacity, function<void(T&)> consume)
+            : m_queue(capacity),
+              m_consume(consume),
+              m_pushed(0),
+              m_consumed(0),
+              m_failed(false)
+        {
+            m_thread = thread(&PipelineStage::run, this);
+        }
+
+        // A stage left unfinished, e.g. by an exception of the producer,
+        // still consumes what was pushed before it stops
+        ~PipelineStage()
+        {
+            if (m_thread.joinable())
+            {
+                m_queue.close();
+                m_thread.join();
+            }
+        }
+
+        PipelineStage(const PipelineStage&) = delete;
+        PipelineStage& operator=(const PipelineStage&) = delete;
+
+        // Waits while the queue is full
+        void push(T item)
+        {
+            m_queue.push(item);
+            ++m_pushed;
+        }
+
+        // The items pushed and not yet consumed, for the producer
+        size_t pending() const
+        {
+            return m_pushed - m_consumed.load(memory_order_acquire);
+        }
+
+        // Waits until every item pushed so far has been consumed, e.g.
+        // before the producer changes what they refer to
+        void drain()
+        {
+            LIC_TRACE_SCOPE("wait for pipeline stage");
+            for (unsigned int waits = 0; m_consumed.load(memory_order_acquire) < m_pushed; ++waits)
+            {
+                SpscQueue<T>::wait(waits);
+            }
+        }
+
+        // Waits until every item has been consumed.  Rethrows what consume()
+        // failed with.
+        void finish()
+        {
+            m_queue.close();
+            m_thread.join();
+            if (m_error)
+            {
+                rethrow_exception(m_error);
+            }
+        }
+
+    private:
+        void run()
+        {
+            T item;
+            while (m_queue.pop(item))
+            {
+                if (! m_failed)
+                {
+                    try
+                    {
+                        LIC_TRACE_SCOPE("pipeline stage batch");
+                        m_consume(item);
+                    }
+                    catch (...)
+                    {
+                        m_error = current_exception();
+                        m_failed = true;
+                    }
+                }
+                m_consumed.fetch_add(1, memory_order_release);
+            }
+        }
+
+        SpscQueue<T> m_queue;
+        function<void(T&)> m_consume;
+        // Only the producer counts the items pushed
+        size_t m_pushed;
+        atomic<size_t> m_consumed;
+        bool m_failed;
+        exception_ptr m_error;
+        thread m_thread;
+};
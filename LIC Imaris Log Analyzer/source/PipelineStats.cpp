@@ -0,0 +1,368 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "PipelineStats.h"
+#include "Utilities.h"
+#include "BufferedWriter.h"
+#include "TraceRecorder.h"
+
+#include <atomic>
+#include <cstdio>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    const double MegaByte = 1024.0 * 1024.0;
+
+    atomic<bool> s_memoryAccounting(false);
+
+#ifdef _WIN32
+    double fileTimeSeconds(const FILETIME& fileTime)
+    {
+        ULARGE_INTEGER ticks;
+        ticks.LowPart = fileTime.dwLowDateTime;
+        ticks.HighPart = fileTime.dwHighDateTime;
+        return static_cast<double>(ticks.QuadPart) / 1e7;
+    }
+#endif
+
+    // User plus kernel time of the process or of the calling thread
+    double cpuTime(bool thread)
+    {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        BOOL ok = thread ? GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)
+                         : GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+        if (! ok)
+        {
+            return 0.0;
+        }
+        return fileTimeSeconds(kernel) + fileTimeSeconds(user);
+#else
+        struct timespec time;
+        if (clock_gettime(thread ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) / 1e9;
+#endif
+    }
+
+    double eventsPerSecond(const StageStats& stage)
+    {
+        return stage.wallSeconds > 0.0 ? static_cast<double>(stage.events) / stage.wallSeconds : 0.0;
+    }
+}
+
+PipelineStats::PipelineStats(const string& inputFilePath)
+    : m_inputFilePath(inputFilePath)
+{
+}
+
+PipelineStats::PipelineStats(const PipelineStats& other)
+    : m_inputFilePath(other.m_inputFilePath),
+      m_stages(other.stages()),
+      m_memoryAccounts(other.memoryAccounts()),
+      m_tunings(other.tunings())
+{
+}
+
+PipelineStats& PipelineStats::operator=(const PipelineStats& other)
+{
+    if (this != &other)
+    {
+        vector<StageStats> stages = other.stages();
+        vector<MemoryAccount> memoryAccounts = other.memoryAccounts();
+        vector<ChunkTuning> tunings = other.tunings();
+        lock_guard<mutex> lock(m_mutex);
+        m_inputFilePath = other.m_inputFilePath;
+        m_stages.swap(stages);
+        m_memoryAccounts.swap(memoryAccounts);
+        m_tunings.swap(tunings);
+    }
+    return *this;
+}
+
+void PipelineStats::record(const StageStats& stage)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_stages.push_back(stage);
+}
+
+void PipelineStats::recordMemory(const MemoryAccount& account)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_memoryAccounts.push_back(account);
+}
+
+void PipelineStats::recordTuning(const ChunkTuning& tuning)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_tunings.push_back(tuning);
+}
+
+void PipelineStats::clear()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_stages.clear();
+    m_memoryAccounts.clear();
+    m_tunings.clear();
+}
+
+const string& PipelineStats::inputFilePath() const
+{
+    return m_inputFilePath;
+}
+
+vector<StageStats> PipelineStats::stages() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_stages;
+}
+
+vector<MemoryAccount> PipelineStats::memoryAccounts() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_memoryAccounts;
+}
+
+vector<ChunkTuning> PipelineStats::tunings() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_tunings;
+}
+
+string PipelineStats::format() const
+{
+    vector<StageStats> stages = this->stages();
+    string text = m_inputFilePath + "\n";
+    char line[256];
+    snprintf(line, sizeof(line), "%-52s %9s %9s %9s %10s %12s %9s\n",
+             "Stage", "Wall s", "CPU s", "MB", "Events", "Events/s", "Peak MB");
+    text += line;
+    for (size_t stage = 0; stage < stages.size(); ++stage)
+    {
+        const StageStats& stats = stages.at(stage);
+        snprintf(line, sizeof(line), "%-52s %9.3f %9.3f %9.1f %10llu %12.0f %9.1f\n",
+                 stats.name.c_str(), stats.wallSeconds, stats.cpuSeconds,
+                 static_cast<double>(stats.bytes) / MegaByte,
+                 static_cast<unsigned long long>(stats.events), eventsPerSecond(stats),
+                 static_cast<double>(stats.peakMemory) / MegaByte);
+        text += line;
+    }
+
+    vector<ChunkTuning> tunings = this->tunings();
+    for (size_t tuning = 0; tuning < tunings.size(); ++tuning)
+    {
+        const ChunkTuning& chunks = tunings.at(tuning);
+        snprintf(line, sizeof(line), "\nChunks of %s: %llu of %.2f to %.2f MB (last %.2f MB), %.1f MB/s per thread",
+                 chunks.stage.c_str(), static_cast<unsigned long long>(chunks.chunks),
+                 static_cast<double>(chunks.minBytes) / MegaByte, static_cast<double>(chunks.maxBytes) / MegaByte,
+                 static_cast<double>(chunks.lastBytes) / MegaByte, chunks.bytesPerSecond / MegaByte);
+        text += line;
+        if (chunks.queueCapacity > 0)
+        {
+            snprintf(line, sizeof(line), ", %.1f of %u usage batches queued", chunks.meanQueued,
+                     static_cast<unsigned int>(chunks.queueCapacity));
+            text += line;
+        }
+        text += "\n";
+    }
+
+    // The structures are the same after every stage, so they make the rows
+    // of one table with a column per stage
+    vector<MemoryAccount> accounts = memoryAccounts();
+    if (! accounts.empty())
+    {
+        snprintf(line, sizeof(line), "\n%-28s", "Heap MB after");
+        text += line;
+        for (size_t account = 0; account < accounts.size(); ++account)
+        {
+            snprintf(line, sizeof(line), " %12.12s", accounts.at(account).stage.c_str());
+            text += line;
+        }
+        text += "\n";
+        for (size_t structure = 0; structure < accounts.front().structures.size(); ++structure)
+        {
+            snprintf(line, sizeof(line), "%-28s", accounts.front().structures.at(structure).first.c_str());
+            text += line;
+            for (size_t account = 0; account < accounts.size(); ++account)
+            {
+                const vector< pair<string, uint64_t> >& structures = accounts.at(account).structures;
+                double bytes = structure < structures.size() ? static_cast<double>(structures.at(structure).second) : 0.0;
+                snprintf(line, sizeof(line), " %12.1f", bytes / MegaByte);
+                text += line;
+            }
+            text += "\n";
+        }
+    }
+    return text;
+}
+
+string PipelineStats::json() const
+{
+    vector<StageStats> stages = this->stages();
+    string text = "{\"input\": ";
+    appendJsonString(text, m_inputFilePath);
+    text += ", \"stages\": [";
+    char numbers[256];
+    for (size_t stage = 0; stage < stages.size(); ++stage)
+    {
+        const StageStats& stats = stages.at(stage);
+        text += stage == 0 ? "\n  {\"name\": " : ",\n  {\"name\": ";
+        appendJsonString(text, stats.name);
+        snprintf(numbers, sizeof(numbers),
+                 ", \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, \"bytes\": %llu, \"events\": %llu, "
+                 "\"events_per_second\": %.1f, \"peak_memory_bytes\": %llu}",
+                 stats.wallSeconds, stats.cpuSeconds,
+                 static_cast<unsigned long long>(stats.bytes),
+                 static_cast<unsigned long long>(stats.events), eventsPerSecond(stats),
+                 static_cast<unsigned long long>(stats.peakMemory));
+        text += numbers;
+    }
+    text += "]";
+
+    vector<ChunkTuning> tunings = this->tunings();
+    if (! tunings.empty())
+    {
+        text += ", \"chunk_tuning\": [";
+        for (size_t tuning = 0; tuning < tunings.size(); ++tuning)
+        {
+            const ChunkTuning& chunks = tunings.at(tuning);
+            text += tuning == 0 ? "\n  {\"stage\": " : ",\n  {\"stage\": ";
+            appendJsonString(text, chunks.stage);
+            snprintf(numbers, sizeof(numbers),
+                     ", \"chunks\": %llu, \"min_bytes\": %llu, \"max_bytes\": %llu, \"last_bytes\": %llu, "
+                     "\"bytes_per_second\": %.1f, \"queue_capacity\": %u, \"mean_queued\": %.3f}",
+                     static_cast<unsigned long long>(chunks.chunks), static_cast<unsigned long long>(chunks.minBytes),
+                     static_cast<unsigned long long>(chunks.maxBytes), static_cast<unsigned long long>(chunks.lastBytes),
+                     chunks.bytesPerSecond, static_cast<unsigned int>(chunks.queueCapacity), chunks.meanQueued);
+            text += numbers;
+        }
+        text += "]";
+    }
+
+    vector<MemoryAccount> accounts = memoryAccounts();
+    if (! accounts.empty())
+    {
+        text += ", \"memory\": [";
+        for (size_t account = 0; account < accounts.size(); ++account)
+        {
+            text += account == 0 ? "\n  {\"after\": " : ",\n  {\"after\": ";
+            appendJsonString(text, accounts.at(account).stage);
+            text += ", \"heap_bytes\": {";
+            const vector< pair<string, uint64_t> >& structures = accounts.at(account).structures;
+            for (size_t structure = 0; structure < structures.size(); ++structure)
+            {
+                text += structure == 0 ? "" : ", ";
+                appendJsonString(text, structures.at(structure).first);
+                snprintf(numbers, sizeof(numbers), ": %llu", static_cast<unsigned long long>(structures.at(structure).second));
+                text += numbers;
+            }
+            text += "}}";
+        }
+        text += "]";
+    }
+    text += "}";
+    return text;
+}
+
+void writePipelineStatsJson(const string& outputFilePath, const vector<PipelineStats>& logs)
+{
+    BufferedWriter out(outputFilePath);
+    out.write("{\"logs\": [");
+    for (size_t log = 0; log < logs.size(); ++log)
+    {
+        out.write(log == 0 ? "\n" : ",\n");
+        out.write(logs.at(log).json());
+    }
+    out.write("]}\n");
+    out.close();
+}
+
+StageTimer::StageTimer(PipelineStats& stats, const string& name, cpuClock clock)
+    : m_stats(stats),
+      m_clock(clock),
+      m_start(chrono::steady_clock::now()),
+      m_cpuStart(cpuSeconds())
+{
+    m_stage.name = name;
+    m_stage.wallSeconds = 0.0;
+    m_stage.cpuSeconds = 0.0;
+    m_stage.bytes = 0;
+    m_stage.events = 0;
+    m_stage.peakMemory = 0;
+}
+
+StageTimer::~StageTimer()
+{
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    m_stage.wallSeconds = chrono::duration<double>(end - m_start).count();
+    m_stage.cpuSeconds = cpuSeconds() - m_cpuStart;
+    m_stage.peakMemory = peakMemoryUsage();
+    m_stats.record(m_stage);
+
+#ifndef LIC_NO_TRACING
+    // The stages of a trace are told apart by their log
+    TraceRecorder* trace = currentTraceRecorder();
+    if (trace != NULL)
+    {
+        const string& path = m_stats.inputFilePath();
+        trace->record(m_stage.name, path.substr(path.find_last_of("/\\") + 1), m_start, end);
+    }
+#endif
+}
+
+void StageTimer::setBytes(uint64_t bytes)
+{
+    m_stage.bytes = bytes;
+}
+
+void StageTimer::setEvents(uint64_t events)
+{
+    m_stage.events = events;
+}
+
+void setMemoryAccounting(bool accounting)
+{
+    s_memoryAccounting = accounting;
+}
+
+bool memoryAccounting()
+{
+    return s_memoryAccounting;
+}
+
+double StageTimer::cpuSeconds() const
+{
+    return cpuTime(m_clock == ThreadCpu);
+}
@@ -0,0 +1,142 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Figures of one stage of the analysis or of one report writer.  CPU time
+// is the process's, or for a report (which runs on one thread while others
+// run) its thread's.  Bytes and events are what the stage read or wrote;
+// peak memory is the process's peak when the stage ended.
+struct StageStats
+{
+    string name;
+    double wallSeconds;
+    double cpuSeconds;
+    uint64_t bytes;
+    uint64_t events;
+    size_t peakMemory;
+};
+
+// The heap bytes of each major structure of the analysis once a stage is
+// done (see setMemoryAccounting), estimated from the sizes and capacities
+// of its containers
+struct MemoryAccount
+{
+    string stage;
+    vector< pair<string, uint64_t> > structures;
+};
+
+// How a stage sized the chunks it parsed at runtime (see ChunkTuner): their
+// count, smallest, largest and last size, the bytes a thread parsed per
+// second, and the batches waiting for the concurrent usage pass on average
+// when a chunk was cut, of a queue of queueCapacity (0 without the pass)
+struct ChunkTuning
+{
+    string stage;
+    uint64_t chunks;
+    uint64_t minBytes;
+    uint64_t maxBytes;
+    uint64_t lastBytes;
+    double bytesPerSecond;
+    size_t queueCapacity;
+    double meanQueued;
+};
+
+// The stage figures of one log (see StageTimer).  Reports are written
+// concurrently, so the stages may be recorded from several threads.
+class PipelineStats
+{
+    public:
+        explicit PipelineStats(const string& inputFilePath = string());
+        PipelineStats(const PipelineStats& other);
+        PipelineStats& operator=(const PipelineStats& other);
+
+        void record(const StageStats& stage);
+        void recordMemory(const MemoryAccount& account);
+        void recordTuning(const ChunkTuning& tuning);
+        void clear();
+
+        const string& inputFilePath() const;
+        vector<StageStats> stages() const;
+        vector<MemoryAccount> memoryAccounts() const;
+        vector<ChunkTuning> tunings() const;
+
+        // A table for the console and a JSON object for monitoring
+        string format() const;
+        string json() const;
+
+    private:
+        string m_inputFilePath;
+        vector<StageStats> m_stages;
+        vector<MemoryAccount> m_memoryAccounts;
+        vector<ChunkTuning> m_tunings;
+        mutable mutex m_mutex;
+};
+
+// Whether the logs analyzed from now on account the memory of their
+// structures after each stage (off by default)
+void setMemoryAccounting(bool accounting);
+
+bool memoryAccounting();
+
+// Writes {"logs": [...]} with the json() of every log.  Throws
+// CannotOpenFileException if the file cannot be written.
+void writePipelineStatsJson(const string& outputFilePath, const vector<PipelineStats>& logs);
+
+// Measures the stage from its construction to its destruction and records
+// it, and as a span of the trace if one is recorded (see TraceRecorder).
+// The bytes and events are set while the stage runs.
+class StageTimer
+{
+    public:
+        enum cpuClock
+        {
+            ProcessCpu,
+            ThreadCpu
+        };
+
+        StageTimer(PipelineStats& stats, const string& name, cpuClock clock = ProcessCpu);
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+        ~StageTimer();
+
+        void setBytes(uint64_t bytes);
+        void setEvents(uint64_t events);
+
+    private:
+        double cpuSeconds() const;
+
+        PipelineStats& m_stats;
+        StageStats m_stage;
+        cpuClock m_clock;
+        chrono::steady_clock::time_point m_start;
+        double m_cpuStart;
+};
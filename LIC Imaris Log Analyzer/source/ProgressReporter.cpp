@@ -0,0 +1,114 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ProgressReporter.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    atomic<ProgressReporter*> s_progressReporter(NULL);
+}
+
+ProgressReporter::ProgressReporter(uint64_t totalBytes, chrono::milliseconds interval)
+    : m_totalBytes(totalBytes),
+      m_interval(interval),
+      m_start(chrono::steady_clock::now()),
+      m_bytes(0),
+      m_events(0),
+      m_printed(false),
+      m_stopped(false)
+{
+    m_thread = thread(&ProgressReporter::run, this);
+}
+
+// A run that reported its progress ends with a last line, at its end
+ProgressReporter::~ProgressReporter()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+    if (m_printed)
+    {
+        print(chrono::duration<double>(chrono::steady_clock::now() - m_start).count());
+    }
+}
+
+void ProgressReporter::run()
+{
+    unique_lock<mutex> lock(m_mutex);
+    chrono::steady_clock::time_point next = m_start + m_interval;
+    while (! m_wakeUp.wait_until(lock, next, [this] { return m_stopped; }))
+    {
+        print(chrono::duration<double>(chrono::steady_clock::now() - m_start).count());
+        m_printed = true;
+        next += m_interval;
+    }
+}
+
+// E.g. "Read 42% (1234 of 2938 MB), 310 MB/s, 2450000 events/s, 6 s left"
+void ProgressReporter::print(double seconds)
+{
+    const double megabyte = 1024.0 * 1024.0;
+    uint64_t bytes = m_bytes.load(memory_order_relaxed);
+    uint64_t events = m_events.load(memory_order_relaxed);
+    double bytesPerSecond = seconds > 0 ? bytes / seconds : 0;
+    double eventsPerSecond = seconds > 0 ? events / seconds : 0;
+
+    if (m_totalBytes > 0)
+    {
+        // The analysis after the parse goes on with all of the input read
+        uint64_t read = min(bytes, m_totalBytes);
+        fprintf(stderr, "Read %d%% (%.0f of %.0f MB), %.0f MB/s, %.0f events/s",
+                static_cast<int>(100 * read / m_totalBytes), read / megabyte, m_totalBytes / megabyte,
+                bytesPerSecond / megabyte, eventsPerSecond);
+        if (read < m_totalBytes && bytesPerSecond > 0)
+        {
+            fprintf(stderr, ", %.0f s left\n", (m_totalBytes - read) / bytesPerSecond);
+        }
+        else
+        {
+            fprintf(stderr, ", analyzing\n");
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Read %.0f MB, %.0f MB/s, %.0f events/s\n", bytes / megabyte,
+                bytesPerSecond / megabyte, eventsPerSecond);
+    }
+    fflush(stderr);
+}
+
+void setProgressReporter(ProgressReporter* progress)
+{
+    s_progressReporter = progress;
+}
+
+ProgressReporter* currentProgressReporter()
+{
+    return s_progressReporter;
+}
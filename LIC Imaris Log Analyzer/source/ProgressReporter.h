@@ -0,0 +1,78 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+// Reports the progress of a long run on the standard error, so that a run
+// over large logs does not look hung: the percent of the input read, MB/s,
+// events/s and the time left.  The parser adds the bytes and events it has
+// consumed with relaxed atomics only; a thread of its own samples them and
+// prints a line every interval, the first one after one interval, so that
+// a short run stays quiet.  Without a total (e.g. for compressed logs,
+// whose text is larger than the files) the percent and time left are left
+// out.
+class ProgressReporter
+{
+    public:
+        explicit ProgressReporter(uint64_t totalBytes, chrono::milliseconds interval = chrono::seconds(1));
+        ~ProgressReporter();
+        ProgressReporter(const ProgressReporter&) = delete;
+        ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+        void add(uint64_t bytes, uint64_t events)
+        {
+            m_bytes.fetch_add(bytes, memory_order_relaxed);
+            m_events.fetch_add(events, memory_order_relaxed);
+        }
+
+    private:
+        void run();
+        void print(double seconds);
+
+        uint64_t m_totalBytes;
+        chrono::milliseconds m_interval;
+        chrono::steady_clock::time_point m_start;
+        atomic<uint64_t> m_bytes;
+        atomic<uint64_t> m_events;
+        bool m_printed;
+
+        mutex m_mutex;
+        condition_variable m_wakeUp;
+        bool m_stopped;
+        thread m_thread;
+};
+
+// The reporter the logs analyzed from now on add their progress to, or
+// NULL (the default) for none.  The caller keeps it alive until then.
+void setProgressReporter(ProgressReporter* progress);
+
+ProgressReporter* currentProgressReporter();
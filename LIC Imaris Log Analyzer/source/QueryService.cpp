@@ -0,0 +1,591 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "QueryService.h"
+#include "LogData.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <map>
+#include <boost/asio.hpp>
+
+using namespace std;
+
+namespace
+{
+    const char* UsageHelp =
+        "usage MM/DD/YYYY HH:MM[:SS]\n"
+        "peak MM/DD/YYYY HH:MM[:SS] MM/DD/YYYY HH:MM[:SS]\n"
+        "durations MM/DD/YYYY HH:MM[:SS] MM/DD/YYYY HH:MM[:SS] [users|hosts]\n"
+        "holders product MM/DD/YYYY HH:MM[:SS]\n"
+        "denials MM/DD/YYYY HH:MM[:SS] MM/DD/YYYY HH:MM[:SS]\n"
+        "run MM/DD/YYYY HH:MM[:SS]\n"
+        "rollups day|week|month [users|hosts]\n"
+        "lines session|denial|event|line number\n"
+        "summary\n"
+        "help\n"
+        "quit\n"
+        "shutdown\n";
+
+    void appendDateTime(string& text, long long timestamp)
+    {
+        char dateTime[MaxFormattedTimeLength];
+        text.append(dateTime, appendLogDateTime(dateTime, timestamp));
+    }
+
+    void appendDate(string& text, long long timestamp)
+    {
+        char date[MaxFormattedTimeLength];
+        text.append(date, appendLogDate(date, timestamp));
+    }
+
+    void appendError(string& response, const string& message)
+    {
+        response += "ERROR " + message + "\n";
+    }
+}
+
+QueryService::QueryService(const LogData& logData, unsigned short port)
+    : m_logData(logData),
+      m_port(port),
+      m_shutdown(false)
+{
+}
+
+void QueryService::run()
+{
+    using boost::asio::ip::tcp;
+
+    boost::asio::io_context context;
+    tcp::acceptor acceptor(context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), m_port));
+
+    while (! m_shutdown)
+    {
+        tcp::socket socket(context);
+        acceptor.accept(socket);
+
+        // A client that goes away ends only its own connection
+        boost::system::error_code error;
+        boost::asio::streambuf input;
+        bool open = true;
+        while (open && ! m_shutdown)
+        {
+            boost::asio::read_until(socket, input, '\n', error);
+            if (error)
+            {
+                break;
+            }
+
+            istream inputStream(&input);
+            string request;
+            getline(inputStream, request);
+            if (! request.empty() && request.back() == '\r')
+            {
+                request.pop_back();
+            }
+
+            string response;
+            open = answer(request, response);
+            response += '\n';
+            boost::asio::write(socket, boost::asio::buffer(response), error);
+            if (error)
+            {
+                break;
+            }
+        }
+        socket.shutdown(tcp::socket::shutdown_both, error);
+        socket.close(error);
+    }
+}
+
+bool QueryService::answer(string_view request, string& response)
+{
+    vector<string_view> tokens;
+    tokenizeStringView(" ", request, tokens);
+    if (tokens.empty())
+    {
+        appendError(response, "empty request");
+        return true;
+    }
+
+    if (tokens.at(0) == "usage")
+    {
+        answerUsage(tokens, response);
+    }
+    else if (tokens.at(0) == "peak")
+    {
+        answerPeak(tokens, response);
+    }
+    else if (tokens.at(0) == "durations")
+    {
+        answerDurations(tokens, response);
+    }
+    else if (tokens.at(0) == "holders")
+    {
+        answerHolders(tokens, response);
+    }
+    else if (tokens.at(0) == "denials")
+    {
+        answerDenials(tokens, response);
+    }
+    else if (tokens.at(0) == "run")
+    {
+        answerRun(tokens, response);
+    }
+    else if (tokens.at(0) == "rollups")
+    {
+        answerRollups(tokens, response);
+    }
+    else if (tokens.at(0) == "lines")
+    {
+        answerLines(tokens, response);
+    }
+    else if (tokens.at(0) == "summary")
+    {
+        answerSummary(tokens, response);
+    }
+    else if (tokens.at(0) == "help")
+    {
+        response += UsageHelp;
+    }
+    else if (tokens.at(0) == "quit")
+    {
+        return false;
+    }
+    else if (tokens.at(0) == "shutdown")
+    {
+        m_shutdown = true;
+        return false;
+    }
+    else
+    {
+        appendError(response, "unknown request " + string(tokens.at(0)));
+    }
+
+    return true;
+}
+
+bool QueryService::requestScope(string_view request, long long& from, long long& to, string& product)
+{
+    vector<string_view> tokens;
+    tokenizeStringView(" ", request, tokens);
+    product.clear();
+    if (tokens.empty())
+    {
+        return false;
+    }
+
+    if ((tokens.at(0) == "usage" || tokens.at(0) == "run") && tokens.size() == 3 && parseTime(tokens, 1, from))
+    {
+        to = from + 1;
+        return true;
+    }
+    if (tokens.at(0) == "holders" && tokens.size() == 4 && parseTime(tokens, 2, from))
+    {
+        to = from + 1;
+        product = string(tokens.at(1));
+        return true;
+    }
+    if ((tokens.at(0) == "peak" || tokens.at(0) == "durations" || tokens.at(0) == "denials") &&
+        parseTime(tokens, 1, from) && parseTime(tokens, 3, to))
+    {
+        return true;
+    }
+
+    return false;
+}
+
+// Reads the date and time tokens at index and index + 1
+bool QueryService::parseTime(const vector<string_view>& tokens, size_t index, long long& timestamp)
+{
+    DateTime dateTime;
+    dateTime.year = 0;
+    if (index + 1 >= tokens.size() ||
+        ! parseLogDate(tokens.at(index), dateTime) ||
+        ! parseLogTime(tokens.at(index + 1), dateTime) ||
+        dateTime.year == 0)
+    {
+        return false;
+    }
+    timestamp = dateTimeToEpoch(dateTime);
+
+    return true;
+}
+
+void QueryService::answerUsage(const vector<string_view>& tokens, string& response)
+{
+    long long timestamp;
+    if (tokens.size() != 3 || ! parseTime(tokens, 1, timestamp))
+    {
+        appendError(response, "expected usage MM/DD/YYYY HH:MM[:SS]");
+        return;
+    }
+
+    vector<UsageCounters> counters;
+    m_logData.usageAt(timestamp, counters);
+    appendCounters(counters, response);
+}
+
+// The peak of every counter between the two times, which need not all be
+// reached at the same time
+void QueryService::answerPeak(const vector<string_view>& tokens, string& response)
+{
+    long long from;
+    long long to;
+    if (tokens.size() != 5 || ! parseTime(tokens, 1, from) || ! parseTime(tokens, 3, to))
+    {
+        appendError(response, "expected peak MM/DD/YYYY HH:MM[:SS] MM/DD/YYYY HH:MM[:SS]");
+        return;
+    }
+
+    vector<UsageCounters> maxima;
+    m_logData.peakUsage(from, to, maxima);
+    appendCounters(maxima, response);
+}
+
+void QueryService::appendCounters(const vector<UsageCounters>& counters, string& response)
+{
+    response += "Product,Floating Licenses in use,Total Licenses in use,"
+                "Floating Licenses Limit,Reserved Licenses in use,Reserved Licenses Limit\n";
+    for (size_t product = 0; product < counters.size(); ++product)
+    {
+        const UsageCounters& productCounters = counters.at(product);
+        response += m_logData.uniqueProducts().name(product);
+        response += ',' + to_string(productCounters.floatingInUse);
+        response += ',' + to_string(productCounters.totalInUse);
+        response += ',' + to_string(productCounters.floatingLimit);
+        response += ',' + to_string(productCounters.reservedInUse);
+        response += ',' + to_string(productCounters.reservedLimit);
+        response += '\n';
+    }
+}
+
+// Sums the part of every session that falls into the interval by user (or
+// host) and product.  Only the non-zero sums are listed.
+void QueryService::answerDurations(const vector<string_view>& tokens, string& response)
+{
+    long long from;
+    long long to;
+    bool byHost = tokens.size() == 6 && tokens.at(5) == "hosts";
+    if ((tokens.size() != 5 && tokens.size() != 6) ||
+        (tokens.size() == 6 && tokens.at(5) != "users" && ! byHost) ||
+        ! parseTime(tokens, 1, from) || ! parseTime(tokens, 3, to))
+    {
+        appendError(response, "expected durations MM/DD/YYYY HH:MM[:SS] MM/DD/YYYY HH:MM[:SS] [users|hosts]");
+        return;
+    }
+
+    const SessionIndex& sessionIndex = m_logData.sessionIndex();
+    const StringInterner& names = byHost ? m_logData.uniqueHosts() : m_logData.uniqueUsers();
+    const size_t numberOfProducts = m_logData.uniqueProducts().size();
+    const vector<size_t>& keys = byHost ? sessionIndex.hostProducts() : sessionIndex.userProducts();
+
+    response += byHost ? "Host" : "User";
+    response += ",Product,Duration (seconds)\n";
+    for (size_t key = 0; key < keys.size(); ++key)
+    {
+        size_t name = keys.at(key) / numberOfProducts;
+        size_t product = keys.at(key) % numberOfProducts;
+        long long duration = byHost ? sessionIndex.hostDuration(name, product, from, to)
+                                    : sessionIndex.userDuration(name, product, from, to);
+        if (duration > 0)
+        {
+            response += names.name(name);
+            response += ',';
+            response += m_logData.uniqueProducts().name(product);
+            response += ',' + to_string(duration) + '\n';
+        }
+    }
+}
+
+// The sessions of a product that held a license at the time, in check-out
+// order
+void QueryService::answerHolders(const vector<string_view>& tokens, string& response)
+{
+    long long timestamp;
+    size_t product;
+    if (tokens.size() != 4 || ! parseTime(tokens, 2, timestamp))
+    {
+        appendError(response, "expected holders product MM/DD/YYYY HH:MM[:SS]");
+        return;
+    }
+    if (! m_logData.uniqueProducts().find(tokens.at(1), product))
+    {
+        appendError(response, "unknown product " + string(tokens.at(1)));
+        return;
+    }
+
+    const EventStore& events = m_logData.events();
+    const vector<Session>& sessions = m_logData.sessions();
+    vector<size_t> holders;
+    m_logData.sessionIndex().heldAt(product, timestamp, holders);
+
+    response += "User,Host,Check out\n";
+    for (size_t holder = 0; holder < holders.size(); ++holder)
+    {
+        size_t row = sessions.at(holders.at(holder)).checkOutRow;
+        response += m_logData.uniqueUsers().name(events.users.at(row));
+        response += ',';
+        response += m_logData.uniqueHosts().name(events.hosts.at(row));
+        response += ',';
+        appendDateTime(response, events.timestamps.at(row));
+        response += '\n';
+    }
+}
+
+// Denied requests in the interval, counted per hour.  Only the hours with
+// denials are listed.
+void QueryService::answerDenials(const vector<string_view>& tokens, string& response)
+{
+    long long from;
+    long long to;
+    if (tokens.size() != 5 || ! parseTime(tokens, 1, from) || ! parseTime(tokens, 3, to))
+    {
+        appendError(response, "expected denials MM/DD/YYYY HH:MM[:SS] MM/DD/YYYY HH:MM[:SS]");
+        return;
+    }
+
+    const EventStore& events = m_logData.events();
+    const vector<size_t>& denialRows = m_logData.denialRows();
+    map<long long, size_t> denialsByHour;
+    for (size_t denial = 0; denial < denialRows.size(); ++denial)
+    {
+        long long timestamp = events.timestamps.at(denialRows.at(denial));
+        if (timestamp >= from && timestamp < to)
+        {
+            ++denialsByHour[timestamp - timestamp % 3600];
+        }
+    }
+
+    response += "Hour,Denials\n";
+    for (map<long long, size_t>::const_iterator hour = denialsByHour.begin(); hour != denialsByHour.end(); ++hour)
+    {
+        appendDateTime(response, hour->first);
+        response += ',' + to_string(hour->second) + '\n';
+    }
+}
+
+// The run of the license server at the time, found in the index of the
+// START and SHUTDOWN events.  Runs are counted from 1; the first one begins
+// with the log unless the log begins with a START.
+void QueryService::answerRun(const vector<string_view>& tokens, string& response)
+{
+    long long timestamp;
+    if (tokens.size() != 3 || ! parseTime(tokens, 1, timestamp))
+    {
+        appendError(response, "expected run MM/DD/YYYY HH:MM[:SS]");
+        return;
+    }
+
+    const EventStore& events = m_logData.events();
+    const ServerRuns& runs = m_logData.serverRuns();
+    size_t run = runs.runAt(timestamp);
+    size_t beginRow = runs.beginRow(run);
+    size_t endRow = runs.endRow(run);
+
+    response += "Run,Begin,Begin Event,End,End Event,Server\n";
+    response += to_string(run + 1) + ',';
+    if (beginRow != NoId)
+    {
+        appendDateTime(response, events.timestamps.at(beginRow));
+        response += ',' + eventTypeName(events.types.at(beginRow));
+    }
+    else
+    {
+        response += ",log start";
+    }
+    response += ',';
+    if (endRow != NoId)
+    {
+        appendDateTime(response, events.timestamps.at(endRow));
+        response += ',' + eventTypeName(events.types.at(endRow));
+    }
+    else
+    {
+        response += ",log end";
+    }
+    response += ',';
+    // START events keep their license server in the host column
+    if (beginRow != NoId && events.types.at(beginRow) == StartEvent && events.hosts.at(beginRow) != NoId)
+    {
+        response += m_logData.uniqueServers().name(events.hosts.at(beginRow));
+    }
+    response += '\n';
+}
+
+// The rollups kept with the event cache, by period start.  Only the periods
+// with usage, denials or sessions are listed.
+void QueryService::answerRollups(const vector<string_view>& tokens, string& response)
+{
+    rollupPeriod period;
+    bool byHost = tokens.size() == 3 && tokens.at(2) == "hosts";
+    if ((tokens.size() != 2 && tokens.size() != 3) ||
+        (tokens.size() == 3 && tokens.at(2) != "users" && ! byHost) ||
+        ! UsageRollups::parsePeriod(tokens.at(1), period))
+    {
+        appendError(response, "expected rollups day|week|month [users|hosts]");
+        return;
+    }
+    const UsageRollups& rollups = m_logData.rollups();
+    if (rollups.empty())
+    {
+        appendError(response, "no rollups, the log was not analyzed with the event cache");
+        return;
+    }
+
+    const StringInterner& products = m_logData.uniqueProducts();
+    if (tokens.size() == 2)
+    {
+        response += "Period,Product,Peak Floating Licenses in use,Mean Floating Licenses in use,Denials\n";
+        for (const auto& usage : rollups.usage(period))
+        {
+            char mean[32];
+            snprintf(mean, sizeof(mean), "%.2f", rollups.mean(period, usage.first.first, usage.first.second));
+            appendDate(response, usage.first.first);
+            response += ',';
+            response += products.name(usage.first.second);
+            response += ',' + to_string(usage.second.peak) + ',' + mean + ',' + to_string(usage.second.denials) + '\n';
+        }
+        return;
+    }
+
+    const StringInterner& names = byHost ? m_logData.uniqueHosts() : m_logData.uniqueUsers();
+    response += byHost ? "Period,Host" : "Period,User";
+    response += ",Product,Duration (seconds)\n";
+    for (const auto& duration : byHost ? rollups.hostDurations(period) : rollups.userDurations(period))
+    {
+        appendDate(response, get<0>(duration.first));
+        response += ',';
+        response += names.name(get<1>(duration.first));
+        response += ',';
+        response += products.name(get<2>(duration.first));
+        response += ',' + to_string(duration.second) + '\n';
+    }
+}
+
+// The raw lines of the log behind a session (its check-out and check-in), a
+// denial, an event or a line, all numbered from 1 in the order of the log
+void QueryService::answerLines(const vector<string_view>& tokens, string& response)
+{
+    size_t number = 0;
+    if (tokens.size() == 3)
+    {
+        number = static_cast<size_t>(stringViewToInt(tokens.at(2)));
+    }
+    if (tokens.size() != 3 || number == 0 ||
+        (tokens.at(1) != "session" && tokens.at(1) != "denial" && tokens.at(1) != "event" && tokens.at(1) != "line"))
+    {
+        appendError(response, "expected lines session|denial|event|line number");
+        return;
+    }
+
+    vector<uint64_t> lines;
+    if (tokens.at(1) == "line")
+    {
+        lines.push_back(number);
+    }
+    else
+    {
+        vector<size_t> rows;
+        if (tokens.at(1) == "session" && number <= m_logData.sessions().size())
+        {
+            const Session& session = m_logData.sessions().at(number - 1);
+            rows.push_back(session.checkOutRow);
+            if (session.checkInRow != NoId)
+            {
+                rows.push_back(session.checkInRow);
+            }
+        }
+        else if (tokens.at(1) == "denial" && number <= m_logData.denialRows().size())
+        {
+            rows.push_back(m_logData.denialRows().at(number - 1));
+        }
+        else if (tokens.at(1) == "event" && number <= m_logData.events().size())
+        {
+            rows.push_back(number - 1);
+        }
+        if (rows.empty())
+        {
+            appendError(response, "no " + string(tokens.at(1)) + " " + string(tokens.at(2)));
+            return;
+        }
+        for (size_t row = 0; row < rows.size(); ++row)
+        {
+            lines.push_back(m_logData.eventLine(rows.at(row)));
+        }
+    }
+
+    vector<string> texts(lines.size());
+    for (size_t line = 0; line < lines.size(); ++line)
+    {
+        if (! m_logData.readLogLine(lines.at(line), texts.at(line)))
+        {
+            appendError(response, "line not indexed, the log is compressed or its events were not parsed from it");
+            return;
+        }
+    }
+    response += "Line,Text\n";
+    for (size_t line = 0; line < lines.size(); ++line)
+    {
+        response += to_string(lines.at(line)) + ',' + texts.at(line) + '\n';
+    }
+}
+
+// The summary of the log so far from its event totals, so it takes no walk
+// over the events however long the log grew.  Statistics of the whole log
+// leave the product empty.
+void QueryService::answerSummary(const vector<string_view>& tokens, string& response)
+{
+    if (tokens.size() != 1)
+    {
+        appendError(response, "expected summary");
+        return;
+    }
+
+    const EventTotals& totals = m_logData.eventTotals();
+    const StringInterner& products = m_logData.uniqueProducts();
+    response += "Statistic,Product,Value\n";
+    if (totals.firstTime() != LLONG_MAX)
+    {
+        response += "First Event,,";
+        appendDateTime(response, totals.firstTime());
+        response += "\nLast Event,,";
+        appendDateTime(response, m_logData.endTime());
+        response += '\n';
+    }
+    const eventType types[] = { OutEvent, InEvent, DenyEvent, StartEvent, ShutdownEvent, ProductEvent };
+    for (eventType type : types)
+    {
+        response += eventTypeName(type) + " Events,," + to_string(totals.events(type)) + '\n';
+    }
+    response += "Products,," + to_string(products.size()) + '\n';
+    response += "Users,," + to_string(m_logData.uniqueUsers().size()) + '\n';
+    response += "Hosts,," + to_string(m_logData.uniqueHosts().size()) + '\n';
+    for (size_t product = 0; product < products.size(); ++product)
+    {
+        response += "Denied Requests,";
+        response += products.name(product);
+        response += ',' + to_string(totals.denials(product)) + '\n';
+    }
+}
@@ -0,0 +1,110 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+class LogData;
+struct UsageCounters;
+
+// Keeps an analyzed log in memory and answers queries about it over a TCP
+// connection on the loopback interface, so that scripts can ask questions
+// without the log being parsed again for each one.  The protocol is line
+// based: every request is one line, and the answer is a number of CSV lines
+// followed by an empty line.  Times are given as in the log, "MM/DD/YYYY
+// HH:MM[:SS]", and intervals are half-open [from, to).
+//
+//   usage <time>                        counters of every product at <time>
+//   peak <from> <to>                    largest counters of every product
+//                                       between <from> and <to>
+//   durations <from> <to> [users|hosts] checked out time per user (or host)
+//                                       and product, clipped to the interval
+//   holders <product> <time>            user, host and check-out time of
+//                                       the sessions holding the product
+//   denials <from> <to>                 denied requests per hour
+//   run <time>                          the run of the license server at
+//                                       <time>: the START or SHUTDOWN it
+//                                       began and ended with, and its
+//                                       server
+//   rollups day|week|month [users|hosts] peak and mean floating licenses in
+//                                       use and denied requests per product,
+//                                       or checked out time per user (or
+//                                       host) and product, of every period;
+//                                       needs the event cache (-e)
+//   lines session|denial|event|line <n> the raw lines of the log behind the
+//                                       n-th session (check-out and
+//                                       check-in), denial or event, or
+//                                       line n; not for a compressed log or
+//                                       events of the event cache
+//   summary                             first and last event time, events
+//                                       by type, distinct products, users
+//                                       and hosts, and denied requests per
+//                                       product, from the totals kept while
+//                                       the log is read
+//   help                                the list of requests
+//   quit                                closes the connection
+//   shutdown                            stops the service
+//
+// Errors are answered with a line starting with "ERROR".  Connections are
+// served one after the other.  The log must outlive the service.
+class QueryService
+{
+    public:
+        QueryService(const LogData& logData, unsigned short port);
+        QueryService(const QueryService&) = delete;
+        QueryService& operator=(const QueryService&) = delete;
+
+        // Serves connections until a shutdown request
+        void run();
+
+        // Answers one request line.  Returns false if the connection should
+        // be closed after the response.
+        bool answer(string_view request, string& response);
+
+        // The interval [from, to) of the log a request asks about, and the
+        // product it asks about, empty for every product.  Returns false for
+        // a request that asks about no interval, e.g. rollups, or that is
+        // not valid.
+        static bool requestScope(string_view request, long long& from, long long& to, string& product);
+
+    private:
+        static bool parseTime(const vector<string_view>& tokens, size_t index, long long& timestamp);
+        void answerUsage(const vector<string_view>& tokens, string& response);
+        void answerPeak(const vector<string_view>& tokens, string& response);
+        void appendCounters(const vector<UsageCounters>& counters, string& response);
+        void answerDurations(const vector<string_view>& tokens, string& response);
+        void answerHolders(const vector<string_view>& tokens, string& response);
+        void answerDenials(const vector<string_view>& tokens, string& response);
+        void answerRun(const vector<string_view>& tokens, string& response);
+        void answerRollups(const vector<string_view>& tokens, string& response);
+        void answerLines(const vector<string_view>& tokens, string& response);
+        void answerSummary(const vector<string_view>& tokens, string& response);
+
+        const LogData& m_logData;
+        unsigned short m_port;
+        bool m_shutdown;
+};
@@ -0,0 +1,109 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ReorderBuffer.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ReorderBuffer::ReorderBuffer()
+    : m_window(0)
+{
+    clear();
+}
+
+void ReorderBuffer::setWindow(long long window)
+{
+    m_window = window;
+}
+
+void ReorderBuffer::clear()
+{
+    m_held = priority_queue< HeldEvent, vector<HeldEvent>, greater<HeldEvent> >();
+    m_last = LLONG_MIN;
+    m_latest = LLONG_MIN;
+    m_released = LLONG_MIN;
+    m_lateEvents = 0;
+    m_unorderedEvents = 0;
+}
+
+void ReorderBuffer::push(long long timestamp, size_t event, vector<size_t>& released)
+{
+    if (timestamp < m_latest)
+    {
+        ++m_lateEvents;
+        if (timestamp < m_released)
+        {
+            ++m_unorderedEvents;
+        }
+    }
+    else
+    {
+        m_latest = timestamp;
+    }
+    m_last = timestamp;
+    m_held.push(HeldEvent(timestamp, event));
+
+    // Nothing that comes later may be released before the events up to
+    // window seconds before the latest time
+    while (! m_held.empty() && m_held.top().first <= m_latest - m_window)
+    {
+        release(released);
+    }
+}
+
+void ReorderBuffer::pushUntimed(size_t event, vector<size_t>& released)
+{
+    if (m_held.empty())
+    {
+        released.push_back(event);
+        return;
+    }
+    m_held.push(HeldEvent(m_last, event));
+}
+
+void ReorderBuffer::flush(vector<size_t>& released)
+{
+    while (! m_held.empty())
+    {
+        release(released);
+    }
+}
+
+size_t ReorderBuffer::lateEvents() const
+{
+    return m_lateEvents;
+}
+
+size_t ReorderBuffer::unorderedEvents() const
+{
+    return m_unorderedEvents;
+}
+
+void ReorderBuffer::release(vector<size_t>& released)
+{
+    m_released = max(m_released, m_held.top().first);
+    released.push_back(m_held.top().second);
+    m_held.pop();
+}
@@ -0,0 +1,82 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Puts events that come slightly out of time order back in order as they
+// stream past, e.g. those of logs merged from failover servers or written
+// around a change to or from daylight saving time.  An event is held until
+// one at least window seconds later has come, so only the events of the
+// last window seconds are held, in a heap, and an event up to window
+// seconds late is released in its place.  Events of the same time keep
+// their order.  An event later than that is released at once, still out of
+// order, as the events after it may already be gone.
+class ReorderBuffer
+{
+    public:
+        ReorderBuffer();
+
+        void setWindow(long long window);
+        void clear();
+
+        // Takes the next event, numbered in the order it came, and appends
+        // the events it releases to released
+        void push(long long timestamp, size_t event, vector<size_t>& released);
+
+        // Takes an event without a time of its own, e.g. a PRODUCT line,
+        // which stays right after the event before it
+        void pushUntimed(size_t event, vector<size_t>& released);
+
+        // Releases the events still held, e.g. at the end of a run of
+        // events that must all be released
+        void flush(vector<size_t>& released);
+
+        // Events that came after a later one, and those of them that were
+        // too late to be put back in order
+        size_t lateEvents() const;
+        size_t unorderedEvents() const;
+
+    private:
+        void release(vector<size_t>& released);
+
+        typedef pair<long long, size_t> HeldEvent;
+
+        long long m_window;
+        priority_queue< HeldEvent, vector<HeldEvent>, greater<HeldEvent> > m_held;
+        // The time of the last event pushed, the latest time seen and the
+        // time of the last event released
+        long long m_last;
+        long long m_latest;
+        long long m_released;
+        size_t m_lateEvents;
+        size_t m_unorderedEvents;
+};
@@ -0,0 +1,209 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ResourceLimits.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // The share of the memory limit the buffers may take together
+    const uint64_t BufferShareDivisor = 4;
+
+    atomic<size_t> s_threadLimit(0);
+    atomic<uint64_t> s_memoryLimit(0);
+
+    // The CPUs the process may run on, 0 if the system does not tell
+    size_t allowedCpus()
+    {
+#ifdef _WIN32
+        DWORD_PTR processMask;
+        DWORD_PTR systemMask;
+        if (! GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        {
+            return 0;
+        }
+        size_t cpus = 0;
+        for (; processMask != 0; processMask &= processMask - 1)
+        {
+            ++cpus;
+        }
+        return cpus;
+#elif defined(__linux__)
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        {
+            return 0;
+        }
+        return static_cast<size_t>(CPU_COUNT(&set));
+#else
+        return 0;
+#endif
+    }
+
+    // Reads a list of CPU numbers and ranges, e.g. "0-3,6"
+    bool parseCpuList(const string& cpus, vector<size_t>& numbers)
+    {
+        size_t position = 0;
+        while (position < cpus.size())
+        {
+            size_t end = cpus.find(',', position);
+            string item = cpus.substr(position, end == string::npos ? string::npos : end - position);
+            size_t dash = item.find('-');
+            string first = item.substr(0, dash);
+            string last = (dash == string::npos) ? first : item.substr(dash + 1);
+            if (first.empty() || last.empty() || first.find_first_not_of("0123456789") != string::npos ||
+                last.find_first_not_of("0123456789") != string::npos || first.size() > 4 || last.size() > 4)
+            {
+                return false;
+            }
+            size_t from = stoul(first);
+            size_t to = stoul(last);
+            if (to < from)
+            {
+                return false;
+            }
+            for (size_t cpu = from; cpu <= to; ++cpu)
+            {
+                numbers.push_back(cpu);
+            }
+            if (end == string::npos)
+            {
+                break;
+            }
+            position = end + 1;
+        }
+        return ! numbers.empty() && position < cpus.size();
+    }
+}
+
+void setThreadLimit(size_t threads)
+{
+    s_threadLimit = threads;
+}
+
+size_t availableThreads()
+{
+    size_t threads = s_threadLimit;
+    if (threads == 0)
+    {
+        threads = allowedCpus();
+    }
+    if (threads == 0)
+    {
+        threads = thread::hardware_concurrency();
+    }
+    return max(threads, static_cast<size_t>(1));
+}
+
+bool setCpuAffinity(const string& cpus)
+{
+    vector<size_t> numbers;
+    if (! parseCpuList(cpus, numbers))
+    {
+        return false;
+    }
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (size_t cpu : numbers)
+    {
+        if (cpu >= 8 * sizeof(DWORD_PTR))
+        {
+            return false;
+        }
+        mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    return SetProcessAffinityMask(GetCurrentProcess(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t cpu : numbers)
+    {
+        if (cpu >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+bool lowerProcessPriority()
+{
+#ifdef _WIN32
+    return SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN) != 0 ||
+           SetPriorityClass(GetCurrentProcess(), IDLE_PRIORITY_CLASS) != 0;
+#else
+    // Threads started later take the nice value and I/O priority over
+    bool lowered = setpriority(PRIO_PROCESS, 0, 19) == 0;
+#ifdef __linux__
+    const int ioprioWhoProcess = 1;
+    const int ioprioClassIdle = 3;
+    const int ioprioClassShift = 13;
+    syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioprioClassIdle << ioprioClassShift);
+#endif
+    return lowered;
+#endif
+}
+
+void setMemoryLimit(uint64_t bytes)
+{
+    s_memoryLimit = bytes;
+}
+
+uint64_t memoryLimit()
+{
+    return s_memoryLimit;
+}
+
+size_t limitedBufferSize(size_t wanted, size_t minimum, size_t count)
+{
+    uint64_t limit = s_memoryLimit;
+    if (limit == 0)
+    {
+        return wanted;
+    }
+    uint64_t share = limit / BufferShareDivisor / max(count, static_cast<size_t>(1));
+    return static_cast<size_t>(max<uint64_t>(min<uint64_t>(wanted, share), minimum));
+}
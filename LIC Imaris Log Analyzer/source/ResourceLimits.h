@@ -0,0 +1,61 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Limits on the threads, CPUs and memory an analysis takes, e.g. one run on
+// the license server itself, which must not starve RLM.  They are set once
+// by the front end before any pool or log is created, and the stages size
+// their threads and buffers by them: under a memory limit they degrade to
+// smaller blocks and buffers and one log of a batch at a time rather than
+// take more memory.
+
+// The worker threads of a pool created without a count; 0 for one per CPU
+// the process may run on
+void setThreadLimit(size_t threads);
+size_t availableThreads();
+
+// Restricts the process to the CPUs of a list like "0-3,6", before any of
+// its threads is started.  Returns false for a list that is not valid, or
+// if the system does not allow it.
+bool setCpuAffinity(const string& cpus);
+
+// Lowers the CPU and I/O priority of the process to that of background
+// work, before any of its threads is started.  Returns false if the system
+// does not allow it.
+bool lowerProcessPriority();
+
+// The memory the analysis should stay within, in bytes; 0 for no limit.
+// The events of a log are held in memory whatever the limit; the buffers
+// around them give way.
+void setMemoryLimit(uint64_t bytes);
+uint64_t memoryLimit();
+
+// The size of one of count buffers in use at once, which together take at
+// most a quarter of the memory limit: wanted without a limit, and never
+// less than minimum
+size_t limitedBufferSize(size_t wanted, size_t minimum, size_t count);
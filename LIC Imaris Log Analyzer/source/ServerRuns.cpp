@@ -0,0 +1,89 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ServerRuns.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void ServerRuns::clear()
+{
+    m_rows.clear();
+    m_times.clear();
+    m_startsIndexed = 0;
+    m_shutdownsIndexed = 0;
+}
+
+size_t ServerRuns::memoryBytes() const
+{
+    return heapBytes(m_rows) + heapBytes(m_times);
+}
+
+void ServerRuns::extend(const EventStore& events, const vector<size_t>& startRows, const vector<size_t>& shutdownRows)
+{
+    while (m_startsIndexed < startRows.size() || m_shutdownsIndexed < shutdownRows.size())
+    {
+        size_t startRow = (m_startsIndexed < startRows.size()) ? startRows[m_startsIndexed] : NoId;
+        size_t shutdownRow = (m_shutdownsIndexed < shutdownRows.size()) ? shutdownRows[m_shutdownsIndexed] : NoId;
+        size_t row;
+        if (startRow < shutdownRow)
+        {
+            row = startRow;
+            ++m_startsIndexed;
+        }
+        else
+        {
+            row = shutdownRow;
+            ++m_shutdownsIndexed;
+        }
+        m_rows.push_back(row);
+        m_times.push_back(m_times.empty() ? events.timestamps[row] : max(m_times.back(), events.timestamps[row]));
+    }
+}
+
+size_t ServerRuns::runs() const
+{
+    return m_rows.size() + 1;
+}
+
+size_t ServerRuns::runOfRow(size_t row) const
+{
+    return upper_bound(m_rows.begin(), m_rows.end(), row) - m_rows.begin();
+}
+
+size_t ServerRuns::runAt(long long time) const
+{
+    return upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin();
+}
+
+size_t ServerRuns::beginRow(size_t run) const
+{
+    return (run > 0 && run <= m_rows.size()) ? m_rows[run - 1] : NoId;
+}
+
+size_t ServerRuns::endRow(size_t run) const
+{
+    return (run < m_rows.size()) ? m_rows[run] : NoId;
+}
@@ -0,0 +1,71 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <vector>
+#include "EventStore.h"
+
+using namespace std;
+
+// The runs of the license server a log covers, split at its START and
+// SHUTDOWN events (the boundaries): run 0 is what comes before the first
+// boundary, and run r begins at boundary r - 1 and ends at boundary r, or
+// at the end of the log.  The boundaries are taken from the START and
+// SHUTDOWN row lists as the log is read, so the run of an event or of a
+// time is a binary search over the few boundaries rather than a walk over
+// the events.  A log that goes back in time keeps the latest time seen so
+// far at each boundary, so the search by time stays ordered.
+class ServerRuns
+{
+    public:
+        ServerRuns() : m_startsIndexed(0), m_shutdownsIndexed(0) {}
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Takes the boundaries the row lists gained since the last call.
+        // The rows must not have moved since then.
+        void extend(const EventStore& events, const vector<size_t>& startRows, const vector<size_t>& shutdownRows);
+
+        // One more than there are boundaries
+        size_t runs() const;
+
+        // The run the event of row is in; a boundary begins its run
+        size_t runOfRow(size_t row) const;
+        // The run the time falls in, that of the last boundary at or before
+        // it
+        size_t runAt(long long time) const;
+
+        // The row of the boundary that begins the run, NoId for run 0, and
+        // of the one that ends it, NoId for the last run
+        size_t beginRow(size_t run) const;
+        size_t endRow(size_t run) const;
+
+    private:
+        vector<size_t> m_rows;
+        vector<long long> m_times;
+        size_t m_startsIndexed;
+        size_t m_shutdownsIndexed;
+};
@@ -0,0 +1,322 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SessionIndex.h"
+#include "HeapBytes.h"
+#include "LogData.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+void SessionIndex::build(const EventStore& events,
+                         const vector<Session>& sessions,
+                         size_t numberOfProducts,
+                         size_t numberOfUsers,
+                         size_t numberOfHosts)
+{
+    clear();
+    m_numberOfProducts = numberOfProducts;
+
+    // Check-out and check-in of every session that held a license for a
+    // while, by product
+    vector< vector<size_t> > productSessions(numberOfProducts);
+    vector<long long> checkIns(sessions.size(), LLONG_MIN);
+    for (size_t session = 0; session < sessions.size(); ++session)
+    {
+        size_t row = sessions.at(session).checkOutRow;
+        long long checkOut = events.timestamps.at(row);
+        long long checkIn = checkOut + sessions.at(session).duration;
+        if (checkIn <= checkOut)
+        {
+            continue;
+        }
+        checkIns.at(session) = checkIn;
+
+        productSessions.at(events.products.at(row)).push_back(session);
+    }
+
+    m_productSessions.resize(numberOfProducts);
+    for (size_t product = 0; product < numberOfProducts; ++product)
+    {
+        vector<size_t>& productSession = productSessions.at(product);
+        stable_sort(productSession.begin(), productSession.end(), [&](size_t first, size_t second)
+        {
+            return events.timestamps[sessions[first].checkOutRow] < events.timestamps[sessions[second].checkOutRow];
+        });
+
+        ProductSessions& indexed = m_productSessions.at(product);
+        indexed.sessions = productSession;
+        indexed.leafCount = 1;
+        while (indexed.leafCount < productSession.size())
+        {
+            indexed.leafCount *= 2;
+        }
+        indexed.maxCheckIns.assign(2 * indexed.leafCount, LLONG_MIN);
+        indexed.checkOuts.reserve(productSession.size());
+        for (size_t position = 0; position < productSession.size(); ++position)
+        {
+            indexed.checkOuts.push_back(events.timestamps.at(sessions.at(productSession.at(position)).checkOutRow));
+            indexed.maxCheckIns.at(indexed.leafCount + position) = checkIns.at(productSession.at(position));
+        }
+        for (size_t node = indexed.leafCount - 1; node > 0; --node)
+        {
+            indexed.maxCheckIns.at(node) = max(indexed.maxCheckIns.at(2 * node), indexed.maxCheckIns.at(2 * node + 1));
+        }
+    }
+
+    // The changes of the open sessions by user (host) and product, one
+    // table after the other
+    vector<SessionChange> changes;
+    changes.reserve(2 * sessions.size());
+    for (int byHost = 0; byHost < 2; ++byHost)
+    {
+        changes.clear();
+        for (size_t session = 0; session < sessions.size(); ++session)
+        {
+            size_t row = sessions.at(session).checkOutRow;
+            if (checkIns.at(session) == LLONG_MIN)
+            {
+                continue;
+            }
+            size_t name = byHost ? events.hosts.at(row) : events.users.at(row);
+            size_t key = name * numberOfProducts + events.products.at(row);
+            changes.push_back({key, events.timestamps.at(row), 1});
+            changes.push_back({key, checkIns.at(session), -1});
+        }
+
+        if (byHost)
+        {
+            m_hostIntegrals.build(changes, numberOfHosts * numberOfProducts, m_hostProducts);
+        }
+        else
+        {
+            m_userIntegrals.build(changes, numberOfUsers * numberOfProducts, m_userProducts);
+        }
+    }
+}
+
+void SessionIndex::clear()
+{
+    m_numberOfProducts = 0;
+    m_productSessions.clear();
+    m_userIntegrals.clear();
+    m_hostIntegrals.clear();
+    m_userProducts.clear();
+    m_hostProducts.clear();
+}
+
+size_t SessionIndex::memoryBytes() const
+{
+    size_t bytes = heapBytes(m_productSessions) + heapBytes(m_userProducts) + heapBytes(m_hostProducts);
+    for (size_t product = 0; product < m_productSessions.size(); ++product)
+    {
+        const ProductSessions& sessions = m_productSessions.at(product);
+        bytes += heapBytes(sessions.checkOuts) + heapBytes(sessions.sessions) + heapBytes(sessions.maxCheckIns);
+    }
+    const UsageIntegrals* integrals[] = { &m_userIntegrals, &m_hostIntegrals };
+    for (size_t index = 0; index < 2; ++index)
+    {
+        bytes += heapBytes(integrals[index]->offsets) + heapBytes(integrals[index]->times) +
+                 heapBytes(integrals[index]->openCounts) + heapBytes(integrals[index]->openSeconds);
+    }
+    return bytes;
+}
+
+void SessionIndex::overlapping(size_t product, long long from, long long to, vector<size_t>& sessions) const
+{
+    sessions.clear();
+    if (product >= m_productSessions.size() || from >= to)
+    {
+        return;
+    }
+
+    // Only the sessions checked out before to can overlap; of those, the
+    // tree is descended into the subtrees with a check-in after from
+    const ProductSessions& productSessions = m_productSessions.at(product);
+    size_t checkOutEnd = lower_bound(productSessions.checkOuts.begin(), productSessions.checkOuts.end(), to) - productSessions.checkOuts.begin();
+    collectOverlapping(productSessions, 1, 0, productSessions.leafCount, checkOutEnd, from, sessions);
+}
+
+size_t SessionIndex::nextOverlapping(size_t product, long long from, long long to, size_t& position) const
+{
+    if (product >= m_productSessions.size() || from >= to)
+    {
+        return NoId;
+    }
+
+    const ProductSessions& productSessions = m_productSessions.at(product);
+    size_t checkOutEnd = lower_bound(productSessions.checkOuts.begin(), productSessions.checkOuts.end(), to) - productSessions.checkOuts.begin();
+    size_t found = firstOverlapping(productSessions, 1, 0, productSessions.leafCount, position, checkOutEnd, from);
+    if (found == NoId)
+    {
+        position = checkOutEnd;
+        return NoId;
+    }
+    position = found + 1;
+    return productSessions.sessions[found];
+}
+
+void SessionIndex::heldAt(size_t product, long long time, vector<size_t>& sessions) const
+{
+    overlapping(product, time, time + 1, sessions);
+}
+
+long long SessionIndex::userDuration(size_t user, size_t product, long long from, long long to) const
+{
+    return m_userIntegrals.clippedDuration(user * m_numberOfProducts + product, from, to);
+}
+
+long long SessionIndex::hostDuration(size_t host, size_t product, long long from, long long to) const
+{
+    return m_hostIntegrals.clippedDuration(host * m_numberOfProducts + product, from, to);
+}
+
+const vector<size_t>& SessionIndex::userProducts() const
+{
+    return m_userProducts;
+}
+
+const vector<size_t>& SessionIndex::hostProducts() const
+{
+    return m_hostProducts;
+}
+
+void SessionIndex::collectOverlapping(const ProductSessions& productSessions,
+                                      size_t node,
+                                      size_t nodeBegin,
+                                      size_t nodeEnd,
+                                      size_t checkOutEnd,
+                                      long long from,
+                                      vector<size_t>& sessions) const
+{
+    if (nodeBegin >= checkOutEnd || productSessions.maxCheckIns[node] <= from)
+    {
+        return;
+    }
+    if (node >= productSessions.leafCount)
+    {
+        sessions.push_back(productSessions.sessions[nodeBegin]);
+        return;
+    }
+
+    size_t nodeMiddle = nodeBegin + (nodeEnd - nodeBegin) / 2;
+    collectOverlapping(productSessions, 2 * node, nodeBegin, nodeMiddle, checkOutEnd, from, sessions);
+    collectOverlapping(productSessions, 2 * node + 1, nodeMiddle, nodeEnd, checkOutEnd, from, sessions);
+}
+
+// The first position from position on and before checkOutEnd whose session
+// is checked in after from, or NoId
+size_t SessionIndex::firstOverlapping(const ProductSessions& productSessions,
+                                      size_t node,
+                                      size_t nodeBegin,
+                                      size_t nodeEnd,
+                                      size_t position,
+                                      size_t checkOutEnd,
+                                      long long from) const
+{
+    if (nodeEnd <= position || nodeBegin >= checkOutEnd || productSessions.maxCheckIns[node] <= from)
+    {
+        return NoId;
+    }
+    if (node >= productSessions.leafCount)
+    {
+        return nodeBegin;
+    }
+
+    size_t nodeMiddle = nodeBegin + (nodeEnd - nodeBegin) / 2;
+    size_t found = firstOverlapping(productSessions, 2 * node, nodeBegin, nodeMiddle, position, checkOutEnd, from);
+    if (found != NoId)
+    {
+        return found;
+    }
+    return firstOverlapping(productSessions, 2 * node + 1, nodeMiddle, nodeEnd, position, checkOutEnd, from);
+}
+
+// Turns the +1/-1 changes of every key into its running integral.  Changes
+// at the same time are merged into one step.
+void SessionIndex::UsageIntegrals::build(vector<SessionChange>& changes, size_t keyCount, vector<size_t>& keys)
+{
+    sort(changes.begin(), changes.end());
+
+    offsets.assign(keyCount + 1, 0);
+    long long openCount = 0;
+    for (size_t change = 0; change < changes.size(); ++change)
+    {
+        size_t key = changes[change].key;
+        long long time = changes[change].time;
+        bool newKey = change == 0 || changes[change - 1].key != key;
+        if (newKey)
+        {
+            keys.push_back(key);
+            openCount = 0;
+        }
+        if (newKey || times.back() != time)
+        {
+            long long seconds = newKey ? 0 : openSeconds.back() + openCounts.back() * (time - times.back());
+            times.push_back(time);
+            openCounts.push_back(openCount);
+            openSeconds.push_back(seconds);
+        }
+        openCount += changes[change].change;
+        openCounts.back() = openCount;
+        offsets[key + 1] = times.size();
+    }
+
+    // Keys without sessions get an empty range
+    for (size_t key = 1; key <= keyCount; ++key)
+    {
+        offsets[key] = max(offsets[key], offsets[key - 1]);
+    }
+}
+
+long long SessionIndex::UsageIntegrals::secondsUntil(size_t key, long long time) const
+{
+    vector<long long>::const_iterator first = times.begin() + offsets[key];
+    vector<long long>::const_iterator last = times.begin() + offsets[key + 1];
+    if (first == last || time <= *first)
+    {
+        return 0;
+    }
+
+    size_t step = upper_bound(first, last, time) - times.begin() - 1;
+    return openSeconds[step] + openCounts[step] * (time - times[step]);
+}
+
+long long SessionIndex::UsageIntegrals::clippedDuration(size_t key, long long from, long long to) const
+{
+    if (from >= to || key + 1 >= offsets.size())
+    {
+        return 0;
+    }
+
+    return secondsUntil(key, to) - secondsUntil(key, from);
+}
+
+void SessionIndex::UsageIntegrals::clear()
+{
+    offsets.clear();
+    times.clear();
+    openCounts.clear();
+    openSeconds.clear();
+}
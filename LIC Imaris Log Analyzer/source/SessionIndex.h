@@ -0,0 +1,141 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+#include "EventStore.h"
+
+using namespace std;
+
+struct Session;
+
+// Index of the license sessions of a report log for range queries, built
+// once the sessions are paired (see LogData::sessionIndex).  A session holds
+// its license over [check-out, check-out + duration); sessions still checked
+// out last until the end of the log as in the reports.
+//
+// Per product, the sessions are sorted by check-out time over a tree of
+// their latest check-in times, so the sessions of a product that overlap an
+// interval are found in log time plus their number.  The checked out time
+// of every user and host per product is kept as a running integral of the
+// number of its open sessions, so the part of its sessions that falls into
+// an interval is the difference of two binary searches.
+class SessionIndex
+{
+    public:
+        SessionIndex() : m_numberOfProducts(0) {}
+
+        void build(const EventStore& events,
+                   const vector<Session>& sessions,
+                   size_t numberOfProducts,
+                   size_t numberOfUsers,
+                   size_t numberOfHosts);
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Sessions (indices into the analyzed sessions) of the product that
+        // overlap [from, to), in check-out order
+        void overlapping(size_t product, long long from, long long to, vector<size_t>& sessions) const;
+
+        // The next of those sessions from position on, one at a time, which
+        // advances position past it; NoId after the last
+        size_t nextOverlapping(size_t product, long long from, long long to, size_t& position) const;
+
+        // Sessions of the product that held a license at time
+        void heldAt(size_t product, long long time, vector<size_t>& sessions) const;
+
+        // Checked out seconds of the user's (host's) sessions of the product,
+        // clipped to [from, to)
+        long long userDuration(size_t user, size_t product, long long from, long long to) const;
+        long long hostDuration(size_t host, size_t product, long long from, long long to) const;
+
+        // Users (hosts) times numberOfProducts plus product of the pairs that
+        // have sessions, in ascending order
+        const vector<size_t>& userProducts() const;
+        const vector<size_t>& hostProducts() const;
+
+    private:
+        // A session of a user (host) and product opened (+1) or closed (-1)
+        struct SessionChange
+        {
+            size_t key;
+            long long time;
+            long long change;
+
+            bool operator<(const SessionChange& other) const
+            {
+                return key != other.key ? key < other.key : time < other.time;
+            }
+        };
+
+        // Sessions of one product sorted by check-out time.  maxCheckIns is a
+        // binary tree over them, leaves from leafCount on, in which every node
+        // holds the latest check-in of its subtree.
+        struct ProductSessions
+        {
+            vector<long long> checkOuts;
+            vector<size_t> sessions;
+            vector<long long> maxCheckIns;
+            size_t leafCount;
+        };
+
+        // Open sessions of every user (host) and product, the steps of key
+        // k in [offsets[k], offsets[k + 1]): openCounts[i] sessions were
+        // open from times[i] on, and openSeconds[i] is the sum of their
+        // checked out seconds up to times[i]
+        struct UsageIntegrals
+        {
+            vector<size_t> offsets;
+            vector<long long> times;
+            vector<long long> openCounts;
+            vector<long long> openSeconds;
+
+            void build(vector<SessionChange>& changes, size_t keyCount, vector<size_t>& keys);
+            long long secondsUntil(size_t key, long long time) const;
+            long long clippedDuration(size_t key, long long from, long long to) const;
+            void clear();
+        };
+
+        void collectOverlapping(const ProductSessions& productSessions,
+                                size_t node,
+                                size_t nodeBegin,
+                                size_t nodeEnd,
+                                size_t checkOutEnd,
+                                long long from,
+                                vector<size_t>& sessions) const;
+        size_t firstOverlapping(const ProductSessions& productSessions,
+                                size_t node,
+                                size_t nodeBegin,
+                                size_t nodeEnd,
+                                size_t position,
+                                size_t checkOutEnd,
+                                long long from) const;
+
+        size_t m_numberOfProducts;
+        vector<ProductSessions> m_productSessions;
+        UsageIntegrals m_userIntegrals;
+        UsageIntegrals m_hostIntegrals;
+        vector<size_t> m_userProducts;
+        vector<size_t> m_hostProducts;
+};
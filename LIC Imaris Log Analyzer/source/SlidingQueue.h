@@ -0,0 +1,83 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// A queue that is pushed at the back and popped at the front, as a window
+// sliding over the events moves on, in one vector it keeps the capacity
+// of.  The popped elements are dropped all at once when they make up half
+// of the vector, so after the first windows it allocates no more, where a
+// deque allocates a new block for every few hundred elements that pass
+// through it.
+template <typename T>
+class SlidingQueue
+{
+    public:
+        SlidingQueue()
+            : m_first(0)
+        {
+        }
+
+        bool empty() const { return m_first == m_values.size(); }
+        size_t size() const { return m_values.size() - m_first; }
+
+        T& operator[](size_t index) { return m_values[m_first + index]; }
+        const T& operator[](size_t index) const { return m_values[m_first + index]; }
+        T& front() { return m_values[m_first]; }
+        const T& front() const { return m_values[m_first]; }
+        T& back() { return m_values.back(); }
+        const T& back() const { return m_values.back(); }
+
+        void push_back(const T& value)
+        {
+            m_values.push_back(value);
+        }
+
+        void pop_front()
+        {
+            ++m_first;
+            if (m_first * 2 >= m_values.size())
+            {
+                m_values.erase(m_values.begin(), m_values.begin() + m_first);
+                m_first = 0;
+            }
+        }
+
+        void clear()
+        {
+            m_values.clear();
+            m_first = 0;
+        }
+
+        // The vector the elements are kept in, for the memory accounting
+        const vector<T>& storage() const { return m_values; }
+
+    private:
+        vector<T> m_values;
+        size_t m_first;
+};
@@ -0,0 +1,204 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "SparseTotals.h"
+#include "HeapBytes.h"
+#include "CheckedAccess.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+void SparseTotals::clear()
+{
+    m_products = 0;
+    m_rowOffsets.clear();
+    m_entryProducts.clear();
+    m_entryValues.clear();
+}
+
+size_t SparseTotals::memoryBytes() const
+{
+    return heapBytes(m_rowOffsets) + heapBytes(m_entryProducts) + heapBytes(m_entryValues);
+}
+
+// The entries are bucketed by row with a counting sort, and every row is
+// summed in a products wide scratch row of which only the products it
+// touched are read back, so the table is built in time linear in the
+// entries plus the rows.
+void SparseTotals::assign(size_t rows, size_t products, const vector<CheckpointEntry>& entries)
+{
+    clear();
+    m_products = products;
+    m_rowOffsets.assign(rows + 1, 0);
+
+    vector<size_t> rowStarts(rows + 1, 0);
+    for (size_t entry = 0; entry < entries.size(); ++entry)
+    {
+        ++indexed(rowStarts, entries[entry].row + 1);
+    }
+    for (size_t row = 0; row < rows; ++row)
+    {
+        rowStarts[row + 1] += rowStarts[row];
+    }
+    vector<size_t> rowEntries(entries.size());
+    vector<size_t> nextEntry(rowStarts.begin(), rowStarts.end() - 1);
+    for (size_t entry = 0; entry < entries.size(); ++entry)
+    {
+        rowEntries[nextEntry[entries[entry].row]++] = entry;
+    }
+
+    vector<long long> rowTotals(products, 0);
+    vector<char> touched(products, 0);
+    vector<uint32_t> touchedProducts;
+    for (size_t row = 0; row < rows; ++row)
+    {
+        touchedProducts.clear();
+        for (size_t position = rowStarts[row]; position < rowStarts[row + 1]; ++position)
+        {
+            const CheckpointEntry& entry = entries[rowEntries[position]];
+            if (! indexed(touched, entry.product))
+            {
+                touched[entry.product] = 1;
+                touchedProducts.push_back(static_cast<uint32_t>(entry.product));
+            }
+            rowTotals[entry.product] += entry.value;
+        }
+        sort(touchedProducts.begin(), touchedProducts.end());
+        for (uint32_t product : touchedProducts)
+        {
+            if (rowTotals[product] != 0)
+            {
+                m_entryProducts.push_back(product);
+                m_entryValues.push_back(rowTotals[product]);
+            }
+            rowTotals[product] = 0;
+            touched[product] = 0;
+        }
+        m_rowOffsets[row + 1] = m_entryProducts.size();
+    }
+}
+
+size_t SparseTotals::rows() const
+{
+    return m_rowOffsets.empty() ? 0 : m_rowOffsets.size() - 1;
+}
+
+size_t SparseTotals::products() const
+{
+    return m_products;
+}
+
+long long SparseTotals::value(size_t row, size_t product) const
+{
+    if (row >= rows())
+    {
+        return 0;
+    }
+    vector<uint32_t>::const_iterator rowBegin = m_entryProducts.begin() + m_rowOffsets[row];
+    vector<uint32_t>::const_iterator rowEnd = m_entryProducts.begin() + m_rowOffsets[row + 1];
+    vector<uint32_t>::const_iterator found = lower_bound(rowBegin, rowEnd, product);
+    if (found == rowEnd || *found != product)
+    {
+        return 0;
+    }
+    return m_entryValues[found - m_entryProducts.begin()];
+}
+
+void SparseTotals::rowValues(size_t row, vector<long long>& values) const
+{
+    values.assign(m_products, 0);
+    if (row >= rows())
+    {
+        return;
+    }
+    for (size_t entry = m_rowOffsets[row]; entry < m_rowOffsets[row + 1]; ++entry)
+    {
+        values[m_entryProducts[entry]] = m_entryValues[entry];
+    }
+}
+
+void SparseTotals::productTotals(vector<long long>& totals) const
+{
+    totals.assign(m_products, 0);
+    for (size_t entry = 0; entry < m_entryProducts.size(); ++entry)
+    {
+        totals[m_entryProducts[entry]] += m_entryValues[entry];
+    }
+}
+
+long long SparseTotals::total() const
+{
+    return accumulate(m_entryValues.begin(), m_entryValues.end(), 0LL);
+}
+
+void SparseTotals::largestRows(size_t count, vector<CheckpointEntry>& largest) const
+{
+    // Larger totals, then lower rows, come first; every heap has the last
+    // of its product in front
+    auto before = [](const CheckpointEntry& first, const CheckpointEntry& second)
+    {
+        return first.value != second.value ? first.value > second.value : first.row < second.row;
+    };
+    vector<vector<CheckpointEntry>> heaps(m_products);
+    for (size_t row = 0; row < rows() && count > 0; ++row)
+    {
+        for (size_t entry = m_rowOffsets[row]; entry < m_rowOffsets[row + 1]; ++entry)
+        {
+            CheckpointEntry total = { row, m_entryProducts[entry], m_entryValues[entry] };
+            vector<CheckpointEntry>& heap = heaps[total.product];
+            if (heap.size() < count)
+            {
+                heap.push_back(total);
+                push_heap(heap.begin(), heap.end(), before);
+            }
+            else if (before(total, heap.front()))
+            {
+                pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = total;
+                push_heap(heap.begin(), heap.end(), before);
+            }
+        }
+    }
+
+    largest.clear();
+    for (size_t product = 0; product < m_products; ++product)
+    {
+        sort_heap(heaps[product].begin(), heaps[product].end(), before);
+        largest.insert(largest.end(), heaps[product].begin(), heaps[product].end());
+    }
+}
+
+void SparseTotals::entries(vector<CheckpointEntry>& entries) const
+{
+    entries.clear();
+    for (size_t row = 0; row < rows(); ++row)
+    {
+        for (size_t entry = m_rowOffsets[row]; entry < m_rowOffsets[row + 1]; ++entry)
+        {
+            CheckpointEntry total = { row, m_entryProducts[entry], m_entryValues[entry] };
+            entries.push_back(total);
+        }
+    }
+}
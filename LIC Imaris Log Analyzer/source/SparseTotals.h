@@ -0,0 +1,79 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+
+using namespace std;
+
+// A rows x products table of totals, e.g. the seconds each user had each
+// product checked out.  A user or host touches only a few of the products,
+// so only the nonzero totals are kept: those of every row ordered by
+// product, in compressed sparse rows.  The table is built at once from a
+// list of entries; the reports expand it one row at a time.
+class SparseTotals
+{
+    public:
+        SparseTotals() : m_products(0) {}
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Sums the entries, which may name a (row, product) more than once
+        // and come in any order, into a table of the given shape
+        void assign(size_t rows, size_t products, const vector<CheckpointEntry>& entries);
+
+        size_t rows() const;
+        size_t products() const;
+        long long value(size_t row, size_t product) const;
+
+        // The totals of a row for every product, zero for those it does not
+        // hold and for a row past the table
+        void rowValues(size_t row, vector<long long>& values) const;
+
+        // The nonzero totals, by row and product
+        void entries(vector<CheckpointEntry>& entries) const;
+
+        // The sums over the rows for every product, and the sum of all
+        // totals, reduced over the nonzero totals alone
+        void productTotals(vector<long long>& totals) const;
+        long long total() const;
+
+        // The count rows with the largest totals of every product, largest
+        // first and ties by row, as entries listed by product.  A bounded
+        // heap per product selects them in one pass over the nonzero totals,
+        // without sorting the table.
+        void largestRows(size_t count, vector<CheckpointEntry>& largest) const;
+
+    private:
+        size_t m_products;
+        // The totals of row r are entries m_rowOffsets[r] up to
+        // m_rowOffsets[r + 1]
+        vector<size_t> m_rowOffsets;
+        vector<uint32_t> m_entryProducts;
+        vector<long long> m_entryValues;
+};
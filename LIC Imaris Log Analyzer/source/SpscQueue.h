@@ -0,0 +1,162 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Bounded ring buffer between exactly one producer thread and one consumer
+// thread, without locks: the producer only advances the tail and the
+// consumer only the head, each published with release and read with
+// acquire ordering.  A full queue holds the producer back (backpressure),
+// an empty one the consumer.  Waiting spins briefly, then yields, then
+// sleeps, so a stage that waits long, e.g. a reader ahead of its parser,
+// does not hold on to a core.
+template <typename T>
+class SpscQueue
+{
+    public:
+        // The capacity is rounded up to a power of two
+        explicit SpscQueue(size_t capacity)
+            : m_head(0),
+              m_tail(0),
+              m_closed(false)
+        {
+            size_t slots = 1;
+            while (slots < capacity)
+            {
+                slots <<= 1;
+            }
+            m_slots.resize(slots);
+            m_mask = slots - 1;
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Producer: moves item in unless the queue is full
+        bool tryPush(T& item)
+        {
+            size_t tail = m_tail.load(memory_order_relaxed);
+            if (tail - m_head.load(memory_order_acquire) > m_mask)
+            {
+                return false;
+            }
+            m_slots[tail & m_mask] = move(item);
+            m_tail.store(tail + 1, memory_order_release);
+            return true;
+        }
+
+        // Producer: moves item in, waiting while the queue is full.  Returns
+        // false, leaving item alone, if stopped() turns true meanwhile.
+        template <typename Stopped>
+        bool push(T& item, Stopped stopped)
+        {
+            for (unsigned int waits = 0; ! tryPush(item); ++waits)
+            {
+                if (stopped())
+                {
+                    return false;
+                }
+                wait(waits);
+            }
+            return true;
+        }
+
+        bool push(T& item)
+        {
+            return push(item, []() { return false; });
+        }
+
+        // Consumer: moves the oldest item out unless the queue is empty
+        bool tryPop(T& item)
+        {
+            size_t head = m_head.load(memory_order_relaxed);
+            if (head == m_tail.load(memory_order_acquire))
+            {
+                return false;
+            }
+            item = move(m_slots[head & m_mask]);
+            m_head.store(head + 1, memory_order_release);
+            return true;
+        }
+
+        // Consumer: moves the oldest item out, waiting while the queue is
+        // empty.  Returns false once the queue is closed and empty.
+        bool pop(T& item)
+        {
+            for (unsigned int waits = 0; ! tryPop(item); ++waits)
+            {
+                if (m_closed.load(memory_order_acquire))
+                {
+                    // Items pushed before the close come first
+                    return tryPop(item);
+                }
+                wait(waits);
+            }
+            return true;
+        }
+
+        // Producer: no more items follow
+        void close()
+        {
+            m_closed.store(true, memory_order_release);
+        }
+
+        // Whether the consumer has taken every item pushed so far
+        bool empty() const
+        {
+            return m_head.load(memory_order_acquire) == m_tail.load(memory_order_acquire);
+        }
+
+        static void wait(unsigned int waits)
+        {
+            if (waits < 64)
+            {
+                return;
+            }
+            if (waits < 128)
+            {
+                this_thread::yield();
+                return;
+            }
+            this_thread::sleep_for(chrono::microseconds(waits < 1024 ? 50 : 500));
+        }
+
+    private:
+        vector<T> m_slots;
+        size_t m_mask;
+
+        // On cache lines of their own, so that the two threads do not
+        // invalidate each other's line on every item
+        alignas(64) atomic<size_t> m_head;
+        alignas(64) atomic<size_t> m_tail;
+        alignas(64) atomic<bool> m_closed;
+};
@@ -0,0 +1,151 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "SqliteDatabase.h"
+#include "Cancellation.h"
+#include "Exceptions.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sqlite3.h>
+#include <boost/filesystem/operations.hpp>
+
+using namespace std;
+
+SqliteDatabase::SqliteDatabase(const string& filePath)
+    : m_filePath(filePath),
+      m_temporaryPath(filePath + ".tmp"),
+      m_database(NULL),
+      m_statement(NULL)
+{
+    boost::system::error_code error;
+    boost::filesystem::remove(m_temporaryPath, error);
+    if (sqlite3_open_v2(m_temporaryPath.c_str(), &m_database, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK)
+    {
+        sqlite3_close(m_database);
+        m_database = NULL;
+        CannotOpenFileException cannotOpenFileException(filePath);
+        throw cannotOpenFileException;
+    }
+    execute("PRAGMA page_size = 65536; PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF; PRAGMA locking_mode = EXCLUSIVE; "
+            "PRAGMA temp_store = MEMORY; PRAGMA cache_size = -262144; BEGIN");
+}
+
+// A database left open by an exception is incomplete, and without a
+// journal its transaction cannot be rolled back, so the file is removed
+SqliteDatabase::~SqliteDatabase()
+{
+    finalize();
+    if (m_database != NULL)
+    {
+        sqlite3_close(m_database);
+        boost::system::error_code error;
+        boost::filesystem::remove(m_temporaryPath, error);
+    }
+}
+
+void SqliteDatabase::execute(const string& sql)
+{
+    finalize();
+    check(sqlite3_exec(m_database, sql.c_str(), NULL, NULL, NULL));
+}
+
+void SqliteDatabase::prepare(const string& sql)
+{
+    finalize();
+    check(sqlite3_prepare_v2(m_database, sql.c_str(), static_cast<int>(sql.size() + 1), &m_statement, NULL));
+}
+
+void SqliteDatabase::bindInteger(int column, long long value)
+{
+    check(sqlite3_bind_int64(m_statement, column, value));
+}
+
+void SqliteDatabase::bindText(int column, string_view text)
+{
+    check(sqlite3_bind_text(m_statement, column, text.data(), static_cast<int>(text.size()), SQLITE_STATIC));
+}
+
+// The times of the first columns of a row are formatted into buffers that
+// stay until the row is inserted, those of later ones are copied by SQLite
+void SqliteDatabase::bindTime(int column, long long epochSeconds)
+{
+    DateTime dateTime;
+    epochToDateTime(epochSeconds, dateTime);
+    char copied[TimeLength];
+    bool buffered = (column >= 1 && column <= TimeBuffers);
+    char* text = buffered ? m_times[column - 1] : copied;
+    int length = snprintf(text, TimeLength, "%04d-%02d-%02d %02d:%02d:%02d", dateTime.year, dateTime.month,
+                          dateTime.day, dateTime.hours, dateTime.minutes, dateTime.seconds);
+    check(sqlite3_bind_text(m_statement, column, text, min(length, TimeLength - 1), buffered ? SQLITE_STATIC : SQLITE_TRANSIENT));
+}
+
+void SqliteDatabase::bindNull(int column)
+{
+    check(sqlite3_bind_null(m_statement, column));
+}
+
+void SqliteDatabase::insertRow()
+{
+    throwIfCancelled();
+    if (sqlite3_step(m_statement) != SQLITE_DONE)
+    {
+        check(sqlite3_errcode(m_database));
+    }
+    check(sqlite3_reset(m_statement));
+}
+
+void SqliteDatabase::close()
+{
+    execute("COMMIT");
+    if (sqlite3_close(m_database) != SQLITE_OK)
+    {
+        check(SQLITE_ERROR);
+    }
+    m_database = NULL;
+
+    boost::system::error_code error;
+    boost::filesystem::rename(m_temporaryPath, m_filePath, error);
+    if (error)
+    {
+        boost::filesystem::remove(m_temporaryPath, error);
+        check(SQLITE_ERROR);
+    }
+}
+
+// Any result but OK fails the whole database
+void SqliteDatabase::check(int result)
+{
+    if (result != SQLITE_OK)
+    {
+        CannotOpenFileException cannotOpenFileException(m_filePath);
+        throw cannotOpenFileException;
+    }
+}
+
+void SqliteDatabase::finalize()
+{
+    sqlite3_finalize(m_statement);
+    m_statement = NULL;
+}
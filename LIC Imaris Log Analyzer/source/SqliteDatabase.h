@@ -0,0 +1,82 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+// A SQLite database that tables are bulk-loaded into, for ad hoc SQL over
+// an analyzed log.  The file is written anew without a journal or syncs,
+// since a failed run just makes it again from the log.  All rows go in
+// inside one transaction, each table through one prepared statement that
+// is bound and reset for every row, and the indexes are best created after
+// the rows, so that each is built by one sort instead of row by row.  The
+// database is built under a temporary name and renamed when it is closed;
+// every row polls for cancellation (see Cancellation.h).
+class SqliteDatabase
+{
+    public:
+        // Replaces any file at the path once closed.  Every function throws
+        // CannotOpenFileException if SQLite fails.
+        explicit SqliteDatabase(const string& filePath);
+        ~SqliteDatabase();
+        SqliteDatabase(const SqliteDatabase&) = delete;
+        SqliteDatabase& operator=(const SqliteDatabase&) = delete;
+
+        // Statements without rows, e.g. CREATE TABLE or CREATE INDEX
+        void execute(const string& sql);
+
+        // The INSERT statement the next rows go through.  Each row binds its
+        // columns, numbered from 1, and is then inserted.  Text is not
+        // copied and must stay until the row is inserted.
+        void prepare(const string& sql);
+        void bindInteger(int column, long long value);
+        void bindText(int column, string_view text);
+        // "YYYY-MM-DD HH:MM:SS", which sorts in time order and which the
+        // date and time functions of SQLite read
+        void bindTime(int column, long long epochSeconds);
+        void bindNull(int column);
+        void insertRow();
+
+        // Commits the rows and closes the file
+        void close();
+
+    private:
+        void check(int result);
+        void finalize();
+
+        string m_filePath;
+        string m_temporaryPath;
+        sqlite3* m_database;
+        sqlite3_stmt* m_statement;
+        // The times of a row, bound without a copy
+        static const int TimeBuffers = 4;
+        static const int TimeLength = 32;
+        char m_times[TimeBuffers][TimeLength];
+};
@@ -0,0 +1,329 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "StringInterner.h"
+#include "HeapBytes.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    const size_t ArenaBlockSize = 64 * 1024;
+    const size_t InitialSlotCount = 64;
+
+    // The slot entry of id, tagged with the upper half of its hash
+    uint64_t slotEntry(size_t id, size_t hash)
+    {
+        return (static_cast<uint64_t>(hash) >> 32 << 32) | static_cast<uint64_t>(id + 1);
+    }
+
+    size_t slotId(uint64_t entry)
+    {
+        return static_cast<size_t>(static_cast<uint32_t>(entry)) - 1;
+    }
+}
+
+string_view StringArena::store(string_view text)
+{
+    if (text.empty())
+    {
+        return string_view();
+    }
+
+    // A string longer than a block gets a block of its own
+    if (m_blockUsed + text.size() > m_blockSize)
+    {
+        m_blockSize = max(ArenaBlockSize, text.size());
+        m_blocks.push_back(unique_ptr<char[]>(new char[m_blockSize]));
+        m_blockUsed = 0;
+        m_blockBytes += m_blockSize + HeapBlockOverhead;
+    }
+
+    char* copy = m_blocks.back().get() + m_blockUsed;
+    memcpy(copy, text.data(), text.size());
+    m_blockUsed += text.size();
+
+    return string_view(copy, text.size());
+}
+
+void StringArena::clear()
+{
+    m_blocks.clear();
+    m_blockUsed = 0;
+    m_blockSize = 0;
+    m_blockBytes = 0;
+}
+
+size_t StringArena::memoryBytes() const
+{
+    return m_blockBytes + heapBytes(m_blocks);
+}
+
+size_t StringInterner::intern(string_view name)
+{
+    size_t hash = std::hash<string_view>()(name);
+    if (! m_slots.empty())
+    {
+        size_t slot = findSlot(name, hash);
+        if (m_slots[slot] != 0)
+        {
+            return slotId(m_slots[slot]);
+        }
+    }
+
+    size_t id = m_names.size();
+    m_names.push_back(m_arena.store(name));
+    m_hashes.push_back(hash);
+    if (2 * m_names.size() > m_slots.size())
+    {
+        growSlots();
+    }
+    else
+    {
+        m_slots[findSlot(name, hash)] = slotEntry(id, hash);
+    }
+
+    return id;
+}
+
+bool StringInterner::find(string_view name, size_t& id) const
+{
+    if (m_slots.empty())
+    {
+        return false;
+    }
+
+    size_t slot = findSlot(name, std::hash<string_view>()(name));
+    if (m_slots[slot] == 0)
+    {
+        return false;
+    }
+    id = slotId(m_slots[slot]);
+
+    return true;
+}
+
+string_view StringInterner::name(size_t id) const
+{
+    return m_names.at(id);
+}
+
+size_t StringInterner::size() const
+{
+    return m_names.size();
+}
+
+bool StringInterner::empty() const
+{
+    return m_names.empty();
+}
+
+void StringInterner::clear()
+{
+    m_slots.clear();
+    m_hashes.clear();
+    m_names.clear();
+    m_arena.clear();
+}
+
+size_t StringInterner::memoryBytes() const
+{
+    return m_arena.memoryBytes() + heapBytes(m_names) + heapBytes(m_hashes) + heapBytes(m_slots);
+}
+
+// The slot that holds name, or the free slot where it would go (linear
+// probing).  The names are only compared when the tags of the hashes match.
+size_t StringInterner::findSlot(string_view name, size_t hash) const
+{
+    const size_t mask = m_slots.size() - 1;
+    const uint64_t tag = slotEntry(0, hash) >> 32;
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+    {
+        uint64_t entry = m_slots[slot];
+        if (entry == 0 || ((entry >> 32) == tag && m_names[slotId(entry)] == name))
+        {
+            return slot;
+        }
+    }
+}
+
+// Doubles the table (or creates it) and inserts all names again
+void StringInterner::growSlots()
+{
+    if (m_names.size() >= UINT32_MAX)
+    {
+        throw length_error("too many names to intern");
+    }
+
+    size_t slotCount = max(InitialSlotCount, m_slots.size());
+    while (2 * m_names.size() > slotCount)
+    {
+        slotCount *= 2;
+    }
+
+    m_slots.assign(slotCount, 0);
+    const size_t mask = slotCount - 1;
+    for (size_t id = 0; id < m_names.size(); ++id)
+    {
+        size_t slot = m_hashes[id] & mask;
+        while (m_slots[slot] != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = slotEntry(id, m_hashes[id]);
+    }
+}
+
+size_t SharedInterner::intern(string_view name)
+{
+    size_t hash = std::hash<string_view>()(name);
+    size_t shardIndex = (hash >> 24) % ShardCount;
+    Shard& shard = m_shards[shardIndex];
+    size_t id;
+    if (findId(shard, shard.table.load(memory_order_acquire), name, hash, id))
+    {
+        return id * ShardCount + shardIndex;
+    }
+
+    // Another thread may have added the name since
+    lock_guard<mutex> lock(shard.insertLock);
+    Table* table = shard.table.load(memory_order_relaxed);
+    if (findId(shard, table, name, hash, id))
+    {
+        return id * ShardCount + shardIndex;
+    }
+
+    id = shard.hashes.size();
+    if (id / NameBlockSize >= MaxNameBlocks)
+    {
+        throw length_error("too many names to intern");
+    }
+    if (id % NameBlockSize == 0)
+    {
+        shard.blocks.push_back(unique_ptr<string_view[]>(new string_view[NameBlockSize]));
+        shard.nameBlocks[id / NameBlockSize].store(shard.blocks.back().get(), memory_order_release);
+    }
+    shard.blocks.back()[id % NameBlockSize] = shard.arena.store(name);
+    shard.hashes.push_back(hash);
+
+    // The name is in place before a reader can find its id
+    if (table == NULL || 2 * shard.hashes.size() > table->mask + 1)
+    {
+        growTable(shard);
+    }
+    else
+    {
+        size_t slot = hash & table->mask;
+        while (table->slots[slot].load(memory_order_relaxed) != 0)
+        {
+            slot = (slot + 1) & table->mask;
+        }
+        table->slots[slot].store(slotEntry(id, hash), memory_order_release);
+    }
+
+    return id * ShardCount + shardIndex;
+}
+
+string_view SharedInterner::name(size_t id) const
+{
+    return shardName(m_shards[id % ShardCount], id / ShardCount);
+}
+
+void SharedInterner::clear()
+{
+    for (size_t shardIndex = 0; shardIndex < ShardCount; ++shardIndex)
+    {
+        Shard& shard = m_shards[shardIndex];
+        shard.table.store(NULL, memory_order_relaxed);
+        shard.tables.clear();
+        for (size_t block = 0; block < shard.blocks.size(); ++block)
+        {
+            shard.nameBlocks[block].store(NULL, memory_order_relaxed);
+        }
+        shard.blocks.clear();
+        shard.hashes.clear();
+        shard.arena.clear();
+    }
+}
+
+// Probes table, which may be NULL or one a writer has since replaced
+bool SharedInterner::findId(const Shard& shard, const Table* table, string_view name, size_t hash, size_t& id)
+{
+    if (table == NULL)
+    {
+        return false;
+    }
+
+    const uint64_t tag = slotEntry(0, hash) >> 32;
+    for (size_t slot = hash & table->mask; ; slot = (slot + 1) & table->mask)
+    {
+        uint64_t entry = table->slots[slot].load(memory_order_acquire);
+        if (entry == 0)
+        {
+            return false;
+        }
+        if ((entry >> 32) == tag && shardName(shard, slotId(entry)) == name)
+        {
+            id = slotId(entry);
+            return true;
+        }
+    }
+}
+
+string_view SharedInterner::shardName(const Shard& shard, size_t id)
+{
+    return shard.nameBlocks[id / NameBlockSize].load(memory_order_acquire)[id % NameBlockSize];
+}
+
+// Builds a table of twice the size (or the first one) and publishes it
+void SharedInterner::growTable(Shard& shard)
+{
+    size_t slotCount = InitialSlotCount;
+    while (2 * shard.hashes.size() > slotCount)
+    {
+        slotCount *= 2;
+    }
+
+    unique_ptr<Table> table(new Table);
+    table->mask = slotCount - 1;
+    table->slots.reset(new atomic<uint64_t>[slotCount]);
+    for (size_t slot = 0; slot < slotCount; ++slot)
+    {
+        table->slots[slot].store(0, memory_order_relaxed);
+    }
+    for (size_t id = 0; id < shard.hashes.size(); ++id)
+    {
+        size_t slot = shard.hashes[id] & table->mask;
+        while (table->slots[slot].load(memory_order_relaxed) != 0)
+        {
+            slot = (slot + 1) & table->mask;
+        }
+        table->slots[slot].store(slotEntry(id, shard.hashes[id]), memory_order_relaxed);
+    }
+
+    shard.table.store(table.get(), memory_order_release);
+    shard.tables.push_back(move(table));
+}
@@ -0,0 +1,157 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Bump-pointer storage for strings that live as long as the arena.  The
+// text is copied into large blocks, so adding a string does not allocate
+// except when a block is full, and all of it is freed at once.
+class StringArena
+{
+    public:
+        StringArena() : m_blockUsed(0), m_blockSize(0), m_blockBytes(0) {}
+        StringArena(const StringArena&) = delete;
+        StringArena& operator=(const StringArena&) = delete;
+        StringArena(StringArena&&) = default;
+        StringArena& operator=(StringArena&&) = default;
+
+        // Returns a view of the copy, valid until the arena is cleared
+        string_view store(string_view text);
+        void clear();
+        size_t memoryBytes() const;
+
+    private:
+        vector< unique_ptr<char[]> > m_blocks;
+        size_t m_blockUsed;
+        size_t m_blockSize;
+        size_t m_blockBytes;
+};
+
+// Maps names (products, users, hosts, ...) to dense ids in first-seen order,
+// which is the column order of the reports.  Lookups take a string_view and
+// do not allocate.  The names are kept in an arena and looked up in an open
+// addressing table of ids, so interning a new name costs no allocation of
+// its own either.
+class StringInterner
+{
+    public:
+        StringInterner() {}
+        StringInterner(const StringInterner&) = delete;
+        StringInterner& operator=(const StringInterner&) = delete;
+
+        // Moving keeps the names in place, so the views stay valid
+        StringInterner(StringInterner&&) = default;
+        StringInterner& operator=(StringInterner&&) = default;
+
+        // Returns the id of name, adding it if it has not been seen yet
+        size_t intern(string_view name);
+
+        // Returns false if name has not been interned
+        bool find(string_view name, size_t& id) const;
+
+        // Valid as long as the interner (or the one it was moved to)
+        string_view name(size_t id) const;
+        size_t size() const;
+        bool empty() const;
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+    private:
+        size_t findSlot(string_view name, size_t hash) const;
+        void growSlots();
+
+        StringArena m_arena;
+        vector<string_view> m_names;
+        vector<size_t> m_hashes;
+
+        // Id + 1 of the name in each slot, 0 for a free slot, with the upper
+        // half of the name's hash in the upper 32 bits, so that a probe
+        // only compares the names on a match.  The number of slots is a
+        // power of two and at most half of them are used.
+        vector<uint64_t> m_slots;
+};
+
+// An interner the parser threads share.  Most names repeat, so a lookup
+// takes no lock: the names are spread over shards by their hash, and a
+// shard's table of ids is only ever replaced, never changed in place under
+// a reader, while a new name takes the shard's lock.  The ids are dense
+// within a shard but interleave across them, so they follow no order; the
+// log renumbers them in its own first-seen order as the chunks are
+// appended (see LogData::appendChunk).
+class SharedInterner
+{
+    public:
+        SharedInterner() {}
+        SharedInterner(const SharedInterner&) = delete;
+        SharedInterner& operator=(const SharedInterner&) = delete;
+
+        // Returns the id of name, adding it if no thread has yet
+        size_t intern(string_view name);
+
+        // Any id intern returned; valid until the interner is cleared
+        string_view name(size_t id) const;
+
+        // Only while no thread interns
+        void clear();
+
+    private:
+        static const size_t ShardCount = 16;
+        static const size_t NameBlockSize = 16384;
+        static const size_t MaxNameBlocks = 1024;
+
+        struct Table
+        {
+            size_t mask;
+            unique_ptr< atomic<uint64_t>[] > slots;
+        };
+
+        struct Shard
+        {
+            mutex insertLock;
+            // The table readers probe; the ones it replaced are kept in
+            // tables, as a reader may still be probing them
+            atomic<Table*> table{NULL};
+            vector< unique_ptr<Table> > tables;
+            // The names by id within the shard, in blocks that never move
+            atomic<string_view*> nameBlocks[MaxNameBlocks] = {};
+            vector< unique_ptr<string_view[]> > blocks;
+            vector<size_t> hashes;
+            StringArena arena;
+        };
+
+        static bool findId(const Shard& shard, const Table* table, string_view name, size_t hash, size_t& id);
+        static string_view shardName(const Shard& shard, size_t id);
+        static void growTable(Shard& shard);
+
+        Shard m_shards[ShardCount];
+};
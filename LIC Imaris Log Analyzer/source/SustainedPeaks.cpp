@@ -0,0 +1,327 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SustainedPeaks.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+const long long SustainedPeaks::WindowMinutes[SustainedPeaks::Windows] = { 15, 30, 60 };
+
+namespace
+{
+    // Values saved for every window besides its segments and levels
+    const size_t WindowResults = 5;
+}
+
+SustainedPeaks::Window::Window()
+    : unevaluated(0),
+      held(0),
+      heldFrom(LLONG_MIN),
+      bestIntegral(-1),
+      averageFrom(LLONG_MIN)
+{
+}
+
+void SustainedPeaks::Window::change(long long time, int32_t inUse, long long seconds, long long observedFrom)
+{
+    if (segments.empty())
+    {
+        Segment none = { observedFrom, 0, 0 };
+        segments.push_back(none);
+    }
+    time = max(time, segments.back().start);
+    moveTo(time, seconds, observedFrom);
+
+    Segment& last = segments.back();
+    if (inUse == last.level)
+    {
+        return;
+    }
+    closeLevels(time, inUse, seconds);
+    if (time == last.start)
+    {
+        last.level = inUse;
+    }
+    else
+    {
+        Segment next = { time, inUse, last.integral + static_cast<long long>(last.level) * (time - last.start) };
+        segments.push_back(next);
+    }
+}
+
+// Measures the windows that start at a change and end by time, then the
+// one that ends at time
+void SustainedPeaks::Window::moveTo(long long time, long long seconds, long long observedFrom)
+{
+    while (unevaluated < segments.size() && segments[unevaluated].start + seconds <= time)
+    {
+        measure(segments[unevaluated].start + seconds, seconds, observedFrom);
+        ++unevaluated;
+    }
+    measure(time, seconds, observedFrom);
+}
+
+// The usage integral of the window that ends at end, which is at or after
+// the last change.  The changes before the window start are dropped; the
+// windows starting at them were measured before.
+void SustainedPeaks::Window::measure(long long end, long long seconds, long long observedFrom)
+{
+    long long from = end - seconds;
+    if (from < observedFrom)
+    {
+        return;
+    }
+    while (segments.size() > 1 && segments[1].start <= from)
+    {
+        segments.pop_front();
+        unevaluated = (unevaluated > 0) ? unevaluated - 1 : 0;
+    }
+    const Segment& first = segments.front();
+    const Segment& last = segments.back();
+    long long integral = last.integral + static_cast<long long>(last.level) * (end - last.start) -
+                         (first.integral + static_cast<long long>(first.level) * (from - first.start));
+    if (integral > bestIntegral)
+    {
+        bestIntegral = integral;
+        averageFrom = from;
+    }
+}
+
+// The levels above the new usage end at time, and count for the held peak
+// if they lasted a whole window.  The levels below it stay in use since
+// they started; a rise starts a level of its own.
+void SustainedPeaks::Window::closeLevels(long long time, int32_t inUse, long long seconds)
+{
+    long long since = time;
+    while (! levels.empty() && levels.back().level > inUse)
+    {
+        const Level& level = levels.back();
+        if (time - level.since >= seconds && level.level > held)
+        {
+            held = level.level;
+            heldFrom = level.since;
+        }
+        since = level.since;
+        levels.pop_back();
+    }
+    if (inUse > 0 && (levels.empty() || levels.back().level < inUse))
+    {
+        Level level = { inUse, since };
+        levels.push_back(level);
+    }
+}
+
+SustainedPeaks::SustainedPeaks()
+    : m_started(false),
+      m_clock(0),
+      m_start(0)
+{
+}
+
+void SustainedPeaks::clear()
+{
+    m_started = false;
+    m_clock = 0;
+    m_start = 0;
+    m_windows.clear();
+}
+
+size_t SustainedPeaks::memoryBytes() const
+{
+    size_t bytes = heapBytes(m_windows);
+    for (size_t window = 0; window < m_windows.size(); ++window)
+    {
+        bytes += heapBytes(m_windows.at(window).segments.storage()) + heapBytes(m_windows.at(window).levels);
+    }
+    return bytes;
+}
+
+void SustainedPeaks::resize(size_t products)
+{
+    if (products * Windows > m_windows.size())
+    {
+        m_windows.resize(products * Windows);
+    }
+}
+
+void SustainedPeaks::advance(long long time)
+{
+    if (! m_started)
+    {
+        m_started = true;
+        m_clock = time;
+        m_start = time;
+    }
+    m_clock = max(m_clock, time);
+}
+
+void SustainedPeaks::change(size_t product, int32_t inUse)
+{
+    for (size_t length = 0; length < Windows; ++length)
+    {
+        window(product, length).change(m_clock, inUse, WindowMinutes[length] * 60, m_start);
+    }
+}
+
+void SustainedPeaks::takeProducts(const SustainedPeaks& shard, size_t firstProduct, size_t endProduct)
+{
+    m_started = shard.m_started;
+    m_clock = shard.m_clock;
+    m_start = shard.m_start;
+    copy(shard.m_windows.begin() + firstProduct * Windows, shard.m_windows.begin() + endProduct * Windows,
+         m_windows.begin() + firstProduct * Windows);
+}
+
+size_t SustainedPeaks::products() const
+{
+    return m_windows.size() / Windows;
+}
+
+SustainedPeak SustainedPeaks::peak(size_t product, size_t window, long long endTime) const
+{
+    long long seconds = WindowMinutes[window] * 60;
+    Window counted = m_windows.at(product * Windows + window);
+    if (m_started)
+    {
+        // The usage stays as it is up to the end
+        counted.change(endTime, counted.segments.empty() ? 0 : counted.segments.back().level, seconds, m_start);
+        long long end = max(endTime, counted.segments.back().start);
+        for (size_t level = 0; level < counted.levels.size(); ++level)
+        {
+            if (end - counted.levels[level].since >= seconds && counted.levels[level].level > counted.held)
+            {
+                counted.held = counted.levels[level].level;
+                counted.heldFrom = counted.levels[level].since;
+            }
+        }
+    }
+
+    SustainedPeak peak;
+    peak.held = counted.held;
+    peak.heldFrom = counted.heldFrom;
+    peak.average = (counted.bestIntegral < 0) ? 0.0 : static_cast<double>(counted.bestIntegral) / seconds;
+    peak.averageFrom = counted.averageFrom;
+    return peak;
+}
+
+void SustainedPeaks::save(Checkpoint& checkpoint) const
+{
+    checkpoint.peaksClock = m_started ? m_clock : LLONG_MIN;
+    checkpoint.peaksStart = m_start;
+    checkpoint.peakResults.clear();
+    checkpoint.peakSegmentCounts.clear();
+    checkpoint.peakSegmentStarts.clear();
+    checkpoint.peakSegmentLevels.clear();
+    checkpoint.peakLevelCounts.clear();
+    checkpoint.peakLevelSince.clear();
+    checkpoint.peakLevels.clear();
+    for (size_t entry = 0; entry < m_windows.size(); ++entry)
+    {
+        const Window& window = m_windows[entry];
+        checkpoint.peakResults.push_back(window.held);
+        checkpoint.peakResults.push_back(window.heldFrom);
+        checkpoint.peakResults.push_back(window.bestIntegral);
+        checkpoint.peakResults.push_back(window.averageFrom);
+        checkpoint.peakResults.push_back(static_cast<int64_t>(window.unevaluated));
+        checkpoint.peakSegmentCounts.push_back(window.segments.size());
+        for (size_t segment = 0; segment < window.segments.size(); ++segment)
+        {
+            checkpoint.peakSegmentStarts.push_back(window.segments[segment].start);
+            checkpoint.peakSegmentLevels.push_back(window.segments[segment].level);
+        }
+        checkpoint.peakLevelCounts.push_back(window.levels.size());
+        for (size_t level = 0; level < window.levels.size(); ++level)
+        {
+            checkpoint.peakLevelSince.push_back(window.levels[level].since);
+            checkpoint.peakLevels.push_back(window.levels[level].level);
+        }
+    }
+}
+
+// The integrals of the segments are counted again from the first one
+bool SustainedPeaks::restore(const Checkpoint& checkpoint)
+{
+    size_t windows = checkpoint.peakSegmentCounts.size();
+    if (windows % Windows != 0 || windows / Windows > checkpoint.products.size() ||
+        checkpoint.peakLevelCounts.size() != windows ||
+        checkpoint.peakResults.size() != windows * WindowResults ||
+        checkpoint.peakSegmentLevels.size() != checkpoint.peakSegmentStarts.size() ||
+        checkpoint.peakLevels.size() != checkpoint.peakLevelSince.size())
+    {
+        return false;
+    }
+
+    vector<Window> restored(windows);
+    size_t segment = 0;
+    size_t level = 0;
+    for (size_t entry = 0; entry < windows; ++entry)
+    {
+        Window& window = restored[entry];
+        uint64_t segments = checkpoint.peakSegmentCounts[entry];
+        uint64_t levels = checkpoint.peakLevelCounts[entry];
+        const int64_t* results = &checkpoint.peakResults[entry * WindowResults];
+        if (segments > checkpoint.peakSegmentStarts.size() - segment ||
+            levels > checkpoint.peakLevelSince.size() - level ||
+            results[4] < 0 || static_cast<uint64_t>(results[4]) > segments)
+        {
+            return false;
+        }
+        window.held = static_cast<int32_t>(results[0]);
+        window.heldFrom = results[1];
+        window.bestIntegral = results[2];
+        window.averageFrom = results[3];
+        window.unevaluated = static_cast<size_t>(results[4]);
+        for (uint64_t count = 0; count < segments; ++count, ++segment)
+        {
+            Segment next = { checkpoint.peakSegmentStarts[segment], checkpoint.peakSegmentLevels[segment], 0 };
+            if (! window.segments.empty())
+            {
+                const Segment& last = window.segments.back();
+                next.integral = last.integral + static_cast<long long>(last.level) * (next.start - last.start);
+            }
+            window.segments.push_back(next);
+        }
+        for (uint64_t count = 0; count < levels; ++count, ++level)
+        {
+            Level next = { checkpoint.peakLevels[level], checkpoint.peakLevelSince[level] };
+            window.levels.push_back(next);
+        }
+    }
+    if (segment != checkpoint.peakSegmentStarts.size() || level != checkpoint.peakLevelSince.size())
+    {
+        return false;
+    }
+
+    m_started = checkpoint.peaksClock != LLONG_MIN;
+    m_clock = m_started ? checkpoint.peaksClock : 0;
+    m_start = m_started ? checkpoint.peaksStart : 0;
+    m_windows.swap(restored);
+    return true;
+}
+
+SustainedPeaks::Window& SustainedPeaks::window(size_t product, size_t window)
+{
+    return m_windows.at(product * Windows + window);
+}
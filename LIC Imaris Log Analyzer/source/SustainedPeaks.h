@@ -0,0 +1,139 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+#include "SlidingQueue.h"
+
+using namespace std;
+
+// The peak of a product's floating license usage over one window length:
+// the most licenses in use throughout a window, and the highest
+// time-weighted mean over a window, with the start of the first window
+// each was found in (LLONG_MIN if no window was observed in full)
+struct SustainedPeak
+{
+    int32_t held;
+    long long heldFrom;
+    double average;
+    long long averageFrom;
+};
+
+// Finds the usage of every product sustained over 15, 30 and 60 minutes
+// while the usage pass walks the events, instead of the instantaneous
+// peaks, which one short burst sets.  The held peak comes from a monotonic
+// stack of the levels in use since a time, the mean from a queue of the
+// usage changes of the last window with the running integral of the usage.
+// Both are updated one change at a time, so the cost is linear in the
+// changes and the memory that of the changes of one window, which the
+// windows keep once they have slid past their first changes.
+class SustainedPeaks
+{
+    public:
+        static const size_t Windows = 3;
+        static const long long WindowMinutes[Windows];
+
+        SustainedPeaks();
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Room for the product ids below products; a new product starts
+        // with none in use
+        void resize(size_t products);
+
+        // Moves the clock on to time; the first call starts the observation.
+        // An earlier time, of an event slightly out of order, leaves it
+        // where it is.
+        void advance(long long time);
+
+        // The floating licenses of the product in use from the clock on
+        void change(size_t product, int32_t inUse);
+
+        // Takes the products [firstProduct, endProduct) and the clock from
+        // peaks of as many products that followed the same events with the
+        // changes of those products alone, one shard of a parallel pass
+        void takeProducts(const SustainedPeaks& shard, size_t firstProduct, size_t endProduct);
+
+        size_t products() const;
+        // The peaks of the product over the window, with the usage up to
+        // endTime counted
+        SustainedPeak peak(size_t product, size_t window, long long endTime) const;
+
+        // The state of every product and window, for a checkpoint; restore
+        // is false if the checkpoint does not fit the products
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+    private:
+        // The usage from start on, and its integral from the first change
+        // still in the queue up to start
+        struct Segment
+        {
+            long long start;
+            int32_t level;
+            long long integral;
+        };
+
+        // The licenses in use without a break since a time
+        struct Level
+        {
+            int32_t level;
+            long long since;
+        };
+
+        // One product and window length.  The mean over a window can only
+        // peak at a window that starts or ends at a change, so the window
+        // ending at every change and the one starting at every change are
+        // measured; the segments from unevaluated on still wait for the
+        // latter.
+        struct Window
+        {
+            Window();
+
+            void change(long long time, int32_t inUse, long long seconds, long long observedFrom);
+            void moveTo(long long time, long long seconds, long long observedFrom);
+            void measure(long long end, long long seconds, long long observedFrom);
+            void closeLevels(long long time, int32_t inUse, long long seconds);
+
+            SlidingQueue<Segment> segments;
+            size_t unevaluated;
+            vector<Level> levels;
+            int32_t held;
+            long long heldFrom;
+            long long bestIntegral;
+            long long averageFrom;
+        };
+
+        Window& window(size_t product, size_t window);
+
+        bool m_started;
+        long long m_clock;
+        long long m_start;
+        // The windows of product p are at p * Windows on
+        vector<Window> m_windows;
+};
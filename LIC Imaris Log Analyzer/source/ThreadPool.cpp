@@ -0,0 +1,220 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+#include "ThreadPool.h"
+#include "ResourceLimits.h"
+
+using namespace std;
+
+namespace
+{
+    const size_t NoWorker = static_cast<size_t>(-1);
+
+    // The pool and deque of the worker running on this thread, if any
+    thread_local ThreadPool* t_pool = NULL;
+    thread_local size_t t_worker = NoWorker;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+    : m_stopping(false)
+{
+    if (threads == 0)
+    {
+        threads = availableThreads();
+    }
+
+    m_localTasks.resize(threads);
+    for (size_t worker = 0; worker < threads; ++worker)
+    {
+        m_workers.push_back(thread(&ThreadPool::work, this, worker));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+
+    for (size_t worker = 0; worker < m_workers.size(); ++worker)
+    {
+        m_workers.at(worker).join();
+    }
+}
+
+size_t ThreadPool::size() const
+{
+    return m_workers.size();
+}
+
+// Tasks submitted by a worker go to its own deque, others to the shared one
+void ThreadPool::submit(TaskGroup* group, function<void()> task)
+{
+    {
+        unique_lock<mutex> lock(m_mutex);
+        Task queued = { task, group };
+        if (t_pool == this)
+        {
+            m_localTasks.at(t_worker).push_back(queued);
+        }
+        else
+        {
+            m_sharedTasks.push_back(queued);
+        }
+        ++group->m_pending;
+    }
+    m_changed.notify_one();
+}
+
+// Must be called with the lock held
+bool ThreadPool::popTask(size_t worker, Task& task)
+{
+    if (worker != NoWorker && ! m_localTasks.at(worker).empty())
+    {
+        task = m_localTasks.at(worker).back();
+        m_localTasks.at(worker).pop_back();
+        return true;
+    }
+    if (! m_sharedTasks.empty())
+    {
+        task = m_sharedTasks.front();
+        m_sharedTasks.pop_front();
+        return true;
+    }
+
+    // Steal the oldest task, starting with the next worker so that the
+    // thieves spread over the deques
+    size_t workers = m_localTasks.size();
+    size_t first = (worker == NoWorker) ? 0 : worker + 1;
+    for (size_t offset = 0; offset < workers; ++offset)
+    {
+        deque<Task>& victim = m_localTasks.at((first + offset) % workers);
+        if (! victim.empty())
+        {
+            task = victim.front();
+            victim.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Called and returns with the lock held; it is released while the task runs
+void ThreadPool::runTask(unique_lock<mutex>& lock, Task& task)
+{
+    exception_ptr error;
+    lock.unlock();
+    try
+    {
+        task.run();
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+    task.run = nullptr;
+    lock.lock();
+
+    TaskGroup* group = task.group;
+    if (error && ! group->m_error)
+    {
+        group->m_error = error;
+    }
+    if (--group->m_pending == 0)
+    {
+        m_changed.notify_all();
+    }
+}
+
+void ThreadPool::work(size_t worker)
+{
+    t_pool = this;
+    t_worker = worker;
+
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        Task task;
+        if (popTask(worker, task))
+        {
+            runTask(lock, task);
+        }
+        else if (m_stopping)
+        {
+            return;
+        }
+        else
+        {
+            m_changed.wait(lock);
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : m_pool(pool),
+      m_pending(0)
+{
+}
+
+// The tasks refer to the group, so it cannot go away before they finish
+TaskGroup::~TaskGroup()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+void TaskGroup::run(function<void()> task)
+{
+    m_pool.submit(this, task);
+}
+
+void TaskGroup::wait()
+{
+    size_t worker = (t_pool == &m_pool) ? t_worker : NoWorker;
+
+    unique_lock<mutex> lock(m_pool.m_mutex);
+    while (m_pending > 0)
+    {
+        ThreadPool::Task task;
+        if (m_pool.popTask(worker, task))
+        {
+            m_pool.runTask(lock, task);
+        }
+        else
+        {
+            m_pool.m_changed.wait(lock);
+        }
+    }
+
+    if (m_error)
+    {
+        exception_ptr error = m_error;
+        m_error = exception_ptr();
+        rethrow_exception(error);
+    }
+}
@@ -0,0 +1,99 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class TaskGroup;
+
+// Fixed set of worker threads with one task deque per worker.  A worker runs
+// the newest task of its own deque first and, when that is empty, takes the
+// oldest task from the shared queue or steals one from another worker, so
+// jobs of very different sizes keep every thread busy.  Tasks are submitted
+// and waited for through a TaskGroup.  The deques share one lock, which is
+// cheap at the granularity of whole files and reports.
+class ThreadPool
+{
+    public:
+        // 0 threads means availableThreads(): the thread limit, or one per
+        // CPU the process may run on
+        explicit ThreadPool(size_t threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t size() const;
+
+    private:
+        friend class TaskGroup;
+
+        struct Task
+        {
+            function<void()> run;
+            TaskGroup* group;
+        };
+
+        void submit(TaskGroup* group, function<void()> task);
+        bool popTask(size_t worker, Task& task);
+        void runTask(unique_lock<mutex>& lock, Task& task);
+        void work(size_t worker);
+
+        vector<thread> m_workers;
+        vector< deque<Task> > m_localTasks;
+        deque<Task> m_sharedTasks;
+        mutex m_mutex;
+        condition_variable m_changed;
+        bool m_stopping;
+};
+
+// Tasks that are waited for together.  wait() may be called from inside a
+// task of the same pool: the waiting thread runs queued tasks until the
+// group is done instead of blocking a worker.  A task that throws does not
+// stop the others; wait() rethrows the first such exception.
+class TaskGroup
+{
+    public:
+        explicit TaskGroup(ThreadPool& pool);
+        ~TaskGroup();
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void run(function<void()> task);
+
+        // Blocks until every task of the group has finished
+        void wait();
+
+    private:
+        friend class ThreadPool;
+
+        ThreadPool& m_pool;
+        size_t m_pending;
+        exception_ptr m_error;
+};
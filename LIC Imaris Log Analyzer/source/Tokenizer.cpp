@@ -0,0 +1,346 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Tokenizer.h"
+#include "Utilities.h"
+
+#include <cstring>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LIC_TOKENIZER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LIC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LIC_TARGET_AVX2
+#endif
+
+using namespace std;
+
+namespace
+{
+    enum tokenizerState
+    {
+        BetweenTokens,
+        InToken,
+        InQuotedToken
+    };
+
+    inline unsigned int lowestBit(uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // Walks the space and quote masks of one block of the line.  The state
+    // carries over between blocks, so a token may span several of them.
+    // Returns true once the line has maxTokens tokens.
+    inline bool tokenizeBlock(string_view line,
+                              size_t blockStart,
+                              size_t blockSize,
+                              uint32_t spaces,
+                              uint32_t quotes,
+                              tokenizerState& state,
+                              size_t& tokenStart,
+                              vector<string_view>& tokens,
+                              size_t maxTokens)
+    {
+        uint32_t valid = (blockSize >= 32) ? 0xFFFFFFFFu : ((1u << blockSize) - 1);
+        uint32_t remaining = valid;
+
+        while (remaining)
+        {
+            uint32_t candidates;
+            if (state == BetweenTokens)
+            {
+                candidates = ~spaces & remaining;
+            }
+            else if (state == InToken)
+            {
+                candidates = spaces & remaining;
+            }
+            else
+            {
+                candidates = quotes & remaining;
+            }
+
+            if (! candidates)
+            {
+                return false;
+            }
+
+            unsigned int bit = lowestBit(candidates);
+            size_t pos = blockStart + bit;
+
+            if (state == BetweenTokens)
+            {
+                if (quotes & (1u << bit))
+                {
+                    state = InQuotedToken;
+                    tokenStart = pos + 1;
+                }
+                else
+                {
+                    state = InToken;
+                    tokenStart = pos;
+                }
+            }
+            else
+            {
+                tokens.push_back(line.substr(tokenStart, pos - tokenStart));
+                state = BetweenTokens;
+                if (tokens.size() == maxTokens)
+                {
+                    return true;
+                }
+            }
+
+            // Clear the bits up to and including the one just handled
+            remaining &= (bit >= 31) ? 0 : (0xFFFFFFFFu << (bit + 1));
+        }
+        return false;
+    }
+
+    inline void finishLine(string_view line,
+                           tokenizerState state,
+                           size_t tokenStart,
+                           vector<string_view>& tokens)
+    {
+        if (state != BetweenTokens)
+        {
+            tokens.push_back(line.substr(tokenStart));
+        }
+    }
+
+    void tokenizeLineScalar(string_view line, vector<string_view>& tokens, size_t maxTokens)
+    {
+        tokenizeStringView(" ", line, tokens, maxTokens);
+    }
+
+#ifdef LIC_TOKENIZER_X86
+    void tokenizeLineSSE2(string_view line, vector<string_view>& tokens, size_t maxTokens)
+    {
+        tokens.clear();
+        tokenizerState state = BetweenTokens;
+        size_t tokenStart = 0;
+        const __m128i spaceVector = _mm_set1_epi8(' ');
+        const __m128i quoteVector = _mm_set1_epi8('"');
+        const char* data = line.data();
+        size_t size = line.size();
+        size_t blockStart = 0;
+
+        for (; blockStart + 16 <= size; blockStart += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + blockStart));
+            uint32_t spaces = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, spaceVector)));
+            uint32_t quotes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, quoteVector)));
+            if (tokenizeBlock(line, blockStart, 16, spaces, quotes, state, tokenStart, tokens, maxTokens))
+            {
+                return;
+            }
+        }
+
+        // The tail is copied out so that no load reads past the end of the
+        // line, which may be the end of the mapped file
+        if (blockStart < size)
+        {
+            char tail[16] = {0};
+            memcpy(tail, data + blockStart, size - blockStart);
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+            uint32_t spaces = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, spaceVector)));
+            uint32_t quotes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, quoteVector)));
+            if (tokenizeBlock(line, blockStart, size - blockStart, spaces, quotes, state, tokenStart, tokens, maxTokens))
+            {
+                return;
+            }
+        }
+
+        finishLine(line, state, tokenStart, tokens);
+    }
+
+    LIC_TARGET_AVX2
+    void tokenizeLineAVX2(string_view line, vector<string_view>& tokens, size_t maxTokens)
+    {
+        tokens.clear();
+        tokenizerState state = BetweenTokens;
+        size_t tokenStart = 0;
+        const __m256i spaceVector = _mm256_set1_epi8(' ');
+        const __m256i quoteVector = _mm256_set1_epi8('"');
+        const char* data = line.data();
+        size_t size = line.size();
+        size_t blockStart = 0;
+
+        for (; blockStart + 32 <= size; blockStart += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + blockStart));
+            uint32_t spaces = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, spaceVector)));
+            uint32_t quotes = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, quoteVector)));
+            if (tokenizeBlock(line, blockStart, 32, spaces, quotes, state, tokenStart, tokens, maxTokens))
+            {
+                return;
+            }
+        }
+
+        if (blockStart < size)
+        {
+            char tail[32] = {0};
+            memcpy(tail, data + blockStart, size - blockStart);
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+            uint32_t spaces = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, spaceVector)));
+            uint32_t quotes = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, quoteVector)));
+            if (tokenizeBlock(line, blockStart, size - blockStart, spaces, quotes, state, tokenStart, tokens, maxTokens))
+            {
+                return;
+            }
+        }
+
+        finishLine(line, state, tokenStart, tokens);
+    }
+
+    bool cpuSupportsAVX2()
+    {
+#ifdef _MSC_VER
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 0);
+        if (cpuInfo[0] < 7)
+        {
+            return false;
+        }
+
+        // AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0)
+        __cpuid(cpuInfo, 1);
+        bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+        bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+        if (! osxsave || ! avx || (_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+        __cpuidex(cpuInfo, 7, 0);
+        return (cpuInfo[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    typedef void (*tokenizeLineFunction)(string_view, vector<string_view>&, size_t);
+
+    tokenizeLineFunction functionForBackend(TokenizerBackend backend)
+    {
+        switch (backend)
+        {
+#ifdef LIC_TOKENIZER_X86
+            case SSE2Tokenizer:
+                return tokenizeLineSSE2;
+            case AVX2Tokenizer:
+                return tokenizeLineAVX2;
+#endif
+            default:
+                return tokenizeLineScalar;
+        }
+    }
+
+    TokenizerBackend s_backend = detectTokenizerBackend();
+    tokenizeLineFunction s_tokenizeLine = functionForBackend(s_backend);
+}
+
+TokenizerBackend detectTokenizerBackend()
+{
+#ifdef LIC_TOKENIZER_X86
+    if (cpuSupportsAVX2())
+    {
+        return AVX2Tokenizer;
+    }
+    return SSE2Tokenizer;
+#else
+    return ScalarTokenizer;
+#endif
+}
+
+bool tokenizerBackendSupported(TokenizerBackend backend)
+{
+    switch (backend)
+    {
+        case ScalarTokenizer:
+            return true;
+#ifdef LIC_TOKENIZER_X86
+        case SSE2Tokenizer:
+            return true;
+        case AVX2Tokenizer:
+            return cpuSupportsAVX2();
+#endif
+        default:
+            return false;
+    }
+}
+
+bool setTokenizerBackend(TokenizerBackend backend)
+{
+    if (! tokenizerBackendSupported(backend))
+    {
+        return false;
+    }
+    s_backend = backend;
+    s_tokenizeLine = functionForBackend(backend);
+
+    return true;
+}
+
+TokenizerBackend tokenizerBackend()
+{
+    return s_backend;
+}
+
+string tokenizerBackendName(TokenizerBackend backend)
+{
+    switch (backend)
+    {
+        case SSE2Tokenizer:
+            return "sse2";
+        case AVX2Tokenizer:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+void tokenizeLine(string_view line, vector<string_view>& tokens, size_t maxTokens)
+{
+    if (maxTokens == 0)
+    {
+        tokens.clear();
+        return;
+    }
+    s_tokenizeLine(line, tokens, maxTokens);
+}
@@ -0,0 +1,57 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Backends for splitting report log lines at spaces.  All of them give the
+// same tokens as tokenizeStringView(" ", ...), including quoted fields; the
+// vectorized ones classify 16 (SSE2) or 32 (AVX2) bytes per step.
+enum TokenizerBackend
+{
+    ScalarTokenizer,
+    SSE2Tokenizer,
+    AVX2Tokenizer
+};
+
+// Best backend the running CPU supports.  This is what tokenizeLine uses
+// unless setTokenizerBackend picked another one.
+TokenizerBackend detectTokenizerBackend();
+
+bool tokenizerBackendSupported(TokenizerBackend backend);
+
+// Returns false (and keeps the current backend) if the CPU lacks support
+bool setTokenizerBackend(TokenizerBackend backend);
+
+TokenizerBackend tokenizerBackend();
+
+string tokenizerBackendName(TokenizerBackend backend);
+
+// Splits the line into at most maxTokens tokens; the scan stops at the end
+// of the last one, so the fields after it cost nothing
+void tokenizeLine(string_view line, vector<string_view>& tokens, size_t maxTokens = SIZE_MAX);
@@ -0,0 +1,101 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "TraceRecorder.h"
+#include "BufferedWriter.h"
+#include "Utilities.h"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace
+{
+    atomic<TraceRecorder*> s_traceRecorder(NULL);
+    atomic<uint32_t> s_nextThread(1);
+
+    // Small, stable numbers read better in a viewer than the system's ids
+    uint32_t traceThread()
+    {
+        thread_local uint32_t thread = s_nextThread.fetch_add(1);
+        return thread;
+    }
+}
+
+TraceRecorder::TraceRecorder()
+    : m_start(chrono::steady_clock::now())
+{
+}
+
+void TraceRecorder::record(const string& name, const string& category,
+                           chrono::steady_clock::time_point start, chrono::steady_clock::time_point end)
+{
+    Span span;
+    span.name = name;
+    span.category = category;
+    span.thread = traceThread();
+    span.startMicroseconds = chrono::duration_cast<chrono::microseconds>(start - m_start).count();
+    span.durationMicroseconds = chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+    lock_guard<mutex> lock(m_mutex);
+    m_spans.push_back(span);
+}
+
+void TraceRecorder::write(const string& outputFilePath) const
+{
+    vector<Span> spans;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        spans = m_spans;
+    }
+
+    BufferedWriter out(outputFilePath);
+    out.write("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    string event;
+    char numbers[128];
+    for (size_t span = 0; span < spans.size(); ++span)
+    {
+        const Span& current = spans.at(span);
+        event.assign(span == 0 ? "\n{\"name\": " : ",\n{\"name\": ");
+        appendJsonString(event, current.name);
+        event += ", \"cat\": ";
+        appendJsonString(event, current.category.empty() ? string("run") : current.category);
+        snprintf(numbers, sizeof(numbers), ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %lld, \"dur\": %lld}",
+                 current.thread, static_cast<long long>(current.startMicroseconds),
+                 static_cast<long long>(current.durationMicroseconds));
+        event += numbers;
+        out.write(event);
+    }
+    out.write("]}\n");
+    out.close();
+}
+
+void setTraceRecorder(TraceRecorder* recorder)
+{
+    s_traceRecorder = recorder;
+}
+
+TraceRecorder* currentTraceRecorder()
+{
+    return s_traceRecorder;
+}
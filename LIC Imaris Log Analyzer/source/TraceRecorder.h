@@ -0,0 +1,116 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Records when each thread ran which stage of a run, for a trace viewer
+// (chrome://tracing, Perfetto): unlike the totals of PipelineStats, a trace
+// shows where the parser waited for the reader, the reader for room ahead
+// of the parser, or the cores sat idle while a report was written.  The
+// spans are kept in memory and written as Chrome trace event JSON once the
+// run is over.  Building with LIC_NO_TRACING removes the scopes (see
+// LIC_TRACE_SCOPE) and leaves a recorder that records nothing.
+class TraceRecorder
+{
+    public:
+        TraceRecorder();
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        // A span of the calling thread; category is e.g. the log's name
+        void record(const string& name, const string& category,
+                    chrono::steady_clock::time_point start, chrono::steady_clock::time_point end);
+
+        // Throws CannotOpenFileException if the file cannot be written
+        void write(const string& outputFilePath) const;
+
+    private:
+        struct Span
+        {
+            string name;
+            string category;
+            uint32_t thread;
+            int64_t startMicroseconds;
+            int64_t durationMicroseconds;
+        };
+
+        chrono::steady_clock::time_point m_start;
+        vector<Span> m_spans;
+        mutable mutex m_mutex;
+};
+
+// The recorder the runs from now on record their spans to, or NULL (the
+// default) for none.  The caller keeps it alive until then.
+void setTraceRecorder(TraceRecorder* recorder);
+
+TraceRecorder* currentTraceRecorder();
+
+// Records the span from its construction to its destruction if a recorder
+// was set when it began.  Without one it costs a load and a branch.
+class TraceScope
+{
+    public:
+        explicit TraceScope(const char* name)
+            : m_recorder(currentTraceRecorder()),
+              m_name(name)
+        {
+            if (m_recorder != NULL)
+            {
+                m_start = chrono::steady_clock::now();
+            }
+        }
+
+        ~TraceScope()
+        {
+            if (m_recorder != NULL)
+            {
+                m_recorder->record(m_name, string(), m_start, chrono::steady_clock::now());
+            }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        TraceRecorder* m_recorder;
+        const char* m_name;
+        chrono::steady_clock::time_point m_start;
+};
+
+#define LIC_TRACE_CONCAT_LINE(name, line) name##line
+#define LIC_TRACE_CONCAT(name, line) LIC_TRACE_CONCAT_LINE(name, line)
+
+#ifdef LIC_NO_TRACING
+#define LIC_TRACE_SCOPE(name)
+#else
+#define LIC_TRACE_SCOPE(name) TraceScope LIC_TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
@@ -0,0 +1,202 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "UsageHeatmap.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+namespace
+{
+    const long long HourSeconds = 3600;
+    const long long WeekSeconds = 7 * 24 * HourSeconds;
+    // Day 0 of the epoch, 01/01/1970, was a Thursday
+    const long long EpochWeekOffset = 3 * 24 * HourSeconds;
+}
+
+UsageHeatmap::UsageHeatmap()
+    : m_started(false),
+      m_clock(0),
+      m_observedSeconds(Cells, 0)
+{
+}
+
+void UsageHeatmap::clear()
+{
+    m_started = false;
+    m_clock = 0;
+    m_observedSeconds.assign(Cells, 0);
+    m_inUseSeconds.clear();
+    m_peaks.clear();
+    m_inUse.clear();
+    m_countedTo.clear();
+}
+
+size_t UsageHeatmap::memoryBytes() const
+{
+    return heapBytes(m_observedSeconds) + heapBytes(m_inUseSeconds) + heapBytes(m_peaks) + heapBytes(m_inUse) +
+           heapBytes(m_countedTo);
+}
+
+void UsageHeatmap::resize(size_t products)
+{
+    if (products > m_inUse.size())
+    {
+        m_inUseSeconds.resize(products * Cells, 0);
+        m_peaks.resize(products * Cells, 0);
+        m_inUse.resize(products, 0);
+        m_countedTo.resize(products, m_clock);
+    }
+}
+
+void UsageHeatmap::advance(long long time)
+{
+    if (! m_started)
+    {
+        m_started = true;
+        m_clock = time;
+        fill(m_countedTo.begin(), m_countedTo.end(), time);
+        return;
+    }
+    while (m_clock < time)
+    {
+        long long cellEnd = m_clock - (m_clock % HourSeconds + HourSeconds) % HourSeconds + HourSeconds;
+        long long end = min(time, cellEnd);
+        m_observedSeconds[cellOf(m_clock)] += end - m_clock;
+        m_clock = end;
+    }
+}
+
+void UsageHeatmap::change(size_t product, int32_t inUse)
+{
+    count(product, m_countedTo.at(product), m_clock, m_inUse.at(product));
+    m_countedTo.at(product) = m_clock;
+    m_inUse.at(product) = inUse;
+    int32_t& peak = m_peaks.at(product * Cells + cellOf(m_clock));
+    peak = max(peak, inUse);
+}
+
+void UsageHeatmap::flush()
+{
+    for (size_t product = 0; product < m_inUse.size(); ++product)
+    {
+        count(product, m_countedTo[product], m_clock, m_inUse[product]);
+        m_countedTo[product] = m_clock;
+    }
+}
+
+void UsageHeatmap::takeProducts(const UsageHeatmap& shard, size_t firstProduct, size_t endProduct)
+{
+    m_started = shard.m_started;
+    m_clock = shard.m_clock;
+    m_observedSeconds = shard.m_observedSeconds;
+    copy(shard.m_inUseSeconds.begin() + firstProduct * Cells, shard.m_inUseSeconds.begin() + endProduct * Cells,
+         m_inUseSeconds.begin() + firstProduct * Cells);
+    copy(shard.m_peaks.begin() + firstProduct * Cells, shard.m_peaks.begin() + endProduct * Cells,
+         m_peaks.begin() + firstProduct * Cells);
+    copy(shard.m_inUse.begin() + firstProduct, shard.m_inUse.begin() + endProduct, m_inUse.begin() + firstProduct);
+    copy(shard.m_countedTo.begin() + firstProduct, shard.m_countedTo.begin() + endProduct, m_countedTo.begin() + firstProduct);
+}
+
+size_t UsageHeatmap::products() const
+{
+    return m_inUse.size();
+}
+
+long long UsageHeatmap::observedSeconds(size_t cell) const
+{
+    return m_observedSeconds.at(cell);
+}
+
+double UsageHeatmap::mean(size_t product, size_t cell) const
+{
+    long long observed = m_observedSeconds.at(cell);
+    if (observed == 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(m_inUseSeconds.at(product * Cells + cell)) / observed;
+}
+
+int32_t UsageHeatmap::peak(size_t product, size_t cell) const
+{
+    return m_peaks.at(product * Cells + cell);
+}
+
+void UsageHeatmap::save(Checkpoint& checkpoint) const
+{
+    checkpoint.heatmapClock = m_started ? m_clock : LLONG_MIN;
+    checkpoint.heatmapObserved = m_observedSeconds;
+    checkpoint.heatmapSeconds = m_inUseSeconds;
+    checkpoint.heatmapPeaks = m_peaks;
+    checkpoint.heatmapInUse = m_inUse;
+}
+
+bool UsageHeatmap::restore(const Checkpoint& checkpoint)
+{
+    size_t products = checkpoint.heatmapInUse.size();
+    if (checkpoint.heatmapObserved.size() != Cells ||
+        checkpoint.heatmapSeconds.size() != products * Cells ||
+        checkpoint.heatmapPeaks.size() != products * Cells ||
+        products > checkpoint.products.size())
+    {
+        return false;
+    }
+
+    m_started = checkpoint.heatmapClock != LLONG_MIN;
+    m_clock = m_started ? checkpoint.heatmapClock : 0;
+    m_observedSeconds = checkpoint.heatmapObserved;
+    m_inUseSeconds = checkpoint.heatmapSeconds;
+    m_peaks = checkpoint.heatmapPeaks;
+    m_inUse = checkpoint.heatmapInUse;
+    m_countedTo.assign(products, m_clock);
+    return true;
+}
+
+// The hour of the week from Monday 00:00 on
+size_t UsageHeatmap::cellOf(long long time)
+{
+    long long weekTime = ((time + EpochWeekOffset) % WeekSeconds + WeekSeconds) % WeekSeconds;
+    return static_cast<size_t>(weekTime / HourSeconds);
+}
+
+// Adds the licenses in use from one time to another to the cells between
+void UsageHeatmap::count(size_t product, long long from, long long to, int32_t inUse)
+{
+    if (inUse <= 0)
+    {
+        return;
+    }
+    while (from < to)
+    {
+        long long cellEnd = from - (from % HourSeconds + HourSeconds) % HourSeconds + HourSeconds;
+        long long end = min(to, cellEnd);
+        size_t cell = product * Cells + cellOf(from);
+        m_inUseSeconds[cell] += inUse * (end - from);
+        m_peaks[cell] = max(m_peaks[cell], inUse);
+        from = end;
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Checkpoint.h"
+
+using namespace std;
+
+// The floating licenses of every product in use over the week: the seconds
+// each license was in use, summed into the 7 x 24 cells of an hour of a
+// weekday, and the most in use at once in every cell.  It is filled one
+// change of the usage at a time as the usage pass walks the events, so its
+// size depends on the products alone and not on the length of the log.
+// Days start on Monday; the log times are taken as they are, without a
+// time zone.
+class UsageHeatmap
+{
+    public:
+        static const size_t Days = 7;
+        static const size_t Hours = 24;
+        static const size_t Cells = Days * Hours;
+
+        UsageHeatmap();
+
+        void clear();
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // Room for the product ids below products; a new product starts
+        // with none in use
+        void resize(size_t products);
+
+        // Moves the clock on to time; the first call starts it.  An earlier
+        // time, of an event slightly out of order, leaves it where it is.
+        void advance(long long time);
+
+        // The floating licenses of the product in use from the clock on
+        void change(size_t product, int32_t inUse);
+
+        // Counts the licenses in use up to the clock, before the results
+        // are read or saved
+        void flush();
+
+        // Takes the products [firstProduct, endProduct) and the clock from a
+        // heatmap of as many products that followed the same events with
+        // the changes of those products alone, one shard of a parallel pass
+        void takeProducts(const UsageHeatmap& shard, size_t firstProduct, size_t endProduct);
+
+        size_t products() const;
+        // Seconds of the cell the clock went through, over all weeks
+        long long observedSeconds(size_t cell) const;
+        // The time-weighted mean in use over the observed seconds, 0 if none
+        double mean(size_t product, size_t cell) const;
+        int32_t peak(size_t product, size_t cell) const;
+
+        // The flushed state, for a checkpoint; restore is false if the
+        // checkpoint does not fit the products
+        void save(Checkpoint& checkpoint) const;
+        bool restore(const Checkpoint& checkpoint);
+
+        // The cell of a time, its hour of the week from Monday 00:00 on
+        static size_t cellOf(long long time);
+
+    private:
+        void count(size_t product, long long from, long long to, int32_t inUse);
+
+        bool m_started;
+        long long m_clock;
+        vector<int64_t> m_observedSeconds;
+        // The cells of product p are at p * Cells on
+        vector<int64_t> m_inUseSeconds;
+        vector<int32_t> m_peaks;
+        // The licenses of every product in use since the time it was last
+        // counted up to
+        vector<int32_t> m_inUse;
+        vector<long long> m_countedTo;
+};
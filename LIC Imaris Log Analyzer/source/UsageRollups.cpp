@@ -0,0 +1,309 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "UsageRollups.h"
+#include "HeapBytes.h"
+#include "Utilities.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    const long long DaySeconds = 24 * 3600;
+    // 01/01/1970 was a Thursday, three days after the Monday a week starts on
+    const long long EpochWeekdayOffset = 3;
+
+    // Day number of time, rounding down before the epoch
+    long long dayOf(long long time)
+    {
+        return (time >= 0) ? time / DaySeconds : -((-time + DaySeconds - 1) / DaySeconds);
+    }
+}
+
+bool UsageRollups::parsePeriod(string_view name, rollupPeriod& period)
+{
+    const char* names[Periods] = { "day", "week", "month" };
+    for (size_t index = 0; index < Periods; ++index)
+    {
+        if (name == names[index])
+        {
+            period = static_cast<rollupPeriod>(index);
+            return true;
+        }
+    }
+    return false;
+}
+
+long long UsageRollups::periodStart(rollupPeriod period, long long time)
+{
+    long long day = dayOf(time);
+    if (period == DayRollup)
+    {
+        return day * DaySeconds;
+    }
+    if (period == WeekRollup)
+    {
+        long long weekday = ((day + EpochWeekdayOffset) % 7 + 7) % 7;
+        return (day - weekday) * DaySeconds;
+    }
+
+    DateTime dateTime;
+    epochToDateTime(time, dateTime);
+    DateTime start = { dateTime.year, dateTime.month, 1, 0, 0, 0 };
+    return dateTimeToEpoch(start);
+}
+
+long long UsageRollups::nextPeriodStart(rollupPeriod period, long long time)
+{
+    if (period == DayRollup)
+    {
+        return periodStart(period, time) + DaySeconds;
+    }
+    if (period == WeekRollup)
+    {
+        return periodStart(period, time) + 7 * DaySeconds;
+    }
+
+    DateTime dateTime;
+    epochToDateTime(time, dateTime);
+    DateTime next = { dateTime.year + dateTime.month / 12, dateTime.month % 12 + 1, 1, 0, 0, 0 };
+    return dateTimeToEpoch(next);
+}
+
+void UsageRollups::clear()
+{
+    for (size_t period = 0; period < Periods; ++period)
+    {
+        m_rollups[period] = Rollup();
+    }
+}
+
+bool UsageRollups::empty() const
+{
+    return m_rollups[DayRollup].observed.empty();
+}
+
+size_t UsageRollups::memoryBytes() const
+{
+    size_t bytes = 0;
+    for (size_t period = 0; period < Periods; ++period)
+    {
+        const Rollup& rollup = m_rollups[period];
+        bytes += heapBytes(rollup.usage) + heapBytes(rollup.observed) + heapBytes(rollup.users) + heapBytes(rollup.hosts);
+    }
+    return bytes;
+}
+
+void UsageRollups::addObserved(long long from, long long to)
+{
+    for (long long start = from; start < to; )
+    {
+        long long day = dayOf(start) * DaySeconds;
+        long long end = min(day + DaySeconds, to);
+        m_rollups[DayRollup].observed[day] += end - start;
+        start = end;
+    }
+}
+
+void UsageRollups::addUsage(size_t product, long long from, long long to, int32_t inUse)
+{
+    long long start = from;
+    do
+    {
+        long long day = dayOf(start) * DaySeconds;
+        long long end = min(day + DaySeconds, max(to, from));
+        RollupUsage& usage = m_rollups[DayRollup].usage[make_pair(day, product)];
+        usage.peak = max(usage.peak, inUse);
+        usage.inUseSeconds += static_cast<int64_t>(inUse) * (end - start);
+        start = end;
+    }
+    while (start < to);
+}
+
+void UsageRollups::addDenials(size_t product, long long time, uint64_t requests)
+{
+    m_rollups[DayRollup].usage[make_pair(dayOf(time) * DaySeconds, product)].denials += requests;
+}
+
+void UsageRollups::addSession(size_t product, size_t user, size_t host, long long checkOut, long long checkIn)
+{
+    for (long long start = checkOut; start < checkIn; )
+    {
+        long long day = dayOf(start) * DaySeconds;
+        long long end = min(day + DaySeconds, checkIn);
+        m_rollups[DayRollup].users[make_tuple(day, user, product)] += end - start;
+        m_rollups[DayRollup].hosts[make_tuple(day, host, product)] += end - start;
+        start = end;
+    }
+}
+
+// Weeks and months hold whole days, so they are summed from the days, with
+// the peak the largest of their days
+void UsageRollups::rollUp()
+{
+    const Rollup& days = m_rollups[DayRollup];
+    for (size_t period = WeekRollup; period < Periods; ++period)
+    {
+        rollupPeriod rollup = static_cast<rollupPeriod>(period);
+        Rollup& periods = m_rollups[period];
+        periods = Rollup();
+        for (const auto& usage : days.usage)
+        {
+            RollupUsage& total = periods.usage[make_pair(periodStart(rollup, usage.first.first), usage.first.second)];
+            total.peak = max(total.peak, usage.second.peak);
+            total.inUseSeconds += usage.second.inUseSeconds;
+            total.denials += usage.second.denials;
+        }
+        for (const auto& observed : days.observed)
+        {
+            periods.observed[periodStart(rollup, observed.first)] += observed.second;
+        }
+        for (const auto& duration : days.users)
+        {
+            periods.users[make_tuple(periodStart(rollup, get<0>(duration.first)), get<1>(duration.first), get<2>(duration.first))] +=
+                duration.second;
+        }
+        for (const auto& duration : days.hosts)
+        {
+            periods.hosts[make_tuple(periodStart(rollup, get<0>(duration.first)), get<1>(duration.first), get<2>(duration.first))] +=
+                duration.second;
+        }
+    }
+}
+
+const map<pair<long long, size_t>, RollupUsage>& UsageRollups::usage(rollupPeriod period) const
+{
+    return m_rollups[period].usage;
+}
+
+const map<long long, int64_t>& UsageRollups::observedSeconds(rollupPeriod period) const
+{
+    return m_rollups[period].observed;
+}
+
+const map<tuple<long long, size_t, size_t>, int64_t>& UsageRollups::userDurations(rollupPeriod period) const
+{
+    return m_rollups[period].users;
+}
+
+const map<tuple<long long, size_t, size_t>, int64_t>& UsageRollups::hostDurations(rollupPeriod period) const
+{
+    return m_rollups[period].hosts;
+}
+
+double UsageRollups::mean(rollupPeriod period, long long start, size_t product) const
+{
+    map<long long, int64_t>::const_iterator observed = m_rollups[period].observed.find(start);
+    map<pair<long long, size_t>, RollupUsage>::const_iterator usage = m_rollups[period].usage.find(make_pair(start, product));
+    if (observed == m_rollups[period].observed.end() || observed->second <= 0 || usage == m_rollups[period].usage.end())
+    {
+        return 0.0;
+    }
+    return static_cast<double>(usage->second.inUseSeconds) / static_cast<double>(observed->second);
+}
+
+void UsageRollups::save(RollupCache& cache) const
+{
+    for (size_t period = 0; period < Periods; ++period)
+    {
+        const Rollup& rollup = m_rollups[period];
+        for (const auto& usage : rollup.usage)
+        {
+            int64_t values[] = { static_cast<int64_t>(period), usage.first.first, static_cast<int64_t>(usage.first.second),
+                                 usage.second.peak, usage.second.inUseSeconds, static_cast<int64_t>(usage.second.denials) };
+            cache.usage.insert(cache.usage.end(), values, values + 6);
+        }
+        for (const auto& observed : rollup.observed)
+        {
+            int64_t values[] = { static_cast<int64_t>(period), observed.first, observed.second };
+            cache.observed.insert(cache.observed.end(), values, values + 3);
+        }
+        const map<tuple<long long, size_t, size_t>, int64_t>* durations[] = { &rollup.users, &rollup.hosts };
+        vector<int64_t>* columns[] = { &cache.userDurations, &cache.hostDurations };
+        for (size_t table = 0; table < 2; ++table)
+        {
+            for (const auto& duration : *durations[table])
+            {
+                int64_t values[] = { static_cast<int64_t>(period), get<0>(duration.first), static_cast<int64_t>(get<1>(duration.first)),
+                                     static_cast<int64_t>(get<2>(duration.first)), duration.second };
+                columns[table]->insert(columns[table]->end(), values, values + 5);
+            }
+        }
+    }
+}
+
+bool UsageRollups::restore(const RollupCache& cache)
+{
+    clear();
+    if (cache.usage.size() % 6 != 0 || cache.observed.size() % 3 != 0 ||
+        cache.userDurations.size() % 5 != 0 || cache.hostDurations.size() % 5 != 0)
+    {
+        return false;
+    }
+
+    const int64_t products = static_cast<int64_t>(cache.products.size());
+    for (size_t value = 0; value < cache.usage.size(); value += 6)
+    {
+        const int64_t* usage = &cache.usage[value];
+        if (usage[0] < 0 || usage[0] >= static_cast<int64_t>(Periods) || usage[2] < 0 || usage[2] >= products)
+        {
+            clear();
+            return false;
+        }
+        RollupUsage& rollup = m_rollups[usage[0]].usage[make_pair(usage[1], static_cast<size_t>(usage[2]))];
+        rollup.peak = static_cast<int32_t>(usage[3]);
+        rollup.inUseSeconds = usage[4];
+        rollup.denials = static_cast<uint64_t>(usage[5]);
+    }
+    for (size_t value = 0; value < cache.observed.size(); value += 3)
+    {
+        const int64_t* observed = &cache.observed[value];
+        if (observed[0] < 0 || observed[0] >= static_cast<int64_t>(Periods))
+        {
+            clear();
+            return false;
+        }
+        m_rollups[observed[0]].observed[observed[1]] = observed[2];
+    }
+    const vector<int64_t>* columns[] = { &cache.userDurations, &cache.hostDurations };
+    const int64_t rows[] = { static_cast<int64_t>(cache.users.size()), static_cast<int64_t>(cache.hosts.size()) };
+    for (size_t table = 0; table < 2; ++table)
+    {
+        for (size_t value = 0; value < columns[table]->size(); value += 5)
+        {
+            const int64_t* duration = &columns[table]->at(value);
+            if (duration[0] < 0 || duration[0] >= static_cast<int64_t>(Periods) ||
+                duration[2] < 0 || duration[2] >= rows[table] || duration[3] < 0 || duration[3] >= products)
+            {
+                clear();
+                return false;
+            }
+            Rollup& rollup = m_rollups[duration[0]];
+            (table == 0 ? rollup.users : rollup.hosts)[make_tuple(duration[1], static_cast<size_t>(duration[2]),
+                                                                  static_cast<size_t>(duration[3]))] = duration[4];
+        }
+    }
+    return true;
+}
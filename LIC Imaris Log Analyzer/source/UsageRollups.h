@@ -0,0 +1,111 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include "EventCache.h"
+
+using namespace std;
+
+enum rollupPeriod
+{
+    DayRollup,
+    WeekRollup,
+    MonthRollup
+};
+
+// The usage of a product over one day, week or month: the most floating
+// licenses in use at once, the license seconds in use (whose mean over
+// the observed seconds of the period is the time-weighted mean) and the
+// denied requests
+struct RollupUsage
+{
+    RollupUsage() : peak(0), inUseSeconds(0), denials(0) {}
+
+    int32_t peak;
+    int64_t inUseSeconds;
+    uint64_t denials;
+};
+
+// Day, week and month totals of an analyzed log, kept with its event cache
+// (see RollupCache) so that dashboards over years of logs read them instead
+// of the events.  The intervals added are split into days, which rollUp
+// then sums into weeks and months.  Weeks start on Monday, as in the usage
+// heatmap, and the log times are taken as they are, without a time zone.
+class UsageRollups
+{
+    public:
+        static const size_t Periods = 3;
+
+        // "day", "week" or "month"
+        static bool parsePeriod(string_view name, rollupPeriod& period);
+        // The start of the period holding time, and that of the next one
+        static long long periodStart(rollupPeriod period, long long time);
+        static long long nextPeriodStart(rollupPeriod period, long long time);
+
+        void clear();
+        bool empty() const;
+        // The heap it holds, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // The log observed over [from, to)
+        void addObserved(long long from, long long to);
+        // inUse floating licenses of the product over [from, to).  An empty
+        // interval still counts for the peak of its period.
+        void addUsage(size_t product, long long from, long long to, int32_t inUse);
+        void addDenials(size_t product, long long time, uint64_t requests);
+        // A session of the user on the host over [checkOut, checkIn)
+        void addSession(size_t product, size_t user, size_t host, long long checkOut, long long checkIn);
+        // The weeks and months of the days added, once they all are
+        void rollUp();
+
+        // By period start and product, or by period start, user (or host)
+        // and product; only the periods with usage, denials or sessions
+        const map<pair<long long, size_t>, RollupUsage>& usage(rollupPeriod period) const;
+        const map<long long, int64_t>& observedSeconds(rollupPeriod period) const;
+        const map<tuple<long long, size_t, size_t>, int64_t>& userDurations(rollupPeriod period) const;
+        const map<tuple<long long, size_t, size_t>, int64_t>& hostDurations(rollupPeriod period) const;
+        // The time-weighted mean in use over the observed seconds, 0 if none
+        double mean(rollupPeriod period, long long start, size_t product) const;
+
+        // The rollups in the columns of a cache; restore is false if they
+        // do not fit the names of the cache
+        void save(RollupCache& cache) const;
+        bool restore(const RollupCache& cache);
+
+    private:
+        struct Rollup
+        {
+            map<pair<long long, size_t>, RollupUsage> usage;
+            map<long long, int64_t> observed;
+            map<tuple<long long, size_t, size_t>, int64_t> users;
+            map<tuple<long long, size_t, size_t>, int64_t> hosts;
+        };
+
+        Rollup m_rollups[Periods];
+};
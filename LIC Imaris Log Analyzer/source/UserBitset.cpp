@@ -0,0 +1,125 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "UserBitset.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    inline size_t populationCount(uint64_t word)
+    {
+#ifdef _MSC_VER
+        return static_cast<size_t>(__popcnt64(word));
+#else
+        return static_cast<size_t>(__builtin_popcountll(word));
+#endif
+    }
+
+    inline size_t lowestBit(uint64_t word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return index;
+#else
+        return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+    }
+}
+
+void UserBitset::reset(size_t users)
+{
+    m_words.assign((users + 63) / 64, 0);
+}
+
+void UserBitset::insert(size_t user)
+{
+    m_words.at(user / 64) |= uint64_t(1) << (user % 64);
+}
+
+void UserBitset::erase(size_t user)
+{
+    m_words.at(user / 64) &= ~(uint64_t(1) << (user % 64));
+}
+
+bool UserBitset::contains(size_t user) const
+{
+    return user / 64 < m_words.size() && (m_words[user / 64] >> (user % 64)) & 1;
+}
+
+size_t UserBitset::count() const
+{
+    size_t users = 0;
+    for (size_t word = 0; word < m_words.size(); ++word)
+    {
+        users += populationCount(m_words[word]);
+    }
+    return users;
+}
+
+size_t UserBitset::countNotIn(const UserBitset& other) const
+{
+    size_t users = 0;
+    for (size_t word = 0; word < m_words.size(); ++word)
+    {
+        uint64_t otherWord = word < other.m_words.size() ? other.m_words[word] : 0;
+        users += populationCount(m_words[word] & ~otherWord);
+    }
+    return users;
+}
+
+void UserBitset::unionWith(const UserBitset& other)
+{
+    if (m_words.size() < other.m_words.size())
+    {
+        m_words.resize(other.m_words.size(), 0);
+    }
+    for (size_t word = 0; word < other.m_words.size(); ++word)
+    {
+        m_words[word] |= other.m_words[word];
+    }
+}
+
+size_t UserBitset::next(size_t user) const
+{
+    size_t word = user / 64;
+    if (word >= m_words.size())
+    {
+        return NoId;
+    }
+    uint64_t bits = m_words[word] & (~uint64_t(0) << (user % 64));
+    while (bits == 0)
+    {
+        if (++word == m_words.size())
+        {
+            return NoId;
+        }
+        bits = m_words[word];
+    }
+    return word * 64 + lowestBit(bits);
+}
@@ -0,0 +1,58 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "EventStore.h"
+
+using namespace std;
+
+// A set of interned user ids, one bit per user in 64-bit words, e.g. the
+// users that hold a license of a product.  The size of a set is a
+// population count and the union of sets a bitwise or, so the unique users
+// of several servers are combined without replaying their events.
+class UserBitset
+{
+    public:
+        UserBitset() {}
+
+        // Room for the user ids below users; the set is left empty
+        void reset(size_t users);
+
+        void insert(size_t user);
+        void erase(size_t user);
+        bool contains(size_t user) const;
+
+        size_t count() const;
+        // The number of users in this set but not in other
+        size_t countNotIn(const UserBitset& other) const;
+        void unionWith(const UserBitset& other);
+
+        // The first user from user on that is in the set, NoId if none
+        size_t next(size_t user) const;
+
+    private:
+        vector<uint64_t> m_words;
+};
@@ -22,7 +22,15 @@
 
 #include "Utilities.h"
 #include "Exceptions.h"
+#include "BufferedWriter.h"
 #include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <string>
 #include <vector>
 #include <boost/date_time/gregorian/gregorian.hpp>
@@ -31,9 +39,27 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 using namespace boost::filesystem;
 
+namespace
+{
+    atomic<bool> s_memoryHints(true);
+}
+
 void loadDataFromFile(const string& filePath, vector<string>& fileData)
 {
     string line;
@@ -57,42 +83,249 @@ void loadDataFromFile(const string& filePath, vector<string>& fileData)
     }
 }
 
-void tokenizeString(const string& delimiter,
-                    const string& str,
-                    vector<string>& tokens)
+bool MappedFile::fits(const string& filePath)
 {
-    size_t startPos = 0;
-    size_t endPos = 0;
-    tokens.clear();
-    bool withinQuotes = false;
-    string localDelimiter = delimiter;
+    const uint64_t maxMappedSize = (sizeof(size_t) < 8) ? (1ull << 30) : UINT64_MAX;
+    long long size = getFileSize(filePath);
+    return size < 0 || static_cast<uint64_t>(size) <= maxMappedSize;
+}
+
+void MappedFile::open(const string& filePath)
+{
+    if (! fileExists(filePath))
+    {
+        CannotOpenFileException cannotOpenFileException(filePath);
+        throw cannotOpenFileException;
+    }
+
+    // An empty file cannot be mapped, it simply has no lines.  A mapping of
+    // the file from an earlier open is dropped.
+    if (boost::filesystem::file_size(filePath) == 0)
+    {
+        close();
+        return;
+    }
+
+    try
+    {
+        boost::interprocess::file_mapping mapping(filePath.c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+        m_mapping.swap(mapping);
+        m_region.swap(region);
+    }
+    catch (boost::interprocess::interprocess_exception&)
+    {
+        CannotOpenFileException cannotOpenFileException(filePath);
+        throw cannotOpenFileException;
+    }
+}
+
+// Unmaps the file, after which it is empty
+void MappedFile::close()
+{
+    boost::interprocess::mapped_region region;
+    boost::interprocess::file_mapping mapping;
+    m_region.swap(region);
+    m_mapping.swap(mapping);
+}
+
+const char* MappedFile::data() const
+{
+    return static_cast<const char*>(m_region.get_address());
+}
+
+size_t MappedFile::size() const
+{
+    return m_region.get_size();
+}
+
+void MappedFile::adviseRead(size_t offset, size_t length) const
+{
+    if (! s_memoryHints || offset >= size())
+    {
+        return;
+    }
+    length = min(length, size() - offset);
+#ifdef _WIN32
+    // PrefetchVirtualMemory came with Windows 8, so it is looked up rather
+    // than linked
+    struct MemoryRange
+    {
+        void* address;
+        size_t bytes;
+    };
+    typedef BOOL (WINAPI* PrefetchVirtualMemoryFunction)(HANDLE, ULONG_PTR, MemoryRange*, ULONG);
+    static PrefetchVirtualMemoryFunction prefetch = reinterpret_cast<PrefetchVirtualMemoryFunction>(
+        reinterpret_cast<void*>(GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory")));
+    if (prefetch != NULL)
+    {
+        MemoryRange range = { const_cast<char*>(data()) + offset, length };
+        prefetch(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(data() + offset);
+    uintptr_t pageStart = start - start % pageSize;
+    void* address = reinterpret_cast<void*>(pageStart);
+    madvise(address, length + (start - pageStart), MADV_SEQUENTIAL);
+    madvise(address, length + (start - pageStart), MADV_WILLNEED);
+#endif
+}
+
+void setMemoryHints(bool enabled)
+{
+    s_memoryHints = enabled;
+}
+
+void adviseHugePages(const void* data, size_t bytes)
+{
+#ifdef MADV_HUGEPAGE
+    const uintptr_t hugePageSize = 2 << 20;
+    uintptr_t start = (reinterpret_cast<uintptr_t>(data) + hugePageSize - 1) & ~(hugePageSize - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(data) + bytes) & ~(hugePageSize - 1);
+    if (s_memoryHints && end > start)
+    {
+        madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE);
+    }
+#else
+    (void) data;
+    (void) bytes;
+#endif
+}
+
+// Hands out the line starting at offset and moves offset past its line break.
+// Like getline, the text after the last line break is a line of its own,
+// even when it is empty.
+bool nextLineView(const MappedFile& file, size_t& offset, string_view& lineView)
+{
+    return nextLineView(string_view(file.data(), file.size()), offset, lineView);
+}
 
-    do
+bool nextLineView(string_view text, size_t& offset, string_view& lineView)
+{
+    const char* data = text.data();
+    size_t size = text.size();
+
+    if (offset > size)
     {
-        startPos = str.find_first_not_of(localDelimiter, startPos);
-        endPos = str.find_first_of(localDelimiter, startPos);
+        return false;
+    }
 
-        if (startPos != string::npos)
+    const char* lineBreak = NULL;
+    if (offset < size)
+    {
+        lineBreak = static_cast<const char*>(memchr(data + offset, '\n', size - offset));
+    }
+    size_t endPos = lineBreak ? lineBreak - data : size;
+    size_t length = endPos - offset;
+
+    // Remove extra line break, if present
+    if (length > 0 && data[endPos-1] == '\r')
+    {
+        --length;
+    }
+    lineView = string_view(data + offset, length);
+    offset = endPos + 1;
+
+    return true;
+}
+
+void loadLineViewsFromFile(const MappedFile& file, vector<string_view>& lineViews)
+{
+    size_t offset = 0;
+    string_view lineView;
+
+    while (nextLineView(file, offset, lineView))
+    {
+        lineViews.push_back(lineView);
+    }
+}
+
+// Splits str at any of the delimiter characters.  The tokens are views into
+// str and are written into the caller's buffer, which keeps its capacity
+// between calls. A field starting with a quote runs to the closing quote
+// and may contain delimiters; an unclosed quote runs to the end of str.
+void tokenizeStringView(string_view delimiter,
+                        string_view str,
+                        vector<string_view>& tokens,
+                        size_t maxTokens)
+{
+    tokens.clear();
+    size_t startPos = str.find_first_not_of(delimiter);
+
+    while (startPos != string_view::npos && tokens.size() < maxTokens)
+    {
+        size_t endPos;
+        if (str[startPos] == '"')
         {
-            if (str.at(startPos) == '"')
+            ++startPos;
+            endPos = str.find('"', startPos);
+            tokens.push_back(str.substr(startPos, endPos - startPos));
+            if (endPos == string_view::npos)
             {
-                withinQuotes = true;
-                startPos = startPos + 1;
-                localDelimiter = "\"";
-                endPos = str.find_first_of(localDelimiter, startPos);
-                if (endPos != string::npos)
-                    localDelimiter = delimiter;
+                break;
             }
-
+            ++endPos;
+        }
+        else
+        {
+            endPos = str.find_first_of(delimiter, startPos);
             tokens.push_back(str.substr(startPos, endPos - startPos));
-
-            if (withinQuotes)
-                endPos = endPos + 1;
-                withinQuotes = false;
+            if (endPos == string_view::npos)
+            {
+                break;
+            }
         }
-        startPos = endPos;
+        startPos = str.find_first_not_of(delimiter, endPos);
+    }
+}
+
+string_view firstToken(string_view line)
+{
+    size_t startPos = line.find_first_not_of(' ');
+    if (startPos == string_view::npos)
+    {
+        return string_view();
     }
-    while (endPos != string::npos);
+    size_t endPos;
+    if (line[startPos] == '"')
+    {
+        ++startPos;
+        endPos = line.find('"', startPos);
+    }
+    else
+    {
+        endPos = line.find(' ', startPos);
+    }
+    return line.substr(startPos, endPos == string_view::npos ? string_view::npos : endPos - startPos);
+}
+
+void tokenizeString(const string& delimiter,
+                    string_view str,
+                    vector<string>& tokens)
+{
+    vector<string_view> tokenViews;
+    tokenizeStringView(delimiter, str, tokenViews);
+
+    tokens.clear();
+    for (size_t token = 0; token < tokenViews.size(); ++token)
+    {
+        tokens.push_back(string(tokenViews.at(token)));
+    }
+}
+
+int stringViewToInt(string_view str)
+{
+    // Behaves like atoi on the leading digits, but needs no terminating null
+    int value = 0;
+    size_t startPos = 0;
+    if (! str.empty() && str[0] == '+')
+    {
+        startPos = 1;
+    }
+    from_chars(str.data() + startPos, str.data() + str.size(), value);
+
+    return value;
 }
 
 void untokenizeString(const string& delimiter,
@@ -110,7 +343,7 @@ void untokenizeString(const string& delimiter,
     }
 }
 
-void getUniqueItems(string& itemName, vector<string>& uniqueItems)
+void getUniqueItems(string_view itemName, vector<string>& uniqueItems)
 {
     bool duplicate = false;
     for (size_t item=0; item < uniqueItems.size(); ++item)
@@ -124,38 +357,30 @@ void getUniqueItems(string& itemName, vector<string>& uniqueItems)
 
     if (! duplicate)
     {
-        uniqueItems.push_back(itemName);
+        uniqueItems.push_back(string(itemName));
     }
 }
 
 void write2DVectorToFile(const string filePath,
                          const vector < vector<string> >& data,
-                         const string delimiter)
+                         const string delimiter,
+                         compressionFormat compression)
 {
-    ofstream myfile;
-    myfile.open (filePath.c_str());
-    if (myfile.is_open())
+    BufferedWriter out(filePath, false, compression);
+    for (size_t row = 0; row<data.size(); ++row)
     {
-        for (size_t row = 0; row<data.size(); ++row)
+        size_t columnSize = data[row].size();
+        for (size_t col = 0; col<columnSize; ++col)
         {
-            size_t columnSize = data.at(row).size();
-            for (size_t col = 0; col<columnSize; ++col)
+            out.write(data[row][col]);
+            if (col != columnSize-1)
             {
-                myfile << data.at(row).at(col);
-                if (col != columnSize-1)
-                {
-                    myfile << delimiter;
-                }
+                out.write(delimiter);
             }
-            myfile << "\n";
         }
-        myfile.close();
-    }
-    else
-    {
-        CannotOpenFileException cannotOpenFileException(filePath);
-        throw cannotOpenFileException;
+        out.write('\n');
     }
+    out.close();
 }
 
 void findReplaceAll(const string oldPattern,
@@ -218,10 +443,10 @@ ptime stringToBoostTime(string& dateString,
 {
     date boostDate(from_us_string(dateString));
 
-    vector<string> timeVector;
-    tokenizeString(":", timeString, timeVector);
-    int intHours = atoi(timeVector.at(0).c_str());
-    int intMinutes = atoi(timeVector.at(1).c_str());
+    vector<string_view> timeVector;
+    tokenizeStringView(":", timeString, timeVector);
+    int intHours = stringViewToInt(timeVector.at(0));
+    int intMinutes = stringViewToInt(timeVector.at(1));
     int intSeconds;
 
     if (timeVector.size() < 3)
@@ -230,24 +455,280 @@ ptime stringToBoostTime(string& dateString,
     }
     else
     {
-        intSeconds = atoi(timeVector.at(2).c_str());
+        intSeconds = stringViewToInt(timeVector.at(2));
     }
     ptime dateTime(boostDate, hours(intHours)+minutes(intMinutes)+seconds(intSeconds));
    
     return dateTime;
 }
 
+namespace
+{
+    // Parses the digits of str[pos, end) and moves pos past them
+    bool parseNumberField(string_view str, size_t& pos, size_t end, int& value)
+    {
+        if (pos >= end || end > str.size())
+        {
+            return false;
+        }
+        const char* first = str.data() + pos;
+        const char* last = str.data() + end;
+        from_chars_result result = from_chars(first, last, value);
+        if (result.ec != errc() || result.ptr != last)
+        {
+            return false;
+        }
+        pos = end + 1;
+
+        return true;
+    }
+
+    size_t fieldEnd(string_view str, size_t pos, char separator)
+    {
+        size_t found = str.find(separator, pos);
+        return (found == string_view::npos) ? str.size() : found;
+    }
+
+    // "00" to "99", so that two digits are one copy instead of two divisions
+    const char DigitPairs[] =
+        "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+        "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+    char* appendTwoDigits(char* out, long long value)
+    {
+        memcpy(out, DigitPairs + 2 * (value % 100), 2);
+        return out + 2;
+    }
+}
+
+bool parseLogDate(string_view dateString, DateTime& dateTime)
+{
+    size_t pos = 0;
+    if (! parseNumberField(dateString, pos, fieldEnd(dateString, pos, '/'), dateTime.month) ||
+        ! parseNumberField(dateString, pos, fieldEnd(dateString, pos, '/'), dateTime.day))
+    {
+        return false;
+    }
+    if (pos <= dateString.size() &&
+        ! parseNumberField(dateString, pos, dateString.size(), dateTime.year))
+    {
+        return false;
+    }
+
+    return dateTime.month >= 1 && dateTime.month <= 12 && dateTime.day >= 1 && dateTime.day <= 31;
+}
+
+bool parseLogTime(string_view timeString, DateTime& dateTime)
+{
+    size_t pos = 0;
+    if (! parseNumberField(timeString, pos, fieldEnd(timeString, pos, ':'), dateTime.hours) ||
+        ! parseNumberField(timeString, pos, fieldEnd(timeString, pos, ':'), dateTime.minutes))
+    {
+        return false;
+    }
+    dateTime.seconds = 0;
+    if (pos <= timeString.size() &&
+        ! parseNumberField(timeString, pos, timeString.size(), dateTime.seconds))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Civil date to day count, after Howard Hinnant's days_from_civil
+long long dateTimeToEpoch(const DateTime& dateTime)
+{
+    long long year = dateTime.year - (dateTime.month <= 2 ? 1 : 0);
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    long long yearOfEra = year - era * 400;
+    long long dayOfYear = (153 * (dateTime.month + (dateTime.month > 2 ? -3 : 9)) + 2) / 5 + dateTime.day - 1;
+    long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    long long days = era * 146097 + dayOfEra - 719468;
+
+    return days * 86400 + dateTime.hours * 3600 + dateTime.minutes * 60 + dateTime.seconds;
+}
+
+void epochToDateTime(long long epochSeconds, DateTime& dateTime)
+{
+    long long days = epochSeconds / 86400;
+    long long secondsOfDay = epochSeconds % 86400;
+    if (secondsOfDay < 0)
+    {
+        secondsOfDay += 86400;
+        --days;
+    }
+    dateTime.hours = static_cast<int>(secondsOfDay / 3600);
+    dateTime.minutes = static_cast<int>(secondsOfDay / 60 % 60);
+    dateTime.seconds = static_cast<int>(secondsOfDay % 60);
+
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    long long dayOfEra = days - era * 146097;
+    long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long long monthIndex = (5 * dayOfYear + 2) / 153;
+    dateTime.day = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    dateTime.month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    dateTime.year = static_cast<int>(yearOfEra + era * 400 + (dateTime.month <= 2 ? 1 : 0));
+}
+
+char* appendLogDate(char* out, long long epochSeconds)
+{
+    DateTime dateTime;
+    epochToDateTime(epochSeconds, dateTime);
+
+    out = appendTwoDigits(out, dateTime.month);
+    *out++ = '/';
+    out = appendTwoDigits(out, dateTime.day);
+    *out++ = '/';
+    out = appendTwoDigits(out, dateTime.year / 100);
+    return appendTwoDigits(out, dateTime.year % 100);
+}
+
+char* appendLogTime(char* out, long long epochSeconds)
+{
+    return appendTimeOfDay(out, ((epochSeconds % 86400) + 86400) % 86400);
+}
+
+char* appendTimeOfDay(char* out, long long secondsOfDay)
+{
+    long long hours = secondsOfDay / 3600;
+    long long secondsOfHour = secondsOfDay - hours * 3600;
+    long long minutes = secondsOfHour / 60;
+
+    out = appendTwoDigits(out, hours);
+    *out++ = ':';
+    out = appendTwoDigits(out, minutes);
+    *out++ = ':';
+    return appendTwoDigits(out, secondsOfHour - minutes * 60);
+}
+
+char* appendLogDateTime(char* out, long long epochSeconds)
+{
+    out = appendLogDate(out, epochSeconds);
+    *out++ = ' ';
+    return appendLogTime(out, epochSeconds);
+}
+
+char* appendDuration(char* out, long long durationSeconds)
+{
+    if (durationSeconds < 0)
+    {
+        *out++ = '-';
+        durationSeconds = -durationSeconds;
+    }
+
+    // Sessions rarely last 100 hours, which take more than two digits
+    long long durationHours = durationSeconds / 3600;
+    long long secondsOfHour = durationSeconds - durationHours * 3600;
+    long long minutes = secondsOfHour / 60;
+    if (durationHours < 100)
+    {
+        out = appendTwoDigits(out, durationHours);
+    }
+    else
+    {
+        out = to_chars(out, out + 20, durationHours).ptr;
+    }
+    *out++ = ':';
+    out = appendTwoDigits(out, minutes);
+    *out++ = ':';
+    return appendTwoDigits(out, secondsOfHour - minutes * 60);
+}
+
+char* appendIsoDate(char* out, long long epochSeconds)
+{
+    DateTime dateTime;
+    epochToDateTime(epochSeconds, dateTime);
+
+    out = appendTwoDigits(out, dateTime.year / 100);
+    out = appendTwoDigits(out, dateTime.year % 100);
+    *out++ = '-';
+    out = appendTwoDigits(out, dateTime.month);
+    *out++ = '-';
+    return appendTwoDigits(out, dateTime.day);
+}
+
+char* appendIsoDateTime(char* out, long long epochSeconds)
+{
+    out = appendIsoDate(out, epochSeconds);
+    *out++ = 'T';
+    return appendLogTime(out, epochSeconds);
+}
+
+void appendJsonString(string& text, string_view value)
+{
+    text += '"';
+    for (size_t character = 0; character < value.size(); ++character)
+    {
+        char c = value[character];
+        if (c == '"' || c == '\\')
+        {
+            text += '\\';
+            text += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+            text += escaped;
+        }
+        else
+        {
+            text += c;
+        }
+    }
+    text += '"';
+}
+
+string formatLogDate(long long epochSeconds)
+{
+    char buffer[MaxFormattedTimeLength];
+    return string(buffer, appendLogDate(buffer, epochSeconds));
+}
+
+string formatLogTime(long long epochSeconds)
+{
+    char buffer[MaxFormattedTimeLength];
+    return string(buffer, appendLogTime(buffer, epochSeconds));
+}
+
+string formatLogDateTime(long long epochSeconds)
+{
+    char buffer[MaxFormattedTimeLength];
+    return string(buffer, appendLogDateTime(buffer, epochSeconds));
+}
+
+string formatDuration(long long durationSeconds)
+{
+    char buffer[MaxFormattedTimeLength];
+    return string(buffer, appendDuration(buffer, durationSeconds));
+}
+
 void parseDataInto2DVector(const vector<string>& rowData,
                            vector< vector<string> >& parsedData)
 {
     string delimiter = " ";
     vector<string> eventLine;
-    string rawLine;
 
     for (size_t line=0; line<rowData.size(); ++line)
     {
         tokenizeString(delimiter, rowData.at(line), eventLine);
-        parsedData.push_back(eventLine);
+        parsedData.push_back(move(eventLine));
+    }
+}
+
+void parseDataInto2DVector(const vector<string_view>& rowData,
+                           vector< vector<string> >& parsedData)
+{
+    string delimiter = " ";
+    vector<string> eventLine;
+
+    for (size_t line=0; line<rowData.size(); ++line)
+    {
+        tokenizeString(delimiter, rowData.at(line), eventLine);
+        parsedData.push_back(move(eventLine));
     }
 }
 
@@ -270,8 +751,212 @@ void getFileListInDirectory(const string& directory, vector<string>& fileList)
     }
 }
 
+bool matchesWildcard(string_view name, string_view pattern)
+{
+    // Greedy matching with backtracking to the last '*'
+    size_t nameIndex = 0;
+    size_t patternIndex = 0;
+    size_t starIndex = string_view::npos;
+    size_t starMatch = 0;
+
+    while (nameIndex < name.size())
+    {
+        if (patternIndex < pattern.size() &&
+            (pattern[patternIndex] == '?' ||
+             tolower(static_cast<unsigned char>(pattern[patternIndex])) == tolower(static_cast<unsigned char>(name[nameIndex]))))
+        {
+            ++nameIndex;
+            ++patternIndex;
+        }
+        else if (patternIndex < pattern.size() && pattern[patternIndex] == '*')
+        {
+            starIndex = patternIndex++;
+            starMatch = nameIndex;
+        }
+        else if (starIndex != string_view::npos)
+        {
+            patternIndex = starIndex + 1;
+            nameIndex = ++starMatch;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (patternIndex < pattern.size() && pattern[patternIndex] == '*')
+    {
+        ++patternIndex;
+    }
+
+    return patternIndex == pattern.size();
+}
+
+bool getBatchInputFiles(const string& inputPath, vector<string>& fileList)
+{
+    string directory;
+    string pattern;
+
+    if (! inputPath.empty() && inputPath.at(0) == '@')
+    {
+        ifstream listFile(inputPath.substr(1).c_str());
+        string line;
+        while (getline(listFile, line))
+        {
+            if (! line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            if (! line.empty())
+            {
+                fileList.push_back(line);
+            }
+        }
+        return true;
+    }
+    else if (is_directory(inputPath))
+    {
+        directory = inputPath;
+        pattern = "*";
+    }
+    else if (inputPath.find_first_of("*?") != string::npos)
+    {
+        size_t found = inputPath.find_last_of("/\\");
+        directory = (found == string::npos) ? "." : inputPath.substr(0, found);
+        pattern = inputPath.substr(found == string::npos ? 0 : found + 1);
+    }
+    else
+    {
+        return false;
+    }
+
+    vector<string> directoryFiles;
+    getFileListInDirectory(directory, directoryFiles);
+    for (size_t file = 0; file < directoryFiles.size(); ++file)
+    {
+        string fileName = path(directoryFiles.at(file)).filename().string();
+        if (matchesWildcard(fileName, pattern) && fileName.find("LIC_Imaris_") == string::npos)
+        {
+            fileList.push_back(directoryFiles.at(file));
+        }
+    }
+    sort(fileList.begin(), fileList.end());
+
+    return true;
+}
+
+string absolutePath(const string& filePath)
+{
+    return absolute(filePath).string();
+}
+
+string quoteCommandArgument(const string& argument)
+{
+#ifdef _WIN32
+    // Backslashes are literal unless they come before a quote
+    string quoted = "\"";
+    size_t backslashes = 0;
+    for (char c : argument)
+    {
+        if (c == '\\')
+        {
+            ++backslashes;
+            continue;
+        }
+        quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+        quoted.push_back(c);
+        backslashes = 0;
+    }
+    quoted.append(backslashes * 2, '\\');
+    quoted.push_back('"');
+    return quoted;
+#else
+    string quoted = "'";
+    for (char c : argument)
+    {
+        if (c == '\'')
+        {
+            quoted += "'\\''";
+        }
+        else
+        {
+            quoted.push_back(c);
+        }
+    }
+    quoted.push_back('\'');
+    return quoted;
+#endif
+}
+
+int runCommand(const string& commandLine)
+{
+#ifdef _WIN32
+    // cmd /c drops the outer quotes of a line that starts with one
+    return system(("\"" + commandLine + "\"").c_str());
+#else
+    int status = system(commandLine.c_str());
+    if (status == -1 || ! WIFEXITED(status))
+    {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+#endif
+}
+
 bool fileExists(const string& filePath)
 {
     ifstream ifile(filePath.c_str());
     return (ifile.is_open());
 }
+
+long long getFileSize(const string& filePath)
+{
+    boost::system::error_code error;
+    boost::uintmax_t size = boost::filesystem::file_size(filePath, error);
+    if (error)
+    {
+        return -1;
+    }
+    return static_cast<long long>(size);
+}
+
+long long getFileModifiedTime(const string& filePath)
+{
+    boost::system::error_code error;
+    time_t modified = boost::filesystem::last_write_time(filePath, error);
+    if (error)
+    {
+        return -1;
+    }
+    return static_cast<long long>(modified);
+}
+
+size_t peakMemoryUsage()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (! GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Linux reports kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+bool truncateFile(const string& filePath, unsigned long long size)
+{
+    boost::system::error_code error;
+    boost::filesystem::resize_file(filePath, size, error);
+    return ! error;
+}
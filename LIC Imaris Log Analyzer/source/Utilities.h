@@ -22,10 +22,15 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "Compression.h"
 
 using namespace std;
 using namespace boost::posix_time;
@@ -33,19 +38,72 @@ using namespace boost::gregorian;
 
 void loadDataFromFile(const string& filePath, vector<string>& fileData);
 
+// Read-only memory mapping of an input log file.  Views handed out by
+// loadLineViewsFromFile point into the mapping, so the MappedFile must
+// outlive them.
+class MappedFile
+{
+public:
+    MappedFile() {}
+    // Whether the file fits into the address space, which a 32-bit build
+    // cannot spare more than a gigabyte of for one mapping
+    static bool fits(const string& filePath);
+    void open(const string& filePath);
+    void close();
+    const char* data() const;
+    size_t size() const;
+    // Hints that the bytes [offset, offset + length) are read next, front
+    // to back, so the system reads them in ahead in large blocks instead of
+    // faulting them in page by page (madvise, PrefetchVirtualMemory).
+    // Ignored where the system does not support it.
+    void adviseRead(size_t offset, size_t length) const;
+private:
+    boost::interprocess::file_mapping m_mapping;
+    boost::interprocess::mapped_region m_region;
+};
+
+// Whether adviseRead and adviseHugePages pass their hints on, on unless
+// turned off, e.g. to measure what they gain
+void setMemoryHints(bool enabled);
+
+// Asks for transparent huge pages for the whole 2 MB pages of a large
+// buffer not yet filled, so that it takes fewer TLB entries and page
+// faults.  Only Linux has them for ordinary allocations; elsewhere, or
+// when the system has them turned off, the hint is ignored.
+void adviseHugePages(const void* data, size_t bytes);
+
+bool nextLineView(const MappedFile& file, size_t& offset, string_view& lineView);
+bool nextLineView(string_view text, size_t& offset, string_view& lineView);
+
+void loadLineViewsFromFile(const MappedFile& file, vector<string_view>& lineViews);
+
+// Stops after maxTokens tokens, leaving the rest of the string unsplit
+void tokenizeStringView(string_view delimiter,
+                        string_view rawEventData,
+                        vector<string_view>& tokens,
+                        size_t maxTokens = SIZE_MAX);
+
 void tokenizeString(const string& delimiter,
-                    const string& rawEventData,
+                    string_view rawEventData,
                     vector<string>& tokens);
 
+// The first token tokenizeStringView(" ", line, ...) gives, without
+// splitting the rest of the line.  Empty for a blank line.
+string_view firstToken(string_view line);
+
+int stringViewToInt(string_view str);
+
 void untokenizeString(const string& delimiter,
                     string& rawEventData,
                     const vector<string>& tokens);
 
-void getUniqueItems(string& item, vector<string>& uniqueItems);
+// Adds item to uniqueItems unless it is already listed; only a new item is copied
+void getUniqueItems(string_view item, vector<string>& uniqueItems);
 
 void write2DVectorToFile(const string filePath,
                          const vector < vector<string> >& data,
-                         const string delimiter);
+                         const string delimiter,
+                         compressionFormat compression = Uncompressed);
 
 void findReplaceAll(const string oldPattern,
                     const string newPattern,
@@ -61,6 +119,56 @@ ptime stringToBoostTime(string& dateString,
 
 string boostTimeToString(ptime& dateTime);
 
+// Calendar fields of a report log timestamp
+struct DateTime
+{
+    int year;
+    int month;
+    int day;
+    int hours;
+    int minutes;
+    int seconds;
+};
+
+// Fixed-format parsers for the report log date ("MM/DD" or "MM/DD/YYYY"; the
+// year is left unchanged when absent) and time ("HH:MM:SS" or "HH:MM").
+// They return false if the field does not have that form.
+bool parseLogDate(string_view dateString, DateTime& dateTime);
+bool parseLogTime(string_view timeString, DateTime& dateTime);
+
+// Seconds since 1970-01-01 00:00:00 and back
+long long dateTimeToEpoch(const DateTime& dateTime);
+void epochToDateTime(long long epochSeconds, DateTime& dateTime);
+
+// "MM/DD/YYYY" and "HH:MM:SS", as they appear in the reports
+string formatLogDate(long long epochSeconds);
+string formatLogTime(long long epochSeconds);
+string formatLogDateTime(long long epochSeconds);
+
+// "HH:MM:SS" with at least two hour digits, like boost's to_simple_string
+string formatDuration(long long durationSeconds);
+
+// The same formats written to out without allocating.  They return the end
+// of the text, which is at most MaxFormattedTimeLength bytes.
+const size_t MaxFormattedTimeLength = 32;
+char* appendLogDate(char* out, long long epochSeconds);
+char* appendLogTime(char* out, long long epochSeconds);
+char* appendLogDateTime(char* out, long long epochSeconds);
+char* appendDuration(char* out, long long durationSeconds);
+
+// "HH:MM:SS" of a second of the day, 0 to 86399, e.g. after the date of a
+// day formatted once for all of its timestamps (see BufferedWriter)
+char* appendTimeOfDay(char* out, long long secondsOfDay);
+
+// "YYYY-MM-DDTHH:MM:SS", the ISO 8601 form of the exports, and its date
+// part, at most MaxFormattedTimeLength bytes like the formats above
+char* appendIsoDateTime(char* out, long long epochSeconds);
+char* appendIsoDate(char* out, long long epochSeconds);
+
+// Appends value as a quoted JSON string, escaping the quotes, backslashes
+// and control characters
+void appendJsonString(string& text, string_view value);
+
 template <typename T>
 string toString(T& value)
 {
@@ -74,6 +182,45 @@ string toString(T& value)
 void parseDataInto2DVector(const vector<string>& rawData,
                            vector< vector<string> >& allData);
 
+void parseDataInto2DVector(const vector<string_view>& rawData,
+                           vector< vector<string> >& allData);
+
 void getFileListInDirectory(const string& directory, vector<string>& fileList);
 
+// Matches name against a pattern with the wildcards '*' and '?'
+// (case-insensitive, like Windows file name patterns)
+bool matchesWildcard(string_view name, string_view pattern);
+
+// Expands a batch input - a directory or a file name pattern such as
+// "C:/logs/*.log" - into the sorted list of files it names.  Report files
+// written by the analyzer itself are skipped.  A list file, "@logs.txt",
+// names the logs one per line and keeps their order.  Returns false if
+// inputPath is a single file.
+bool getBatchInputFiles(const string& inputPath, vector<string>& fileList);
+
+// The path made absolute against the working folder
+string absolutePath(const string& filePath);
+
+// The argument quoted for the command shell of the system, so that it
+// reaches the program as it is
+string quoteCommandArgument(const string& argument);
+
+// Runs the command line through the command shell and waits for it.
+// Returns its exit code, or -1 if it did not run or exit.
+int runCommand(const string& commandLine);
+
 bool fileExists(const string& filePath);
+
+// Length of the file in bytes, or -1 if it does not exist
+long long getFileSize(const string& filePath);
+
+// Time of the file's last change in seconds since the epoch, or -1 if it
+// does not exist
+long long getFileModifiedTime(const string& filePath);
+
+// Peak resident memory of the process in bytes (the peak working set on
+// Windows), or 0 if the system does not tell
+size_t peakMemoryUsage();
+
+// Cuts the file back to size bytes; returns false if that failed
+bool truncateFile(const string& filePath, unsigned long long size);
@@ -0,0 +1,209 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "VersionUsage.h"
+#include "HeapBytes.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+namespace
+{
+    // Values saved for every pair: product, version, check-outs in use,
+    // peak and its time, closed sessions and their seconds
+    const size_t PairValues = 7;
+}
+
+void VersionUsage::clear()
+{
+    m_index.clear();
+    m_totals.clear();
+}
+
+size_t VersionUsage::memoryBytes() const
+{
+    return m_index.memoryBytes() + heapBytes(m_totals);
+}
+
+void VersionUsage::checkOut(size_t product, size_t version, long long time)
+{
+    VersionTotals& totals = totalsOf(product, version);
+    ++totals.inUse;
+    if (totals.inUse > totals.peak)
+    {
+        totals.peak = totals.inUse;
+        totals.peakTime = time;
+    }
+}
+
+void VersionUsage::checkIn(size_t product, size_t version)
+{
+    VersionTotals& totals = totalsOf(product, version);
+    if (totals.inUse > 0)
+    {
+        --totals.inUse;
+    }
+}
+
+void VersionUsage::shutDown(size_t firstProduct, size_t endProduct)
+{
+    for (VersionTotals& totals : m_totals)
+    {
+        if (totals.product >= firstProduct && totals.product < endProduct)
+        {
+            totals.inUse = 0;
+        }
+    }
+}
+
+// The shard counted its products from the same start as this, so their
+// concurrency is taken over as it is
+void VersionUsage::takeProducts(const VersionUsage& shard, size_t firstProduct, size_t endProduct)
+{
+    for (const VersionTotals& counted : shard.m_totals)
+    {
+        if (counted.product >= firstProduct && counted.product < endProduct)
+        {
+            VersionTotals& totals = totalsOf(counted.product, counted.version);
+            totals.inUse = counted.inUse;
+            totals.peak = counted.peak;
+            totals.peakTime = counted.peakTime;
+        }
+    }
+}
+
+void VersionUsage::clearSessions()
+{
+    for (VersionTotals& totals : m_totals)
+    {
+        totals.sessions = 0;
+        totals.seconds = 0;
+        totals.closedSessions = 0;
+        totals.closedSeconds = 0;
+    }
+}
+
+void VersionUsage::addSession(size_t product, size_t version, long long seconds, bool closed)
+{
+    VersionTotals& totals = totalsOf(product, version);
+    ++totals.sessions;
+    totals.seconds += seconds;
+    if (closed)
+    {
+        ++totals.closedSessions;
+        totals.closedSeconds += seconds;
+    }
+}
+
+void VersionUsage::totals(vector<VersionTotals>& totals) const
+{
+    totals = m_totals;
+    sort(totals.begin(), totals.end(), [](const VersionTotals& first, const VersionTotals& second)
+         {
+             return first.product != second.product ? first.product < second.product : first.version < second.version;
+         });
+}
+
+void VersionUsage::save(Checkpoint& checkpoint) const
+{
+    checkpoint.versionUsage.clear();
+    checkpoint.versionUsage.reserve(m_totals.size() * PairValues);
+    for (const VersionTotals& totals : m_totals)
+    {
+        checkpoint.versionUsage.push_back(static_cast<int64_t>(totals.product));
+        checkpoint.versionUsage.push_back(static_cast<int64_t>(totals.version));
+        checkpoint.versionUsage.push_back(totals.inUse);
+        checkpoint.versionUsage.push_back(totals.peak);
+        checkpoint.versionUsage.push_back(totals.peakTime);
+        checkpoint.versionUsage.push_back(static_cast<int64_t>(totals.closedSessions));
+        checkpoint.versionUsage.push_back(totals.closedSeconds);
+    }
+}
+
+bool VersionUsage::restoreConcurrency(const Checkpoint& checkpoint)
+{
+    if (! validEntries(checkpoint))
+    {
+        return false;
+    }
+    const vector<int64_t>& values = checkpoint.versionUsage;
+    for (size_t value = 0; value < values.size(); value += PairValues)
+    {
+        VersionTotals& totals = totalsOf(static_cast<size_t>(values[value]), static_cast<size_t>(values[value + 1]));
+        totals.inUse = static_cast<int32_t>(values[value + 2]);
+        totals.peak = static_cast<int32_t>(values[value + 3]);
+        totals.peakTime = values[value + 4];
+    }
+    return true;
+}
+
+bool VersionUsage::restoreSessions(const Checkpoint& checkpoint)
+{
+    if (! validEntries(checkpoint))
+    {
+        return false;
+    }
+    const vector<int64_t>& values = checkpoint.versionUsage;
+    for (size_t value = 0; value < values.size(); value += PairValues)
+    {
+        VersionTotals& totals = totalsOf(static_cast<size_t>(values[value]), static_cast<size_t>(values[value + 1]));
+        totals.sessions = totals.closedSessions = static_cast<uint64_t>(values[value + 5]);
+        totals.seconds = totals.closedSeconds = values[value + 6];
+    }
+    return true;
+}
+
+VersionTotals& VersionUsage::totalsOf(size_t product, size_t version)
+{
+    // The map holds every index plus one, so a new pair reads as 0
+    size_t& index = m_index[make_pair(product, version)];
+    if (index == 0)
+    {
+        VersionTotals totals = { product, version, 0, 0, LLONG_MIN, 0, 0, 0, 0 };
+        m_totals.push_back(totals);
+        index = m_totals.size();
+    }
+    return m_totals[index - 1];
+}
+
+bool VersionUsage::validEntries(const Checkpoint& checkpoint)
+{
+    const vector<int64_t>& values = checkpoint.versionUsage;
+    if (values.size() % PairValues != 0)
+    {
+        return false;
+    }
+    for (size_t value = 0; value < values.size(); value += PairValues)
+    {
+        if (values[value] < 0 || static_cast<uint64_t>(values[value]) >= checkpoint.products.size() ||
+            values[value + 1] < 0 || static_cast<uint64_t>(values[value + 1]) >= checkpoint.versions.size() ||
+            values[value + 2] < 0 || values[value + 2] > values[value + 3] || values[value + 3] > INT32_MAX ||
+            values[value + 5] < 0 || values[value + 6] < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
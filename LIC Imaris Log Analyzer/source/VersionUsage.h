@@ -0,0 +1,98 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Checkpoint.h"
+#include "FlatHashMap.h"
+
+using namespace std;
+
+// The usage of one version of a product: the check-outs of it in use, the
+// most of them in use at once and when that was first reached (LLONG_MIN
+// if never), and its sessions and their seconds.  The closed sessions are
+// also counted apart, as only they go into a checkpoint.
+struct VersionTotals
+{
+    size_t product;
+    size_t version;
+    int32_t inUse;
+    int32_t peak;
+    long long peakTime;
+    uint64_t sessions;
+    long long seconds;
+    uint64_t closedSessions;
+    long long closedSeconds;
+};
+
+// Concurrency and durations by product and version, for the version usage
+// report: which releases of a product are still in use, and how much.  The
+// (product, version) pairs seen are numbered in a flat hash map, so only the
+// pairs of the log take room.  The concurrent usage pass checks every
+// version out and in, counting check-outs rather than the licenses the
+// server reports in use, which it only does by product; the session pass
+// adds the sessions.  A parallel usage pass counts every shard's products
+// apart, then takes them over like the other usage tables.
+class VersionUsage
+{
+    public:
+        VersionUsage() {}
+
+        void clear();
+        // The map and the totals, an estimate for the memory accounting
+        size_t memoryBytes() const;
+
+        // The usage pass: a check-out or check-in at time, and a shutdown,
+        // which ends the check-outs of the products [firstProduct,
+        // endProduct).  A check-in with none in use is not counted, as the
+        // log may have started after the check-out.
+        void checkOut(size_t product, size_t version, long long time);
+        void checkIn(size_t product, size_t version);
+        void shutDown(size_t firstProduct, size_t endProduct);
+        void takeProducts(const VersionUsage& shard, size_t firstProduct, size_t endProduct);
+
+        // The session pass, which starts over from the closed sessions of
+        // the checkpoint every run
+        void clearSessions();
+        void addSession(size_t product, size_t version, long long seconds, bool closed);
+
+        // The totals of every pair seen, by product and then version id
+        void totals(vector<VersionTotals>& totals) const;
+
+        // The concurrency and the closed sessions of every pair, for a
+        // checkpoint; the restores are false if the checkpoint does not fit
+        // the names, and each takes its part alone
+        void save(Checkpoint& checkpoint) const;
+        bool restoreConcurrency(const Checkpoint& checkpoint);
+        bool restoreSessions(const Checkpoint& checkpoint);
+
+    private:
+        VersionTotals& totalsOf(size_t product, size_t version);
+        static bool validEntries(const Checkpoint& checkpoint);
+
+        FlatHashMap<pair<size_t, size_t>, size_t> m_index;
+        vector<VersionTotals> m_totals;
+};
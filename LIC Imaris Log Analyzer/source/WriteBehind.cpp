@@ -0,0 +1,376 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "WriteBehind.h"
+#include "BlockReader.h"
+#include "Exceptions.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <boost/filesystem.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    atomic<int> s_writeBehindMode(AutoWriteBehind);
+
+    // The allocation of a file grows to the next multiple of this
+    const uint64_t AllocationStep = 32 << 20;
+}
+
+void setWriteBehindMode(writeBehindMode mode)
+{
+    s_writeBehindMode = mode;
+}
+
+writeBehindMode currentWriteBehindMode()
+{
+    return static_cast<writeBehindMode>(s_writeBehindMode.load());
+}
+
+bool useWriteBehind(const string& filePath)
+{
+    switch (currentWriteBehindMode())
+    {
+        case AlwaysWriteBehind:
+            return true;
+        case NeverWriteBehind:
+            return false;
+        default:
+        {
+            // The file itself is usually not there yet
+            boost::filesystem::path folder = boost::filesystem::absolute(filePath).parent_path();
+            return isOnNetworkShare(folder.string());
+        }
+    }
+}
+
+#ifdef _WIN32
+struct WriteBehindOutput::Writes
+{
+    struct Write
+    {
+        Write() : size(0), pending(false)
+        {
+            memset(&overlapped, 0, sizeof(overlapped));
+            overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        }
+        ~Write()
+        {
+            CloseHandle(overlapped.hEvent);
+        }
+
+        vector<char> buffer;
+        OVERLAPPED overlapped;
+        DWORD size;
+        bool pending;
+    };
+
+    Writes() : file(INVALID_HANDLE_VALUE), nextWrite(0), failed(false) {}
+
+    // Waits for the write to finish, which leaves its buffer free
+    void complete(Write& write)
+    {
+        if (write.pending)
+        {
+            DWORD written = 0;
+            if (! GetOverlappedResult(file, &write.overlapped, &written, TRUE) || written != write.size)
+            {
+                failed = true;
+            }
+            write.pending = false;
+        }
+    }
+
+    HANDLE file;
+    Write writes[WritesInFlight];
+    size_t nextWrite;
+    bool failed;
+};
+#else
+struct WriteBehindOutput::Writes
+{
+    struct Write
+    {
+        vector<char> buffer;
+        size_t size;
+        uint64_t offset;
+    };
+
+    Writes() : file(-1), writing(0), finishing(false), failed(false), allocated(false) {}
+
+    // The body of each thread: takes the oldest buffer queued and writes it
+    // at its offset
+    void writeBlocks()
+    {
+        while (true)
+        {
+            Write write;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                changed.wait(lock, [this]() { return ! queued.empty() || finishing; });
+                if (queued.empty())
+                {
+                    return;
+                }
+                write = move(queued.front());
+                queued.pop_front();
+                ++writing;
+            }
+
+            bool written = true;
+            {
+                LIC_TRACE_SCOPE("write report behind");
+                size_t length = 0;
+                while (length < write.size)
+                {
+                    ssize_t count = pwrite(file, write.buffer.data() + length, write.size - length,
+                                           static_cast<off_t>(write.offset + length));
+                    if (count < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if (count <= 0)
+                    {
+                        written = false;
+                        break;
+                    }
+                    length += static_cast<size_t>(count);
+                }
+            }
+
+            {
+                lock_guard<mutex> lock(queueMutex);
+                failed = failed || ! written;
+                --writing;
+                spareBuffers.push_back(move(write.buffer));
+            }
+            changed.notify_all();
+        }
+    }
+
+    int file;
+    mutex queueMutex;
+    condition_variable changed;
+    deque<Write> queued;
+    size_t writing;
+    vector< vector<char> > spareBuffers;
+    bool finishing;
+    bool failed;
+    // Whether any of the allocation ahead succeeded
+    bool allocated;
+    vector<thread> threads;
+};
+#endif
+
+WriteBehindOutput::WriteBehindOutput(const string& filePath, bool append)
+    : m_filePath(filePath),
+      m_writes(new Writes()),
+      m_offset(0),
+      m_allocated(0),
+      m_finished(false)
+{
+#ifdef _WIN32
+    m_writes->file = CreateFileA(filePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                                 append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
+    if (m_writes->file == INVALID_HANDLE_VALUE)
+    {
+        CannotOpenFileException cannotOpenFileException(filePath);
+        throw cannotOpenFileException;
+    }
+    LARGE_INTEGER size;
+    if (append && GetFileSizeEx(m_writes->file, &size))
+    {
+        m_offset = static_cast<uint64_t>(size.QuadPart);
+    }
+#else
+    m_writes->file = ::open(filePath.c_str(), O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC), 0666);
+    if (m_writes->file < 0)
+    {
+        CannotOpenFileException cannotOpenFileException(filePath);
+        throw cannotOpenFileException;
+    }
+    if (append)
+    {
+        off_t end = lseek(m_writes->file, 0, SEEK_END);
+        m_offset = (end > 0) ? static_cast<uint64_t>(end) : 0;
+    }
+    for (size_t thread = 0; thread < WritesInFlight; ++thread)
+    {
+        m_writes->threads.push_back(std::thread(&Writes::writeBlocks, m_writes.get()));
+    }
+#endif
+    m_allocated = m_offset;
+}
+
+WriteBehindOutput::~WriteBehindOutput()
+{
+    finish();
+}
+
+void WriteBehindOutput::write(vector<char>& buffer, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    // The text goes into the buffer of the oldest write, with the line
+    // endings of a text mode file, so the buffer given stays the caller's
+    Writes::Write& next = m_writes->writes[m_writes->nextWrite];
+    m_writes->complete(next);
+    next.buffer.resize(size + static_cast<size_t>(count(buffer.begin(), buffer.begin() + size, '\n')));
+    char* out = next.buffer.data();
+    for (size_t byte = 0; byte < size; ++byte)
+    {
+        if (buffer[byte] == '\n')
+        {
+            *out++ = '\r';
+        }
+        *out++ = buffer[byte];
+    }
+    next.size = static_cast<DWORD>(next.buffer.size());
+    allocate(m_offset + next.size);
+
+    HANDLE event = next.overlapped.hEvent;
+    memset(&next.overlapped, 0, sizeof(next.overlapped));
+    next.overlapped.hEvent = event;
+    next.overlapped.Offset = static_cast<DWORD>(m_offset);
+    next.overlapped.OffsetHigh = static_cast<DWORD>(m_offset >> 32);
+    if (WriteFile(m_writes->file, next.buffer.data(), next.size, NULL, &next.overlapped) ||
+        GetLastError() == ERROR_IO_PENDING)
+    {
+        next.pending = true;
+    }
+    else
+    {
+        m_writes->failed = true;
+    }
+    m_offset += next.size;
+    m_writes->nextWrite = (m_writes->nextWrite + 1) % WritesInFlight;
+#else
+    allocate(m_offset + size);
+
+    size_t bufferSize = buffer.size();
+    unique_lock<mutex> lock(m_writes->queueMutex);
+    m_writes->changed.wait(lock, [this]() { return m_writes->queued.size() + m_writes->writing < WritesInFlight; });
+    Writes::Write queued;
+    queued.size = size;
+    queued.offset = m_offset;
+    queued.buffer.swap(buffer);
+    m_writes->queued.push_back(move(queued));
+    if (! m_writes->spareBuffers.empty())
+    {
+        buffer = move(m_writes->spareBuffers.back());
+        m_writes->spareBuffers.pop_back();
+    }
+    lock.unlock();
+    m_writes->changed.notify_all();
+
+    buffer.resize(bufferSize);
+    m_offset += size;
+#endif
+}
+
+uint64_t WriteBehindOutput::position() const
+{
+    return m_offset;
+}
+
+bool WriteBehindOutput::finish()
+{
+    if (m_finished)
+    {
+        return ! m_writes->failed;
+    }
+    m_finished = true;
+
+#ifdef _WIN32
+    for (size_t write = 0; write < WritesInFlight; ++write)
+    {
+        m_writes->complete(m_writes->writes[write]);
+    }
+    // Closing the file frees the allocation past its end
+    if (! CloseHandle(m_writes->file))
+    {
+        m_writes->failed = true;
+    }
+#else
+    {
+        lock_guard<mutex> lock(m_writes->queueMutex);
+        m_writes->finishing = true;
+    }
+    m_writes->changed.notify_all();
+    for (size_t thread = 0; thread < m_writes->threads.size(); ++thread)
+    {
+        m_writes->threads.at(thread).join();
+    }
+    // Here it takes cutting the file to its length
+    if (m_writes->allocated && ftruncate(m_writes->file, static_cast<off_t>(m_offset)) != 0)
+    {
+        m_writes->failed = true;
+    }
+    if (::close(m_writes->file) != 0)
+    {
+        m_writes->failed = true;
+    }
+#endif
+    return ! m_writes->failed;
+}
+
+// A failed allocation only leaves the file system to extend the file write
+// by write, as it would without one
+void WriteBehindOutput::allocate(uint64_t end)
+{
+    if (end <= m_allocated)
+    {
+        return;
+    }
+    m_allocated = (end + AllocationStep - 1) / AllocationStep * AllocationStep;
+
+#ifdef _WIN32
+    FILE_ALLOCATION_INFO allocation;
+    allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(m_allocated);
+    SetFileInformationByHandle(m_writes->file, FileAllocationInfo, &allocation, sizeof(allocation));
+#elif defined(FALLOC_FL_KEEP_SIZE)
+    if (fallocate(m_writes->file, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_offset),
+                  static_cast<off_t>(m_allocated - m_offset)) == 0)
+    {
+        m_writes->allocated = true;
+    }
+#endif
+}
@@ -0,0 +1,96 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// How a report file is written.  On a network share every write waits for
+// a round trip, so there the buffers a BufferedWriter flushes are written
+// behind: several large writes are in flight at once while the next
+// buffers are formatted (see WriteBehindOutput).
+enum writeBehindMode
+{
+    AutoWriteBehind,   // Write behind to folders on a network share
+    AlwaysWriteBehind,
+    NeverWriteBehind
+};
+
+void setWriteBehindMode(writeBehindMode mode);
+
+writeBehindMode currentWriteBehindMode();
+
+// Whether the current mode writes the file behind, which for auto depends
+// on whether its folder is on a network share (see isOnNetworkShare)
+bool useWriteBehind(const string& filePath);
+
+// Writes a report file with up to WritesInFlight writes at once, each at its
+// own offset: overlapped WriteFile on Windows, where the text is given the
+// platform's line endings as a text mode file would be, and as many
+// threads of positioned writes elsewhere.  The file's allocation is grown
+// in large steps ahead of the writes, so that the file system does not
+// extend it write by write; what is left over is freed when the file is
+// closed.
+class WriteBehindOutput
+{
+public:
+    static const size_t WritesInFlight = 4;
+
+    // Creates the file, or opens it to append to it.  Throws
+    // CannotOpenFileException.
+    WriteBehindOutput(const string& filePath, bool append);
+    ~WriteBehindOutput();
+
+    // Takes over the first size bytes of buffer and hands back a spare
+    // buffer of the same size, waiting for a write to finish if all of them
+    // are in flight
+    void write(vector<char>& buffer, size_t size);
+
+    // The length of the file once the writes so far are done
+    uint64_t position() const;
+
+    // Waits for the writes in flight and closes the file.  Returns false if
+    // any write or the close failed.
+    bool finish();
+
+private:
+    WriteBehindOutput(const WriteBehindOutput&);
+    WriteBehindOutput& operator=(const WriteBehindOutput&);
+
+    // The file and the writes in flight, which differ by platform
+    struct Writes;
+
+    // Extends the allocation of the file to hold at least end bytes
+    void allocate(uint64_t end);
+
+    string m_filePath;
+    unique_ptr<Writes> m_writes;
+    uint64_t m_offset;
+    uint64_t m_allocated;
+    bool m_finished;
+};
@@ -0,0 +1,225 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// Build tool of the portable (non-Windows) command line front end. Turns the
+// string table of "LIC Imaris Log Analyzer.rc" and the IDS_ identifiers of
+// resource.h, both UTF-16LE as Visual Studio keeps them, into C++ sources, so
+// the resource strings stay defined in one place for both builds:
+//
+//   GenerateResourceStrings resource.h "LIC Imaris Log Analyzer.rc" out_dir
+//
+// writes out_dir/ResourceStrings.h (the identifiers) and
+// out_dir/ResourceStrings.inc (the { id, L"text" } rows of the string table).
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Reads a UTF-16LE text file into lines of code units, without the byte
+    // order mark and the line ends.
+    bool readUtf16Lines(const string& filePath, vector<u16string>& lines)
+    {
+        ifstream file(filePath, ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        string bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        u16string line;
+        for (size_t pos = 0; pos + 1 < bytes.size(); pos += 2)
+        {
+            char16_t unit = static_cast<char16_t>(static_cast<unsigned char>(bytes[pos]) |
+                                                  (static_cast<unsigned char>(bytes[pos + 1]) << 8));
+            if (unit == 0xFEFF && pos == 0)
+            {
+                continue;
+            }
+            if (unit == u'\n')
+            {
+                if (!line.empty() && line.back() == u'\r')
+                {
+                    line.pop_back();
+                }
+                lines.push_back(line);
+                line.clear();
+            }
+            else
+            {
+                line += unit;
+            }
+        }
+        if (!line.empty())
+        {
+            lines.push_back(line);
+        }
+        return true;
+    }
+
+    // ASCII lines only carry ASCII identifiers and numbers
+    string narrow(const u16string& text)
+    {
+        string result;
+        for (char16_t unit : text)
+        {
+            result += unit < 0x80 ? static_cast<char>(unit) : '?';
+        }
+        return result;
+    }
+
+    bool startsWith(const string& text, const string& prefix)
+    {
+        return text.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    // Turns the body of a resource compiler string ("" for a quote, C escapes
+    // otherwise) into the body of a C++ wide string literal. Anything beyond
+    // ASCII is written as a universal character name.
+    string toWideLiteral(const u16string& text)
+    {
+        string literal;
+        for (size_t pos = 0; pos < text.size(); ++pos)
+        {
+            char16_t unit = text[pos];
+            if (unit == u'"')
+            {
+                literal += "\\\"";
+                if (pos + 1 < text.size() && text[pos + 1] == u'"')
+                {
+                    ++pos;
+                }
+            }
+            else if (unit == u'\\' && pos + 1 < text.size())
+            {
+                literal += '\\';
+                literal += static_cast<char>(text[++pos]);
+            }
+            else if (unit < 0x80)
+            {
+                literal += static_cast<char>(unit);
+            }
+            else
+            {
+                char32_t codePoint = unit;
+                if (unit >= 0xD800 && unit < 0xDC00 && pos + 1 < text.size())
+                {
+                    codePoint = 0x10000 + ((unit - 0xD800) << 10) + (text[++pos] - 0xDC00);
+                }
+                char escape[16];
+                snprintf(escape, sizeof(escape), codePoint > 0xFFFF ? "\\U%08X" : "\\u%04X",
+                         static_cast<unsigned int>(codePoint));
+                literal += escape;
+            }
+        }
+        return literal;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: GenerateResourceStrings resource.h resource.rc output_Folder\n");
+        return 1;
+    }
+
+    vector<u16string> headerLines;
+    vector<u16string> scriptLines;
+    if (!readUtf16Lines(argv[1], headerLines))
+    {
+        fprintf(stderr, "Unable to open file: %s\n", argv[1]);
+        return 1;
+    }
+    if (!readUtf16Lines(argv[2], scriptLines))
+    {
+        fprintf(stderr, "Unable to open file: %s\n", argv[2]);
+        return 1;
+    }
+
+    ostringstream identifiers;
+    identifiers << "// Generated from resource.h by GenerateResourceStrings, do not edit.\n\n"
+                << "#pragma once\n\n";
+    for (const u16string& line : headerLines)
+    {
+        string text = narrow(line);
+        if (startsWith(text, "#define IDS_"))
+        {
+            identifiers << text << "\n";
+        }
+    }
+
+    ostringstream table;
+    table << "// Generated from LIC Imaris Log Analyzer.rc by GenerateResourceStrings, do not edit.\n\n";
+    bool inStringTable = false;
+    size_t strings = 0;
+    for (const u16string& line : scriptLines)
+    {
+        string text = narrow(line);
+        size_t start = text.find_first_not_of(" \t");
+        string token = start == string::npos ? string() : text.substr(start, text.find_first_of(" \t", start) - start);
+        if (token == "STRINGTABLE")
+        {
+            inStringTable = true;
+        }
+        else if (inStringTable && token == "END")
+        {
+            inStringTable = false;
+        }
+        else if (inStringTable && startsWith(token, "IDS_"))
+        {
+            size_t open = line.find(u'"');
+            size_t close = line.rfind(u'"');
+            if (open == u16string::npos || close == open)
+            {
+                fprintf(stderr, "%s: no string for %s on one line\n", argv[2], token.c_str());
+                return 1;
+            }
+            table << "    { " << token << ", L\""
+                  << toWideLiteral(line.substr(open + 1, close - open - 1)) << "\" },\n";
+            ++strings;
+        }
+    }
+    if (strings == 0)
+    {
+        fprintf(stderr, "%s: no STRINGTABLE found\n", argv[2]);
+        return 1;
+    }
+
+    string outputDirectory = argv[3];
+    ofstream identifierFile(outputDirectory + "/ResourceStrings.h", ios::binary);
+    ofstream tableFile(outputDirectory + "/ResourceStrings.inc", ios::binary);
+    identifierFile << identifiers.str();
+    tableFile << table.str();
+    if (!identifierFile || !tableFile)
+    {
+        fprintf(stderr, "Unable to write to %s\n", argv[3]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "PortableConsole.h"
+
+#include <clocale>
+#include <climits>
+#include <cstdarg>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct ResourceString
+    {
+        unsigned int   id;
+        const wchar_t* text;
+    };
+
+    const ResourceString s_resourceStrings[] =
+    {
+#include "ResourceStrings.inc"
+    };
+}
+
+int LoadString(HMODULE, unsigned int id, WCHAR* buffer, int bufferLength)
+{
+    if (bufferLength <= 0)
+    {
+        return 0;
+    }
+    buffer[0] = L'\0';
+    for (const ResourceString& resourceString : s_resourceStrings)
+    {
+        if (resourceString.id == id)
+        {
+            wcsncpy(buffer, resourceString.text, bufferLength - 1);
+            buffer[bufferLength - 1] = L'\0';
+            return static_cast<int>(wcslen(buffer));
+        }
+    }
+    return 0;
+}
+
+int wprintf_s(const wchar_t* format, ...)
+{
+    std::vector<wchar_t> text(1024);
+    int length;
+    for (;;)
+    {
+        va_list args;
+        va_start(args, format);
+        length = vswprintf(text.data(), text.size(), format, args);
+        va_end(args);
+        // vswprintf only tells that the text did not fit, not how long it is
+        if (length >= 0 || text.size() >= (1u << 24))
+        {
+            break;
+        }
+        text.resize(text.size() * 4);
+    }
+    if (length < 0)
+    {
+        return -1;
+    }
+
+    std::string bytes;
+    std::mbstate_t state = std::mbstate_t();
+    char character[MB_LEN_MAX];
+    for (int pos = 0; pos < length; ++pos)
+    {
+        size_t characterLength = wcrtomb(character, text[pos], &state);
+        if (characterLength == static_cast<size_t>(-1))
+        {
+            bytes += '?';
+            state = std::mbstate_t();
+        }
+        else
+        {
+            bytes.append(character, characterLength);
+        }
+    }
+    fwrite(bytes.data(), 1, bytes.size(), stdout);
+    return length;
+}
+
+int main(int argc, char* argv[])
+{
+    // the resource strings are written in the encoding of the user's locale
+    setlocale(LC_CTYPE, "");
+
+    std::vector<std::wstring> arguments;
+    std::vector<_TCHAR*> wideArgv;
+    for (int arg = 0; arg < argc; ++arg)
+    {
+        // one wide character per byte, ConvertToString() narrows them back
+        std::wstring argument;
+        for (const char* byte = argv[arg]; *byte; ++byte)
+        {
+            argument += static_cast<wchar_t>(static_cast<unsigned char>(*byte));
+        }
+        arguments.push_back(argument);
+    }
+    for (std::wstring& argument : arguments)
+    {
+        wideArgv.push_back(&argument[0]);
+    }
+    wideArgv.push_back(nullptr);
+    return lic_main(argc, wideArgv.data());
+}
@@ -0,0 +1,68 @@
+// Copyright 2014 Steve Robinson (author of the original code)
+//
+// and
+//
+// Copyright 2022 Tobias Wernet (ALbert Ludwigs University Freiburg)
+//
+// This file is part of the LIC Imaris Log Analyzer
+// based on the original RLM Log Reader by Steve Robinson
+//
+// LIC Imaris Log Analyzer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RLM Log Reader was distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RLM Log Reader.  If not, see <http://www.gnu.org/licenses/>.
+
+// The part of the Windows API and the Microsoft C runtime the command line
+// front end uses, for the portable (non-Windows) build. The resource strings
+// come from the string table generated out of the .rc file, and main() hands
+// the arguments to _tmain() as wide strings, one byte per character, so the
+// paths leave ConvertToString() as the bytes they were given in.
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+
+#include "ResourceStrings.h"
+
+typedef wchar_t WCHAR;
+typedef wchar_t _TCHAR;
+typedef void*   HMODULE;
+
+#define _tmain   lic_main
+#define printf_s printf
+
+int lic_main(int argc, _TCHAR* argv[]);
+
+inline HMODULE GetModuleHandle(const void*)
+{
+    return nullptr;
+}
+
+// Copies the string table entry of the id into the buffer, an empty string
+// for an unknown id. Returns the number of characters copied.
+int LoadString(HMODULE module, unsigned int id, WCHAR* buffer, int bufferLength);
+
+inline void SecureZeroMemory(void* memory, size_t length)
+{
+    memset(memory, 0, length);
+}
+
+inline int _wcsicmp(const wchar_t* left, const wchar_t* right)
+{
+    return wcscasecmp(left, right);
+}
+
+// Formats like the Microsoft wprintf_s and writes the text to stdout in the
+// encoding of the locale. stdout is never used wide oriented, so the printf_s
+// output of the front end can mix with it.
+int wprintf_s(const wchar_t* format, ...);